@@ -0,0 +1,440 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para a aquisição contínua do ADC por TPM e DMA.
+ *
+ * @file        dsf_ADC_ocp.cpp
+ * @version     1.0
+ * @date        1 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   ADC, TPM, DMA, DMAMUX, PORT e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (1 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_ADC_ocp.h"
+
+/*!
+ * Registradores do ADC0 (pág. 462), do DMAMUX0 (pág. 326) e dos canais de
+ * DMA (pág. 345).
+ */
+#define DSF_ADC_REG(offset)   (*(volatile uint32_t *)(0x4003B000 + (offset)))
+#define DSF_ADC_SC1A          DSF_ADC_REG(0x00)
+#define DSF_ADC_CFG1          DSF_ADC_REG(0x08)
+#define DSF_ADC_CFG2          DSF_ADC_REG(0x0C)
+#define DSF_ADC_RA            DSF_ADC_REG(0x10)
+#define DSF_ADC_SC2           DSF_ADC_REG(0x20)
+#define DSF_ADC_SC3           DSF_ADC_REG(0x24)
+#define DSF_ADC_PG            DSF_ADC_REG(0x2C)
+#define DSF_ADC_MG            DSF_ADC_REG(0x30)
+#define DSF_DMAMUX_CHCFG(ch)  (*(volatile uint8_t *)(0x40021000 + (ch)))
+
+namespace {
+
+/*!
+ * Campos do ADC0: COCO (SC1A 7), ADCH desligado (0x1F), ADIV (CFG1 6:5),
+ * MUXSEL (CFG2 4), ADTRG (SC2 6), DMAEN (SC2 2), CAL e CALF (SC3 7 e 6) e
+ * média de 32 (SC3 2:0 = 111) durante a calibração. A aquisição usa
+ * ADIV = 2; a calibração pede o ADCK até 4 MHz (pág. 494).
+ */
+const uint32_t kCOCO = 1u << 7;
+const uint32_t kADCOff = 0x1F;
+const uint32_t kADIV2 = 1u << 5;
+const uint32_t kADIVShift = 5;
+const uint32_t kMaxADIV = 3;
+const uint32_t kCalibrationHz = 4000000;
+const uint32_t kMUXSEL = 1u << 4;
+const uint32_t kADTRG = 1u << 6;
+const uint32_t kDMAEN = 1u << 2;
+const uint32_t kCAL = 1u << 7;
+const uint32_t kCALF = 1u << 6;
+const uint32_t kAverage32 = 7;
+
+/*!
+ * Registradores de calibração CLPD..CLP0 e CLMD..CLM0 (págs. 477 a 482):
+ * a soma de CLPS e CLP4..CLP0 ajusta o ganho.
+ */
+const uint8_t kPlusSide[6] = {0x38, 0x3C, 0x40, 0x44, 0x48, 0x4C};
+const uint8_t kMinusSide[6] = {0x58, 0x5C, 0x60, 0x64, 0x68, 0x6C};
+
+/*!
+ * Campos do DMA_DSR_BCRn (CE 30, BES 29, BED 28, DONE 24) e do DMA_DCRn:
+ * EINT (31), ERQ (30), CS (29), SSIZE = 16 bits (21:20), DINC (19),
+ * DSIZE = 16 bits (18:17) e DMOD (11:8). DMAMUX: ENBL (7) e a fonte 40,
+ * fim de conversão do ADC0.
+ */
+const uint32_t kErrors = (1u << 30) | (1u << 29) | (1u << 28);
+const uint32_t kDONE = 1u << 24;
+const uint32_t kDCR = (1u << 31) | (1u << 30) | (1u << 29) | (2u << 20)
+                      | (1u << 19) | (2u << 17);
+const uint8_t kMuxADC0 = 0x80 | 40;
+
+/*!
+ * Gatilho alternativo do ADC0 no SIM_SOPT7: ADC0ALTTRGEN (7) e
+ * ADC0TRGSEL = 8 + TPM (overflow do TPM0..TPM2).
+ */
+const uint32_t kAltTrigger = 1u << 7;
+const uint32_t kTriggerTPM0 = 8;
+
+}  // namespace
+
+/*!
+ *   @fn         dsf_ADC_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método associa o objeto ao TPM de disparo e ao canal de DMA e
+ *   coloca o pino da entrada na função analógica (MUX = 0). Os clocks do
+ *   ADC, do DMA e do TPM só são adquiridos em calibrate e start.
+ *
+ *   @param[in]  input - entrada do ADC0.
+ *               trigger - TPM dedicado ao disparo das conversões.
+ *               DMAChannel - canal de DMA (0 a 3) dedicado ao objeto.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - PCR: Pin Control Register. Pág. 183.
+ */
+dsf_ADC_ocp::dsf_ADC_ocp(ADC_t::dsf_Input input, TPM_t::TPMNumber_t trigger,
+                         uint8_t DMAChannel)
+    : buffer(0), bufferLength(0), blockHandler(0), handlerArgument(0),
+      half(0), blockCount(0), lateCount(0), inputCode(input & 0x3F),
+      mode(ADC_t::dsf_Bits16), averageMode(ADC_t::dsf_Avg1), freqDiv(0),
+      modulo(0xFFFF), TPMNumber(trigger),
+      channel(DMAChannel % ADC_t::dsf_DMAChannels), running(false),
+      ADCGate(ClockGate_t::dsf_NumGates) {
+  uint8_t GPIONumber = (input >> 6) & 7;
+
+  bindPeripheral((uint8_t *)(TPM0_BASE + 0x1000*trigger));
+  addressDMASAR = (volatile uint32_t *)(0x40008100 + 0x10*channel);
+  addressDMADAR = addressDMASAR + 1;
+  addressDMADSR = addressDMASAR + 2;
+  addressDMADCR = addressDMASAR + 3;
+  if (GPIONumber < 5) {
+    enableGPIOClock(GPIONumber);
+    bindPin(GPIONumber, (input >> 9) & 0x1F);
+    *addressPortxPCRn = PORT_PCR_MUX(0);
+  }
+}
+
+/*!
+ *   @fn         ~dsf_ADC_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ */
+dsf_ADC_ocp::~dsf_ADC_ocp() {
+  stop();
+}
+
+/*!
+ *   @fn         setResolution
+ *
+ *   @brief      Seleciona a resolução das conversões.
+ *
+ *   Os resultados são alinhados à direita; com 8, 10 ou 12 bits a parte
+ *   alta das amostras é zero.
+ */
+void dsf_ADC_ocp::setResolution(ADC_t::dsf_Resolution resolution) {
+  mode = resolution;
+}
+
+/*!
+ *   @fn         setAverage
+ *
+ *   @brief      Seleciona o número de conversões somadas em cada amostra.
+ */
+void dsf_ADC_ocp::setAverage(ADC_t::dsf_Average average) {
+  averageMode = average;
+}
+
+/*!
+ *   @fn         setSampleRate
+ *
+ *   @brief      Ajusta o período do TPM de disparo para a taxa pedida.
+ *
+ *   Escolhe o menor divisor do TPM com que o período cabe em 16 bits, o
+ *   que dá a melhor resolução de taxa.
+ *
+ *   @param[in]  hertz - taxa de amostragem desejada.
+ *
+ *   @return     A taxa efetiva, em Hz, ou 0 se hertz = 0.
+ */
+uint32_t dsf_ADC_ocp::setSampleRate(uint32_t hertz) {
+  uint32_t source, period = 0;
+
+  if (hertz == 0) {
+    return 0;
+  }
+  for (freqDiv = TPMDiv_t::Div1; freqDiv <= TPMDiv_t::Div128; freqDiv++) {
+    source = dsf_MCG_ocp::timerHz() >> freqDiv;
+    period = (source + hertz/2)/hertz;
+    if (period <= 0x10000) {
+      break;
+    }
+  }
+  if (freqDiv > TPMDiv_t::Div128) {
+    freqDiv = TPMDiv_t::Div128;
+    period = 0x10000;
+  }
+  modulo = (uint16_t)((period ? period : 1) - 1);
+  return sampleRate();
+}
+
+/*!
+ *   @fn         setBuffer
+ *
+ *   @brief      Informa o buffer circular e o tratador dos blocos.
+ *
+ *   @param[in]  samples - buffer, alinhado a 2*length bytes.
+ *               length - número de amostras, potência de 2.
+ *               handler - tratador de cada metade completa, ou 0.
+ *               argument - argumento repassado ao tratador.
+ *
+ *   @return     false se length ou o alinhamento não servem ao DMOD.
+ */
+bool dsf_ADC_ocp::setBuffer(uint16_t *samples, uint16_t length,
+                            dsf_ADCBlockHandler handler, void *argument) {
+  if (length < ADC_t::dsf_MinBuffer || length > ADC_t::dsf_MaxBuffer
+      || (length & (length - 1))
+      || ((uintptr_t)samples & (2u*length - 1))) {
+    return false;
+  }
+  buffer = samples;
+  bufferLength = length;
+  blockHandler = handler;
+  handlerArgument = argument;
+  return true;
+}
+
+/*!
+ *   @fn         calibrate
+ *
+ *   @brief      Executa a calibração do ADC e grava os ganhos.
+ *
+ *   A calibração é feita uma vez, após o reset, com a média de 32 e o
+ *   menor divisor do barramento que leva o ADCK a até 4 MHz (ADIV = 4 no
+ *   FEI, 8 com o barramento a 24 MHz); a CPU espera o fim, de alguns ms.
+ *   O COCO deixado pela calibração é apagado, para que o DMA não copie o
+ *   RA no start.
+ *
+ *   @return     false se a calibração falhou (CALF).
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - Calibration function. Pág. 494.
+ */
+bool dsf_ADC_ocp::calibrate() {
+  uint32_t sum, adiv = 0;
+
+  if (running) {
+    return false;
+  }
+  while (adiv < kMaxADIV && (dsf_MCG_ocp::busHz() >> adiv) > kCalibrationHz) {
+    adiv++;
+  }
+  acquireADC();
+  DSF_ADC_CFG1 = (adiv << kADIVShift) | ((uint32_t)mode << 2);
+  DSF_ADC_SC2 = 0;
+  DSF_ADC_SC3 = kCAL | kCALF | kAverage32;
+  while (!(DSF_ADC_SC1A & kCOCO)) {
+  }
+  DSF_ADC_SC1A = kADCOff;
+  if (DSF_ADC_SC3 & kCALF) {
+    releaseADC();
+    return false;
+  }
+  sum = 0;
+  for (int i = 0; i < 6; i++) {
+    sum += DSF_ADC_REG(kPlusSide[i]);
+  }
+  DSF_ADC_PG = (sum >> 1) | 0x8000;
+  sum = 0;
+  for (int i = 0; i < 6; i++) {
+    sum += DSF_ADC_REG(kMinusSide[i]);
+  }
+  DSF_ADC_MG = (sum >> 1) | 0x8000;
+  releaseADC();
+  return true;
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Inicia a aquisição contínua.
+ *
+ *   A ordem evita uma primeira amostra fora de lugar: o DMA é armado antes
+ *   do ADC aceitar disparos e o TPM é o último a ser ligado.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - SIM_SOPT7: System Options Register 7. Pág. 198.
+ *               - ADCx_SC2: Status and Control Register 2. Pág. 471.
+ *               - DMA_DCRn: DMA Control Register. Pág. 352.
+ */
+void dsf_ADC_ocp::start() {
+  uint32_t dmod = 0;
+
+  if (running || !buffer) {
+    return;
+  }
+  while ((8u << dmod) < 2u*bufferLength) {
+    dmod++;
+  }
+  acquireADC();
+  enablePeripheralClock(TPMNumber);
+  writeSC(0);
+
+  half = 0;
+  DSF_DMAMUX_CHCFG(channel) = 0;
+  *addressDMADSR = kDONE;
+  *addressDMASAR = 0x4003B010;
+  *addressDMADAR = (uint32_t)(uintptr_t)buffer;
+  *addressDMADSR = bufferLength;
+  *addressDMADCR = kDCR | (dmod << 8);
+  DSF_DMAMUX_CHCFG(channel) = kMuxADC0;
+  NVIC_ClearPendingIRQ((IRQn_Type)(DMA0_IRQn + channel));
+  NVIC_EnableIRQ((IRQn_Type)(DMA0_IRQn + channel));
+
+  DSF_ADC_CFG1 = kADIV2 | ((uint32_t)mode << 2);
+  DSF_ADC_CFG2 = (inputCode & 0x20) ? kMUXSEL : 0;
+  DSF_ADC_SC3 = averageMode;
+  DSF_ADC_SC2 = kADTRG | kDMAEN;
+  SIM_SOPT7 = kAltTrigger | (kTriggerTPM0 + TPMNumber);
+  DSF_ADC_SC1A = inputCode & 0x1F;
+
+  restartCounter(modulo, 0x08 | freqDiv);
+  running = true;
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para a aquisição e libera os clocks.
+ *
+ *   A metade em andamento é descartada.
+ */
+void dsf_ADC_ocp::stop() {
+  if (!running) {
+    return;
+  }
+  writeSC(0);
+  disablePeripheralClock();
+  DSF_ADC_SC1A = kADCOff;
+  DSF_ADC_SC2 = 0;
+  SIM_SOPT7 = 0;
+  NVIC_DisableIRQ((IRQn_Type)(DMA0_IRQn + channel));
+  DSF_DMAMUX_CHCFG(channel) = 0;
+  *addressDMADCR = 0;
+  *addressDMADSR = kDONE;
+  releaseADC();
+  running = false;
+}
+
+/*!
+ *   @fn         irqHandler
+ *
+ *   @brief      Trata o fim de uma metade do buffer.
+ *
+ *   Recarrega o contador de bytes e entrega a metade completa. O erro de
+ *   configuração (CE) indica que a interrupção veio depois da conversão
+ *   seguinte: a amostra pendente é copiada após a recarga, mas a metade
+ *   é contada em lateBlocks.
+ */
+void dsf_ADC_ocp::irqHandler() {
+  uint32_t status = *addressDMADSR;
+  const uint16_t *block = buffer + (half ? bufferLength/2 : 0);
+  uint8_t completed = half;
+
+  *addressDMADSR = kDONE;
+  *addressDMADSR = bufferLength;
+  if (status & kErrors) {
+    lateCount++;
+  }
+  half = !completed;
+  blockCount++;
+  if (blockHandler) {
+    blockHandler(handlerArgument, block, bufferLength/2, completed);
+  }
+}
+
+/*!
+ *   @fn         sampleRate
+ *
+ *   @brief      Informa a taxa de amostragem efetiva, em Hz.
+ */
+uint32_t dsf_ADC_ocp::sampleRate() {
+  return (dsf_MCG_ocp::timerHz() >> freqDiv)/((uint32_t)modulo + 1);
+}
+
+/*!
+ *   @fn         blocks
+ *
+ *   @brief      Informa o número de metades completas desde o start.
+ */
+uint32_t dsf_ADC_ocp::blocks() {
+  return blockCount;
+}
+
+/*!
+ *   @fn         lateBlocks
+ *
+ *   @brief      Informa o número de metades entregues depois da conversão
+ *               seguinte.
+ *
+ *   Com mais de uma amostra de atraso, as conversões do intervalo
+ *   sobrescrevem o RA e se perdem.
+ */
+uint32_t dsf_ADC_ocp::lateBlocks() {
+  return lateCount;
+}
+
+/*!
+ *   @fn         acquireADC
+ *
+ *   @brief      Adquire os clocks do ADC0 e do DMA.
+ */
+void dsf_ADC_ocp::acquireADC() {
+  if (ADCGate != ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  ADCGate = ClockGate_t::dsf_ADC0;
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_ADC0);
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_DMA);
+}
+
+/*!
+ *   @fn         releaseADC
+ *
+ *   @brief      Libera os clocks do ADC0 e do DMA.
+ */
+void dsf_ADC_ocp::releaseADC() {
+  if (ADCGate == ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_DMA);
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_ADC0);
+  ADCGate = ClockGate_t::dsf_NumGates;
+}
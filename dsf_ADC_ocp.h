@@ -0,0 +1,231 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para a aquisição contínua do ADC por TPM e DMA.
+ *
+ * @file        dsf_ADC_ocp.h
+ * @version     1.0
+ * @date        1 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   ADC, TPM, DMA, DMAMUX, PORT e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (1 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_ADC_OCP_H_
+#define DSF_ADC_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_TPM_ocp.h"
+
+/*!
+ * Namespace associado às entradas, à resolução e à média por hardware do
+ * ADC0. Cada entrada codifica o canal ADCH (bits 4:0), o mux "b" (bit 5),
+ * o GPIO (bits 8:6, 7 para entradas internas) e o pino (bits 13:9).
+ */
+namespace ADC_t {
+  enum dsf_Input {
+    dsf_SE0_PTE20 = 0 | (4 << 6) | (20 << 9),
+    dsf_SE3_PTE22 = 3 | (4 << 6) | (22 << 9),
+    dsf_SE4a_PTE21 = 4 | (4 << 6) | (21 << 9),
+    dsf_SE4b_PTE29 = 4 | (1 << 5) | (4 << 6) | (29 << 9),
+    dsf_SE5b_PTD1 = 5 | (1 << 5) | (3 << 6) | (1 << 9),
+    dsf_SE6b_PTD5 = 6 | (1 << 5) | (3 << 6) | (5 << 9),
+    dsf_SE7a_PTE23 = 7 | (4 << 6) | (23 << 9),
+    dsf_SE7b_PTD6 = 7 | (1 << 5) | (3 << 6) | (6 << 9),
+    dsf_SE8_PTB0 = 8 | (1 << 6) | (0 << 9),
+    dsf_SE9_PTB1 = 9 | (1 << 6) | (1 << 9),
+    dsf_SE11_PTC2 = 11 | (2 << 6) | (2 << 9),
+    dsf_SE12_PTB2 = 12 | (1 << 6) | (2 << 9),
+    dsf_SE13_PTB3 = 13 | (1 << 6) | (3 << 9),
+    dsf_SE14_PTC0 = 14 | (2 << 6) | (0 << 9),
+    dsf_SE15_PTC1 = 15 | (2 << 6) | (1 << 9),
+    dsf_SE23_PTE30 = 23 | (4 << 6) | (30 << 9),
+    dsf_TempSensor = 26 | (7 << 6),
+    dsf_Bandgap = 27 | (7 << 6)
+  };
+
+  enum dsf_Resolution {
+    dsf_Bits8 = 0,
+    dsf_Bits12 = 1,
+    dsf_Bits10 = 2,
+    dsf_Bits16 = 3
+  };
+
+  enum dsf_Average {
+    dsf_Avg1 = 0,
+    dsf_Avg4 = 4,
+    dsf_Avg8 = 5,
+    dsf_Avg16 = 6,
+    dsf_Avg32 = 7
+  };
+
+  enum dsf_ADCLimits {
+    dsf_MinBuffer = 8,
+    dsf_MaxBuffer = 8192,
+    dsf_DMAChannels = 4
+  };
+}  // namespace ADC_t
+
+/*!
+ * Tratador de um bloco completo: metade 0 ou 1 do buffer circular.
+ */
+typedef void (*dsf_ADCBlockHandler)(void *argument, const uint16_t *samples,
+                                    uint16_t count, uint8_t half);
+
+/*!
+ *  @class    dsf_ADC_ocp
+ *
+ *  @brief    Classe de aquisição contínua do ADC0 em taxa fixa.
+ *
+ *  @details  O overflow de um TPM dedicado dispara cada conversão pelo
+ *            SIM_SOPT7 (gatilho alternativo do ADC0) e o fim de conversão
+ *            requisita o DMA, que copia o resultado para um buffer circular
+ *            em RAM. Nenhuma amostra passa pela CPU: o intervalo entre as
+ *            amostras é o período do TPM, sem o jitter do laço principal.
+ *
+ *            O DMA do KL25 não tem interrupção de meio de transferência.
+ *            O buffer de length amostras é percorrido com o módulo de
+ *            destino (DMOD), que faz o endereço voltar ao início sozinho, e
+ *            o contador de bytes vale meio buffer: a interrupção do canal
+ *            ocorre a cada metade, recarrega o contador e entrega a metade
+ *            que acabou de encher (half = 0) ou a segunda metade (half = 1)
+ *            ao tratador, enquanto o DMA já escreve na outra. O tratador
+ *            deve terminar antes que a outra metade encha.
+ *
+ *            Uma interrupção atrasada (por uma seção crítica, por exemplo)
+ *            encontra o erro de configuração (CE) do DMA: a conversão
+ *            seguinte chegou com o contador zerado. Até uma amostra de
+ *            atraso nada se perde, pois o COCO segura a requisição e a
+ *            amostra é copiada logo após a recarga; com mais atraso as
+ *            conversões seguintes sobrescrevem o RA. Essas metades são
+ *            contadas em lateBlocks: o DMA não informa quantas amostras se
+ *            perderam, só que a entrega passou do prazo.
+ *
+ *            O buffer deve ter length potência de 2, entre
+ *            ADC_t::dsf_MinBuffer e ADC_t::dsf_MaxBuffer, e estar alinhado
+ *            ao seu tamanho em bytes (exigência do DMOD).
+ *
+ *            A média por hardware (4 a 32 conversões por amostra) e a
+ *            resolução valem para todas as amostras. O ADC usa o clock do
+ *            barramento dividido por 2; com 16 bits cada conversão dura
+ *            cerca de 5 us, de modo que a taxa máxima é de cerca de
+ *            200 kHz/média. A calibração usa um divisor maior, com o ADCK
+ *            até 4 MHz.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            PTB0 a 8 kHz com média de 4, disparo no TPM1 e DMA0.
+ *             +fn uint16_t samples[256] __attribute__((aligned(512)));
+ *             +fn dsf_ADC_ocp adc(ADC_t::dsf_SE8_PTB0, TPM_t::dsf_TPM1, 0);
+ *             +fn DSF_IRQ_BIND(DMA0, adc)
+ *             +fn adc.setAverage(ADC_t::dsf_Avg4);
+ *             +fn adc.calibrate();
+ *             +fn adc.setSampleRate(8000);
+ *             +fn adc.setBuffer(samples, 256, onBlock, 0);
+ *             +fn adc.start();
+ */
+class dsf_ADC_ocp : public dsf_TPMPeripheral_ocp {
+ public:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  dsf_ADC_ocp(ADC_t::dsf_Input input,
+              TPM_t::TPMNumber_t trigger = TPM_t::dsf_TPM1,
+              uint8_t DMAChannel = 0);
+  ~dsf_ADC_ocp();
+
+  /*!
+   * Métodos de configuração, antes de start.
+   */
+  void setResolution(ADC_t::dsf_Resolution resolution);
+  void setAverage(ADC_t::dsf_Average average);
+  uint32_t setSampleRate(uint32_t hertz);
+  bool setBuffer(uint16_t *samples, uint16_t length,
+                 dsf_ADCBlockHandler handler, void *argument);
+  bool calibrate();
+
+  /*!
+   * Métodos de controle da aquisição.
+   */
+  void start();
+  void stop();
+
+  /*!
+   * Método de tratamento da interrupção do canal de DMA.
+   */
+  void irqHandler();
+
+  /*!
+   * Métodos de consulta.
+   */
+  uint32_t sampleRate();
+  uint32_t blocks();
+  uint32_t lateBlocks();
+
+ private:
+  /*!
+   * Registradores do canal de DMA: SAR, DAR, DSR_BCR e DCR.
+   */
+  volatile uint32_t *addressDMASAR;
+  volatile uint32_t *addressDMADAR;
+  volatile uint32_t *addressDMADSR;
+  volatile uint32_t *addressDMADCR;
+  /*!
+   * Buffer circular e tratador dos blocos.
+   */
+  uint16_t *buffer;
+  uint16_t bufferLength;
+  dsf_ADCBlockHandler blockHandler;
+  void *handlerArgument;
+  /*!
+   * Metade do buffer sendo escrita pelo DMA.
+   */
+  volatile uint8_t half;
+  volatile uint32_t blockCount;
+  volatile uint32_t lateCount;
+  /*!
+   * Configuração do ADC e do TPM de disparo.
+   */
+  uint8_t inputCode;
+  uint8_t mode;
+  uint8_t averageMode;
+  uint8_t freqDiv;
+  uint16_t modulo;
+  uint8_t TPMNumber;
+  uint8_t channel;
+  bool running;
+  ClockGate_t::dsf_Gate ADCGate;
+
+  void acquireADC();
+  void releaseADC();
+};
+
+#endif  //  DSF_ADC_OCP_H_
@@ -0,0 +1,315 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para o brilho de leds em GPIO por modulação BCM.
+ *
+ * @file        dsf_BCM_ocp.cpp
+ * @version     1.0
+ * @date        2 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM, GPIO, FGPIO, PORT e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (2 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include <string.h>
+#include "dsf_BCM_ocp.h"
+#include "dsf_BME_ocp.h"
+
+/*!
+ * Registradores do PORT (pág. 183), do GPIO (pág. 778) e do FGPIO, a
+ * porta de E/S de ciclo único do núcleo (pág. 775).
+ */
+#define DSF_BCM_PCR(GPIO, pin)                                               \
+  (*(volatile uint32_t *)(0x40049000 + 0x1000*(GPIO) + 4*(pin)))
+#define DSF_BCM_PCOR(GPIO)  (*(volatile uint32_t *)(0x400FF008 + 0x40*(GPIO)))
+#define DSF_BCM_PDDR(GPIO)  (*(volatile uint32_t *)(0x400FF014 + 0x40*(GPIO)))
+#define DSF_BCM_FPTOR(GPIO) (0xF80FF00C + 0x40*(GPIO))
+
+/*!
+ *   @fn         dsf_BCM_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método associa o objeto ao TPM dedicado e ajusta a taxa padrão
+ *   de 200 quadros/s. O clock do TPM só é adquirido em start.
+ *
+ *   @param[in]  tpm - TPM dedicado à modulação.
+ */
+dsf_BCM_ocp::dsf_BCM_ocp(TPM_t::TPMNumber_t tpm)
+    : front(0), pending(false), plane(0), frameCount(0), portCount(0),
+      channelCount(0), unit(1), freqDiv(0), TPMNumber(tpm), running(false) {
+  bindPeripheral((uint8_t *)(TPM0_BASE + 0x1000*tpm));
+  memset(planes, 0, sizeof(planes));
+  memset(applied, 0, sizeof(applied));
+  memset(levels, 0, sizeof(levels));
+  setFrameRate(200);
+}
+
+/*!
+ *   @fn         ~dsf_BCM_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ *
+ *   Para a modulação, desliga os pinos e libera os clocks dos GPIOs.
+ */
+dsf_BCM_ocp::~dsf_BCM_ocp() {
+  stop();
+  for (uint8_t i = 0; i < portCount; i++) {
+    dsf_ClockGate_ocp::release(
+        (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA + port[i]));
+  }
+}
+
+/*!
+ *   @fn         attach
+ *
+ *   @brief      Acrescenta um pino como canal de brilho.
+ *
+ *   O pino é configurado como saída GPIO desligada e fica dedicado ao
+ *   BCM: o tratador acompanha o seu nível pelos toggles que escreve.
+ *   Só pode ser chamado com a modulação parada.
+ *
+ *   @param[in]  GPIO - GPIO do pino.
+ *               pin - número do pino no GPIO.
+ *
+ *   @return     O número do canal, ou -1 sem canais livres.
+ */
+int dsf_BCM_ocp::attach(GPIO_t::dsf_GPIO GPIO, uint8_t pin) {
+  uint8_t index = 0;
+
+  if (running || channelCount == BCM_t::dsf_MaxChannels || pin > 31) {
+    return -1;
+  }
+  while (index < portCount && port[index] != GPIO) {
+    index++;
+  }
+  if (index == portCount) {
+    dsf_ClockGate_ocp::acquire(
+        (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA + GPIO));
+    port[index] = GPIO;
+    addressPTOR[index] = (volatile uint32_t *)DSF_BCM_FPTOR(GPIO);
+    portCount++;
+  }
+  DSF_BCM_PCR(GPIO, pin) = PORT_PCR_MUX(1);
+  DSF_BCM_PCOR(GPIO) = 1u << pin;
+  dsf_BME_ocp::setBits(&DSF_BCM_PDDR(GPIO), 1u << pin);
+  applied[index] &= ~(1u << pin);
+  channelPort[channelCount] = index;
+  channelPin[channelCount] = pin;
+  levels[channelCount] = 0;
+  return channelCount++;
+}
+
+/*!
+ *   @fn         setFrameRate
+ *
+ *   @brief      Ajusta a unidade de tempo para a taxa de quadros pedida.
+ *
+ *   Um quadro dura 255 unidades. Escolhe o menor divisor do TPM com que o
+ *   plano 7 (128 unidades) cabe em 16 bits. Só pode ser chamado com a
+ *   modulação parada.
+ *
+ *   @param[in]  hertz - quadros por segundo desejados.
+ *
+ *   @return     A taxa efetiva, em quadros por segundo.
+ */
+uint32_t dsf_BCM_ocp::setFrameRate(uint16_t hertz) {
+  uint32_t source, ticks = 0;
+
+  if (running || hertz == 0) {
+    return frameRate();
+  }
+  for (freqDiv = TPMDiv_t::Div1; freqDiv < TPMDiv_t::Div128; freqDiv++) {
+    source = dsf_MCG_ocp::timerHz() >> freqDiv;
+    ticks = source/(255u*hertz);
+    if (ticks <= 0x10000/128) {
+      break;
+    }
+  }
+  if (ticks > 0x10000/128) {
+    ticks = 0x10000/128;
+  }
+  if ((ticks << freqDiv) < BCM_t::dsf_MinUnit) {
+    ticks = (BCM_t::dsf_MinUnit + (1u << freqDiv) - 1) >> freqDiv;
+  }
+  unit = (uint16_t)ticks;
+  return frameRate();
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Inicia a modulação a partir do plano 0.
+ *
+ *   Os dois buffers recebem os níveis atuais. O MOD do plano 0 é escrito
+ *   com o TPM parado e o do plano 1 logo após ligá-lo, para valer a
+ *   partir do primeiro overflow.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ *               - TPMxMOD: Modulo Register. Pág. 554.
+ *               - GPIOx_PTOR: Port Toggle Output Register. Pág. 779.
+ */
+void dsf_BCM_ocp::start() {
+  if (running) {
+    return;
+  }
+  pending = false;
+  front = 0;
+  build(0);
+  build(1);
+
+  enablePeripheralClock(TPMNumber);
+  writeSC(0);
+  plane = 0;
+  for (uint8_t i = 0; i < portCount; i++) {
+    *addressPTOR[i] = planes[front][0][i] ^ applied[i];
+    applied[i] = planes[front][0][i];
+  }
+  restartCounter(unit - 1, 0x80 | 0x40 | 0x08 | freqDiv);
+  writeMOD(((uint32_t)unit << 1) - 1);
+  NVIC_ClearPendingIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  NVIC_EnableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  running = true;
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para a modulação, desliga os pinos e libera o TPM.
+ */
+void dsf_BCM_ocp::stop() {
+  if (!running) {
+    return;
+  }
+  NVIC_DisableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  writeSC(0);
+  disablePeripheralClock();
+  for (uint8_t i = 0; i < portCount; i++) {
+    *addressPTOR[i] = applied[i];
+    applied[i] = 0;
+  }
+  running = false;
+}
+
+/*!
+ *   @fn         setLevel
+ *
+ *   @brief      Altera o brilho de um canal no próximo present.
+ *
+ *   @param[in]  channel - canal retornado por attach.
+ *               level - brilho de 0 (desligado) a 255 (sempre ligado).
+ */
+void dsf_BCM_ocp::setLevel(uint8_t channel, uint8_t level) {
+  if (channel < channelCount) {
+    levels[channel] = level;
+  }
+}
+
+/*!
+ *   @fn         level
+ *
+ *   @brief      Informa o brilho de um canal.
+ */
+uint8_t dsf_BCM_ocp::level(uint8_t channel) {
+  return channel < channelCount ? levels[channel] : 0;
+}
+
+/*!
+ *   @fn         present
+ *
+ *   @brief      Publica os níveis atuais a partir do próximo quadro.
+ *
+ *   Com pending em false o tratador não troca os buffers, de modo que o
+ *   buffer de trás pode ser remontado mesmo se a troca anterior ainda não
+ *   aconteceu; ela passa a valer com os níveis mais recentes.
+ */
+void dsf_BCM_ocp::present() {
+  pending = false;
+  __asm volatile("" ::: "memory");
+  build(front ^ 1);
+  __asm volatile("" ::: "memory");
+  pending = true;
+}
+
+/*!
+ *   @fn         channels
+ *
+ *   @brief      Informa o número de canais acrescentados.
+ */
+uint8_t dsf_BCM_ocp::channels() {
+  return channelCount;
+}
+
+/*!
+ *   @fn         frames
+ *
+ *   @brief      Informa o número de quadros completos desde o start.
+ */
+uint32_t dsf_BCM_ocp::frames() {
+  return frameCount;
+}
+
+/*!
+ *   @fn         frameRate
+ *
+ *   @brief      Informa a taxa de quadros efetiva, em quadros por segundo.
+ */
+uint32_t dsf_BCM_ocp::frameRate() {
+  return (dsf_MCG_ocp::timerHz() >> freqDiv)/(255u*unit);
+}
+
+/*!
+ *   @fn         unitCycles
+ *
+ *   @brief      Informa a unidade de tempo em ciclos do clock do TPM.
+ */
+uint32_t dsf_BCM_ocp::unitCycles() {
+  return (uint32_t)unit << freqDiv;
+}
+
+/*!
+ *   @fn         build
+ *
+ *   @brief      Monta os padrões dos 8 planos de um buffer de quadro.
+ *
+ *   @param[in]  frame - buffer de quadro (0 ou 1).
+ */
+void dsf_BCM_ocp::build(uint8_t frame) {
+  memset(planes[frame], 0, sizeof(planes[frame]));
+  for (uint8_t c = 0; c < channelCount; c++) {
+    uint32_t bit = 1u << channelPin[c];
+    for (uint8_t b = 0; b < BCM_t::dsf_Planes; b++) {
+      if (levels[c] & (1u << b)) {
+        planes[frame][b][channelPort[c]] |= bit;
+      }
+    }
+  }
+}
@@ -0,0 +1,201 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para o brilho de leds em GPIO por modulação BCM.
+ *
+ * @file        dsf_BCM_ocp.h
+ * @version     1.0
+ * @date        2 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM, GPIO, FGPIO, PORT e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (2 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_BCM_OCP_H_
+#define DSF_BCM_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_TPM_ocp.h"
+#include "dsf_GPIO_ocp.h"
+
+/*!
+ * Namespace associado aos limites do BCM: canais, planos de bit (8 bits
+ * de brilho), GPIOs e menor unidade de tempo em ciclos do TPM.
+ */
+namespace BCM_t {
+  enum dsf_BCMLimits {
+    dsf_MaxChannels = 32,
+    dsf_Planes = 8,
+    dsf_Ports = 5,
+    dsf_MinUnit = 160
+  };
+}  // namespace BCM_t
+
+/*!
+ *  @class    dsf_BCM_ocp
+ *
+ *  @brief    Modulação por código binário (BCM) de leds em pinos GPIO.
+ *
+ *  @details  O quadro é dividido em 8 planos de bit, com durações de 1, 2,
+ *            4, ..., 128 unidades de tempo: no plano b cada pino fica
+ *            ligado se o bit b do seu brilho vale 1, o que dá 256 níveis
+ *            com 8 interrupções por quadro, em vez de uma por nível.
+ *
+ *            Um TPM dedicado gera as interrupções de overflow. Cada
+ *            tratador escreve o MOD do plano seguinte, que o TPM só adota
+ *            no próximo overflow, de modo que o período nunca é
+ *            interrompido no meio. Os padrões dos planos já ficam prontos
+ *            por GPIO: o tratador faz uma única escrita no PTOR do FGPIO
+ *            por GPIO usado, com o XOR entre o padrão novo e o anterior.
+ *            Os demais pinos do GPIO não são tocados e não há
+ *            leitura-modificação-escrita concorrente com outros drivers.
+ *
+ *            Os quadros têm dois buffers. setLevel altera apenas os níveis
+ *            e present monta os planos no buffer de trás; o tratador troca
+ *            os buffers no início do quadro seguinte, de modo que um
+ *            quadro nunca mistura níveis antigos e novos.
+ *
+ *            A unidade de tempo tem no mínimo BCM_t::dsf_MinUnit ciclos,
+ *            para que o tratador termine dentro do plano 0: a taxa máxima
+ *            é de cerca de 500 quadros/s.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Três leds em GPIO a 200 quadros/s, sobre o TPM0.
+ *             +fn dsf_BCM_ocp leds(TPM_t::dsf_TPM0);
+ *             +fn DSF_IRQ_BIND(TPM0, leds)
+ *             +fn red = leds.attach(GPIO_t::dsf_GPIOB, GPIO_t::dsf_PTB18);
+ *             +fn leds.setFrameRate(200);
+ *             +fn leds.start();
+ *             +fn leds.setLevel(red, 64);
+ *             +fn leds.present();
+ */
+class dsf_BCM_ocp : public dsf_TPMPeripheral_ocp {
+ public:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  explicit dsf_BCM_ocp(TPM_t::TPMNumber_t tpm = TPM_t::dsf_TPM0);
+  ~dsf_BCM_ocp();
+
+  /*!
+   * Métodos de configuração dos canais e da taxa de quadros.
+   */
+  int attach(GPIO_t::dsf_GPIO GPIO, uint8_t pin);
+  uint32_t setFrameRate(uint16_t hertz);
+
+  /*!
+   * Métodos de controle da modulação.
+   */
+  void start();
+  void stop();
+
+  /*!
+   * Métodos de atualização dos níveis.
+   */
+  void setLevel(uint8_t channel, uint8_t level);
+  uint8_t level(uint8_t channel);
+  void present();
+
+  /*!
+   *   @fn         irqHandler
+   *
+   *   @brief      Trata o overflow do TPM no fim de cada plano.
+   *
+   *   Fica no header porque a duração do plano 0 limita o seu tempo:
+   *   expandido no tratador do DSF_IRQ_BIND, não paga uma chamada.
+   */
+  void irqHandler() {
+    const uint32_t *pattern;
+
+    clearOverflow();
+    if (++plane == BCM_t::dsf_Planes) {
+      plane = 0;
+      frameCount++;
+      if (pending) {
+        front ^= 1;
+        pending = false;
+      }
+    }
+    pattern = planes[front][plane];
+    for (uint8_t i = 0; i < portCount; i++) {
+      *addressPTOR[i] = pattern[i] ^ applied[i];
+      applied[i] = pattern[i];
+    }
+    writeMOD(((uint32_t)unit << ((plane + 1) & 7)) - 1);
+  }
+
+  /*!
+   * Métodos de consulta.
+   */
+  uint8_t channels();
+  uint32_t frames();
+  uint32_t frameRate();
+  uint32_t unitCycles();
+
+ private:
+  /*!
+   * Padrões dos planos por GPIO usado, nos dois buffers de quadro.
+   */
+  uint32_t planes[2][BCM_t::dsf_Planes][BCM_t::dsf_Ports];
+  volatile uint8_t front;
+  volatile bool pending;
+  /*!
+   * Plano em exibição e padrão já escrito em cada GPIO usado.
+   */
+  uint8_t plane;
+  uint32_t applied[BCM_t::dsf_Ports];
+  volatile uint32_t frameCount;
+  /*!
+   * GPIOs usados: PTOR do FGPIO e número do GPIO.
+   */
+  volatile uint32_t *addressPTOR[BCM_t::dsf_Ports];
+  uint8_t port[BCM_t::dsf_Ports];
+  uint8_t portCount;
+  /*!
+   * Brilho, GPIO usado e bit de cada canal.
+   */
+  uint8_t levels[BCM_t::dsf_MaxChannels];
+  uint8_t channelPort[BCM_t::dsf_MaxChannels];
+  uint8_t channelPin[BCM_t::dsf_MaxChannels];
+  uint8_t channelCount;
+  /*!
+   * Unidade de tempo em ticks do TPM e divisor.
+   */
+  uint16_t unit;
+  uint8_t freqDiv;
+  uint8_t TPMNumber;
+  bool running;
+
+  void build(uint8_t frame);
+};
+
+#endif  //  DSF_BCM_OCP_H_
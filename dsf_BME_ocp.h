@@ -0,0 +1,150 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Escritas decoradas do BME: AND, OR, XOR e inserção de campo.
+ *
+ * @file        dsf_BME_ocp.h
+ * @version     1.0
+ * @date        8 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   BME e periféricos do AIPS e do GPIO.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (8 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_BME_OCP_H_
+#define DSF_BME_OCP_H_
+
+#include <stdint.h>
+
+/*!
+ * Namespace de definição das decorações de endereço do BME. AND, OR e XOR
+ * levam os 20 bits menos significativos do endereço (0x40000000 a
+ * 0x400FFFFF, incluindo o GPIO, mas não o FGPIO); o BFI leva só 19 bits
+ * (0x40000000 a 0x4007FFFF) e não alcança o GPIO.
+ */
+namespace BME_t {
+  enum dsf_Decoration {
+    dsf_And = 0x44000000,
+    dsf_Or = 0x48000000,
+    dsf_Xor = 0x4C000000,
+    dsf_Bfi = 0x50000000
+  };
+  enum dsf_AddressMask {
+    dsf_LogicMask = 0xFFFFF,
+    dsf_BfiMask = 0x7FFFF
+  };
+}  // namespace BME_t
+
+/*!
+ *  @class    dsf_BME_ocp
+ *
+ *  @brief    Atualização atômica de bits e campos de registradores.
+ *
+ *  @details  Uma escrita no endereço decorado faz o BME ler o registrador,
+ *            aplicar a operação e escrevê-lo de volta em um único acesso do
+ *            núcleo ao barramento. A sequência LDR/ORR/STR de um "|=" pode
+ *            ser interrompida entre a leitura e a escrita, e a escrita
+ *            desfaz o que a interrupção mudou no mesmo registrador; a
+ *            escrita decorada não pode.
+ *
+ *            A largura do acesso é a do ponteiro (8, 16 ou 32 bits). Como
+ *            em qualquer leitura-modificação-escrita, as flags
+ *            write-1-to-clear lidas em 1 (TOF, ISF) são escritas de volta
+ *            em 1 e apagadas.
+ *
+ *            Os métodos são inline para que o endereço decorado de um
+ *            registrador constante seja calculado na compilação.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Pino 18 do GPIOB como saída e pull up em PTA1.
+ *             +fn dsf_BME_ocp::setBits(&GPIOB_PDDR, 1u << 18);
+ *             +fn dsf_BME_ocp::insertField(&PORTA_PCR1, 0, 2, 3);
+ */
+class dsf_BME_ocp {
+ public:
+  /*!
+   *   @fn         setBits
+   *
+   *   @brief      Liga os bits de bits no registrador (OR decorado).
+   */
+  template <typename T>
+  static void setBits(volatile T *reg, uint32_t bits) {
+    *decorate(reg, BME_t::dsf_Or, BME_t::dsf_LogicMask) = (T)bits;
+  }
+
+  /*!
+   *   @fn         clearBits
+   *
+   *   @brief      Desliga os bits de bits no registrador (AND decorado).
+   */
+  template <typename T>
+  static void clearBits(volatile T *reg, uint32_t bits) {
+    *decorate(reg, BME_t::dsf_And, BME_t::dsf_LogicMask) = (T)~bits;
+  }
+
+  /*!
+   *   @fn         toggleBits
+   *
+   *   @brief      Inverte os bits de bits no registrador (XOR decorado).
+   */
+  template <typename T>
+  static void toggleBits(volatile T *reg, uint32_t bits) {
+    *decorate(reg, BME_t::dsf_Xor, BME_t::dsf_LogicMask) = (T)bits;
+  }
+
+  /*!
+   *   @fn         insertField
+   *
+   *   @brief      Escreve value no campo de width bits que começa no bit
+   *               position, sem alterar os demais (BFI decorado).
+   *
+   *   @param[in]  reg - registrador do AIPS (não vale para o GPIO).
+   *               position - bit menos significativo do campo (0 a 31).
+   *               width - largura do campo (1 a 16).
+   *               value - valor do campo, não deslocado.
+   */
+  template <typename T>
+  static void insertField(volatile T *reg, uint8_t position, uint8_t width,
+                          uint32_t value) {
+    *decorate(reg, BME_t::dsf_Bfi | (uint32_t)position << 23
+                   | (uint32_t)(width - 1) << 19, BME_t::dsf_BfiMask)
+        = (T)(value << position);
+  }
+
+ private:
+  template <typename T>
+  static volatile T *decorate(volatile T *reg, uint32_t decoration,
+                              uint32_t mask) {
+    return (volatile T *)(uintptr_t)(decoration | ((uintptr_t)reg & mask));
+  }
+};
+
+#endif  //  DSF_BME_OCP_H_
@@ -0,0 +1,300 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Calibração da base de tempo dos TPMs por referência externa.
+ *
+ * @file        dsf_Calibration_ocp.cpp
+ * @version     1.0
+ * @date        13 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM (input capture), PORT e MCG.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (13 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_Calibration_ocp.h"
+
+/*!
+ *   @fn         dsf_Calibration_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método associa o objeto ao TPM e ao canal do pino de referência e
+ *   seleciona a função TPM no pino. A janela padrão é de referenceHz
+ *   bordas, 1 s.
+ *
+ *   @param[in]  referencePin - pino de captura ligado à referência.
+ *               referenceHz - frequência da referência, em Hz.
+ *               edge - borda da referência que é capturada.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - PortxPCRn: Pin Control Register. Pág. 183.
+ *               - TPMxCnSC: Channel Status and Control. Pág. 555.
+ */
+dsf_Calibration_ocp::dsf_Calibration_ocp(TPM_t::Pin_t referencePin,
+                                         uint32_t referenceHz,
+                                         TPMEdge_t::TPMEdge edge) {
+  uint8_t *baseAddress;
+
+  TPMNumber = (referencePin >> 11) & 0x3;
+  baseAddress = (uint8_t *)(TPM0_BASE + 0x1000*TPMNumber);
+  bindPeripheral(baseAddress);
+  bindChannel(baseAddress, (referencePin >> 8) & 0x7);
+
+  /*!
+   * Canal em captura (MSB:MSA = 00) com interrupção (CHIE = 0x40).
+   */
+  switch (edge) {
+    case TPMEdge_t::Rising: channelConfig = 0x40 | 0x04; break;
+    case TPMEdge_t::Falling: channelConfig = 0x40 | 0x08; break;
+    default: channelConfig = 0x40 | 0x0C; break;
+  }
+
+  enableGPIOClock((referencePin >> 5) & 0x7);
+  bindPin((referencePin >> 5) & 0x7, referencePin & 0x1F);
+  selectMuxAlternative((referencePin >> 13) & 0x7);
+
+  referenceRate = referenceHz ? referenceHz : 1;
+  windowEdges = referenceRate;
+  armed = false;
+  windowCount = 0;
+  rejectedCount = 0;
+  lastHz = 0;
+}
+
+/*!
+ *   @fn         ~dsf_Calibration_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ */
+dsf_Calibration_ocp::~dsf_Calibration_ocp() {
+  stop();
+}
+
+/*!
+ *   @fn         setWindow
+ *
+ *   @brief      Ajusta o número de períodos da referência por janela.
+ *
+ *   Janelas maiores melhoram a resolução e reagem mais devagar às
+ *   mudanças de temperatura. Vale a partir da próxima janela.
+ *
+ *   @param[in]  edges - períodos da referência por janela, no mínimo 1.
+ */
+void dsf_Calibration_ocp::setWindow(uint32_t edges) {
+  windowEdges = edges ? edges : 1;
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Inicia a contagem livre e a captura da referência.
+ *
+ *   A correção atual do dsf_MCG_ocp é mantida até a primeira janela
+ *   completa.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ */
+void dsf_Calibration_ocp::start() {
+  enablePeripheralClock(TPMNumber);
+  writeSC(0);
+  *addressTPMxCnSC = 0x80 | channelConfig;
+  overflows = 0;
+  armed = false;
+  dsf_MCG_ocp::subscribe(clockChanged, this);
+  restartCounter(0xFFFF, 0x80 | 0x40 | 0x08 | TPMDiv_t::Div16);
+  NVIC_ClearPendingIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  NVIC_EnableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para a medição e libera o clock do TPM.
+ *
+ *   A última correção continua valendo no dsf_MCG_ocp.
+ */
+void dsf_Calibration_ocp::stop() {
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  NVIC_DisableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  dsf_MCG_ocp::unsubscribe(clockChanged, this);
+  *addressTPMxCnSC = 0x80;
+  writeSC(0);
+  disablePeripheralClock();
+}
+
+/*!
+ *   @fn         irqHandler
+ *
+ *   @brief      Trata as interrupções de overflow e de captura do TPM.
+ *
+ *   A primeira borda arma a janela; a borda de número windowEdges a fecha
+ *   e abre a seguinte, de modo que nenhum período da referência fica de
+ *   fora.
+ */
+void dsf_Calibration_ocp::irqHandler() {
+  bool wrapped = false;
+  uint32_t now;
+
+  if (*addressTPMxSC & 0x80) {
+    clearOverflow();
+    overflows++;
+    wrapped = true;
+  }
+  if (!(*addressTPMxCnSC & 0x80)) {
+    return;
+  }
+  now = stamp(*addressTPMxCnV, wrapped);
+  *addressTPMxCnSC = 0x80 | channelConfig;
+  if (armed && ++edgeCount >= windowEdges) {
+    finishWindow(now - windowStamp);
+    armed = false;
+  }
+  if (!armed) {
+    windowStamp = now;
+    edgeCount = 0;
+    windowProfile = dsf_MCG_ocp::profile();
+    armed = true;
+  }
+}
+
+/*!
+ *   @fn         stamp
+ *
+ *   @brief      Estende um valor capturado de 16 para 32 bits.
+ *
+ *   Mesma regra do dsf_Latency_ocp: uma captura na metade alta com
+ *   overflow tratado nesta interrupção ocorreu antes do overflow; uma
+ *   captura na metade baixa com overflow pendente ocorreu depois dele.
+ */
+uint32_t dsf_Calibration_ocp::stamp(uint32_t value, bool wrapped) {
+  uint32_t high = overflows;
+
+  if (wrapped && value >= 0x8000) {
+    high--;
+  } else if (!wrapped && value < 0x8000 && (*addressTPMxSC & 0x80)) {
+    high++;
+  }
+  return (high << 16) | (value & 0xFFFF);
+}
+
+/*!
+ *   @fn         finishWindow
+ *
+ *   @brief      Converte os ticks de uma janela em frequência e correção.
+ *
+ *   A frequência do relógio do TPM é ticks*16*referenceRate/windowEdges,
+ *   arredondada. A correção só é entregue ao dsf_MCG_ocp se muda mais que
+ *   dsf_MinTrimStep, para não chamar os observadores a cada janela.
+ *
+ *   @param[in]  ticks - ticks do TPM entre a primeira e a última borda.
+ */
+void dsf_Calibration_ocp::finishWindow(uint32_t ticks) {
+  uint32_t nominal = dsf_MCG_ocp::nominalTimerHz();
+  uint32_t hz, factor, current, step;
+
+  hz = (uint32_t)((((uint64_t)ticks*referenceRate << TPMDiv_t::Div16)
+                   + windowEdges/2)/windowEdges);
+  if (dsf_MCG_ocp::profile() != windowProfile
+      || hz > nominal + nominal/100*Calibration_t::dsf_MaxErrorPercent
+      || hz < nominal - nominal/100*Calibration_t::dsf_MaxErrorPercent) {
+    rejectedCount++;
+    return;
+  }
+  lastHz = hz;
+  windowCount++;
+  factor = (uint32_t)((((uint64_t)hz << 24) + nominal/2)/nominal);
+  current = dsf_MCG_ocp::trim();
+  step = factor > current ? factor - current : current - factor;
+  if (step > Calibration_t::dsf_MinTrimStep) {
+    dsf_MCG_ocp::setTrim(factor);
+  }
+}
+
+/*!
+ *   @fn         clockChanged
+ *
+ *   @brief      Observador do dsf_MCG_ocp: descarta a janela em andamento
+ *               se o perfil mudou.
+ *
+ *   As mudanças da própria correção mantêm o perfil e a janela.
+ */
+void dsf_Calibration_ocp::clockChanged(void *argument) {
+  dsf_Calibration_ocp *self = (dsf_Calibration_ocp *)argument;
+
+  if (dsf_MCG_ocp::profile() != self->windowProfile) {
+    self->armed = false;
+  }
+}
+
+/*!
+ *   @fn         windows
+ *
+ *   @brief      Informa o número de janelas aceitas.
+ */
+uint32_t dsf_Calibration_ocp::windows() {
+  return windowCount;
+}
+
+/*!
+ *   @fn         rejected
+ *
+ *   @brief      Informa o número de janelas descartadas.
+ */
+uint32_t dsf_Calibration_ocp::rejected() {
+  return rejectedCount;
+}
+
+/*!
+ *   @fn         measuredHz
+ *
+ *   @brief      Informa a frequência dos TPMs medida na última janela
+ *               aceita, em Hz (0 antes da primeira).
+ */
+uint32_t dsf_Calibration_ocp::measuredHz() {
+  return lastHz;
+}
+
+/*!
+ *   @fn         errorPpm
+ *
+ *   @brief      Informa o desvio da última medição em relação à
+ *               frequência nominal, em partes por milhão.
+ */
+int32_t dsf_Calibration_ocp::errorPpm() {
+  uint32_t nominal = dsf_MCG_ocp::nominalTimerHz();
+
+  if (!lastHz) {
+    return 0;
+  }
+  return (int32_t)(((int64_t)lastHz - nominal)*1000000/nominal);
+}
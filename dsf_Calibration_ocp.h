@@ -0,0 +1,160 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Calibração da base de tempo dos TPMs por referência externa.
+ *
+ * @file        dsf_Calibration_ocp.h
+ * @version     1.0
+ * @date        13 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM (input capture), PORT e MCG.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (13 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_CALIBRATION_OCP_H_
+#define DSF_CALIBRATION_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_TPM_ocp.h"
+#include "dsf_MCG_ocp.h"
+
+/*!
+ * Namespace de definição dos limites da calibração: desvio máximo aceito
+ * em uma janela (10%) e a menor mudança da correção que é aplicada (2 ppm
+ * em ponto fixo 8.24).
+ */
+namespace Calibration_t {
+  enum dsf_CalibrationLimits {
+    dsf_MaxErrorPercent = 10,
+    dsf_MinTrimStep = 34
+  };
+}  // namespace Calibration_t
+
+/*!
+ *  @class    dsf_Calibration_ocp
+ *
+ *  @brief    Mede a frequência real dos TPMs contra uma referência externa
+ *            e corrige as frequências informadas pelo dsf_MCG_ocp.
+ *
+ *  @details  A referência é um sinal lento e preciso em um pino de captura
+ *            do TPM, por exemplo 1 Hz de um RTC com cristal de 32,768 kHz
+ *            ou o 1PPS de um GPS. O TPM conta livremente com MOD = 0xFFFF
+ *            e Div16, e a interrupção de overflow estende a contagem para
+ *            32 bits, como no dsf_Latency_ocp.
+ *
+ *            Cada janela soma os ticks de setWindow períodos da referência
+ *            (1 s por padrão). A frequência medida é convertida na razão
+ *            medida/nominal e entregue ao dsf_MCG_ocp::setTrim, de modo que
+ *            dsf_Delay_ocp::waitMicros, a UART, o SysTick e as demais
+ *            conversões passam a usar a frequência real. Com Div16 a
+ *            resolução de uma janela de 1 s é de 0,8 ppm.
+ *
+ *            Janelas com desvio acima de dsf_MaxErrorPercent (bordas
+ *            perdidas ou ruído no pino) são descartadas e contadas em
+ *            rejected. Uma troca de perfil do MCG durante a janela a
+ *            descarta, pois os ticks passam a ter outra duração.
+ *
+ *            O TPM não conta em VLPS/LLS; a calibração deve rodar com o
+ *            núcleo em RUN ou WAIT.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Saída de 1 Hz de um RTC ligada ao PTE20 (TPM1_CH0).
+ *             +fn dsf_Calibration_ocp calibration(TPM_t::dsf_TPM1_PTE20, 1);
+ *             +fn DSF_IRQ_BIND(TPM1, calibration)
+ *             +fn calibration.start();
+ *             +fn tpm.waitMicros(400000);
+ *             +fn ppm = calibration.errorPpm();
+ */
+class dsf_Calibration_ocp : public dsf_TPMPeripheral_ocp {
+ public:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  dsf_Calibration_ocp(TPM_t::Pin_t referencePin, uint32_t referenceHz,
+                      TPMEdge_t::TPMEdge edge = TPMEdge_t::Rising);
+  ~dsf_Calibration_ocp();
+
+  /*!
+   * Métodos de configuração e controle da medição.
+   */
+  void setWindow(uint32_t edges);
+  void start();
+  void stop();
+
+  /*!
+   * Método de tratamento da interrupção do TPM.
+   */
+  void irqHandler();
+
+  /*!
+   * Métodos de consulta.
+   */
+  uint32_t windows();
+  uint32_t rejected();
+  uint32_t measuredHz();
+  int32_t errorPpm();
+
+ private:
+  /*!
+   * Configuração do canal (ELSB:ELSA e CHIE), referência e janela.
+   */
+  uint32_t channelConfig;
+  uint32_t referenceRate;
+  uint32_t windowEdges;
+  uint8_t TPMNumber;
+
+  /*!
+   * Contagem de overflows, parte alta do tempo de 32 bits.
+   */
+  volatile uint32_t overflows;
+  /*!
+   * Janela em andamento: instante da primeira borda, bordas contadas e
+   * perfil do MCG no início.
+   */
+  uint32_t windowStamp;
+  uint32_t edgeCount;
+  MCG_t::dsf_Profile windowProfile;
+  bool armed;
+
+  /*!
+   * Resultados.
+   */
+  volatile uint32_t windowCount;
+  volatile uint32_t rejectedCount;
+  volatile uint32_t lastHz;
+
+  uint32_t stamp(uint32_t value, bool wrapped);
+  void finishWindow(uint32_t ticks);
+  static void clockChanged(void *argument);
+};
+
+#endif  //  DSF_CALIBRATION_OCP_H_
@@ -0,0 +1,196 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Implementação do gerenciador de clock gating dos periféricos.
+ *
+ * @file        dsf_ClockGate_ocp.cpp
+ * @version     1.0
+ * @date        14 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   SIM.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (14 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_ClockGate_ocp.h"
+#include "dsf_BME_ocp.h"
+
+uint8_t dsf_ClockGate_ocp::userCount[ClockGate_t::dsf_NumGates];
+uint32_t dsf_ClockGate_ocp::switchCount[ClockGate_t::dsf_NumGates];
+uint32_t dsf_ClockGate_ocp::activeMask;
+
+/*!
+ *   @fn         acquire
+ *
+ *   @brief      Adquire uma porta de clock.
+ *
+ *   Este método incrementa o número de usuários da porta de clock e a liga
+ *   quando o primeiro usuário a adquire.
+ *
+ *   @param[in]  gate - porta de clock a ser adquirida.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - SIM_SCGC4: System Clock Gating Control Register 4. Pág. 204.
+ *               - SIM_SCGC5: System Clock Gating Control Register 5. Pág. 206.
+ *               - SIM_SCGC6: System Clock Gating Control Register 6. Pág. 207.
+ *               - SIM_SCGC7: System Clock Gating Control Register 7. Pág. 209.
+ */
+void dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_Gate gate) {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (userCount[gate]++ == 0) {
+    gateOn(gate);
+  }
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         release
+ *
+ *   @brief      Libera uma porta de clock.
+ *
+ *   Este método decrementa o número de usuários da porta de clock e a
+ *   desliga quando o último usuário a libera. Liberar uma porta sem
+ *   usuários não tem efeito.
+ *
+ *   @param[in]  gate - porta de clock a ser liberada.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - SIM_SCGC4: System Clock Gating Control Register 4. Pág. 204.
+ *               - SIM_SCGC5: System Clock Gating Control Register 5. Pág. 206.
+ *               - SIM_SCGC6: System Clock Gating Control Register 6. Pág. 207.
+ *               - SIM_SCGC7: System Clock Gating Control Register 7. Pág. 209.
+ */
+void dsf_ClockGate_ocp::release(ClockGate_t::dsf_Gate gate) {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (userCount[gate] != 0 && --userCount[gate] == 0) {
+    gateOff(gate);
+  }
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         users
+ *
+ *   @brief      Informa o número de usuários de uma porta de clock.
+ *
+ *   @param[in]  gate - porta de clock consultada.
+ *
+ *   @return     O número de usuários da porta de clock.
+ */
+uint8_t dsf_ClockGate_ocp::users(ClockGate_t::dsf_Gate gate) {
+  return userCount[gate];
+}
+
+/*!
+ *   @fn         activeGates
+ *
+ *   @brief      Informa as portas de clock atualmente ligadas.
+ *
+ *   @return     Máscara de bits em que o bit n corresponde à porta de clock
+ *               n de ClockGate_t::dsf_Gate.
+ */
+uint32_t dsf_ClockGate_ocp::activeGates() {
+  return activeMask;
+}
+
+/*!
+ *   @fn         gateSwitches
+ *
+ *   @brief      Informa quantas vezes uma porta de clock foi ligada.
+ *
+ *   @param[in]  gate - porta de clock consultada.
+ *
+ *   @return     O número de vezes que a porta de clock foi ligada.
+ */
+uint32_t dsf_ClockGate_ocp::gateSwitches(ClockGate_t::dsf_Gate gate) {
+  return switchCount[gate];
+}
+
+/*!
+ *   @fn         gateOn
+ *
+ *   @brief      Liga a porta de clock no registrador SIM_SCGCx.
+ *
+ *   @param[in]  gate - porta de clock a ser ligada.
+ */
+void dsf_ClockGate_ocp::gateOn(ClockGate_t::dsf_Gate gate) {
+  if (gate <= ClockGate_t::dsf_PORTE) {
+    dsf_BME_ocp::setBits(&SIM_SCGC5, SIM_SCGC5_PORTA_MASK
+                         << (gate - ClockGate_t::dsf_PORTA));
+  } else if (gate <= ClockGate_t::dsf_TPM2) {
+    dsf_BME_ocp::setBits(&SIM_SCGC6, SIM_SCGC6_TPM0_MASK
+                         << (gate - ClockGate_t::dsf_TPM0));
+  } else if (gate == ClockGate_t::dsf_TSI) {
+    dsf_BME_ocp::setBits(&SIM_SCGC5, SIM_SCGC5_TSI_MASK);
+  } else if (gate == ClockGate_t::dsf_LPTMR) {
+    dsf_BME_ocp::setBits(&SIM_SCGC5, SIM_SCGC5_LPTMR_MASK);
+  } else if (gate == ClockGate_t::dsf_ADC0) {
+    dsf_BME_ocp::setBits(&SIM_SCGC6, SIM_SCGC6_ADC0_MASK);
+  } else if (gate == ClockGate_t::dsf_UART0) {
+    dsf_BME_ocp::setBits(&SIM_SCGC4, SIM_SCGC4_UART0_MASK);
+  } else {
+    dsf_BME_ocp::setBits(&SIM_SCGC6, SIM_SCGC6_DMAMUX_MASK);
+    dsf_BME_ocp::setBits(&SIM_SCGC7, SIM_SCGC7_DMA_MASK);
+  }
+  activeMask |= 1u << gate;
+  switchCount[gate]++;
+}
+
+/*!
+ *   @fn         gateOff
+ *
+ *   @brief      Desliga a porta de clock no registrador SIM_SCGCx.
+ *
+ *   @param[in]  gate - porta de clock a ser desligada.
+ */
+void dsf_ClockGate_ocp::gateOff(ClockGate_t::dsf_Gate gate) {
+  if (gate <= ClockGate_t::dsf_PORTE) {
+    dsf_BME_ocp::clearBits(&SIM_SCGC5, SIM_SCGC5_PORTA_MASK
+                           << (gate - ClockGate_t::dsf_PORTA));
+  } else if (gate <= ClockGate_t::dsf_TPM2) {
+    dsf_BME_ocp::clearBits(&SIM_SCGC6, SIM_SCGC6_TPM0_MASK
+                           << (gate - ClockGate_t::dsf_TPM0));
+  } else if (gate == ClockGate_t::dsf_TSI) {
+    dsf_BME_ocp::clearBits(&SIM_SCGC5, SIM_SCGC5_TSI_MASK);
+  } else if (gate == ClockGate_t::dsf_LPTMR) {
+    dsf_BME_ocp::clearBits(&SIM_SCGC5, SIM_SCGC5_LPTMR_MASK);
+  } else if (gate == ClockGate_t::dsf_ADC0) {
+    dsf_BME_ocp::clearBits(&SIM_SCGC6, SIM_SCGC6_ADC0_MASK);
+  } else if (gate == ClockGate_t::dsf_UART0) {
+    dsf_BME_ocp::clearBits(&SIM_SCGC4, SIM_SCGC4_UART0_MASK);
+  } else {
+    dsf_BME_ocp::clearBits(&SIM_SCGC7, SIM_SCGC7_DMA_MASK);
+    dsf_BME_ocp::clearBits(&SIM_SCGC6, SIM_SCGC6_DMAMUX_MASK);
+  }
+  activeMask &= ~(1u << gate);
+}
@@ -0,0 +1,125 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Gerenciador de clock gating dos periféricos por contagem de
+ *              referências.
+ *
+ * @file        dsf_ClockGate_ocp.h
+ * @version     1.0
+ * @date        14 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   SIM.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (14 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_CLOCKGATE_OCP_H_
+#define DSF_CLOCKGATE_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+
+/*!
+ * Namespace de definição das portas de clock (gates) gerenciadas.
+ */
+namespace ClockGate_t {
+  enum dsf_Gate {
+    dsf_PORTA = 0,
+    dsf_PORTB = 1,
+    dsf_PORTC = 2,
+    dsf_PORTD = 3,
+    dsf_PORTE = 4,
+    dsf_TPM0 = 5,
+    dsf_TPM1 = 6,
+    dsf_TPM2 = 7,
+    dsf_TSI = 8,
+    dsf_LPTMR = 9,
+    dsf_ADC0 = 10,
+    dsf_DMA = 11,
+    dsf_UART0 = 12,
+    dsf_NumGates
+  };
+}  // namespace ClockGate_t
+
+/*!
+ *  @class    dsf_ClockGate_ocp
+ *
+ *  @brief    Classe de gerenciamento do clock gating dos periféricos.
+ *
+ *  @details  Cada porta de clock dos registradores SIM_SCGC4 a SIM_SCGC7
+ *            possui um contador de usuários. O clock é ligado quando o
+ *            primeiro usuário o adquire e desligado quando o último o
+ *            libera, de modo que periféricos ociosos não consumam corrente.
+ *
+ *            As operações são atômicas em relação às interrupções.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Aquisição e liberação do clock do TPM2.
+ *             +fn dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_TPM2);
+ *             +fn dsf_ClockGate_ocp::release(ClockGate_t::dsf_TPM2);
+ *
+ *            Consulta das portas ativas, para o perfil de consumo.
+ *             +fn mask = dsf_ClockGate_ocp::activeGates();
+ */
+class dsf_ClockGate_ocp {
+ public:
+  /*!
+   * Métodos de aquisição e liberação de uma porta de clock.
+   */
+  static void acquire(ClockGate_t::dsf_Gate gate);
+  static void release(ClockGate_t::dsf_Gate gate);
+  /*!
+   * Métodos de consulta para o perfil de consumo.
+   */
+  static uint8_t users(ClockGate_t::dsf_Gate gate);
+  static uint32_t activeGates();
+  static uint32_t gateSwitches(ClockGate_t::dsf_Gate gate);
+
+ private:
+  /*!
+   * Número de usuários de cada porta de clock.
+   */
+  static uint8_t userCount[ClockGate_t::dsf_NumGates];
+  /*!
+   * Número de vezes que cada porta de clock foi ligada.
+   */
+  static uint32_t switchCount[ClockGate_t::dsf_NumGates];
+  /*!
+   * Máscara das portas de clock atualmente ligadas.
+   */
+  static uint32_t activeMask;
+  /*!
+   * Métodos privados de acesso aos registradores SIM_SCGCx.
+   */
+  static void gateOn(ClockGate_t::dsf_Gate gate);
+  static void gateOff(ClockGate_t::dsf_Gate gate);
+};
+
+#endif  //  DSF_CLOCKGATE_OCP_H_
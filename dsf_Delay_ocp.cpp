@@ -1,213 +1,357 @@
-/*!
- * @copyright    2017 UFAM - Universidade Federal do Amazonas.
- *
- * @brief       API em C++ para o perifrico TPM, no modo delay.
- *
- * @file        dsf_Delay_ocp.h
- * @version     1.0
- * @date        31 Julho 2017
- *
- * @section     HARDWARES & SOFTWARES
- *              +board        FRDM-KL25Z da NXP.
- *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
- *              +peripheral   TPM.
- *              +compiler     Kinetis Design Studio IDE.
- *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
- *              +revisions    Verso (data): Descrio breve.
- *                             ++ 1.0 (6 Julho 2017): Verso inicial.
- *
- * @section     AUTHORS & DEVELOPERS
- *              +institution  Universidade Federal do Amazonas.
- *              +courses      Engenharia da Computao / Engenharia Eltrica.
- *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
- *              +student      Verso inicial:
- *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
- *
- * @section     LICENSE
- *
- *              GNU General Public License (GNU GPL).
- *
- *              Este programa  um software livre; Voc pode redistribu-lo
- *              e/ou modific-lo de acordo com os termos do "GNU General Public
- *              License" como publicado pela Free Software Foundation; Seja a
- *              verso 3 da licena, ou qualquer verso posterior.
- *
- *              Este programa  distribudo na esperana de que seja til,
- *              mas SEM QUALQUER GARANTIA; Sem a garantia implcita de
- *              COMERCIALIZAO OU USO PARA UM DETERMINADO PROPSITO.
- *              Veja o site da "GNU General Public License" para mais detalhes.
- *
- * @htmlonly    http://www.gnu.org/copyleft/gpl.html
- */
-
-
-#include <stdint.h>
-#include "dsf_Delay_ocp.h"
-
-
-/*!
- *   @fn       dsf_Delay_ocp
- *
- *   @brief    Mtodo construtor da classe.
- *
- *   Mtodo construtor da classe, que inicializa os atributos do objeto.
- *
- *   @param[in]  tpm - perifrico TPM a ser associado ao objeto de software.
- */
-dsf_Delay_ocp::dsf_Delay_ocp(TPM_t::TPMNumber_t tpm) {
-  uint8_t *baseAddress;
-
-  baseAddress = (uint8_t *)(TPM0_BASE + 0x1000*tpm);
-  bindPeripheral(baseAddress);
-  enablePeripheralClock(tpm);
-}
-
-
-/*!
- *   @fn       setFrequency
- *
- *   @brief    Mtodo de ajuste da frequncia de operao.
- *
- *   Mtodo que ajusta a frequncia de operao do delay.
- *
- *   @param[in]  divBase - constante de diviso do divisor de frequncia.
- */
-void dsf_Delay_ocp::setFrequency(TPMDiv_t::TPMDiv divBase) {
-  freqDiv = divBase;
-}
-
-
-/*!
- *   @fn       startDelay
- *
- *   @brief    Inicia a operao do perifrico TPM no modo delay.
- *
- *   Mtodo que inicia um delay de durao especificada.
- *
- *   @param[in] cycles - nmero de ciclos de relgio da operao.
- *
- *   @details   Este mtodo no "prende", i.e., o mtodo apenas inicia a
- *              contagem do temporizador.
- *
- *              O parmetro "cycles" no corresponde ao tempo, em segundos,
- *              da temporizao iniciada.
- *              A equao que relaciona o parmetro "cycles" ao tempo,
- *              em segundos,  dada por:
- *
- *              cycles = T*(20.97*10^6)/divBase,
- *
- *              onde:
- *              - T       : tempo em segundos;
- *              - divBase : fator de diviso configurado no mtodo
- *                          setFrequency;
- *              - cycles  : ciclos de relgio.
- *
- *              Note o maior valor do parmetro dever ser de 65535, que
- *               o maior valor em decimal que se obtm com 16 bits.
- *              65535  o fundo de escala do registrador TPM_CNT.
- */
-void dsf_Delay_ocp::startDelay(uint16_t cycles) {
-  /*!
-   * Desabilita a contagem.
-   */
-  *addressTPMxSC = 0;
-  /*!
-   * Reseta o contador CNT.
-   */
-  *addressTPMxCNT = 0;
-  /*!
-   * Ajusta o fundo de escala do registrador "Modulo".
-   */
-  *addressTPMxMOD = cycles;
-  /*!
-   * Ajusta o valor de diviso.
-   */
-  *addressTPMxSC |= freqDiv;
-  /*!
-   * Limpa a flag de trmino TOF do registrador Status Counter.
-   */
-  *addressTPMxSC |= 0x80;
-  /*!
-   * Habilita a contagem.
-   */
-  *addressTPMxSC |= 0x08;
-}
-
-
-/*!
- *   @fn       timeoutDelay
- *
- *   @brief    Indica a ocorrncia do trmino de temporizao.
- *
- *   Mtodo que indica se o tempo especificado pelo
- *
- *   @param[in]  divBase - constante de diviso do divisor de frequncia.
- */
-int dsf_Delay_ocp::timeoutDelay() {
-  if (*addressTPMxSC & 0x80) {
-    return 1;
-  }
-  return 0;
-}
-
-
-/*!
- *   @fn       waitDelay
- *
- *   @brief    Inicia a operao do perifrico TPM no modo delay.
- *
- *   Mtodo que inicia um delay de durao especificada.
- *
- *   @param[in] cycles - nmero de ciclos de relgio da operao.
- *
- *   @details   Este mtodo aguarda at que o valor de temporizao desejado
- *              se esgote.
- *
- *              O parmetro "cycles" no corresponde ao tempo, em segundos,
- *              da temporizao iniciada.
- *              A equao que relaciona o parmetro "cycles" ao tempo,
- *              em segundos,  dada por:
- *
- *              cycles = T*(20.97*10^6)/divBase,
- *
- *              onde:
- *              - T       : tempo em segundos;
- *              - divBase : fator de diviso configurado no mtodo
- *                          setFrequency;
- *              - cycles  : ciclos de relgio.
- *
- *              Note o maior valor do parmetro dever ser de 65535, que
- *               o maior valor em decimal que se obtm com 16 bits.
- *              65535  o fundo de escala do registrador TPM_CNT.
- */
-void dsf_Delay_ocp::waitDelay(uint16_t cycles) {
-  startDelay(cycles);
-  do {} while (timeoutDelay() != 1);
-}
-
-
-/*!
- *   @fn       cancelDelay
- *
- *   @brief    Cancela uma temporizao em andamento.
- *
- *   Mtodo que cancela uma temporizao iniciada, parando o contador.
- */
-void dsf_Delay_ocp::cancelDelay() {
-  *addressTPMxSC = 0;
-}
-
-
-/*!
- *   @fn       getCounter
- *
- *   @brief    Mtodo que informa o valor atual da contagem.
- *
- *   Mtodo que informa o valor atual do contador do temporizador.
- *
- *   @param[in]  value - varivel passada por referncia que ser atualizada
- *                       com o valor corrente do contador do temporizador.
- */
-void dsf_Delay_ocp::getCounter(uint16_t *value) {
-  *value = *addressTPMxCNT;
-}
+/*!
+ * @copyright   © 2017 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para o periférico TPM, no modo delay.
+ *
+ * @file        dsf_Delay_ocp.h
+ * @version     1.0
+ * @date        31 Julho 2017
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (6 Julho 2017): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *              +student      Versão inicial:
+ *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+
+#include <stdint.h>
+#include "dsf_Delay_ocp.h"
+#ifdef DSF_LOAD_METER
+#include "dsf_LoadMeter_ocp.h"
+#endif
+
+
+/*!
+ *   @fn       dsf_Delay_ocp
+ *
+ *   @brief    Método construtor da classe.
+ *
+ *   Método construtor da classe, que inicializa os atributos do objeto.
+ *   O clock do TPM só é adquirido quando uma temporização é iniciada.
+ *
+ *   @param[in]  tpm - periférico TPM a ser associado ao objeto de software.
+ */
+dsf_Delay_ocp::dsf_Delay_ocp(TPM_t::TPMNumber_t tpm) {
+  uint8_t *baseAddress;
+
+  baseAddress = (uint8_t *)(TPM0_BASE + 0x1000*tpm);
+  bindPeripheral(baseAddress);
+  TPMNumber = tpm;
+}
+
+
+/*!
+ *   @fn       ~dsf_Delay_ocp
+ *
+ *   @brief    Método destrutor da classe.
+ *
+ *   Método destrutor da classe, que cancela a temporização em andamento e
+ *   libera o clock do TPM.
+ */
+dsf_Delay_ocp::~dsf_Delay_ocp() {
+  cancelDelay();
+}
+
+
+/*!
+ *   @fn       setFrequency
+ *
+ *   @brief    Método de ajuste da frequência de operação.
+ *
+ *   Método que ajusta a frequência de operação do delay.
+ *
+ *   @param[in]  divBase - constante de divisão do divisor de frequência.
+ */
+void dsf_Delay_ocp::setFrequency(TPMDiv_t::TPMDiv divBase) {
+  freqDiv = divBase;
+}
+
+
+/*!
+ *   @fn       startDelay
+ *
+ *   @brief    Inicia a operação do periférico TPM no modo delay.
+ *
+ *   Método que inicia um delay de duração especificada.
+ *
+ *   @param[in] cycles - número de ciclos de relógio da operação.
+ *
+ *   @details   Este método não "prende", i.e., o método apenas inicia a
+ *              contagem do temporizador.
+ *
+ *              O parâmetro "cycles" não corresponde ao tempo, em segundos,
+ *              da temporização iniciada.
+ *              A equação que relaciona o parâmetro "cycles" ao tempo,
+ *              em segundos, é dada por:
+ *
+ *              cycles = T*fTPM/divBase,
+ *
+ *              onde:
+ *              - T       : tempo em segundos;
+ *              - fTPM    : dsf_MCG_ocp::timerHz(), 20,97*10^6 no FEI;
+ *              - divBase : fator de divisão configurado no método
+ *                          setFrequency;
+ *              - cycles  : ciclos de relógio.
+ *
+ *              Note o maior valor do parâmetro deverá ser de 65535, que
+ *              é o maior valor em decimal que se obtém com 16 bits.
+ *              65535 é o fundo de escala do registrador TPM_CNT.
+ *
+ *              O clock do TPM é adquirido aqui e permanece ligado até a
+ *              chamada de cancelDelay.
+ */
+void dsf_Delay_ocp::startDelay(uint16_t cycles) {
+  /*!
+   * Adquire o clock do TPM.
+   */
+  enablePeripheralClock(TPMNumber);
+  /*!
+   * Reseta o contador, ajusta o fundo de escala se mudou e, em uma só
+   * escrita, o divisor, a flag de término TOF e a contagem.
+   */
+  restartCounter(cycles, 0x80 | 0x08 | freqDiv);
+}
+
+
+/*!
+ *   @fn       timeoutDelay
+ *
+ *   @brief    Indica a ocorrência do término de temporização.
+ *
+ *   Método que indica se o tempo especificado pelo
+ *
+ *   @param[in]  divBase - constante de divisão do divisor de frequência.
+ */
+int dsf_Delay_ocp::timeoutDelay() {
+  /*!
+   * Sem clock não há temporização em andamento e o TPM não pode ser lido.
+   */
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return 0;
+  }
+  if (*addressTPMxSC & 0x80) {
+    return 1;
+  }
+  return 0;
+}
+
+
+/*!
+ *   @fn       waitDelay
+ *
+ *   @brief    Inicia a operação do periférico TPM no modo delay.
+ *
+ *   Método que inicia um delay de duração especificada.
+ *
+ *   @param[in] cycles - número de ciclos de relógio da operação.
+ *
+ *   @details   Este método aguarda até que o valor de temporização desejado
+ *              se esgote.
+ *
+ *              O parâmetro "cycles" não corresponde ao tempo, em segundos,
+ *              da temporização iniciada.
+ *              A equação que relaciona o parâmetro "cycles" ao tempo,
+ *              em segundos, é dada por:
+ *
+ *              cycles = T*fTPM/divBase,
+ *
+ *              onde:
+ *              - T       : tempo em segundos;
+ *              - fTPM    : dsf_MCG_ocp::timerHz(), 20,97*10^6 no FEI;
+ *              - divBase : fator de divisão configurado no método
+ *                          setFrequency;
+ *              - cycles  : ciclos de relógio.
+ *
+ *              Note o maior valor do parâmetro deverá ser de 65535, que
+ *              é o maior valor em decimal que se obtém com 16 bits.
+ *              65535 é o fundo de escala do registrador TPM_CNT.
+ *
+ *              Ao término, o contador é parado e o clock do TPM liberado.
+ *
+ *              Com -DDSF_LOAD_METER a espera é contabilizada como
+ *              dsf_Delay no dsf_LoadMeter_ocp.
+ */
+void dsf_Delay_ocp::waitDelay(uint16_t cycles) {
+#ifdef DSF_LOAD_METER
+  uint8_t previous = dsf_LoadMeter_ocp::enter(LoadMeter_t::dsf_Delay);
+#endif
+  startDelay(cycles);
+  do {} while (timeoutDelay() != 1);
+  cancelDelay();
+#ifdef DSF_LOAD_METER
+  dsf_LoadMeter_ocp::leave(previous);
+#endif
+}
+
+
+/*!
+ *   @fn       microsToTicks
+ *
+ *   @brief    Converte um tempo em microssegundos para ticks do TPM.
+ *
+ *   Usa dsf_MCG_ocp::timerHz(), que inclui a correção do
+ *   dsf_Calibration_ocp, e o divisor configurado em setFrequency. O
+ *   resultado é arredondado para o tick mais próximo. O resultado tem 64
+ *   bits: no PEE48 com Div1, 2^32 ticks são apenas 89 s.
+ *
+ *   @param[in]  micros - tempo em microssegundos.
+ *
+ *   @return   número de ticks do TPM.
+ */
+uint64_t dsf_Delay_ocp::microsToTicks(uint32_t micros) {
+  uint64_t scaled = (uint64_t)1000000 << freqDiv;
+
+  return ((uint64_t)micros*dsf_MCG_ocp::timerHz() + scaled/2)/scaled;
+}
+
+
+/*!
+ *   @fn       waitMicros
+ *
+ *   @brief    Espera um tempo em microssegundos.
+ *
+ *   O tempo é convertido por microsToTicks e, se passa do fundo de escala
+ *   do TPM, dividido em partes iguais de no máximo 65536 ticks, cada uma
+ *   esperada com waitDelay. Ao contrário de waitDelay com um número fixo
+ *   de ciclos, a espera acompanha o perfil do MCG e a sua correção.
+ *
+ *   @param[in]  micros - tempo em microssegundos.
+ */
+void dsf_Delay_ocp::waitMicros(uint32_t micros) {
+  uint64_t ticks = microsToTicks(micros);
+  uint64_t parts = (ticks + 0xFFFF) >> 16;
+  uint64_t chunk;
+
+  while (parts) {
+    chunk = (ticks + parts - 1)/parts;
+    waitDelay((uint16_t)(chunk - 1));
+    ticks -= chunk;
+    parts--;
+  }
+}
+
+
+/*!
+ *   @fn       cancelDelay
+ *
+ *   @brief    Cancela uma temporização em andamento.
+ *
+ *   Método que cancela uma temporização iniciada, parando o contador e
+ *   liberando o clock do TPM.
+ */
+void dsf_Delay_ocp::cancelDelay() {
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  writeSC(0);
+  disablePeripheralClock();
+}
+
+
+/*!
+ *   @fn       getCounter
+ *
+ *   @brief    Método que informa o valor atual da contagem.
+ *
+ *   Método que informa o valor atual do contador do temporizador.
+ *
+ *   @param[in]  value - variável passada por referência que será atualizada
+ *                       com o valor corrente do contador do temporizador.
+ */
+void dsf_Delay_ocp::getCounter(uint16_t *value) {
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    *value = 0;
+    return;
+  }
+  *value = *addressTPMxCNT;
+}
+
+
+/*!
+ *   @fn       remainingDelay
+ *
+ *   @brief    Informa o tempo que falta para o término da temporização.
+ *
+ *   Método usado pelo dsf_Power_ocp para limitar o sono ao término da
+ *   temporização em andamento.
+ *
+ *   @param[out] micros - tempo restante, em microssegundos (0 se a
+ *                        temporização já terminou).
+ *
+ *   @return   1 se há uma temporização iniciada e 0 se não há.
+ */
+int dsf_Delay_ocp::remainingDelay(uint32_t *micros) {
+  uint32_t status, ticks;
+
+  *micros = 0;
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return 0;
+  }
+  status = *addressTPMxSC;
+  if (!(status & 0x18)) {
+    return 0;
+  }
+  if (status & 0x80) {
+    return 1;
+  }
+  ticks = *addressTPMxMOD + 1 - *addressTPMxCNT;
+  *micros = (uint32_t)(((uint64_t)ticks << freqDiv)*1000000
+                       /dsf_MCG_ocp::timerHz());
+  return 1;
+}
+
+
+/*!
+ *   @fn       resumeDelay
+ *
+ *   @brief    Desconta da temporização o tempo passado em VLPS ou LLS.
+ *
+ *   Nos modos de parada o relógio do TPM é desligado e ele não conta, mas
+ *   mantém CNT e MOD. Na volta, a temporização em andamento é reiniciada
+ *   com o restante menos o tempo dormido; se ele já passou do término, o
+ *   TOF é ligado no próximo tick.
+ *
+ *   @param[in]  elapsedMicros - tempo passado com o TPM parado.
+ */
+void dsf_Delay_ocp::resumeDelay(uint32_t elapsedMicros) {
+  uint32_t status, remaining, ticks;
+
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  status = *addressTPMxSC;
+  if (!(status & 0x18) || (status & 0x80)) {
+    return;
+  }
+  remaining = *addressTPMxMOD + 1 - *addressTPMxCNT;
+  ticks = (uint32_t)(((uint64_t)elapsedMicros*dsf_MCG_ocp::timerHz()
+                      /1000000) >> freqDiv);
+  startDelay(ticks + 1 < remaining ? (uint16_t)(remaining - ticks - 1) : 0);
+}
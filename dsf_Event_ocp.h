@@ -0,0 +1,174 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Eventos de entrada e fila de eventos sem bloqueio.
+ *
+ * @file        dsf_Event_ocp.h
+ * @version     1.0
+ * @date        21 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (21 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_EVENT_OCP_H_
+#define DSF_EVENT_OCP_H_
+
+#include <stdint.h>
+
+/*!
+ * Namespace de definição das origens e tipos de eventos de entrada.
+ */
+namespace Event_t {
+  enum dsf_EventSource {
+    dsf_SourceKey = 0,
+    dsf_SourceKeypad = 1,
+    dsf_SourceTouch = 2
+  };
+  enum dsf_EventType {
+    dsf_Press = 0,
+    dsf_Release = 1
+  };
+}  // namespace Event_t
+
+/*!
+ *  @struct   dsf_Event
+ *
+ *  @brief    Evento de entrada.
+ *
+ *  @details  O campo code identifica a tecla dentro da origem e o campo
+ *            stamp registra o número da varredura em que o evento ocorreu.
+ */
+struct dsf_Event {
+  uint8_t source;
+  uint8_t type;
+  uint8_t code;
+  uint8_t reserved;
+  uint32_t stamp;
+};
+
+/*!
+ *  @class    dsf_EventQueue_ocp
+ *
+ *  @brief    Fila circular de eventos com um produtor e um consumidor.
+ *
+ *  @details  O produtor (tipicamente uma interrupção) só escreve o índice
+ *            head e o consumidor (o laço principal) só escreve o índice
+ *            tail. Como as escritas de 8 bits são atômicas no Cortex-M0+,
+ *            a fila não precisa desabilitar interrupções.
+ *
+ *            O tamanho deve ser uma potência de 2, no máximo 128. Eventos
+ *            que chegam com a fila cheia são descartados e contados.
+ */
+template <typename T, uint8_t Size>
+class dsf_EventQueue_ocp {
+ public:
+  /*!
+   * Método construtor da classe.
+   */
+  dsf_EventQueue_ocp() : head(0), tail(0), dropped(0) {
+  }
+
+  /*!
+   *   @fn         push
+   *
+   *   @brief      Insere um evento na fila (lado do produtor).
+   *
+   *   @param[in]  item - evento a ser inserido.
+   *
+   *   @return     false se a fila estava cheia e o evento foi descartado.
+   */
+  bool push(const T &item) {
+    uint8_t next = (uint8_t)((head + 1) & (Size - 1));
+
+    if (next == tail) {
+      dropped++;
+      return false;
+    }
+    buffer[head] = item;
+    /*!
+     * Barreira de compilação: o evento é escrito antes de ser publicado.
+     */
+    __asm volatile("" ::: "memory");
+    head = next;
+    return true;
+  }
+
+  /*!
+   *   @fn         pop
+   *
+   *   @brief      Retira um evento da fila (lado do consumidor).
+   *
+   *   @param[out] item - evento retirado.
+   *
+   *   @return     false se a fila estava vazia.
+   */
+  bool pop(T *item) {
+    if (tail == head) {
+      return false;
+    }
+    *item = buffer[tail];
+    __asm volatile("" ::: "memory");
+    tail = (uint8_t)((tail + 1) & (Size - 1));
+    return true;
+  }
+
+  /*!
+   *   @fn         isEmpty
+   *
+   *   @brief      Indica se a fila está vazia.
+   */
+  bool isEmpty() const {
+    return tail == head;
+  }
+
+  /*!
+   *   @fn         droppedCount
+   *
+   *   @brief      Informa o número de eventos descartados por fila cheia.
+   */
+  uint32_t droppedCount() const {
+    return dropped;
+  }
+
+ private:
+  static_assert(Size >= 2 && Size <= 128 && (Size & (Size - 1)) == 0,
+                "Size deve ser uma potencia de 2 entre 2 e 128");
+
+  T buffer[Size];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  volatile uint32_t dropped;
+};
+
+/*!
+ * Fila de eventos de entrada usada pelos drivers de teclado e de toque.
+ */
+typedef dsf_EventQueue_ocp<dsf_Event, 32> dsf_InputQueue_ocp;
+
+#endif  //  DSF_EVENT_OCP_H_
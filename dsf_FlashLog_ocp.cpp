@@ -0,0 +1,363 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Registro persistente de totais em setores rotativos da flash.
+ *
+ * @file        dsf_FlashLog_ocp.cpp
+ * @version     1.0
+ * @date        5 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   FTFA.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (5 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_FlashLog_ocp.h"
+
+namespace {
+
+/*!
+ * Palavra apagada, marca das etiquetas e valor de uma época inválida.
+ */
+const uint32_t kErased = 0xFFFFFFFF;
+const uint32_t kMark = 0x5A;
+
+/*!
+ * CRC-8 de polinômio 0x07, o mesmo dos quadros de telemetria, calculado
+ * bit a bit: são só 5 bytes por entrada.
+ */
+uint8_t crc8(uint8_t key, uint32_t data) {
+  uint8_t bytes[5] = {key, (uint8_t)data, (uint8_t)(data >> 8),
+                      (uint8_t)(data >> 16), (uint8_t)(data >> 24)};
+  uint8_t crc = 0;
+
+  for (int i = 0; i < 5; i++) {
+    crc ^= bytes[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (uint8_t)((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+  }
+  return crc;
+}
+
+/*!
+ * Etiqueta: chave (7:0), complemento da chave (15:8), CRC-8 (23:16) e a
+ * marca (31:24).
+ */
+uint32_t tag(uint8_t key, uint32_t data) {
+  return (uint32_t)key | (uint32_t)(uint8_t)~key << 8
+         | (uint32_t)crc8(key, data) << 16 | kMark << 24;
+}
+
+}  // namespace
+
+/*!
+ *   @fn         dsf_FlashLog_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Nada é lido da flash antes de mount.
+ *
+ *   @param[in]  base - endereço do primeiro setor, alinhado ao setor.
+ *               sectors - número de setores do rodízio, no mínimo 2.
+ */
+dsf_FlashLog_ocp::dsf_FlashLog_ocp(uint32_t base, uint8_t sectors)
+    : baseAddress(base), currentEpoch(0), stallCount(0), next(0),
+      present(0), sectorCount(sectors < 2 ? 2 : sectors), active(0),
+      spareReady(false), mounted(false) {
+}
+
+/*!
+ *   @fn         mount
+ *
+ *   @brief      Recupera os totais gravados e prepara o registro.
+ *
+ *   Sem nenhum cabeçalho válido (flash nova), o primeiro setor é
+ *   formatado com a época 1. Lê os dsf_LogSectors cabeçalhos e as
+ *   dsf_Slots entradas do setor ativo, sem depender do histórico.
+ *
+ *   @return     Flash_t::dsf_FlashOk ou os bits de erro do FSTAT.
+ */
+uint8_t dsf_FlashLog_ocp::mount() {
+  uint32_t best = 0;
+
+  mounted = false;
+  present = 0;
+  for (uint8_t s = 0; s < sectorCount; s++) {
+    uint32_t header = dsf_Flash_ocp::read(slotAddress(s, 0));
+    if (dsf_Flash_ocp::read(slotAddress(s, 0) + 4) == ~header
+        && header != 0 && header > best) {
+      best = header;
+      active = s;
+    }
+  }
+  if (best == 0) {
+    return format();
+  }
+  currentEpoch = best;
+
+  /*!
+   * As entradas são gravadas em ordem: a próxima livre vem depois da
+   * última não apagada, mesmo que ela tenha sido interrompida.
+   */
+  next = 1;
+  for (uint16_t slot = 1; slot < FlashLog_t::dsf_Slots; slot++) {
+    uint32_t address = slotAddress(active, slot);
+    uint32_t data;
+    uint8_t key;
+
+    if (dsf_Flash_ocp::read(address) != kErased
+        || dsf_Flash_ocp::read(address + 4) != kErased) {
+      next = slot + 1;
+    }
+    if (readRecord(address, &key, &data)) {
+      values[key] = data;
+      present |= (uint8_t)(1u << key);
+    }
+  }
+  spareReady = !dsf_Flash_ocp::verifyErased(slotAddress(spare(), 0),
+                                            Flash_t::dsf_SectorSize/4);
+  mounted = true;
+  return Flash_t::dsf_FlashOk;
+}
+
+/*!
+ *   @fn         set
+ *
+ *   @brief      Grava o novo valor de um total.
+ *
+ *   Um valor igual ao atual não é gravado.
+ *
+ *   @param[in]  key - chave, de 0 a dsf_MaxKeys - 1.
+ *               data - novo valor.
+ *
+ *   @return     Flash_t::dsf_FlashOk, os bits de erro do FSTAT ou
+ *               Flash_t::dsf_FlashAccess sem mount ou com chave inválida.
+ */
+uint8_t dsf_FlashLog_ocp::set(uint8_t key, uint32_t data) {
+  uint8_t status;
+
+  if (!mounted || key >= FlashLog_t::dsf_MaxKeys) {
+    return Flash_t::dsf_FlashAccess;
+  }
+  if (has(key) && values[key] == data) {
+    return Flash_t::dsf_FlashOk;
+  }
+  if (next >= FlashLog_t::dsf_Slots) {
+    stallCount++;
+    status = compact();
+    if (status != Flash_t::dsf_FlashOk) {
+      return status;
+    }
+  }
+  status = writeRecord(slotAddress(active, next), key, data);
+  next++;
+  if (status == Flash_t::dsf_FlashOk) {
+    values[key] = data;
+    present |= (uint8_t)(1u << key);
+  }
+  return status;
+}
+
+/*!
+ *   @fn         add
+ *
+ *   @brief      Soma delta a um total e grava o resultado.
+ */
+uint8_t dsf_FlashLog_ocp::add(uint8_t key, uint32_t delta) {
+  return set(key, value(key) + delta);
+}
+
+/*!
+ *   @fn         service
+ *
+ *   @brief      Adianta o trabalho que set teria que esperar.
+ *
+ *   Apaga o próximo setor se ele não está apagado ou, com o setor ativo
+ *   a dsf_CompactSlots entradas do fim, compacta. Cada chamada faz no
+ *   máximo uma dessas operações.
+ *
+ *   @return     true se fez alguma operação.
+ */
+bool dsf_FlashLog_ocp::service() {
+  if (!mounted) {
+    return false;
+  }
+  if (!spareReady) {
+    prepareSpare();
+    return true;
+  }
+  if (FlashLog_t::dsf_Slots - next <= FlashLog_t::dsf_CompactSlots) {
+    compact();
+    return true;
+  }
+  return false;
+}
+
+uint32_t dsf_FlashLog_ocp::value(uint8_t key) {
+  return has(key) ? values[key] : 0;
+}
+
+bool dsf_FlashLog_ocp::has(uint8_t key) {
+  return key < FlashLog_t::dsf_MaxKeys && ((present >> key) & 1);
+}
+
+uint32_t dsf_FlashLog_ocp::epoch() {
+  return currentEpoch;
+}
+
+uint16_t dsf_FlashLog_ocp::freeSlots() {
+  return mounted ? (uint16_t)(FlashLog_t::dsf_Slots - next) : 0;
+}
+
+uint32_t dsf_FlashLog_ocp::stalls() {
+  return stallCount;
+}
+
+uint32_t dsf_FlashLog_ocp::slotAddress(uint8_t sector, uint16_t slot) {
+  return baseAddress + (uint32_t)sector*Flash_t::dsf_SectorSize
+         + (uint32_t)slot*FlashLog_t::dsf_SlotSize;
+}
+
+uint8_t dsf_FlashLog_ocp::spare() {
+  return (uint8_t)((active + 1) % sectorCount);
+}
+
+/*!
+ * Inicia o registro vazio no primeiro setor, com a época 1.
+ */
+uint8_t dsf_FlashLog_ocp::format() {
+  uint8_t status = Flash_t::dsf_FlashOk;
+
+  active = 0;
+  if (dsf_Flash_ocp::verifyErased(slotAddress(0, 0),
+                                  Flash_t::dsf_SectorSize/4)) {
+    status = dsf_Flash_ocp::eraseSector(slotAddress(0, 0));
+  }
+  if (status == Flash_t::dsf_FlashOk) {
+    status = writeHeader(0, 1);
+  }
+  if (status != Flash_t::dsf_FlashOk) {
+    return status;
+  }
+  currentEpoch = 1;
+  next = 1;
+  spareReady = false;
+  mounted = true;
+  return Flash_t::dsf_FlashOk;
+}
+
+/*!
+ * Apaga o próximo setor, se a verificação não o encontra apagado.
+ */
+uint8_t dsf_FlashLog_ocp::prepareSpare() {
+  uint32_t address = slotAddress(spare(), 0);
+  uint8_t status = dsf_Flash_ocp::verifyErased(address,
+                                               Flash_t::dsf_SectorSize/4);
+
+  if (status != Flash_t::dsf_FlashOk) {
+    status = dsf_Flash_ocp::eraseSector(address);
+  }
+  spareReady = status == Flash_t::dsf_FlashOk;
+  return status;
+}
+
+/*!
+ * Copia os totais para o próximo setor e o torna ativo gravando o seu
+ * cabeçalho por último. Interrompida antes do cabeçalho, o setor ativo
+ * continua o anterior e o próximo é apagado de novo.
+ */
+uint8_t dsf_FlashLog_ocp::compact() {
+  uint8_t target = spare();
+  uint16_t slot = 1;
+  uint8_t status;
+
+  if (!spareReady) {
+    status = prepareSpare();
+    if (status != Flash_t::dsf_FlashOk) {
+      return status;
+    }
+  }
+  spareReady = false;
+  for (uint8_t key = 0; key < FlashLog_t::dsf_MaxKeys; key++) {
+    if (has(key)) {
+      status = writeRecord(slotAddress(target, slot++), key, values[key]);
+      if (status != Flash_t::dsf_FlashOk) {
+        return status;
+      }
+    }
+  }
+  status = writeHeader(target, currentEpoch + 1);
+  if (status != Flash_t::dsf_FlashOk) {
+    return status;
+  }
+  active = target;
+  currentEpoch++;
+  next = slot;
+  return Flash_t::dsf_FlashOk;
+}
+
+/*!
+ * Cabeçalho: a época e depois o seu complemento, que valida o setor.
+ */
+uint8_t dsf_FlashLog_ocp::writeHeader(uint8_t sector, uint32_t epochValue) {
+  uint8_t status = dsf_Flash_ocp::program(slotAddress(sector, 0), epochValue);
+
+  if (status != Flash_t::dsf_FlashOk) {
+    return status;
+  }
+  return dsf_Flash_ocp::program(slotAddress(sector, 0) + 4, ~epochValue);
+}
+
+/*!
+ * Entrada: o valor e depois a etiqueta, que a valida.
+ */
+uint8_t dsf_FlashLog_ocp::writeRecord(uint32_t address, uint8_t key,
+                                      uint32_t data) {
+  uint8_t status = dsf_Flash_ocp::program(address, data);
+
+  if (status != Flash_t::dsf_FlashOk) {
+    return status;
+  }
+  return dsf_Flash_ocp::program(address + 4, tag(key, data));
+}
+
+/*!
+ * Uma gravação interrompida deixa bits em 1 que deveriam ser 0: a chave
+ * deixa de ser o complemento do byte seguinte, o CRC ou a marca não
+ * conferem, e a entrada é descartada.
+ */
+bool dsf_FlashLog_ocp::readRecord(uint32_t address, uint8_t *key,
+                                  uint32_t *data) {
+  uint32_t label = dsf_Flash_ocp::read(address + 4);
+
+  *data = dsf_Flash_ocp::read(address);
+  *key = (uint8_t)label;
+  return *key < FlashLog_t::dsf_MaxKeys && label == tag(*key, *data);
+}
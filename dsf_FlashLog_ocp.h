@@ -0,0 +1,166 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Registro persistente de totais em setores rotativos da flash.
+ *
+ * @file        dsf_FlashLog_ocp.h
+ * @version     1.0
+ * @date        5 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   FTFA.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (5 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_FLASHLOG_OCP_H_
+#define DSF_FLASHLOG_OCP_H_
+
+#include <stdint.h>
+#include "dsf_Flash_ocp.h"
+
+/*!
+ * Namespace de definição da área do registro (os 4 últimos setores da
+ * flash, a serem reservados no script do linker), do tamanho das entradas
+ * e das chaves das estatísticas do sorteio.
+ */
+namespace FlashLog_t {
+  enum dsf_LogLayout {
+    dsf_LogBase = 0x1F000,
+    dsf_LogSectors = 4,
+    dsf_SlotSize = 8,
+    dsf_Slots = Flash_t::dsf_SectorSize/8,
+    dsf_MaxKeys = 8,
+    dsf_CompactSlots = 16
+  };
+  enum dsf_LogKey {
+    dsf_KeyDraws = 0,
+    dsf_KeyWins = 1
+  };
+}  // namespace FlashLog_t
+
+/*!
+ *  @class    dsf_FlashLog_ocp
+ *
+ *  @brief    Classe de totais persistentes gravados só por acréscimo.
+ *
+ *  @details  Cada atualização de um total (até dsf_MaxKeys chaves de 32
+ *            bits) grava uma entrada de 8 bytes na próxima posição livre
+ *            do setor ativo: o valor e depois a etiqueta com a chave, o
+ *            complemento da chave, o CRC-8 da chave e do valor e uma marca.
+ *            Nenhum setor é apagado a cada atualização; uma entrada custa
+ *            duas gravações de 65 us.
+ *
+ *            A primeira posição de cada setor é o cabeçalho: a época e o
+ *            seu complemento. O setor ativo é o de maior época válida.
+ *            Quando o setor ativo enche, a compactação copia os totais
+ *            correntes para o setor seguinte, já apagado, e grava o
+ *            cabeçalho com a época seguinte por último. Os setores são
+ *            usados em rodízio, o que distribui igualmente os apagamentos.
+ *
+ *            Gravar só leva bits de 1 para 0 e apagar só de 0 para 1, de
+ *            modo que uma gravação ou um apagamento interrompido por falta
+ *            de energia nunca produz um par valor/complemento consistente:
+ *            entradas e cabeçalhos incompletos são sempre descartados, e
+ *            os totais recuperados são os da última atualização completa
+ *            (ou da interrompida, se ela chegou ao fim).
+ *
+ *            A recuperação na partida (mount) lê os cabeçalhos e só o
+ *            setor ativo, que começa com todos os totais: o custo não
+ *            depende do número de atualizações já feitas.
+ *
+ *            O apagamento do próximo setor (14 ms com as interrupções
+ *            mascaradas) e a compactação são feitos por service, chamado
+ *            quando a aplicação pode esperar, por exemplo no laço ocioso.
+ *            set só apaga e compacta ele mesmo se service não foi chamado
+ *            a tempo; essas esperas são contadas em stalls.
+ *
+ *            Os métodos não são reentrantes: são chamados só do laço
+ *            principal.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Totais do sorteio.
+ *             +fn dsf_FlashLog_ocp stats;
+ *             +fn stats.mount();
+ *             +fn stats.add(FlashLog_t::dsf_KeyDraws, 1);
+ *             +fn wins = stats.value(FlashLog_t::dsf_KeyWins);
+ *             +fn stats.service();
+ */
+class dsf_FlashLog_ocp {
+ public:
+  /*!
+   * Método construtor da classe.
+   */
+  explicit dsf_FlashLog_ocp(uint32_t base = FlashLog_t::dsf_LogBase,
+                            uint8_t sectors = FlashLog_t::dsf_LogSectors);
+
+  /*!
+   * Métodos de recuperação e de atualização dos totais.
+   */
+  uint8_t mount();
+  uint8_t set(uint8_t key, uint32_t value);
+  uint8_t add(uint8_t key, uint32_t delta);
+
+  /*!
+   * Método de manutenção: um apagamento ou uma compactação por chamada.
+   */
+  bool service();
+
+  /*!
+   * Métodos de consulta.
+   */
+  uint32_t value(uint8_t key);
+  bool has(uint8_t key);
+  uint32_t epoch();
+  uint16_t freeSlots();
+  uint32_t stalls();
+
+ private:
+  uint32_t slotAddress(uint8_t sector, uint16_t slot);
+  uint8_t spare();
+  uint8_t format();
+  uint8_t prepareSpare();
+  uint8_t compact();
+  uint8_t writeHeader(uint8_t sector, uint32_t epochValue);
+  uint8_t writeRecord(uint32_t address, uint8_t key, uint32_t data);
+  bool readRecord(uint32_t address, uint8_t *key, uint32_t *data);
+
+  uint32_t values[FlashLog_t::dsf_MaxKeys];
+  uint32_t baseAddress;
+  uint32_t currentEpoch;
+  uint32_t stallCount;
+  uint16_t next;
+  uint8_t present;
+  uint8_t sectorCount;
+  uint8_t active;
+  bool spareReady;
+  bool mounted;
+};
+
+#endif  //  DSF_FLASHLOG_OCP_H_
@@ -0,0 +1,191 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Driver do controlador da memória flash (FTFA).
+ *
+ * @file        dsf_Flash_ocp.cpp
+ * @version     1.0
+ * @date        5 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   FTFA.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (5 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_Flash_ocp.h"
+
+/*!
+ * Registradores de 8 bits do FTFA: FSTAT e os bytes de comando. FCCOB0 a
+ * FCCOB3 ficam em ordem inversa na palavra em +4 e FCCOB4 a FCCOB7 na
+ * palavra em +8, de modo que a palavra em +4 é código << 24 | endereço e a
+ * palavra em +8 é o dado em little endian.
+ */
+#define DSF_FTFA_REG(offset) (*(volatile uint8_t *)(0x40020000 + (offset)))
+#define DSF_FTFA_FSTAT       DSF_FTFA_REG(0x0)
+#define DSF_FTFA_FCCOB0      DSF_FTFA_REG(0x7)
+
+/*!
+ * Funções executadas da RAM: a seção .data é copiada da flash para a RAM
+ * pelo código de partida, e long_call permite a chamada a partir da
+ * flash, fora do alcance de um BL.
+ */
+#ifdef DSF_HOST_SIM
+#define DSF_RAMFUNC
+#else
+#define DSF_RAMFUNC __attribute__((section(".data.ramfunc"), long_call, \
+                                   noinline))
+#endif
+
+namespace {
+
+/*!
+ * Campos do FTFA_FSTAT: CCIF (7), RDCOLERR (6), ACCERR (5), FPVIOL (4) e
+ * MGSTAT0 (0). Códigos dos comandos: Read 1s Section, Program Longword e
+ * Erase Flash Sector.
+ */
+const uint8_t kCCIF = 1u << 7;
+const uint8_t kRDCOLERR = 1u << 6;
+const uint8_t kACCERR = 1u << 5;
+const uint8_t kFPVIOL = 1u << 4;
+const uint8_t kMGSTAT0 = 1u << 0;
+const uint8_t kRead1sSection = 0x01;
+const uint8_t kProgramLongword = 0x06;
+const uint8_t kEraseSector = 0x09;
+
+/*!
+ *   @fn         launch
+ *
+ *   @brief      Lança o comando já escrito no FCCOB e espera o seu fim.
+ *
+ *   Executada da RAM: durante o comando a flash não pode ser lida.
+ *
+ *   @return     Os bits de erro do FSTAT.
+ */
+DSF_RAMFUNC uint8_t launch() {
+  uint8_t status;
+
+  DSF_FTFA_FSTAT = kCCIF;
+  do {
+    status = DSF_FTFA_FSTAT;
+  } while (!(status & kCCIF));
+  return status & (kACCERR | kFPVIOL | kMGSTAT0);
+}
+
+}  // namespace
+
+/*!
+ *   @fn         command
+ *
+ *   @brief      Executa um comando do FTFA com as interrupções mascaradas.
+ *
+ *   @param[in]  code - código do comando (FCCOB0).
+ *               address - endereço na flash (FCCOB1 a FCCOB3).
+ *               data - FCCOB4 a FCCOB7, com FCCOB7 no byte menos
+ *                      significativo.
+ *
+ *   @return     Os bits de erro do FSTAT.
+ *
+ *   @remarks    Siglas e capítulos do Manual de Referência KL25:
+ *               - FTFA_FSTAT: Flash Status Register. Cap. 27.
+ *               - FTFA_FCCOBn: Flash Common Command Object Registers.
+ *                 Cap. 27.
+ */
+uint8_t dsf_Flash_ocp::command(uint8_t code, uint32_t address,
+                               uint32_t data) {
+  uint32_t primask;
+  uint8_t status;
+
+  /*!
+   * Os comandos são síncronos: CCIF já está em 1. Um comando não é
+   * lançado com ACCERR ou FPVIOL do anterior ainda ativos; os bits são
+   * apagados escrevendo 1.
+   */
+  DSF_FTFA_FSTAT = kRDCOLERR | kACCERR | kFPVIOL;
+  for (int i = 0; i < 3; i++) {
+    DSF_FTFA_REG(0x4 + i) = (uint8_t)(address >> 8*i);
+  }
+  for (int i = 0; i < 4; i++) {
+    DSF_FTFA_REG(0x8 + i) = (uint8_t)(data >> 8*i);
+  }
+  DSF_FTFA_FCCOB0 = code;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  status = launch();
+  __set_PRIMASK(primask);
+  return status;
+}
+
+/*!
+ *   @fn         eraseSector
+ *
+ *   @brief      Apaga (leva a 0xFF) o setor de 1 KB que contém address.
+ *
+ *   As interrupções ficam mascaradas durante o apagamento, 14 ms típicos.
+ *
+ *   @param[in]  address - endereço alinhado ao setor.
+ *
+ *   @return     Flash_t::dsf_FlashOk ou os bits de erro do FSTAT.
+ */
+uint8_t dsf_Flash_ocp::eraseSector(uint32_t address) {
+  return command(kEraseSector, address, 0);
+}
+
+/*!
+ *   @fn         program
+ *
+ *   @brief      Grava uma palavra de 32 bits apagada.
+ *
+ *   @param[in]  address - endereço alinhado em 4 bytes.
+ *               value - valor gravado.
+ *
+ *   @return     Flash_t::dsf_FlashOk ou os bits de erro do FSTAT.
+ */
+uint8_t dsf_Flash_ocp::program(uint32_t address, uint32_t value) {
+  return command(kProgramLongword, address, value);
+}
+
+/*!
+ *   @fn         verifyErased
+ *
+ *   @brief      Verifica se um trecho está apagado, com a margem de
+ *               leitura normal do FTFA.
+ *
+ *   Uma leitura comum de 0xFFFFFFFF não basta após um apagamento
+ *   interrompido: células apagadas em parte podem ler 1 hoje e 0 depois.
+ *
+ *   @param[in]  address - endereço alinhado em 4 bytes.
+ *               longwords - número de palavras de 32 bits.
+ *
+ *   @return     Flash_t::dsf_FlashOk se todos os bits estão em 1,
+ *               Flash_t::dsf_FlashVerify se não, ou os bits de erro.
+ */
+uint8_t dsf_Flash_ocp::verifyErased(uint32_t address, uint32_t longwords) {
+  return command(kRead1sSection, address, (longwords & 0xFFFF) << 16);
+}
@@ -0,0 +1,115 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Driver do controlador da memória flash (FTFA).
+ *
+ * @file        dsf_Flash_ocp.h
+ * @version     1.0
+ * @date        5 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   FTFA.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (5 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_FLASH_OCP_H_
+#define DSF_FLASH_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+
+/*!
+ * Namespace de definição da geometria da flash do MKL25Z128 e do estado
+ * dos comandos: os bits de erro do FTFA_FSTAT, 0 em caso de sucesso.
+ */
+namespace Flash_t {
+  enum dsf_FlashGeometry {
+    dsf_SectorSize = 1024,
+    dsf_FlashSize = 0x20000
+  };
+  enum dsf_FlashStatus {
+    dsf_FlashOk = 0,
+    dsf_FlashVerify = 0x01,
+    dsf_FlashProtected = 0x10,
+    dsf_FlashAccess = 0x20
+  };
+}  // namespace Flash_t
+
+/*!
+ *  @class    dsf_Flash_ocp
+ *
+ *  @brief    Classe de apagamento e gravação da flash pelo FTFA.
+ *
+ *  @details  A flash do KL25 é um único bloco: enquanto um comando do FTFA
+ *            está em andamento, nenhuma leitura da flash pode ser feita,
+ *            nem de instruções. Por isso o lançamento do comando e a
+ *            espera pelo CCIF ficam em uma função na RAM e as interrupções
+ *            ficam mascaradas durante o comando, já que os tratadores e a
+ *            tabela de vetores estão na flash.
+ *
+ *            Os tempos típicos são 65 us para gravar uma palavra de 32
+ *            bits e 14 ms para apagar um setor de 1 KB (DS KL25, tabela
+ *            de tempos do FTFA). Gravar só leva bits de 1 para 0: uma
+ *            palavra é gravada uma única vez entre dois apagamentos.
+ *
+ *            Os métodos retornam os bits de erro do FSTAT (ACCERR, FPVIOL
+ *            e MGSTAT0), isto é, Flash_t::dsf_FlashOk em caso de sucesso.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Grava uma palavra no último setor.
+ *             +fn dsf_Flash_ocp::eraseSector(0x1FC00);
+ *             +fn dsf_Flash_ocp::program(0x1FC00, value);
+ *             +fn value = dsf_Flash_ocp::read(0x1FC00);
+ */
+class dsf_Flash_ocp {
+ public:
+  /*!
+   * Métodos de comando do FTFA.
+   */
+  static uint8_t eraseSector(uint32_t address);
+  static uint8_t program(uint32_t address, uint32_t value);
+  static uint8_t verifyErased(uint32_t address, uint32_t longwords);
+
+  /*!
+   *   @fn         read
+   *
+   *   @brief      Lê uma palavra de 32 bits da flash.
+   *
+   *   @param[in]  address - endereço alinhado em 4 bytes.
+   */
+  static uint32_t read(uint32_t address) {
+    return *(const volatile uint32_t *)(uintptr_t)address;
+  }
+
+ private:
+  static uint8_t command(uint8_t code, uint32_t address, uint32_t data);
+};
+
+#endif  //  DSF_FLASH_OCP_H_
@@ -1,266 +1,388 @@
-/*!
- * @copyright    2017 UFAM - Universidade Federal do Amazonas.
- *
- * @brief       Interface de programao de aplicaes em C++ para GPIO.
- *
- * @file        dsf_GPIO_ocp.cpp
- * @version     1.0
- * @date        30 Julho 2017
- *
- * @section     HARDWARES & SOFTWARES
- *              +board        FRDM-KL25Z da NXP.
- *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
- *              +peripheral   GPIO.
- *              +compiler     Kinetis Design Studio IDE.
- *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
- *              +revisions    Verso (data): Descrio breve.
- *                             ++ 1.0 (6 Julho 2017): Verso inicial.
- *
- * @section     AUTHORS & DEVELOPERS
- *              +institution  Universidade Federal do Amazonas.
- *              +courses      Engenharia da Computao / Engenharia Eltrica.
- *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
- *              +student      Verso inicial:
- *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
- *
- * @section     LICENSE
- *
- *              GNU General Public License (GNU GPL).
- *
- *              Este programa  um software livre; Voc pode redistribu-lo
- *              e/ou modific-lo de acordo com os termos do "GNU General Public
- *              License" como publicado pela Free Software Foundation; Seja a
- *              verso 3 da licena, ou qualquer verso posterior.
- *
- *              Este programa  distribudo na esperana de que seja til,
- *              mas SEM QUALQUER GARANTIA; Sem a garantia implcita de
- *              COMERCIALIZAO OU USO PARA UM DETERMINADO PROPSITO.
- *              Veja o site da "GNU General Public License" para mais detalhes.
- *
- * @htmlonly    http://www.gnu.org/copyleft/gpl.html
- */
-
-#include <MKL25Z4.h>
-#include "dsf_GPIO_ocp.h"
-
-/*!
- *   @fn       dsf_GPIO_ocp
- *
- *   @brief    Mtodo construtor da classe.
- *
- *   Este  o mtodo construtor padro da classe e realiza a associao
- *   entre o objeto de software e o perifrico de hardware, bem como a
- *   habilitao do clock do perifrico e dos registradores a ele associados.
- *
- *   @param[in]  GPIOName - GPIO;
- *               pin - pino do GPIO selecionado.
- *
- *   @remarks  Siglas e pginas do Manual de Referncia KL25:
- *             - PDOR: Port Data Output Register.Pg. 775.
- *             - PDIR: Port Data Input Register.Pg. 777.
- *             - PDDR: Port Direct Input Register. Pg. 778.
- *             - PTOR: Port Toogle Output Register.Pg.777.
- *             - PortxPCRn: Pin Control Register.Pg. 183 (Mux) and 185 (Pull).
- */
-
-dsf_GPIO_ocp::dsf_GPIO_ocp(GPIO_t::dsf_GPIO GPIOName, GPIO_t::dsf_Pin pin) {
-  pinPort = 1 << pin;
-  bindPeripheral(GPIOName, pin);
-  enableModuleClock(GPIOName);
-  selectMuxAlternative();
-}
-
-/*!
- *   @fn         setPortMode
- *
- *   @brief      Seleciona o modo de operao de um pino.
- *
- *   Este seleciona o modo de operao (entrada ou sada) ao pino
- *   escolhido no construtor.
- *
- *   @param[in]  mode - modo de operao.
- *                      Os modos de operao disponveis so:
- *                      PortMode_t::Input para modo entrada e
- *                      PortMode_t::Output para modo sada.
- *
- *   @remarks    Sigla e pagina do Manual de Referencia KL25:
- *               - PDDR: Port Direct Input Register. Pg. 778.
- */
-void dsf_GPIO_ocp::setPortMode(PortMode_t::dsf_PortMode mode) {
-  if (mode == PortMode_t::Input) {
-    *addressPDDR &= ~pinPort;
-  } else {
-    *addressPDDR |= pinPort;
-  }
-}
-
-/*!
- *   @fn         setPullResistor
- *
- *   @brief      Ajusta resistor de pull.
- *
- *   Este mtodo define se o pino de entrada possui resistor de pull up
- *   ou nenhum resistor ligado internamente.
- *
- *   @param[in]  pullResistor - resistor de pull up ou nenhum.
- *               pullResistor pode ser ajustado como:
- *               PullResistor_t::PullUpResistor,para resistor de pull up.
- *               PullResistor_t::PullNoneResistor,para nenhum resistor de pull.
- *
- *   @remarks    Sigla e pagina do Manual de Referencia KL25:
- *               - PortxPCRn: Pin Control Register. Pg. 183 (Mux) and 185 (Pull).
- */
-void dsf_GPIO_ocp::setPullResistor(PullResistor_t::dsf_PullResistor pull) {
-  *addressPortxPCRn &= ~(PORT_PCR_PS_MASK | PORT_PCR_PE_MASK);
-  *addressPortxPCRn |= pull;
-}
-
-/*!
- *   @fn         writeBit
- *
- *   @brief      Escreve no pino de sada.
- *
- *   Este mtodo escreve o valor do bit do parmetro "bit" no pino da
- *   porta de sada.
- *
- *   @param[in]  bit - O valor do bit a ser escrito no pino da porta de sada.
- *
- *   @remarks    Siglas e pginas do Manual de Referncia KL25:
- *               - PDOR: Port Data Output Register. Pg. 775.
- */
-void dsf_GPIO_ocp::writeBit(int bit) {
-  if (bit) {
-    *addressPDOR |= pinPort;
-  } else {
-    *addressPDOR &= ~pinPort;
-  }
-}
-
-/*!
- *   @fn       readBit
- *
- *   @brief    L o pino de entrada.
- *
- *   Este mtodo l o valor do bit presente no pino da porta de entrada.
- *
- *	 @return   O valor do bit presente no pino da porta de entrada.
- *
- *   @remarks  Siglas e pginas do Manual de Referncia KL25:
- *             - PDIR: Port Data Input Register. Pg. 777.
- */
-int dsf_GPIO_ocp::readBit() {
-  if (*addressPDIR & pinPort) {
-    return 1;
-  }
-  return 0;
-}
-
-/*!
- *   @fn       toogleBit
- *
- *   @brief    Altera o bit de sada para o seu complemento.
- *
- *   Este mtodo altera o bit de sada para o seu complemento, i.e.,
- *   se o bit atual  '0', muda para '1' e vice-versa.
- *
- *   @remarks  Siglas e pginas do Manual de Referncia KL25:
- *             - PTOR: Port Toogle Output Register.Pg.777.
- */
-void dsf_GPIO_ocp::toogleBit() {
-  *addressPTOR |= pinPort;
-}
-
-/*!
- *   @fn       bindPeripheral
- *
- *   @brief    Associa o objeto de software ao perifrico de hardware.
- *
- *   Este mtodo associa os ponteiros aos seus respectivos registradores.
- *
- *   @remarks  Siglas e pginas do Manual de Referncia KL25:
- *             - PDOR: Port Data Output Register.Pg. 775.
- *             - PDIR: Port Data Input Register.Pg. 777.
- *             - PDDR: Port Direct Input Register. Pg. 778.
- *             - PTOR: Port Toogle Output Register.Pg.777.
- *             - PortxPCRn: Pin Control Register.Pg. 183 (Mux) and 185 (Pull).
- */
-void dsf_GPIO_ocp::bindPeripheral(uint8_t GPIONumber, uint8_t pinNumber) {
-  uint32_t baseAddress;
-
-  /*!
-   * Clculo do endereo base do GPIO do parmetro "GPIOBaseAddress".
-   * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
-   * GPIOBaseAddress = 0x400FF000 (Base GPIOA) + 0x40*(0,1,2,3 ou 4) (Offset).
-   *
-   */
-  baseAddress = GPIOA_BASE + (uint32_t)(0x40*GPIONumber);
-
-  /*!
-   * Clculo do endereo absoluto do PDOR para o GPIO.
-   * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
-   * addressPDOR = address base (Base) + 0x00 (Offset).
-   */
-  addressPDOR = (volatile uint32_t *)(baseAddress + 0x0);
-
-  /*!
-   * Clculo do endereo absoluto do PDIR para o GPIO.
-    * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
-   * addressPDIR = address base (Base) + 0x10 (Offset).
-   */
-  addressPDIR = (volatile uint32_t *)(baseAddress + 0x10);
-
-  /*!
-   * Clculo do endereo absoluto do PDDR para o GPIO.
-    * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
-   * addressPDDR = address base (Base) + 0x14 (Offset).
-   */
-  addressPDDR = (volatile uint32_t *)(baseAddress + 0x14);
-
-  /*!
-   * Clculo do endereo absoluto do PTOR para o GPIO.
-   * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
-   * addressPTOR = address base (Base) + 0xC (Offset).
-   */
-  addressPTOR = (volatile uint32_t *)(baseAddress + 0xC);
-
-  /*!
-   * Clculo do endereo absoluto do PCR para o GPIO.
-   * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
-   * addressPortxPCRn = 0x40049000 (Base) + 0x1000*(0,1,2,3,4 ou 5)
-   *                    + 4*(0,1,2,3,4,...,30) (Offset).
-   */
-  addressPortxPCRn = (volatile uint32_t *)(0x40049000
-                       + 0x1000*GPIONumber
-                       + 4*pinNumber);
-}
-
-/*!
- *   @fn       enablePeripheralClock
- *
- *   @brief    Habilita o clock do GPIO do perifrico.
- *
- *   Este mtodo habilita o clock do GPIO selecionado atravs do registrador
- *   SIM_SCGC5.
- *
- *   @remarks  Siglas e pginas do Manual de Referncia KL25:
- *             - SIM_SCGC5:System Clock Gating Control Register.Pg. 206.
- */
-void dsf_GPIO_ocp::enableModuleClock(uint8_t GPIONumber) {
-  SIM_SCGC5 |= SIM_SCGC5_PORTA_MASK << GPIONumber;
-}
-
-/*!
- *   @fn       selectMuxAlternative
- *
- *   @brief    Seleciona o modo GPIO de operao do pino.
- *
- *   Este mtodo seleciona o modo de operao do pino atravs do registrador
- *   Portx_PCRn, utilizando a macro de configurao PORT_PCR_MUX(x), disponvel
- *   no arquivo MKL25Z4.h
- *
- *   @remarks  Siglas e pginas do Manual de Referncia KL25:
- *             - PortxPCRn: Pin Control Register.Pg. 183 (Mux) and 185 (Pull).
- */
-void dsf_GPIO_ocp::selectMuxAlternative() {
-  *addressPortxPCRn = PORT_PCR_MUX(1);
-}
+/*!
+ * @copyright   © 2017 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Interface de programação de aplicações em C++ para GPIO.
+ *
+ * @file        dsf_GPIO_ocp.cpp
+ * @version     1.0
+ * @date        30 Julho 2017
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   GPIO.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (6 Julho 2017): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *              +student      Versão inicial:
+ *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include <MKL25Z4.h>
+#include "dsf_GPIO_ocp.h"
+#include "dsf_BME_ocp.h"
+
+/*!
+ *   @fn       dsf_GPIO_ocp
+ *
+ *   @brief    Método construtor da classe.
+ *
+ *   Este é o método construtor padrão da classe e realiza a associação
+ *   entre o objeto de software e o periférico de hardware, bem como a
+ *   habilitação do clock do periférico e dos registradores a ele associados.
+ *
+ *   @param[in]  GPIOName - GPIO;
+ *               pin - pino do GPIO selecionado.
+ *
+ *   @remarks  Siglas e páginas do Manual de Referência KL25:
+ *             - PDOR: Port Data Output Register.Pág. 775.
+ *             - PDIR: Port Data Input Register.Pág. 777.
+ *             - PDDR: Port Direct Input Register. Pág. 778.
+ *             - PTOR: Port Toogle Output Register.Pág.777.
+ *             - PortxPCRn: Pin Control Register.Pág. 183 (Mux) and 185 (Pull).
+ */
+
+uint32_t dsf_GPIO_ocp::mismatches;
+
+dsf_GPIO_ocp::dsf_GPIO_ocp(GPIO_t::dsf_GPIO GPIOName, GPIO_t::dsf_Pin pin) {
+  pinPort = 1 << pin;
+  edges = 0;
+  bindPeripheral(GPIOName, pin);
+  enableModuleClock(GPIOName);
+  selectMuxAlternative();
+}
+
+/*!
+ *   @fn       ~dsf_GPIO_ocp
+ *
+ *   @brief    Método destrutor da classe.
+ *
+ *   Este método libera o clock do GPIO associado ao objeto, que é
+ *   desligado quando nenhum outro objeto o utiliza.
+ */
+dsf_GPIO_ocp::~dsf_GPIO_ocp() {
+  disableModuleClock();
+}
+
+/*!
+ *   @fn         setPortMode
+ *
+ *   @brief      Seleciona o modo de operação de um pino.
+ *
+ *   Este seleciona o modo de operação (entrada ou saída) ao pino
+ *   escolhido no construtor. O bit do PDDR é alterado por uma escrita
+ *   decorada do BME, que não perde as mudanças feitas por interrupções nos
+ *   outros pinos da porta.
+ *
+ *   @param[in]  mode - modo de operação.
+ *                      Os modos de operação disponíveis são:
+ *                      PortMode_t::Input para modo entrada e
+ *                      PortMode_t::Output para modo saída.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - PDDR: Port Direct Input Register. Pág. 778.
+ */
+void dsf_GPIO_ocp::setPortMode(PortMode_t::dsf_PortMode mode) {
+  if (mode == PortMode_t::Input) {
+    dsf_BME_ocp::clearBits(addressPDDR, pinPort);
+  } else {
+    dsf_BME_ocp::setBits(addressPDDR, pinPort);
+  }
+}
+
+/*!
+ *   @fn         setPullResistor
+ *
+ *   @brief      Ajusta resistor de pull.
+ *
+ *   Este método define se o pino de entrada possui resistor de pull up
+ *   ou nenhum resistor ligado internamente.
+ *
+ *   @param[in]  pullResistor - resistor de pull up ou nenhum.
+ *               pullResistor pode ser ajustado como:
+ *               PullResistor_t::PullUpResistor,para resistor de pull up.
+ *               PullResistor_t::PullNoneResistor,para nenhum resistor de pull.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - PortxPCRn: Pin Control Register. Pág. 183 (Mux) and 185 (Pull).
+ */
+void dsf_GPIO_ocp::setPullResistor(PullResistor_t::dsf_PullResistor pull) {
+  /*!
+   * PS e PE (bits 0 e 1) com o restante do PCR da cópia de sombra. Sem a
+   * ISF na escrita, uma interrupção pendente do pino não é perdida.
+   */
+  writePCR((shadowPCR & ~(PORT_PCR_PS_MASK | PORT_PCR_PE_MASK)) | pull);
+}
+
+/*!
+ *   @fn         writeBit
+ *
+ *   @brief      Escreve no pino de saída.
+ *
+ *   Este método escreve o valor do bit do parâmetro "bit" no pino da
+ *   porta de saída.
+ *
+ *   @param[in]  bit - O valor do bit a ser escrito no pino da porta de saída.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - PDOR: Port Data Output Register. Pág. 775.
+ */
+void dsf_GPIO_ocp::writeBit(int bit) {
+  if (bit) {
+    dsf_BME_ocp::setBits(addressPDOR, pinPort);
+  } else {
+    dsf_BME_ocp::clearBits(addressPDOR, pinPort);
+  }
+}
+
+/*!
+ *   @fn       readBit
+ *
+ *   @brief    Lê o pino de entrada.
+ *
+ *   Este método lê o valor do bit presente no pino da porta de entrada.
+ *
+ *	 @return   O valor do bit presente no pino da porta de entrada.
+ *
+ *   @remarks  Siglas e páginas do Manual de Referência KL25:
+ *             - PDIR: Port Data Input Register. Pág. 777.
+ */
+int dsf_GPIO_ocp::readBit() {
+  if (*addressPDIR & pinPort) {
+    return 1;
+  }
+  return 0;
+}
+
+/*!
+ *   @fn       setInterrupt
+ *
+ *   @brief    Seleciona a borda que gera a interrupção do pino.
+ *
+ *   Este método programa o campo IRQC do pino, descarta uma flag ISF
+ *   antiga e habilita a interrupção do PORT no NVIC. A interrupção do NVIC
+ *   não é desabilitada com dsf_IrqDisabled, pois é compartilhada pelos
+ *   demais pinos do PORT. Pinos de PORTB, PORTC e PORTE são ignorados.
+ *
+ *   @param[in]  mode - borda de interrupção (PortIrq_t).
+ *
+ *   @remarks  Siglas e páginas do Manual de Referência KL25:
+ *             - PortxPCRn: Pin Control Register. Pág. 183 (IRQC e ISF).
+ */
+void dsf_GPIO_ocp::setInterrupt(PortIrq_t::dsf_PortIrq mode) {
+  IRQn_Type irq;
+
+  if (moduleGate == ClockGate_t::dsf_PORTA) {
+    irq = PORTA_IRQn;
+  } else if (moduleGate == ClockGate_t::dsf_PORTD) {
+    irq = PORTD_IRQn;
+  } else {
+    return;
+  }
+  /*!
+   * O IRQC novo e a ISF (write-1-to-clear), que descarta a flag antiga,
+   * em uma só escrita.
+   */
+  writePCR((shadowPCR & ~PORT_PCR_IRQC_MASK) | PORT_PCR_IRQC(mode)
+           | PORT_PCR_ISF_MASK);
+  if (mode != PortIrq_t::dsf_IrqDisabled) {
+    NVIC_ClearPendingIRQ(irq);
+    NVIC_EnableIRQ(irq);
+  }
+}
+
+/*!
+ *   @fn       edgeCount
+ *
+ *   @brief    Informa o número de bordas tratadas pela interrupção.
+ */
+uint32_t dsf_GPIO_ocp::edgeCount() {
+  return edges;
+}
+
+/*!
+ *   @fn       toogleBit
+ *
+ *   @brief    Altera o bit de saída para o seu complemento.
+ *
+ *   Este método altera o bit de saída para o seu complemento, i.e.,
+ *   se o bit atual é '0', muda para '1' e vice-versa.
+ *
+ *   @remarks  Siglas e páginas do Manual de Referência KL25:
+ *             - PTOR: Port Toogle Output Register.Pág.777.
+ */
+void dsf_GPIO_ocp::toogleBit() {
+  *addressPTOR = pinPort;
+}
+
+/*!
+ *   @fn       bindPeripheral
+ *
+ *   @brief    Associa o objeto de software ao periférico de hardware.
+ *
+ *   Este método associa os ponteiros aos seus respectivos registradores.
+ *
+ *   @remarks  Siglas e páginas do Manual de Referência KL25:
+ *             - PDOR: Port Data Output Register.Pág. 775.
+ *             - PDIR: Port Data Input Register.Pág. 777.
+ *             - PDDR: Port Direct Input Register. Pág. 778.
+ *             - PTOR: Port Toogle Output Register.Pág.777.
+ *             - PortxPCRn: Pin Control Register.Pág. 183 (Mux) and 185 (Pull).
+ */
+void dsf_GPIO_ocp::bindPeripheral(uint8_t GPIONumber, uint8_t pinNumber) {
+  uint32_t baseAddress;
+
+  /*!
+   * Cálculo do endereço base do GPIO do parâmetro "GPIOBaseAddress".
+   * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
+   * GPIOBaseAddress = 0x400FF000 (Base GPIOA) + 0x40*(0,1,2,3 ou 4) (Offset).
+   *
+   */
+  baseAddress = GPIOA_BASE + (uint32_t)(0x40*GPIONumber);
+
+  /*!
+   * Cálculo do endereço absoluto do PDOR para o GPIO.
+   * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
+   * addressPDOR = address base (Base) + 0x00 (Offset).
+   */
+  addressPDOR = (volatile uint32_t *)(baseAddress + 0x0);
+
+  /*!
+   * Cálculo do endereço absoluto do PDIR para o GPIO.
+    * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
+   * addressPDIR = address base (Base) + 0x10 (Offset).
+   */
+  addressPDIR = (volatile uint32_t *)(baseAddress + 0x10);
+
+  /*!
+   * Cálculo do endereço absoluto do PDDR para o GPIO.
+    * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
+   * addressPDDR = address base (Base) + 0x14 (Offset).
+   */
+  addressPDDR = (volatile uint32_t *)(baseAddress + 0x14);
+
+  /*!
+   * Cálculo do endereço absoluto do PTOR para o GPIO.
+   * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
+   * addressPTOR = address base (Base) + 0xC (Offset).
+   */
+  addressPTOR = (volatile uint32_t *)(baseAddress + 0xC);
+
+  /*!
+   * Cálculo do endereço absoluto do PCR para o GPIO.
+   * Address(hexa): GPIOA=400FF014 B=400FF054 C=400FF094 D=400FF0D4 E=400FF114.
+   * addressPortxPCRn = 0x40049000 (Base) + 0x1000*(0,1,2,3,4 ou 5)
+   *                    + 4*(0,1,2,3,4,...,30) (Offset).
+   */
+  addressPortxPCRn = (volatile uint32_t *)(0x40049000
+                       + 0x1000*GPIONumber
+                       + 4*pinNumber);
+}
+
+/*!
+ *   @fn       enablePeripheralClock
+ *
+ *   @brief    Habilita o clock do GPIO do periférico.
+ *
+ *   Este método adquire o clock do GPIO selecionado no gerenciador
+ *   dsf_ClockGate_ocp, que o liga no registrador SIM_SCGC5.
+ *
+ *   @remarks  Siglas e páginas do Manual de Referência KL25:
+ *             - SIM_SCGC5:System Clock Gating Control Register.Pág. 206.
+ */
+void dsf_GPIO_ocp::enableModuleClock(uint8_t GPIONumber) {
+  moduleGate = (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA + GPIONumber);
+  dsf_ClockGate_ocp::acquire(moduleGate);
+}
+
+/*!
+ *   @fn       disableModuleClock
+ *
+ *   @brief    Libera o clock do GPIO do periférico.
+ *
+ *   Este método libera o clock do GPIO no gerenciador dsf_ClockGate_ocp,
+ *   que o desliga no registrador SIM_SCGC5 quando não há outros usuários.
+ *
+ *   @remarks  Siglas e páginas do Manual de Referência KL25:
+ *             - SIM_SCGC5:System Clock Gating Control Register.Pág. 206.
+ */
+void dsf_GPIO_ocp::disableModuleClock() {
+  dsf_ClockGate_ocp::release(moduleGate);
+}
+
+/*!
+ *   @fn       selectMuxAlternative
+ *
+ *   @brief    Seleciona o modo GPIO de operação do pino.
+ *
+ *   Este método seleciona o modo de operação do pino através do registrador
+ *   Portx_PCRn, utilizando a macro de configuração PORT_PCR_MUX(x), disponível
+ *   no arquivo MKL25Z4.h
+ *
+ *   @remarks  Siglas e páginas do Manual de Referência KL25:
+ *             - PortxPCRn: Pin Control Register.Pág. 183 (Mux) and 185 (Pull).
+ */
+void dsf_GPIO_ocp::selectMuxAlternative() {
+  shadowPCR = PORT_PCR_MUX(1);
+  *addressPortxPCRn = shadowPCR;
+}
+
+/*!
+ *   @fn       writePCR
+ *
+ *   @brief    Escreve o PCR do pino e atualiza a cópia de sombra.
+ *
+ *   Com -DDSF_SHADOW_CHECK, o IRQC, o MUX, o PE e o PS lidos do hardware
+ *   são conferidos antes com a cópia; uma divergência é contada e a
+ *   cópia adota o valor lido, antes de aplicar a mudança pedida.
+ *
+ *   @param[in]  value - o novo valor do PCR, com a ISF para limpá-la.
+ */
+void dsf_GPIO_ocp::writePCR(uint32_t value) {
+#ifdef DSF_SHADOW_CHECK
+  const uint32_t kFields = PORT_PCR_IRQC_MASK | PORT_PCR_MUX_MASK
+                           | PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;
+  uint32_t actual = *addressPortxPCRn & kFields;
+  uint32_t changed = (shadowPCR ^ value) & kFields;
+
+  if (actual != (shadowPCR & kFields)) {
+    mismatches++;
+    value = (value & ~kFields) | (actual & ~changed) | (value & changed);
+  }
+#endif
+  *addressPortxPCRn = value;
+  shadowPCR = value & ~PORT_PCR_ISF_MASK;
+}
+
+/*!
+ *   @fn       shadowMismatches
+ *
+ *   @brief    Informa as divergências do PCR encontradas pelos objetos.
+ *
+ *   @return   O número de divergências; sempre 0 sem -DDSF_SHADOW_CHECK.
+ */
+uint32_t dsf_GPIO_ocp::shadowMismatches() {
+  return mismatches;
+}
@@ -0,0 +1,223 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Ligação das interrupções do vetor aos objetos dos drivers.
+ *
+ * @file        dsf_Irq_ocp.cpp
+ * @version     1.0
+ * @date        27 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   NVIC, SysTick e TPM (auditoria).
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (27 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_Irq_ocp.h"
+#include "dsf_Text_ocp.h"
+
+dsf_IrqStats dsf_IrqAudit_ocp::audit[Irq_t::dsf_NumIrqs];
+uint32_t dsf_IrqAudit_ocp::enteredAt[Irq_t::dsf_NumIrqs];
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Zera a auditoria e inicia o SysTick em contagem livre.
+ *
+ *   @remarks    Siglas e páginas do ARMv6-M Architecture Reference Manual:
+ *               - SYST_CSR, SYST_RVR, SYST_CVR: SysTick. B3.3.
+ */
+void dsf_IrqAudit_ocp::start() {
+  reset();
+  SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+/*!
+ *   @fn         reset
+ *
+ *   @brief      Zera os contadores de todas as linhas.
+ */
+void dsf_IrqAudit_ocp::reset() {
+  for (uint8_t i = 0; i < Irq_t::dsf_NumIrqs; i++) {
+    audit[i].entries = 0;
+    audit[i].measured = 0;
+    audit[i].minEntry = 0;
+    audit[i].maxEntry = 0;
+    audit[i].sumEntry = 0;
+    audit[i].maxHandler = 0;
+    audit[i].sumHandler = 0;
+  }
+}
+
+/*!
+ *   @fn         enter
+ *
+ *   @brief      Registra a entrada no tratador de uma linha.
+ *
+ *   O TPM é lido antes de qualquer outra coisa, para que a medição inclua
+ *   só o prólogo do tratador. O carimbo do SysTick é tomado por último,
+ *   para que a duração não inclua a própria auditoria.
+ */
+void dsf_IrqAudit_ocp::enter(IRQn_Type irq) {
+  dsf_IrqStats &entry = audit[irq];
+  uint32_t cycles;
+
+  if (irq >= TPM0_IRQn && irq <= TPM2_IRQn
+      && entryCycles((uint8_t)(irq - TPM0_IRQn), &cycles)) {
+    if (!entry.measured || cycles < entry.minEntry) {
+      entry.minEntry = cycles;
+    }
+    entry.measured++;
+    entry.sumEntry += cycles;
+    if (cycles > entry.maxEntry) {
+      entry.maxEntry = cycles;
+    }
+  }
+  entry.entries++;
+  enteredAt[irq] = SysTick->VAL;
+}
+
+/*!
+ *   @fn         leave
+ *
+ *   @brief      Registra a saída do tratador de uma linha.
+ *
+ *   O SysTick conta para baixo em 24 bits: a duração é a diferença entre
+ *   os carimbos de entrada e de saída, módulo 2^24.
+ */
+void dsf_IrqAudit_ocp::leave(IRQn_Type irq) {
+  dsf_IrqStats &entry = audit[irq];
+  uint32_t cycles = (enteredAt[irq] - SysTick->VAL) & SysTick_VAL_CURRENT_Msk;
+
+  entry.sumHandler += cycles;
+  if (cycles > entry.maxHandler) {
+    entry.maxHandler = cycles;
+  }
+}
+
+/*!
+ *   @fn         getStats
+ *
+ *   @brief      Copia o resumo da auditoria de uma linha.
+ *
+ *   @param[in]  irq - linha de interrupção.
+ *   @param[out] stats - resumo; os campos de entrada valem 0 se nenhuma
+ *                       entrada foi medida.
+ */
+void dsf_IrqAudit_ocp::getStats(IRQn_Type irq, dsf_IrqStats *stats) {
+  *stats = audit[irq];
+}
+
+/*!
+ *   @fn         dump
+ *
+ *   @brief      Escreve uma linha por interrupção tratada, em ciclos.
+ *
+ *   Formato: "irq=18 entries=412 entry_min=40 entry_mean=52 entry_max=310
+ *   handler_mean=230 handler_max=1250"; os campos entry_* só aparecem para
+ *   as linhas medidas.
+ *
+ *   @param[in]  putChar - função de saída de um caractere.
+ */
+void dsf_IrqAudit_ocp::dump(void (*putChar)(char)) {
+  for (uint8_t i = 0; i < Irq_t::dsf_NumIrqs; i++) {
+    const dsf_IrqStats &entry = audit[i];
+
+    if (!entry.entries) {
+      continue;
+    }
+    dsf_putText(putChar, "irq=");
+    dsf_putNumber(putChar, i);
+    dsf_putText(putChar, " entries=");
+    dsf_putNumber(putChar, entry.entries);
+    if (entry.measured) {
+      dsf_putText(putChar, " entry_min=");
+      dsf_putNumber(putChar, entry.minEntry);
+      dsf_putText(putChar, " entry_mean=");
+      dsf_putNumber(putChar, (uint32_t)(entry.sumEntry/entry.measured));
+      dsf_putText(putChar, " entry_max=");
+      dsf_putNumber(putChar, entry.maxEntry);
+    }
+    dsf_putText(putChar, " handler_mean=");
+    dsf_putNumber(putChar, (uint32_t)(entry.sumHandler/entry.entries));
+    dsf_putText(putChar, " handler_max=");
+    dsf_putNumber(putChar, entry.maxHandler);
+    putChar('\n');
+  }
+}
+
+/*!
+ *   @fn         entryCycles
+ *
+ *   @brief      Mede os ciclos desde o pedido mais antigo de um TPM.
+ *
+ *   Para cada origem com a flag e a habilitação ligadas, o tempo decorrido
+ *   é CNT - instante do pedido, módulo MOD + 1: o overflow ocorre em
+ *   CNT = 0 e o evento de um canal em CnV (captura ou comparação).
+ *
+ *   @param[in]  TPMNumber - TPM da interrupção.
+ *   @param[out] cycles - ciclos do núcleo desde o pedido.
+ *
+ *   @return     false se nenhuma origem pendente foi encontrada.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ *               - TPMxCNT, TPMxMOD: Counter e Modulo. Págs. 554 e 555.
+ *               - TPMxCnSC, TPMxCnV: Channel Status Control e Value.
+ *                 Págs. 556 e 558.
+ */
+bool dsf_IrqAudit_ocp::entryCycles(uint8_t TPMNumber, uint32_t *cycles) {
+  uint32_t baseAddress = TPM0_BASE + 0x1000*TPMNumber;
+  uint32_t count = *(volatile uint32_t *)(baseAddress + 0x04);
+  uint32_t status = *(volatile uint32_t *)(baseAddress + 0x00);
+  uint32_t period = (*(volatile uint32_t *)(baseAddress + 0x08) & 0xFFFF) + 1;
+  uint32_t control, value, elapsed;
+  bool found = false;
+
+  *cycles = 0;
+  if ((status & 0xC0) == 0xC0) {
+    *cycles = count;
+    found = true;
+  }
+  for (uint8_t channel = 0; channel < 6; channel++) {
+    control = *(volatile uint32_t *)(baseAddress + 0x0C + 8*channel);
+    if ((control & 0xC0) != 0xC0) {
+      continue;
+    }
+    value = *(volatile uint32_t *)(baseAddress + 0x10 + 8*channel) & 0xFFFF;
+    elapsed = (count >= value) ? count - value : count + period - value;
+    if (elapsed > *cycles) {
+      *cycles = elapsed;
+    }
+    found = true;
+  }
+  *cycles <<= status & 7;
+  return found;
+}
@@ -0,0 +1,204 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Ligação das interrupções do vetor aos objetos dos drivers.
+ *
+ * @file        dsf_Irq_ocp.h
+ * @version     1.0
+ * @date        27 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   NVIC, SysTick e TPM (auditoria).
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (27 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_IRQ_OCP_H_
+#define DSF_IRQ_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#ifdef DSF_LOAD_METER
+#include "dsf_LoadMeter_ocp.h"
+#endif
+
+/*!
+ * Namespace de definição do número de linhas de interrupção do NVIC.
+ */
+namespace Irq_t {
+  enum dsf_IrqLimits {
+    dsf_NumIrqs = 32
+  };
+}  // namespace Irq_t
+
+/*!
+ *   @fn         dsf_irqDispatch
+ *
+ *   @brief      Chama o irqHandler de cada objeto ligado a um vetor.
+ *
+ *   A lista de objetos é resolvida em tempo de compilação: como os objetos
+ *   são globais, o endereço de cada um é uma constante e cada chamada é
+ *   direta (ou expandida no tratador, se irqHandler estiver no header),
+ *   sem ponteiro de função nem método virtual.
+ */
+__attribute__((always_inline)) inline void dsf_irqDispatch() {
+}
+
+template <typename Driver, typename... Drivers>
+__attribute__((always_inline)) inline void dsf_irqDispatch(
+    Driver &object, Drivers &... others) {
+  object.irqHandler();
+  dsf_irqDispatch(others...);
+}
+
+/*!
+ *  @struct   dsf_IrqStats
+ *
+ *  @brief    Resumo da auditoria de uma linha de interrupção, em ciclos.
+ *
+ *  @details  entry é o tempo entre o pedido do periférico e a primeira
+ *            leitura do tratador (só medido para os TPMs: measured conta as
+ *            entradas medidas); handler é o tempo dentro do tratador,
+ *            incluindo interrupções aninhadas de maior prioridade.
+ */
+struct dsf_IrqStats {
+  uint32_t entries;
+  uint32_t measured;
+  uint32_t minEntry;
+  uint32_t maxEntry;
+  uint64_t sumEntry;
+  uint32_t maxHandler;
+  uint64_t sumHandler;
+};
+
+/*!
+ *  @class    dsf_IrqAudit_ocp
+ *
+ *  @brief    Auditoria dos ciclos de entrada e de execução das interrupções.
+ *
+ *  @details  Só é usada pelos tratadores gerados com DSF_IRQ_BIND quando o
+ *            firmware é compilado com -DDSF_IRQ_AUDIT; sem a macro, os
+ *            tratadores não têm nenhuma instrução além das chamadas.
+ *
+ *            Na entrada de um TPM, o CNT é comparado com o instante do
+ *            pedido: zero para o overflow (TOF) e CnV para um canal (CHF);
+ *            vale o pedido mais antigo. A diferença, multiplicada pelo
+ *            prescaler, está em ciclos do núcleo, pois em todos os perfis
+ *            do dsf_MCG_ocp o TPM conta no relógio do núcleo, com
+ *            resolução de um tick. Para as demais linhas (PORTA, PORTD...)
+ *            não há carimbo do pedido e só o número de entradas e a
+ *            duração são registrados.
+ *
+ *            A duração é medida pelo SysTick em contagem livre com o
+ *            relógio do núcleo, iniciado por start; trechos de até 0,8 s.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Build com -DDSF_IRQ_AUDIT.
+ *             +fn DSF_IRQ_BIND(TPM1, latency)
+ *             +fn dsf_IrqAudit_ocp::start();
+ *             +fn dsf_IrqAudit_ocp::dump(putChar);
+ */
+class dsf_IrqAudit_ocp {
+ public:
+  /*!
+   * Métodos de controle da auditoria.
+   */
+  static void start();
+  static void reset();
+
+  /*!
+   * Métodos chamados pelos tratadores gerados com DSF_IRQ_BIND.
+   */
+  static void enter(IRQn_Type irq);
+  static void leave(IRQn_Type irq);
+
+  /*!
+   * Métodos de consulta e de descarga.
+   */
+  static void getStats(IRQn_Type irq, dsf_IrqStats *stats);
+  static void dump(void (*putChar)(char));
+
+ private:
+  static dsf_IrqStats audit[Irq_t::dsf_NumIrqs];
+  static uint32_t enteredAt[Irq_t::dsf_NumIrqs];
+
+  static bool entryCycles(uint8_t TPMNumber, uint32_t *cycles);
+};
+
+/*!
+ *  @def      DSF_IRQ_BIND
+ *
+ *  @brief    Gera o tratador do vetor de interrupções para um ou mais objetos.
+ *
+ *  @details  O primeiro argumento é o nome do vetor sem o sufixo
+ *            (TPM0, TPM1, PORTA...); os demais são objetos globais com um
+ *            método irqHandler(). Um vetor ligado duas vezes é um erro de
+ *            link e um nome de vetor inexistente é um erro de compilação
+ *            em qualquer build (o static_assert usa o IRQn correspondente,
+ *            que não existe).
+ *
+ *            Com -DDSF_IRQ_AUDIT o tratador alimenta dsf_IrqAudit_ocp e com
+ *            -DDSF_LOAD_METER conta o próprio tempo como dsf_Interrupt no
+ *            dsf_LoadMeter_ocp; sem as macros só as chamadas são geradas.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Relógio no TPM0 e dois pinos do PORTA.
+ *             +fn DSF_IRQ_BIND(TPM0, sysClock)
+ *             +fn DSF_IRQ_BIND(PORTA, key, sensor)
+ */
+#ifdef DSF_IRQ_AUDIT
+#define DSF_IRQ_AUDIT_ENTER(irq) dsf_IrqAudit_ocp::enter(irq);
+#define DSF_IRQ_AUDIT_LEAVE(irq) dsf_IrqAudit_ocp::leave(irq);
+#else
+#define DSF_IRQ_AUDIT_ENTER(irq)
+#define DSF_IRQ_AUDIT_LEAVE(irq)
+#endif
+
+#ifdef DSF_LOAD_METER
+#define DSF_IRQ_LOAD_ENTER()                                                 \
+  uint8_t loadPrevious =                                                     \
+      dsf_LoadMeter_ocp::enter(LoadMeter_t::dsf_Interrupt);
+#define DSF_IRQ_LOAD_LEAVE() dsf_LoadMeter_ocp::leave(loadPrevious);
+#else
+#define DSF_IRQ_LOAD_ENTER()
+#define DSF_IRQ_LOAD_LEAVE()
+#endif
+
+#define DSF_IRQ_BIND(vector, ...)                                            \
+  static_assert((int)vector##_IRQn >= 0, "vetor inexistente");              \
+  extern "C" void vector##_IRQHandler(void) {                                \
+    DSF_IRQ_AUDIT_ENTER(vector##_IRQn)                                       \
+    DSF_IRQ_LOAD_ENTER()                                                     \
+    dsf_irqDispatch(__VA_ARGS__);                                            \
+    DSF_IRQ_LOAD_LEAVE()                                                     \
+    DSF_IRQ_AUDIT_LEAVE(vector##_IRQn)                                       \
+  }
+
+#endif  //  DSF_IRQ_OCP_H_
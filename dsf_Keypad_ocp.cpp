@@ -0,0 +1,324 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para teclado matricial com varredura por TPM.
+ *
+ * @file        dsf_Keypad_ocp.cpp
+ * @version     1.0
+ * @date        21 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   FGPIO, PORT e TPM.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (21 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_Keypad_ocp.h"
+#include "dsf_BME_ocp.h"
+
+/*!
+ *   @fn         dsf_Keypad_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método associa o objeto aos GPIOs das linhas e das colunas e ao
+ *   TPM de varredura, configura as linhas como entradas com o PDOR em
+ *   nível baixo e as colunas como entradas com pull up.
+ *
+ *   @param[in]  rowGPIO - GPIO das linhas.
+ *               rowPins - pinos das linhas.
+ *               rows - número de linhas, até Keypad_t::dsf_MaxRows; 0
+ *               resulta em um teclado sem teclas.
+ *               columnGPIO - GPIO das colunas.
+ *               columnPins - pinos das colunas.
+ *               columns - número de colunas, até Keypad_t::dsf_MaxColumns;
+ *               0 resulta em um teclado sem teclas.
+ *               tpm - TPM usado para disparar as varreduras.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - FGPIO: Fast GPIO (IOPORT). Pág. 771.
+ *               - PortxPCRn: Pin Control Register. Pág. 183.
+ */
+dsf_Keypad_ocp::dsf_Keypad_ocp(GPIO_t::dsf_GPIO rowGPIO,
+                               const GPIO_t::dsf_Pin *rowPins, uint8_t rows,
+                               GPIO_t::dsf_GPIO columnGPIO,
+                               const GPIO_t::dsf_Pin *columnPins,
+                               uint8_t columns, TPM_t::TPMNumber_t tpm) {
+  uint32_t rowBase = 0xF80FF000 + 0x40*rowGPIO;
+  uint32_t columnBase = 0xF80FF000 + 0x40*columnGPIO;
+  uint32_t allRows = 0;
+  volatile uint32_t *addressPCR;
+
+  bindPeripheral((uint8_t *)(TPM0_BASE + 0x1000*tpm));
+  TPMNumber = tpm;
+  freqDiv = TPMDiv_t::Div1;
+  scanNumber = 0;
+  scanTicks = 0;
+
+  rowCount = rows < Keypad_t::dsf_MaxRows ?
+             rows : (uint8_t)Keypad_t::dsf_MaxRows;
+  columnCount = columns < Keypad_t::dsf_MaxColumns ?
+                columns : (uint8_t)Keypad_t::dsf_MaxColumns;
+  /*!
+   * Sem linhas ou sem colunas o teclado não tem teclas: nenhuma linha é
+   * varrida e isPressed não divide por zero.
+   */
+  if (rowCount == 0 || columnCount == 0) {
+    rowCount = 0;
+    columnCount = 0;
+  }
+
+  /*!
+   * Registradores PCOR (0x08) e PDIR (0x10) do FGPIO e PDDR (0x14) do
+   * GPIO.
+   */
+  addressRowPDDR = (volatile uint32_t *)(GPIOA_BASE + 0x40*rowGPIO + 0x14);
+  addressColumnPDIR = (volatile uint32_t *)(columnBase + 0x10);
+
+  rowGate = (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA + rowGPIO);
+  columnGate = (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA + columnGPIO);
+  dsf_ClockGate_ocp::acquire(rowGate);
+  dsf_ClockGate_ocp::acquire(columnGate);
+
+  for (uint8_t r = 0; r < rowCount; r++) {
+    rowMask[r] = 1u << rowPins[r];
+    allRows |= rowMask[r];
+    keyState[r] = 0;
+    count0[r] = 0xFFFFFFFF;
+    count1[r] = 0xFFFFFFFF;
+    addressPCR = (volatile uint32_t *)(0x40049000 + 0x1000*rowGPIO
+                                       + 4*rowPins[r]);
+    *addressPCR = PORT_PCR_MUX(1) | PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;
+  }
+  columnMask = 0;
+  for (uint8_t c = 0; c < columnCount; c++) {
+    columnBit[c] = 1u << columnPins[c];
+    columnMask |= columnBit[c];
+    addressPCR = (volatile uint32_t *)(0x40049000 + 0x1000*columnGPIO
+                                       + 4*columnPins[c]);
+    *addressPCR = PORT_PCR_MUX(1) | PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;
+  }
+
+  /*!
+   * PDOR das linhas em nível baixo, com linhas e colunas entradas; uma
+   * linha só é saída enquanto selecionada. O PDDR é alterado pelo BME no
+   * endereço do GPIO, pois as escritas decoradas não alcançam o FGPIO.
+   * O pull up das linhas evita entradas flutuantes entre as varreduras.
+   */
+  *(volatile uint32_t *)(rowBase + 0x8) = allRows;
+  dsf_BME_ocp::clearBits(addressRowPDDR, allRows);
+  dsf_BME_ocp::clearBits((volatile uint32_t *)(GPIOA_BASE + 0x40*columnGPIO
+                                               + 0x14), columnMask);
+}
+
+/*!
+ *   @fn         ~dsf_Keypad_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ *
+ *   Este método para a varredura e libera os clocks dos GPIOs.
+ */
+dsf_Keypad_ocp::~dsf_Keypad_ocp() {
+  stop();
+  dsf_ClockGate_ocp::release(rowGate);
+  dsf_ClockGate_ocp::release(columnGate);
+}
+
+/*!
+ *   @fn         setFrequency
+ *
+ *   @brief      Ajusta o divisor de frequência do TPM de varredura.
+ *
+ *   @param[in]  divBase - constante de divisão do divisor de frequência.
+ */
+void dsf_Keypad_ocp::setFrequency(TPMDiv_t::TPMDiv divBase) {
+  freqDiv = divBase;
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Inicia a varredura periódica.
+ *
+ *   Este método configura o TPM para gerar uma interrupção de overflow a
+ *   cada "cycles" ciclos do relógio dividido, com a mesma relação entre
+ *   ciclos e tempo do dsf_Delay_ocp::startDelay.
+ *
+ *   @param[in]  cycles - período de varredura, em ciclos de relógio.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ */
+void dsf_Keypad_ocp::start(uint16_t cycles) {
+  enablePeripheralClock(TPMNumber);
+  /*!
+   * Limpa TOF (0x80), habilita a interrupção TOIE (0x40) e a contagem
+   * (0x08) com uma única escrita.
+   */
+  restartCounter(cycles, 0x80 | 0x40 | 0x08 | freqDiv);
+  NVIC_ClearPendingIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  NVIC_EnableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para a varredura periódica e libera o clock do TPM.
+ */
+void dsf_Keypad_ocp::stop() {
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  NVIC_DisableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  writeSC(0);
+  disablePeripheralClock();
+}
+
+/*!
+ *   @fn         irqHandler
+ *
+ *   @brief      Trata a interrupção de overflow do TPM.
+ *
+ *   Este método limpa a flag TOF, executa uma varredura e registra a
+ *   contagem do TPM ao seu término, que mede a latência da interrupção
+ *   somada ao tempo de varredura.
+ */
+void dsf_Keypad_ocp::irqHandler() {
+  uint16_t ticks;
+
+  clearOverflow();
+  scan();
+  ticks = (uint16_t)*addressTPMxCNT;
+  if (ticks > scanTicks) {
+    scanTicks = ticks;
+  }
+}
+
+/*!
+ *   @fn         scan
+ *
+ *   @brief      Varre todas as linhas do teclado.
+ *
+ *   Para cada linha, são feitas uma escrita decorada no PDDR, que a torna
+ *   saída em nível baixo, uma leitura de acomodação, uma leitura do PDIR
+ *   e outra escrita decorada, que a devolve à alta impedância. O debounce
+ *   usa contadores verticais: cada bit de count1:count0 forma um contador
+ *   de 2 bits por tecla, reiniciado quando a amostra coincide com o
+ *   estado filtrado, e o estado só muda quando o contador completa 4
+ *   amostras diferentes consecutivas.
+ */
+void dsf_Keypad_ocp::scan() {
+  uint32_t sample, changed;
+
+  for (uint8_t r = 0; r < rowCount; r++) {
+    dsf_BME_ocp::setBits(addressRowPDDR, rowMask[r]);
+    /*!
+     * Leitura de acomodação das colunas após a mudança da linha.
+     */
+    (void)*addressColumnPDIR;
+    sample = ~*addressColumnPDIR & columnMask;
+    dsf_BME_ocp::clearBits(addressRowPDDR, rowMask[r]);
+
+    changed = keyState[r] ^ sample;
+    count0[r] = ~(count0[r] & changed);
+    count1[r] = count0[r] ^ (count1[r] & changed);
+    changed &= count0[r] & count1[r];
+    if (changed) {
+      keyState[r] ^= changed;
+      emitChanges(r, changed);
+    }
+  }
+  scanNumber++;
+}
+
+/*!
+ *   @fn         emitChanges
+ *
+ *   @brief      Gera os eventos das teclas de uma linha que mudaram.
+ *
+ *   @param[in]  row - linha varrida.
+ *               changed - máscara das colunas que mudaram de estado.
+ */
+void dsf_Keypad_ocp::emitChanges(uint8_t row, uint32_t changed) {
+  dsf_Event event;
+
+  event.source = Event_t::dsf_SourceKeypad;
+  event.reserved = 0;
+  event.stamp = scanNumber;
+  for (uint8_t c = 0; c < columnCount; c++) {
+    if (changed & columnBit[c]) {
+      event.code = (uint8_t)(row*columnCount + c);
+      event.type = (keyState[row] & columnBit[c]) ?
+                   Event_t::dsf_Press : Event_t::dsf_Release;
+      queue.push(event);
+    }
+  }
+}
+
+/*!
+ *   @fn         events
+ *
+ *   @brief      Informa a fila de eventos do teclado.
+ *
+ *   @return     A fila de eventos, a ser consumida no laço principal.
+ */
+dsf_InputQueue_ocp &dsf_Keypad_ocp::events() {
+  return queue;
+}
+
+/*!
+ *   @fn         isPressed
+ *
+ *   @brief      Informa o estado filtrado de uma tecla.
+ *
+ *   @param[in]  code - código da tecla, linha*colunas + coluna.
+ *
+ *   @return     1 se a tecla está pressionada e 0 caso contrário.
+ */
+int dsf_Keypad_ocp::isPressed(uint8_t code) {
+  uint8_t row, column;
+
+  if (code >= rowCount*columnCount) {
+    return 0;
+  }
+  row = code / columnCount;
+  column = code - row*columnCount;
+  return (keyState[row] & columnBit[column]) ? 1 : 0;
+}
+
+/*!
+ *   @fn         maxScanTicks
+ *
+ *   @brief      Informa a maior duração observada de uma varredura.
+ *
+ *   @return     A maior contagem do TPM ao final de uma varredura, que inclui
+ *               a latência de entrada na interrupção.
+ */
+uint16_t dsf_Keypad_ocp::maxScanTicks() {
+  return scanTicks;
+}
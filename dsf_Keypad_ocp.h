@@ -0,0 +1,178 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para teclado matricial com varredura por TPM.
+ *
+ * @file        dsf_Keypad_ocp.h
+ * @version     1.0
+ * @date        21 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   FGPIO, PORT e TPM.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (21 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_KEYPAD_OCP_H_
+#define DSF_KEYPAD_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_GPIO_ocp.h"
+#include "dsf_TPM_ocp.h"
+#include "dsf_Event_ocp.h"
+
+/*!
+ * Namespace de definição dos limites do teclado matricial.
+ */
+namespace Keypad_t {
+  enum dsf_KeypadLimits {
+    dsf_MaxRows = 8,
+    dsf_MaxColumns = 16
+  };
+}  // namespace Keypad_t
+
+/*!
+ *  @class    dsf_Keypad_ocp
+ *
+ *  @brief    Classe de varredura de teclado matricial em segundo plano.
+ *
+ *  @details  As linhas são pinos de um mesmo GPIO com o PDOR em nível
+ *            baixo e as colunas são entradas com pull up de um mesmo GPIO.
+ *            A cada interrupção de overflow do TPM, cada linha é
+ *            selecionada tornando-se saída (um OR decorado do BME no PDDR),
+ *            todas as colunas são lidas com uma única leitura do PDIR do
+ *            FGPIO e a linha é liberada voltando a ser entrada (um AND
+ *            decorado). As linhas não selecionadas ficam em alta
+ *            impedância, como em um dreno aberto, que os PCRs do KL25 não
+ *            oferecem: duas teclas da mesma coluna pressionadas não ligam
+ *            a linha selecionada a outra saída em nível alto. A varredura
+ *            de um teclado 4x4 leva poucos microssegundos.
+ *
+ *            O debounce é feito em paralelo para todas as teclas de uma
+ *            linha com contadores verticais de 2 bits: uma tecla muda de
+ *            estado após 4 varreduras consecutivas com o novo valor. Cada
+ *            tecla tem estado próprio (n-key rollover; teclados sem diodos
+ *            podem apresentar teclas fantasmas com 3 ou mais teclas).
+ *
+ *            Cada mudança de estado gera um dsf_Event na fila de eventos,
+ *            com code = linha*colunas + coluna.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Teclado 4x4 com linhas em PTC0..PTC3 e colunas em PTC4..PTC7.
+ *             +fn dsf_Keypad_ocp keypad(GPIO_t::dsf_GPIOC, rowPins, 4,
+ *                                       GPIO_t::dsf_GPIOC, colPins, 4,
+ *                                       TPM_t::dsf_TPM1);
+ *             +fn keypad.setFrequency(TPMDiv_t::Div16);
+ *             +fn keypad.start(1311);  // 1 ms por varredura.
+ *
+ *            Ligação da interrupção do TPM escolhido.
+ *             +fn DSF_IRQ_BIND(TPM1, keypad)
+ *
+ *            Consumo dos eventos no laço principal.
+ *             +fn while (keypad.events().pop(&event)) { ... }
+ */
+class dsf_Keypad_ocp : public dsf_TPMPeripheral_ocp {
+ public:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  dsf_Keypad_ocp(GPIO_t::dsf_GPIO rowGPIO, const GPIO_t::dsf_Pin *rowPins,
+                 uint8_t rows, GPIO_t::dsf_GPIO columnGPIO,
+                 const GPIO_t::dsf_Pin *columnPins, uint8_t columns,
+                 TPM_t::TPMNumber_t tpm = TPM_t::dsf_TPM1);
+  ~dsf_Keypad_ocp();
+
+  /*!
+   * Métodos de configuração e controle da varredura.
+   */
+  void setFrequency(TPMDiv_t::TPMDiv divBase);
+  void start(uint16_t cycles);
+  void stop();
+
+  /*!
+   * Método de tratamento da interrupção de overflow do TPM.
+   */
+  void irqHandler();
+
+  /*!
+   * Método de varredura, chamado pela interrupção.
+   */
+  void scan();
+
+  /*!
+   * Métodos de consulta.
+   */
+  dsf_InputQueue_ocp &events();
+  int isPressed(uint8_t code);
+  uint16_t maxScanTicks();
+
+ private:
+  /*!
+   * Endereços do PDDR das linhas (GPIO, alcançado pelo BME) e do PDIR
+   * das colunas (FGPIO).
+   */
+  volatile uint32_t *addressRowPDDR;
+  volatile uint32_t *addressColumnPDIR;
+  /*!
+   * Máscara de cada linha e máscara de todas as colunas no GPIO.
+   */
+  uint32_t rowMask[Keypad_t::dsf_MaxRows];
+  uint32_t columnMask;
+  /*!
+   * Máscara de cada coluna no GPIO das colunas.
+   */
+  uint32_t columnBit[Keypad_t::dsf_MaxColumns];
+  uint8_t rowCount;
+  uint8_t columnCount;
+  /*!
+   * Estado filtrado e contadores verticais de debounce de cada linha,
+   * com os bits nas posições dos pinos das colunas.
+   */
+  uint32_t keyState[Keypad_t::dsf_MaxRows];
+  uint32_t count0[Keypad_t::dsf_MaxRows];
+  uint32_t count1[Keypad_t::dsf_MaxRows];
+  /*!
+   * Número da varredura, usado como carimbo dos eventos.
+   */
+  uint32_t scanNumber;
+  /*!
+   * Maior contagem do TPM observada ao final de uma varredura.
+   */
+  uint16_t scanTicks;
+  uint8_t freqDiv;
+  uint8_t TPMNumber;
+  ClockGate_t::dsf_Gate rowGate;
+  ClockGate_t::dsf_Gate columnGate;
+  dsf_InputQueue_ocp queue;
+
+  void emitChanges(uint8_t row, uint32_t changed);
+};
+
+#endif  //  DSF_KEYPAD_OCP_H_
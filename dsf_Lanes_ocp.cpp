@@ -0,0 +1,407 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para sorteios independentes em várias pistas
+ *              tecla/led.
+ *
+ * @file        dsf_Lanes_ocp.cpp
+ * @version     1.0
+ * @date        12 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM, GPIO, FGPIO, PORT e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (12 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include <string.h>
+#include "dsf_Lanes_ocp.h"
+#include "dsf_BME_ocp.h"
+
+/*!
+ * Registradores do PORT (pág. 183), do GPIO (pág. 778) e do FGPIO, a
+ * porta de E/S de ciclo único do núcleo (pág. 775).
+ */
+#define DSF_LANES_PCR(GPIO, pin)                                             \
+  (*(volatile uint32_t *)(0x40049000 + 0x1000*(GPIO) + 4*(pin)))
+#define DSF_LANES_PDDR(GPIO) (*(volatile uint32_t *)(0x400FF014 + 0x40*(GPIO)))
+#define DSF_LANES_FPSOR(GPIO) (0xF80FF004 + 0x40*(GPIO))
+#define DSF_LANES_FPCOR(GPIO) (0xF80FF008 + 0x40*(GPIO))
+#define DSF_LANES_FPDIR(GPIO) (0xF80FF010 + 0x40*(GPIO))
+
+namespace {
+
+/*!
+ * Posição do bit isolado por x & -x, pela sequência de De Bruijn: o
+ * Cortex-M0+ não tem a instrução CLZ, mas multiplica em um ciclo.
+ */
+const uint8_t kBitPosition[32] = {
+  0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+  31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+};
+
+inline uint8_t bitPosition(uint32_t bit) {
+  return kBitPosition[(bit*0x077CB531u) >> 27];
+}
+
+}  // namespace
+
+/*!
+ *   @fn         dsf_Lanes_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método associa o objeto ao TPM dedicado, ajusta 25 ticks/s e uma
+ *   exibição de 25 ticks (1 s). O clock do TPM só é adquirido em start.
+ *
+ *   @param[in]  tpm - TPM dedicado aos ticks.
+ *               seed - semente do gerador base dos sorteios.
+ */
+dsf_Lanes_ocp::dsf_Lanes_ocp(TPM_t::TPMNumber_t tpm, uint64_t seed)
+    : portCount(0), laneCount(0), generator(seed), tickCount(0), period(1),
+      showTicks(25), freqDiv(0), TPMNumber(tpm), running(false) {
+  bindPeripheral((uint8_t *)(TPM0_BASE + 0x1000*tpm));
+  memset(port, 0, sizeof(port));
+  memset(wheel, 0, sizeof(wheel));
+  memset(stats, 0, sizeof(stats));
+  setTickRate(25);
+}
+
+/*!
+ *   @fn         ~dsf_Lanes_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ *
+ *   Para os ticks e libera os clocks dos GPIOs.
+ */
+dsf_Lanes_ocp::~dsf_Lanes_ocp() {
+  stop();
+  for (uint8_t i = 0; i < portCount; i++) {
+    dsf_ClockGate_ocp::release(
+        (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA + port[i].GPIO));
+  }
+}
+
+/*!
+ *   @fn         attach
+ *
+ *   @brief      Acrescenta uma pista.
+ *
+ *   A tecla é configurada como entrada com pull up e o led como saída
+ *   apagada. A pista recebe a sequência atual do gerador base, que é
+ *   avançado 2^64 passos para a pista seguinte. Só pode ser chamado com
+ *   os ticks parados.
+ *
+ *   @param[in]  keyGPIO - GPIO da tecla.
+ *               keyPin - número do pino da tecla no GPIO.
+ *               ledGPIO - GPIO do led.
+ *               ledPin - número do pino do led no GPIO.
+ *               polarity - nível que acende o led.
+ *
+ *   @return     O número da pista, ou -1 sem pistas livres ou com a tecla
+ *               já usada por outra pista.
+ */
+int dsf_Lanes_ocp::attach(GPIO_t::dsf_GPIO keyGPIO,
+                          GPIO_t::dsf_Pin keyPin,
+                          GPIO_t::dsf_GPIO ledGPIO,
+                          GPIO_t::dsf_Pin ledPin,
+                          Lanes_t::dsf_LedPolarity polarity) {
+  uint32_t keyBit = 1u << keyPin;
+  uint32_t ledBit = 1u << ledPin;
+  uint8_t key, led;
+
+  if (running || laneCount == Lanes_t::dsf_MaxLanes || keyPin > 31
+      || ledPin > 31) {
+    return -1;
+  }
+  key = portIndex(keyGPIO);
+  led = portIndex(ledGPIO);
+  if (port[key].keyMask & keyBit) {
+    return -1;
+  }
+
+  DSF_LANES_PCR(keyGPIO, keyPin) = PORT_PCR_MUX(1) | PORT_PCR_PE_MASK
+                                   | PORT_PCR_PS_MASK;
+  dsf_BME_ocp::clearBits(&DSF_LANES_PDDR(keyGPIO), keyBit);
+  DSF_LANES_PCR(ledGPIO, ledPin) = PORT_PCR_MUX(1);
+  if (polarity == Lanes_t::dsf_ActiveLow) {
+    *port[led].addressPSOR = ledBit;
+    port[led].invert |= ledBit;
+  } else {
+    *port[led].addressPCOR = ledBit;
+    port[led].invert &= ~ledBit;
+  }
+  dsf_BME_ocp::setBits(&DSF_LANES_PDDR(ledGPIO), ledBit);
+
+  port[key].keyMask |= keyBit;
+  port[key].idle |= keyBit;
+  port[key].lane[keyPin] = laneCount;
+  laneLedPort[laneCount] = led;
+  laneLedPin[laneCount] = ledPin;
+  draw[laneCount].generator = generator;
+  generator.jump();
+  stats[laneCount].draws = 0;
+  stats[laneCount].wins = 0;
+  return laneCount++;
+}
+
+/*!
+ *   @fn         setTickRate
+ *
+ *   @brief      Ajusta o período do TPM para a taxa de ticks pedida.
+ *
+ *   Escolhe o menor divisor do TPM com que o período cabe em 16 bits. Só
+ *   pode ser chamado com os ticks parados.
+ *
+ *   @param[in]  hertz - ticks por segundo desejados.
+ *
+ *   @return     A taxa efetiva, em ticks por segundo.
+ */
+uint32_t dsf_Lanes_ocp::setTickRate(uint16_t hertz) {
+  uint32_t ticks = 0;
+
+  if (running || hertz == 0) {
+    return tickRate();
+  }
+  for (freqDiv = TPMDiv_t::Div1; freqDiv < TPMDiv_t::Div128; freqDiv++) {
+    ticks = (dsf_MCG_ocp::timerHz() >> freqDiv)/hertz;
+    if (ticks <= 0x10000) {
+      break;
+    }
+  }
+  period = (uint16_t)(ticks > 0x10000 ? 0xFFFF : ticks < 2 ? 1 : ticks - 1);
+  return tickRate();
+}
+
+/*!
+ *   @fn         setShowTicks
+ *
+ *   @brief      Ajusta a duração da exibição do resultado.
+ *
+ *   @param[in]  ticks - duração, de 1 a Lanes_t::dsf_WheelSlots - 1
+ *               ticks.
+ */
+void dsf_Lanes_ocp::setShowTicks(uint8_t ticks) {
+  if (ticks == 0) {
+    ticks = 1;
+  }
+  showTicks = ticks < Lanes_t::dsf_WheelSlots ?
+              ticks : (uint8_t)(Lanes_t::dsf_WheelSlots - 1);
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Inicia os ticks periódicos.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ *               - TPMxMOD: Modulo Register. Pág. 554.
+ */
+void dsf_Lanes_ocp::start() {
+  if (running) {
+    return;
+  }
+  enablePeripheralClock(TPMNumber);
+  /*!
+   * Limpa TOF (0x80), habilita a interrupção TOIE (0x40) e a contagem
+   * (0x08) com uma única escrita.
+   */
+  restartCounter(period, 0x80 | 0x40 | 0x08 | freqDiv);
+  NVIC_ClearPendingIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  NVIC_EnableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  running = true;
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para os ticks e libera o TPM. Os leds ficam como estão.
+ */
+void dsf_Lanes_ocp::stop() {
+  if (!running) {
+    return;
+  }
+  NVIC_DisableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  writeSC(0);
+  disablePeripheralClock();
+  running = false;
+}
+
+/*!
+ *   @fn         tick
+ *
+ *   @brief      Avança todas as pistas um tick.
+ *
+ *   Para cada GPIO usado: os fins de exibição da posição atual da roda
+ *   passam a esperar a tecla ser solta; as teclas são lidas e filtradas
+ *   (a amostra vale quando repete a anterior); as pistas em espera com a
+ *   tecla solta ficam livres; e as pistas livres com a tecla recém
+ *   pressionada sorteiam e entram na roda. Os leds alterados são escritos
+ *   no fim, uma escrita no PSOR e outra no PCOR por GPIO.
+ */
+void dsf_Lanes_ocp::tick() {
+  uint32_t on[Lanes_t::dsf_Ports] = {0};
+  uint32_t off[Lanes_t::dsf_Ports] = {0};
+  uint32_t slot = tickCount & (Lanes_t::dsf_WheelSlots - 1);
+  uint32_t due = (tickCount + showTicks) & (Lanes_t::dsf_WheelSlots - 1);
+
+  for (uint8_t i = 0; i < portCount; i++) {
+    Port &p = port[i];
+    uint32_t expired = wheel[slot][i];
+    uint32_t raw, agree, pressed, down, lit;
+
+    if (!p.keyMask) {
+      continue;
+    }
+    if (expired) {
+      wheel[slot][i] = 0;
+      p.waiting |= expired;
+      lit = expired & p.won;
+      p.won &= ~expired;
+      while (lit) {
+        uint32_t bit = lit & (0u - lit);
+        uint8_t lane = p.lane[bitPosition(bit)];
+
+        off[laneLedPort[lane]] |= 1u << laneLedPin[lane];
+        lit &= lit - 1;
+      }
+    }
+
+    raw = ~*p.addressPDIR & p.keyMask;
+    agree = ~(raw ^ p.raw);
+    p.raw = raw;
+    pressed = (p.pressed & ~agree) | (raw & agree);
+    down = pressed & ~p.pressed & p.idle;
+    p.pressed = pressed;
+
+    p.idle |= p.waiting & ~pressed;
+    p.waiting &= pressed;
+    if (down) {
+      p.idle &= ~down;
+      wheel[due][i] |= down;
+      while (down) {
+        uint32_t bit = down & (0u - down);
+        uint8_t lane = p.lane[bitPosition(bit)];
+
+        stats[lane].draws++;
+        if (lpm_draw::isWin(draw[lane].draw())) {
+          stats[lane].wins++;
+          p.won |= bit;
+          on[laneLedPort[lane]] |= 1u << laneLedPin[lane];
+        }
+        down &= down - 1;
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i < portCount; i++) {
+    uint32_t high = (on[i] & ~port[i].invert) | (off[i] & port[i].invert);
+    uint32_t low = (on[i] & port[i].invert) | (off[i] & ~port[i].invert);
+
+    if (high) {
+      *port[i].addressPSOR = high;
+    }
+    if (low) {
+      *port[i].addressPCOR = low;
+    }
+  }
+  tickCount = tickCount + 1;
+}
+
+/*!
+ *   @fn         lanes
+ *
+ *   @brief      Informa o número de pistas acrescentadas.
+ */
+uint8_t dsf_Lanes_ocp::lanes() {
+  return laneCount;
+}
+
+/*!
+ *   @fn         getStats
+ *
+ *   @brief      Copia as estatísticas de uma pista.
+ *
+ *   Os contadores são lidos sem desabilitar a interrupção; com os ticks
+ *   em andamento, draws e wins podem diferir de um sorteio entre si.
+ *
+ *   @param[in]  lane - pista retornada por attach.
+ *
+ *   @param[out] laneStats - sorteios e vitórias da pista.
+ */
+void dsf_Lanes_ocp::getStats(uint8_t lane, dsf_LaneStats *laneStats) {
+  if (lane < laneCount) {
+    *laneStats = stats[lane];
+  }
+}
+
+/*!
+ *   @fn         ticks
+ *
+ *   @brief      Informa o número de ticks desde a construção.
+ */
+uint32_t dsf_Lanes_ocp::ticks() {
+  return tickCount;
+}
+
+/*!
+ *   @fn         tickRate
+ *
+ *   @brief      Informa a taxa de ticks efetiva, em ticks por segundo.
+ */
+uint32_t dsf_Lanes_ocp::tickRate() {
+  return (dsf_MCG_ocp::timerHz() >> freqDiv)/((uint32_t)period + 1);
+}
+
+/*!
+ *   @fn         portIndex
+ *
+ *   @brief      Informa o índice de um GPIO usado, acrescentando-o.
+ *
+ *   O clock do PORT é adquirido na primeira pista que usa o GPIO.
+ *
+ *   @param[in]  GPIO - número do GPIO.
+ */
+uint8_t dsf_Lanes_ocp::portIndex(uint8_t GPIO) {
+  uint8_t index = 0;
+
+  while (index < portCount && port[index].GPIO != GPIO) {
+    index++;
+  }
+  if (index == portCount) {
+    dsf_ClockGate_ocp::acquire(
+        (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA + GPIO));
+    port[index].GPIO = GPIO;
+    port[index].addressPDIR = (volatile uint32_t *)DSF_LANES_FPDIR(GPIO);
+    port[index].addressPSOR = (volatile uint32_t *)DSF_LANES_FPSOR(GPIO);
+    port[index].addressPCOR = (volatile uint32_t *)DSF_LANES_FPCOR(GPIO);
+    portCount++;
+  }
+  return index;
+}
@@ -0,0 +1,215 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Sorteios independentes em várias pistas tecla/led.
+ *
+ * @file        dsf_Lanes_ocp.h
+ * @version     1.0
+ * @date        12 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM, PORT e FGPIO.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (12 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_LANES_OCP_H_
+#define DSF_LANES_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_TPM_ocp.h"
+#include "dsf_GPIO_ocp.h"
+#include "lpm_draw.h"
+
+/*!
+ * Namespace associado aos limites das pistas: pistas, GPIOs e posições da
+ * roda de temporização (a exibição dura no máximo dsf_WheelSlots - 1
+ * ticks).
+ */
+namespace Lanes_t {
+  enum dsf_LanesLimits {
+    dsf_MaxLanes = 32,
+    dsf_Ports = 5,
+    dsf_WheelSlots = 32
+  };
+  enum dsf_LedPolarity {
+    dsf_ActiveHigh = 0,
+    dsf_ActiveLow = 1
+  };
+}  // namespace Lanes_t
+
+/*!
+ * Estatísticas de uma pista.
+ */
+struct dsf_LaneStats {
+  uint32_t draws;
+  uint32_t wins;
+};
+
+/*!
+ *  @class    dsf_Lanes_ocp
+ *
+ *  @brief    Pistas tecla/led com sorteio próprio, atendidas por um TPM.
+ *
+ *  @details  Cada pista tem uma tecla (entrada com pull up, pressionada em
+ *            nível baixo) e um led, em quaisquer pinos GPIO, e o seu
+ *            próprio gerador de sorteios (a sequência do gerador base
+ *            avançada 2^64 passos por pista) e contadores. Uma pista
+ *            pressionada sorteia uma vez, mostra o resultado (led aceso
+ *            na vitória, apagado na derrota) por showTicks ticks e espera
+ *            a tecla ser solta antes do próximo sorteio.
+ *
+ *            Um TPM dedicado gera os ticks. Em cada tick, as teclas de
+ *            cada GPIO usado são lidas com uma única leitura do PDIR do
+ *            FGPIO e filtradas (a tecla muda após dois ticks iguais), e os
+ *            estados das pistas (livre, exibindo e esperando soltar) são
+ *            máscaras por GPIO, avançadas com operações sobre a palavra
+ *            inteira. Os fins de exibição ficam em uma roda de
+ *            temporização de máscaras, sem contadores por pista. Os leds
+ *            alterados são escritos com uma escrita no PSOR e outra no
+ *            PCOR por GPIO. Só as pistas com evento no tick (toque ou fim
+ *            de exibição) são visitadas uma a uma; o custo de um tick sem
+ *            eventos depende do número de GPIOs, não de pistas.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Duas pistas a 25 ticks/s, sobre o TPM1.
+ *             +fn dsf_Lanes_ocp lanes(TPM_t::dsf_TPM1);
+ *             +fn DSF_IRQ_BIND(TPM1, lanes)
+ *             +fn lanes.attach(GPIO_t::dsf_GPIOA, GPIO_t::dsf_PTA1,
+ *                              GPIO_t::dsf_GPIOB, GPIO_t::dsf_PTB18,
+ *                              Lanes_t::dsf_ActiveLow);
+ *             +fn lanes.attach(GPIO_t::dsf_GPIOD, GPIO_t::dsf_PTD3,
+ *                              GPIO_t::dsf_GPIOB, GPIO_t::dsf_PTB19,
+ *                              Lanes_t::dsf_ActiveLow);
+ *             +fn lanes.setTickRate(25);
+ *             +fn lanes.start();
+ *             +fn lanes.getStats(0, &stats);
+ */
+class dsf_Lanes_ocp : public dsf_TPMPeripheral_ocp {
+ public:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  explicit dsf_Lanes_ocp(TPM_t::TPMNumber_t tpm = TPM_t::dsf_TPM1,
+                         uint64_t seed = 1);
+  ~dsf_Lanes_ocp();
+
+  /*!
+   * Métodos de configuração das pistas e dos ticks.
+   */
+  int attach(GPIO_t::dsf_GPIO keyGPIO, GPIO_t::dsf_Pin keyPin,
+             GPIO_t::dsf_GPIO ledGPIO, GPIO_t::dsf_Pin ledPin,
+             Lanes_t::dsf_LedPolarity polarity = Lanes_t::dsf_ActiveHigh);
+  uint32_t setTickRate(uint16_t hertz);
+  void setShowTicks(uint8_t ticks);
+
+  /*!
+   * Métodos de controle dos ticks.
+   */
+  void start();
+  void stop();
+
+  /*!
+   *   @fn         irqHandler
+   *
+   *   @brief      Trata o overflow do TPM com um tick das pistas.
+   */
+  void irqHandler() {
+    clearOverflow();
+    tick();
+  }
+
+  /*!
+   * Tick das pistas, chamado pela interrupção ou por outro serviço de
+   * tempo com o TPM parado.
+   */
+  void tick();
+
+  /*!
+   * Métodos de consulta.
+   */
+  uint8_t lanes();
+  void getStats(uint8_t lane, dsf_LaneStats *laneStats);
+  uint32_t ticks();
+  uint32_t tickRate();
+
+ private:
+  /*!
+   *  @struct   Port
+   *
+   *  @brief    Estado das pistas de um GPIO usado.
+   *
+   *  @details  As máscaras de estado têm os bits nas posições das teclas
+   *            (uma pista em exibição não está em idle nem em waiting);
+   *            invert, nas posições dos leds.
+   */
+  struct Port {
+    volatile uint32_t *addressPDIR;
+    volatile uint32_t *addressPSOR;
+    volatile uint32_t *addressPCOR;
+    uint32_t keyMask;
+    uint32_t raw;
+    uint32_t pressed;
+    uint32_t idle;
+    uint32_t won;
+    uint32_t waiting;
+    uint32_t invert;
+    uint8_t GPIO;
+    uint8_t lane[32];
+  };
+  Port port[Lanes_t::dsf_Ports];
+  uint8_t portCount;
+  /*!
+   * Fins de exibição por posição da roda e por GPIO usado.
+   */
+  uint32_t wheel[Lanes_t::dsf_WheelSlots][Lanes_t::dsf_Ports];
+  /*!
+   * GPIO usado e bit do led de cada pista, sorteio e estatísticas.
+   */
+  uint8_t laneLedPort[Lanes_t::dsf_MaxLanes];
+  uint8_t laneLedPin[Lanes_t::dsf_MaxLanes];
+  lpm_draw draw[Lanes_t::dsf_MaxLanes];
+  dsf_LaneStats stats[Lanes_t::dsf_MaxLanes];
+  uint8_t laneCount;
+  /*!
+   * Gerador base, avançado a cada pista acrescentada.
+   */
+  lpm_random generator;
+  volatile uint32_t tickCount;
+  uint16_t period;
+  uint8_t showTicks;
+  uint8_t freqDiv;
+  uint8_t TPMNumber;
+  bool running;
+
+  uint8_t portIndex(uint8_t GPIO);
+};
+
+#endif  //  DSF_LANES_OCP_H_
@@ -0,0 +1,440 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Medição da latência entre duas bordas por captura do TPM.
+ *
+ * @file        dsf_Latency_ocp.cpp
+ * @version     1.0
+ * @date        25 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM (input capture) e PORT.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (25 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_Latency_ocp.h"
+#include "dsf_Text_ocp.h"
+
+/*!
+ *   @fn         dsf_Latency_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método associa o objeto ao TPM e aos canais dos dois pinos,
+ *   seleciona a função TPM nos pinos e zera o histograma. Os dois pinos
+ *   devem pertencer ao mesmo TPM; caso contrário start não faz nada.
+ *
+ *   @param[in]  stimulusPin - pino de captura ligado ao estímulo.
+ *               responsePin - pino de captura ligado à resposta.
+ *               stimulusEdge - borda de estímulo (tecla pressionada).
+ *               responseEdge - borda de resposta (mudança do led).
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - PortxPCRn: Pin Control Register. Pág. 183.
+ *               - TPMxCnSC: Channel Status and Control. Pág. 555.
+ */
+dsf_Latency_ocp::dsf_Latency_ocp(TPM_t::Pin_t stimulusPin,
+                                 TPM_t::Pin_t responsePin,
+                                 TPMEdge_t::TPMEdge stimulusEdge,
+                                 TPMEdge_t::TPMEdge responseEdge) {
+  uint8_t *baseAddress;
+  uint8_t responseGPIO = (responsePin >> 5) & 0x7;
+
+  TPMNumber = (stimulusPin >> 11) & 0x3;
+  sameTPM = TPMNumber == ((responsePin >> 11) & 0x3);
+  freqDiv = TPMDiv_t::Div16;
+  baseAddress = (uint8_t *)(TPM0_BASE + 0x1000*TPMNumber);
+  bindPeripheral(baseAddress);
+
+  bindChannel(baseAddress, (responsePin >> 8) & 0x7);
+  responseCnSC = addressTPMxCnSC;
+  responseCnV = addressTPMxCnV;
+  bindChannel(baseAddress, (stimulusPin >> 8) & 0x7);
+  stimulusCnSC = addressTPMxCnSC;
+  stimulusCnV = addressTPMxCnV;
+
+  /*!
+   * Canais em captura (MSB:MSA = 00) com interrupção (CHIE = 0x40).
+   */
+  stimulusConfig = 0x40 | edgeBits(stimulusEdge);
+  responseConfig = 0x40 | edgeBits(responseEdge);
+
+  enableGPIOClock((stimulusPin >> 5) & 0x7);
+  bindPin((stimulusPin >> 5) & 0x7, stimulusPin & 0x1F);
+  selectMuxAlternative((stimulusPin >> 13) & 0x7);
+
+  responseGate = (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA
+                                         + responseGPIO);
+  dsf_ClockGate_ocp::acquire(responseGate);
+  bindPin(responseGPIO, responsePin & 0x1F);
+  selectMuxAlternative((responsePin >> 13) & 0x7);
+
+  reset();
+}
+
+/*!
+ *   @fn         ~dsf_Latency_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ *
+ *   Este método para a medição e libera os clocks adquiridos.
+ */
+dsf_Latency_ocp::~dsf_Latency_ocp() {
+  stop();
+  dsf_ClockGate_ocp::release(responseGate);
+}
+
+/*!
+ *   @fn         setFrequency
+ *
+ *   @brief      Ajusta o divisor de frequência do TPM, que define o tick.
+ *
+ *   @param[in]  divBase - constante de divisão do divisor de frequência.
+ */
+void dsf_Latency_ocp::setFrequency(TPMDiv_t::TPMDiv divBase) {
+  freqDiv = divBase;
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Inicia a contagem livre e a captura das bordas.
+ *
+ *   Os canais são configurados com a contagem parada e a contagem é
+ *   habilitada, com TOIE, em uma única escrita no TPMxSC.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ */
+void dsf_Latency_ocp::start() {
+  if (!sameTPM) {
+    return;
+  }
+  enablePeripheralClock(TPMNumber);
+  writeSC(0);
+  *stimulusCnSC = 0x80 | stimulusConfig;
+  *responseCnSC = 0x80 | responseConfig;
+  overflows = 0;
+  armed = false;
+  restartCounter(0xFFFF, 0x80 | 0x40 | 0x08 | freqDiv);
+  NVIC_ClearPendingIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  NVIC_EnableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para a medição e libera o clock do TPM.
+ *
+ *   O histograma é preservado para consulta.
+ */
+void dsf_Latency_ocp::stop() {
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  NVIC_DisableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  *stimulusCnSC = 0x80;
+  *responseCnSC = 0x80;
+  writeSC(0);
+  disablePeripheralClock();
+}
+
+/*!
+ *   @fn         reset
+ *
+ *   @brief      Zera o histograma e descarta a medição em andamento.
+ */
+void dsf_Latency_ocp::reset() {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  for (uint8_t b = 0; b < Latency_t::dsf_Buckets; b++) {
+    histogram[b] = 0;
+  }
+  count = 0;
+  minTicks = 0xFFFFFFFF;
+  maxTicks = 0;
+  sumTicks = 0;
+  armed = false;
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         irqHandler
+ *
+ *   @brief      Trata as interrupções de overflow e de captura do TPM.
+ *
+ *   O overflow é tratado antes das capturas. As flags são limpas com uma
+ *   escrita da configuração com o bit de flag (write-1-to-clear), sem
+ *   leitura-modificação-escrita.
+ */
+void dsf_Latency_ocp::irqHandler() {
+  bool wrapped = false;
+  bool hasStimulus, hasResponse;
+  uint32_t stimulusTime = 0, responseTime = 0;
+
+  if (*addressTPMxSC & 0x80) {
+    clearOverflow();
+    overflows++;
+    wrapped = true;
+  }
+  hasStimulus = *stimulusCnSC & 0x80;
+  if (hasStimulus) {
+    stimulusTime = stamp(*stimulusCnV, wrapped);
+    *stimulusCnSC = 0x80 | stimulusConfig;
+  }
+  hasResponse = *responseCnSC & 0x80;
+  if (hasResponse) {
+    responseTime = stamp(*responseCnV, wrapped);
+    *responseCnSC = 0x80 | responseConfig;
+  }
+
+  /*!
+   * Uma resposta capturada antes do estímulo na mesma interrupção fecha a
+   * medição anterior antes que o novo estímulo a arme de novo.
+   */
+  if (hasResponse && hasStimulus
+      && (int32_t)(responseTime - stimulusTime) < 0) {
+    if (armed) {
+      record(responseTime - stimulusStamp);
+      armed = false;
+    }
+    hasResponse = false;
+  }
+  if (hasStimulus && !armed) {
+    stimulusStamp = stimulusTime;
+    armed = true;
+  }
+  if (hasResponse && armed) {
+    record(responseTime - stimulusStamp);
+    armed = false;
+  }
+}
+
+/*!
+ *   @fn         stamp
+ *
+ *   @brief      Estende um valor capturado de 16 para 32 bits.
+ *
+ *   Uma captura na metade alta com overflow tratado nesta interrupção
+ *   ocorreu antes do overflow; uma captura na metade baixa com overflow
+ *   ainda pendente ocorreu depois dele.
+ *
+ *   @param[in]  value - valor do TPMxCnV.
+ *               wrapped - indica se esta interrupção tratou um overflow.
+ *
+ *   @return     O instante da captura em ticks.
+ */
+uint32_t dsf_Latency_ocp::stamp(uint32_t value, bool wrapped) {
+  uint32_t high = overflows;
+
+  if (wrapped && value >= 0x8000) {
+    high--;
+  } else if (!wrapped && value < 0x8000 && (*addressTPMxSC & 0x80)) {
+    high++;
+  }
+  return (high << 16) | (value & 0xFFFF);
+}
+
+/*!
+ *   @fn         record
+ *
+ *   @brief      Acumula uma latência no histograma e no resumo.
+ */
+void dsf_Latency_ocp::record(uint32_t ticks) {
+  histogram[bucketOf(ticks)]++;
+  count++;
+  sumTicks += ticks;
+  if (ticks < minTicks) {
+    minTicks = ticks;
+  }
+  if (ticks > maxTicks) {
+    maxTicks = ticks;
+  }
+}
+
+/*!
+ *   @fn         bucketOf
+ *
+ *   @brief      Calcula a classe do histograma de um valor.
+ *
+ *   O expoente é obtido por busca binária, pois o Cortex-M0+ não tem a
+ *   instrução CLZ.
+ */
+uint8_t dsf_Latency_ocp::bucketOf(uint32_t ticks) {
+  uint32_t x = ticks;
+  uint8_t exponent = 0;
+
+  if (ticks < Latency_t::dsf_SubBuckets) {
+    return (uint8_t)ticks;
+  }
+  if (x >= 1u << 16) { x >>= 16; exponent += 16; }
+  if (x >= 1u << 8) { x >>= 8; exponent += 8; }
+  if (x >= 1u << 4) { x >>= 4; exponent += 4; }
+  if (x >= 1u << 2) { x >>= 2; exponent += 2; }
+  if (x >= 1u << 1) { exponent += 1; }
+  return (uint8_t)((exponent - 2)*8 + ((ticks >> (exponent - 3)) & 7));
+}
+
+/*!
+ *   @fn         bucketLow
+ *
+ *   @brief      Informa o menor valor de uma classe do histograma.
+ *
+ *   @param[in]  bucket - classe, de 0 a Latency_t::dsf_Buckets - 1.
+ *
+ *   @return     O limite inferior da classe, em ticks.
+ */
+uint32_t dsf_Latency_ocp::bucketLow(uint8_t bucket) {
+  if (bucket < Latency_t::dsf_SubBuckets) {
+    return bucket;
+  }
+  return (uint32_t)(8 + bucket % 8) << (bucket/8 - 1);
+}
+
+/*!
+ *   @fn         bucketCount
+ *
+ *   @brief      Informa o número de medições de uma classe.
+ */
+uint32_t dsf_Latency_ocp::bucketCount(uint8_t bucket) {
+  if (bucket >= Latency_t::dsf_Buckets) {
+    return 0;
+  }
+  return histogram[bucket];
+}
+
+/*!
+ *   @fn         getStats
+ *
+ *   @brief      Calcula o resumo das latências medidas.
+ *
+ *   A cópia é feita com as interrupções desabilitadas, de modo que o
+ *   resumo é consistente mesmo com a medição em andamento.
+ *
+ *   @param[out] stats - contagem, mínimo, média, p99 e máximo, em ticks.
+ */
+void dsf_Latency_ocp::getStats(dsf_LatencyStats *stats) {
+  uint32_t primask = __get_PRIMASK();
+  uint64_t sum, target, seen = 0;
+  uint8_t b;
+
+  __disable_irq();
+  stats->count = count;
+  stats->min = count ? minTicks : 0;
+  stats->max = maxTicks;
+  sum = sumTicks;
+  __set_PRIMASK(primask);
+
+  stats->mean = stats->count ? (uint32_t)(sum/stats->count) : 0;
+  stats->p99 = 0;
+  target = ((uint64_t)stats->count*99 + 99)/100;
+  for (b = 0; stats->count && b < Latency_t::dsf_Buckets; b++) {
+    seen += histogram[b];
+    if (seen >= target) {
+      stats->p99 = b + 1 < Latency_t::dsf_Buckets ?
+                   bucketLow(b + 1) - 1 : 0xFFFFFFFF;
+      break;
+    }
+  }
+  if (stats->p99 > stats->max) {
+    stats->p99 = stats->max;
+  }
+  if (stats->p99 < stats->min) {
+    stats->p99 = stats->min;
+  }
+}
+
+/*!
+ *   @fn         ticksToMicros
+ *
+ *   @brief      Converte ticks do TPM em microssegundos.
+ */
+uint32_t dsf_Latency_ocp::ticksToMicros(uint32_t ticks) {
+  return (uint32_t)(((uint64_t)ticks << freqDiv)*1000000
+                    / dsf_MCG_ocp::timerHz());
+}
+
+/*!
+ *   @fn         dump
+ *
+ *   @brief      Escreve o resumo e as classes não vazias em texto.
+ *
+ *   O formato é estável, uma grandeza por linha, para que as saídas de
+ *   dois builds possam ser comparadas diretamente:
+ *
+ *     latency count=N min_us=.. mean_us=.. p99_us=.. max_us=..
+ *     bucket_us=LIMITE_INFERIOR count=N
+ *
+ *   @param[in]  putChar - função de saída de um caractere (UART, debugger
+ *                         ou printf no host).
+ */
+void dsf_Latency_ocp::dump(void (*putChar)(char)) {
+  dsf_LatencyStats stats;
+
+  getStats(&stats);
+  dsf_putText(putChar, "latency count=");
+  dsf_putNumber(putChar, stats.count);
+  dsf_putText(putChar, " min_us=");
+  dsf_putNumber(putChar, ticksToMicros(stats.min));
+  dsf_putText(putChar, " mean_us=");
+  dsf_putNumber(putChar, ticksToMicros(stats.mean));
+  dsf_putText(putChar, " p99_us=");
+  dsf_putNumber(putChar, ticksToMicros(stats.p99));
+  dsf_putText(putChar, " max_us=");
+  dsf_putNumber(putChar, ticksToMicros(stats.max));
+  putChar('\n');
+  for (uint8_t b = 0; b < Latency_t::dsf_Buckets; b++) {
+    if (histogram[b]) {
+      dsf_putText(putChar, "bucket_us=");
+      dsf_putNumber(putChar, ticksToMicros(bucketLow(b)));
+      dsf_putText(putChar, " count=");
+      dsf_putNumber(putChar, histogram[b]);
+      putChar('\n');
+    }
+  }
+}
+
+/*!
+ *   @fn         edgeBits
+ *
+ *   @brief      Converte a borda no campo ELSB:ELSA da captura.
+ *
+ *   Os valores de TPMEdge_t não coincidem com o campo: na captura, ELSA
+ *   (0x04) seleciona a borda de subida e ELSB (0x08) a de descida.
+ *
+ *   @remarks    Tabela 31-34 do Manual de Referência KL25. Pág. 556.
+ */
+uint32_t dsf_Latency_ocp::edgeBits(TPMEdge_t::TPMEdge edge) {
+  switch (edge) {
+    case TPMEdge_t::Rising: return 0x04;
+    case TPMEdge_t::Falling: return 0x08;
+    default: return 0x0C;
+  }
+}
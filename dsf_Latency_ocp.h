@@ -0,0 +1,177 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Medição da latência entre duas bordas por captura do TPM.
+ *
+ * @file        dsf_Latency_ocp.h
+ * @version     1.0
+ * @date        25 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM (input capture) e PORT.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (25 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_LATENCY_OCP_H_
+#define DSF_LATENCY_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_TPM_ocp.h"
+
+/*!
+ * Namespace de definição do histograma de latências. O histograma é
+ * log-linear: valores até 7 ticks têm classe própria e cada oitava acima
+ * é dividida em 8 classes, o que limita o erro relativo a 12,5%.
+ */
+namespace Latency_t {
+  enum dsf_LatencyLimits {
+    dsf_SubBuckets = 8,
+    dsf_Buckets = 240
+  };
+}  // namespace Latency_t
+
+/*!
+ *  @struct   dsf_LatencyStats
+ *
+ *  @brief    Resumo das latências medidas, em ticks do TPM.
+ *
+ *  @details  O p99 é o limite superior da classe do histograma que contém o
+ *            percentil, portanto nunca subestima o valor exato.
+ */
+struct dsf_LatencyStats {
+  uint32_t count;
+  uint32_t min;
+  uint32_t mean;
+  uint32_t p99;
+  uint32_t max;
+};
+
+/*!
+ *  @class    dsf_Latency_ocp
+ *
+ *  @brief    Mede a latência entre uma borda de estímulo e uma de resposta.
+ *
+ *  @details  Os dois pinos são canais de captura do mesmo TPM, ligados por
+ *            fio (loopback) ao sinal de estímulo (a tecla) e ao de resposta
+ *            (o led). O TPM conta livremente com MOD = 0xFFFF e a
+ *            interrupção de overflow estende a contagem para 32 bits.
+ *
+ *            A primeira borda de estímulo arma a medição; as bordas seguintes
+ *            (repiques da tecla) são ignoradas até a primeira borda de
+ *            resposta, que fecha a medição. As medições são acumuladas em
+ *            um histograma em RAM, sem divisões na interrupção.
+ *
+ *            Com Div16 o tick vale 0,76 us e o alcance é de 54 minutos.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Tecla (PTA1) ligada a PTA12 e led verde (PTB18) a PTA13.
+ *             +fn dsf_Latency_ocp latency(TPM_t::dsf_TPM1_PTA12,
+ *                                         TPM_t::dsf_TPM1_PTA13);
+ *             +fn latency.start();
+ *             +fn DSF_IRQ_BIND(TPM1, latency)
+ *             +fn latency.dump(putChar);
+ */
+class dsf_Latency_ocp : public dsf_TPMPeripheral_ocp {
+ public:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  dsf_Latency_ocp(TPM_t::Pin_t stimulusPin, TPM_t::Pin_t responsePin,
+                  TPMEdge_t::TPMEdge stimulusEdge = TPMEdge_t::Falling,
+                  TPMEdge_t::TPMEdge responseEdge = TPMEdge_t::Both);
+  ~dsf_Latency_ocp();
+
+  /*!
+   * Métodos de configuração e controle da medição.
+   */
+  void setFrequency(TPMDiv_t::TPMDiv divBase);
+  void start();
+  void stop();
+  void reset();
+
+  /*!
+   * Método de tratamento da interrupção do TPM.
+   */
+  void irqHandler();
+
+  /*!
+   * Métodos de consulta e de descarga do histograma.
+   */
+  void getStats(dsf_LatencyStats *stats);
+  uint32_t bucketCount(uint8_t bucket);
+  static uint32_t bucketLow(uint8_t bucket);
+  uint32_t ticksToMicros(uint32_t ticks);
+  void dump(void (*putChar)(char));
+
+ private:
+  /*!
+   * Registradores dos canais de estímulo e de resposta.
+   */
+  volatile uint32_t *stimulusCnSC;
+  volatile uint32_t *stimulusCnV;
+  volatile uint32_t *responseCnSC;
+  volatile uint32_t *responseCnV;
+  /*!
+   * Configuração dos canais (ELSB:ELSA e CHIE).
+   */
+  uint32_t stimulusConfig;
+  uint32_t responseConfig;
+  ClockGate_t::dsf_Gate responseGate;
+  uint8_t TPMNumber;
+  uint8_t freqDiv;
+  bool sameTPM;
+
+  /*!
+   * Contagem de overflows, parte alta do tempo de 32 bits.
+   */
+  volatile uint32_t overflows;
+  /*!
+   * Instante da borda de estímulo que armou a medição em andamento.
+   */
+  uint32_t stimulusStamp;
+  bool armed;
+
+  /*!
+   * Histograma e resumo das latências.
+   */
+  uint32_t histogram[Latency_t::dsf_Buckets];
+  uint32_t count;
+  uint32_t minTicks;
+  uint32_t maxTicks;
+  uint64_t sumTicks;
+
+  uint32_t stamp(uint32_t value, bool wrapped);
+  void record(uint32_t ticks);
+  static uint8_t bucketOf(uint32_t ticks);
+  static uint32_t edgeBits(TPMEdge_t::TPMEdge edge);
+};
+
+#endif  //  DSF_LATENCY_OCP_H_
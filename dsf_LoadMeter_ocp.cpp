@@ -0,0 +1,272 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Medidor de carga da CPU: atraso, sono, interrupções e
+ *              aplicação.
+ *
+ * @file        dsf_LoadMeter_ocp.cpp
+ * @version     1.0
+ * @date        27 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM (via dsf_SysClock_ocp).
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (27 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_LoadMeter_ocp.h"
+#include "dsf_Text_ocp.h"
+
+dsf_SysClock_ocp *dsf_LoadMeter_ocp::clock = 0;
+uint8_t dsf_LoadMeter_ocp::current = LoadMeter_t::dsf_Application;
+uint8_t dsf_LoadMeter_ocp::slot = 0;
+uint64_t dsf_LoadMeter_ocp::since = 0;
+uint64_t dsf_LoadMeter_ocp::slotEnd = 0;
+uint32_t dsf_LoadMeter_ocp::slotTicks = 1;
+uint32_t dsf_LoadMeter_ocp::slots[LoadMeter_t::dsf_Slots]
+                                 [LoadMeter_t::dsf_NumCategories];
+uint64_t dsf_LoadMeter_ocp::totals[LoadMeter_t::dsf_NumCategories];
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Zera o medidor e começa a contabilizar como aplicação.
+ *
+ *   @param[in]  sysClock - relógio do sistema, já iniciado.
+ *               slotMicros - duração de cada fatia da janela deslizante;
+ *                            a janela cobre dsf_Slots fatias.
+ */
+void dsf_LoadMeter_ocp::start(dsf_SysClock_ocp *sysClock,
+                              uint32_t slotMicros) {
+  uint32_t primask = __get_PRIMASK();
+  uint64_t ticks = (uint64_t)slotMicros*sysClock->tickFrequency()/1000000;
+
+  __disable_irq();
+  for (uint8_t s = 0; s < LoadMeter_t::dsf_Slots; s++) {
+    for (uint8_t c = 0; c < LoadMeter_t::dsf_NumCategories; c++) {
+      slots[s][c] = 0;
+    }
+  }
+  for (uint8_t c = 0; c < LoadMeter_t::dsf_NumCategories; c++) {
+    totals[c] = 0;
+  }
+  slotTicks = ticks ? (uint32_t)ticks : 1;
+  current = LoadMeter_t::dsf_Application;
+  slot = 0;
+  since = sysClock->ticks();
+  slotEnd = since + slotTicks;
+  clock = sysClock;
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Contabiliza o tempo até agora e congela o medidor.
+ */
+void dsf_LoadMeter_ocp::stop() {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (clock) {
+    charge(clock->ticks());
+    clock = 0;
+  }
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         enter
+ *
+ *   @brief      Atribui o tempo decorrido à categoria corrente e troca de
+ *               categoria.
+ *
+ *   @param[in]  category - nova categoria.
+ *
+ *   @return     A categoria anterior, a ser restaurada por leave.
+ */
+uint8_t dsf_LoadMeter_ocp::enter(LoadMeter_t::dsf_LoadCategory category) {
+  uint32_t primask = __get_PRIMASK();
+  uint8_t previous;
+
+  __disable_irq();
+  previous = current;
+  if (clock) {
+    charge(clock->ticks());
+    current = category;
+  }
+  __set_PRIMASK(primask);
+  return previous;
+}
+
+/*!
+ *   @fn         leave
+ *
+ *   @brief      Atribui o tempo decorrido e restaura a categoria anterior.
+ *
+ *   @param[in]  previous - valor retornado pelo enter correspondente.
+ */
+void dsf_LoadMeter_ocp::leave(uint8_t previous) {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (clock) {
+    charge(clock->ticks());
+    current = previous;
+  }
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         getStats
+ *
+ *   @brief      Calcula a carga na janela deslizante, até o instante atual.
+ *
+ *   @param[out] stats - tempos em ticks do relógio e porcentagens.
+ */
+void dsf_LoadMeter_ocp::getStats(dsf_LoadStats *stats) {
+  uint32_t primask = __get_PRIMASK();
+  uint32_t busy;
+
+  __disable_irq();
+  if (clock) {
+    charge(clock->ticks());
+  }
+  stats->total = 0;
+  for (uint8_t c = 0; c < LoadMeter_t::dsf_NumCategories; c++) {
+    stats->ticks[c] = 0;
+    for (uint8_t s = 0; s < LoadMeter_t::dsf_Slots; s++) {
+      stats->ticks[c] += slots[s][c];
+    }
+    stats->total += stats->ticks[c];
+  }
+  __set_PRIMASK(primask);
+
+  busy = stats->ticks[LoadMeter_t::dsf_Application]
+         + stats->ticks[LoadMeter_t::dsf_Interrupt];
+  for (uint8_t c = 0; c < LoadMeter_t::dsf_NumCategories; c++) {
+    stats->share[c] = stats->total
+        ? (uint8_t)((uint64_t)stats->ticks[c]*100/stats->total) : 0;
+  }
+  stats->utilization = stats->total
+      ? (uint8_t)((uint64_t)busy*100/stats->total) : 0;
+}
+
+/*!
+ *   @fn         utilization
+ *
+ *   @brief      Informa a utilização da CPU na janela deslizante, em %.
+ */
+uint8_t dsf_LoadMeter_ocp::utilization() {
+  dsf_LoadStats stats;
+
+  getStats(&stats);
+  return stats.utilization;
+}
+
+/*!
+ *   @fn         totalTicks
+ *
+ *   @brief      Informa o tempo de uma categoria desde start, em ticks.
+ */
+uint64_t dsf_LoadMeter_ocp::totalTicks(
+    LoadMeter_t::dsf_LoadCategory category) {
+  uint32_t primask = __get_PRIMASK();
+  uint64_t ticks;
+
+  __disable_irq();
+  if (clock) {
+    charge(clock->ticks());
+  }
+  ticks = totals[category];
+  __set_PRIMASK(primask);
+  return ticks;
+}
+
+/*!
+ *   @fn         dump
+ *
+ *   @brief      Escreve a carga da janela deslizante em uma linha.
+ *
+ *   Formato: "load util=37 app=30 delay=58 sleep=5 irq=7 window_us=1000000",
+ *   com as porcentagens de cada categoria.
+ *
+ *   @param[in]  putChar - função de saída de um caractere.
+ */
+void dsf_LoadMeter_ocp::dump(void (*putChar)(char)) {
+  static const char *const names[LoadMeter_t::dsf_NumCategories] = {
+    " app=", " delay=", " sleep=", " irq="
+  };
+  dsf_LoadStats stats;
+
+  getStats(&stats);
+  dsf_putText(putChar, "load util=");
+  dsf_putNumber(putChar, stats.utilization);
+  for (uint8_t c = 0; c < LoadMeter_t::dsf_NumCategories; c++) {
+    dsf_putText(putChar, names[c]);
+    dsf_putNumber(putChar, stats.share[c]);
+  }
+  dsf_putText(putChar, " window_us=");
+  dsf_putNumber(putChar,
+                clock ? (uint32_t)clock->ticksToMicros(stats.total) : 0);
+  putChar('\n');
+}
+
+/*!
+ *   @fn         charge
+ *
+ *   @brief      Atribui o tempo desde o último instante à categoria corrente.
+ *
+ *   As fatias completadas no intervalo são fechadas em ordem e a fatia
+ *   seguinte é zerada. Depois de um intervalo maior que a janela inteira,
+ *   as voltas completas são puladas: no máximo dsf_Slots + 1 fatias são
+ *   percorridas, com interrupções desabilitadas pelo chamador.
+ *
+ *   @param[in]  now - instante atual, em ticks do relógio.
+ */
+void dsf_LoadMeter_ocp::charge(uint64_t now) {
+  uint64_t skip;
+
+  totals[current] += now - since;
+  while (now >= slotEnd) {
+    slots[slot][current] += (uint32_t)(slotEnd - since);
+    since = slotEnd;
+    slotEnd += slotTicks;
+    slot = (uint8_t)((slot + 1) & (LoadMeter_t::dsf_Slots - 1));
+    for (uint8_t c = 0; c < LoadMeter_t::dsf_NumCategories; c++) {
+      slots[slot][c] = 0;
+    }
+    if (now - since > (uint64_t)slotTicks*LoadMeter_t::dsf_Slots) {
+      skip = (now - since)/slotTicks - LoadMeter_t::dsf_Slots;
+      since += skip*slotTicks;
+      slotEnd += skip*slotTicks;
+    }
+  }
+  slots[slot][current] += (uint32_t)(now - since);
+  since = now;
+}
@@ -0,0 +1,146 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Medidor de carga da CPU: atraso, sono, interrupções e
+ *              aplicação.
+ *
+ * @file        dsf_LoadMeter_ocp.h
+ * @version     1.0
+ * @date        27 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM (via dsf_SysClock_ocp).
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (27 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_LOADMETER_OCP_H_
+#define DSF_LOADMETER_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_SysClock_ocp.h"
+
+/*!
+ * Namespace de definição das categorias de tempo e da janela deslizante.
+ */
+namespace LoadMeter_t {
+  enum dsf_LoadCategory {
+    dsf_Application = 0,
+    dsf_Delay = 1,
+    dsf_Sleep = 2,
+    dsf_Interrupt = 3,
+    dsf_NumCategories = 4
+  };
+  enum dsf_LoadLimits {
+    dsf_Slots = 8
+  };
+}  // namespace LoadMeter_t
+
+/*!
+ *  @struct   dsf_LoadStats
+ *
+ *  @brief    Carga da CPU na janela deslizante.
+ *
+ *  @details  ticks e share são o tempo e a porcentagem de cada categoria;
+ *            utilization é a porcentagem de aplicação mais interrupções,
+ *            isto é, 100 menos a folga (atrasos em espera ativa e sono).
+ */
+struct dsf_LoadStats {
+  uint32_t ticks[LoadMeter_t::dsf_NumCategories];
+  uint8_t share[LoadMeter_t::dsf_NumCategories];
+  uint32_t total;
+  uint8_t utilization;
+};
+
+/*!
+ *  @class    dsf_LoadMeter_ocp
+ *
+ *  @brief    Contabiliza o tempo da CPU por categoria.
+ *
+ *  @details  O tempo é lido do dsf_SysClock_ocp e atribuído à categoria
+ *            corrente a cada troca: waitDelay entra em dsf_Delay,
+ *            dsf_Power_ocp::sleep em dsf_Sleep e os tratadores gerados
+ *            por DSF_IRQ_BIND em dsf_Interrupt, sempre restaurando a
+ *            categoria anterior na saída, de modo que interrupções
+ *            aninhadas são descontadas de quem foi interrompido e a
+ *            interrupção que acorda o WFI conta como dsf_Interrupt.
+ *
+ *            A janela deslizante tem dsf_Slots fatias de duração fixa; a
+ *            fatia mais antiga é descartada quando uma nova começa. Os
+ *            totais desde start não são descartados.
+ *
+ *            Os ganchos só existem com -DDSF_LOAD_METER; sem a macro os
+ *            drivers não têm nenhuma instrução a mais.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Janela de 8 x 125 ms sobre o relógio do TPM0.
+ *             +fn dsf_LoadMeter_ocp::start(&sysClock, 125000);
+ *             +fn power.sleep();
+ *             +fn percent = dsf_LoadMeter_ocp::utilization();
+ *             +fn dsf_LoadMeter_ocp::dump(putChar);
+ */
+class dsf_LoadMeter_ocp {
+ public:
+  /*!
+   * Métodos de controle do medidor.
+   */
+  static void start(dsf_SysClock_ocp *sysClock,
+                    uint32_t slotMicros = 125000);
+  static void stop();
+
+  /*!
+   * Métodos de troca de categoria. enter retorna a categoria anterior,
+   * que deve ser passada a leave.
+   */
+  static uint8_t enter(LoadMeter_t::dsf_LoadCategory category);
+  static void leave(uint8_t previous);
+
+  /*!
+   * Métodos de consulta e de descarga.
+   */
+  static void getStats(dsf_LoadStats *stats);
+  static uint8_t utilization();
+  static uint64_t totalTicks(LoadMeter_t::dsf_LoadCategory category);
+  static void dump(void (*putChar)(char));
+
+ private:
+  static dsf_SysClock_ocp *clock;
+  static uint8_t current;
+  static uint8_t slot;
+  static uint64_t since;
+  static uint64_t slotEnd;
+  static uint32_t slotTicks;
+  static uint32_t slots[LoadMeter_t::dsf_Slots][LoadMeter_t::dsf_NumCategories];
+  static uint64_t totals[LoadMeter_t::dsf_NumCategories];
+
+  static void charge(uint64_t now);
+};
+
+#endif  //  DSF_LOADMETER_OCP_H_
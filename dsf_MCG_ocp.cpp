@@ -0,0 +1,481 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Perfis de relógio do MCG: FEI, FEE, PEE 48 MHz e VLPR.
+ *
+ * @file        dsf_MCG_ocp.cpp
+ * @version     1.0
+ * @date        7 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   MCG, OSC0, SIM e SMC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (7 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_MCG_ocp.h"
+
+/*!
+ * Registradores do MCG e do SMC (bytes).
+ */
+#define DSF_MCG_REG(offset)  (*(volatile uint8_t *)(0x40064000 + (offset)))
+#define DSF_MCG_C1           DSF_MCG_REG(0x0)
+#define DSF_MCG_C2           DSF_MCG_REG(0x1)
+#define DSF_MCG_C5           DSF_MCG_REG(0x4)
+#define DSF_MCG_C6           DSF_MCG_REG(0x5)
+#define DSF_MCG_S            DSF_MCG_REG(0x6)
+#define DSF_MCG_SC           DSF_MCG_REG(0x8)
+#define DSF_SMC_PMPROT       (*(volatile uint8_t *)0x4007E000)
+#define DSF_SMC_PMCTRL       (*(volatile uint8_t *)0x4007E001)
+#define DSF_SMC_PMSTAT       (*(volatile uint8_t *)0x4007E003)
+
+namespace {
+
+/*!
+ * Campos de MCG_C1, MCG_C2, MCG_C6 e MCG_S (pág. 374 a 382).
+ */
+const uint8_t kCLKSMask = 3u << 6;
+const uint8_t kCLKSInternal = 1u << 6;
+const uint8_t kCLKSExternal = 2u << 6;
+const uint8_t kFRDIV256 = 3u << 3;
+const uint8_t kIREFS = 1u << 2;
+const uint8_t kIRCLKEN = 1u << 1;
+const uint8_t kLOCRE0 = 1u << 7;
+const uint8_t kRANGE0VeryHigh = 2u << 4;
+const uint8_t kEREFS0 = 1u << 2;
+const uint8_t kLP = 1u << 1;
+const uint8_t kIRCS = 1u << 0;
+const uint8_t kPLLS = 1u << 6;
+const uint8_t kLOCK0 = 1u << 6;
+const uint8_t kPLLST = 1u << 5;
+const uint8_t kIREFST = 1u << 4;
+const uint8_t kCLKSTMask = 3u << 2;
+const uint8_t kCLKSTFLL = 0u << 2;
+const uint8_t kCLKSTInternal = 1u << 2;
+const uint8_t kCLKSTExternal = 2u << 2;
+const uint8_t kCLKSTPLL = 3u << 2;
+const uint8_t kOSCINIT0 = 1u << 1;
+const uint8_t kIRCST = 1u << 0;
+
+/*!
+ * PLL: 8 MHz / (PRDIV0 + 1) = 4 MHz de referência, x (VDIV0 + 24) = 96 MHz.
+ */
+const uint8_t kPRDIV0 = 1;
+const uint8_t kVDIV0 = 0;
+
+/*!
+ * SMC: AVLP | ALLS em PMPROT, RUNM em PMCTRL e os estados de PMSTAT.
+ */
+const uint8_t kPMPROT = (1u << 5) | (1u << 3);
+const uint8_t kRUNMMask = 3u << 5;
+const uint8_t kRUNMVLPR = 2u << 5;
+const uint8_t kStatRUN = 0x01;
+const uint8_t kStatVLPR = 0x04;
+
+const uint32_t kPLLFLLSEL = 1u << 16;
+const uint32_t kSpinLimit = 100000;
+
+/*!
+ * Frequências e divisores de cada perfil, na ordem de MCG_t::dsf_Profile.
+ * clkdiv1 é OUTDIV1 (bits 31..28, núcleo) e OUTDIV4 (bits 18..16,
+ * barramento e flash, dividindo o núcleo).
+ */
+struct Profile {
+  uint32_t coreHz;
+  uint32_t busHz;
+  uint32_t timerHz;
+  uint32_t source;
+  uint32_t clkdiv1;
+};
+
+const Profile kProfiles[MCG_t::dsf_NumProfiles] = {
+  {20971520, 10485760, 20971520, 1, 0x00010000},
+  {20000000, 10000000, 20000000, 1, 0x00010000},
+  {48000000, 24000000, 48000000, 1, 0x10010000},
+  {4000000, 800000, 4000000, 3, 0x00040000}
+};
+
+}  // namespace
+
+MCG_t::dsf_Profile dsf_MCG_ocp::current = MCG_t::dsf_FEI;
+dsf_ClockListener dsf_MCG_ocp::listeners[MCG_t::dsf_MaxListeners];
+void *dsf_MCG_ocp::arguments[MCG_t::dsf_MaxListeners];
+uint32_t dsf_MCG_ocp::trimFactor = MCG_t::dsf_TrimOne;
+uint32_t dsf_MCG_ocp::trimmedCoreHz = 20971520;
+uint32_t dsf_MCG_ocp::trimmedBusHz = 10485760;
+uint32_t dsf_MCG_ocp::trimmedTimerHz = 20971520;
+
+/*!
+ *   @fn         setProfile
+ *
+ *   @brief      Troca o perfil de relógio e avisa os observadores.
+ *
+ *   A troca é feita com as interrupções desabilitadas, para que nenhum
+ *   tratador veja as frequências de um perfil com o relógio de outro; o
+ *   lock do PLL leva até 1 ms.
+ *
+ *   @param[in]  profile - perfil desejado.
+ *
+ *   @return     false se o perfil não foi alcançado; o MCG fica em FEI.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - MCG_C1 a MCG_S: Multipurpose Clock Generator. Pág. 374.
+ *               - SIM_SOPT2: System Options Register 2. Pág. 195.
+ *               - SIM_CLKDIV1: System Clock Divider Register 1. Pág. 215.
+ *               - SMC_PMCTRL, SMC_PMSTAT: System Mode Controller. Pág. 221.
+ */
+bool dsf_MCG_ocp::setProfile(MCG_t::dsf_Profile profile) {
+  uint32_t primask;
+  bool reached;
+
+  if (profile >= MCG_t::dsf_NumProfiles) {
+    return false;
+  }
+  primask = __get_PRIMASK();
+  __disable_irq();
+  reached = toFEI();
+  if (reached && profile == MCG_t::dsf_FEE) {
+    reached = toFEE();
+  } else if (reached && profile == MCG_t::dsf_PEE48) {
+    reached = toPEE();
+  } else if (reached && profile == MCG_t::dsf_VLPR) {
+    reached = toBLPI();
+  }
+  if (!reached) {
+    toFEI();
+    profile = MCG_t::dsf_FEI;
+  }
+  SIM_SOPT2 = (SIM_SOPT2 & ~(kPLLFLLSEL | SIM_SOPT2_TPMSRC_MASK
+                             | SIM_SOPT2_UART0SRC_MASK))
+              | (profile == MCG_t::dsf_PEE48 ? kPLLFLLSEL : 0)
+              | SIM_SOPT2_TPMSRC(kProfiles[profile].source)
+              | SIM_SOPT2_UART0SRC(kProfiles[profile].source);
+  current = profile;
+  trimFactor = MCG_t::dsf_TrimOne;
+  applyTrim();
+  notify();
+  __set_PRIMASK(primask);
+  return reached;
+}
+
+/*!
+ *   @fn         profile
+ *
+ *   @brief      Informa o perfil atual.
+ */
+MCG_t::dsf_Profile dsf_MCG_ocp::profile() {
+  return current;
+}
+
+/*!
+ *   @fn         resume
+ *
+ *   @brief      Volta ao PEE depois de um modo de parada.
+ *
+ *   Ao entrar em VLPS ou LLS a partir do PEE (PLLSTEN0 = 0), o MCG sai em
+ *   PBE, com CLKS = 10: o núcleo roda no cristal até o lock do PLL e a
+ *   volta a CLKS = 00. Nos outros perfis não há o que fazer.
+ */
+void dsf_MCG_ocp::resume() {
+  if (current != MCG_t::dsf_PEE48
+      || (DSF_MCG_S & kCLKSTMask) == kCLKSTPLL) {
+    return;
+  }
+  waitStatus(kLOCK0, kLOCK0);
+  DSF_MCG_C1 = DSF_MCG_C1 & ~kCLKSMask;
+  waitStatus(kCLKSTMask, kCLKSTPLL);
+}
+
+/*!
+ *   @fn         coreHz
+ *
+ *   @brief      Informa a frequência do núcleo e do SysTick, em Hz.
+ */
+uint32_t dsf_MCG_ocp::coreHz() {
+  return trimmedCoreHz;
+}
+
+/*!
+ *   @fn         busHz
+ *
+ *   @brief      Informa a frequência do barramento e da flash, em Hz.
+ */
+uint32_t dsf_MCG_ocp::busHz() {
+  return trimmedBusHz;
+}
+
+/*!
+ *   @fn         timerHz
+ *
+ *   @brief      Informa a frequência de contagem dos TPMs e da UART0, em Hz.
+ */
+uint32_t dsf_MCG_ocp::timerHz() {
+  return trimmedTimerHz;
+}
+
+/*!
+ *   @fn         timerSource
+ *
+ *   @brief      Informa o valor de TPMSRC e UART0SRC do perfil atual.
+ */
+uint32_t dsf_MCG_ocp::timerSource() {
+  return kProfiles[current].source;
+}
+
+/*!
+ *   @fn         setTrim
+ *
+ *   @brief      Ajusta a correção das frequências do perfil atual.
+ *
+ *   Como em setProfile, os observadores são chamados depois da mudança,
+ *   com as interrupções desabilitadas. Pode ser chamado por um tratador
+ *   de interrupção.
+ *
+ *   @param[in]  factor - frequência real dividida pela nominal, em ponto
+ *               fixo 8.24 (MCG_t::dsf_TrimOne = 1,0).
+ */
+void dsf_MCG_ocp::setTrim(uint32_t factor) {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  trimFactor = factor;
+  applyTrim();
+  notify();
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         trim
+ *
+ *   @brief      Informa a correção atual, em ponto fixo 8.24.
+ */
+uint32_t dsf_MCG_ocp::trim() {
+  return trimFactor;
+}
+
+/*!
+ *   @fn         nominalTimerHz
+ *
+ *   @brief      Informa a frequência nominal dos TPMs no perfil atual, sem
+ *               a correção.
+ */
+uint32_t dsf_MCG_ocp::nominalTimerHz() {
+  return kProfiles[current].timerHz;
+}
+
+/*!
+ *   @fn         subscribe
+ *
+ *   @brief      Registra um observador das mudanças de perfil.
+ *
+ *   O observador é chamado com as interrupções desabilitadas, depois da
+ *   troca, e não deve chamar setProfile.
+ *
+ *   @return     false se já há dsf_MaxListeners observadores.
+ */
+bool dsf_MCG_ocp::subscribe(dsf_ClockListener listener, void *argument) {
+  int8_t free = -1;
+
+  for (uint8_t i = 0; i < MCG_t::dsf_MaxListeners; i++) {
+    if (listeners[i] == listener && arguments[i] == argument) {
+      return true;
+    }
+    if (!listeners[i] && free < 0) {
+      free = (int8_t)i;
+    }
+  }
+  if (free < 0) {
+    return false;
+  }
+  arguments[free] = argument;
+  listeners[free] = listener;
+  return true;
+}
+
+/*!
+ *   @fn         unsubscribe
+ *
+ *   @brief      Remove um observador registrado.
+ */
+void dsf_MCG_ocp::unsubscribe(dsf_ClockListener listener, void *argument) {
+  for (uint8_t i = 0; i < MCG_t::dsf_MaxListeners; i++) {
+    if (listeners[i] == listener && arguments[i] == argument) {
+      listeners[i] = 0;
+    }
+  }
+}
+
+/*!
+ *   @fn         applyTrim
+ *
+ *   @brief      Calcula as frequências do perfil atual com a correção,
+ *               arredondadas para o Hz mais próximo.
+ */
+void dsf_MCG_ocp::applyTrim() {
+  const Profile &nominal = kProfiles[current];
+
+  trimmedCoreHz = (uint32_t)(((uint64_t)nominal.coreHz*trimFactor
+                              + (MCG_t::dsf_TrimOne >> 1)) >> 24);
+  trimmedBusHz = (uint32_t)(((uint64_t)nominal.busHz*trimFactor
+                             + (MCG_t::dsf_TrimOne >> 1)) >> 24);
+  trimmedTimerHz = (uint32_t)(((uint64_t)nominal.timerHz*trimFactor
+                               + (MCG_t::dsf_TrimOne >> 1)) >> 24);
+}
+
+/*!
+ *   @fn         notify
+ *
+ *   @brief      Chama os observadores registrados.
+ */
+void dsf_MCG_ocp::notify() {
+  for (uint8_t i = 0; i < MCG_t::dsf_MaxListeners; i++) {
+    if (listeners[i]) {
+      listeners[i](arguments[i]);
+    }
+  }
+}
+
+/*!
+ *   @fn         waitStatus
+ *
+ *   @brief      Espera os bits mask de MCG_S assumirem value.
+ */
+bool dsf_MCG_ocp::waitStatus(uint8_t mask, uint8_t value) {
+  for (uint32_t spin = 0; spin < kSpinLimit; spin++) {
+    if ((DSF_MCG_S & mask) == value) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+ *   @fn         toFEI
+ *
+ *   @brief      Volta ao FEI de qualquer perfil.
+ *
+ *   VLPR volta a RUN antes de qualquer mudança do MCG; PEE passa por PBE
+ *   e FBE, BLPI por FBI. O oscilador é desligado no fim.
+ */
+bool dsf_MCG_ocp::toFEI() {
+  if (DSF_SMC_PMSTAT == kStatVLPR) {
+    DSF_SMC_PMCTRL = DSF_SMC_PMCTRL & ~kRUNMMask;
+    for (uint32_t spin = 0; DSF_SMC_PMSTAT != kStatRUN; spin++) {
+      if (spin == kSpinLimit) {
+        return false;
+      }
+    }
+  }
+  if ((DSF_MCG_S & kCLKSTMask) == kCLKSTPLL) {
+    DSF_MCG_C1 = (DSF_MCG_C1 & ~kCLKSMask) | kCLKSExternal;
+    if (!waitStatus(kCLKSTMask, kCLKSTExternal)) {
+      return false;
+    }
+  }
+  DSF_MCG_C6 = DSF_MCG_C6 & ~kPLLS;
+  DSF_MCG_C2 = DSF_MCG_C2 & ~kLP;
+  DSF_MCG_C1 = kIREFS;
+  if (!waitStatus(kIREFST | kCLKSTMask, kIREFST | kCLKSTFLL)) {
+    return false;
+  }
+  DSF_MCG_C2 = kLOCRE0;
+  SIM_CLKDIV1 = kProfiles[MCG_t::dsf_FEI].clkdiv1;
+  return true;
+}
+
+/*!
+ *   @fn         toFEE
+ *
+ *   @brief      FEI -> FEE: FLL no cristal de 8 MHz / 256 = 31,25 kHz.
+ */
+bool dsf_MCG_ocp::toFEE() {
+  DSF_MCG_C2 = kRANGE0VeryHigh | kEREFS0;
+  if (!waitStatus(kOSCINIT0, kOSCINIT0)) {
+    return false;
+  }
+  DSF_MCG_C1 = kFRDIV256;
+  if (!waitStatus(kIREFST | kCLKSTMask, kCLKSTFLL)) {
+    return false;
+  }
+  SIM_CLKDIV1 = kProfiles[MCG_t::dsf_FEE].clkdiv1;
+  return true;
+}
+
+/*!
+ *   @fn         toPEE
+ *
+ *   @brief      FEI -> FBE -> PBE -> PEE com o PLL em 96 MHz.
+ *
+ *   Os divisores do núcleo e do barramento são ajustados antes, para
+ *   que o núcleo nunca passe de 48 MHz.
+ */
+bool dsf_MCG_ocp::toPEE() {
+  SIM_CLKDIV1 = kProfiles[MCG_t::dsf_PEE48].clkdiv1;
+  DSF_MCG_C2 = kRANGE0VeryHigh | kEREFS0;
+  if (!waitStatus(kOSCINIT0, kOSCINIT0)) {
+    return false;
+  }
+  DSF_MCG_C1 = kCLKSExternal | kFRDIV256;
+  if (!waitStatus(kIREFST | kCLKSTMask, kCLKSTExternal)) {
+    return false;
+  }
+  DSF_MCG_C5 = kPRDIV0;
+  DSF_MCG_C6 = kPLLS | kVDIV0;
+  if (!waitStatus(kPLLST | kLOCK0, kPLLST | kLOCK0)) {
+    return false;
+  }
+  DSF_MCG_C1 = kFRDIV256;
+  return waitStatus(kCLKSTMask, kCLKSTPLL);
+}
+
+/*!
+ *   @fn         toBLPI
+ *
+ *   @brief      FEI -> FBI -> BLPI no IRC de 4 MHz e RUN -> VLPR.
+ *
+ *   VLPR exige núcleo até 4 MHz e barramento até 1 MHz: OUTDIV4 = /5.
+ */
+bool dsf_MCG_ocp::toBLPI() {
+  SIM_CLKDIV1 = kProfiles[MCG_t::dsf_VLPR].clkdiv1;
+  DSF_MCG_SC = 0;
+  DSF_MCG_C2 = kLOCRE0 | kIRCS;
+  DSF_MCG_C1 = kCLKSInternal | kIREFS | kIRCLKEN;
+  if (!waitStatus(kIREFST | kCLKSTMask | kIRCST,
+                  kIREFST | kCLKSTInternal | kIRCST)) {
+    return false;
+  }
+  DSF_MCG_C2 = kLOCRE0 | kIRCS | kLP;
+  DSF_SMC_PMPROT = kPMPROT;
+  DSF_SMC_PMCTRL = (DSF_SMC_PMCTRL & ~kRUNMMask) | kRUNMVLPR;
+  for (uint32_t spin = 0; DSF_SMC_PMSTAT != kStatVLPR; spin++) {
+    if (spin == kSpinLimit) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,186 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Perfis de relógio do MCG: FEI, FEE, PEE 48 MHz e VLPR.
+ *
+ * @file        dsf_MCG_ocp.h
+ * @version     1.0
+ * @date        7 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   MCG, OSC0, SIM e SMC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (7 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_MCG_OCP_H_
+#define DSF_MCG_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+
+/*!
+ * Namespace de definição dos perfis de relógio, do número de observadores
+ * das mudanças de perfil e da correção unitária (ponto fixo 8.24).
+ */
+namespace MCG_t {
+  enum dsf_Profile {
+    dsf_FEI = 0,
+    dsf_FEE = 1,
+    dsf_PEE48 = 2,
+    dsf_VLPR = 3,
+    dsf_NumProfiles = 4
+  };
+  enum dsf_MCGLimits {
+    dsf_MaxListeners = 4
+  };
+  enum dsf_Trim {
+    dsf_TrimOne = 0x01000000
+  };
+}  // namespace MCG_t
+
+/*!
+ * Observador chamado depois de cada mudança de perfil.
+ */
+typedef void (*dsf_ClockListener)(void *argument);
+
+/*!
+ *  @class    dsf_MCG_ocp
+ *
+ *  @brief    Classe de configuração do relógio do núcleo, do barramento e
+ *            dos TPMs e da UART0.
+ *
+ *  @details  Perfis (núcleo / barramento / TPM e UART0):
+ *            - dsf_FEI: FLL no IRC de 32768 Hz, o modo de reset
+ *              (20,97 / 10,49 / 20,97 MHz).
+ *            - dsf_FEE: FLL no cristal de 8 MHz da placa dividido por 256
+ *              (20 / 10 / 20 MHz).
+ *            - dsf_PEE48: PLL de 96 MHz no cristal (48 / 24 / 48 MHz, o
+ *              TPM e a UART0 com MCGPLLCLK/2), 2,3 vezes o FEI.
+ *            - dsf_VLPR: BLPI no IRC rápido de 4 MHz e o SMC em VLPR
+ *              (4 / 0,8 / 4 MHz, o TPM e a UART0 com MCGIRCLK).
+ *
+ *            setProfile passa sempre pelo FEI, de modo que cada perfil é
+ *            alcançado por um único caminho de modos válidos do MCG, e
+ *            espera cada mudança nos bits de estado de MCG_S. Depois da
+ *            troca, os observadores registrados com subscribe são
+ *            chamados: a UART0 recalcula os divisores, o SysClock guarda
+ *            o tempo já contado e o Profiler reprograma o SysTick.
+ *
+ *            Os demais drivers consultam timerHz e coreHz a cada
+ *            conversão, de modo que as conversões entre ticks e tempo
+ *            seguem o perfil atual; um TPM em andamento (dsf_Delay_ocp,
+ *            dsf_ADC_ocp, dsf_BCM_ocp) passa a contar na nova frequência.
+ *
+ *            As frequências informadas são as nominais do perfil vezes a
+ *            correção de setTrim, a razão medida/nominal em ponto fixo
+ *            8.24 mantida pelo dsf_Calibration_ocp. Os IRCs, e com eles o
+ *            FLL no FEI, variam alguns por cento entre placas e com a
+ *            temperatura. Uma nova correção também chama os observadores;
+ *            setProfile volta à correção unitária, pois a fonte muda.
+ *
+ *            Em VLPR a flash não pode ser gravada (dsf_Flash_ocp) e o MCG
+ *            não pode mudar: setProfile volta antes a RUN. Ao sair de VLPS
+ *            ou LLS a partir do PEE o MCG fica em PBE, e dsf_Power_ocp
+ *            chama resume para voltar ao PEE. PMPROT é de escrita única e
+ *            é gravado com AVLP e ALLS, o mesmo valor do dsf_Power_ocp.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Execução a 48 MHz e volta ao modo de reset.
+ *             +fn dsf_MCG_ocp::setProfile(MCG_t::dsf_PEE48);
+ *             +fn dsf_MCG_ocp::setProfile(MCG_t::dsf_FEI);
+ *
+ *            Conversão de um intervalo medido em ticks do TPM com Div128.
+ *             +fn us = (uint64_t)ticks*128*1000000/dsf_MCG_ocp::timerHz();
+ *
+ *            FLL medido 1,5% acima do nominal.
+ *             +fn dsf_MCG_ocp::setTrim(MCG_t::dsf_TrimOne
+ *                                      + MCG_t::dsf_TrimOne/200*3);
+ */
+class dsf_MCG_ocp {
+ public:
+  /*!
+   * Métodos de troca e consulta do perfil.
+   */
+  static bool setProfile(MCG_t::dsf_Profile profile);
+  static MCG_t::dsf_Profile profile();
+  static void resume();
+
+  /*!
+   * Métodos de consulta das frequências do perfil atual, em Hz, e da
+   * seleção TPMSRC/UART0SRC correspondente.
+   */
+  static uint32_t coreHz();
+  static uint32_t busHz();
+  static uint32_t timerHz();
+  static uint32_t timerSource();
+
+  /*!
+   * Métodos da correção das frequências e da frequência nominal dos TPMs,
+   * sem a correção.
+   */
+  static void setTrim(uint32_t factor);
+  static uint32_t trim();
+  static uint32_t nominalTimerHz();
+
+  /*!
+   * Métodos de registro dos observadores das mudanças de perfil.
+   */
+  static bool subscribe(dsf_ClockListener listener, void *argument);
+  static void unsubscribe(dsf_ClockListener listener, void *argument);
+
+ private:
+  /*!
+   * Perfil atual e observadores registrados.
+   */
+  static MCG_t::dsf_Profile current;
+  static dsf_ClockListener listeners[MCG_t::dsf_MaxListeners];
+  static void *arguments[MCG_t::dsf_MaxListeners];
+  /*!
+   * Correção atual e frequências do perfil com ela aplicada.
+   */
+  static uint32_t trimFactor;
+  static uint32_t trimmedCoreHz;
+  static uint32_t trimmedBusHz;
+  static uint32_t trimmedTimerHz;
+
+  static void applyTrim();
+  static void notify();
+  /*!
+   * Métodos privados de transição entre os modos do MCG: false se o
+   * estado esperado não aparece em MCG_S (cristal ausente, PLL sem lock).
+   */
+  static bool waitStatus(uint8_t mask, uint8_t value);
+  static bool toFEI();
+  static bool toFEE();
+  static bool toPEE();
+  static bool toBLPI();
+};
+
+#endif  //  DSF_MCG_OCP_H_
@@ -0,0 +1,447 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Gerenciador dos modos de baixo consumo VLPS e LLS.
+ *
+ * @file        dsf_Power_ocp.cpp
+ * @version     1.0
+ * @date        6 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   SMC, LLWU, LPTMR e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (6 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_Power_ocp.h"
+#include "dsf_Text_ocp.h"
+#include "dsf_BME_ocp.h"
+#include "dsf_ClockGate_ocp.h"
+#ifdef DSF_LOAD_METER
+#include "dsf_LoadMeter_ocp.h"
+#endif
+
+/*!
+ * Registradores de 8 bits do SMC e do LLWU e de 32 bits do LPTMR0. O CNR
+ * só é lido depois de uma escrita, que captura a contagem.
+ */
+#define DSF_SMC_PMPROT  (*(volatile uint8_t *)0x4007E000)
+#define DSF_SMC_PMCTRL  (*(volatile uint8_t *)0x4007E001)
+#define DSF_LLWU_PE(n)  (*(volatile uint8_t *)(0x4007C000 + (n)))
+#define DSF_LLWU_ME     (*(volatile uint8_t *)0x4007C004)
+#define DSF_LLWU_F1     (*(volatile uint8_t *)0x4007C005)
+#define DSF_LLWU_F2     (*(volatile uint8_t *)0x4007C006)
+#define DSF_LPTMR_CSR   (*(volatile uint32_t *)0x40040000)
+#define DSF_LPTMR_PSR   (*(volatile uint32_t *)0x40040004)
+#define DSF_LPTMR_CMR   (*(volatile uint32_t *)0x40040008)
+#define DSF_LPTMR_CNR   (*(volatile uint32_t *)0x4004000C)
+
+namespace {
+
+/*!
+ * Campos do SMC_PMPROT (AVLP, ALLS) e do SMC_PMCTRL (STOPA e STOPM),
+ * do LPTMR0_CSR (TCF, TIE, TEN) e do LPTMR0_PSR (PBYP, PCS = LPO).
+ */
+const uint8_t kAVLP = 1u << 5;
+const uint8_t kALLS = 1u << 3;
+const uint8_t kSTOPA = 1u << 3;
+const uint8_t kStopVLPS = 2;
+const uint8_t kStopLLS = 3;
+const uint32_t kTCF = 1u << 7;
+const uint32_t kTIE = 1u << 6;
+const uint32_t kTEN = 1u << 0;
+const uint32_t kLPO = (1u << 2) | 1u;
+
+}  // namespace
+
+/*!
+ *   @fn         dsf_Power_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Nenhum registrador é acessado antes de start.
+ */
+dsf_Power_ocp::dsf_Power_ocp() {
+  deepestState = Power_t::dsf_VLPS;
+  wakePin = Power_t::dsf_NoWakePin;
+  started = false;
+  delayCount = 0;
+  sysClock = 0;
+  for (uint8_t s = 0; s < Power_t::dsf_NumStates; s++) {
+    micros[s] = 0;
+    sleeps[s] = 0;
+  }
+  for (uint8_t w = 0; w < Power_t::dsf_NumSources; w++) {
+    wakes[w] = 0;
+  }
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Libera os modos de parada e inicia a contagem do tempo.
+ *
+ *   O PMPROT só aceita a primeira escrita após o reset; VLPS e LLS são
+ *   liberados juntos e o modo usado é escolhido por deepest. O LPTMR
+ *   passa a contar o LPO e o tempo em dsf_Run é contado a partir daqui.
+ *
+ *   @param[in]  deepest - dsf_Run (só WFI), dsf_VLPS ou dsf_LLS.
+ *               pin - pino do LLWU que acorda do LLS.
+ *               edge - borda do pino que acorda.
+ *
+ *   @remarks    Siglas do Manual de Referência KL25:
+ *               - SMC_PMPROT: Power Mode Protection Register.
+ *               - LLWU_PEn: Pin Enable Registers; LLWU_ME: Module Enable.
+ *               - LPTMR0_PSR: Prescale Register. Pág. 594.
+ */
+void dsf_Power_ocp::start(Power_t::dsf_PowerState deepest,
+                          Power_t::dsf_LLWUPin pin,
+                          Power_t::dsf_WakeEdge edge) {
+  uint8_t shift;
+
+  stop();
+  deepestState = deepest;
+  wakePin = pin;
+  DSF_SMC_PMPROT = kAVLP | kALLS;
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_LPTMR);
+  DSF_LPTMR_CSR = 0;
+  DSF_LPTMR_PSR = kLPO;
+  runCounter();
+
+  /*!
+   * O LPTMR é o módulo 0 do LLWU; o pino acorda na borda escolhida.
+   */
+  if (pin != Power_t::dsf_NoWakePin) {
+    shift = (uint8_t)(2*(pin & 3));
+    dsf_BME_ocp::insertField(&DSF_LLWU_PE(pin >> 2), shift, 2, edge);
+  }
+  dsf_BME_ocp::setBits(&DSF_LLWU_ME, 1u);
+  DSF_LLWU_F1 = 0xFF;
+  DSF_LLWU_F2 = 0xFF;
+
+  for (uint8_t s = 0; s < Power_t::dsf_NumStates; s++) {
+    micros[s] = 0;
+    sleeps[s] = 0;
+  }
+  for (uint8_t w = 0; w < Power_t::dsf_NumSources; w++) {
+    wakes[w] = 0;
+  }
+  started = true;
+  NVIC_ClearPendingIRQ(LPTimer_IRQn);
+  NVIC_EnableIRQ(LPTimer_IRQn);
+  if (deepest == Power_t::dsf_LLS) {
+    NVIC_ClearPendingIRQ(LLW_IRQn);
+    NVIC_EnableIRQ(LLW_IRQn);
+  }
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para o LPTMR, desliga o pino do LLWU e libera o clock.
+ */
+void dsf_Power_ocp::stop() {
+  if (!started) {
+    return;
+  }
+  started = false;
+  NVIC_DisableIRQ(LPTimer_IRQn);
+  NVIC_DisableIRQ(LLW_IRQn);
+  DSF_LPTMR_CSR = 0;
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_LPTMR);
+  if (wakePin != Power_t::dsf_NoWakePin) {
+    dsf_BME_ocp::clearBits(&DSF_LLWU_PE(wakePin >> 2),
+                           3u << 2*(wakePin & 3));
+  }
+  dsf_BME_ocp::clearBits(&DSF_LLWU_ME, 1u);
+}
+
+/*!
+ *   @fn         track
+ *
+ *   @brief      Registra uma temporização a ser preservada durante o sono.
+ *
+ *   @param[in]  delay - objeto dsf_Delay_ocp, global.
+ *
+ *   @return     false se já há dsf_MaxDelays temporizações registradas.
+ */
+bool dsf_Power_ocp::track(dsf_Delay_ocp *delay) {
+  for (uint8_t d = 0; d < delayCount; d++) {
+    if (delays[d] == delay) {
+      return true;
+    }
+  }
+  if (delayCount == Power_t::dsf_MaxDelays) {
+    return false;
+  }
+  delays[delayCount++] = delay;
+  return true;
+}
+
+/*!
+ *   @fn         track
+ *
+ *   @brief      Registra o relógio do sistema, que para com o TPM no sono.
+ *
+ *   @param[in]  clock - objeto dsf_SysClock_ocp, global; 0 desfaz o
+ *                       registro.
+ */
+void dsf_Power_ocp::track(dsf_SysClock_ocp *clock) {
+  sysClock = clock;
+}
+
+/*!
+ *   @fn         sleep
+ *
+ *   @brief      Dorme até o timeout, o fim de uma temporização registrada
+ *               ou uma interrupção.
+ *
+ *   O sono é programado com as interrupções mascaradas: uma interrupção
+ *   que chega antes do WFI faz o WFI retornar sem dormir (STOPA) e os
+ *   tratadores só executam depois que o tempo foi contabilizado e as
+ *   temporizações corrigidas.
+ *
+ *   O tempo dormido em VLPS ou LLS é somado ao relógio registrado ainda
+ *   no trecho mascarado. Com -DDSF_LOAD_METER, esse trecho é
+ *   contabilizado como dsf_Sleep, já com o tempo somado; o tratador que
+ *   acorda o núcleo executa depois e conta como dsf_Interrupt.
+ *
+ *   O LPTMR conta ticks inteiros do LPO, com fase qualquer em relação ao
+ *   início: no despertar pelo LPTMR o tempo real está entre ms - 1 e ms e
+ *   é estimado em ms - 0,5; nos demais, em ticks contados.
+ *
+ *   @param[in]  timeoutMs - tempo máximo de sono, em ms (0: só as
+ *                           temporizações registradas ou 65,5 s).
+ *
+ *   @return     Power_t::dsf_WakeSource.
+ *
+ *   @remarks    Siglas do Manual de Referência KL25 e do ARMv6-M:
+ *               - SMC_PMCTRL: Power Mode Control Register (STOPM, STOPA).
+ *               - LPTMR0_CMR e LPTMR0_CNR: Compare e Counter Registers.
+ *                 Pág. 595.
+ *               - SCR: System Control Register (SLEEPDEEP). B3.2.7.
+ */
+uint8_t dsf_Power_ocp::sleep(uint32_t timeoutMs) {
+  uint32_t ms = Power_t::dsf_MaxSleepMs;
+  uint32_t remaining, primask, ticks, flags, elapsed;
+  uint8_t source, stopMode;
+  bool fired, aborted, stopped;
+#ifdef DSF_LOAD_METER
+  uint8_t loadPrevious;
+#endif
+
+  if (!started) {
+    return Power_t::dsf_WakeNone;
+  }
+  if (timeoutMs && timeoutMs < ms) {
+    ms = timeoutMs;
+  }
+  for (uint8_t d = 0; d < delayCount; d++) {
+    if (delays[d]->remainingDelay(&remaining)) {
+      if (remaining < 1000) {
+        return Power_t::dsf_WakeNone;
+      }
+      if (remaining/1000 < ms) {
+        ms = remaining/1000;
+      }
+    }
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  micros[Power_t::dsf_Run] += (uint64_t)chargeRun()*1000;
+#ifdef DSF_LOAD_METER
+  loadPrevious = dsf_LoadMeter_ocp::enter(LoadMeter_t::dsf_Sleep);
+#endif
+
+  /*!
+   * TCF (e o despertar) depois de ms ticks: CMR = ms - 1 com TFC = 0.
+   */
+  DSF_LPTMR_CSR = 0;
+  DSF_LPTMR_CMR = ms - 1;
+  DSF_LPTMR_CSR = kTIE | kTEN;
+
+  if (deepestState != Power_t::dsf_Run) {
+    stopMode = deepestState == Power_t::dsf_LLS ? kStopLLS : kStopVLPS;
+    dsf_BME_ocp::insertField(&DSF_SMC_PMCTRL, 0, 3, stopMode);
+    /*!
+     * A leitura garante que a escrita terminou antes do WFI.
+     */
+    (void)DSF_SMC_PMCTRL;
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+  }
+  __DSB();
+  __WFI();
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+  dsf_MCG_ocp::resume();
+
+  aborted = deepestState != Power_t::dsf_Run && (DSF_SMC_PMCTRL & kSTOPA);
+  fired = (DSF_LPTMR_CSR & kTCF) != 0;
+  DSF_LPTMR_CNR = 0;
+  ticks = DSF_LPTMR_CNR & 0xFFFF;
+  flags = DSF_LLWU_F1 | (uint32_t)DSF_LLWU_F2 << 8;
+  DSF_LLWU_F1 = 0xFF;
+  DSF_LLWU_F2 = 0xFF;
+  runCounter();
+  stopped = !aborted && deepestState != Power_t::dsf_Run;
+  elapsed = fired ? (ms + ticks)*1000 - 500 : ticks*1000;
+  if (stopped && sysClock) {
+    sysClock->resume(elapsed);
+  }
+#ifdef DSF_LOAD_METER
+  dsf_LoadMeter_ocp::leave(loadPrevious);
+#endif
+  __set_PRIMASK(primask);
+
+  if (!stopped) {
+    sleeps[Power_t::dsf_Run] += aborted ? 1 : 0;
+    micros[Power_t::dsf_Run] += (uint64_t)((fired ? ms : 0) + ticks)*1000;
+    source = fired ? Power_t::dsf_WakeTimer : Power_t::dsf_WakeIrq;
+    wakes[source]++;
+    return source;
+  }
+  micros[deepestState] += elapsed;
+  sleeps[deepestState]++;
+  source = fired ? Power_t::dsf_WakeTimer
+                 : flags ? Power_t::dsf_WakePin : Power_t::dsf_WakeIrq;
+  wakes[source]++;
+  for (uint8_t d = 0; d < delayCount; d++) {
+    delays[d]->resumeDelay(elapsed);
+  }
+  return source;
+}
+
+/*!
+ *   @fn         irqHandler
+ *
+ *   @brief      Apaga as flags do LPTMR e do LLWU.
+ *
+ *   sleep já trata o despertar com as interrupções mascaradas; o
+ *   tratador só executa com um pedido que ficou pendente no NVIC e apaga
+ *   as flags que ainda estiverem ligadas.
+ */
+void dsf_Power_ocp::irqHandler() {
+  if (!started) {
+    return;
+  }
+  if ((DSF_LPTMR_CSR & (kTCF | kTIE)) == (kTCF | kTIE)) {
+    DSF_LPTMR_CSR = (DSF_LPTMR_CSR & ~kTIE) | kTCF;
+  }
+  DSF_LLWU_F1 = 0xFF;
+  DSF_LLWU_F2 = 0xFF;
+}
+
+/*!
+ *   @fn         getStats
+ *
+ *   @brief      Copia o tempo em cada estado e as contagens desde start.
+ */
+void dsf_Power_ocp::getStats(dsf_PowerStats *stats) {
+  uint64_t run = micros[Power_t::dsf_Run];
+
+  if (started) {
+    run += (uint64_t)chargeRun()*1000;
+  }
+  for (uint8_t s = 0; s < Power_t::dsf_NumStates; s++) {
+    stats->ms[s] = (uint32_t)((s == Power_t::dsf_Run ? run : micros[s])/1000);
+    stats->sleeps[s] = sleeps[s];
+  }
+  for (uint8_t w = 0; w < Power_t::dsf_NumSources; w++) {
+    stats->wakes[w] = wakes[w];
+  }
+}
+
+/*!
+ *   @fn         dump
+ *
+ *   @brief      Escreve o tempo em cada estado e os despertares em uma
+ *               linha.
+ *
+ *   Formato: "power run_ms=12 vlps_ms=3988 lls_ms=0 aborted=0 vlps=10
+ *   lls=0 timer=9 pin=0 irq=1".
+ *
+ *   @param[in]  putChar - função de saída de um caractere.
+ */
+void dsf_Power_ocp::dump(void (*putChar)(char)) {
+  static const char *const times[Power_t::dsf_NumStates] = {
+    "power run_ms=", " vlps_ms=", " lls_ms="
+  };
+  static const char *const counts[Power_t::dsf_NumStates] = {
+    " aborted=", " vlps=", " lls="
+  };
+  static const char *const sources[Power_t::dsf_NumSources] = {
+    0, " timer=", " pin=", " irq="
+  };
+  dsf_PowerStats stats;
+
+  getStats(&stats);
+  for (uint8_t s = 0; s < Power_t::dsf_NumStates; s++) {
+    dsf_putText(putChar, times[s]);
+    dsf_putNumber(putChar, stats.ms[s]);
+  }
+  for (uint8_t s = 0; s < Power_t::dsf_NumStates; s++) {
+    dsf_putText(putChar, counts[s]);
+    dsf_putNumber(putChar, stats.sleeps[s]);
+  }
+  for (uint8_t w = 1; w < Power_t::dsf_NumSources; w++) {
+    dsf_putText(putChar, sources[w]);
+    dsf_putNumber(putChar, stats.wakes[w]);
+  }
+  putChar('\n');
+}
+
+/*!
+ *   @fn         chargeRun
+ *
+ *   @brief      Ticks do LPO desde o último runCounter.
+ *
+ *   Com CMR = 0xFFFF, TCF indica uma volta completa do contador.
+ */
+uint32_t dsf_Power_ocp::chargeRun() {
+  uint32_t ticks;
+
+  DSF_LPTMR_CNR = 0;
+  ticks = DSF_LPTMR_CNR & 0xFFFF;
+  if (DSF_LPTMR_CSR & kTCF) {
+    ticks += 0x10000;
+  }
+  return ticks;
+}
+
+/*!
+ *   @fn         runCounter
+ *
+ *   @brief      Reinicia o LPTMR em contagem livre, sem interrupção.
+ *
+ *   Desligar o LPTMR zera o CNR e apaga o TCF.
+ */
+void dsf_Power_ocp::runCounter() {
+  DSF_LPTMR_CSR = 0;
+  DSF_LPTMR_CMR = 0xFFFF;
+  DSF_LPTMR_CSR = kTEN;
+}
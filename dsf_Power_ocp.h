@@ -0,0 +1,213 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Gerenciador dos modos de baixo consumo VLPS e LLS.
+ *
+ * @file        dsf_Power_ocp.h
+ * @version     1.0
+ * @date        6 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   SMC, LLWU, LPTMR e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (6 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_POWER_OCP_H_
+#define DSF_POWER_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_Delay_ocp.h"
+#include "dsf_MCG_ocp.h"
+#include "dsf_SysClock_ocp.h"
+
+/*!
+ * Namespace de definição dos estados de energia, das fontes de despertar
+ * e dos pinos do LLWU no KL25 (sinais LLWU_Pn).
+ */
+namespace Power_t {
+  enum dsf_PowerState {
+    dsf_Run = 0,
+    dsf_VLPS = 1,
+    dsf_LLS = 2,
+    dsf_NumStates = 3
+  };
+  enum dsf_WakeSource {
+    dsf_WakeNone = 0,
+    dsf_WakeTimer = 1,
+    dsf_WakePin = 2,
+    dsf_WakeIrq = 3,
+    dsf_NumSources = 4
+  };
+  enum dsf_LLWUPin {
+    dsf_P5_PTB0 = 5,
+    dsf_P6_PTC1 = 6,
+    dsf_P7_PTC3 = 7,
+    dsf_P8_PTC4 = 8,
+    dsf_P9_PTC5 = 9,
+    dsf_P10_PTC6 = 10,
+    dsf_P14_PTD4 = 14,
+    dsf_P15_PTD6 = 15,
+    dsf_NoWakePin = 0xFF
+  };
+  enum dsf_WakeEdge {
+    dsf_EdgeRising = 1,
+    dsf_EdgeFalling = 2,
+    dsf_EdgeEither = 3
+  };
+  enum dsf_PowerLimits {
+    dsf_MaxDelays = 4,
+    dsf_MaxSleepMs = 0x10000
+  };
+}  // namespace Power_t
+
+/*!
+ *  @struct   dsf_PowerStats
+ *
+ *  @brief    Tempo em cada estado de energia e despertares por fonte.
+ *
+ *  @details  ms é o tempo em dsf_Run, dsf_VLPS e dsf_LLS desde start,
+ *            medido pelo LPTMR com resolução de 1 ms por trecho; sleeps
+ *            conta as entradas em cada modo de parada (sleeps[dsf_Run]
+ *            conta as entradas abortadas por uma interrupção pendente).
+ */
+struct dsf_PowerStats {
+  uint32_t ms[Power_t::dsf_NumStates];
+  uint32_t sleeps[Power_t::dsf_NumStates];
+  uint32_t wakes[Power_t::dsf_NumSources];
+};
+
+/*!
+ *  @class    dsf_Power_ocp
+ *
+ *  @brief    Dorme em VLPS ou LLS entre os eventos da aplicação.
+ *
+ *  @details  sleep programa o LPTMR (LPO de 1 kHz, que continua ligado
+ *            nos dois modos) para o menor entre o timeout pedido e o
+ *            restante das temporizações dsf_Delay_ocp registradas com
+ *            track, e executa o WFI com SLEEPDEEP no modo escolhido em
+ *            start:
+ *            - dsf_VLPS: acorda com qualquer interrupção habilitada, por
+ *              exemplo a do PORTA da tecla (GPIO setInterrupt);
+ *            - dsf_LLS: só o LLWU acorda, pelo LPTMR (módulo 0) ou pelo
+ *              pino do LLWU informado em start; o vetor LLW deve ser
+ *              ligado ao objeto, além do LPTimer.
+ *
+ *            Nos dois modos o relógio do MCG para e com ele os TPMs, o
+ *            SysTick e a UART0. Os registradores do TPM são mantidos e, na
+ *            volta, resumeDelay desconta o tempo dormido de cada
+ *            temporização registrada, de modo que timeoutDelay termina no
+ *            instante certo (erro de até 0,5 ms por despertar, a resolução
+ *            do LPO). No perfil PEE do dsf_MCG_ocp, o despertar sai em PBE
+ *            e sleep chama dsf_MCG_ocp::resume para voltar ao PLL.
+ *
+ *            Entre os sonos o LPTMR conta livre e mede o tempo em dsf_Run.
+ *            Com deepest = dsf_Run, sleep usa o WFI comum (modo WAIT): os
+ *            TPMs continuam contando e o tempo é contado em dsf_Run.
+ *            O dsf_SysClock_ocp registrado com track recebe o tempo
+ *            dormido em resume, antes de qualquer leitura na volta. Com
+ *            -DDSF_LOAD_METER o sono é contabilizado como dsf_Sleep no
+ *            dsf_LoadMeter_ocp, o que em VLPS e LLS exige o relógio
+ *            registrado.
+ *
+ *            A latência de despertar (alguns microssegundos, conforme a
+ *            tabela de transições do datasheet, mais a entrada do
+ *            tratador) não pode ser medida no chip, pois só o LPO funciona
+ *            durante o sono; o simulador do host (host/dsf_power_sim) a
+ *            mede da borda da tecla ao led.
+ *
+ *            O LPTMR fica dedicado ao objeto entre start e stop e não
+ *            pode ser usado junto com o dsf_TSI_ocp.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Espera de 400 ms em VLPS, acordando com a tecla do PORTA.
+ *             +fn DSF_IRQ_BIND(LPTimer, power)
+ *             +fn DSF_IRQ_BIND(PORTA, key)
+ *             +fn key.setInterrupt(PortIrq_t::dsf_IrqEither);
+ *             +fn power.track(&tpm);
+ *             +fn power.start(Power_t::dsf_VLPS);
+ *             +fn tpm.startDelay(0xFFFF);
+ *             +fn while (!tpm.timeoutDelay()) power.sleep();
+ *
+ *            LLS com a tecla em PTD4 (LLWU_P14).
+ *             +fn DSF_IRQ_BIND(LLW, power)
+ *             +fn power.start(Power_t::dsf_LLS, Power_t::dsf_P14_PTD4,
+ *                             Power_t::dsf_EdgeFalling);
+ */
+class dsf_Power_ocp {
+ public:
+  /*!
+   * Método construtor padrão da classe.
+   */
+  dsf_Power_ocp();
+
+  /*!
+   * Métodos de controle do gerenciador.
+   */
+  void start(Power_t::dsf_PowerState deepest,
+             Power_t::dsf_LLWUPin pin = Power_t::dsf_NoWakePin,
+             Power_t::dsf_WakeEdge edge = Power_t::dsf_EdgeEither);
+  void stop();
+  bool track(dsf_Delay_ocp *delay);
+  void track(dsf_SysClock_ocp *clock);
+
+  /*!
+   * Método de sono. Retorna a fonte que acordou (Power_t::dsf_WakeSource)
+   * ou dsf_WakeNone se uma temporização termina em menos de 1 ms.
+   */
+  uint8_t sleep(uint32_t timeoutMs = 0);
+
+  /*!
+   * Métodos de consulta e de descarga.
+   */
+  void getStats(dsf_PowerStats *stats);
+  void dump(void (*putChar)(char));
+
+  /*!
+   * Tratador das interrupções do LPTMR e do LLWU (DSF_IRQ_BIND).
+   */
+  void irqHandler();
+
+ private:
+  uint8_t deepestState;
+  uint8_t wakePin;
+  bool started;
+  uint8_t delayCount;
+  dsf_Delay_ocp *delays[Power_t::dsf_MaxDelays];
+  dsf_SysClock_ocp *sysClock;
+  uint64_t micros[Power_t::dsf_NumStates];
+  uint32_t sleeps[Power_t::dsf_NumStates];
+  uint32_t wakes[Power_t::dsf_NumSources];
+
+  uint32_t chargeRun();
+  void runCounter();
+};
+
+#endif  //  DSF_POWER_OCP_H_
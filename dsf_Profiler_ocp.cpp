@@ -0,0 +1,280 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Perfilador estatístico: histograma do PC amostrado pelo SysTick.
+ *
+ * @file        dsf_Profiler_ocp.cpp
+ * @version     1.0
+ * @date        3 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   SysTick e SCB.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (3 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_Profiler_ocp.h"
+#include "dsf_Text_ocp.h"
+
+uint16_t dsf_Profiler_ocp::histogram[Profiler_t::dsf_Buckets];
+uint32_t dsf_Profiler_ocp::rangeBase = 0;
+uint32_t dsf_Profiler_ocp::rangeSize = 0x20000;
+uint8_t dsf_Profiler_ocp::shift = 8;
+uint32_t dsf_Profiler_ocp::rate = Profiler_t::dsf_DefaultHz;
+uint32_t dsf_Profiler_ocp::sampleCount;
+uint32_t dsf_Profiler_ocp::outsideCount;
+uint64_t dsf_Profiler_ocp::handlerCycles;
+
+/*!
+ * Ponte em C para o tratador em assembly.
+ */
+extern "C" void dsf_profilerSample(uint32_t pc) {
+  dsf_Profiler_ocp::sample(pc);
+}
+
+#ifdef DSF_HOST_SIM
+/*!
+ * No simulador do host não há quadro de exceção: o PC vem do simulador.
+ */
+extern "C" void SysTick_Handler(void) {
+  dsf_profilerSample((uint32_t)dsf_sim_interruptedPc());
+}
+#else
+/*!
+ * Tratador sem prólogo: o SP ainda aponta o quadro empilhado pela
+ * exceção, com o PC em +24. O bit 2 do EXC_RETURN (LR) indica se o quadro
+ * está na MSP ou na PSP. O salto para dsf_profilerSample mantém o LR, de
+ * modo que o retorno dela é o retorno da exceção.
+ *
+ * ARMv6-M Architecture Reference Manual, B1.5.6 e B1.5.8.
+ */
+extern "C" __attribute__((naked)) void SysTick_Handler(void) {
+  __asm volatile(
+      "  movs r0, #4\n"
+      "  mov r1, lr\n"
+      "  tst r0, r1\n"
+      "  bne 1f\n"
+      "  mrs r0, msp\n"
+      "  b 2f\n"
+      "1:\n"
+      "  mrs r0, psp\n"
+      "2:\n"
+      "  ldr r0, [r0, #24]\n"
+      "  ldr r1, 3f\n"
+      "  bx r1\n"
+      "  .align 2\n"
+      "3:\n"
+      "  .word dsf_profilerSample\n");
+}
+#endif
+
+/*!
+ *   @fn         setRange
+ *
+ *   @brief      Seleciona a faixa de endereços do histograma e o zera.
+ *
+ *   As faixas têm 2^shift bytes, com o menor shift (no mínimo 2, uma
+ *   instrução de 32 bits) com que size cabe em dsf_Buckets faixas.
+ *
+ *   @param[in]  base - primeiro endereço da faixa.
+ *               size - tamanho da faixa, em bytes.
+ */
+void dsf_Profiler_ocp::setRange(uint32_t base, uint32_t size) {
+  rangeBase = base;
+  rangeSize = size ? size : 1;
+  shift = 2;
+  while (((rangeSize - 1) >> shift) >= Profiler_t::dsf_Buckets) {
+    shift++;
+  }
+  reset();
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Inicia a amostragem periódica pelo SysTick.
+ *
+ *   @param[in]  hertz - amostras por segundo, de 2 Hz ao clock do núcleo
+ *                       dividido pelo custo de uma amostra.
+ *
+ *   @remarks    Siglas e páginas do ARMv6-M Architecture Reference Manual:
+ *               - SYST_CSR, SYST_RVR, SYST_CVR: SysTick. B3.3.
+ *               - SHPR3: System Handler Priority Register 3. B3.2.12.
+ */
+void dsf_Profiler_ocp::start(uint32_t hertz) {
+  rate = hertz ? hertz : (uint32_t)Profiler_t::dsf_DefaultHz;
+  SysTick->CTRL = 0;
+  clockChanged(0);
+  SysTick->VAL = 0;
+  dsf_MCG_ocp::subscribe(clockChanged, 0);
+  NVIC_SetPriority(SysTick_IRQn, 0);
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk
+                  | SysTick_CTRL_ENABLE_Msk;
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para a amostragem; o histograma é preservado.
+ */
+void dsf_Profiler_ocp::stop() {
+  SysTick->CTRL = 0;
+  dsf_MCG_ocp::unsubscribe(clockChanged, 0);
+}
+
+/*!
+ *   @fn         clockChanged
+ *
+ *   @brief      Programa o período do SysTick para a taxa no clock atual.
+ *
+ *   Também é o observador das trocas de perfil do dsf_MCG_ocp: o novo
+ *   período vale a partir do próximo recarregamento do SysTick.
+ */
+void dsf_Profiler_ocp::clockChanged(void *) {
+  uint32_t reload = dsf_MCG_ocp::coreHz()/rate - 1;
+
+  if (reload > SysTick_LOAD_RELOAD_Msk) {
+    reload = SysTick_LOAD_RELOAD_Msk;
+  }
+  SysTick->LOAD = reload;
+}
+
+/*!
+ *   @fn         reset
+ *
+ *   @brief      Zera o histograma e os contadores.
+ */
+void dsf_Profiler_ocp::reset() {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  for (uint32_t i = 0; i < Profiler_t::dsf_Buckets; i++) {
+    histogram[i] = 0;
+  }
+  sampleCount = 0;
+  outsideCount = 0;
+  handlerCycles = 0;
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         sample
+ *
+ *   @brief      Conta uma amostra do PC interrompido.
+ *
+ *   As faixas saturam em 65535. O tempo do próprio método é medido com o
+ *   SysTick, que acabou de recarregar e não volta a zero no meio dele.
+ *
+ *   @param[in]  pc - endereço da instrução interrompida.
+ */
+void dsf_Profiler_ocp::sample(uint32_t pc) {
+  uint32_t entered = SysTick->VAL;
+  uint32_t offset = pc - rangeBase;
+
+  if (offset < rangeSize) {
+    uint16_t &bucket = histogram[offset >> shift];
+    if (bucket != 0xFFFF) {
+      bucket++;
+    }
+  } else {
+    outsideCount++;
+  }
+  sampleCount++;
+  handlerCycles += (entered - SysTick->VAL) & SysTick_VAL_CURRENT_Msk;
+}
+
+/*!
+ *   @fn         samples
+ *
+ *   @brief      Informa o número de amostras desde o último reset.
+ */
+uint32_t dsf_Profiler_ocp::samples() {
+  return sampleCount;
+}
+
+/*!
+ *   @fn         outside
+ *
+ *   @brief      Informa o número de amostras fora da faixa do histograma.
+ */
+uint32_t dsf_Profiler_ocp::outside() {
+  return outsideCount;
+}
+
+/*!
+ *   @fn         overheadPpm
+ *
+ *   @brief      Estima a fração da CPU gasta pelo perfilador, em ppm.
+ *
+ *   Ciclos médios medidos por amostra mais dsf_FixedCycles, vezes a taxa,
+ *   sobre o clock do núcleo.
+ */
+uint32_t dsf_Profiler_ocp::overheadPpm() {
+  uint64_t cycles = Profiler_t::dsf_FixedCycles;
+
+  if (sampleCount) {
+    cycles += handlerCycles/sampleCount;
+  }
+  return (uint32_t)(cycles*rate*1000000ull/dsf_MCG_ocp::coreHz());
+}
+
+/*!
+ *   @fn         dump
+ *
+ *   @brief      Escreve o cabeçalho e as faixas não vazias do histograma.
+ *
+ *   Formato: "profile hz=1000 base=0 shift=8 samples=5000 outside=0
+ *   overhead_ppm=5340" seguido de uma linha "bucket=12 count=345" por
+ *   faixa não vazia; a faixa i começa em base + (i << shift).
+ *
+ *   @param[in]  putChar - função de saída de um caractere.
+ */
+void dsf_Profiler_ocp::dump(void (*putChar)(char)) {
+  dsf_putText(putChar, "profile hz=");
+  dsf_putNumber(putChar, rate);
+  dsf_putText(putChar, " base=");
+  dsf_putNumber(putChar, rangeBase);
+  dsf_putText(putChar, " shift=");
+  dsf_putNumber(putChar, shift);
+  dsf_putText(putChar, " samples=");
+  dsf_putNumber(putChar, sampleCount);
+  dsf_putText(putChar, " outside=");
+  dsf_putNumber(putChar, outsideCount);
+  dsf_putText(putChar, " overhead_ppm=");
+  dsf_putNumber(putChar, overheadPpm());
+  putChar('\n');
+  for (uint32_t i = 0; i < Profiler_t::dsf_Buckets; i++) {
+    if (histogram[i]) {
+      dsf_putText(putChar, "bucket=");
+      dsf_putNumber(putChar, i);
+      dsf_putText(putChar, " count=");
+      dsf_putNumber(putChar, histogram[i]);
+      putChar('\n');
+    }
+  }
+}
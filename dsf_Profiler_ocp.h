@@ -0,0 +1,141 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Perfilador estatístico: histograma do PC amostrado pelo SysTick.
+ *
+ * @file        dsf_Profiler_ocp.h
+ * @version     1.0
+ * @date        3 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   SysTick e SCB.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (3 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_PROFILER_OCP_H_
+#define DSF_PROFILER_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_TPM_ocp.h"
+
+/*!
+ * Namespace de definição dos limites do perfilador: número de faixas do
+ * histograma, taxa padrão e ciclos fixos de cada amostra, os que o SysTick
+ * não mede: 15 da entrada da exceção, 15 do trecho em assembly que lê o PC
+ * empilhado, 29 do prólogo e do epílogo de sample e 16 do retorno.
+ */
+namespace Profiler_t {
+  enum dsf_ProfilerLimits {
+    dsf_Buckets = 512,
+    dsf_DefaultHz = 1000,
+    dsf_FixedCycles = 75
+  };
+}  // namespace Profiler_t
+
+/*!
+ *  @class    dsf_Profiler_ocp
+ *
+ *  @brief    Perfilador estatístico por amostragem do PC.
+ *
+ *  @details  A exceção do SysTick, com a maior prioridade, lê o PC
+ *            empilhado do código interrompido, seja o laço principal, um
+ *            atraso ou outro tratador, e incrementa a faixa do histograma
+ *            que contém o endereço. Nenhuma função precisa ser anotada.
+ *
+ *            O histograma cobre [base, base + size) em dsf_Buckets faixas
+ *            de 2^shift bytes, com o menor shift que cabe; o padrão é a
+ *            flash inteira (128 KB, faixas de 256 bytes). Para localizar
+ *            um trecho quente, setRange estreita a faixa até 4 bytes por
+ *            faixa. Amostras fora da faixa são contadas em outside.
+ *
+ *            O custo de cada amostra é medido pelo próprio tratador com o
+ *            SysTick e informado em overheadPpm, somado aos ciclos fixos
+ *            da exceção. Pelos tempos das instruções do Cortex-M0+, com a
+ *            flash sem estados de espera, uma amostra na faixa custa 112
+ *            ciclos: 15 na entrada da exceção, 15 no trecho em assembly,
+ *            66 em sample (37 deles entre as duas leituras do SysTick) e
+ *            16 no retorno. Na taxa padrão de 1 kHz, são 0,53 % (5340 ppm)
+ *            da CPU a 20,97 MHz e 0,23 % a 48 MHz. O host/dsf_profile_sim
+ *            informa um valor de modelo, maior, porque lá cada acesso a
+ *            registrador custa 100 ciclos.
+ *            O tratador do SysTick é definido por este módulo, de modo que
+ *            o perfilador não convive com o dsf_IrqAudit_ocp, que usa o
+ *            SysTick em contagem livre.
+ *
+ *            O dump é convertido em funções no host por host/dsf_profsym,
+ *            com os símbolos do ELF do firmware.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Flash inteira a 1 kHz.
+ *             +fn dsf_Profiler_ocp::start();
+ *             +fn dsf_Profiler_ocp::dump(putChar);
+ *
+ *            Trecho de 2 KB a partir de 0x1200, a 4 kHz.
+ *             +fn dsf_Profiler_ocp::setRange(0x1200, 0x800);
+ *             +fn dsf_Profiler_ocp::start(4000);
+ */
+class dsf_Profiler_ocp {
+ public:
+  /*!
+   * Métodos de configuração e controle da amostragem.
+   */
+  static void setRange(uint32_t base, uint32_t size);
+  static void start(uint32_t hertz = Profiler_t::dsf_DefaultHz);
+  static void stop();
+  static void reset();
+
+  /*!
+   * Método chamado pelo tratador do SysTick com o PC interrompido.
+   */
+  static void sample(uint32_t pc);
+
+  /*!
+   * Métodos de consulta e de descarga.
+   */
+  static uint32_t samples();
+  static uint32_t outside();
+  static uint32_t overheadPpm();
+  static void dump(void (*putChar)(char));
+
+ private:
+  static uint16_t histogram[Profiler_t::dsf_Buckets];
+  static uint32_t rangeBase;
+  static uint32_t rangeSize;
+  static uint8_t shift;
+  static uint32_t rate;
+  static uint32_t sampleCount;
+  static uint32_t outsideCount;
+  static uint64_t handlerCycles;
+
+  static void clockChanged(void *argument);
+};
+
+#endif  //  DSF_PROFILER_OCP_H_
@@ -0,0 +1,267 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Máquina de estados com tabela de transições gerada em tempo
+ *              de compilação.
+ *
+ * @file        dsf_StateMachine_ocp.h
+ * @version     1.0
+ * @date        11 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (11 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_STATEMACHINE_OCP_H_
+#define DSF_STATEMACHINE_OCP_H_
+
+#include <stdint.h>
+
+/*!
+ * Namespace de definição dos valores reservados de estado e de evento.
+ */
+namespace StateMachine_t {
+  enum dsf_Reserved {
+    dsf_NoState = 0xFF,
+    dsf_NoEvent = 0xFF
+  };
+}  // namespace StateMachine_t
+
+/*!
+ * Ação de uma transição. Retorna o próximo evento a ser tratado no novo
+ * estado (por exemplo, o resultado de um sorteio) ou
+ * StateMachine_t::dsf_NoEvent.
+ */
+typedef uint8_t (*dsf_StateAction)();
+
+/*!
+ * Célula da tabela de transições: ação e próximo estado, ou dsf_NoState se
+ * o evento não é tratado no estado.
+ */
+struct dsf_StateCell {
+  dsf_StateAction action;
+  uint8_t next;
+};
+
+/*!
+ *  @struct   dsf_Transition
+ *
+ *  @brief    Transição From --Event--> To, com ação opcional.
+ */
+template <uint8_t From, uint8_t Event, uint8_t To,
+          dsf_StateAction Action = nullptr>
+struct dsf_Transition {
+  static constexpr uint8_t from = From;
+  static constexpr uint8_t event = Event;
+  static constexpr uint8_t to = To;
+  static constexpr dsf_StateAction action = Action;
+};
+
+/*!
+ * Lista de transições, percorrida só em tempo de compilação.
+ */
+template <typename... Transitions>
+struct dsf_TransitionList;
+
+template <>
+struct dsf_TransitionList<> {
+  static constexpr uint32_t matches(uint8_t, uint8_t) {
+    return 0;
+  }
+  static constexpr dsf_StateCell cell(uint8_t, uint8_t) {
+    return dsf_StateCell{nullptr, StateMachine_t::dsf_NoState};
+  }
+  static constexpr bool inRange(uint8_t, uint8_t) {
+    return true;
+  }
+};
+
+template <typename Head, typename... Tail>
+struct dsf_TransitionList<Head, Tail...> {
+  static constexpr uint32_t matches(uint8_t state, uint8_t event) {
+    return (Head::from == state && Head::event == event)
+           + dsf_TransitionList<Tail...>::matches(state, event);
+  }
+  static constexpr dsf_StateCell cell(uint8_t state, uint8_t event) {
+    return (Head::from == state && Head::event == event)
+           ? dsf_StateCell{Head::action, Head::to}
+           : dsf_TransitionList<Tail...>::cell(state, event);
+  }
+  static constexpr bool inRange(uint8_t states, uint8_t events) {
+    return Head::from < states && Head::to < states && Head::event < events
+           && dsf_TransitionList<Tail...>::inRange(states, events);
+  }
+};
+
+/*!
+ * Verifica, por bissecção das células, que nenhum par estado e evento tem
+ * mais de uma transição.
+ */
+template <typename List, uint8_t Events>
+constexpr bool dsf_uniqueTransitions(uint16_t first, uint16_t last) {
+  return last - first <= 1
+         ? last == first || List::matches(first / Events, first % Events) <= 1
+         : dsf_uniqueTransitions<List, Events>(first, first + (last - first)/2)
+           && dsf_uniqueTransitions<List, Events>(first + (last - first)/2,
+                                                  last);
+}
+
+/*!
+ * Sequência de índices das células (std::index_sequence do C++14).
+ */
+template <uint16_t... I>
+struct dsf_StateIndices {
+};
+
+template <uint16_t N, uint16_t... I>
+struct dsf_MakeStateIndices : dsf_MakeStateIndices<N - 1, N - 1, I...> {
+};
+
+template <uint16_t... I>
+struct dsf_MakeStateIndices<0, I...> {
+  typedef dsf_StateIndices<I...> type;
+};
+
+/*!
+ * Tabela plana de transições, com States*Events células constantes.
+ */
+template <uint8_t Events, typename List, typename Indices>
+struct dsf_StateTable;
+
+template <uint8_t Events, typename List, uint16_t... I>
+struct dsf_StateTable<Events, List, dsf_StateIndices<I...> > {
+  static const dsf_StateCell cells[sizeof...(I)];
+};
+
+template <uint8_t Events, typename List, uint16_t... I>
+const dsf_StateCell
+    dsf_StateTable<Events, List, dsf_StateIndices<I...> >::cells[] = {
+  List::cell(I / Events, I % Events)...
+};
+
+/*!
+ *  @class    dsf_StateMachine_ocp
+ *
+ *  @brief    Máquina de estados com despacho O(1) por tabela.
+ *
+ *  @details  Os estados e os eventos são números de 0 a States - 1 e de 0
+ *            a Events - 1, tipicamente enumeradores de um namespace, e as
+ *            transições são tipos dsf_Transition. A tabela de
+ *            States*Events células é calculada pelo compilador e fica
+ *            constante na flash; o despacho é um acesso indexado à tabela
+ *            e uma chamada direta da ação, sem heap, sem funções virtuais
+ *            e sem percorrer as transições.
+ *
+ *            Transições repetidas (mesmo estado e evento) ou com estado ou
+ *            evento fora dos limites são erros de compilação. Um evento
+ *            sem transição no estado atual é ignorado.
+ *
+ *            O estado é atualizado antes da ação, e o evento retornado pela
+ *            ação é tratado em seguida no novo estado, até a ação retornar
+ *            StateMachine_t::dsf_NoEvent. Assim, uma decisão (vitória ou
+ *            derrota) é um evento, e não uma condição na transição.
+ *
+ *            dispatch é chamado só pelo laço principal. Eventos gerados em
+ *            interrupções passam por uma dsf_EventQueue_ocp e são
+ *            despachados no laço.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Led que pisca a cada estouro do TPM enquanto a tecla está
+ *            solta.
+ *             +fn typedef dsf_StateMachine_ocp<2, 3,
+ *                     dsf_Transition<Blinking, Timeout, Blinking, blink>,
+ *                     dsf_Transition<Blinking, KeyDown, Holding, hold>,
+ *                     dsf_Transition<Holding, KeyUp, Blinking>
+ *                 > Machine;
+ *             +fn Machine machine(Blinking);
+ *             +fn if (tpm.timeoutDelay()) machine.dispatch(Timeout);
+ */
+template <uint8_t States, uint8_t Events, typename... Transitions>
+class dsf_StateMachine_ocp {
+  typedef dsf_TransitionList<Transitions...> List;
+
+  static_assert(States >= 1 && States < StateMachine_t::dsf_NoState,
+                "States deve estar entre 1 e 254");
+  static_assert(Events >= 1 && Events < StateMachine_t::dsf_NoEvent,
+                "Events deve estar entre 1 e 254");
+  static_assert(List::inRange(States, Events),
+                "Transicao com estado ou evento fora dos limites");
+  static_assert(dsf_uniqueTransitions<List, Events>(0, States*Events),
+                "Duas transicoes com o mesmo estado e evento");
+
+ public:
+  typedef dsf_StateTable<Events, List,
+      typename dsf_MakeStateIndices<(uint16_t)(States*Events)>::type> Table;
+
+  /*!
+   * Método construtor da classe.
+   */
+  explicit dsf_StateMachine_ocp(uint8_t initial) : state(initial) {
+  }
+
+  /*!
+   *   @fn         dispatch
+   *
+   *   @brief      Trata um evento e os eventos retornados pelas ações.
+   *
+   *   @param[in]  event - evento, de 0 a Events - 1.
+   *
+   *   @return     false se o evento foi ignorado no estado atual.
+   */
+  bool dispatch(uint8_t event) {
+    bool handled = false;
+
+    while (event < Events) {
+      const dsf_StateCell &cell = Table::cells[state*Events + event];
+
+      if (cell.next == StateMachine_t::dsf_NoState) {
+        break;
+      }
+      state = cell.next;
+      handled = true;
+      event = cell.action ? cell.action()
+                          : (uint8_t)StateMachine_t::dsf_NoEvent;
+    }
+    return handled;
+  }
+
+  /*!
+   *   @fn         current
+   *
+   *   @brief      Informa o estado atual.
+   */
+  uint8_t current() const {
+    return state;
+  }
+
+ private:
+  uint8_t state;
+};
+
+#endif  //  DSF_STATEMACHINE_OCP_H_
@@ -0,0 +1,369 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Relógio monotônico de 64 bits sobre um TPM em contagem livre.
+ *
+ * @file        dsf_SysClock_ocp.cpp
+ * @version     1.0
+ * @date        26 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (26 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_SysClock_ocp.h"
+
+/*!
+ *   @fn         dsf_SysClock_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método associa o objeto ao TPM dedicado ao relógio e calcula os
+ *   multiplicadores para o divisor padrão Div1. O clock do TPM só é
+ *   adquirido em start.
+ *
+ *   @param[in]  tpm - TPM dedicado ao relógio.
+ */
+dsf_SysClock_ocp::dsf_SysClock_ocp(TPM_t::TPMNumber_t tpm) {
+  bindPeripheral((uint8_t *)(TPM0_BASE + 0x1000*tpm));
+  TPMNumber = tpm;
+  overflows = 0;
+  sequence = 0;
+  resumedTicks = 0;
+  nanosPerTick = 0;
+  microsPerTick = 0;
+  baseTicks = 0;
+  baseNanos = 0;
+  baseMicros = 0;
+  setFrequency(TPMDiv_t::Div1);
+}
+
+/*!
+ *   @fn         ~dsf_SysClock_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ */
+dsf_SysClock_ocp::~dsf_SysClock_ocp() {
+  stop();
+}
+
+/*!
+ *   @fn         setFrequency
+ *
+ *   @brief      Ajusta o divisor do TPM e recalcula os multiplicadores.
+ *
+ *   Os multiplicadores são (10^9 << 32)/f e (10^6 << 32)/f, com f a
+ *   frequência do tick; para o relógio de 20,97152 MHz do FEI ambos são
+ *   exatos. O tempo contado até a chamada fica na base, na frequência
+ *   anterior.
+ *
+ *   A leitura dos ticks, a nova base e os novos multiplicadores são feitos
+ *   com as interrupções desabilitadas: um overflow entre a leitura e a
+ *   publicação seria convertido com os multiplicadores novos, e uma
+ *   interrupção que lesse o relógio com o número de sequência ímpar
+ *   repetiria a leitura para sempre. Com o relógio contando, um divisor
+ *   novo é escrito no PS no mesmo trecho, pois o PS só pode ser trocado
+ *   com a contagem parada: o TPM é parado antes da leitura dos ticks e
+ *   religado logo depois com o novo divisor, sem zerar o CNT, de modo que
+ *   só os ciclos entre as duas escritas no SC (três leituras) deixam de
+ *   ser contados. clockChanged chama este método com o mesmo divisor, só
+ *   para trocar a frequência de entrada, e o TPM não é parado.
+ *
+ *   @param[in]  divBase - constante de divisão do divisor de frequência.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ */
+void dsf_SysClock_ocp::setFrequency(TPMDiv_t::TPMDiv divBase) {
+  uint32_t primask = __get_PRIMASK();
+  bool reprogram = peripheralGate != ClockGate_t::dsf_NumGates
+                   && divBase != freqDiv;
+  uint64_t count;
+
+  __disable_irq();
+  if (reprogram) {
+    writeSC(0);
+  }
+  count = ticks();
+  if (reprogram) {
+    /*!
+     * Religa a contagem (0x08) com TOIE (0x40) sem escrever o TOF, que
+     * continua pendente para o tratador se o overflow já ocorreu.
+     */
+    writeSC(0x40 | 0x08 | divBase);
+  }
+  sequence++;
+  __asm volatile("" ::: "memory");
+  baseNanos += scale(count - baseTicks, nanosPerTick);
+  baseMicros += scale(count - baseTicks, microsPerTick);
+  baseTicks = count;
+  freqDiv = divBase;
+  nanosPerTick = (1000000000ull << 32)/tickFrequency();
+  microsPerTick = (1000000ull << 32)/tickFrequency();
+  __asm volatile("" ::: "memory");
+  sequence++;
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Inicia a contagem livre com a interrupção de overflow.
+ *
+ *   A contagem de ticks continua de onde parou se o relógio já tinha sido
+ *   iniciado antes.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ *               - NVIC_IPRn: prioridade 0, a maior. ARMv6-M ARM, B3.4.
+ */
+void dsf_SysClock_ocp::start() {
+  dsf_MCG_ocp::subscribe(clockChanged, this);
+  enablePeripheralClock(TPMNumber);
+  restartCounter(0xFFFF, 0x80 | 0x40 | 0x08 | freqDiv);
+  NVIC_SetPriority((IRQn_Type)(TPM0_IRQn + TPMNumber), 0);
+  NVIC_ClearPendingIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  NVIC_EnableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para o relógio e libera o clock do TPM.
+ *
+ *   A contagem é arredondada para o próximo múltiplo do período, de modo
+ *   que o relógio continua monotônico no próximo start.
+ *
+ *   A escrita da parte alta é feita com as interrupções desabilitadas:
+ *   uma interrupção que lesse o relógio com o número de sequência ímpar
+ *   (o dsf_LoadMeter_ocp lê em toda entrada de tratador) repetiria a
+ *   leitura para sempre, pois este trecho não voltaria a executar. O
+ *   clock do TPM é liberado no mesmo trecho, para que nenhuma leitura
+ *   combine a parte alta nova com o CNT parado.
+ */
+void dsf_SysClock_ocp::stop() {
+  uint32_t status;
+  uint32_t primask;
+
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  dsf_MCG_ocp::unsubscribe(clockChanged, this);
+  NVIC_DisableIRQ((IRQn_Type)(TPM0_IRQn + TPMNumber));
+  primask = __get_PRIMASK();
+  __disable_irq();
+  status = *addressTPMxSC;
+  writeSC(0);
+  /*!
+   * Arredonda para o próximo overflow, contando um TOF ainda pendente.
+   */
+  sequence++;
+  __asm volatile("" ::: "memory");
+  overflows = overflows + ((status & 0x80) ? 2 : 1);
+  __asm volatile("" ::: "memory");
+  sequence++;
+  disablePeripheralClock();
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         resume
+ *
+ *   @brief      Soma ao relógio o tempo em que o TPM ficou parado.
+ *
+ *   Chamado pelo dsf_Power_ocp na volta de VLPS ou LLS, com o tempo
+ *   dormido medido pelo LPTMR. O CNT não pode receber a diferença (uma
+ *   escrita o zera), que fica em resumedTicks e é somada por ticks; a
+ *   atualização é publicada entre dois incrementos do número de sequência,
+ *   como no tratador.
+ *
+ *   @param[in]  elapsedMicros - tempo dormido, em us.
+ */
+void dsf_SysClock_ocp::resume(uint32_t elapsedMicros) {
+  uint64_t elapsed = (uint64_t)elapsedMicros*tickFrequency()/1000000;
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  sequence++;
+  __asm volatile("" ::: "memory");
+  resumedTicks = resumedTicks + elapsed;
+  __asm volatile("" ::: "memory");
+  sequence++;
+  __set_PRIMASK(primask);
+}
+
+/*!
+ *   @fn         ticks
+ *
+ *   @brief      Lê o relógio sem desabilitar interrupções.
+ *
+ *   A parte alta, o CNT, a flag TOF e de novo o CNT são lidos entre duas
+ *   leituras do número de sequência; a leitura é repetida se uma
+ *   interrupção atualizou o relógio no meio dela. Com TOF pendente, o
+ *   overflow ainda não foi contado: se o CNT voltou entre as duas
+ *   leituras, ele ocorreu entre elas e vale a segunda; senão ocorreu antes
+ *   da primeira, qualquer que seja o CNT. Assim um trecho com interrupções
+ *   desabilitadas pode durar até um período do TPM. Os ticks somados por
+ *   resume são lidos no mesmo trecho.
+ *
+ *   @return     O número de ticks desde o primeiro start.
+ */
+uint64_t dsf_SysClock_ocp::ticks() {
+  uint32_t before, count, status, again;
+  uint64_t high, resumed;
+
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return (overflows << 16) + resumedTicks;
+  }
+  do {
+    before = sequence;
+    __asm volatile("" ::: "memory");
+    high = overflows;
+    resumed = resumedTicks;
+    count = *addressTPMxCNT & 0xFFFF;
+    status = *addressTPMxSC;
+    again = *addressTPMxCNT & 0xFFFF;
+    __asm volatile("" ::: "memory");
+  } while ((before & 1) || before != sequence);
+
+  if (status & 0x80) {
+    if (again < count) {
+      count = again;
+    }
+    high++;
+  }
+  return ((high << 16) | count) + resumed;
+}
+
+/*!
+ *   @fn         nanoseconds
+ *
+ *   @brief      Lê o relógio em nanossegundos.
+ *
+ *   A base e o multiplicador são lidos com o mesmo número de sequência
+ *   dos ticks, de modo que uma troca de perfil no meio é repetida.
+ */
+uint64_t dsf_SysClock_ocp::nanoseconds() {
+  uint32_t before;
+  uint64_t result;
+
+  do {
+    before = sequence;
+    __asm volatile("" ::: "memory");
+    result = baseNanos + scale(ticks() - baseTicks, nanosPerTick);
+    __asm volatile("" ::: "memory");
+  } while ((before & 1) || before != sequence);
+  return result;
+}
+
+/*!
+ *   @fn         microseconds
+ *
+ *   @brief      Lê o relógio em microssegundos.
+ */
+uint64_t dsf_SysClock_ocp::microseconds() {
+  uint32_t before;
+  uint64_t result;
+
+  do {
+    before = sequence;
+    __asm volatile("" ::: "memory");
+    result = baseMicros + scale(ticks() - baseTicks, microsPerTick);
+    __asm volatile("" ::: "memory");
+  } while ((before & 1) || before != sequence);
+  return result;
+}
+
+/*!
+ *   @fn         ticksToNanos
+ *
+ *   @brief      Converte um intervalo em ticks para nanossegundos.
+ */
+uint64_t dsf_SysClock_ocp::ticksToNanos(uint64_t value) {
+  return scale(value, nanosPerTick);
+}
+
+/*!
+ *   @fn         ticksToMicros
+ *
+ *   @brief      Converte um intervalo em ticks para microssegundos.
+ */
+uint64_t dsf_SysClock_ocp::ticksToMicros(uint64_t value) {
+  return scale(value, microsPerTick);
+}
+
+/*!
+ *   @fn         tickFrequency
+ *
+ *   @brief      Informa a frequência do tick, em Hz.
+ */
+uint32_t dsf_SysClock_ocp::tickFrequency() {
+  return dsf_MCG_ocp::timerHz() >> freqDiv;
+}
+
+/*!
+ *   @fn         clockChanged
+ *
+ *   @brief      Observador das trocas de perfil do dsf_MCG_ocp.
+ *
+ *   Chamado por setProfile com as interrupções desabilitadas: o tempo
+ *   contado até aqui é guardado na frequência anterior e os
+ *   multiplicadores são recalculados para a nova. Os ticks contados
+ *   durante a própria troca (alguns us, passando pelo FEI) entram na
+ *   frequência anterior.
+ *
+ *   @param[in]  argument - o objeto dsf_SysClock_ocp.
+ */
+void dsf_SysClock_ocp::clockChanged(void *argument) {
+  dsf_SysClock_ocp *clock = (dsf_SysClock_ocp *)argument;
+
+  clock->setFrequency((TPMDiv_t::TPMDiv)clock->freqDiv);
+}
+
+/*!
+ *   @fn         scale
+ *
+ *   @brief      Calcula (value*multiplier) >> 32 com produtos de 32 bits.
+ *
+ *   O Cortex-M0+ só multiplica 32x32 -> 32 bits; os quatro produtos
+ *   parciais de 64 bits são somados já deslocados, sem o produto de 128
+ *   bits. O erro é de no máximo uma unidade por truncamento.
+ */
+uint64_t dsf_SysClock_ocp::scale(uint64_t value, uint64_t multiplier) {
+  uint32_t valueLow = (uint32_t)value;
+  uint32_t valueHigh = (uint32_t)(value >> 32);
+  uint32_t multiplierLow = (uint32_t)multiplier;
+  uint32_t multiplierHigh = (uint32_t)(multiplier >> 32);
+
+  return ((uint64_t)valueHigh*multiplierHigh << 32)
+         + (uint64_t)valueHigh*multiplierLow
+         + (uint64_t)valueLow*multiplierHigh
+         + (((uint64_t)valueLow*multiplierLow) >> 32);
+}
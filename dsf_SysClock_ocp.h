@@ -0,0 +1,176 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Relógio monotônico de 64 bits sobre um TPM em contagem livre.
+ *
+ * @file        dsf_SysClock_ocp.h
+ * @version     1.0
+ * @date        26 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (26 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_SYSCLOCK_OCP_H_
+#define DSF_SYSCLOCK_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_TPM_ocp.h"
+
+/*!
+ *  @class    dsf_SysClock_ocp
+ *
+ *  @brief    Base de tempo do sistema, compartilhada pelos drivers.
+ *
+ *  @details  Um TPM dedicado conta livremente com MOD = 0xFFFF e a
+ *            interrupção de overflow acumula a parte alta, formando um
+ *            contador de ticks de 64 bits que nunca volta a zero.
+ *
+ *            A leitura não desabilita interrupções: ela repete enquanto o
+ *            número de sequência, incrementado pela interrupção antes e
+ *            depois de cada atualização, muda durante a leitura. Um
+ *            overflow ainda não tratado (TOF pendente com as interrupções
+ *            desabilitadas) é detectado pela própria leitura, de modo que
+ *            o tempo nunca regride. A interrupção do relógio recebe a maior
+ *            prioridade do NVIC, para que nenhum leitor a interrompa no
+ *            meio de uma atualização; um trecho com interrupções
+ *            desabilitadas não deve durar mais que um período do TPM.
+ *
+ *            A conversão para ns e us usa multiplicadores de ponto fixo
+ *            32.32 calculados em setFrequency: um produto de 64 bits feito
+ *            com quatro multiplicações de 32 bits, sem divisão.
+ *
+ *            Entre start e stop o relógio observa as trocas de perfil do
+ *            dsf_MCG_ocp: o tempo já contado é guardado em ns e us e os
+ *            multiplicadores passam a usar a nova frequência do TPM, de
+ *            modo que nanoseconds e microseconds seguem o tempo real. Os
+ *            intervalos em ticks (ticksToNanos, ticksToMicros) são
+ *            convertidos na frequência atual e não devem atravessar uma
+ *            troca de perfil.
+ *
+ *            Nos modos VLPS e LLS o TPM para junto com o MCG e os ticks do
+ *            sono não são contados; o dsf_Power_ocp chama resume na volta,
+ *            com o tempo dormido medido pelo LPTMR, se o relógio foi
+ *            registrado com track. O tempo somado tem a resolução do LPO
+ *            (0,5 ms por despertar).
+ *
+ *            No FEI, com Div1 o tick vale 47,7 ns e o overflow ocorre a
+ *            cada 3,1 ms; com Div128 o tick vale 6,1 us e o overflow a
+ *            cada 400 ms.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Relógio no TPM0 e sua interrupção.
+ *             +fn dsf_SysClock_ocp sysClock(TPM_t::dsf_TPM0);
+ *             +fn DSF_IRQ_BIND(TPM0, sysClock)
+ *             +fn sysClock.start();
+ *
+ *            Medição de um intervalo.
+ *             +fn uint64_t t0 = sysClock.ticks();
+ *             +fn uint64_t us = sysClock.ticksToMicros(sysClock.ticks() - t0);
+ */
+class dsf_SysClock_ocp : public dsf_TPMPeripheral_ocp {
+ public:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  explicit dsf_SysClock_ocp(TPM_t::TPMNumber_t tpm = TPM_t::dsf_TPM0);
+  ~dsf_SysClock_ocp();
+
+  /*!
+   * Métodos de configuração e controle do relógio.
+   */
+  void setFrequency(TPMDiv_t::TPMDiv divBase);
+  void start();
+  void stop();
+  void resume(uint32_t elapsedMicros);
+
+  /*!
+   *   @fn         irqHandler
+   *
+   *   @brief      Trata a interrupção de overflow do TPM.
+   *
+   *   Limpa TOF com uma única escrita e publica a nova parte alta entre
+   *   dois incrementos do número de sequência. Fica no header para ser
+   *   expandido no tratador gerado por DSF_IRQ_BIND.
+   */
+  void irqHandler() {
+    clearOverflow();
+    sequence++;
+    __asm volatile("" ::: "memory");
+    overflows = overflows + 1;
+    __asm volatile("" ::: "memory");
+    sequence++;
+  }
+
+  /*!
+   * Métodos de leitura do relógio.
+   */
+  uint64_t ticks();
+  uint64_t nanoseconds();
+  uint64_t microseconds();
+
+  /*!
+   * Métodos de conversão de intervalos medidos em ticks.
+   */
+  uint64_t ticksToNanos(uint64_t value);
+  uint64_t ticksToMicros(uint64_t value);
+  uint32_t tickFrequency();
+
+ private:
+  /*!
+   * Número de overflows do TPM e número de sequência das atualizações.
+   */
+  volatile uint64_t overflows;
+  volatile uint32_t sequence;
+  /*!
+   * Ticks somados por resume, em que o TPM ficou parado no sono.
+   */
+  volatile uint64_t resumedTicks;
+  /*!
+   * Multiplicadores 32.32 de ticks para ns e para us.
+   */
+  uint64_t nanosPerTick;
+  uint64_t microsPerTick;
+  /*!
+   * Tempo contado até a última mudança de frequência do tick.
+   */
+  uint64_t baseTicks;
+  uint64_t baseNanos;
+  uint64_t baseMicros;
+  uint8_t freqDiv;
+  uint8_t TPMNumber;
+
+  static void clockChanged(void *argument);
+  static uint64_t scale(uint64_t value, uint64_t multiplier);
+};
+
+#endif  //  DSF_SYSCLOCK_OCP_H_
@@ -1,157 +1,374 @@
-/*!
- * @copyright    2017 UFAM - Universidade Federal do Amazonas.
- *
- * @brief       Implementao da classe me "dsf_TPMPeripheral_ocp".
- *
- * @file        dsf_TPM_ocp.cpp
- * @version     1.0
- * @date        02 Agosto 2017
- *
- * @section     HARDWARES & SOFTWARES
- *              +board        FRDM-KL25Z da NXP.
- *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
- *              +peripheral   TPM.
- *              +compiler     Kinetis Design Studio IDE.
- *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
- *              +revisions    Verso (data): Descrio breve.
- *                             ++ 1.0 (02 Agosto 2017): Verso inicial.
- *
- * @section     AUTHORS & DEVELOPERS
- *              +institution  Universidade Federal do Amazonas.
- *              +courses      Engenharia da Computao / Engenharia Eltrica.
- *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
- *              +student      Verso inicial:
- *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
- *
- * @section     LICENSE
- *
- *              GNU General Public License (GNU GPL).
- *
- *              Este programa  um software livre; Voc pode redistribu-lo
- *              e/ou modific-lo de acordo com os termos do "GNU General Public
- *              License" como publicado pela Free Software Foundation; Seja a
- *              verso 3 da licena, ou qualquer verso posterior.
- *
- *              Este programa  distribudo na esperana de que seja til,
- *              mas SEM QUALQUER GARANTIA; Sem a garantia implcita de
- *              COMERCIALIZAO OU USO PARA UM DETERMINADO PROPSITO.
- *              Veja o site da "GNU General Public License" para mais detalhes.
- *
- * @htmlonly    http://www.gnu.org/copyleft/gpl.html
- */
-
-#include "dsf_TPM_ocp.h"
-
-/*!
- *   @fn         bindPeripheral
- *
- *   @brief      Associa o objeto de software ao perifrico de hardware.
- *
- *   Este mtodo associa ao objeto de software o perifrico de hardware,
- *   utilizando a inicializao dos ponteiros para os endereos de memria
- *   dos registradores correspondentes.
- *
- *   @param[in]  baseAddress - o endereo base do perifrico TPM.
- *
- *   @remarks    Sigla e pagina do Manual de Referencia KL25:
- *               - TPMxSC: Status Control Register. Pg. 552.
- *               - TPMxCNT: Counter Register. Pg.554.
- *               - TPMxMOD: Modulo Register. Pg. 554.
- */
-
-void dsf_TPMPeripheral_ocp::bindPeripheral(uint8_t *baseAddress) {
-  addressTPMxSC = (volatile uint32_t *)(baseAddress);
-  addressTPMxCNT = (volatile uint32_t *)(baseAddress + 0x4);
-  addressTPMxMOD = (volatile uint32_t *)(baseAddress + 0x8);
-}
-
-/*!
- *   @fn         bindChannel
- *
- *   @brief      Associa o canal do objeto de software ao hardware
- *
- *   Este mtodo associa os atributos do canal do objeto de software ao
- *   seu correspondente do perifrico hardware.
- *
- *   @param[in]  baseAddress - o endereo base do perifrico TPM.
- *               chnNumber - o nmero do canal do perifrico TPM.
- *
- *   @remarks    Sigla e pagina do Manual de Referencia KL25:
- *               - TPMxCnV: Channel Value Register. Pg.557.
- *               - TPMxCnSC: Channel Status Control Register. Pg.555.
- */
-void dsf_TPMPeripheral_ocp::bindChannel(uint8_t *baseAddress,
-                                        uint8_t chnNumber) {
-  addressTPMxCnV = (volatile uint32_t *)(baseAddress + 0x10 + 8*chnNumber);
-  addressTPMxCnSC = (volatile uint32_t *)(baseAddress + 0xC + 8*chnNumber);
-}
-
-
-/*!
- *   @fn         bindPin
- *
- *   @brief      Associa o pino do objeto ao perifrico de hardare.
- *
- *   Este mtodo associa o pino do objeto de software ao pino do perifrico.
- *
- *   @param[in]  pinNumber - o nmero do pino do objeto de software.
- *
- *   @remarks    Sigla e pagina do Manual de Referencia KL25:
- *               - PCR: Pin Control Register. Pg.183.
- */
-void dsf_TPMPeripheral_ocp::bindPin(uint8_t GPIONumber, uint8_t pinNumber) {
-  addressPortxPCRn = (volatile uint32_t *)(0x40049000
-                                          + 0x1000*GPIONumber + 4*pinNumber);
-}
-
-
-/*!
- *   @fn         enablePeripheralClock
- *
- *   @brief      Habilita o clock do perifrico de hardware.
- *
- *   Este mtodo habilita o clock do perifrico TPM solicitado.
- *
- *   @remarks    Sigla e pagina do Manual de Referencia KL25:
- *               - SCGC6: System Control Gating Clock Register 6. Pg.207.
- *               - SOPT2: System Options Register 2. Pg.195.
- */
-void dsf_TPMPeripheral_ocp::enablePeripheralClock(uint8_t TPMNumber) {
-  SIM_SCGC6 |= SIM_SCGC6_TPM0_MASK << TPMNumber;
-  SIM_SOPT2 |= SIM_SOPT2_TPMSRC(1);
-}
-
-/*!
- *   @fn         enableGPIOClock
- *
- *   @brief      Habilita o clock do GPIO do pino.
- *
- *   Este mtodo habilita o clock do perifrico GPIO do pino passado por
- *   parmetro.
- *
- *   @param[in]  GPIONumber - o nmero do GPIO correspondente ao pino.
- *
- *   @remarks    Sigla e pagina do Manual de Referencia KL25:
- *               - SCGC5: System Control Gating Clock Register 5. Pg.199.
- */
-void dsf_TPMPeripheral_ocp::enableGPIOClock(uint8_t GPIONumber) {
-  SIM_SCGC5 |= SIM_SCGC5_PORTA_MASK << GPIONumber;
-}
-
-/*!
- *   @fn         selectMuxAlternative
- *
- *   @brief      Seleciona a alternativa de trabalho do pino.
- *
- *   Este mtodo seleciona o modo de operao do pino correspondente para o
- *   modo de operao TPM.
- *
- *   @param[in]  muxAlt - alternativa de operao do pino para o canal e TPM
- *                        especificados.
- *
- *   @remarks    Sigla e pagina do Manual de Referencia KL25:
- *               - PCR: Pin Control Register. Pg.183.
- */
-void dsf_TPMPeripheral_ocp::selectMuxAlternative(uint8_t muxAlt) {
-  *addressPortxPCRn = PORT_PCR_MUX(muxAlt);
-}
+/*!
+ * @copyright   © 2017 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Implementação da classe mãe "dsf_TPMPeripheral_ocp".
+ *
+ * @file        dsf_TPM_ocp.cpp
+ * @version     1.0
+ * @date        02 Agosto 2017
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (02 Agosto 2017): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *              +student      Versão inicial:
+ *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_TPM_ocp.h"
+#include "dsf_BME_ocp.h"
+
+/*!
+ * Cópias de sombra com os valores de reset do SC e do MOD (pág. 552).
+ */
+uint32_t dsf_TPMPeripheral_ocp::shadowSC[TPM_t::dsf_NumTPMs];
+uint32_t dsf_TPMPeripheral_ocp::shadowMOD[TPM_t::dsf_NumTPMs] = {
+  0xFFFF, 0xFFFF, 0xFFFF
+};
+uint32_t dsf_TPMPeripheral_ocp::shadowSource;
+uint32_t dsf_TPMPeripheral_ocp::mismatches;
+
+/*!
+ *   @fn         dsf_TPMPeripheral_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método indica que o objeto ainda não adquiriu nenhuma porta de
+ *   clock.
+ */
+dsf_TPMPeripheral_ocp::dsf_TPMPeripheral_ocp()
+    : peripheralGate(ClockGate_t::dsf_NumGates),
+      GPIOGate(ClockGate_t::dsf_NumGates) {
+}
+
+/*!
+ *   @fn         ~dsf_TPMPeripheral_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ *
+ *   Este método libera as portas de clock ainda adquiridas pelo objeto.
+ */
+dsf_TPMPeripheral_ocp::~dsf_TPMPeripheral_ocp() {
+  disablePeripheralClock();
+  disableGPIOClock();
+}
+
+/*!
+ *   @fn         bindPeripheral
+ *
+ *   @brief      Associa o objeto de software ao periférico de hardware.
+ *
+ *   Este método associa ao objeto de software o periférico de hardware,
+ *   utilizando a inicialização dos ponteiros para os endereços de memória
+ *   dos registradores correspondentes.
+ *
+ *   @param[in]  baseAddress - o endereço base do periférico TPM.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ *               - TPMxCNT: Counter Register. Pág.554.
+ *               - TPMxMOD: Modulo Register. Pág. 554.
+ */
+
+void dsf_TPMPeripheral_ocp::bindPeripheral(uint8_t *baseAddress) {
+  addressTPMxSC = (volatile uint32_t *)(baseAddress);
+  addressTPMxCNT = (volatile uint32_t *)(baseAddress + 0x4);
+  addressTPMxMOD = (volatile uint32_t *)(baseAddress + 0x8);
+  TPMIndex = (uint8_t)(((uintptr_t)baseAddress - TPM0_BASE) >> 12);
+}
+
+/*!
+ *   @fn         bindChannel
+ *
+ *   @brief      Associa o canal do objeto de software ao hardware
+ *
+ *   Este método associa os atributos do canal do objeto de software ao
+ *   seu correspondente do periférico hardware.
+ *
+ *   @param[in]  baseAddress - o endereço base do periférico TPM.
+ *               chnNumber - o número do canal do periférico TPM.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - TPMxCnV: Channel Value Register. Pág.557.
+ *               - TPMxCnSC: Channel Status Control Register. Pág.555.
+ */
+void dsf_TPMPeripheral_ocp::bindChannel(uint8_t *baseAddress,
+                                        uint8_t chnNumber) {
+  addressTPMxCnV = (volatile uint32_t *)(baseAddress + 0x10 + 8*chnNumber);
+  addressTPMxCnSC = (volatile uint32_t *)(baseAddress + 0xC + 8*chnNumber);
+}
+
+
+/*!
+ *   @fn         bindPin
+ *
+ *   @brief      Associa o pino do objeto ao periférico de hardare.
+ *
+ *   Este método associa o pino do objeto de software ao pino do periférico.
+ *
+ *   @param[in]  pinNumber - o número do pino do objeto de software.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - PCR: Pin Control Register. Pág.183.
+ */
+void dsf_TPMPeripheral_ocp::bindPin(uint8_t GPIONumber, uint8_t pinNumber) {
+  addressPortxPCRn = (volatile uint32_t *)(0x40049000
+                                          + 0x1000*GPIONumber + 4*pinNumber);
+}
+
+
+/*!
+ *   @fn         enablePeripheralClock
+ *
+ *   @brief      Habilita o clock do periférico de hardware.
+ *
+ *   Este método adquire o clock do periférico TPM solicitado no gerenciador
+ *   dsf_ClockGate_ocp. Chamadas repetidas não adquirem o clock novamente.
+ *   A fonte de clock dos TPMs só é escrita no SOPT2 quando difere da
+ *   cópia de sombra.
+ *
+ *   @param[in]  TPMNumber - o número do periférico TPM.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - SCGC6: System Control Gating Clock Register 6. Pág.207.
+ *               - SOPT2: System Options Register 2. Pág.195.
+ */
+void dsf_TPMPeripheral_ocp::enablePeripheralClock(uint8_t TPMNumber) {
+  if (peripheralGate != ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  peripheralGate = (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_TPM0 + TPMNumber);
+  dsf_ClockGate_ocp::acquire(peripheralGate);
+#ifdef DSF_SHADOW_CHECK
+  /*!
+   * Sem contar divergência: o setProfile escreve o TPMSRC sem a cópia.
+   */
+  shadowSource = (SIM_SOPT2 >> 24) & 3;
+#endif
+  if (shadowSource != dsf_MCG_ocp::timerSource()) {
+    shadowSource = dsf_MCG_ocp::timerSource();
+    dsf_BME_ocp::insertField(&SIM_SOPT2, 24, 2, shadowSource);
+  }
+}
+
+/*!
+ *   @fn         disablePeripheralClock
+ *
+ *   @brief      Libera o clock do periférico de hardware.
+ *
+ *   Este método libera o clock do periférico TPM no gerenciador
+ *   dsf_ClockGate_ocp, que o desliga quando não há outros usuários.
+ *   Após a liberação, os registradores do TPM não devem ser acessados.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - SCGC6: System Control Gating Clock Register 6. Pág.207.
+ */
+void dsf_TPMPeripheral_ocp::disablePeripheralClock() {
+  if (peripheralGate == ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  dsf_ClockGate_ocp::release(peripheralGate);
+  peripheralGate = ClockGate_t::dsf_NumGates;
+}
+
+/*!
+ *   @fn         enableGPIOClock
+ *
+ *   @brief      Habilita o clock do GPIO do pino.
+ *
+ *   Este método adquire o clock do periférico GPIO do pino passado por
+ *   parâmetro no gerenciador dsf_ClockGate_ocp.
+ *
+ *   @param[in]  GPIONumber - o número do GPIO correspondente ao pino.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - SCGC5: System Control Gating Clock Register 5. Pág.199.
+ */
+void dsf_TPMPeripheral_ocp::enableGPIOClock(uint8_t GPIONumber) {
+  if (GPIOGate != ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  GPIOGate = (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA + GPIONumber);
+  dsf_ClockGate_ocp::acquire(GPIOGate);
+}
+
+/*!
+ *   @fn         disableGPIOClock
+ *
+ *   @brief      Libera o clock do GPIO do pino.
+ *
+ *   Este método libera o clock do GPIO do pino no gerenciador
+ *   dsf_ClockGate_ocp.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - SCGC5: System Control Gating Clock Register 5. Pág.199.
+ */
+void dsf_TPMPeripheral_ocp::disableGPIOClock() {
+  if (GPIOGate == ClockGate_t::dsf_NumGates) {
+    return;
+  }
+  dsf_ClockGate_ocp::release(GPIOGate);
+  GPIOGate = ClockGate_t::dsf_NumGates;
+}
+
+/*!
+ *   @fn         selectMuxAlternative
+ *
+ *   @brief      Seleciona a alternativa de trabalho do pino.
+ *
+ *   Este método seleciona o modo de operação do pino correspondente para o
+ *   modo de operação TPM.
+ *
+ *   @param[in]  muxAlt - alternativa de operação do pino para o canal e TPM
+ *                        especificados.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - PCR: Pin Control Register. Pág.183.
+ */
+void dsf_TPMPeripheral_ocp::selectMuxAlternative(uint8_t muxAlt) {
+  *addressPortxPCRn = PORT_PCR_MUX(muxAlt);
+}
+
+/*!
+ *   @fn         writeSC
+ *
+ *   @brief      Escreve o TPMxSC se a configuração mudou.
+ *
+ *   A escrita é omitida quando o valor é igual à cópia de sombra e não
+ *   contém o TOF (0x80), que é write-1-to-clear e não fica na cópia.
+ *
+ *   @param[in]  control - o novo valor do TPMxSC.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ */
+void dsf_TPMPeripheral_ocp::writeSC(uint32_t control) {
+  verifyShadow();
+  if (!(control & 0x80) && control == shadowSC[TPMIndex]) {
+    return;
+  }
+  *addressTPMxSC = control;
+  shadowSC[TPMIndex] = control & ~0x80u;
+}
+
+/*!
+ *   @fn         writeMOD
+ *
+ *   @brief      Escreve o TPMxMOD se o fundo de escala mudou.
+ *
+ *   Com o contador ligado, o hardware só adota o novo valor no próximo
+ *   overflow; a cópia guarda o valor escrito, que é o lido de volta.
+ *
+ *   @param[in]  modulo - o novo fundo de escala.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - TPMxMOD: Modulo Register. Pág. 554.
+ */
+void dsf_TPMPeripheral_ocp::writeMOD(uint32_t modulo) {
+  verifyShadow();
+  if (modulo == shadowMOD[TPMIndex]) {
+    return;
+  }
+  *addressTPMxMOD = modulo;
+  shadowMOD[TPMIndex] = modulo;
+}
+
+/*!
+ *   @fn         restartCounter
+ *
+ *   @brief      Reinicia a contagem do zero com um novo MOD e SC.
+ *
+ *   A configuração nova é comparada com as cópias antes de qualquer
+ *   acesso. O contador só é parado quando estava ligado e o MOD ou a
+ *   configuração mudam, pois o prescaler e o MOD só podem ser trocados com
+ *   a contagem parada; o MOD só é escrito quando muda. O pior caso são as
+ *   quatro escritas de antes (SC, CNT, MOD, SC); com o TPM parado e o
+ *   mesmo MOD, restam o CNT e o SC.
+ *
+ *   @param[in]  modulo - o fundo de escala.
+ *               control - o TPMxSC final, com o TOF para limpá-lo.
+ *
+ *   @remarks    Sigla e pagina do Manual de Referencia KL25:
+ *               - TPMxSC: Status Control Register. Pág. 552.
+ *               - TPMxCNT: Counter Register. Pág.554.
+ *               - TPMxMOD: Modulo Register. Pág. 554.
+ */
+void dsf_TPMPeripheral_ocp::restartCounter(uint32_t modulo,
+                                           uint32_t control) {
+  uint32_t &sc = shadowSC[TPMIndex];
+
+  verifyShadow();
+  if ((sc & 0x18) && (modulo != shadowMOD[TPMIndex]
+                      || (control & ~0x80u) != sc)) {
+    *addressTPMxSC = 0;
+    sc = 0;
+  }
+  *addressTPMxCNT = 0;
+  if (modulo != shadowMOD[TPMIndex]) {
+    *addressTPMxMOD = modulo;
+    shadowMOD[TPMIndex] = modulo;
+  }
+  if ((control & 0x80) || control != sc) {
+    *addressTPMxSC = control;
+    sc = control & ~0x80u;
+  }
+}
+
+/*!
+ *   @fn         shadowMismatches
+ *
+ *   @brief      Informa as divergências encontradas entre as cópias e o
+ *               hardware.
+ *
+ *   @return     O número de divergências; sempre 0 sem -DDSF_SHADOW_CHECK.
+ */
+uint32_t dsf_TPMPeripheral_ocp::shadowMismatches() {
+  return mismatches;
+}
+
+/*!
+ *   @fn         verifyShadow
+ *
+ *   @brief      Confere as cópias de sombra com o hardware.
+ *
+ *   Com -DDSF_SHADOW_CHECK, lê o SC e o MOD antes de cada escrita; uma
+ *   divergência (um acesso direto ao TPM fora destes métodos) é contada e
+ *   a cópia adota o valor lido. Sem o flag, o método é vazio.
+ */
+void dsf_TPMPeripheral_ocp::verifyShadow() {
+#ifdef DSF_SHADOW_CHECK
+  uint32_t control = *addressTPMxSC & 0x17F;
+  uint32_t modulo = *addressTPMxMOD & 0xFFFF;
+
+  if (control != shadowSC[TPMIndex] || modulo != shadowMOD[TPMIndex]) {
+    mismatches++;
+    shadowSC[TPMIndex] = control;
+    shadowMOD[TPMIndex] = modulo;
+  }
+#endif
+}
@@ -1,177 +1,246 @@
-/*!
- * @copyright    2017 Universidade Federal do Amazonas.
- *
- * @brief       Interface da classe me "dsf_TPMPeripheral_ocp".
- *
- * @file        dsf_TPM_ocp.h
- * @version     1.0
- * @date        02 Agosto 2017
- *
- * @section     HARDWARES & SOFTWARES
- *              +board        FRDM-KL25Z da NXP.
- *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
- *              +peripheral   TPM.
- *              +compiler     Kinetis Design Studio IDE.
- *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
- *              +revisions    Verso (data): Descrio breve.
- *                             ++ 1.0 (02 Agosto 2017): Verso inicial.
- *
- * @section     AUTHORS & DEVELOPERS
- *              +institution  Universidade Federal do Amazonas.
- *              +courses      Engenharia da Computao / Engenharia Eltrica.
- *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
- *              +student      Verso inicial:
- *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
- *
- * @section     LICENSE
- *
- *              GNU General Public License (GNU GPL).
- *
- *              Este programa  um software livre; Voc pode redistribu-lo
- *              e/ou modific-lo de acordo com os termos do "GNU General Public
- *              License" como publicado pela Free Software Foundation; Seja a
- *              verso 3 da licena, ou qualquer verso posterior.
- *
- *              Este programa  distribudo na esperana de que seja til,
- *              mas SEM QUALQUER GARANTIA; Sem a garantia implcita de
- *              COMERCIALIZAO OU USO PARA UM DETERMINADO PROPSITO.
- *              Veja o site da "GNU General Public License" para mais detalhes.
- *
- * @htmlonly    http://www.gnu.org/copyleft/gpl.html
- */
-
-#ifndef DSF_TPM_OCP_H_
-#define DSF_TPM_OCP_H_
-
-#include <MKL25Z4.h>
-#include <stdint.h>
-
-/*!
- * Namespace associado  mascara do GPIO, canal, TPM e alternativa do mux PCR.
- */
-namespace Pin {
-  enum GPIOMask_t {
-    dsf_GPIOA = 0,
-    dsf_GPIOB = 1<<5,
-    dsf_GPIOC = 2<<5,
-    dsf_GPIOD = 3<<5,
-    dsf_GPIOE = 4<<5
-  };
-
-  enum TPMChnMask_t {
-    dsf_CH0 = 0,
-    dsf_CH1 = 1<<8,
-    dsf_CH2 = 2<<8,
-    dsf_CH3 = 3<<8,
-    dsf_CH4 = 4<<8,
-    dsf_CH5 = 5<<8
-  };
-
-  enum TPMMask_t {
-    dsf_TPM0 = 0,
-    dsf_TPM1 = 1<<11,
-    dsf_TPM2 = 2<<11
-  };
-
-  enum muxAltMask {
-    dsf_Alt3 = 3<<13,
-    dsf_Alt4 = 4<<13
-  };
-}  //  namespace Pin
-
-/*!
- * Namespace associado ao fator de diviso do divisor de frequncia.
- */
-namespace TPMDiv_t {
-  enum TPMDiv {Div1 = 0, Div2, Div4, Div8, Div16, Div32, Div64, Div128};
-}
-
-/*!
- * Namespace associado  borda de transio de deteco.
- */
-namespace TPMEdge_t {
-  enum TPMEdge {Falling = 1, Rising, Both};
-}  //  namespace TPMEdge_t
-
-/*!
- * Namespace associado ao perifrico TPM e seus pinos correspondentes.
- */
-namespace TPM_t {
-  enum TPMNumber_t {
-    dsf_TPM0 = 0,
-    dsf_TPM1 = 1,
-    dsf_TPM2 = 2
-  };
-
-  enum Pin_t {
-    dsf_TPM0_PTA0 = 0|Pin::dsf_GPIOA|Pin::dsf_CH5|Pin::dsf_Alt3,
-    dsf_TPM0_PTA3 = 3|Pin::dsf_GPIOA|Pin::dsf_CH0|Pin::dsf_Alt3,
-    dsf_TPM0_PTA4 = 4|Pin::dsf_GPIOA|Pin::dsf_CH1|Pin::dsf_Alt3,
-    dsf_TPM0_PTA5 = 5|Pin::dsf_GPIOA|Pin::dsf_CH2|Pin::dsf_Alt3,
-    dsf_TPM0_PTC1 = 1|Pin::dsf_GPIOC|Pin::dsf_CH0|Pin::dsf_Alt4,
-    dsf_TPM0_PTC2 = 2|Pin::dsf_GPIOC|Pin::dsf_CH1|Pin::dsf_Alt4,
-    dsf_TPM0_PTC3 = 3|Pin::dsf_GPIOC|Pin::dsf_CH2|Pin::dsf_Alt4,
-    dsf_TPM0_PTC4 = 4|Pin::dsf_GPIOC|Pin::dsf_CH3|Pin::dsf_Alt4,
-    dsf_TPM0_PTC8 = 8|Pin::dsf_GPIOC|Pin::dsf_CH4|Pin::dsf_Alt3,
-    dsf_TPM0_PTC9 = 9|Pin::dsf_GPIOC|Pin::dsf_CH5|Pin::dsf_Alt3,
-    dsf_TPM0_PTD0 = 0|Pin::dsf_GPIOD|Pin::dsf_CH0|Pin::dsf_Alt4,
-    dsf_TPM0_PTD1 = 1|Pin::dsf_GPIOD|Pin::dsf_CH1|Pin::dsf_Alt4,
-    dsf_TPM0_PTD2 = 2|Pin::dsf_GPIOD|Pin::dsf_CH2|Pin::dsf_Alt4,
-    dsf_TPM0_PTD3 = 3 |Pin::dsf_GPIOD|Pin::dsf_CH3|Pin::dsf_Alt4,
-    dsf_TPM0_PTD4 = 4|Pin::dsf_GPIOD|Pin::dsf_CH4|Pin::dsf_Alt4,
-    dsf_TPM0_PTD5 = 5|Pin::dsf_GPIOD|Pin::dsf_CH5|Pin::dsf_Alt4,
-    dsf_TPM0_PTE29 = 29|Pin::dsf_GPIOE|Pin::dsf_CH2|Pin::dsf_Alt3,
-    dsf_TPM0_PTE30 = 30|Pin::dsf_GPIOE|Pin::dsf_CH3|Pin::dsf_Alt3,
-    dsf_TPM1_PTA12 = 12|Pin::dsf_GPIOA|Pin::dsf_CH0|Pin::dsf_Alt3,
-    dsf_TPM1_PTA13 = 13|Pin::dsf_GPIOA|Pin::dsf_CH1|Pin::dsf_Alt3,
-    dsf_TPM1_PTB0 = 0|Pin::dsf_GPIOB|Pin::dsf_CH0|Pin::dsf_Alt3,
-    dsf_TPM1_PTB1 = 1|Pin::dsf_GPIOB|Pin::dsf_CH1|Pin::dsf_Alt3,
-    dsf_TPM1_PTE20 = 20|Pin::dsf_GPIOE|Pin::dsf_CH0|Pin::dsf_Alt3,
-    dsf_TPM1_PTE21 = 21|Pin::dsf_GPIOE|Pin::dsf_CH1|Pin::dsf_Alt3,
-    dsf_TPM2_PTA1 = 1|Pin::dsf_GPIOA|Pin::dsf_CH0|Pin::dsf_Alt3,
-    dsf_TPM2_PTA2 = 2|Pin::dsf_GPIOA|Pin::dsf_CH1|Pin::dsf_Alt3,
-    dsf_TPM2_PTE22 = 22|Pin::dsf_GPIOE|Pin::dsf_CH0|Pin::dsf_Alt3,
-    dsf_TPM2_PTE23 = 23|Pin::dsf_GPIOE|Pin::dsf_CH1|Pin::dsf_Alt3
-  };
-}  //  namespace TPM_t
-
-/*!
- *  @class    dsf_TPMPeripheral_ocp.
- *
- *  @brief    A classe me "dsf_TPMPeripheral_ocp" representa o perifrico TPM.
- *
- *  @details  Esta classe  utilizada como classe me para os perifricos que
- *            esto associados ao TPM, como o dsf_Delay_ocp, dsf_Measure_ocp,
- *            dsf_EventCounter_ocp, dsf_PWM_ocp.
- */
-class dsf_TPMPeripheral_ocp {
- protected:
-  /*!
-   * Endereos dos registradores associados ao perifrico TPM e seus canais.
-   */
-  volatile uint32_t *addressTPMxSC;
-  volatile uint32_t *addressTPMxMOD;
-  volatile uint32_t *addressTPMxCNT;
-  volatile uint32_t *addressTPMxCnV;
-  volatile uint32_t *addressTPMxCnSC;
-  volatile uint32_t *addressPortxPCRn;
-
-  /*!
-   * Mtodos de bind do perifrico, dos seus canais e do pino escolhido.
-   */
-  void bindPeripheral(uint8_t*);
-  void bindChannel(uint8_t*, uint8_t);
-  void bindPin(uint8_t, uint8_t);
-
-  /*!
-   * Mtodos de habilitao de clock do perifrico e da porta.
-   */
-  void enablePeripheralClock(uint8_t);
-  void enableGPIOClock(uint8_t);
-  /*!
-   * Mtodo de seleo do mux do pino.
-   */
-  void selectMuxAlternative(uint8_t);
-};
-
-#endif
+/*!
+ * @copyright   © 2017 Universidade Federal do Amazonas.
+ *
+ * @brief       Interface da classe mãe "dsf_TPMPeripheral_ocp".
+ *
+ * @file        dsf_TPM_ocp.h
+ * @version     1.0
+ * @date        02 Agosto 2017
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TPM.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (02 Agosto 2017): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *              +student      Versão inicial:
+ *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_TPM_OCP_H_
+#define DSF_TPM_OCP_H_
+
+#include <MKL25Z4.h>
+#include <stdint.h>
+#include "dsf_ClockGate_ocp.h"
+#include "dsf_MCG_ocp.h"
+
+/*!
+ * Namespace associado à mascara do GPIO, canal, TPM e alternativa do mux PCR.
+ */
+namespace Pin {
+  enum GPIOMask_t {
+    dsf_GPIOA = 0,
+    dsf_GPIOB = 1<<5,
+    dsf_GPIOC = 2<<5,
+    dsf_GPIOD = 3<<5,
+    dsf_GPIOE = 4<<5
+  };
+
+  enum TPMChnMask_t {
+    dsf_CH0 = 0,
+    dsf_CH1 = 1<<8,
+    dsf_CH2 = 2<<8,
+    dsf_CH3 = 3<<8,
+    dsf_CH4 = 4<<8,
+    dsf_CH5 = 5<<8
+  };
+
+  enum TPMMask_t {
+    dsf_TPM0 = 0,
+    dsf_TPM1 = 1<<11,
+    dsf_TPM2 = 2<<11
+  };
+
+  enum muxAltMask {
+    dsf_Alt3 = 3<<13,
+    dsf_Alt4 = 4<<13
+  };
+}  //  namespace Pin
+
+/*!
+ * Namespace associado ao fator de divisão do divisor de frequência.
+ */
+namespace TPMDiv_t {
+  enum TPMDiv {Div1 = 0, Div2, Div4, Div8, Div16, Div32, Div64, Div128};
+}
+
+/*!
+ * Namespace associado à borda de transição de detecção.
+ */
+namespace TPMEdge_t {
+  enum TPMEdge {Falling = 1, Rising, Both};
+}  //  namespace TPMEdge_t
+
+/*!
+ * Namespace associado ao periférico TPM e seus pinos correspondentes.
+ */
+namespace TPM_t {
+  enum TPMNumber_t {
+    dsf_TPM0 = 0,
+    dsf_TPM1 = 1,
+    dsf_TPM2 = 2,
+    dsf_NumTPMs = 3
+  };
+
+  enum Pin_t {
+    dsf_TPM0_PTA0 = 0|Pin::dsf_GPIOA|Pin::dsf_CH5|Pin::dsf_Alt3,
+    dsf_TPM0_PTA3 = 3|Pin::dsf_GPIOA|Pin::dsf_CH0|Pin::dsf_Alt3,
+    dsf_TPM0_PTA4 = 4|Pin::dsf_GPIOA|Pin::dsf_CH1|Pin::dsf_Alt3,
+    dsf_TPM0_PTA5 = 5|Pin::dsf_GPIOA|Pin::dsf_CH2|Pin::dsf_Alt3,
+    dsf_TPM0_PTC1 = 1|Pin::dsf_GPIOC|Pin::dsf_CH0|Pin::dsf_Alt4,
+    dsf_TPM0_PTC2 = 2|Pin::dsf_GPIOC|Pin::dsf_CH1|Pin::dsf_Alt4,
+    dsf_TPM0_PTC3 = 3|Pin::dsf_GPIOC|Pin::dsf_CH2|Pin::dsf_Alt4,
+    dsf_TPM0_PTC4 = 4|Pin::dsf_GPIOC|Pin::dsf_CH3|Pin::dsf_Alt4,
+    dsf_TPM0_PTC8 = 8|Pin::dsf_GPIOC|Pin::dsf_CH4|Pin::dsf_Alt3,
+    dsf_TPM0_PTC9 = 9|Pin::dsf_GPIOC|Pin::dsf_CH5|Pin::dsf_Alt3,
+    dsf_TPM0_PTD0 = 0|Pin::dsf_GPIOD|Pin::dsf_CH0|Pin::dsf_Alt4,
+    dsf_TPM0_PTD1 = 1|Pin::dsf_GPIOD|Pin::dsf_CH1|Pin::dsf_Alt4,
+    dsf_TPM0_PTD2 = 2|Pin::dsf_GPIOD|Pin::dsf_CH2|Pin::dsf_Alt4,
+    dsf_TPM0_PTD3 = 3 |Pin::dsf_GPIOD|Pin::dsf_CH3|Pin::dsf_Alt4,
+    dsf_TPM0_PTD4 = 4|Pin::dsf_GPIOD|Pin::dsf_CH4|Pin::dsf_Alt4,
+    dsf_TPM0_PTD5 = 5|Pin::dsf_GPIOD|Pin::dsf_CH5|Pin::dsf_Alt4,
+    dsf_TPM0_PTE29 = 29|Pin::dsf_GPIOE|Pin::dsf_CH2|Pin::dsf_Alt3,
+    dsf_TPM0_PTE30 = 30|Pin::dsf_GPIOE|Pin::dsf_CH3|Pin::dsf_Alt3,
+    dsf_TPM1_PTA12 = 12|Pin::dsf_GPIOA|Pin::dsf_CH0|Pin::dsf_TPM1|Pin::dsf_Alt3,
+    dsf_TPM1_PTA13 = 13|Pin::dsf_GPIOA|Pin::dsf_CH1|Pin::dsf_TPM1|Pin::dsf_Alt3,
+    dsf_TPM1_PTB0 = 0|Pin::dsf_GPIOB|Pin::dsf_CH0|Pin::dsf_TPM1|Pin::dsf_Alt3,
+    dsf_TPM1_PTB1 = 1|Pin::dsf_GPIOB|Pin::dsf_CH1|Pin::dsf_TPM1|Pin::dsf_Alt3,
+    dsf_TPM1_PTE20 = 20|Pin::dsf_GPIOE|Pin::dsf_CH0|Pin::dsf_TPM1|Pin::dsf_Alt3,
+    dsf_TPM1_PTE21 = 21|Pin::dsf_GPIOE|Pin::dsf_CH1|Pin::dsf_TPM1|Pin::dsf_Alt3,
+    dsf_TPM2_PTA1 = 1|Pin::dsf_GPIOA|Pin::dsf_CH0|Pin::dsf_TPM2|Pin::dsf_Alt3,
+    dsf_TPM2_PTA2 = 2|Pin::dsf_GPIOA|Pin::dsf_CH1|Pin::dsf_TPM2|Pin::dsf_Alt3,
+    dsf_TPM2_PTE22 = 22|Pin::dsf_GPIOE|Pin::dsf_CH0|Pin::dsf_TPM2|Pin::dsf_Alt3,
+    dsf_TPM2_PTE23 = 23|Pin::dsf_GPIOE|Pin::dsf_CH1|Pin::dsf_TPM2|Pin::dsf_Alt3
+  };
+}  //  namespace TPM_t
+
+/*!
+ *  @class    dsf_TPMPeripheral_ocp.
+ *
+ *  @brief    A classe mãe "dsf_TPMPeripheral_ocp" representa o periférico TPM.
+ *
+ *  @details  Esta classe é utilizada como classe mãe para os periféricos que
+ *            estão associados ao TPM, como o dsf_Delay_ocp, dsf_Measure_ocp,
+ *            dsf_EventCounter_ocp, dsf_PWM_ocp.
+ *
+ *            O SC (sem o TOF) e o MOD de cada TPM têm cópias de sombra,
+ *            compartilhadas pelos objetos do mesmo TPM. writeSC, writeMOD
+ *            e restartCounter montam a configuração nova a partir delas e
+ *            só escrevem os registradores que mudam, sem leituras; o
+ *            TPMSRC do SIM_SOPT2 também só é escrito quando muda. Com
+ *            -DDSF_SHADOW_CHECK, cada escrita confere antes as cópias com
+ *            o hardware, conta as divergências e adota o valor lido.
+ */
+class dsf_TPMPeripheral_ocp {
+ public:
+  /*!
+   * Número de divergências entre as cópias de sombra e o hardware
+   * encontradas com -DDSF_SHADOW_CHECK.
+   */
+  static uint32_t shadowMismatches();
+
+ protected:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  dsf_TPMPeripheral_ocp();
+  ~dsf_TPMPeripheral_ocp();
+
+  /*!
+   * Endereços dos registradores associados ao periférico TPM e seus canais.
+   */
+  volatile uint32_t *addressTPMxSC;
+  volatile uint32_t *addressTPMxMOD;
+  volatile uint32_t *addressTPMxCNT;
+  volatile uint32_t *addressTPMxCnV;
+  volatile uint32_t *addressTPMxCnSC;
+  volatile uint32_t *addressPortxPCRn;
+
+  /*!
+   * Portas de clock do TPM e do GPIO do pino adquiridas pelo objeto.
+   */
+  ClockGate_t::dsf_Gate peripheralGate;
+  ClockGate_t::dsf_Gate GPIOGate;
+
+  /*!
+   * Métodos de bind do periférico, dos seus canais e do pino escolhido.
+   */
+  void bindPeripheral(uint8_t*);
+  void bindChannel(uint8_t*, uint8_t);
+  void bindPin(uint8_t, uint8_t);
+
+  /*!
+   * Métodos de habilitação e liberação de clock do periférico e da porta.
+   */
+  void enablePeripheralClock(uint8_t);
+  void disablePeripheralClock();
+  void enableGPIOClock(uint8_t);
+  void disableGPIOClock();
+  /*!
+   * Método de seleção do mux do pino.
+   */
+  void selectMuxAlternative(uint8_t);
+
+  /*!
+   * Métodos de escrita do SC e do MOD pelas cópias de sombra. Exigem o
+   * clock do TPM adquirido.
+   */
+  void writeSC(uint32_t control);
+  void writeMOD(uint32_t modulo);
+  void restartCounter(uint32_t modulo, uint32_t control);
+
+  /*!
+   *   @fn         clearOverflow
+   *
+   *   @brief      Limpa o TOF com uma escrita da configuração atual.
+   */
+  void clearOverflow() {
+    *addressTPMxSC = shadowSC[TPMIndex] | 0x80;
+  }
+
+ private:
+  /*!
+   * Índice do TPM nas cópias de sombra.
+   */
+  uint8_t TPMIndex;
+  /*!
+   * Cópias de sombra do SC (sem o TOF) e do MOD de cada TPM.
+   */
+  static uint32_t shadowSC[TPM_t::dsf_NumTPMs];
+  static uint32_t shadowMOD[TPM_t::dsf_NumTPMs];
+  /*!
+   * Cópia de sombra do TPMSRC do SIM_SOPT2. O dsf_MCG_ocp::setProfile
+   * também o escreve, sempre com o timerSource do novo perfil: uma cópia
+   * desatualizada só provoca uma escrita repetida.
+   */
+  static uint32_t shadowSource;
+  static uint32_t mismatches;
+
+  void verifyShadow();
+};
+
+#endif
@@ -0,0 +1,364 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para o sensor capacitivo TSI em segundo plano.
+ *
+ * @file        dsf_TSI_ocp.cpp
+ * @version     1.0
+ * @date        31 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TSI, LPTMR, PORT e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (31 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_TSI_ocp.h"
+
+/*!
+ * Registradores do TSI0 (pág. 581) e do LPTMR0 (pág. 589).
+ */
+#define DSF_TSI_GENCS   (*(volatile uint32_t *)0x40045000)
+#define DSF_TSI_DATA    (*(volatile uint32_t *)0x40045004)
+#define DSF_LPTMR_CSR   (*(volatile uint32_t *)0x40040000)
+#define DSF_LPTMR_PSR   (*(volatile uint32_t *)0x40040004)
+#define DSF_LPTMR_CMR   (*(volatile uint32_t *)0x40040008)
+
+/*!
+ * Campos do TSI0_GENCS: ESOR (28), REFCHRG (23:21), EXTCHRG (18:16),
+ * PS (15:13), NSCN (12:8), TSIEN (7), TSIIEN (6), STPE (5), STM (4) e
+ * EOSF (2). Configuração: corrente de referência de 8 uA, corrente
+ * externa de 64 uA, prescaler 16 e 12 varreduras por medida, com disparo
+ * por hardware e interrupção de fim de varredura.
+ */
+namespace {
+
+const uint32_t kGENCS = (1u << 28) | (4u << 21) | (7u << 16) | (4u << 13)
+                        | (11u << 8) | (1u << 7) | (1u << 6) | (1u << 5)
+                        | (1u << 4);
+const uint32_t kEOSF = 1u << 2;
+
+/*!
+ * GPIO e pino de cada canal do TSI (Signal Multiplexing, pág. 161).
+ */
+const uint8_t kChannelGPIO[16] = {1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 2,
+                                  2, 2};
+const uint8_t kChannelPin[16] = {0, 0, 1, 2, 3, 4, 1, 2, 3, 16, 17, 18, 19,
+                                 0, 1, 2};
+
+}  // namespace
+
+/*!
+ *   @fn         dsf_TSI_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método associa o objeto aos eletrodos e seleciona a função TSI
+ *   (ALT0) nos pinos correspondentes.
+ *
+ *   @param[in]  channels - canal do TSI de cada eletrodo (TSI_t::dsf_Channel).
+ *               electrodes - número de eletrodos, até
+ *               TSI_t::dsf_MaxElectrodes.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - PortxPCRn: Pin Control Register. Pág. 183.
+ */
+dsf_TSI_ocp::dsf_TSI_ocp(const uint8_t *channels, uint8_t electrodes) {
+  electrodeCount = electrodes < TSI_t::dsf_MaxElectrodes ?
+                   electrodes : (uint8_t)TSI_t::dsf_MaxElectrodes;
+  current = 0;
+  touched = 0;
+  touchDelta = TSI_t::dsf_TouchDelta;
+  releaseDelta = TSI_t::dsf_ReleaseDelta;
+  scanNumber = 0;
+  running = false;
+
+  for (uint8_t e = 0; e < electrodeCount; e++) {
+    uint8_t GPIONumber = kChannelGPIO[channels[e] & 15];
+
+    channel[e] = channels[e] & 15;
+    baseline16[e] = 0;
+    lastDelta[e] = 0;
+    calibration[e] = 0;
+    portGate[e] = (ClockGate_t::dsf_Gate)(ClockGate_t::dsf_PORTA + GPIONumber);
+    dsf_ClockGate_ocp::acquire(portGate[e]);
+    *(volatile uint32_t *)(0x40049000 + 0x1000*GPIONumber
+                           + 4*kChannelPin[channel[e]]) = PORT_PCR_MUX(0);
+  }
+}
+
+/*!
+ *   @fn         ~dsf_TSI_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ *
+ *   Este método para a varredura e libera os clocks dos PORTs.
+ */
+dsf_TSI_ocp::~dsf_TSI_ocp() {
+  stop();
+  for (uint8_t e = 0; e < electrodeCount; e++) {
+    dsf_ClockGate_ocp::release(portGate[e]);
+  }
+}
+
+/*!
+ *   @fn         setThresholds
+ *
+ *   @brief      Ajusta os limiares de toque e de liberação.
+ *
+ *   @param[in]  touch - diferença para a linha de base que indica toque.
+ *               release - diferença abaixo da qual o toque é liberado,
+ *               menor que touch.
+ */
+void dsf_TSI_ocp::setThresholds(uint16_t touch, uint16_t release) {
+  touchDelta = touch;
+  releaseDelta = release < touch ? release : touch;
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Inicia a varredura em segundo plano.
+ *
+ *   O LPTMR conta o LPO de 1 kHz sem prescaler e dispara uma varredura
+ *   do eletrodo selecionado a cada periodMs ms; a linha de base é
+ *   recalibrada.
+ *
+ *   @param[in]  periodMs - intervalo entre varreduras, de 1 a 65535 ms.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - TSI0_GENCS: General Control and Status Register. Pág. 581.
+ *               - TSI0_DATA: Data Register. Pág. 586.
+ *               - LPTMR0_CSR: Control Status Register. Pág. 593.
+ */
+void dsf_TSI_ocp::start(uint16_t periodMs) {
+  if (electrodeCount == 0 || periodMs == 0) {
+    return;
+  }
+  stop();
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_TSI);
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_LPTMR);
+  running = true;
+
+  current = 0;
+  touched = 0;
+  for (uint8_t e = 0; e < electrodeCount; e++) {
+    baseline16[e] = 0;
+    lastDelta[e] = 0;
+    calibration[e] = 0;
+  }
+
+  DSF_TSI_GENCS = 0;
+  DSF_TSI_DATA = (uint32_t)channel[0] << 28;
+  DSF_TSI_GENCS = kGENCS | kEOSF;
+  NVIC_ClearPendingIRQ(TSI0_IRQn);
+  NVIC_EnableIRQ(TSI0_IRQn);
+
+  /*!
+   * LPTMR: LPO (PCS = 1) sem prescaler (PBYP), contador zerado a cada
+   * comparação (TFC = 0).
+   */
+  DSF_LPTMR_CSR = 0;
+  DSF_LPTMR_PSR = (1u << 2) | 1u;
+  DSF_LPTMR_CMR = (uint32_t)(periodMs - 1);
+  DSF_LPTMR_CSR = 1u;
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para a varredura e libera os clocks do TSI e do LPTMR.
+ */
+void dsf_TSI_ocp::stop() {
+  if (!running) {
+    return;
+  }
+  DSF_LPTMR_CSR = 0;
+  NVIC_DisableIRQ(TSI0_IRQn);
+  DSF_TSI_GENCS = kEOSF;
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_LPTMR);
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_TSI);
+  running = false;
+}
+
+/*!
+ *   @fn         irqHandler
+ *
+ *   @brief      Trata a interrupção de fim de varredura.
+ *
+ *   Lê a contagem, limpa EOSF com uma única escrita da configuração e
+ *   seleciona o próximo eletrodo antes do próximo disparo do LPTMR.
+ */
+void dsf_TSI_ocp::irqHandler() {
+  uint8_t electrode = current;
+  uint16_t count = (uint16_t)DSF_TSI_DATA;
+
+  DSF_TSI_GENCS = kGENCS | kEOSF;
+  if (++current >= electrodeCount) {
+    current = 0;
+  }
+  DSF_TSI_DATA = (uint32_t)channel[current] << 28;
+  update(electrode, count);
+}
+
+/*!
+ *   @fn         update
+ *
+ *   @brief      Atualiza a linha de base e o estado de toque de um eletrodo.
+ *
+ *   @param[in]  electrode - eletrodo varrido.
+ *               count - contagem TSICNT da varredura.
+ */
+void dsf_TSI_ocp::update(uint8_t electrode, uint16_t count) {
+  uint32_t bit = 1u << electrode;
+  int32_t difference;
+  dsf_Event event;
+
+  if (electrode == 0) {
+    scanNumber++;
+  }
+  if (calibration[electrode] < TSI_t::dsf_CalibrationScans) {
+    /*!
+     * A soma das amostras vira a média, em 1/16 de contagem, na última
+     * varredura de calibração.
+     */
+    baseline16[electrode] += count;
+    if (++calibration[electrode] == TSI_t::dsf_CalibrationScans) {
+      baseline16[electrode] = (baseline16[electrode] << 4)
+                              / TSI_t::dsf_CalibrationScans;
+    }
+    return;
+  }
+
+  difference = (int32_t)count - (int32_t)(baseline16[electrode] >> 4);
+  lastDelta[electrode] = difference;
+  if (touched & bit) {
+    if (difference >= (int32_t)releaseDelta) {
+      return;
+    }
+    touched &= ~bit;
+    event.type = Event_t::dsf_Release;
+  } else {
+    if (difference < 0) {
+      baseline16[electrode] = (uint32_t)count << 4;
+    } else {
+      baseline16[electrode] = (uint32_t)((int32_t)baseline16[electrode]
+          + (((int32_t)((uint32_t)count << 4)
+              - (int32_t)baseline16[electrode]) >> TSI_t::dsf_BaselineShift));
+    }
+    if (difference <= (int32_t)touchDelta) {
+      return;
+    }
+    touched |= bit;
+    event.type = Event_t::dsf_Press;
+  }
+  event.source = Event_t::dsf_SourceTouch;
+  event.code = electrode;
+  event.reserved = 0;
+  event.stamp = scanNumber;
+  queue.push(event);
+}
+
+/*!
+ *   @fn         events
+ *
+ *   @brief      Informa a fila de eventos de toque.
+ *
+ *   @return     A fila de eventos, a ser consumida no laço principal.
+ */
+dsf_InputQueue_ocp &dsf_TSI_ocp::events() {
+  return queue;
+}
+
+/*!
+ *   @fn         touchedMask
+ *
+ *   @brief      Informa os eletrodos tocados.
+ *
+ *   @return     Máscara em que o bit e corresponde ao eletrodo e.
+ */
+uint32_t dsf_TSI_ocp::touchedMask() {
+  return touched;
+}
+
+/*!
+ *   @fn         isTouched
+ *
+ *   @brief      Informa se um eletrodo está tocado.
+ *
+ *   @return     1 se o eletrodo está tocado e 0 caso contrário.
+ */
+int dsf_TSI_ocp::isTouched(uint8_t electrode) {
+  return (touched >> electrode) & 1;
+}
+
+/*!
+ *   @fn         delta
+ *
+ *   @brief      Informa a última diferença entre a leitura e a linha de
+ *               base de um eletrodo, em contagens.
+ */
+int32_t dsf_TSI_ocp::delta(uint8_t electrode) {
+  return electrode < electrodeCount ? lastDelta[electrode] : 0;
+}
+
+/*!
+ *   @fn         baseline
+ *
+ *   @brief      Informa a linha de base de um eletrodo, em contagens.
+ */
+uint16_t dsf_TSI_ocp::baseline(uint8_t electrode) {
+  return electrode < electrodeCount ? (uint16_t)(baseline16[electrode] >> 4)
+                                    : 0;
+}
+
+/*!
+ *   @fn         sliderPosition
+ *
+ *   @brief      Calcula a posição do toque entre os dois primeiros
+ *               eletrodos, como no slider da placa.
+ *
+ *   A posição é a fração da diferença do segundo eletrodo na soma das
+ *   diferenças dos dois.
+ *
+ *   @return     A posição, de 0 (primeiro eletrodo) a 100 (segundo), ou -1
+ *               se nenhum dos dois está tocado.
+ */
+int dsf_TSI_ocp::sliderPosition() {
+  int32_t first, second;
+
+  if (electrodeCount < 2 || (touched & 3) == 0) {
+    return -1;
+  }
+  first = lastDelta[0] > 0 ? lastDelta[0] : 0;
+  second = lastDelta[1] > 0 ? lastDelta[1] : 0;
+  if (first + second == 0) {
+    return -1;
+  }
+  return (int)(100*second/(first + second));
+}
@@ -0,0 +1,187 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       API em C++ para o sensor capacitivo TSI em segundo plano.
+ *
+ * @file        dsf_TSI_ocp.h
+ * @version     1.0
+ * @date        31 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   TSI, LPTMR, PORT e NVIC.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (31 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_TSI_OCP_H_
+#define DSF_TSI_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_ClockGate_ocp.h"
+#include "dsf_Event_ocp.h"
+
+/*!
+ * Namespace de definição dos canais do TSI, dos limites e dos limiares
+ * padrão, em contagens do TSICNT.
+ */
+namespace TSI_t {
+  enum dsf_Channel {
+    dsf_CH0_PTB0 = 0,
+    dsf_CH1_PTA0 = 1,
+    dsf_CH2_PTA1 = 2,
+    dsf_CH3_PTA2 = 3,
+    dsf_CH4_PTA3 = 4,
+    dsf_CH5_PTA4 = 5,
+    dsf_CH6_PTB1 = 6,
+    dsf_CH7_PTB2 = 7,
+    dsf_CH8_PTB3 = 8,
+    dsf_CH9_PTB16 = 9,
+    dsf_CH10_PTB17 = 10,
+    dsf_CH11_PTB18 = 11,
+    dsf_CH12_PTB19 = 12,
+    dsf_CH13_PTC0 = 13,
+    dsf_CH14_PTC1 = 14,
+    dsf_CH15_PTC2 = 15
+  };
+  enum dsf_TSILimits {
+    dsf_MaxElectrodes = 4,
+    dsf_CalibrationScans = 8,
+    dsf_BaselineShift = 6
+  };
+  enum dsf_TSIThresholds {
+    dsf_TouchDelta = 200,
+    dsf_ReleaseDelta = 100
+  };
+}  // namespace TSI_t
+
+/*!
+ *  @class    dsf_TSI_ocp
+ *
+ *  @brief    Classe de leitura de eletrodos capacitivos pelo TSI.
+ *
+ *  @details  As varreduras são disparadas por hardware pelo LPTMR, que
+ *            conta o LPO de 1 kHz, e cada fim de varredura gera uma
+ *            interrupção. O tratador lê o TSICNT do eletrodo varrido,
+ *            seleciona o próximo eletrodo para o próximo disparo e atualiza
+ *            o estado; a CPU não espera nenhuma varredura.
+ *
+ *            As primeiras TSI_t::dsf_CalibrationScans varreduras de cada
+ *            eletrodo formam a linha de base. Depois, enquanto o eletrodo
+ *            não está tocado, a linha de base acompanha a deriva com um
+ *            filtro de primeira ordem (peso 2^-dsf_BaselineShift) e desce
+ *            imediatamente para leituras abaixo dela. O toque é detectado
+ *            quando a leitura supera a linha de base em touch contagens e
+ *            liberado quando fica abaixo de release contagens (histerese),
+ *            sem espera de debounce: a latência é de no máximo um período
+ *            do LPTMR por eletrodo mais uma varredura.
+ *
+ *            Cada toque e cada liberação geram um dsf_Event com origem
+ *            Event_t::dsf_SourceTouch na mesma fila dsf_InputQueue_ocp do
+ *            teclado, com code = índice do eletrodo.
+ *
+ *            O LPTMR fica dedicado ao TSI enquanto a varredura está ativa.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Slider da FRDM-KL25Z (PTB16 e PTB17), um eletrodo a cada 5 ms.
+ *             +fn const uint8_t slider[] = {TSI_t::dsf_CH9_PTB16,
+ *                                           TSI_t::dsf_CH10_PTB17};
+ *             +fn dsf_TSI_ocp touch(slider, 2);
+ *             +fn DSF_IRQ_BIND(TSI0, touch)
+ *             +fn touch.start(5);
+ *
+ *            Consumo dos eventos e posição no slider.
+ *             +fn while (touch.events().pop(&event)) { ... }
+ *             +fn position = touch.sliderPosition();
+ */
+class dsf_TSI_ocp {
+ public:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  dsf_TSI_ocp(const uint8_t *channels, uint8_t electrodes);
+  ~dsf_TSI_ocp();
+
+  /*!
+   * Métodos de configuração e controle da varredura.
+   */
+  void setThresholds(uint16_t touch, uint16_t release);
+  void start(uint16_t periodMs);
+  void stop();
+
+  /*!
+   * Método de tratamento da interrupção de fim de varredura.
+   */
+  void irqHandler();
+
+  /*!
+   * Métodos de consulta.
+   */
+  dsf_InputQueue_ocp &events();
+  uint32_t touchedMask();
+  int isTouched(uint8_t electrode);
+  int32_t delta(uint8_t electrode);
+  uint16_t baseline(uint8_t electrode);
+  int sliderPosition();
+
+ private:
+  /*!
+   * Canal do TSI de cada eletrodo.
+   */
+  uint8_t channel[TSI_t::dsf_MaxElectrodes];
+  uint8_t electrodeCount;
+  /*!
+   * Eletrodo selecionado para a varredura em andamento.
+   */
+  volatile uint8_t current;
+  /*!
+   * Linha de base em 1/16 de contagem, última diferença para ela e número
+   * de varreduras de calibração de cada eletrodo.
+   */
+  uint32_t baseline16[TSI_t::dsf_MaxElectrodes];
+  volatile int32_t lastDelta[TSI_t::dsf_MaxElectrodes];
+  uint8_t calibration[TSI_t::dsf_MaxElectrodes];
+  /*!
+   * Máscara dos eletrodos tocados.
+   */
+  volatile uint32_t touched;
+  uint16_t touchDelta;
+  uint16_t releaseDelta;
+  /*!
+   * Número da varredura, usado como carimbo dos eventos.
+   */
+  uint32_t scanNumber;
+  bool running;
+  ClockGate_t::dsf_Gate portGate[TSI_t::dsf_MaxElectrodes];
+  dsf_InputQueue_ocp queue;
+
+  void update(uint8_t electrode, uint16_t count);
+};
+
+#endif  //  DSF_TSI_OCP_H_
@@ -0,0 +1,216 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Registros binários de telemetria enquadrados sobre a UART0.
+ *
+ * @file        dsf_Telemetry_ocp.cpp
+ * @version     1.0
+ * @date        4 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   UART0 e DMA (via dsf_UART_ocp).
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (4 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_Telemetry_ocp.h"
+
+namespace {
+
+/*!
+ * CRC-8 de polinômio 0x07 por tabela, um acesso por byte.
+ */
+const uint8_t kCRC8[256] = {
+  0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31,
+  0x24, 0x23, 0x2A, 0x2D, 0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65,
+  0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D, 0xE0, 0xE7, 0xEE, 0xE9,
+  0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+  0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1,
+  0xB4, 0xB3, 0xBA, 0xBD, 0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2,
+  0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA, 0xB7, 0xB0, 0xB9, 0xBE,
+  0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+  0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16,
+  0x03, 0x04, 0x0D, 0x0A, 0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42,
+  0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A, 0x89, 0x8E, 0x87, 0x80,
+  0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+  0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8,
+  0xDD, 0xDA, 0xD3, 0xD4, 0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C,
+  0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44, 0x19, 0x1E, 0x17, 0x10,
+  0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+  0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F,
+  0x6A, 0x6D, 0x64, 0x63, 0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B,
+  0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13, 0xAE, 0xA9, 0xA0, 0xA7,
+  0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+  0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF,
+  0xFA, 0xFD, 0xF4, 0xF3
+};
+
+}  // namespace
+
+/*!
+ *   @fn         dsf_Telemetry_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   @param[in]  uart - transmissor dos quadros, iniciado pelo chamador.
+ */
+dsf_Telemetry_ocp::dsf_Telemetry_ocp(dsf_UART_ocp &uart)
+    : port(uart), sequence(0), recordCount(0), droppedCount(0) {
+}
+
+/*!
+ *   @fn         counter
+ *
+ *   @brief      Registra o valor de um contador.
+ *
+ *   @param[in]  id - identificador do contador (Telemetry_t::dsf_CounterId
+ *                    ou um valor da aplicação).
+ *               value - valor atual.
+ */
+bool dsf_Telemetry_ocp::counter(uint8_t id, uint32_t value) {
+  uint8_t payload[5];
+
+  payload[0] = id;
+  putWord(payload + 1, value);
+  return record(Telemetry_t::dsf_RecCounter, payload, sizeof(payload));
+}
+
+/*!
+ *   @fn         draw
+ *
+ *   @brief      Registra um sorteio e o valor sorteado.
+ */
+bool dsf_Telemetry_ocp::draw(uint32_t number, uint32_t value) {
+  uint8_t payload[8];
+
+  putWord(putWord(payload, number), value);
+  return record(Telemetry_t::dsf_RecDraw, payload, sizeof(payload));
+}
+
+/*!
+ *   @fn         win
+ *
+ *   @brief      Registra um sorteio premiado e a faixa do prêmio.
+ */
+bool dsf_Telemetry_ocp::win(uint32_t number, uint8_t tier) {
+  uint8_t payload[5];
+
+  *putWord(payload, number) = tier;
+  return record(Telemetry_t::dsf_RecWin, payload, sizeof(payload));
+}
+
+/*!
+ *   @fn         latency
+ *
+ *   @brief      Registra uma latência medida, em us.
+ */
+bool dsf_Telemetry_ocp::latency(uint32_t micros) {
+  uint8_t payload[4];
+
+  putWord(payload, micros);
+  return record(Telemetry_t::dsf_RecLatency, payload, sizeof(payload));
+}
+
+/*!
+ *   @fn         record
+ *
+ *   @brief      Monta um quadro e o entrega ao transmissor.
+ *
+ *   @param[in]  type - tipo do registro.
+ *               payload - carga, já em little-endian.
+ *               length - tamanho da carga, até Telemetry_t::dsf_MaxPayload.
+ *
+ *   @return     false se o quadro não coube no buffer ou se a carga é
+ *               grande demais.
+ */
+bool dsf_Telemetry_ocp::record(uint8_t type, const uint8_t *payload,
+                               uint8_t length) {
+  uint8_t frame[Telemetry_t::dsf_MaxFrame];
+  uint8_t crc = 0;
+  uint8_t size;
+
+  if (length > Telemetry_t::dsf_MaxPayload) {
+    return false;
+  }
+  frame[0] = Telemetry_t::dsf_Sync;
+  frame[1] = type;
+  frame[2] = sequence++;
+  frame[3] = length;
+  for (uint8_t i = 0; i < length; i++) {
+    frame[Telemetry_t::dsf_HeaderSize + i] = payload[i];
+  }
+  size = (uint8_t)(Telemetry_t::dsf_HeaderSize + length);
+  for (uint8_t i = 1; i < size; i++) {
+    crc = kCRC8[crc ^ frame[i]];
+  }
+  frame[size++] = crc;
+  recordCount++;
+  if (!port.write(frame, size)) {
+    droppedCount++;
+    return false;
+  }
+  return true;
+}
+
+/*!
+ *   @fn         records
+ *
+ *   @brief      Informa o número de registros gerados, incluindo os
+ *               descartados.
+ */
+uint32_t dsf_Telemetry_ocp::records() {
+  return recordCount;
+}
+
+/*!
+ *   @fn         dropped
+ *
+ *   @brief      Informa o número de registros descartados.
+ */
+uint32_t dsf_Telemetry_ocp::dropped() {
+  return droppedCount;
+}
+
+/*!
+ *   @fn         putWord
+ *
+ *   @brief      Escreve uma palavra de 32 bits em little-endian, o formato
+ *               lido pelo dsf_teledecode.
+ *
+ *   @param[in]  at - posição do registro onde a palavra é escrita.
+ *               value - palavra a escrever.
+ *
+ *   @return     A posição seguinte à palavra.
+ */
+uint8_t *dsf_Telemetry_ocp::putWord(uint8_t *at, uint32_t value) {
+  at[0] = (uint8_t)value;
+  at[1] = (uint8_t)(value >> 8);
+  at[2] = (uint8_t)(value >> 16);
+  at[3] = (uint8_t)(value >> 24);
+  return at + 4;
+}
@@ -0,0 +1,140 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Registros binários de telemetria enquadrados sobre a UART0.
+ *
+ * @file        dsf_Telemetry_ocp.h
+ * @version     1.0
+ * @date        4 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   UART0 e DMA (via dsf_UART_ocp).
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (4 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_TELEMETRY_OCP_H_
+#define DSF_TELEMETRY_OCP_H_
+
+#include <stdint.h>
+#include "dsf_UART_ocp.h"
+
+/*!
+ * Namespace de definição do formato dos quadros, dos tipos de registro e
+ * dos identificadores de contador.
+ *
+ * Quadro: dsf_Sync, tipo, sequência, tamanho da carga, carga (até
+ * dsf_MaxPayload bytes, little-endian) e CRC-8 (polinômio 0x07, valor
+ * inicial 0) do tipo ao fim da carga. Cargas:
+ *  - dsf_RecCounter: id (1 byte) e valor (4 bytes).
+ *  - dsf_RecDraw: número do sorteio (4 bytes) e valor sorteado (4 bytes).
+ *  - dsf_RecWin: número do sorteio (4 bytes) e faixa do prêmio (1 byte).
+ *  - dsf_RecLatency: latência em us (4 bytes).
+ */
+namespace Telemetry_t {
+  enum dsf_Frame {
+    dsf_Sync = 0xA5,
+    dsf_HeaderSize = 4,
+    dsf_MaxPayload = 12,
+    dsf_MaxFrame = 17
+  };
+
+  enum dsf_RecordType {
+    dsf_RecCounter = 1,
+    dsf_RecDraw = 2,
+    dsf_RecWin = 3,
+    dsf_RecLatency = 4
+  };
+
+  enum dsf_CounterId {
+    dsf_CounterBlinks = 0
+  };
+}  // namespace Telemetry_t
+
+/*!
+ *  @class    dsf_Telemetry_ocp
+ *
+ *  @brief    Canal de telemetria em quadros binários sobre a UART0.
+ *
+ *  @details  Cada método monta um quadro de no máximo 17 bytes na pilha e
+ *            o entrega a dsf_UART_ocp::write: o custo no laço é a montagem,
+ *            o CRC por tabela e a cópia para o buffer circular, sem
+ *            nenhuma espera pela linha. A 115200 bauds cabem cerca de
+ *            1100 registros de contador por segundo.
+ *
+ *            O número de sequência avança também nos registros
+ *            descartados por falta de espaço, de modo que o decodificador
+ *            (host/dsf_teledecode) conta as perdas pelos saltos. O
+ *            decodificador se ressincroniza pelo byte dsf_Sync e pelo CRC
+ *            depois de bytes corrompidos ou de uma conexão no meio do
+ *            fluxo.
+ *
+ *            Os métodos seguem a regra de produtor único de dsf_UART_ocp.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Contador de piscadas pelo canal 1 do DMA.
+ *             +fn dsf_UART_ocp serial(1);
+ *             +fn DSF_IRQ_BIND(DMA1, serial)
+ *             +fn dsf_Telemetry_ocp telemetry(serial);
+ *             +fn serial.start();
+ *             +fn telemetry.counter(Telemetry_t::dsf_CounterBlinks, blinks);
+ */
+class dsf_Telemetry_ocp {
+ public:
+  /*!
+   * Método construtor da classe.
+   */
+  explicit dsf_Telemetry_ocp(dsf_UART_ocp &uart);
+
+  /*!
+   * Métodos de registro de eventos. Retornam false se o registro foi
+   * descartado.
+   */
+  bool counter(uint8_t id, uint32_t value);
+  bool draw(uint32_t number, uint32_t value);
+  bool win(uint32_t number, uint8_t tier);
+  bool latency(uint32_t micros);
+  bool record(uint8_t type, const uint8_t *payload, uint8_t length);
+
+  /*!
+   * Métodos de consulta.
+   */
+  uint32_t records();
+  uint32_t dropped();
+
+ private:
+  dsf_UART_ocp &port;
+  uint8_t sequence;
+  uint32_t recordCount;
+  uint32_t droppedCount;
+
+  static uint8_t *putWord(uint8_t *at, uint32_t value);
+};
+
+#endif  //  DSF_TELEMETRY_OCP_H_
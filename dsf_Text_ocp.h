@@ -0,0 +1,83 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Saída de texto e números dos relatórios dos drivers.
+ *
+ * @file        dsf_Text_ocp.h
+ * @version     1.0
+ * @date        14 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (14 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_TEXT_OCP_H_
+#define DSF_TEXT_OCP_H_
+
+#include <stdint.h>
+
+/*!
+ *   @fn         dsf_putNumber
+ *
+ *   @brief      Escreve um número sem sinal em decimal.
+ *
+ *   Usada pelos métodos dump dos drivers, que escrevem uma linha de texto
+ *   por grandeza com uma função de saída de um caractere (UART, depurador
+ *   ou printf no host), sem printf na placa.
+ *
+ *   @param[in]  putChar - função de saída de um caractere.
+ *               value - número a escrever.
+ */
+inline void dsf_putNumber(void (*putChar)(char), uint32_t value) {
+  char digits[10];
+  uint8_t n = 0;
+
+  do {
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+  while (n) {
+    putChar(digits[--n]);
+  }
+}
+
+/*!
+ *   @fn         dsf_putText
+ *
+ *   @brief      Escreve uma cadeia terminada em zero.
+ *
+ *   @param[in]  putChar - função de saída de um caractere.
+ *               text - cadeia a escrever.
+ */
+inline void dsf_putText(void (*putChar)(char), const char *text) {
+  while (*text) {
+    putChar(*text++);
+  }
+}
+
+#endif  //  DSF_TEXT_OCP_H_
@@ -0,0 +1,362 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Transmissão não bloqueante pela UART0 com DMA e buffer circular.
+ *
+ * @file        dsf_UART_ocp.cpp
+ * @version     1.0
+ * @date        4 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   UART0, DMA e DMAMUX.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (4 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_UART_ocp.h"
+#include "dsf_BME_ocp.h"
+
+/*!
+ * Registradores de 8 bits da UART0 (pág. 722) e do DMAMUX0 (pág. 326) e
+ * PCR do PTA2, UART0_TX na alternativa 2.
+ */
+#define DSF_UART0_REG(offset) (*(volatile uint8_t *)(0x4006A000 + (offset)))
+#define DSF_UART0_BDH         DSF_UART0_REG(0x0)
+#define DSF_UART0_BDL         DSF_UART0_REG(0x1)
+#define DSF_UART0_C1          DSF_UART0_REG(0x2)
+#define DSF_UART0_C2          DSF_UART0_REG(0x3)
+#define DSF_UART0_C4          DSF_UART0_REG(0xA)
+#define DSF_UART0_C5          DSF_UART0_REG(0xB)
+#define DSF_DMAMUX_CHCFG(ch)  (*(volatile uint8_t *)(0x40021000 + (ch)))
+#define DSF_PORTA_PCR2        (*(volatile uint32_t *)0x40049008)
+
+namespace {
+
+/*!
+ * Campos da UART0: TIE (C2 7) e TE (C2 3); TDMAE (C5 7), que com TIE faz o
+ * transmissor vazio requisitar o DMA, e BOTHEDGE (C5 1), obrigatório com
+ * OSR de 4 a 7. Endereço do UART0_D, destino do DMA.
+ */
+const uint8_t kTIE = 1u << 7;
+const uint8_t kTE = 1u << 3;
+const uint8_t kTDMAE = 1u << 7;
+const uint8_t kBOTHEDGE = 1u << 1;
+const uint32_t kUART0Data = 0x4006A007;
+
+/*!
+ * Campos do DMA_DSR_BCRn (CE 30, BES 29, BED 28, DONE 24) e do DMA_DCRn:
+ * EINT (31), ERQ (30), CS (29), SINC (22), SSIZE = 8 bits (21:20), DSIZE
+ * = 8 bits (18:17), SMOD (15:12) e D_REQ (7), que desliga ERQ no fim.
+ * DMAMUX: ENBL (7) e a fonte 3, transmissão da UART0.
+ */
+const uint32_t kErrors = (1u << 30) | (1u << 29) | (1u << 28);
+const uint32_t kDONE = 1u << 24;
+const uint32_t kDCR = (1u << 31) | (1u << 30) | (1u << 29) | (1u << 22)
+                      | (1u << 20) | (1u << 17) | (1u << 7);
+const uint8_t kMuxUART0TX = 0x80 | 3;
+/*!
+ * SMOD para o buffer de 16 << (SMOD - 1) bytes: log2(tamanho) - 3.
+ */
+const uint32_t kSMOD = (uint32_t)(28 - __builtin_clz(UART_t::dsf_RingSize));
+
+/*!
+ * Limites do divisor de 13 bits e da razão de sobreamostragem.
+ */
+const uint32_t kMaxSBR = 0x1FFF;
+const uint32_t kMinOSR = 4;
+const uint32_t kMaxOSR = 32;
+
+}  // namespace
+
+/*!
+ *   @fn         dsf_UART_ocp
+ *
+ *   @brief      Método construtor da classe.
+ *
+ *   Este método só associa o objeto ao canal de DMA; o pino e os clocks
+ *   são adquiridos em start.
+ *
+ *   @param[in]  DMAChannel - canal de DMA (0 a 3) dedicado ao objeto.
+ */
+dsf_UART_ocp::dsf_UART_ocp(uint8_t DMAChannel)
+    : head(0), tail(0), inFlight(0), sentCount(0), droppedCount(0),
+      requestedBaud(0), baudRate(0),
+      channel(DMAChannel % UART_t::dsf_DMAChannels),
+      running(false) {
+  addressDMASAR = (volatile uint32_t *)(0x40008100 + 0x10*channel);
+  addressDMADAR = addressDMASAR + 1;
+  addressDMADSR = addressDMASAR + 2;
+  addressDMADCR = addressDMASAR + 3;
+}
+
+/*!
+ *   @fn         ~dsf_UART_ocp
+ *
+ *   @brief      Método destrutor da classe.
+ */
+dsf_UART_ocp::~dsf_UART_ocp() {
+  stop();
+}
+
+/*!
+ *   @fn         start
+ *
+ *   @brief      Configura a UART0 em 8N1 e o canal de DMA da transmissão.
+ *
+ *   Os divisores são calculados por setDivisors para o perfil atual do
+ *   dsf_MCG_ocp e recalculados a cada troca de perfil.
+ *
+ *   @param[in]  baud - taxa desejada, em bauds.
+ *
+ *   @return     A taxa efetiva, em bauds, ou 0 se nenhum divisor serve.
+ *
+ *   @remarks    Siglas e páginas do Manual de Referência KL25:
+ *               - SIM_SOPT2: System Options Register 2. Pág. 195.
+ *               - UART0_C4: UART Control Register 4. Pág. 733.
+ *               - UART0_C5: UART Control Register 5. Pág. 734.
+ *               - DMA_DCRn: DMA Control Register. Pág. 352.
+ */
+uint32_t dsf_UART_ocp::start(uint32_t baud) {
+  if (running || baud == 0) {
+    return running ? baudRate : 0;
+  }
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_PORTA);
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_UART0);
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_DMA);
+  DSF_UART0_C2 = 0;
+  DSF_UART0_C1 = 0;
+  requestedBaud = baud;
+  if (setDivisors() == 0) {
+    dsf_ClockGate_ocp::release(ClockGate_t::dsf_DMA);
+    dsf_ClockGate_ocp::release(ClockGate_t::dsf_UART0);
+    dsf_ClockGate_ocp::release(ClockGate_t::dsf_PORTA);
+    return 0;
+  }
+  DSF_PORTA_PCR2 = PORT_PCR_MUX(2);
+
+  tail = head;
+  inFlight = 0;
+  DSF_DMAMUX_CHCFG(channel) = 0;
+  *addressDMADCR = 0;
+  *addressDMADSR = kDONE;
+  *addressDMADAR = kUART0Data;
+  DSF_DMAMUX_CHCFG(channel) = kMuxUART0TX;
+  NVIC_ClearPendingIRQ((IRQn_Type)(DMA0_IRQn + channel));
+  NVIC_EnableIRQ((IRQn_Type)(DMA0_IRQn + channel));
+
+  DSF_UART0_C2 = kTIE | kTE;
+  dsf_MCG_ocp::subscribe(clockChanged, this);
+  running = true;
+  return baudRate;
+}
+
+/*!
+ *   @fn         setDivisors
+ *
+ *   @brief      Escolhe OSR e SBR para a taxa pedida no clock atual.
+ *
+ *   A razão OSR + 1 e o SBR são escolhidos pelo menor erro de taxa, com a
+ *   maior razão no empate. Os registradores só são escritos se algum
+ *   divisor serve.
+ *
+ *   @return     A taxa efetiva, em bauds, ou 0 se nenhum divisor serve.
+ */
+uint32_t dsf_UART_ocp::setDivisors() {
+  uint32_t clock = dsf_MCG_ocp::timerHz();
+  uint32_t bestError = 0xFFFFFFFF, bestOSR = 0, bestSBR = 0;
+
+  for (uint32_t osr = kMaxOSR; osr >= kMinOSR; osr--) {
+    uint32_t sbr = (clock + osr*requestedBaud/2)/(osr*requestedBaud);
+    uint32_t actual, error;
+    if (sbr == 0 || sbr > kMaxSBR) {
+      continue;
+    }
+    actual = clock/(osr*sbr);
+    error = actual > requestedBaud ? actual - requestedBaud
+                                   : requestedBaud - actual;
+    if (error < bestError) {
+      bestError = error;
+      bestOSR = osr;
+      bestSBR = sbr;
+    }
+  }
+  if (bestOSR == 0) {
+    baudRate = 0;
+    return 0;
+  }
+  baudRate = clock/(bestOSR*bestSBR);
+
+  dsf_BME_ocp::insertField(&SIM_SOPT2, 26, 2, dsf_MCG_ocp::timerSource());
+  DSF_UART0_BDH = (uint8_t)(bestSBR >> 8);
+  DSF_UART0_BDL = (uint8_t)bestSBR;
+  DSF_UART0_C4 = (uint8_t)(bestOSR - 1);
+  DSF_UART0_C5 = kTDMAE | (bestOSR < 8 ? kBOTHEDGE : 0);
+  return baudRate;
+}
+
+/*!
+ *   @fn         clockChanged
+ *
+ *   @brief      Observador das trocas de perfil do dsf_MCG_ocp.
+ *
+ *   @param[in]  argument - o objeto dsf_UART_ocp.
+ */
+void dsf_UART_ocp::clockChanged(void *argument) {
+  ((dsf_UART_ocp *)argument)->setDivisors();
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Para o transmissor e libera os clocks.
+ *
+ *   Os bytes ainda no buffer são descartados.
+ */
+void dsf_UART_ocp::stop() {
+  if (!running) {
+    return;
+  }
+  dsf_MCG_ocp::unsubscribe(clockChanged, this);
+  NVIC_DisableIRQ((IRQn_Type)(DMA0_IRQn + channel));
+  DSF_DMAMUX_CHCFG(channel) = 0;
+  *addressDMADCR = 0;
+  *addressDMADSR = kDONE;
+  DSF_UART0_C2 = 0;
+  DSF_UART0_C5 = 0;
+  DSF_PORTA_PCR2 = PORT_PCR_MUX(0);
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_DMA);
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_UART0);
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_PORTA);
+  inFlight = 0;
+  tail = head;
+  running = false;
+}
+
+/*!
+ *   @fn         write
+ *
+ *   @brief      Copia uma mensagem para o buffer circular.
+ *
+ *   A cópia é publicada de uma vez ao avançar head, de modo que o DMA
+ *   nunca transmite uma mensagem pela metade. Com o DMA parado, a
+ *   interrupção do canal é marcada como pendente para iniciá-lo.
+ *
+ *   @param[in]  data - bytes da mensagem.
+ *               count - número de bytes.
+ *
+ *   @return     false se a mensagem não coube e foi descartada.
+ */
+bool dsf_UART_ocp::write(const uint8_t *data, uint16_t count) {
+  uint16_t position = head;
+
+  if (!running || count > space()) {
+    droppedCount++;
+    return false;
+  }
+  for (uint16_t i = 0; i < count; i++) {
+    ring[(uint16_t)(position + i) & (UART_t::dsf_RingSize - 1)] = data[i];
+  }
+  __asm volatile("" ::: "memory");
+  head = (uint16_t)(position + count);
+  if (inFlight == 0) {
+    NVIC_SetPendingIRQ((IRQn_Type)(DMA0_IRQn + channel));
+  }
+  return true;
+}
+
+/*!
+ *   @fn         irqHandler
+ *
+ *   @brief      Trata o fim de uma transferência e inicia a próxima.
+ *
+ *   Chamado no fim de cada transferência (DONE) e quando write encontra o
+ *   DMA parado. Todo o trecho entre tail e head sai em uma transferência;
+ *   o SMOD cuida da volta ao início do buffer.
+ */
+void dsf_UART_ocp::irqHandler() {
+  uint32_t status = *addressDMADSR;
+  uint16_t pending;
+
+  if (status & kDONE) {
+    *addressDMADSR = kDONE;
+    if (!(status & kErrors)) {
+      sentCount += inFlight;
+    }
+    tail = (uint16_t)(tail + inFlight);
+    inFlight = 0;
+  }
+  if (inFlight != 0) {
+    return;
+  }
+  pending = (uint16_t)(head - tail);
+  if (pending == 0) {
+    return;
+  }
+  inFlight = pending;
+  *addressDMASAR = (uint32_t)(uintptr_t)&ring[tail
+                                              & (UART_t::dsf_RingSize - 1)];
+  *addressDMADSR = pending;
+  *addressDMADCR = kDCR | (kSMOD << 12);
+}
+
+/*!
+ *   @fn         space
+ *
+ *   @brief      Informa o número de bytes livres no buffer.
+ */
+uint16_t dsf_UART_ocp::space() {
+  return (uint16_t)(UART_t::dsf_RingSize - (uint16_t)(head - tail));
+}
+
+/*!
+ *   @fn         sent
+ *
+ *   @brief      Informa o número de bytes entregues à UART0.
+ */
+uint32_t dsf_UART_ocp::sent() {
+  return sentCount;
+}
+
+/*!
+ *   @fn         dropped
+ *
+ *   @brief      Informa o número de mensagens descartadas por falta de
+ *               espaço.
+ */
+uint32_t dsf_UART_ocp::dropped() {
+  return droppedCount;
+}
+
+/*!
+ *   @fn         baud
+ *
+ *   @brief      Informa a taxa efetiva, em bauds.
+ */
+uint32_t dsf_UART_ocp::baud() {
+  return baudRate;
+}
@@ -0,0 +1,169 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Transmissão não bloqueante pela UART0 com DMA e buffer circular.
+ *
+ * @file        dsf_UART_ocp.h
+ * @version     1.0
+ * @date        4 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +peripheral   UART0, DMA e DMAMUX.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (4 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef DSF_UART_OCP_H_
+#define DSF_UART_OCP_H_
+
+#include <stdint.h>
+#include <MKL25Z4.h>
+#include "dsf_ClockGate_ocp.h"
+#include "dsf_TPM_ocp.h"
+
+/*!
+ * Namespace de definição dos limites do transmissor: tamanho do buffer
+ * circular (potência de 2, exigência do SMOD do DMA), taxa padrão e
+ * número de canais de DMA.
+ */
+namespace UART_t {
+  enum dsf_UARTLimits {
+    dsf_RingSize = 512,
+    dsf_DefaultBaud = 115200,
+    dsf_DMAChannels = 4
+  };
+}  // namespace UART_t
+
+/*!
+ *  @class    dsf_UART_ocp
+ *
+ *  @brief    Classe de transmissão pela UART0 sem espera da linha.
+ *
+ *  @details  A UART0 da FRDM-KL25Z chega ao PC pela porta serial virtual do
+ *            OpenSDA (PTA2, UART0_TX). Só a transmissão é usada: PTA1, o
+ *            UART0_RX, continua livre para a tecla.
+ *
+ *            write copia os bytes para um buffer circular em RAM e retorna;
+ *            o DMA os leva ao UART0_D, um byte a cada requisição de
+ *            transmissor vazio (TDMAE), sem a CPU. O módulo de origem
+ *            (SMOD) faz o endereço de leitura voltar ao início do buffer
+ *            sozinho, de modo que um trecho que atravessa o fim do buffer
+ *            sai em uma única transferência.
+ *
+ *            O buffer é livre de travas com um único produtor: write só
+ *            avança head e o tratador do canal de DMA só avança tail. Se o
+ *            DMA está parado, write marca a interrupção do canal como
+ *            pendente e é o tratador que inicia a transferência, de modo
+ *            que os registradores do DMA só são escritos por ele. O
+ *            produtor é o laço principal ou um tratador que não interrompa
+ *            o do DMA.
+ *
+ *            Uma mensagem que não cabe no espaço livre é descartada
+ *            inteira e contada em dropped; write nunca espera a linha.
+ *
+ *            O clock da UART0 é o mesmo dos TPMs (dsf_MCG_ocp::timerHz).
+ *            A razão de sobreamostragem (OSR) e o divisor (SBR) são
+ *            escolhidos juntos pelo menor erro: 115200 bauds saem com erro
+ *            de 0,03 % no FEI e de 0,16 % no PEE de 48 MHz. A cada troca de
+ *            perfil do dsf_MCG_ocp os divisores são recalculados para a
+ *            taxa pedida em start; um byte em transmissão durante a troca
+ *            pode ser corrompido.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Saída serial no canal 1 do DMA.
+ *             +fn dsf_UART_ocp serial(1);
+ *             +fn DSF_IRQ_BIND(DMA1, serial)
+ *             +fn serial.start(115200);
+ *             +fn serial.write(message, length);
+ */
+class dsf_UART_ocp {
+ public:
+  /*!
+   * Métodos construtor e destrutor da classe.
+   */
+  explicit dsf_UART_ocp(uint8_t DMAChannel = 1);
+  ~dsf_UART_ocp();
+
+  /*!
+   * Métodos de controle do transmissor.
+   */
+  uint32_t start(uint32_t baud = UART_t::dsf_DefaultBaud);
+  void stop();
+
+  /*!
+   * Método de escrita não bloqueante: todos os bytes ou nenhum.
+   */
+  bool write(const uint8_t *data, uint16_t count);
+
+  /*!
+   * Método de tratamento da interrupção do canal de DMA.
+   */
+  void irqHandler();
+
+  /*!
+   * Métodos de consulta.
+   */
+  uint16_t space();
+  uint32_t sent();
+  uint32_t dropped();
+  uint32_t baud();
+
+ private:
+  /*!
+   * Buffer circular, alinhado ao seu tamanho (exigência do SMOD).
+   */
+  uint8_t ring[UART_t::dsf_RingSize]
+      __attribute__((aligned(UART_t::dsf_RingSize)));
+  /*!
+   * Índices de 16 bits que dão a volta: head é avançado por write e tail
+   * pelo tratador; inFlight é o trecho entregue ao DMA, 0 com o DMA
+   * parado.
+   */
+  volatile uint16_t head;
+  volatile uint16_t tail;
+  volatile uint16_t inFlight;
+  volatile uint32_t sentCount;
+  uint32_t droppedCount;
+  /*!
+   * Registradores do canal de DMA: SAR, DAR, DSR_BCR e DCR.
+   */
+  volatile uint32_t *addressDMASAR;
+  volatile uint32_t *addressDMADAR;
+  volatile uint32_t *addressDMADSR;
+  volatile uint32_t *addressDMADCR;
+  uint32_t requestedBaud;
+  uint32_t baudRate;
+  uint8_t channel;
+  bool running;
+
+  uint32_t setDivisors();
+  static void clockChanged(void *argument);
+};
+
+#endif  //  DSF_UART_OCP_H_
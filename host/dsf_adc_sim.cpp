@@ -0,0 +1,239 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Disparo pelo TPM, volta do DMOD e entrega das metades do
+ *              buffer do dsf_ADC_ocp no simulador do host.
+ *
+ * @file        dsf_adc_sim.cpp
+ * @version     1.0
+ * @date        17 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -no-pie -Isim -I.. dsf_adc_sim.cpp
+ *                            sim/dsf_Sim.cpp ../dsf_ADC_ocp.cpp
+ *                            ../dsf_TPM_ocp.cpp ../dsf_ClockGate_ocp.cpp
+ *                            ../dsf_Irq_ocp.cpp ../dsf_MCG_ocp.cpp
+ *                            -o dsf_adc_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (17 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_adc_sim
+ *
+ *              PTB0 é amostrado a 8 kHz, com média de 4, disparo no TPM1 e
+ *              DMA0, num buffer de 64 amostras (metades de 4 ms) cercado
+ *              de guardas. Cada conversão devolve um contador, de modo que
+ *              uma amostra fora de ordem, repetida ou perdida aparece no
+ *              fluxo entregue ao tratador. Depois da 3ª metade, o laço
+ *              principal segura as interrupções até 1,5 amostra depois do
+ *              fim da metade seguinte, e depois da 8ª até 3,5 amostras.
+ *
+ *              O código de saída é 0 se a calibração, feita no FEI com o
+ *              ADCK até 4 MHz, passa; se as metades chegam alternadas, com
+ *              o ponteiro da metade certa e o fluxo contínuo, exceto as
+ *              duas amostras sobrescritas no RA pelo segundo atraso; se os
+ *              dois atrasos são contados em lateBlocks; se o intervalo
+ *              entre as conversões é o período do TPM, a menos de um
+ *              acesso; e se as guardas ficam intactas (o DMOD mantém o DMA
+ *              no buffer).
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_ADC_ocp.h"
+#include "dsf_Irq_ocp.h"
+
+namespace {
+
+const uint16_t kLength = 64;
+const uint16_t kHalf = kLength/2;
+const uint32_t kRate = 8000;
+const uint16_t kFirstValue = 100;
+const uint16_t kGuard = 0xA5A5;
+const uint32_t kEndMicros = 60000;
+const uint32_t kMaxJitterCycles = 8;
+
+/*!
+ * Metades depois das quais o laço principal segura as interrupções, e o
+ * atraso, em meias amostras, da interrupção da metade seguinte.
+ */
+const uint32_t kShortStallAfter = 3;
+const uint32_t kLongStallAfter = 8;
+const uint32_t kShortLateSamples = 3;
+const uint32_t kLongLateSamples = 7;
+const uint32_t kLostSamples = 2;
+
+/*!
+ * Buffer alinhado ao seu tamanho em bytes, entre duas guardas.
+ */
+struct Ring {
+  uint16_t before[kLength];
+  uint16_t samples[kLength];
+  uint16_t after[kLength];
+} __attribute__((aligned(2*kLength)));
+
+}  // namespace
+
+dsf_ADC_ocp adc(ADC_t::dsf_SE8_PTB0, TPM_t::dsf_TPM1, 0);
+
+DSF_IRQ_BIND(DMA0, adc)
+
+namespace {
+
+Ring ring;
+uint16_t stream[1024];
+uint32_t streamCount;
+uint8_t halves[64];
+bool pointersOk = true;
+uint32_t blockCount;
+volatile uint32_t stallHalfSamples;
+
+uint16_t nextValue = kFirstValue;
+uint64_t conversions[1024];
+uint32_t conversionCount;
+bool calibrated;
+uint64_t startCycle;
+
+uint16_t source(void *, uint8_t channel) {
+  if (channel == (ADC_t::dsf_SE8_PTB0 & 0x1F)
+      && conversionCount < sizeof(conversions)/sizeof(conversions[0])) {
+    conversions[conversionCount++] = dsf_Sim::now();
+  }
+  return nextValue++;
+}
+
+void onBlock(void *, const uint16_t *samples, uint16_t count, uint8_t half) {
+  pointersOk = pointersOk && count == kHalf
+               && samples == ring.samples + (half ? kHalf : 0);
+  if (blockCount < sizeof(halves)) {
+    halves[blockCount] = half;
+  }
+  for (uint16_t i = 0; i < count; i++) {
+    if (streamCount < sizeof(stream)/sizeof(stream[0])) {
+      stream[streamCount++] = samples[i];
+    }
+  }
+  blockCount++;
+  if (blockCount == kShortStallAfter) {
+    stallHalfSamples = 2*kHalf + kShortLateSamples;
+  } else if (blockCount == kLongStallAfter) {
+    stallHalfSamples = 2*kHalf + kLongLateSamples;
+  }
+}
+
+/*!
+ * Segura as interrupções por um número de meias amostras, a partir do
+ * retorno do tratador.
+ */
+void stall(uint32_t halfSamples) {
+  uint64_t until = dsf_Sim::now()
+                   + dsf_Sim::microseconds(halfSamples*500000ull/kRate);
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  while (dsf_Sim::now() < until) {
+    (void)SIM_SCGC6;
+  }
+  __set_PRIMASK(primask);
+}
+
+void entry() {
+  calibrated = adc.calibrate();
+  adc.setAverage(ADC_t::dsf_Avg4);
+  adc.setSampleRate(kRate);
+  adc.setBuffer(ring.samples, kLength, onBlock, 0);
+  adc.start();
+  startCycle = dsf_Sim::now();
+  for (;;) {
+    __WFI();
+    if (stallHalfSamples) {
+      uint32_t halfSamples = stallHalfSamples;
+      stallHalfSamples = 0;
+      stall(halfSamples);
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  bool ok;
+  uint32_t gaps = 0, gapAt = 0, gapSize = 0;
+  uint64_t period, expected, worstJitter = 0;
+  bool alternating = true, guardsOk = true;
+
+  for (uint16_t i = 0; i < kLength; i++) {
+    ring.before[i] = kGuard;
+    ring.after[i] = kGuard;
+  }
+  dsf_Sim::setAnalogSource(source, 0);
+  dsf_Sim::run(entry, dsf_Sim::microseconds(kEndMicros));
+
+  for (uint32_t i = 1; i < streamCount; i++) {
+    if (stream[i] != (uint16_t)(stream[i - 1] + 1)) {
+      gaps++;
+      gapAt = i;
+      gapSize = (uint16_t)(stream[i] - stream[i - 1] - 1);
+    }
+  }
+  for (uint32_t b = 0; b < blockCount && b < sizeof(halves); b++) {
+    alternating = alternating && halves[b] == b % 2;
+  }
+  for (uint16_t i = 0; i < kLength; i++) {
+    guardsOk = guardsOk && ring.before[i] == kGuard
+               && ring.after[i] == kGuard;
+  }
+  period = (dsf_Sim::coreFrequency() + adc.sampleRate()/2)/adc.sampleRate();
+  expected = (dsf_Sim::microseconds(kEndMicros) - startCycle)/period/kHalf;
+  for (uint32_t i = 1; i < conversionCount; i++) {
+    uint64_t interval = conversions[i] - conversions[i - 1];
+    uint64_t jitter = interval > period ? interval - period : period - interval;
+    if (jitter > worstJitter) {
+      worstJitter = jitter;
+    }
+  }
+
+  printf("calibrated=%d rate=%u blocks=%u late_blocks=%u samples=%u\n",
+         calibrated, adc.sampleRate(), blockCount, adc.lateBlocks(),
+         streamCount);
+  printf("first=%u gaps=%u gap_at=%u gap_size=%u period_cycles=%llu "
+         "worst_jitter_cycles=%llu\n", streamCount ? stream[0] : 0, gaps,
+         gapAt, gapSize, (unsigned long long)period,
+         (unsigned long long)worstJitter);
+  printf("alternating=%d pointers=%d guards=%d\n", alternating, pointersOk,
+         guardsOk);
+  ok = calibrated && blockCount + 1 >= expected
+       && streamCount == blockCount*kHalf && stream[0] == kFirstValue
+       && gaps == 1 && gapAt == (kLongStallAfter + 1)*kHalf
+       && gapSize == kLostSamples && adc.lateBlocks() == 2
+       && alternating && pointersOk && guardsOk
+       && conversionCount > streamCount && worstJitter <= kMaxJitterCycles;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Verificação do dsf_BCM_ocp no simulador do host.
+ *
+ * @file        dsf_bcm_sim.cpp
+ * @version     1.0
+ * @date        2 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_bcm_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_BCM_ocp.cpp ../dsf_TPM_ocp.cpp
+ *                            ../dsf_ClockGate_ocp.cpp ../dsf_Irq_ocp.cpp
+ *                            ../dsf_MCG_ocp.cpp -o dsf_bcm_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (2 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_bcm_sim [-n atualizações] [-r quadros/s] [-s semente]
+ *
+ *              Onze canais em PTC1..PTC7 e PTD0..PTD3 recebem níveis
+ *              pseudoaleatórios, publicados com present em planos
+ *              aleatórios do quadro. O canal de PTC0 tem nível 1 e só
+ *              fica ligado no plano 0: a sua borda de subida marca o início
+ *              de cada quadro. O tempo ligado de cada pino em cada quadro,
+ *              observado pelo simulador, é convertido em nível e comparado
+ *              com os conjuntos publicados: cada quadro deve mostrar um
+ *              único conjunto, na ordem de publicação, todo conjunto deve
+ *              aparecer e cada quadro deve durar 255 unidades. O código de
+ *              saída é 0 se todas as verificações passaram.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_BCM_ocp.h"
+#include "dsf_Irq_ocp.h"
+#include "lpm_random.h"
+
+dsf_BCM_ocp bcm(TPM_t::dsf_TPM0);
+
+DSF_IRQ_BIND(TPM0, bcm)
+
+namespace {
+
+const int kChannels = 11;
+const uint8_t kGPIO[kChannels] = {2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3};
+const uint8_t kPin[kChannels] = {1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3};
+
+typedef std::vector<uint8_t> Levels;
+
+/*!
+ * Conjuntos publicados e quadros observados nos pinos.
+ */
+std::vector<Levels> published;
+std::vector<Levels> observed;
+std::vector<uint64_t> frameLength;
+
+uint32_t updates = 200;
+uint16_t frameRate = 200;
+lpm_random generator;
+
+/*!
+ * Tempo ligado de cada canal no quadro em andamento.
+ */
+bool high[kChannels];
+uint64_t risenAt[kChannels];
+uint64_t onCycles[kChannels];
+uint64_t frameStart = 0;
+bool inFrame = false;
+
+void onChannel(void *argument, uint8_t, uint8_t, int level) {
+  int c = (int)(intptr_t)argument;
+
+  if (level) {
+    risenAt[c] = dsf_Sim::now();
+  } else if (inFrame) {
+    onCycles[c] += dsf_Sim::now() - risenAt[c];
+  }
+  high[c] = level;
+}
+
+/*!
+ * Início de quadro: fecha o anterior, contando os pinos ainda ligados até
+ * agora, e converte o tempo ligado em nível. O estado vem de high, pois as
+ * bordas simultâneas do mesmo GPIO ainda não foram entregues aos
+ * observadores.
+ */
+void onMarker(void *, uint8_t, uint8_t, int level) {
+  uint64_t now = dsf_Sim::now();
+  uint32_t unit = bcm.unitCycles();
+  Levels frame(kChannels);
+
+  if (!level) {
+    return;
+  }
+  if (inFrame) {
+    for (int c = 0; c < kChannels; c++) {
+      if (high[c]) {
+        onCycles[c] += now - risenAt[c];
+      }
+      frame[c] = (uint8_t)((onCycles[c] + unit/2)/unit);
+    }
+    observed.push_back(frame);
+    frameLength.push_back(now - frameStart);
+  }
+  for (int c = 0; c < kChannels; c++) {
+    onCycles[c] = 0;
+    risenAt[c] = now;
+  }
+  frameStart = now;
+  inFrame = true;
+}
+
+void publishRandom() {
+  Levels levels(kChannels);
+
+  for (int c = 0; c < kChannels; c++) {
+    levels[c] = (uint8_t)generator.next();
+    bcm.setLevel((uint8_t)(c + 1), levels[c]);
+  }
+  bcm.present();
+  published.push_back(levels);
+}
+
+void waitFrames(uint32_t count) {
+  uint32_t target = bcm.frames() + count;
+
+  while (bcm.frames() < target) {
+    __WFI();
+  }
+}
+
+/*!
+ * Firmware: canais, início da modulação e atualizações em planos
+ * aleatórios, com pelo menos um quadro entre elas.
+ */
+void entry() {
+  bcm.attach(GPIO_t::dsf_GPIOC, 0);
+  for (int c = 0; c < kChannels; c++) {
+    bcm.attach((GPIO_t::dsf_GPIO)kGPIO[c], kPin[c]);
+  }
+  bcm.setLevel(0, 1);
+  bcm.setFrameRate(frameRate);
+  publishRandom();
+  bcm.start();
+  for (uint32_t u = 1; u < updates; u++) {
+    waitFrames(1 + generator.next() % 3);
+    for (uint32_t p = generator.next() % BCM_t::dsf_Planes; p > 0; p--) {
+      __WFI();
+    }
+    publishRandom();
+  }
+  waitFrames(3);
+  bcm.stop();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint64_t seed = 1;
+  size_t next = 0, shown = 0;
+  uint64_t expected, worst = 0;
+  bool inOrder = true;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      updates = (uint32_t)strtoul(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+      frameRate = (uint16_t)strtoul(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      seed = strtoull(argv[++i], 0, 0);
+    } else {
+      fprintf(stderr, "usage: %s [-n updates] [-r fps] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+  generator.seed(seed);
+  dsf_Sim::watch(2, 0, onMarker, 0);
+  for (int c = 0; c < kChannels; c++) {
+    dsf_Sim::watch(kGPIO[c], kPin[c], onChannel, (void *)(intptr_t)c);
+  }
+  dsf_Sim::run(entry, dsf_Sim::microseconds(60000000));
+
+  /*!
+   * Cada quadro deve repetir o conjunto anterior ou mostrar um conjunto
+   * publicado depois dele; nenhum conjunto pode ser pulado.
+   */
+  for (size_t f = 0; f < observed.size() && inOrder; f++) {
+    if (observed[f] == published[next]) {
+      continue;
+    }
+    if (next + 1 < published.size() && observed[f] == published[next + 1]) {
+      next++;
+      shown++;
+      continue;
+    }
+    printf("frame %lu does not match update %lu or %lu\n", (unsigned long)f,
+           (unsigned long)next, (unsigned long)next + 1);
+    inOrder = false;
+  }
+  /*!
+   * O primeiro quadro começa na escrita de start, antes do TPM, e não
+   * entra na verificação da duração.
+   */
+  expected = 255ull*bcm.unitCycles();
+  for (size_t f = 1; f < frameLength.size(); f++) {
+    uint64_t error = frameLength[f] > expected ? frameLength[f] - expected
+                                               : expected - frameLength[f];
+    if (error > worst) {
+      worst = error;
+    }
+  }
+  printf("frames=%lu updates=%lu shown=%lu fps=%lu unit_cycles=%lu "
+         "irq_per_frame=%.2f frame_error_cycles=%lu\n",
+         (unsigned long)observed.size(), (unsigned long)published.size(),
+         (unsigned long)shown + 1, (unsigned long)bcm.frameRate(),
+         (unsigned long)bcm.unitCycles(),
+         observed.empty() ? 0.0
+                          : (double)dsf_Sim::interruptCount()/observed.size(),
+         (unsigned long)worst);
+  if (!inOrder || shown + 1 != published.size() || observed.empty()
+      || worst > 16) {
+    printf("FAIL\n");
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,372 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Custo e atomicidade das escritas decoradas do BME no
+ *              simulador do host.
+ *
+ * @file        dsf_bme_sim.cpp
+ * @version     1.0
+ * @date        8 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_bme_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_GPIO_ocp.cpp ../dsf_Delay_ocp.cpp
+ *                            ../dsf_TPM_ocp.cpp ../dsf_ClockGate_ocp.cpp
+ *                            ../dsf_Irq_ocp.cpp ../dsf_MCG_ocp.cpp
+ *                            -o dsf_bme_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (8 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_bme_sim
+ *
+ *              Cada operação dos drivers que passou para o dsf_BME_ocp é
+ *              executada duas vezes a partir do mesmo estado: com a
+ *              sequência leitura-modificação-escrita anterior, reproduzida
+ *              aqui sobre os mesmos registradores, e com o driver. A tabela
+ *              mostra os acessos ao barramento e os ciclos simulados de
+ *              cada versão; os registradores devem terminar iguais.
+ *
+ *              Depois, uma borda em PTA1 é agendada em cada ciclo de uma
+ *              janela em torno de uma mudança de direção de PTB18, e a
+ *              interrupção do PORTA muda a direção de PTB19 no mesmo PDDR.
+ *              Com o "|=", as bordas que caem entre a leitura e a escrita
+ *              perdem a mudança da interrupção; com o BME, nenhuma perde.
+ *              O código de saída é 0 se o BME é mais barato em todas as
+ *              operações, com o mesmo resultado, e nunca perde mudanças.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_BME_ocp.h"
+#include "dsf_ClockGate_ocp.h"
+#include "dsf_Delay_ocp.h"
+#include "dsf_GPIO_ocp.h"
+#include "dsf_Irq_ocp.h"
+
+namespace {
+
+/*!
+ * Registradores de PTB18, PTB19, PTA1 e do TPM1 usados nas comparações.
+ */
+volatile uint32_t *const kPDOR = (volatile uint32_t *)0x400FF040u;
+volatile uint32_t *const kPTOR = (volatile uint32_t *)0x400FF04Cu;
+volatile uint32_t *const kPDDR = (volatile uint32_t *)0x400FF054u;
+volatile uint32_t *const kPCR18 = (volatile uint32_t *)0x4004A048u;
+volatile uint32_t *const kPCR1 = (volatile uint32_t *)0x40049004u;
+volatile uint32_t *const kTPM1SC = (volatile uint32_t *)0x40039000u;
+volatile uint32_t *const kTPM1CNT = (volatile uint32_t *)0x40039004u;
+volatile uint32_t *const kTPM1MOD = (volatile uint32_t *)0x40039008u;
+
+const uint32_t kPin18 = 1u << 18;
+const uint32_t kPin19 = 1u << 19;
+const uint16_t kDelayTicks = 1000;
+const uint32_t kSweepCycles = 32;
+
+}  // namespace
+
+dsf_GPIO_ocp led(GPIO_t::dsf_GPIOB, GPIO_t::dsf_PTB18);
+dsf_GPIO_ocp other(GPIO_t::dsf_GPIOB, GPIO_t::dsf_PTB19);
+dsf_GPIO_ocp key(GPIO_t::dsf_GPIOA, GPIO_t::dsf_PTA1);
+dsf_Delay_ocp delay(TPM_t::dsf_TPM1);
+
+namespace {
+
+/*!
+ * Mudança feita pela interrupção no PDDR: com "|=" ou com o driver.
+ */
+class Racer {
+ public:
+  bool decorated;
+  uint32_t calls;
+
+  void irqHandler() {
+    if (decorated) {
+      other.setPortMode(PortMode_t::Output);
+    } else {
+      *kPDDR |= kPin19;
+    }
+    calls++;
+  }
+};
+
+Racer racer = {false, 0};
+
+}  // namespace
+
+DSF_IRQ_BIND(PORTA, key, racer)
+
+namespace {
+
+/*!
+ * Uma operação: estado inicial, versão leitura-modificação-escrita,
+ * versão do driver e registrador comparado.
+ */
+struct Operation {
+  const char *name;
+  void (*prepare)();
+  void (*reference)();
+  void (*driver)();
+  uint32_t (*state)();
+};
+
+struct Cost {
+  uint64_t accesses;
+  uint64_t cycles;
+  uint32_t state;
+};
+
+void clearPDDR() {
+  *kPDDR = 0;
+}
+void referencePortMode() {
+  *kPDDR |= kPin18;
+}
+void driverPortMode() {
+  led.setPortMode(PortMode_t::Output);
+}
+uint32_t readPDDR() {
+  return *kPDDR;
+}
+
+/*!
+ * Os PCRs são preparados pelo driver, que mantém a cópia de sombra deles.
+ */
+void resetPCR() {
+  led.setPullResistor(PullResistor_t::PullNoneResistor);
+}
+void referencePull() {
+  *kPCR18 &= ~(PORT_PCR_PS_MASK | PORT_PCR_PE_MASK);
+  *kPCR18 |= PullResistor_t::PullUpResistor;
+}
+void driverPull() {
+  led.setPullResistor(PullResistor_t::PullUpResistor);
+}
+uint32_t readPCR18() {
+  return *kPCR18;
+}
+
+void clearPDOR() {
+  *kPDOR = 0;
+}
+void referenceWrite() {
+  *kPDOR |= kPin18;
+}
+void driverWrite() {
+  led.writeBit(1);
+}
+void referenceToggle() {
+  *kPTOR |= kPin18;
+}
+void driverToggle() {
+  led.toogleBit();
+}
+uint32_t readPDOR() {
+  return *kPDOR;
+}
+
+void resetPCR1() {
+  key.setPullResistor(PullResistor_t::PullUpResistor);
+  key.setInterrupt(PortIrq_t::dsf_IrqDisabled);
+}
+void referenceInterrupt() {
+  *kPCR1 = (*kPCR1 & ~PORT_PCR_IRQC_MASK)
+           | PORT_PCR_IRQC(PortIrq_t::dsf_IrqFalling) | PORT_PCR_ISF_MASK;
+  NVIC_ClearPendingIRQ(PORTA_IRQn);
+  NVIC_EnableIRQ(PORTA_IRQn);
+}
+void driverInterrupt() {
+  key.setInterrupt(PortIrq_t::dsf_IrqFalling);
+}
+uint32_t readPCR1() {
+  return *kPCR1;
+}
+
+/*!
+ * startDelay antigo, com o clock do TPM1 já adquirido pelos dois lados:
+ * só a escolha da fonte no SOPT2 e o TPM são acessados.
+ */
+void stopTPM1() {
+  *kTPM1SC = 0;
+}
+void referenceDelay() {
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_TPM1);
+  SIM_SOPT2 = (SIM_SOPT2 & ~SIM_SOPT2_TPMSRC_MASK)
+              | SIM_SOPT2_TPMSRC(dsf_MCG_ocp::timerSource());
+  *kTPM1SC = 0;
+  *kTPM1CNT = 0;
+  *kTPM1MOD = kDelayTicks;
+  *kTPM1SC |= TPMDiv_t::Div128;
+  *kTPM1SC |= 0x80;
+  *kTPM1SC |= 0x08;
+}
+void driverDelay() {
+  delay.startDelay(kDelayTicks);
+}
+uint32_t readTPM1() {
+  return (*kTPM1SC & 0x1F) | *kTPM1MOD << 8;
+}
+
+void noPreparation() {
+}
+void referenceGate() {
+  SIM_SCGC5 |= SIM_SCGC5_LPTMR_MASK;
+  SIM_SCGC5 &= ~SIM_SCGC5_LPTMR_MASK;
+}
+void driverGate() {
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_LPTMR);
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_LPTMR);
+}
+uint32_t readSCGC5() {
+  return SIM_SCGC5;
+}
+
+const Operation kOperations[] = {
+  {"setPortMode", clearPDDR, referencePortMode, driverPortMode, readPDDR},
+  {"setPullResistor", resetPCR, referencePull, driverPull, readPCR18},
+  {"writeBit", clearPDOR, referenceWrite, driverWrite, readPDOR},
+  {"toogleBit", clearPDOR, referenceToggle, driverToggle, readPDOR},
+  {"setInterrupt", resetPCR1, referenceInterrupt, driverInterrupt, readPCR1},
+  {"startDelay", stopTPM1, referenceDelay, driverDelay, readTPM1},
+  {"gateOn+gateOff", noPreparation, referenceGate, driverGate, readSCGC5}
+};
+const uint32_t kOperationCount = sizeof(kOperations)/sizeof(kOperations[0]);
+
+Cost costs[kOperationCount][2];
+
+Cost measure(void (*prepare)(), void (*run)(), uint32_t (*state)()) {
+  Cost cost;
+  uint64_t accesses, cycles;
+
+  prepare();
+  accesses = dsf_Sim::accessCount();
+  cycles = dsf_Sim::now();
+  run();
+  cost.accesses = dsf_Sim::accessCount() - accesses;
+  cost.cycles = dsf_Sim::now() - cycles;
+  cost.state = state();
+  return cost;
+}
+
+/*!
+ * Varredura: a borda em PTA1 cai offset ciclos depois do início da
+ * mudança de direção de PTB18. Conta as mudanças da interrupção perdidas
+ * e as interrupções tratadas.
+ */
+struct Sweep {
+  uint32_t lost;
+  uint32_t handled;
+};
+
+Sweep sweeps[2];
+
+void press(void *) {
+  dsf_Sim::drive(0, 1, Sim_t::dsf_Low);
+}
+
+void pace(uint32_t accesses) {
+  for (uint32_t i = 0; i < accesses; i++) {
+    *kPTOR = 0;
+  }
+}
+
+void sweep(bool decorated, Sweep *result) {
+  racer.decorated = decorated;
+  result->lost = 0;
+  result->handled = 0;
+  for (uint32_t offset = 0; offset < kSweepCycles; offset++) {
+    uint32_t calls = racer.calls;
+
+    *kPDDR = 0;
+    dsf_Sim::schedule(dsf_Sim::now() + offset, press, 0);
+    if (decorated) {
+      led.setPortMode(PortMode_t::Output);
+    } else {
+      *kPDDR |= kPin18;
+    }
+    pace(8);
+    dsf_Sim::drive(0, 1, Sim_t::dsf_Released);
+    pace(2);
+    result->handled += racer.calls - calls;
+    if (*kPDDR != (kPin18 | kPin19)) {
+      result->lost++;
+    }
+  }
+}
+
+void entry() {
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_TPM1);
+  delay.setFrequency(TPMDiv_t::Div128);
+  for (uint32_t i = 0; i < kOperationCount; i++) {
+    const Operation &op = kOperations[i];
+    costs[i][0] = measure(op.prepare, op.reference, op.state);
+    costs[i][1] = measure(op.prepare, op.driver, op.state);
+  }
+  *kTPM1SC = 0;
+  dsf_ClockGate_ocp::release(ClockGate_t::dsf_TPM1);
+
+  key.setPortMode(PortMode_t::Input);
+  key.setPullResistor(PullResistor_t::PullUpResistor);
+  key.setInterrupt(PortIrq_t::dsf_IrqFalling);
+  sweep(false, &sweeps[0]);
+  sweep(true, &sweeps[1]);
+  key.setInterrupt(PortIrq_t::dsf_IrqDisabled);
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+
+  dsf_Sim::run(entry, dsf_Sim::microseconds(1000000));
+
+  printf("%-16s %12s %10s %12s %10s %s\n", "operation", "rmw_accesses",
+         "rmw_cycles", "bme_accesses", "bme_cycles", "state");
+  for (uint32_t i = 0; i < kOperationCount; i++) {
+    const Cost &rmw = costs[i][0];
+    const Cost &bme = costs[i][1];
+    bool good = bme.state == rmw.state && bme.accesses < rmw.accesses
+                && bme.cycles < rmw.cycles;
+    printf("%-16s %12llu %10llu %12llu %10llu 0x%08x %s\n",
+           kOperations[i].name, (unsigned long long)rmw.accesses,
+           (unsigned long long)rmw.cycles, (unsigned long long)bme.accesses,
+           (unsigned long long)bme.cycles, bme.state,
+           bme.state == rmw.state ? (good ? "ok" : "FAIL")
+                                  : "FAIL (state differs)");
+    ok = ok && good;
+  }
+  printf("sweep offsets=%u rmw_lost=%u rmw_handled=%u bme_lost=%u"
+         " bme_handled=%u\n", kSweepCycles, sweeps[0].lost,
+         sweeps[0].handled, sweeps[1].lost, sweeps[1].handled);
+  ok = ok && sweeps[0].lost > 0 && sweeps[1].lost == 0
+       && sweeps[0].handled == kSweepCycles
+       && sweeps[1].handled == kSweepCycles;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
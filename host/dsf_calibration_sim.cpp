@@ -0,0 +1,246 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Erro das esperas antes e depois da calibração pela
+ *              referência externa, no simulador do host.
+ *
+ * @file        dsf_calibration_sim.cpp
+ * @version     1.0
+ * @date        13 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_calibration_sim.cpp
+ *                            sim/dsf_Sim.cpp ../dsf_Calibration_ocp.cpp
+ *                            ../dsf_Delay_ocp.cpp ../dsf_TPM_ocp.cpp
+ *                            ../dsf_ClockGate_ocp.cpp ../dsf_Irq_ocp.cpp
+ *                            ../dsf_MCG_ocp.cpp -o dsf_calibration_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (13 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_calibration_sim
+ *
+ *              O FLL do simulador roda com um erro do IRC (setIrcError) e
+ *              uma referência de 100 Hz exata chega ao PTE20 (TPM1_CH0). O
+ *              firmware mede, no tempo real do simulador, a espera de
+ *              400 ms do main.cpp (dsf_Delay_ocp::waitMicros no TPM2) e uma
+ *              espera de 5 s em quatro fases:
+ *              - nominal: antes da calibração;
+ *              - trimmed: depois de duas janelas de 1 s do
+ *                dsf_Calibration_ocp;
+ *              - step: logo depois de um degrau do erro do IRC (variação
+ *                de temperatura), com a correção antiga;
+ *              - retrimmed: depois de mais três janelas.
+ *
+ *              Cada cenário roda em um processo filho a partir do mesmo
+ *              estado. A tabela mostra o erro das duas esperas, em ppm, e
+ *              o erro medido pela calibração no início da fase. O código de
+ *              saída é 0 se o erro passa de 10000 ppm sem correção e fica
+ *              em até 50 ppm com ela, nas duas esperas, sem janelas
+ *              descartadas.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Calibration_ocp.h"
+#include "dsf_Delay_ocp.h"
+#include "dsf_Irq_ocp.h"
+
+namespace {
+
+const uint32_t kReferenceHz = 100;
+const uint32_t kShortUs = 400000;
+const uint32_t kLongUs = 5000000;
+const int32_t kMaxTrimmedPpm = 50;
+const int32_t kMinNominalPpm = 10000;
+
+enum Phase {
+  kNominal = 0,
+  kTrimmed = 1,
+  kStep = 2,
+  kRetrimmed = 3,
+  kPhases = 4
+};
+
+const char *const kPhaseNames[kPhases] = {"nominal", "trimmed", "step",
+                                          "retrimmed"};
+
+/*!
+ * Erro do IRC no início e depois do degrau, em ppm.
+ */
+struct Scenario {
+  int32_t ircPpm;
+  int32_t stepPpm;
+};
+
+const Scenario kScenarios[] = {{25000, -15000}, {-20000, 10000}};
+const int kNumScenarios = sizeof(kScenarios)/sizeof(kScenarios[0]);
+
+}  // namespace
+
+dsf_Delay_ocp tpm(TPM_t::dsf_TPM2);
+dsf_Calibration_ocp calibration(TPM_t::dsf_TPM1_PTE20, kReferenceHz);
+
+DSF_IRQ_BIND(TPM1, calibration)
+
+namespace {
+
+/*!
+ * Resultado de um cenário, enviado do processo filho pelo pipe.
+ */
+struct Result {
+  int32_t shortPpm[kPhases];
+  int32_t longPpm[kPhases];
+  int32_t measuredPpm[kPhases];
+  uint32_t windows;
+  uint32_t rejected;
+};
+
+Scenario scenario;
+Result result;
+uint64_t referenceAt;
+int referenceLevel;
+
+/*!
+ * Borda da referência; a próxima é agendada meio período depois, no
+ * tempo real do simulador.
+ */
+void reference(void *) {
+  referenceLevel = !referenceLevel;
+  dsf_Sim::drive(4, 20, referenceLevel ? Sim_t::dsf_High : Sim_t::dsf_Low);
+  referenceAt += dsf_Sim::coreFrequency()/(2*kReferenceHz);
+  dsf_Sim::schedule(referenceAt, reference, 0);
+}
+
+/*!
+ * Erro de uma espera medida no tempo real do simulador, em ppm.
+ */
+int32_t waitError(uint32_t micros) {
+  uint64_t begin = dsf_Sim::now();
+  int64_t elapsed;
+
+  tpm.waitMicros(micros);
+  elapsed = (int64_t)(dsf_Sim::now() - begin)
+            - (int64_t)dsf_Sim::microseconds(micros);
+  return (int32_t)(elapsed*1000000/(int64_t)dsf_Sim::microseconds(micros));
+}
+
+void measure(Phase phase) {
+  result.measuredPpm[phase] = calibration.errorPpm();
+  result.shortPpm[phase] = waitError(kShortUs);
+  result.longPpm[phase] = waitError(kLongUs);
+}
+
+void waitWindows(uint32_t count) {
+  uint32_t target = calibration.windows() + count;
+
+  while (calibration.windows() < target) {
+    tpm.waitMicros(10000);
+  }
+}
+
+void entry() {
+  tpm.setFrequency(TPMDiv_t::Div128);
+  measure(kNominal);
+  calibration.start();
+  waitWindows(2);
+  measure(kTrimmed);
+  dsf_Sim::setIrcError(scenario.stepPpm);
+  measure(kStep);
+  waitWindows(3);
+  measure(kRetrimmed);
+  result.windows = calibration.windows();
+  result.rejected = calibration.rejected();
+  dsf_Sim::stop();
+}
+
+/*!
+ * Roda um cenário no processo filho, a partir do estado inicial do pai.
+ */
+bool simulate(const Scenario &which, Result *out) {
+  int channel[2];
+  pid_t child;
+  int status;
+  bool ok;
+
+  if (pipe(channel) != 0 || (child = fork()) < 0) {
+    perror("dsf_calibration_sim");
+    return false;
+  }
+  if (child == 0) {
+    close(channel[0]);
+    scenario = which;
+    dsf_Sim::setIrcError(scenario.ircPpm);
+    referenceAt = dsf_Sim::now() + dsf_Sim::microseconds(1234);
+    dsf_Sim::schedule(referenceAt, reference, 0);
+    dsf_Sim::run(entry, dsf_Sim::now() + dsf_Sim::microseconds(60000000));
+    ok = write(channel[1], &result, sizeof(result)) == (ssize_t)sizeof(result);
+    _exit(ok ? 0 : 1);
+  }
+  close(channel[1]);
+  ok = read(channel[0], out, sizeof(*out)) == (ssize_t)sizeof(*out);
+  close(channel[0]);
+  return waitpid(child, &status, 0) == child && WIFEXITED(status)
+         && WEXITSTATUS(status) == 0 && ok;
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+
+  printf("%-9s %8s %9s %9s %12s\n", "phase", "irc_ppm", "400ms_ppm",
+         "5s_ppm", "measured_ppm");
+  for (int s = 0; s < kNumScenarios; s++) {
+    Result r;
+
+    if (!simulate(kScenarios[s], &r)) {
+      fprintf(stderr, "scenario %d: simulation failed\n", s);
+      return 1;
+    }
+    for (int p = 0; p < kPhases; p++) {
+      printf("%-9s %8d %9d %9d %12d\n", kPhaseNames[p],
+             p < kStep ? kScenarios[s].ircPpm : kScenarios[s].stepPpm,
+             r.shortPpm[p], r.longPpm[p], r.measuredPpm[p]);
+    }
+    printf("windows=%u rejected=%u\n", r.windows, r.rejected);
+    ok = ok && abs(r.shortPpm[kNominal]) > kMinNominalPpm
+         && abs(r.longPpm[kNominal]) > kMinNominalPpm
+         && abs(r.shortPpm[kTrimmed]) <= kMaxTrimmedPpm
+         && abs(r.longPpm[kTrimmed]) <= kMaxTrimmedPpm
+         && abs(r.shortPpm[kRetrimmed]) <= kMaxTrimmedPpm
+         && abs(r.longPpm[kRetrimmed]) <= kMaxTrimmedPpm
+         && r.rejected == 0;
+  }
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Perfis de relógio do MCG no simulador do host.
+ *
+ * @file        dsf_clock_sim.cpp
+ * @version     1.0
+ * @date        7 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -no-pie
+ *                            -Wno-int-to-pointer-cast -Isim -I..
+ *                            dsf_clock_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_MCG_ocp.cpp ../dsf_Delay_ocp.cpp
+ *                            ../dsf_SysClock_ocp.cpp ../dsf_UART_ocp.cpp
+ *                            ../dsf_Power_ocp.cpp ../dsf_TPM_ocp.cpp
+ *                            ../dsf_ClockGate_ocp.cpp ../dsf_Irq_ocp.cpp
+ *                            -o dsf_clock_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (7 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_clock_sim
+ *
+ *              Passa por todos os perfis do dsf_MCG_ocp com o SysClock e a
+ *              UART0 em andamento. Em cada perfil, uma temporização de
+ *              10 ms calculada com timerHz é medida no tempo simulado e 32
+ *              bytes a 115200 bauds são cronometrados na saída da UART0.
+ *              Depois, uma troca FEI -> PEE48 no meio de uma mensagem deve
+ *              mudar a taxa dos bytes seguintes para a nova taxa efetiva,
+ *              o SysClock deve ter acompanhado todas as trocas e um sono em
+ *              VLPS a partir do PEE deve voltar ao PLL. Uma linha por
+ *              perfil e o resumo vão para a saída padrão; o código de saída
+ *              é 0 se todas as medidas ficam dentro das tolerâncias.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_MCG_ocp.h"
+#include "dsf_Delay_ocp.h"
+#include "dsf_SysClock_ocp.h"
+#include "dsf_UART_ocp.h"
+#include "dsf_Power_ocp.h"
+#include "dsf_Irq_ocp.h"
+
+dsf_Delay_ocp delay(TPM_t::dsf_TPM1);
+dsf_SysClock_ocp sysClock(TPM_t::dsf_TPM2);
+dsf_UART_ocp serial(1);
+dsf_Power_ocp power;
+
+DSF_IRQ_BIND(TPM2, sysClock)
+DSF_IRQ_BIND(DMA1, serial)
+DSF_IRQ_BIND(LPTimer, power)
+
+namespace {
+
+const char *const kNames[MCG_t::dsf_NumProfiles] = {
+  "FEI", "FEE", "PEE48", "VLPR"
+};
+const uint32_t kDelayUs = 10000;
+const uint32_t kBaud = 115200;
+const uint32_t kBytes = 32;
+/*!
+ * Os ticks do SysClock contados durante uma troca, que passa pelo FEI,
+ * são convertidos na frequência anterior: alguns us por troca.
+ */
+const int64_t kClockToleranceUs = 30;
+
+/*!
+ * Medidas de um perfil: erro da temporização, taxa efetiva informada pela
+ * UART e taxa medida nos instantes dos bytes.
+ */
+struct Sample {
+  bool reached;
+  uint32_t coreHz;
+  uint32_t timerHz;
+  uint64_t delayErrorNs;
+  uint64_t delayToleranceNs;
+  uint32_t baud;
+  uint32_t measuredBaud;
+};
+
+Sample samples[MCG_t::dsf_NumProfiles];
+std::vector<uint64_t> stamps;
+
+struct Switch {
+  uint32_t baudBefore;
+  uint32_t baudAfter;
+  uint32_t measuredBefore;
+  uint32_t measuredAfter;
+  int64_t clockErrorUs;
+  bool resumed;
+  uint64_t sleepDelayErrorNs;
+  uint64_t sleepDelayToleranceNs;
+};
+
+Switch change = {0, 0, 0, 0, 0, false, 0, 0};
+
+void onByte(void *, uint8_t) {
+  stamps.push_back(dsf_Sim::now());
+}
+
+uint64_t cyclesToNanos(uint64_t cycles) {
+  return cycles*1000000000ull/dsf_Sim::coreFrequency();
+}
+
+uint64_t distance(uint64_t a, uint64_t b) {
+  return a > b ? a - b : b - a;
+}
+
+/*!
+ * Espera de n acessos (escritas no GPIOB_PTOR, sem pino de saída).
+ */
+void pace(uint32_t accesses) {
+  for (uint32_t i = 0; i < accesses; i++) {
+    DSF_SIM_REG32(0x400FF04Cu) = 0;
+  }
+}
+
+void waitDrained() {
+  for (int i = 0; i < 20000 && serial.space() != UART_t::dsf_RingSize; i++) {
+    pace(50);
+  }
+  pace(2000);
+}
+
+/*!
+ * Taxa medida entre os bytes first e last (10 bits por byte em 8N1).
+ */
+uint32_t measuredBaud(size_t first, size_t last) {
+  if (last >= stamps.size() || last <= first) {
+    return 0;
+  }
+  return (uint32_t)(10ull*(last - first)*dsf_Sim::coreFrequency()
+                    /(stamps[last] - stamps[first]));
+}
+
+/*!
+ * Temporização de 10 ms com Div128: o erro aceito é de dois ticks mais
+ * 10 us dos acessos de startDelay e timeoutDelay.
+ */
+uint64_t measureDelay(uint64_t *toleranceNs) {
+  uint32_t ticks = (uint32_t)((uint64_t)dsf_MCG_ocp::timerHz()*kDelayUs
+                              /128/1000000);
+  uint64_t start = dsf_Sim::now();
+
+  delay.startDelay((uint16_t)ticks);
+  while (!delay.timeoutDelay()) {
+  }
+  *toleranceNs = 2*128*1000000000ull/dsf_MCG_ocp::timerHz() + 10000;
+  return distance(cyclesToNanos(dsf_Sim::now() - start),
+                  (uint64_t)kDelayUs*1000);
+}
+
+void entry() {
+  static const MCG_t::dsf_Profile order[] = {
+    MCG_t::dsf_FEE, MCG_t::dsf_PEE48, MCG_t::dsf_VLPR, MCG_t::dsf_FEI
+  };
+  uint8_t message[64];
+  uint64_t clockStart, simStart;
+  size_t cut;
+
+  for (uint32_t i = 0; i < sizeof(message); i++) {
+    message[i] = (uint8_t)('A' + i % 26);
+  }
+  delay.setFrequency(TPMDiv_t::Div128);
+  sysClock.setFrequency(TPMDiv_t::Div16);
+  sysClock.start();
+  serial.start(kBaud);
+  clockStart = sysClock.microseconds();
+  simStart = dsf_Sim::now();
+
+  for (uint32_t i = 0; i < sizeof(order)/sizeof(order[0]); i++) {
+    Sample &sample = samples[order[i]];
+    sample.reached = dsf_MCG_ocp::setProfile(order[i])
+                     && dsf_MCG_ocp::profile() == order[i];
+    sample.coreHz = dsf_MCG_ocp::coreHz();
+    sample.timerHz = dsf_MCG_ocp::timerHz();
+    sample.delayErrorNs = measureDelay(&sample.delayToleranceNs);
+    stamps.clear();
+    serial.write(message, kBytes);
+    waitDrained();
+    sample.baud = serial.baud();
+    sample.measuredBaud = measuredBaud(1, stamps.size() - 1);
+  }
+
+  /*!
+   * Troca no meio da mensagem: o byte em transmissão durante a troca não
+   * entra em nenhuma das medidas.
+   */
+  stamps.clear();
+  change.baudBefore = serial.baud();
+  serial.write(message, sizeof(message));
+  while (stamps.size() < 20) {
+    pace(10);
+  }
+  dsf_MCG_ocp::setProfile(MCG_t::dsf_PEE48);
+  cut = stamps.size();
+  change.baudAfter = serial.baud();
+  waitDrained();
+  change.measuredBefore = measuredBaud(1, cut - 1);
+  change.measuredAfter = measuredBaud(cut + 1, stamps.size() - 1);
+
+  change.clockErrorUs = (int64_t)(sysClock.microseconds() - clockStart)
+                        - (int64_t)(cyclesToNanos(dsf_Sim::now() - simStart)
+                                    /1000);
+  sysClock.stop();
+  serial.stop();
+
+  /*!
+   * Sono em VLPS a partir do PEE: o MCG sai em PBE e sleep volta ao PLL.
+   */
+  power.start(Power_t::dsf_VLPS);
+  power.sleep(5);
+  change.resumed = (*(volatile uint8_t *)0x40064006u & 0x0C) == 0x0C;
+  change.sleepDelayErrorNs = measureDelay(&change.sleepDelayToleranceNs);
+  power.stop();
+  dsf_MCG_ocp::setProfile(MCG_t::dsf_FEI);
+}
+
+bool within(uint32_t measured, uint32_t expected, uint32_t ppm) {
+  return expected
+         && distance(measured, expected)*1000000 <= (uint64_t)expected*ppm;
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+
+  dsf_Sim::listen(onByte, 0);
+  dsf_Sim::run(entry, dsf_Sim::microseconds(5000000));
+
+  for (uint32_t p = 0; p < MCG_t::dsf_NumProfiles; p++) {
+    const Sample &s = samples[p];
+    bool good = s.reached && s.delayErrorNs <= s.delayToleranceNs
+                && within(s.measuredBaud, s.baud, 2000)
+                && within(s.baud, kBaud, 10000);
+    printf("%-5s core_hz=%u timer_hz=%u delay_err_ns=%llu/%llu baud=%u"
+           " measured=%u %s\n", kNames[p], s.coreHz, s.timerHz,
+           (unsigned long long)s.delayErrorNs,
+           (unsigned long long)s.delayToleranceNs, s.baud, s.measuredBaud,
+           good ? "ok" : "FAIL");
+    ok = ok && good;
+  }
+  printf("switch baud=%u->%u measured=%u->%u clock_err_us=%lld"
+         " resumed=%d sleep_delay_err_ns=%llu\n", change.baudBefore,
+         change.baudAfter, change.measuredBefore, change.measuredAfter,
+         (long long)change.clockErrorUs, change.resumed ? 1 : 0,
+         (unsigned long long)change.sleepDelayErrorNs);
+  ok = ok && change.baudBefore != change.baudAfter
+       && within(change.measuredBefore, change.baudBefore, 2000)
+       && within(change.measuredAfter, change.baudAfter, 2000)
+       && change.clockErrorUs > -kClockToleranceUs
+       && change.clockErrorUs < kClockToleranceUs && change.resumed
+       && change.sleepDelayErrorNs <= change.sleepDelayToleranceNs;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
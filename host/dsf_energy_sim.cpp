@@ -0,0 +1,245 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Energia por sorteio das estratégias de espera no simulador
+ *              do host.
+ *
+ * @file        dsf_energy_sim.cpp
+ * @version     1.0
+ * @date        10 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_energy_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_Power_ocp.cpp ../dsf_Delay_ocp.cpp
+ *                            ../dsf_SysClock_ocp.cpp ../dsf_GPIO_ocp.cpp
+ *                            ../dsf_TPM_ocp.cpp ../dsf_ClockGate_ocp.cpp
+ *                            ../dsf_Irq_ocp.cpp ../dsf_MCG_ocp.cpp
+ *                            -o dsf_energy_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (10 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_energy_sim
+ *
+ *              O laço do main.cpp (espera de 400 ms do TPM2, led PTB18
+ *              piscando enquanto a tecla PTA1 está solta) roda por 10,5 s
+ *              com um toque de 500 ms por segundo; cada toque visto pelo laço
+ *              conta como um sorteio. A espera é feita de três maneiras,
+ *              cada uma em um processo filho a partir do mesmo estado:
+ *              - busy: dsf_Delay_ocp::waitDelay, lendo o TOF;
+ *              - wait: dsf_Power_ocp com deepest = dsf_Run (WFI comum);
+ *              - vlps: dsf_Power_ocp com deepest = dsf_VLPS.
+ *
+ *              A tabela mostra o tempo em cada modo e no led aceso, a
+ *              energia estimada pelo dsf_Sim em cada parcela e a energia
+ *              por sorteio. O tempo do led aceso depende da fase das piscadas
+ *              em relação aos toques e varia um pouco entre as versões. O
+ *              código de saída é 0 se as três versões veem todos os toques e
+ *              a energia cai de busy para wait e de wait para vlps.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Delay_ocp.h"
+#include "dsf_GPIO_ocp.h"
+#include "dsf_Irq_ocp.h"
+#include "dsf_Power_ocp.h"
+
+namespace {
+
+const uint64_t kRunUs = 10500000;
+const uint64_t kFirstPressUs = 700000;
+const uint64_t kPressUs = 500000;
+const uint64_t kPressPeriodUs = 1000000;
+const uint32_t kPresses = 10;
+
+enum Design {
+  kBusy = 0,
+  kWait = 1,
+  kVLPS = 2,
+  kDesigns = 3
+};
+
+const char *const kDesignNames[kDesigns] = {"busy", "wait", "vlps"};
+
+}  // namespace
+
+dsf_GPIO_ocp led(GPIO_t::dsf_GPIOB, GPIO_t::dsf_PTB18);
+dsf_GPIO_ocp key(GPIO_t::dsf_GPIOA, GPIO_t::dsf_PTA1);
+dsf_Delay_ocp tpm(TPM_t::dsf_TPM2);
+dsf_Power_ocp power;
+
+DSF_IRQ_BIND(LPTimer, power)
+
+namespace {
+
+/*!
+ * Resultado de uma versão, enviado do processo filho pelo pipe.
+ */
+struct Result {
+  uint32_t draws;
+  uint64_t modeCycles[Sim_t::dsf_NumModes];
+  uint64_t ledCycles;
+  double microjoules[Sim_t::dsf_NumParts];
+  double total;
+};
+
+Design design;
+uint32_t draws;
+
+void press(void *) {
+  dsf_Sim::drive(0, 1, Sim_t::dsf_Low);
+}
+
+void release(void *) {
+  dsf_Sim::drive(0, 1, Sim_t::dsf_Released);
+}
+
+void wait400ms() {
+  if (design == kBusy) {
+    tpm.waitDelay(0xFFFF);
+    return;
+  }
+  tpm.startDelay(0xFFFF);
+  while (!tpm.timeoutDelay()) {
+    power.sleep();
+  }
+  tpm.cancelDelay();
+}
+
+void entry() {
+  bool wasPressed = false;
+  int bit = 0;
+
+  led.setPortMode(PortMode_t::Output);
+  key.setPortMode(PortMode_t::Input);
+  key.setPullResistor(PullResistor_t::PullUpResistor);
+  tpm.setFrequency(TPMDiv_t::Div128);
+  if (design != kBusy) {
+    power.track(&tpm);
+    power.start(design == kWait ? Power_t::dsf_Run : Power_t::dsf_VLPS);
+  }
+  while (true) {
+    wait400ms();
+    if (key.readBit()) {
+      bit = !bit;
+      led.writeBit(bit);
+      wasPressed = false;
+    } else {
+      led.writeBit(1);
+      if (!wasPressed) {
+        draws++;
+      }
+      wasPressed = true;
+    }
+  }
+}
+
+/*!
+ * Roda uma versão no processo filho, a partir do estado inicial do pai.
+ */
+bool simulate(Design which, Result *result) {
+  int channel[2];
+  pid_t child;
+  int status;
+  bool ok;
+
+  if (pipe(channel) != 0 || (child = fork()) < 0) {
+    perror("dsf_energy_sim");
+    return false;
+  }
+  if (child == 0) {
+    Result out;
+    uint64_t at = dsf_Sim::microseconds(kFirstPressUs);
+
+    close(channel[0]);
+    design = which;
+    for (uint32_t i = 0; i < kPresses; i++) {
+      dsf_Sim::schedule(at, press, 0);
+      dsf_Sim::schedule(at + dsf_Sim::microseconds(kPressUs), release, 0);
+      at += dsf_Sim::microseconds(kPressPeriodUs);
+    }
+    dsf_Sim::run(entry, dsf_Sim::now() + dsf_Sim::microseconds(kRunUs));
+    out.draws = draws;
+    for (int m = 0; m < Sim_t::dsf_NumModes; m++) {
+      out.modeCycles[m] = dsf_Sim::modeCycles((Sim_t::dsf_PowerMode)m);
+    }
+    out.ledCycles = dsf_Sim::loadCycles(1, 18);
+    for (int p = 0; p < Sim_t::dsf_NumParts; p++) {
+      out.microjoules[p] = dsf_Sim::microjoules((Sim_t::dsf_EnergyPart)p);
+    }
+    out.total = dsf_Sim::microjoules();
+    ok = write(channel[1], &out, sizeof(out)) == (ssize_t)sizeof(out);
+    _exit(ok ? 0 : 1);
+  }
+  close(channel[1]);
+  ok = read(channel[0], result, sizeof(*result)) == (ssize_t)sizeof(*result);
+  close(channel[0]);
+  return waitpid(child, &status, 0) == child && WIFEXITED(status)
+         && WEXITSTATUS(status) == 0 && ok;
+}
+
+uint64_t cyclesToMillis(uint64_t cycles) {
+  return cycles*1000/dsf_Sim::coreFrequency();
+}
+
+}  // namespace
+
+int main() {
+  Result results[kDesigns];
+  bool ok = true;
+
+  printf("%-6s %7s %7s %7s %7s %9s %9s %9s %9s %9s %5s %11s\n", "design",
+         "run_ms", "wait_ms", "vlps_ms", "led_ms", "core_uj", "clocks_uj",
+         "flash_uj", "loads_uj", "total_uj", "draws", "uj_per_draw");
+  for (int d = 0; d < kDesigns; d++) {
+    const Result &r = results[d];
+
+    if (!simulate((Design)d, &results[d])) {
+      fprintf(stderr, "%s: simulation failed\n", kDesignNames[d]);
+      return 1;
+    }
+    printf("%-6s %7llu %7llu %7llu %7llu %9.1f %9.1f %9.1f %9.1f %9.1f %5u"
+           " %11.1f\n", kDesignNames[d],
+           (unsigned long long)cyclesToMillis(r.modeCycles[Sim_t::dsf_Run]),
+           (unsigned long long)cyclesToMillis(r.modeCycles[Sim_t::dsf_Wait]),
+           (unsigned long long)cyclesToMillis(r.modeCycles[Sim_t::dsf_VLPS]),
+           (unsigned long long)cyclesToMillis(r.ledCycles),
+           r.microjoules[Sim_t::dsf_Core], r.microjoules[Sim_t::dsf_Clocks],
+           r.microjoules[Sim_t::dsf_Flash], r.microjoules[Sim_t::dsf_Loads],
+           r.total, r.draws, r.draws ? r.total/r.draws : 0.0);
+    ok = ok && r.draws == kPresses;
+  }
+  ok = ok && results[kBusy].total > results[kWait].total
+       && results[kWait].total > results[kVLPS].total;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,315 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Vazão, desgaste e falta de energia do dsf_FlashLog_ocp.
+ *
+ * @file        dsf_flashlog_sim.cpp
+ * @version     1.0
+ * @date        5 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_flashlog_sim.cpp
+ *                            sim/dsf_Sim.cpp ../dsf_FlashLog_ocp.cpp
+ *                            ../dsf_Flash_ocp.cpp -o dsf_flashlog_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (5 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_flashlog_sim [-n cortes] [-s semente] [-f flash.bin]
+ *
+ *              Primeiro, sobre uma flash apagada, 3000 sorteios atualizam
+ *              os totais de sorteios e de vitórias, com service no laço
+ *              ocioso e depois sem service: com service nenhuma atualização
+ *              espera um apagamento. Os apagamentos dos setores devem ficar
+ *              iguais, a menos de um. A linha com service traz a energia
+ *              estimada dos comandos do FTFA e a energia total por sorteio.
+ *
+ *              Depois, a alimentação é cortada em um instante
+ *              pseudoaleatório de cada partida, no meio de gravações,
+ *              apagamentos e compactações. A partida seguinte confere que
+ *              cada total recuperado é o último gravado por completo ou o
+ *              que estava sendo gravado, e que mount não demora mais com o
+ *              histórico. O arquivo da flash é apagado no fim, a menos que
+ *              seja dado com -f. O código de saída é 0 se todas as
+ *              verificações passam.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_FlashLog_ocp.h"
+#include "lpm_draw.h"
+
+namespace {
+
+const uint32_t kDraws = 3000;
+const uint32_t kUnservicedDraws = 400;
+const uint32_t kKeys = 2;
+
+/*!
+ * Totais esperados: acked é o último valor gravado com sucesso e pending
+ * o valor da gravação em andamento (igual a acked fora dela).
+ */
+struct Model {
+  uint32_t acked[kKeys];
+  uint32_t pending[kKeys];
+};
+
+/*!
+ * Medidas de uma execução do firmware de teste.
+ */
+struct Measure {
+  uint32_t updates;
+  uint64_t setCycles;
+  uint64_t maxSetCycles;
+  uint64_t mountCycles;
+  uint32_t stalls;
+  uint32_t mismatches;
+  uint8_t status;
+};
+
+Model model;
+Measure measure;
+lpm_draw draws(1);
+bool serviced = true;
+uint32_t updateCount = kDraws;
+
+void clearMeasure() {
+  memset(&measure, 0, sizeof(measure));
+}
+
+/*!
+ * Uma atualização de um total, medida em ciclos.
+ */
+void update(dsf_FlashLog_ocp *log, uint8_t key) {
+  uint64_t before = dsf_Sim::now();
+  uint8_t status;
+
+  model.pending[key] = model.acked[key] + 1;
+  status = log->set(key, model.pending[key]);
+  if (status == Flash_t::dsf_FlashOk) {
+    model.acked[key] = model.pending[key];
+  } else {
+    measure.status |= status;
+    model.pending[key] = model.acked[key];
+  }
+  before = dsf_Sim::now() - before;
+  measure.updates++;
+  measure.setCycles += before;
+  if (before > measure.maxSetCycles) {
+    measure.maxSetCycles = before;
+  }
+}
+
+/*!
+ * Partida: mount e conferência dos totais recuperados com o modelo.
+ */
+bool boot(dsf_FlashLog_ocp *log) {
+  uint64_t before = dsf_Sim::now();
+  uint8_t status = log->mount();
+
+  measure.mountCycles = dsf_Sim::now() - before;
+  if (status != Flash_t::dsf_FlashOk) {
+    measure.status |= status;
+    return false;
+  }
+  for (uint8_t key = 0; key < kKeys; key++) {
+    uint32_t value = log->value(key);
+    if (value != model.acked[key] && value != model.pending[key]) {
+      measure.mismatches++;
+    }
+    model.acked[key] = value;
+    model.pending[key] = value;
+  }
+  return true;
+}
+
+void drawEntry() {
+  dsf_FlashLog_ocp log;
+
+  if (!boot(&log)) {
+    return;
+  }
+  for (uint32_t i = 0; i < updateCount; i++) {
+    update(&log, FlashLog_t::dsf_KeyDraws);
+    if (lpm_draw::isWin(draws.draw())) {
+      update(&log, FlashLog_t::dsf_KeyWins);
+    }
+    while (serviced && log.service()) {
+    }
+  }
+  measure.stalls = log.stalls();
+}
+
+/*!
+ * Atualizações sem fim, com service a cada uma, até o corte.
+ */
+void cutEntry() {
+  dsf_FlashLog_ocp log;
+
+  if (!boot(&log)) {
+    return;
+  }
+  for (uint32_t i = 0;; i++) {
+    update(&log, (i % 5) == 4 ? FlashLog_t::dsf_KeyWins
+                              : FlashLog_t::dsf_KeyDraws);
+    log.service();
+  }
+}
+
+void mountEntry() {
+  dsf_FlashLog_ocp log;
+
+  boot(&log);
+}
+
+uint32_t cutCommand;
+
+void cut(void *) {
+  cutCommand = dsf_Sim::cutPower();
+}
+
+double cyclesToMicros(uint64_t cycles) {
+  return cycles*1e6/dsf_Sim::coreFrequency();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t trials = 300;
+  uint64_t seed = 1;
+  const char *path = 0;
+  lpm_random generator;
+  uint32_t cuts[4] = {0, 0, 0, 0};
+  uint32_t minErases = ~0u, maxErases = 0, mismatches = 0;
+  uint64_t maxMount = 0;
+  bool ok = true;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      trials = (uint32_t)strtoul(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      seed = strtoull(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+      path = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [-n cuts] [-s seed] [-f flash.bin]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (path) {
+    unlink(path);
+  }
+  if (!dsf_Sim::attachFlash(path ? path : "dsf_flashlog_sim.bin")) {
+    perror("attachFlash");
+    return 1;
+  }
+  if (!path) {
+    unlink("dsf_flashlog_sim.bin");
+  }
+  dsf_Sim::setAccessCycles(100);
+
+  /*!
+   * Vazão com service no laço ocioso: set nunca apaga um setor.
+   */
+  clearMeasure();
+  dsf_Sim::run(drawEntry, ~0ull);
+  printf("serviced updates=%lu draws=%lu wins=%lu mean_set_us=%.1f "
+         "max_set_us=%.1f stalls=%lu flash_uj=%.1f uj_per_draw=%.2f\n",
+         (unsigned long)measure.updates,
+         (unsigned long)model.acked[0], (unsigned long)model.acked[1],
+         cyclesToMicros(measure.setCycles/measure.updates),
+         cyclesToMicros(measure.maxSetCycles),
+         (unsigned long)measure.stalls,
+         dsf_Sim::microjoules(Sim_t::dsf_Flash),
+         dsf_Sim::microjoules()/kDraws);
+  ok = ok && measure.status == 0 && measure.stalls == 0
+       && model.acked[0] == kDraws
+       && cyclesToMicros(measure.maxSetCycles) < 1000;
+
+  dsf_Sim::reset();
+  clearMeasure();
+  serviced = false;
+  updateCount = kUnservicedDraws;
+  dsf_Sim::run(drawEntry, ~0ull);
+  printf("unserviced updates=%lu mean_set_us=%.1f max_set_us=%.1f "
+         "stalls=%lu\n", (unsigned long)measure.updates,
+         cyclesToMicros(measure.setCycles/measure.updates),
+         cyclesToMicros(measure.maxSetCycles),
+         (unsigned long)measure.stalls);
+  ok = ok && measure.status == 0 && measure.stalls > 0
+       && measure.mismatches == 0;
+
+  for (uint32_t s = 0; s < FlashLog_t::dsf_LogSectors; s++) {
+    uint32_t erases = dsf_Sim::flashErases(FlashLog_t::dsf_LogBase
+                                           + s*Flash_t::dsf_SectorSize);
+    minErases = erases < minErases ? erases : minErases;
+    maxErases = erases > maxErases ? erases : maxErases;
+  }
+  printf("erases min=%lu max=%lu\n", (unsigned long)minErases,
+         (unsigned long)maxErases);
+  ok = ok && maxErases - minErases <= 1;
+
+  /*!
+   * Cortes de alimentação de 0 a 30 ms após cada partida.
+   */
+  generator.seed(seed);
+  for (uint32_t t = 0; t < trials; t++) {
+    dsf_Sim::reset();
+    clearMeasure();
+    cutCommand = 0;
+    dsf_Sim::schedule(1 + generator.next() % dsf_Sim::microseconds(30000),
+                      cut, 0);
+    dsf_Sim::run(cutEntry, ~0ull);
+    mismatches += measure.mismatches;
+    maxMount = measure.mountCycles > maxMount ? measure.mountCycles : maxMount;
+    cuts[cutCommand == 0x06 ? 1 : cutCommand == 0x09 ? 2
+         : cutCommand == 0x01 ? 3 : 0]++;
+    ok = ok && measure.status == 0;
+  }
+  dsf_Sim::reset();
+  clearMeasure();
+  dsf_Sim::run(mountEntry, ~0ull);
+  mismatches += measure.mismatches;
+  printf("cuts=%lu idle=%lu program=%lu erase=%lu verify=%lu "
+         "mismatches=%lu draws=%lu wins=%lu max_mount_us=%.1f\n",
+         (unsigned long)trials, (unsigned long)cuts[0],
+         (unsigned long)cuts[1], (unsigned long)cuts[2],
+         (unsigned long)cuts[3], (unsigned long)mismatches,
+         (unsigned long)model.acked[0], (unsigned long)model.acked[1],
+         cyclesToMicros(maxMount));
+  ok = ok && mismatches == 0 && measure.status == 0 && cuts[1] > 0
+       && cuts[2] > 0 && cyclesToMicros(maxMount) < 1000;
+
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
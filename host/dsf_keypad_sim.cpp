@@ -0,0 +1,238 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Debounce, n-key rollover, fila de eventos e duração da
+ *              varredura do teclado matricial no simulador do host.
+ *
+ * @file        dsf_keypad_sim.cpp
+ * @version     1.0
+ * @date        15 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_keypad_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_Keypad_ocp.cpp ../dsf_TPM_ocp.cpp
+ *                            ../dsf_ClockGate_ocp.cpp ../dsf_Irq_ocp.cpp
+ *                            ../dsf_MCG_ocp.cpp -o dsf_keypad_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (15 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_keypad_sim
+ *
+ *              Teclado 4x4 com linhas em PTC0..PTC3 e colunas em
+ *              PTC4..PTC7, varrido a cada 1 ms pelo TPM1. Cada tecla é uma
+ *              ligação entre os pinos da sua linha e da sua coluna, feita e
+ *              desfeita nos instantes do roteiro. O roteiro tem um pulso de
+ *              2,2 ms, que o debounce deve ignorar, um toque com trepidação
+ *              na pressão e na soltura, quatro teclas seguradas ao mesmo
+ *              tempo (duas na mesma coluna, sem formar um L que gere tecla
+ *              fantasma) e duas teclas da mesma linha pressionadas juntas.
+ *
+ *              O laço principal dorme em WFI e retira os eventos da fila.
+ *              O código de saída é 0 se os eventos chegam na ordem, com os
+ *              códigos e tipos esperados e sem descartes; se cada pressão
+ *              e soltura é informada de 3 a 5 varreduras depois de a
+ *              ligação se firmar; se isPressed mostra as quatro teclas
+ *              seguradas e nenhuma outra; se o teclado sem colunas não tem
+ *              teclas; e se a maior varredura, contada do overflow do TPM
+ *              ao fim da varredura, fica abaixo de 10 us.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Irq_ocp.h"
+#include "dsf_Keypad_ocp.h"
+
+namespace {
+
+const GPIO_t::dsf_Pin kRows[] = {GPIO_t::dsf_PTC0, GPIO_t::dsf_PTC1,
+                                 GPIO_t::dsf_PTC2, GPIO_t::dsf_PTC3};
+const GPIO_t::dsf_Pin kColumns[] = {GPIO_t::dsf_PTC4, GPIO_t::dsf_PTC5,
+                                    GPIO_t::dsf_PTC6, GPIO_t::dsf_PTC7};
+
+/*!
+ * 1311 ciclos de 20,97 MHz/16: 1 ms por varredura.
+ */
+const uint16_t kScanCycles = 1311;
+const uint32_t kScanMicros = 1000;
+const uint32_t kMaxScanMicros = 10;
+
+}  // namespace
+
+dsf_Keypad_ocp keypad(GPIO_t::dsf_GPIOC, kRows, 4, GPIO_t::dsf_GPIOC,
+                      kColumns, 4, TPM_t::dsf_TPM1);
+dsf_Keypad_ocp empty(GPIO_t::dsf_GPIOC, kRows, 4, GPIO_t::dsf_GPIOC,
+                     kColumns, 0, TPM_t::dsf_TPM2);
+
+DSF_IRQ_BIND(TPM1, keypad)
+
+namespace {
+
+/*!
+ * Um passo do roteiro: instante em microssegundos, tecla e contato.
+ * settles indica que o contato fica firme e um evento é esperado.
+ */
+struct Step {
+  uint32_t micros;
+  uint8_t code;
+  bool closed;
+  bool settles;
+};
+
+const Step kScript[] = {
+  {10000, 5, true, false}, {12200, 5, false, false},
+  {20000, 6, true, false}, {20600, 6, false, false},
+  {21700, 6, true, false}, {22300, 6, false, false},
+  {23400, 6, true, true},
+  {40000, 6, false, false}, {40500, 6, true, false},
+  {41600, 6, false, true},
+  {60000, 0, true, true}, {70000, 4, true, true},
+  {80000, 10, true, true}, {90000, 15, true, true},
+  {110000, 0, false, true}, {120000, 4, false, true},
+  {130000, 10, false, true}, {140000, 15, false, true},
+  {160000, 12, true, true}, {160000, 13, true, true},
+  {170000, 12, false, true}, {170000, 13, false, true}
+};
+const uint32_t kSteps = sizeof(kScript)/sizeof(kScript[0]);
+const uint32_t kEndMicros = 200000;
+
+/*!
+ * Eventos recebidos pelo laço principal, com o instante da retirada.
+ */
+struct Received {
+  dsf_Event event;
+  uint64_t cycle;
+};
+
+Received received[64];
+uint32_t receivedCount;
+uint8_t held[16];
+
+void contact(void *argument) {
+  const Step *step = (const Step *)argument;
+  uint8_t row = kRows[step->code / 4];
+  uint8_t column = kColumns[step->code % 4];
+
+  if (step->closed) {
+    dsf_Sim::wire(GPIO_t::dsf_GPIOC, row, GPIO_t::dsf_GPIOC, column);
+  } else {
+    dsf_Sim::unwire(GPIO_t::dsf_GPIOC, row, GPIO_t::dsf_GPIOC, column);
+  }
+}
+
+void snapshot(void *) {
+  for (uint8_t code = 0; code < 16; code++) {
+    held[code] = (uint8_t)keypad.isPressed(code);
+  }
+}
+
+void entry() {
+  dsf_Event event;
+
+  keypad.setFrequency(TPMDiv_t::Div16);
+  keypad.start(kScanCycles);
+  for (;;) {
+    __WFI();
+    while (keypad.events().pop(&event)) {
+      if (receivedCount < sizeof(received)/sizeof(received[0])) {
+        received[receivedCount].event = event;
+        received[receivedCount].cycle = dsf_Sim::now();
+        receivedCount++;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+  uint32_t expected = 0;
+  uint32_t lastStamp = 0;
+  double maxScan;
+
+  for (uint32_t i = 0; i < kSteps; i++) {
+    dsf_Sim::schedule(dsf_Sim::microseconds(kScript[i].micros), contact,
+                      (void *)&kScript[i]);
+  }
+  dsf_Sim::schedule(dsf_Sim::microseconds(100000), snapshot, 0);
+  dsf_Sim::run(entry, dsf_Sim::microseconds(kEndMicros));
+
+  printf("%-6s %-8s %6s %10s %10s\n", "code", "type", "stamp", "settle_us",
+         "delay_us");
+  for (uint32_t i = 0; i < kSteps; i++) {
+    const Step &step = kScript[i];
+    const Received *got;
+    uint64_t delay;
+
+    if (!step.settles) {
+      continue;
+    }
+    if (expected >= receivedCount) {
+      printf("%-6u %-8s missing\n", step.code,
+             step.closed ? "press" : "release");
+      ok = false;
+      continue;
+    }
+    got = &received[expected++];
+    delay = got->cycle - dsf_Sim::microseconds(step.micros);
+    printf("%-6u %-8s %6lu %10lu %10.0f\n", got->event.code,
+           got->event.type == Event_t::dsf_Press ? "press" : "release",
+           (unsigned long)got->event.stamp, (unsigned long)step.micros,
+           delay*1e6/dsf_Sim::coreFrequency());
+    ok = ok && got->event.source == Event_t::dsf_SourceKeypad
+         && got->event.code == step.code
+         && got->event.type == (step.closed ? Event_t::dsf_Press :
+                                Event_t::dsf_Release)
+         && got->event.stamp >= lastStamp
+         && delay >= dsf_Sim::microseconds(3*kScanMicros)
+         && delay <= dsf_Sim::microseconds(5*kScanMicros);
+    lastStamp = got->event.stamp;
+  }
+  ok = ok && receivedCount == expected
+       && keypad.events().droppedCount() == 0;
+
+  printf("held:");
+  for (uint8_t code = 0; code < 16; code++) {
+    printf(" %u", held[code]);
+    ok = ok && held[code] == (code == 0 || code == 4 || code == 10
+                              || code == 15);
+  }
+  printf("\n");
+  for (uint32_t code = 0; code < 256; code++) {
+    ok = ok && empty.isPressed((uint8_t)code) == 0;
+  }
+
+  maxScan = keypad.maxScanTicks()*16e6/dsf_Sim::coreFrequency();
+  printf("events=%u max_scan_ticks=%u max_scan_us=%.1f\n", receivedCount,
+         keypad.maxScanTicks(), maxScan);
+  ok = ok && maxScan < kMaxScanMicros;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
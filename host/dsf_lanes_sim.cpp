@@ -0,0 +1,551 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Verificação e custo por tick do dsf_Lanes_ocp no simulador
+ *              do host.
+ *
+ * @file        dsf_lanes_sim.cpp
+ * @version     1.0
+ * @date        12 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_lanes_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_Lanes_ocp.cpp ../dsf_Delay_ocp.cpp
+ *                            ../dsf_TPM_ocp.cpp ../dsf_GPIO_ocp.cpp
+ *                            ../dsf_ClockGate_ocp.cpp ../dsf_Irq_ocp.cpp
+ *                            ../dsf_MCG_ocp.cpp -o dsf_lanes_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (12 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_lanes_sim
+ *
+ *              Primeiro, 32 pistas (teclas nos GPIOs A a D e leds no GPIOE,
+ *              metade ativos em nível baixo) rodam por 8 s com os ticks do
+ *              TPM1 a 25 Hz, cada pista com oito toques em instantes
+ *              próprios. Cada pista deve sortear uma vez por toque, acender
+ *              o led uma vez por vitória e ter as vitórias da sua sequência
+ *              do gerador (a base avançada 2^64 passos por pista).
+ *
+ *              Depois, o custo de um tick é medido com 1 a 32 pistas, com
+ *              os ticks chamados no intervalo de esperas do TPM2, em
+ *              acessos a registradores por tick, sem toques (idle) e com
+ *              cada pista tocada 4 de cada 16 ticks (busy). As pistas ficam
+ *              em um só GPIO para as teclas e outro para os leds (packed) ou
+ *              distribuídas pelos cinco GPIOs (spread), e a mesma carga roda
+ *              em uma versão de referência que lê e escreve cada pista com
+ *              os seus próprios acessos, como N objetos dsf_GPIO_ocp. As duas
+ *              versões devem contar os mesmos sorteios e vitórias.
+ *
+ *              O KL25 de 80 pinos não tem 64 pinos GPIO livres: os pinos
+ *              além dos da placa existem só no simulador. O simulador conta
+ *              os acessos ao barramento; o trabalho do núcleo de um tick é
+ *              proporcional ao número de GPIOs usados mais o de pistas com
+ *              evento no tick. O código de saída é 0 se as pistas estão
+ *              corretas e, com 32 pistas, um tick custa no máximo um quarto
+ *              dos acessos da referência e o custo por pista cai ao menos
+ *              quatro vezes de 1 para 32 pistas.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Delay_ocp.h"
+#include "dsf_Irq_ocp.h"
+#include "dsf_Lanes_ocp.h"
+#include "lpm_draw.h"
+
+namespace {
+
+const uint32_t kLanes = Lanes_t::dsf_MaxLanes;
+const uint32_t kPresses = 8;
+const uint64_t kRunUs = 8000000;
+const uint32_t kTicks = 1024;
+const uint32_t kPressPeriod = 16;
+const uint32_t kPressTicks = 4;
+const uint8_t kShowTicks = 2;
+const uint16_t kPaceCycles = 4800;
+const uint8_t kCounts[] = {1, 2, 4, 8, 16, 32};
+const uint32_t kNumCounts = sizeof(kCounts)/sizeof(kCounts[0]);
+
+enum Layout {
+  kPacked = 0,
+  kSpread = 1,
+  kLayouts = 2
+};
+
+const char *const kLayoutNames[kLayouts] = {"packed", "spread"};
+
+/*!
+ * Pinos de uma pista em cada disposição.
+ */
+struct Wiring {
+  uint8_t keyGPIO;
+  uint8_t keyPin;
+  uint8_t ledGPIO;
+  uint8_t ledPin;
+  bool activeLow;
+};
+
+Wiring wiring(Layout layout, uint32_t lane) {
+  Wiring w;
+
+  if (layout == kPacked) {
+    w.keyGPIO = GPIO_t::dsf_GPIOC;
+    w.keyPin = (uint8_t)lane;
+    w.ledGPIO = GPIO_t::dsf_GPIOE;
+    w.ledPin = (uint8_t)lane;
+  } else {
+    w.keyGPIO = (uint8_t)(lane % Lanes_t::dsf_Ports);
+    w.keyPin = (uint8_t)(lane / Lanes_t::dsf_Ports);
+    w.ledGPIO = (uint8_t)((lane + 1) % Lanes_t::dsf_Ports);
+    w.ledPin = (uint8_t)(16 + lane / Lanes_t::dsf_Ports);
+  }
+  w.activeLow = lane & 1;
+  return w;
+}
+
+/*!
+ * Correção: teclas nos GPIOs A a D, pinos 8 a 15, e leds no GPIOE.
+ */
+Wiring checkWiring(uint32_t lane) {
+  Wiring w;
+
+  w.keyGPIO = (uint8_t)(lane % 4);
+  w.keyPin = (uint8_t)(8 + lane / 4);
+  w.ledGPIO = GPIO_t::dsf_GPIOE;
+  w.ledPin = (uint8_t)lane;
+  w.activeLow = lane & 1;
+  return w;
+}
+
+/*!
+ * Resultado de um cenário, enviado do processo filho pelo pipe.
+ */
+struct Result {
+  uint32_t draws[kLanes];
+  uint32_t wins[kLanes];
+  uint32_t lit[kLanes];
+  uint32_t refDraws[kLanes];
+  uint32_t refWins[kLanes];
+  double idle;
+  double busy;
+  double refIdle;
+  double refBusy;
+  uint32_t ticks;
+};
+
+Result result;
+Layout layout;
+uint32_t laneCount;
+
+/*!
+ *  @class    NaiveLanes
+ *
+ *  @brief    Referência: o mesmo fluxo das pistas, uma pista por vez.
+ *
+ *  @details  Cada pista lê a sua tecla no PDIR e escreve o seu led no
+ *            PSOR ou no PCOR, com o mesmo filtro, a mesma exibição e as
+ *            mesmas sequências do gerador do dsf_Lanes_ocp.
+ */
+class NaiveLanes {
+ public:
+  explicit NaiveLanes(uint64_t seed) : count(0), generator(seed) {
+  }
+
+  void attach(const Wiring &w) {
+    Lane &lane = lanes[count++];
+
+    lane.PDIR = (volatile uint32_t *)(0xF80FF010 + 0x40*w.keyGPIO);
+    lane.PSOR = (volatile uint32_t *)(0xF80FF004 + 0x40*w.ledGPIO);
+    lane.PCOR = (volatile uint32_t *)(0xF80FF008 + 0x40*w.ledGPIO);
+    lane.keyMask = 1u << w.keyPin;
+    lane.ledMask = 1u << w.ledPin;
+    lane.activeLow = w.activeLow;
+    lane.raw = false;
+    lane.pressed = false;
+    lane.state = kIdle;
+    lane.show = 0;
+    lane.won = false;
+    lane.draw.generator = generator;
+    lane.draws = 0;
+    lane.wins = 0;
+    generator.jump();
+  }
+
+  void tick() {
+    for (uint32_t i = 0; i < count; i++) {
+      Lane &lane = lanes[i];
+      bool raw;
+
+      if (lane.state == kShowing && --lane.show == 0) {
+        lane.state = kWaiting;
+        if (lane.won) {
+          setLed(lane, false);
+          lane.won = false;
+        }
+      }
+      raw = !(*lane.PDIR & lane.keyMask);
+      if (raw == lane.raw) {
+        if (raw && !lane.pressed && lane.state == kIdle) {
+          lane.state = kShowing;
+          lane.show = kShowTicks;
+          lane.draws++;
+          if (lpm_draw::isWin(lane.draw.draw())) {
+            lane.wins++;
+            lane.won = true;
+            setLed(lane, true);
+          }
+        }
+        lane.pressed = raw;
+      }
+      lane.raw = raw;
+      if (lane.state == kWaiting && !lane.pressed) {
+        lane.state = kIdle;
+      }
+    }
+  }
+
+  uint32_t draws(uint32_t lane) {
+    return lanes[lane].draws;
+  }
+
+  uint32_t wins(uint32_t lane) {
+    return lanes[lane].wins;
+  }
+
+ private:
+  enum State {
+    kIdle,
+    kShowing,
+    kWaiting
+  };
+
+  struct Lane {
+    volatile uint32_t *PDIR;
+    volatile uint32_t *PSOR;
+    volatile uint32_t *PCOR;
+    uint32_t keyMask;
+    uint32_t ledMask;
+    bool activeLow;
+    bool raw;
+    bool pressed;
+    State state;
+    uint8_t show;
+    bool won;
+    lpm_draw draw;
+    uint32_t draws;
+    uint32_t wins;
+  };
+
+  void setLed(Lane &lane, bool on) {
+    if (on != lane.activeLow) {
+      *lane.PSOR = lane.ledMask;
+    } else {
+      *lane.PCOR = lane.ledMask;
+    }
+  }
+
+  Lane lanes[kLanes];
+  uint32_t count;
+  lpm_random generator;
+};
+
+}  // namespace
+
+dsf_Lanes_ocp lanes(TPM_t::dsf_TPM1);
+
+DSF_IRQ_BIND(TPM1, lanes)
+
+namespace {
+
+void press(void *argument) {
+  uint32_t lane = (uint32_t)(uintptr_t)argument;
+  Wiring w = checkWiring(lane);
+
+  dsf_Sim::drive(w.keyGPIO, w.keyPin, Sim_t::dsf_Low);
+}
+
+void release(void *argument) {
+  uint32_t lane = (uint32_t)(uintptr_t)argument;
+  Wiring w = checkWiring(lane);
+
+  dsf_Sim::drive(w.keyGPIO, w.keyPin, Sim_t::dsf_Released);
+}
+
+/*!
+ * Conta os acendimentos do led de cada pista.
+ */
+void ledChanged(void *argument, uint8_t, uint8_t, int level) {
+  uint32_t lane = (uint32_t)(uintptr_t)argument;
+
+  if (level == (checkWiring(lane).activeLow ? 0 : 1)) {
+    result.lit[lane]++;
+  }
+}
+
+void checkEntry() {
+  for (uint32_t i = 0; i < kLanes; i++) {
+    Wiring w = checkWiring(i);
+
+    lanes.attach((GPIO_t::dsf_GPIO)w.keyGPIO, (GPIO_t::dsf_Pin)w.keyPin,
+                 (GPIO_t::dsf_GPIO)w.ledGPIO, (GPIO_t::dsf_Pin)w.ledPin,
+                 w.activeLow ? Lanes_t::dsf_ActiveLow
+                             : Lanes_t::dsf_ActiveHigh);
+  }
+  for (uint32_t i = 0; i < kLanes; i++) {
+    Wiring w = checkWiring(i);
+
+    dsf_Sim::watch(w.ledGPIO, w.ledPin, ledChanged, (void *)(uintptr_t)i);
+  }
+  lanes.setTickRate(25);
+  lanes.setShowTicks(10);
+  lanes.start();
+  while (true) {
+    __WFI();
+  }
+}
+
+/*!
+ * Teclas da carga busy: a pista i fica pressionada kPressTicks de cada
+ * kPressPeriod ticks, com fase 3*i.
+ */
+void driveKeys(uint32_t tick) {
+  for (uint32_t i = 0; i < laneCount; i++) {
+    Wiring w = wiring(layout, i);
+    bool down = (tick + 3*i) % kPressPeriod < kPressTicks;
+
+    dsf_Sim::drive(w.keyGPIO, w.keyPin,
+                   down ? Sim_t::dsf_Low : Sim_t::dsf_Released);
+  }
+}
+
+void releaseKeys() {
+  for (uint32_t i = 0; i < laneCount; i++) {
+    Wiring w = wiring(layout, i);
+
+    dsf_Sim::drive(w.keyGPIO, w.keyPin, Sim_t::dsf_Released);
+  }
+}
+
+/*!
+ * Acessos de kTicks ticks, sem contar as esperas entre eles. O TPM2 fica
+ * contando durante o tick: o simulador trata leituras repetidas do mesmo
+ * registrador (o PDIR lido pista a pista na referência) como espera ativa
+ * e avança até o próximo evento, que não pode faltar.
+ */
+template <typename Lanes>
+double measureTicks(Lanes *target, dsf_Delay_ocp *pace, bool pressing) {
+  uint64_t accesses = 0;
+
+  for (uint32_t t = 0; t < kTicks; t++) {
+    uint64_t before;
+
+    pace->startDelay(kPaceCycles);
+    while (!pace->timeoutDelay()) {
+    }
+    if (pressing) {
+      driveKeys(t);
+    }
+    before = dsf_Sim::accessCount();
+    target->tick();
+    accesses += dsf_Sim::accessCount() - before;
+  }
+  pace->cancelDelay();
+  return (double)accesses/kTicks;
+}
+
+template <typename Lanes>
+void measure(Lanes *target, dsf_Delay_ocp *pace, double *idle,
+             double *busy) {
+  releaseKeys();
+  *idle = measureTicks(target, pace, false);
+  *busy = measureTicks(target, pace, true);
+}
+
+void costEntry() {
+  dsf_Lanes_ocp packed(TPM_t::dsf_TPM1);
+  dsf_Delay_ocp pace(TPM_t::dsf_TPM2);
+  NaiveLanes reference(1);
+
+  pace.setFrequency(TPMDiv_t::Div1);
+  packed.setShowTicks(kShowTicks);
+  for (uint32_t i = 0; i < laneCount; i++) {
+    Wiring w = wiring(layout, i);
+
+    packed.attach((GPIO_t::dsf_GPIO)w.keyGPIO, (GPIO_t::dsf_Pin)w.keyPin,
+                  (GPIO_t::dsf_GPIO)w.ledGPIO, (GPIO_t::dsf_Pin)w.ledPin,
+                  w.activeLow ? Lanes_t::dsf_ActiveLow
+                              : Lanes_t::dsf_ActiveHigh);
+    reference.attach(w);
+  }
+  measure(&packed, &pace, &result.idle, &result.busy);
+  measure(&reference, &pace, &result.refIdle, &result.refBusy);
+  for (uint32_t i = 0; i < laneCount; i++) {
+    dsf_LaneStats stats;
+
+    packed.getStats((uint8_t)i, &stats);
+    result.draws[i] = stats.draws;
+    result.wins[i] = stats.wins;
+    result.refDraws[i] = reference.draws(i);
+    result.refWins[i] = reference.wins(i);
+  }
+}
+
+/*!
+ * Toques da verificação: pista i a cada 900 ms a partir de 300 ms + 17*i
+ * ms, por 200 ms, dentro dos 400 ms de exibição.
+ */
+void scheduleChecks() {
+  for (uint32_t i = 0; i < kLanes; i++) {
+    uint64_t at = dsf_Sim::microseconds(300000 + 17000*i);
+
+    for (uint32_t k = 0; k < kPresses; k++) {
+      dsf_Sim::schedule(at, press, (void *)(uintptr_t)i);
+      dsf_Sim::schedule(at + dsf_Sim::microseconds(200000), release,
+                        (void *)(uintptr_t)i);
+      at += dsf_Sim::microseconds(900000);
+    }
+  }
+}
+
+/*!
+ * Roda um cenário no processo filho, a partir do estado inicial do pai.
+ */
+bool simulate(void (*entry)(), uint64_t untilCycle, Result *out) {
+  int channel[2];
+  pid_t child;
+  int status;
+  bool ok;
+
+  if (pipe(channel) != 0 || (child = fork()) < 0) {
+    perror("dsf_lanes_sim");
+    return false;
+  }
+  if (child == 0) {
+    close(channel[0]);
+    if (entry == checkEntry) {
+      scheduleChecks();
+    }
+    dsf_Sim::run(entry, untilCycle);
+    result.ticks = lanes.ticks();
+    if (entry == checkEntry) {
+      for (uint32_t i = 0; i < kLanes; i++) {
+        dsf_LaneStats stats;
+
+        lanes.getStats((uint8_t)i, &stats);
+        result.draws[i] = stats.draws;
+        result.wins[i] = stats.wins;
+      }
+    }
+    ok = write(channel[1], &result, sizeof(result)) == (ssize_t)sizeof(result);
+    _exit(ok ? 0 : 1);
+  }
+  close(channel[1]);
+  ok = read(channel[0], out, sizeof(*out)) == (ssize_t)sizeof(*out);
+  close(channel[0]);
+  return waitpid(child, &status, 0) == child && WIFEXITED(status)
+         && WEXITSTATUS(status) == 0 && ok;
+}
+
+/*!
+ * Vitórias esperadas nos primeiros sorteios de cada pista.
+ */
+uint32_t expectedWins(uint32_t lane, uint32_t draws) {
+  lpm_draw draw(1);
+  uint32_t wins = 0;
+
+  for (uint32_t i = 0; i < lane; i++) {
+    draw.generator.jump();
+  }
+  for (uint32_t i = 0; i < draws; i++) {
+    wins += lpm_draw::isWin(draw.draw());
+  }
+  return wins;
+}
+
+}  // namespace
+
+int main() {
+  Result check, costs[kLayouts][kNumCounts];
+  uint32_t totalDraws = 0, totalWins = 0;
+  bool ok = true, distinct = false;
+
+  if (!simulate(checkEntry, dsf_Sim::microseconds(kRunUs), &check)) {
+    fprintf(stderr, "check: simulation failed\n");
+    return 1;
+  }
+  for (uint32_t i = 0; i < kLanes; i++) {
+    bool laneOk = check.draws[i] == kPresses
+                  && check.wins[i] == expectedWins(i, kPresses)
+                  && check.lit[i] == check.wins[i];
+
+    if (!laneOk) {
+      printf("lane %u: draws=%u wins=%u expected_wins=%u lit=%u FAIL\n", i,
+             check.draws[i], check.wins[i], expectedWins(i, kPresses),
+             check.lit[i]);
+    }
+    distinct = distinct || check.wins[i] != check.wins[0];
+    totalDraws += check.draws[i];
+    totalWins += check.wins[i];
+    ok = ok && laneOk;
+  }
+  ok = ok && distinct;
+  printf("check lanes=%u ticks=%u draws=%u wins=%u %s\n", kLanes, check.ticks,
+         totalDraws, totalWins, ok ? "OK" : "FAIL");
+
+  printf("%-6s %5s %8s %8s %9s %9s %7s\n", "layout", "lanes", "idle",
+         "busy", "ref_idle", "ref_busy", "draws");
+  for (int l = 0; l < kLayouts; l++) {
+    for (uint32_t c = 0; c < kNumCounts; c++) {
+      Result &r = costs[l][c];
+      uint32_t draws = 0;
+
+      layout = (Layout)l;
+      laneCount = kCounts[c];
+      if (!simulate(costEntry, ~0ull, &r)) {
+        fprintf(stderr, "%s: simulation failed\n", kLayoutNames[l]);
+        return 1;
+      }
+      for (uint32_t i = 0; i < laneCount; i++) {
+        ok = ok && r.draws[i] == r.refDraws[i] && r.wins[i] == r.refWins[i]
+             && r.draws[i] > 0;
+        draws += r.draws[i];
+      }
+      printf("%-6s %5u %8.2f %8.2f %9.2f %9.2f %7u\n", kLayoutNames[l],
+             laneCount, r.idle, r.busy, r.refIdle, r.refBusy, draws);
+    }
+    ok = ok && costs[l][kNumCounts - 1].busy*4
+               <= costs[l][kNumCounts - 1].refBusy
+         && costs[l][kNumCounts - 1].busy*4 <= costs[l][0].busy*kLanes;
+  }
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
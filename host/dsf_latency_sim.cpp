@@ -0,0 +1,262 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Latência tecla-led do firmware no simulador do host.
+ *
+ * @file        dsf_latency_sim.cpp
+ * @version     1.0
+ * @date        25 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. -Dmain=firmware_main -c ../main.cpp
+ *                            g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_latency_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_Latency_ocp.cpp ../dsf_Delay_ocp.cpp
+ *                            ../dsf_GPIO_ocp.cpp ../dsf_TPM_ocp.cpp
+ *                            ../dsf_ClockGate_ocp.cpp ../dsf_Irq_ocp.cpp
+ *                            ../dsf_MCG_ocp.cpp main.o -o dsf_latency_sim
+ *                            (-DDSF_IRQ_AUDIT no segundo comando inclui a
+ *                            auditoria das interrupções na saída)
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (25 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_latency_sim [-n toques] [-s semente] [-q]
+ *
+ *              O main.cpp da placa é executado sem alterações no simulador,
+ *              com a tecla (PTA1) ligada a PTA12 e o led verde (PTB18) a
+ *              PTA13, como na bancada. Os toques têm instantes e durações
+ *              pseudoaleatórios, reprodutíveis pela semente. O histograma do
+ *              dsf_Latency_ocp é comparado com a latência exata observada
+ *              nos pinos pelo simulador: o código de saída é 0 se as
+ *              contagens são iguais e o mínimo, a média, o p99 e o máximo
+ *              diferem da referência em no máximo uma classe do
+ *              histograma. Com -q só a linha de resumo é escrita, para
+ *              comparar builds com diff.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Latency_ocp.h"
+#include "dsf_Irq_ocp.h"
+#include "lpm_random.h"
+
+/*!
+ * Ponto de entrada do firmware (main.cpp compilado com -Dmain=...).
+ */
+int firmware_main();
+
+dsf_Latency_ocp latency(TPM_t::dsf_TPM1_PTA12, TPM_t::dsf_TPM1_PTA13);
+
+DSF_IRQ_BIND(TPM1, latency)
+
+namespace {
+
+/*!
+ * Ciclos do núcleo por tick do TPM com o Div16 padrão do dsf_Latency_ocp.
+ */
+const uint32_t kTickCycles = 16;
+
+/*!
+ * Latência exata observada nos pinos, em ciclos do núcleo.
+ */
+struct Reference {
+  uint64_t pressedAt;
+  bool armed;
+  uint64_t count;
+  uint64_t sum;
+  uint64_t min;
+  uint64_t max;
+};
+
+Reference reference = {0, false, 0, 0, ~0ull, 0};
+std::vector<uint64_t> samples;
+
+void onKey(void *, uint8_t, uint8_t, int level) {
+  if (!level && !reference.armed) {
+    reference.pressedAt = dsf_Sim::now();
+    reference.armed = true;
+  }
+}
+
+void onLed(void *, uint8_t, uint8_t, int) {
+  uint64_t cycles;
+
+  if (!reference.armed) {
+    return;
+  }
+  cycles = dsf_Sim::now() - reference.pressedAt;
+  reference.armed = false;
+  reference.count++;
+  reference.sum += cycles;
+  samples.push_back(cycles);
+  if (cycles < reference.min) {
+    reference.min = cycles;
+  }
+  if (cycles > reference.max) {
+    reference.max = cycles;
+  }
+}
+
+void press(void *) {
+  dsf_Sim::drive(0, 1, Sim_t::dsf_Low);
+}
+
+void release(void *) {
+  dsf_Sim::drive(0, 1, Sim_t::dsf_Released);
+}
+
+void entry() {
+  firmware_main();
+}
+
+void putChar(char c) {
+  putchar(c);
+}
+
+double cyclesToMicros(uint64_t cycles) {
+  return cycles*1e6/dsf_Sim::coreFrequency();
+}
+
+/*!
+ * Classe do histograma que contém um valor em ticks.
+ */
+int bucketIndex(uint64_t ticks) {
+  int b = 0;
+
+  while (b + 1 < Latency_t::dsf_Buckets
+         && dsf_Latency_ocp::bucketLow((uint8_t)(b + 1)) <= ticks) {
+    b++;
+  }
+  return b;
+}
+
+/*!
+ * Compara um valor do histograma com o de referência, em ciclos: a
+ * diferença deve ser de no máximo uma classe.
+ */
+bool sameBucket(uint32_t ticks, uint64_t cycles) {
+  int difference = bucketIndex(ticks) - bucketIndex(cycles/kTickCycles);
+
+  return difference >= -1 && difference <= 1;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t presses = 200;
+  uint64_t seed = 1;
+  bool quiet = false;
+  lpm_random generator;
+  uint64_t at = dsf_Sim::microseconds(50000);
+  uint64_t mean = 0, p99 = 0;
+  dsf_LatencyStats stats;
+  bool ok;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      presses = (uint32_t)strtoul(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      seed = strtoull(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-q")) {
+      quiet = true;
+    } else {
+      fprintf(stderr, "usage: %s [-n presses] [-s seed] [-q]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  /*!
+   * Bancada: tecla em PTA1 + PTA12 (TPM1_CH0), led em PTB18 + PTA13
+   * (TPM1_CH1). Toques de 150 a 650 ms a cada 0,6 a 1,6 s.
+   */
+  dsf_Sim::wire(0, 1, 0, 12);
+  dsf_Sim::wire(1, 18, 0, 13);
+  dsf_Sim::watch(0, 1, onKey, 0);
+  dsf_Sim::watch(1, 18, onLed, 0);
+  generator.seed(seed);
+  for (uint32_t i = 0; i < presses; i++) {
+    dsf_Sim::schedule(at, press, 0);
+    dsf_Sim::schedule(at + dsf_Sim::microseconds(150000 + generator.next()
+                                                 % 500000),
+                      release, 0);
+    at += dsf_Sim::microseconds(600000 + generator.next() % 1000000);
+  }
+
+  latency.start();
+#ifdef DSF_IRQ_AUDIT
+  dsf_IrqAudit_ocp::start();
+#endif
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+  dsf_Sim::run(entry, at + dsf_Sim::microseconds(1000000));
+  double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+
+  latency.getStats(&stats);
+  if (reference.count) {
+    std::sort(samples.begin(), samples.end());
+    mean = reference.sum/reference.count;
+    p99 = samples[(reference.count*99 + 99)/100 - 1];
+  }
+  ok = stats.count == reference.count
+       && (!stats.count
+           || (sameBucket(stats.min, reference.min)
+               && sameBucket(stats.mean, mean)
+               && sameBucket(stats.p99, p99)
+               && sameBucket(stats.max, reference.max)));
+  if (!quiet) {
+    latency.dump(putChar);
+#ifdef DSF_IRQ_AUDIT
+    dsf_IrqAudit_ocp::dump(putChar);
+#endif
+    printf("reference count=%llu min_us=%.1f mean_us=%.1f p99_us=%.1f"
+           " max_us=%.1f\n", (unsigned long long)reference.count,
+           cyclesToMicros(reference.min), cyclesToMicros(mean),
+           cyclesToMicros(p99), cyclesToMicros(reference.max));
+    printf("simulated %.3f s in %.3f s, %llu accesses, %llu interrupts\n",
+           cyclesToMicros(dsf_Sim::now())/1e6, seconds,
+           (unsigned long long)dsf_Sim::accessCount(),
+           (unsigned long long)dsf_Sim::interruptCount());
+  } else {
+    printf("latency count=%lu min_us=%lu mean_us=%lu p99_us=%lu max_us=%lu\n",
+           (unsigned long)stats.count,
+           (unsigned long)latency.ticksToMicros(stats.min),
+           (unsigned long)latency.ticksToMicros(stats.mean),
+           (unsigned long)latency.ticksToMicros(stats.p99),
+           (unsigned long)latency.ticksToMicros(stats.max));
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,361 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Divisão do tempo por categoria e janela deslizante do
+ *              medidor de carga no simulador do host.
+ *
+ * @file        dsf_loadmeter_sim.cpp
+ * @version     1.0
+ * @date        16 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. -DDSF_LOAD_METER
+ *                            dsf_loadmeter_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_LoadMeter_ocp.cpp
+ *                            ../dsf_SysClock_ocp.cpp ../dsf_Delay_ocp.cpp
+ *                            ../dsf_Power_ocp.cpp ../dsf_TPM_ocp.cpp
+ *                            ../dsf_ClockGate_ocp.cpp ../dsf_Irq_ocp.cpp
+ *                            ../dsf_MCG_ocp.cpp -o dsf_loadmeter_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (16 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_loadmeter_sim
+ *
+ *              O medidor usa o relógio do TPM0 com fatias de 10 ms (janela
+ *              de 8 fatias). Um tratador do TPM2, ligado por DSF_IRQ_BIND,
+ *              ocupa cerca de 100 us a cada 1 ms durante todo o teste. Cada
+ *              fatia do roteiro é gasta em uma atividade: aplicação (laço
+ *              de leituras), espera ativa (waitMicros do TPM1) ou sono
+ *              (dsf_Power_ocp::sleep com WFI comum). Três voltas de 2
+ *              fatias de aplicação, 4 de espera e 2 de sono são seguidas
+ *              por 8 fatias só de aplicação.
+ *
+ *              Nos pontos de verificação, a fração de cada categoria na
+ *              janela (share) e utilization são comparadas com o tempo de
+ *              cada atividade medido pelo roteiro nas 7 fatias completas
+ *              anteriores, descontada a fração medida das interrupções,
+ *              com tolerância de 2 pontos. Depois de 8 fatias só de
+ *              aplicação, espera e sono devem ser zero e a utilização 99
+ *              ou 100 %, o que mostra a troca das fatias antigas. O tempo
+ *              total de interrupções desde start deve coincidir com o
+ *              medido no próprio tratador, mais o do relógio e a entrada e
+ *              saída dos tratadores, em 20 %.
+ *
+ *              Por fim o dsf_Power_ocp passa a dormir em VLPS, com o
+ *              relógio registrado por track, por 100 ms simulados. O TPM0
+ *              para no sono e o relógio deve avançar o tempo simulado a
+ *              1 ms por sono, com pelo menos 90 % dele contado como sono
+ *              pelo medidor. O código de saída é 0 se todas as
+ *              verificações passam.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Delay_ocp.h"
+#include "dsf_Irq_ocp.h"
+#include "dsf_LoadMeter_ocp.h"
+#include "dsf_Power_ocp.h"
+#include "dsf_SysClock_ocp.h"
+
+namespace {
+
+/*!
+ * Registradores SC e CNT do TPM2, que gera a carga de interrupções.
+ */
+volatile uint32_t *const kTPM2SC = (volatile uint32_t *)0x4003A000u;
+volatile uint32_t *const kTPM2CNT = (volatile uint32_t *)0x4003A004u;
+volatile uint32_t *const kTPM2MOD = (volatile uint32_t *)0x4003A008u;
+
+const uint32_t kSlotMicros = 10000;
+const uint32_t kStopMicros = 100000;
+const uint32_t kBurnReads = 125;
+const int kTolerance = 2;
+
+/*!
+ * Gasta tempo com leituras alternadas, que o simulador não trata como
+ * um laço de espera.
+ */
+void burn(uint32_t pairs) {
+  for (uint32_t i = 0; i < pairs; i++) {
+    (void)*kTPM2CNT;
+    (void)*kTPM2SC;
+  }
+}
+
+/*!
+ * Tratador de carga: cerca de 100 us por overflow do TPM2.
+ */
+class dsf_Burner {
+ public:
+  uint64_t cycles;
+
+  void irqHandler() {
+    uint64_t start = dsf_Sim::now();
+
+    *kTPM2SC = 0x80 | 0x40 | 0x08 | 4;
+    burn(kBurnReads);
+    cycles += dsf_Sim::now() - start;
+  }
+};
+
+}  // namespace
+
+dsf_SysClock_ocp sysClock(TPM_t::dsf_TPM0);
+dsf_Delay_ocp delay(TPM_t::dsf_TPM1);
+dsf_Power_ocp power;
+dsf_Burner burner;
+
+DSF_IRQ_BIND(TPM0, sysClock)
+DSF_IRQ_BIND(TPM2, burner)
+DSF_IRQ_BIND(LPTimer, power)
+
+namespace {
+
+enum Activity {
+  kApplication = LoadMeter_t::dsf_Application,
+  kDelay = LoadMeter_t::dsf_Delay,
+  kSleep = LoadMeter_t::dsf_Sleep
+};
+
+const uint8_t kScript[] = {
+  kApplication, kApplication, kDelay, kDelay, kDelay, kDelay, kSleep, kSleep,
+  kApplication, kApplication, kDelay, kDelay, kDelay, kDelay, kSleep, kSleep,
+  kApplication, kApplication, kDelay, kDelay, kDelay, kDelay, kSleep, kSleep,
+  kApplication, kApplication, kApplication, kApplication,
+  kApplication, kApplication, kApplication, kApplication
+};
+const uint32_t kSlotCount = sizeof(kScript);
+
+/*!
+ * Pontos de verificação: a janela é lida logo após o início da fatia.
+ */
+const uint32_t kChecks[] = {12, 20, 24, 28, 32};
+const uint32_t kCheckCount = sizeof(kChecks)/sizeof(kChecks[0]);
+
+/*!
+ * Trechos de cada atividade, em ticks do relógio, para o cálculo das
+ * frações esperadas em cada janela.
+ */
+struct Interval {
+  uint64_t from;
+  uint64_t to;
+  uint8_t activity;
+};
+
+Interval intervals[2*kSlotCount];
+uint32_t intervalCount;
+dsf_LoadStats window[kCheckCount];
+uint64_t windowEnd[kCheckCount];
+uint64_t windowStart[kCheckCount];
+uint64_t interruptTicks;
+uint64_t totalTicks;
+
+/*!
+ * Fase em VLPS: ciclos simulados, ticks do relógio e do medidor.
+ */
+struct StopPhase {
+  uint64_t cycles;
+  uint64_t clockTicks;
+  uint64_t sleepTicks;
+  uint32_t sleeps;
+};
+
+StopPhase stopPhase;
+
+void record(uint64_t from, uint8_t activity) {
+  Interval &interval = intervals[intervalCount++];
+
+  interval.from = from;
+  interval.to = sysClock.ticks();
+  interval.activity = activity;
+}
+
+void runSlot(uint8_t activity, uint64_t end) {
+  uint64_t now = sysClock.ticks();
+  uint32_t hz = sysClock.tickFrequency();
+
+  switch (activity) {
+    case kDelay:
+      if (end > now) {
+        delay.waitMicros((uint32_t)((end - now)*1000000/hz));
+      }
+      break;
+    case kSleep:
+      while (sysClock.ticks() + hz/1000 < end) {
+        power.sleep((uint32_t)((end - sysClock.ticks())*1000/hz));
+      }
+      break;
+    default:
+      break;
+  }
+  record(now, activity);
+  now = sysClock.ticks();
+  while (sysClock.ticks() < end) {
+    burn(1);
+  }
+  record(now, kApplication);
+}
+
+/*!
+ * Sonos em VLPS, em que o TPM0 do relógio para.
+ */
+void stopSleeps() {
+  uint64_t cycle, ticks, slept;
+
+  NVIC_DisableIRQ(TPM2_IRQn);
+  power.track(&sysClock);
+  power.start(Power_t::dsf_VLPS);
+  cycle = dsf_Sim::now();
+  ticks = sysClock.ticks();
+  slept = dsf_LoadMeter_ocp::totalTicks(LoadMeter_t::dsf_Sleep);
+  while (dsf_Sim::now() - cycle < dsf_Sim::microseconds(kStopMicros)) {
+    power.sleep(20);
+    stopPhase.sleeps++;
+  }
+  stopPhase.cycles = dsf_Sim::now() - cycle;
+  stopPhase.clockTicks = sysClock.ticks() - ticks;
+  stopPhase.sleepTicks =
+      dsf_LoadMeter_ocp::totalTicks(LoadMeter_t::dsf_Sleep) - slept;
+}
+
+void entry() {
+  uint64_t slotTicks, start;
+  uint32_t check = 0;
+
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_TPM2);
+  *kTPM2MOD = 1310;
+  *kTPM2SC = 0x80 | 0x40 | 0x08 | 4;
+  NVIC_EnableIRQ(TPM2_IRQn);
+  delay.setFrequency(TPMDiv_t::Div128);
+  power.start(Power_t::dsf_Run);
+  sysClock.start();
+
+  slotTicks = (uint64_t)kSlotMicros*sysClock.tickFrequency()/1000000;
+  start = sysClock.ticks();
+  dsf_LoadMeter_ocp::start(&sysClock, kSlotMicros);
+  burner.cycles = 0;
+  for (uint32_t s = 0; s < kSlotCount; s++) {
+    runSlot(kScript[s], start + (s + 1)*slotTicks);
+    if (check < kCheckCount && s + 1 == kChecks[check]) {
+      windowStart[check] = start + (s - 6)*slotTicks;
+      dsf_LoadMeter_ocp::getStats(&window[check]);
+      windowEnd[check] = sysClock.ticks();
+      check++;
+    }
+  }
+  interruptTicks = dsf_LoadMeter_ocp::totalTicks(LoadMeter_t::dsf_Interrupt);
+  totalTicks = 0;
+  for (uint8_t c = 0; c < LoadMeter_t::dsf_NumCategories; c++) {
+    totalTicks +=
+        dsf_LoadMeter_ocp::totalTicks((LoadMeter_t::dsf_LoadCategory)c);
+  }
+  stopSleeps();
+}
+
+bool near(int value, int expected) {
+  return value >= expected - kTolerance && value <= expected + kTolerance;
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+  double irq;
+  uint64_t slack;
+
+  dsf_Sim::run(entry, dsf_Sim::microseconds(1000000));
+
+  /*!
+   * No simulador o tick do TPM0 com Div1 é um ciclo do núcleo.
+   */
+  irq = totalTicks ? (double)interruptTicks/totalTicks : 0;
+  printf("interrupts meter_ticks=%llu handler_cycles=%llu share=%.1f%%\n",
+         (unsigned long long)interruptTicks,
+         (unsigned long long)burner.cycles, irq*100);
+  ok = ok && interruptTicks >= burner.cycles
+       && interruptTicks <= burner.cycles*12/10;
+
+  printf("%-6s %5s %5s %5s %5s %5s   %5s %5s %5s %5s\n", "slot", "app",
+         "delay", "sleep", "irq", "util", "e_app", "e_dly", "e_slp",
+         "e_utl");
+  for (uint32_t i = 0; i < kCheckCount; i++) {
+    const dsf_LoadStats &w = window[i];
+    uint64_t spent[LoadMeter_t::dsf_NumCategories] = {0, 0, 0, 0};
+    uint64_t length = windowEnd[i] - windowStart[i];
+    int expected[LoadMeter_t::dsf_NumCategories];
+
+    for (uint32_t k = 0; k < intervalCount; k++) {
+      uint64_t from = intervals[k].from > windowStart[i] ?
+                      intervals[k].from : windowStart[i];
+      uint64_t to = intervals[k].to < windowEnd[i] ?
+                    intervals[k].to : windowEnd[i];
+
+      if (to > from) {
+        spent[intervals[k].activity] += to - from;
+      }
+    }
+    for (uint8_t c = 0; c < LoadMeter_t::dsf_NumCategories; c++) {
+      expected[c] = (int)(spent[c]*(1 - irq)*100/length + 0.5);
+    }
+    expected[LoadMeter_t::dsf_Interrupt] = (int)(irq*100 + 0.5);
+    printf("%-6u %5u %5u %5u %5u %5u   %5d %5d %5d %5d\n", kChecks[i],
+           w.share[LoadMeter_t::dsf_Application],
+           w.share[LoadMeter_t::dsf_Delay], w.share[LoadMeter_t::dsf_Sleep],
+           w.share[LoadMeter_t::dsf_Interrupt], w.utilization,
+           expected[LoadMeter_t::dsf_Application],
+           expected[LoadMeter_t::dsf_Delay],
+           expected[LoadMeter_t::dsf_Sleep],
+           expected[LoadMeter_t::dsf_Application]
+           + expected[LoadMeter_t::dsf_Interrupt]);
+    for (uint8_t c = 0; c < LoadMeter_t::dsf_NumCategories; c++) {
+      ok = ok && near(w.share[c], expected[c]);
+    }
+    ok = ok && near(w.utilization, expected[LoadMeter_t::dsf_Application]
+                    + expected[LoadMeter_t::dsf_Interrupt]);
+  }
+
+  /*!
+   * Depois de 8 fatias só de aplicação, as fatias antigas saíram da janela.
+   */
+  ok = ok && window[kCheckCount - 1].ticks[LoadMeter_t::dsf_Delay] == 0
+       && window[kCheckCount - 1].ticks[LoadMeter_t::dsf_Sleep] == 0
+       && window[kCheckCount - 1].utilization >= 99;
+
+  printf("vlps sleeps=%u cycles=%llu clock_ticks=%llu sleep_ticks=%llu\n",
+         stopPhase.sleeps, (unsigned long long)stopPhase.cycles,
+         (unsigned long long)stopPhase.clockTicks,
+         (unsigned long long)stopPhase.sleepTicks);
+  slack = stopPhase.sleeps*dsf_Sim::microseconds(1000);
+  ok = ok && stopPhase.clockTicks + slack >= stopPhase.cycles
+       && stopPhase.clockTicks <= stopPhase.cycles + slack
+       && stopPhase.sleepTicks*10 >= stopPhase.cycles*9;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
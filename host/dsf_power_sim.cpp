@@ -0,0 +1,341 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Sono em VLPS e LLS do firmware no simulador do host.
+ *
+ * @file        dsf_power_sim.cpp
+ * @version     1.0
+ * @date        6 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. -Dmain=firmware_main -DDSF_LOW_POWER
+ *                            -c ../main.cpp
+ *                            g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_power_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_Power_ocp.cpp ../dsf_Delay_ocp.cpp
+ *                            ../dsf_SysClock_ocp.cpp ../dsf_GPIO_ocp.cpp
+ *                            ../dsf_TPM_ocp.cpp ../dsf_ClockGate_ocp.cpp
+ *                            ../dsf_Irq_ocp.cpp ../dsf_MCG_ocp.cpp main.o
+ *                            -o dsf_power_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (6 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_power_sim [-q]
+ *
+ *              Fase LLS: dez temporizações de 400 ms do TPM2 com o núcleo
+ *              em LLS e toques em PTD4 (LLWU_P14, borda de descida). Cada
+ *              toque deve acordar o núcleo pelo pino, cada temporização deve
+ *              durar 400 ms +/- 2 ms apesar dos sonos interrompidos e o
+ *              tempo em LLS medido pelo dsf_Power_ocp deve ficar a 1 ms por
+ *              sono do tempo exato do simulador.
+ *
+ *              Fase VLPS: o main.cpp da placa (build -DDSF_LOW_POWER) pisca
+ *              o led por 4 s sem toques e depois recebe toques na tecla
+ *              (PTA1). O intervalo entre piscadas deve ficar a 2 ms de
+ *              400 ms, a latência tecla-led (o led apagado acende no toque)
+ *              abaixo de 50 us e o tempo em VLPS deve conferir com o
+ *              simulador. As linhas de resumo trazem a energia estimada
+ *              pelo dsf_Sim em cada fase e por toque. Com -q só as linhas
+ *              de resumo são escritas. O código de saída é 0 se todas as
+ *              verificações passaram.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Power_ocp.h"
+#include "dsf_Delay_ocp.h"
+#include "dsf_GPIO_ocp.h"
+#include "dsf_Irq_ocp.h"
+
+/*!
+ * Ponto de entrada e objetos do firmware (main.cpp compilado com
+ * -Dmain=... -DDSF_LOW_POWER).
+ */
+int firmware_main();
+extern dsf_Power_ocp power;
+extern dsf_Delay_ocp tpm;
+
+DSF_IRQ_BIND(LLW, power)
+
+namespace {
+
+const uint64_t kQuietUs = 4000000;
+const uint64_t kPhaseUs = 10200000;
+const uint32_t kPresses = 8;
+const uint32_t kRounds = 10;
+const uint64_t kBlinkUs = 400000;
+const uint64_t kToleranceUs = 2000;
+const uint64_t kWakeLimitUs = 50;
+
+/*!
+ * Observações nos pinos: piscadas sem toques e latência tecla-led.
+ */
+struct Bench {
+  uint64_t lastEdge;
+  uint32_t blinks;
+  uint64_t worstBlink;
+  uint64_t pressedAt;
+  bool armed;
+  uint32_t count;
+  uint64_t sum;
+  uint64_t max;
+};
+
+Bench bench = {0, 0, 0, 0, false, 0, 0, 0};
+
+/*!
+ * Fase LLS: instante do último toque em PTD4 e despertares pelo pino.
+ */
+struct Deep {
+  uint64_t pressedAt;
+  uint32_t presses;
+  uint32_t pinWakes;
+  uint64_t sum;
+  uint64_t max;
+  uint64_t worstRound;
+};
+
+Deep deep = {0, 0, 0, 0, 0, 0};
+
+dsf_PowerStats vlpsStats, llsStats;
+uint64_t quietEnd, vlpsAtEdge;
+
+uint64_t cyclesToMicros(uint64_t cycles) {
+  return cycles*1000000/dsf_Sim::coreFrequency();
+}
+
+uint64_t distance(uint64_t a, uint64_t b) {
+  return a > b ? a - b : b - a;
+}
+
+void onLed(void *, uint8_t, uint8_t, int level) {
+  uint64_t now = dsf_Sim::now();
+
+  /*!
+   * Sem toques, cada borda do led marca uma temporização de 400 ms.
+   */
+  if (now < quietEnd) {
+    if (bench.lastEdge) {
+      uint64_t error = distance(cyclesToMicros(now - bench.lastEdge),
+                                kBlinkUs);
+      bench.worstBlink = error > bench.worstBlink ? error : bench.worstBlink;
+      bench.blinks++;
+    }
+    bench.lastEdge = now;
+  }
+  if (bench.armed && level) {
+    uint64_t cycles = now - bench.pressedAt;
+    bench.armed = false;
+    bench.count++;
+    bench.sum += cycles;
+    bench.max = cycles > bench.max ? cycles : bench.max;
+  }
+  vlpsAtEdge = dsf_Sim::modeCycles(Sim_t::dsf_VLPS);
+}
+
+void press(void *) {
+  bench.armed = dsf_Sim::pinLevel(1, 18) == 0;
+  bench.pressedAt = dsf_Sim::now();
+  dsf_Sim::drive(0, 1, Sim_t::dsf_Low);
+}
+
+void release(void *) {
+  bench.armed = false;
+  dsf_Sim::drive(0, 1, Sim_t::dsf_Released);
+}
+
+void pressDeep(void *) {
+  deep.pressedAt = dsf_Sim::now();
+  deep.presses++;
+  dsf_Sim::drive(3, 4, Sim_t::dsf_Low);
+}
+
+void releaseDeep(void *) {
+  dsf_Sim::drive(3, 4, Sim_t::dsf_Released);
+}
+
+void vlpsEntry() {
+  firmware_main();
+}
+
+/*!
+ * Fase LLS com os objetos do firmware, antes do main.cpp, que não retorna.
+ */
+void llsEntry() {
+  dsf_GPIO_ocp wakeKey(GPIO_t::dsf_GPIOD, GPIO_t::dsf_PTD4);
+
+  wakeKey.setPortMode(PortMode_t::Input);
+  wakeKey.setPullResistor(PullResistor_t::PullUpResistor);
+  tpm.setFrequency(TPMDiv_t::Div128);
+  power.track(&tpm);
+  power.start(Power_t::dsf_LLS, Power_t::dsf_P14_PTD4,
+              Power_t::dsf_EdgeFalling);
+  for (uint32_t round = 0; round < kRounds; round++) {
+    uint64_t start = dsf_Sim::now();
+    tpm.startDelay(0xFFFF);
+    while (!tpm.timeoutDelay()) {
+      if (power.sleep() == Power_t::dsf_WakePin) {
+        uint64_t cycles = dsf_Sim::now() - deep.pressedAt;
+        deep.pinWakes++;
+        deep.sum += cycles;
+        deep.max = cycles > deep.max ? cycles : deep.max;
+      }
+    }
+    tpm.cancelDelay();
+    uint64_t error = distance(cyclesToMicros(dsf_Sim::now() - start),
+                              kBlinkUs);
+    deep.worstRound = error > deep.worstRound ? error : deep.worstRound;
+  }
+  power.getStats(&llsStats);
+  power.stop();
+}
+
+void putChar(char c) {
+  putchar(c);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool quiet = false;
+  bool ok = true;
+  uint64_t at, start, vlpsMs, llsMs;
+  double llsUj, vlpsUj;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-q")) {
+      quiet = true;
+    } else {
+      fprintf(stderr, "usage: %s [-q]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  /*!
+   * Fase LLS: toques de 50 ms em PTD4 a cada 370 ms.
+   */
+  at = dsf_Sim::microseconds(130000);
+  for (uint32_t i = 0; i < kRounds; i++) {
+    dsf_Sim::schedule(at, pressDeep, 0);
+    dsf_Sim::schedule(at + dsf_Sim::microseconds(50000), releaseDeep, 0);
+    at += dsf_Sim::microseconds(370000);
+  }
+  if (dsf_Sim::run(llsEntry, dsf_Sim::microseconds(2*kRounds*kBlinkUs))) {
+    fprintf(stderr, "LLS phase did not finish\n");
+    return 1;
+  }
+  llsMs = cyclesToMicros(dsf_Sim::modeCycles(Sim_t::dsf_LLS))/1000;
+  llsUj = dsf_Sim::microjoules();
+  if (!quiet) {
+    power.dump(putChar);
+  }
+
+  /*!
+   * Fase VLPS: toques de 150 ms a cada 730 ms depois do período quieto.
+   * A simulação termina no meio de um sono, que o dsf_Power_ocp ainda não
+   * contou: o tempo em VLPS do simulador é o da última borda do led.
+   */
+  start = dsf_Sim::now();
+  quietEnd = start + dsf_Sim::microseconds(kQuietUs);
+  dsf_Sim::watch(1, 18, onLed, 0);
+  at = quietEnd + dsf_Sim::microseconds(100000);
+  for (uint32_t i = 0; i < kPresses; i++) {
+    dsf_Sim::schedule(at, press, 0);
+    dsf_Sim::schedule(at + dsf_Sim::microseconds(150000), release, 0);
+    at += dsf_Sim::microseconds(730000);
+  }
+  dsf_Sim::run(vlpsEntry, start + dsf_Sim::microseconds(kPhaseUs));
+  power.getStats(&vlpsStats);
+  vlpsMs = cyclesToMicros(vlpsAtEdge)/1000;
+  vlpsUj = dsf_Sim::microjoules() - llsUj;
+  if (!quiet) {
+    power.dump(putChar);
+  }
+
+  printf("lls rounds=%u round_err_us=%llu presses=%u pin_wakes=%u"
+         " wake_us=%llu/%llu fw_ms=%u sim_ms=%llu sleeps=%u uj=%.1f"
+         " uj_per_press=%.1f\n",
+         kRounds, (unsigned long long)deep.worstRound, deep.presses,
+         deep.pinWakes,
+         (unsigned long long)cyclesToMicros(deep.pinWakes
+                                            ? deep.sum/deep.pinWakes : 0),
+         (unsigned long long)cyclesToMicros(deep.max),
+         llsStats.ms[Power_t::dsf_LLS], (unsigned long long)llsMs,
+         llsStats.sleeps[Power_t::dsf_LLS], llsUj,
+         deep.presses ? llsUj/deep.presses : 0.0);
+  printf("vlps blinks=%u blink_err_us=%llu presses=%u wake_us=%llu/%llu"
+         " fw_ms=%u sim_ms=%llu sleeps=%u uj=%.1f uj_per_press=%.1f\n",
+         bench.blinks, (unsigned long long)bench.worstBlink, bench.count,
+         (unsigned long long)cyclesToMicros(bench.count
+                                            ? bench.sum/bench.count : 0),
+         (unsigned long long)cyclesToMicros(bench.max),
+         vlpsStats.ms[Power_t::dsf_VLPS], (unsigned long long)vlpsMs,
+         vlpsStats.sleeps[Power_t::dsf_VLPS], vlpsUj,
+         bench.count ? vlpsUj/bench.count : 0.0);
+
+  /*!
+   * O dsf_Power_ocp mede o sono em ticks de 1 ms do LPO: até 1 ms de erro
+   * por sono.
+   */
+  if (deep.pinWakes != deep.presses
+      || deep.pinWakes != llsStats.wakes[Power_t::dsf_WakePin]
+      || cyclesToMicros(deep.max) > kWakeLimitUs) {
+    fprintf(stderr, "LLS pin wakeups do not match the presses\n");
+    ok = false;
+  }
+  if (deep.worstRound > kToleranceUs) {
+    fprintf(stderr, "LLS delay off by %llu us\n",
+            (unsigned long long)deep.worstRound);
+    ok = false;
+  }
+  if (distance(llsStats.ms[Power_t::dsf_LLS], llsMs)
+      > llsStats.sleeps[Power_t::dsf_LLS] + 1) {
+    fprintf(stderr, "LLS residency differs from the simulator\n");
+    ok = false;
+  }
+  if (bench.blinks < 5 || bench.worstBlink > kToleranceUs) {
+    fprintf(stderr, "VLPS blink interval off by %llu us\n",
+            (unsigned long long)bench.worstBlink);
+    ok = false;
+  }
+  if (bench.count < 2 || cyclesToMicros(bench.max) > kWakeLimitUs) {
+    fprintf(stderr, "VLPS key-to-LED latency not measured or too long\n");
+    ok = false;
+  }
+  if (distance(vlpsStats.ms[Power_t::dsf_VLPS], vlpsMs)
+      > vlpsStats.sleeps[Power_t::dsf_VLPS] + 1) {
+    fprintf(stderr, "VLPS residency differs from the simulator\n");
+    ok = false;
+  }
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Perfilador dsf_Profiler_ocp no simulador do host.
+ *
+ * @file        dsf_profile_sim.cpp
+ * @version     1.0
+ * @date        3 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -no-pie
+ *                            -Wno-int-to-pointer-cast -Isim -I..
+ *                            dsf_profile_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_Profiler_ocp.cpp ../dsf_MCG_ocp.cpp
+ *                            -o dsf_profile_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (3 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_profile_sim [-r amostras/s] [-t segundos] > perfil.txt
+ *              dsf_profsym dsf_profile_sim perfil.txt
+ *
+ *              O firmware de teste alterna spinHot, com 9 escritas em
+ *              registrador por chamada, e spinCold, com 1, de modo que
+ *              spinHot ocupa 90 % do tempo simulado. O histograma cobre
+ *              2 KB a partir de spinHot, em faixas de 4 bytes (-no-pie
+ *              mantém os endereços abaixo de 4 GB), e é escrito na saída
+ *              padrão, no formato do dump, para o dsf_profsym. O código de
+ *              saída é 0 se o número de amostras corresponde à taxa e à
+ *              duração, se nenhuma amostra caiu fora da faixa e se as
+ *              faixas das duas funções recebem todas as amostras na
+ *              proporção esperada.
+ *
+ *              O overhead_ppm é um valor de modelo: as duas leituras do
+ *              SysTick custam 100 ciclos cada no simulador, e não os
+ *              tempos do Cortex-M0+; o custo real está no
+ *              dsf_Profiler_ocp.h.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Profiler_ocp.h"
+
+namespace {
+
+uint32_t rate = Profiler_t::dsf_DefaultHz;
+
+/*!
+ * GPIOB_PTOR: cada escrita custa um acesso a registrador no simulador. O
+ * alinhamento separa as duas funções como no firmware, que não as mistura
+ * na mesma faixa.
+ */
+__attribute__((noinline, aligned(64))) void spinHot() {
+  for (int i = 0; i < 9; i++) {
+    DSF_SIM_REG32(0x400FF04Cu) = 1u << 18;
+  }
+}
+
+__attribute__((noinline, aligned(64))) void spinCold() {
+  DSF_SIM_REG32(0x400FF04Cu) = 1u << 19;
+}
+
+void entry() {
+  dsf_Profiler_ocp::setRange((uint32_t)(uintptr_t)spinHot, 2048);
+  dsf_Profiler_ocp::start(rate);
+  while (true) {
+    spinHot();
+    spinCold();
+  }
+}
+
+/*!
+ * Amostras dos 64 bytes a partir de fn, somadas das faixas do dump.
+ */
+std::string dumped;
+
+void putChar(char c) {
+  putchar(c);
+  dumped += c;
+}
+
+uint32_t samplesIn(void (*fn)()) {
+  unsigned long base = 0, shift = 0, index, count;
+  uint32_t total = 0;
+  const char *line = dumped.c_str();
+
+  sscanf(line, "profile hz=%*u base=%lu shift=%lu", &base, &shift);
+  while ((line = strchr(line, '\n')) != 0) {
+    line++;
+    if (sscanf(line, "bucket=%lu count=%lu", &index, &count) == 2
+        && base + (index << shift) - (uintptr_t)fn < 64) {
+      total += (uint32_t)count;
+    }
+  }
+  return total;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  double seconds = 2;
+  uint32_t expected, hot, cold;
+  bool ok;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+      rate = (uint32_t)strtoul(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [-r hz] [-t seconds]\n", argv[0]);
+      return 2;
+    }
+  }
+  /*!
+   * Acessos de 100 ciclos: a simulação fica 12 vezes mais rápida e o laço
+   * de 1000 ciclos não entra em fase com o período do SysTick, o que
+   * poria todas as amostras na mesma instrução.
+   */
+  dsf_Sim::setAccessCycles(100);
+  dsf_Sim::run(entry, (uint64_t)(seconds*dsf_Sim::coreFrequency()));
+  dsf_Profiler_ocp::dump(putChar);
+
+  /*!
+   * spinCold deve receber cerca de 1 em cada 10 amostras.
+   */
+  expected = (uint32_t)(seconds*rate);
+  hot = samplesIn(spinHot);
+  cold = samplesIn(spinCold);
+  ok = dsf_Profiler_ocp::samples() + 1 >= expected
+       && dsf_Profiler_ocp::samples() <= expected + 1
+       && dsf_Profiler_ocp::outside() == 0
+       && hot + cold == dsf_Profiler_ocp::samples()
+       && cold*20 >= hot && cold*5 <= hot;
+  fprintf(stderr, "samples=%lu expected=%lu hot=%lu cold=%lu "
+          "model_overhead_ppm=%lu %s\n",
+          (unsigned long)dsf_Profiler_ocp::samples(), (unsigned long)expected,
+          (unsigned long)hot, (unsigned long)cold,
+          (unsigned long)dsf_Profiler_ocp::overheadPpm(), ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,313 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Atribuição do dump do dsf_Profiler_ocp às funções do ELF.
+ *
+ * @file        dsf_profsym.cpp
+ * @version     1.0
+ * @date        3 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O2 dsf_profsym.cpp
+ *                            -o dsf_profsym
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (3 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_profsym firmware.elf [perfil.txt]
+ *
+ *              Lê o dump do dsf_Profiler_ocp (do arquivo ou da entrada
+ *              padrão, como capturado da serial) e as funções da tabela de
+ *              símbolos do ELF, de 32 bits (firmware ARM, com o bit Thumb
+ *              removido dos endereços) ou de 64 bits (simulador do host).
+ *              As amostras de cada faixa são repartidas entre as funções
+ *              que a cobrem, na proporção dos bytes em comum; faixas sem
+ *              função vão para [unknown] e as amostras fora da faixa para
+ *              [outside]. A tabela sai em ordem decrescente de amostras.
+ *              O código de saída é 0 se o total atribuído é igual ao total
+ *              do dump.
+ *
+ *              Com faixas largas (shift grande), funções pequenas vizinhas
+ *              dividem as mesmas amostras; setRange estreita a faixa.
+ */
+
+#include <elf.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+/*!
+ * Função da tabela de símbolos: [start, end).
+ */
+struct Function {
+  uint64_t start;
+  uint64_t end;
+  std::string name;
+};
+
+/*!
+ * Cabeçalho e faixas não vazias do dump.
+ */
+struct Profile {
+  uint64_t base;
+  uint32_t shift;
+  uint64_t samples;
+  uint64_t outside;
+  std::vector<std::pair<uint32_t, uint64_t> > buckets;
+};
+
+bool readFile(const char *path, std::vector<uint8_t> *data) {
+  FILE *file = fopen(path, "rb");
+  uint8_t block[4096];
+  size_t n;
+
+  if (!file) {
+    return false;
+  }
+  while ((n = fread(block, 1, sizeof(block), file)) > 0) {
+    data->insert(data->end(), block, block + n);
+  }
+  fclose(file);
+  return true;
+}
+
+std::string demangle(const char *name) {
+  int status = 0;
+  char *text = abi::__cxa_demangle(name, 0, 0, &status);
+  std::string result = status == 0 && text ? text : name;
+
+  free(text);
+  return result;
+}
+
+/*!
+ * Símbolos STT_FUNC de tamanho não nulo das seções SHT_SYMTAB, nos
+ * formatos Elf32 e Elf64. Ehdr, Shdr e Sym são os tipos da classe.
+ */
+template <typename Ehdr, typename Shdr, typename Sym>
+bool loadFunctions(const std::vector<uint8_t> &elf,
+                   std::vector<Function> *functions) {
+  const Ehdr *header = (const Ehdr *)&elf[0];
+  uint64_t thumb = header->e_machine == EM_ARM ? ~1ull : ~0ull;
+
+  if (elf.size() < sizeof(Ehdr) || header->e_shentsize != sizeof(Shdr)
+      || header->e_shoff + (uint64_t)header->e_shnum*sizeof(Shdr)
+         > elf.size()) {
+    return false;
+  }
+  const Shdr *sections = (const Shdr *)&elf[header->e_shoff];
+  for (uint32_t s = 0; s < header->e_shnum; s++) {
+    const Shdr &table = sections[s];
+    if (table.sh_type != SHT_SYMTAB || table.sh_link >= header->e_shnum) {
+      continue;
+    }
+    const Shdr &strings = sections[table.sh_link];
+    if (table.sh_offset + table.sh_size > elf.size()
+        || strings.sh_offset + strings.sh_size > elf.size()) {
+      return false;
+    }
+    const Sym *symbols = (const Sym *)&elf[table.sh_offset];
+    for (uint64_t i = 0; i < table.sh_size/sizeof(Sym); i++) {
+      const Sym &symbol = symbols[i];
+      if ((symbol.st_info & 0xF) != STT_FUNC || symbol.st_size == 0
+          || symbol.st_name >= strings.sh_size) {
+        continue;
+      }
+      Function function;
+      function.start = symbol.st_value & thumb;
+      function.end = function.start + symbol.st_size;
+      function.name = demangle((const char *)&elf[strings.sh_offset
+                                                  + symbol.st_name]);
+      functions->push_back(function);
+    }
+  }
+  return true;
+}
+
+/*!
+ * Ordena por endereço e descarta apelidos (o mesmo endereço inicial).
+ */
+bool loadElf(const char *path, std::vector<Function> *functions) {
+  std::vector<uint8_t> elf;
+  bool ok;
+
+  if (!readFile(path, &elf) || elf.size() < EI_NIDENT
+      || memcmp(&elf[0], ELFMAG, SELFMAG) != 0) {
+    return false;
+  }
+  if (elf[EI_CLASS] == ELFCLASS32) {
+    ok = loadFunctions<Elf32_Ehdr, Elf32_Shdr, Elf32_Sym>(elf, functions);
+  } else if (elf[EI_CLASS] == ELFCLASS64) {
+    ok = loadFunctions<Elf64_Ehdr, Elf64_Shdr, Elf64_Sym>(elf, functions);
+  } else {
+    return false;
+  }
+  std::sort(functions->begin(), functions->end(),
+            [](const Function &a, const Function &b) {
+              return a.start < b.start;
+            });
+  functions->erase(std::unique(functions->begin(), functions->end(),
+                               [](const Function &a, const Function &b) {
+                                 return a.start == b.start;
+                               }),
+                   functions->end());
+  return ok;
+}
+
+bool loadProfile(FILE *file, Profile *profile) {
+  char line[256];
+  unsigned long long base, samples, outside, count;
+  unsigned shift, index;
+  bool header = false;
+
+  while (fgets(line, sizeof(line), file)) {
+    const char *text = strstr(line, "profile hz=");
+    if (text && sscanf(text, "profile hz=%*u base=%llu shift=%u samples=%llu"
+                       " outside=%llu", &base, &shift, &samples,
+                       &outside) == 4) {
+      profile->base = base;
+      profile->shift = shift;
+      profile->samples = samples;
+      profile->outside = outside;
+      profile->buckets.clear();
+      header = true;
+    } else if (header && sscanf(line, "bucket=%u count=%llu", &index,
+                                &count) == 2) {
+      profile->buckets.push_back(std::make_pair(index, (uint64_t)count));
+    }
+  }
+  return header && profile->shift < 32;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::vector<Function> functions;
+  Profile profile;
+  FILE *input = stdin;
+  std::vector<double> share;
+  double unknown = 0, attributed, total = 0;
+
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "usage: %s firmware.elf [dump.txt]\n", argv[0]);
+    return 2;
+  }
+  if (!loadElf(argv[1], &functions)) {
+    fprintf(stderr, "%s: not a readable ELF with a symbol table\n", argv[1]);
+    return 1;
+  }
+  if (argc == 3 && !(input = fopen(argv[2], "r"))) {
+    perror(argv[2]);
+    return 1;
+  }
+  if (!loadProfile(input, &profile)) {
+    fprintf(stderr, "no profiler dump found\n");
+    return 1;
+  }
+
+  /*!
+   * Cada faixa [start, end) é repartida entre as funções que a cobrem, na
+   * proporção dos bytes cobertos: o preenchimento entre funções nunca é
+   * executado e não recebe amostras.
+   */
+  share.assign(functions.size(), 0);
+  for (size_t b = 0; b < profile.buckets.size(); b++) {
+    uint64_t width = 1ull << profile.shift;
+    uint64_t start = profile.base + ((uint64_t)profile.buckets[b].first
+                                     << profile.shift);
+    uint64_t end = start + width;
+    double count = (double)profile.buckets[b].second;
+    uint64_t covered = 0;
+    size_t first, f = std::upper_bound(functions.begin(), functions.end(), start,
+                                [](uint64_t address, const Function &fn) {
+                                  return address < fn.start;
+                                }) - functions.begin();
+
+    first = f = f ? f - 1 : 0;
+    for (; f < functions.size() && functions[f].start < end; f++) {
+      uint64_t low = std::max(start, functions[f].start);
+      uint64_t high = std::min(end, functions[f].end);
+      if (high > low) {
+        covered += high - low;
+      }
+    }
+    for (f = first; covered && f < functions.size()
+                    && functions[f].start < end; f++) {
+      uint64_t low = std::max(start, functions[f].start);
+      uint64_t high = std::min(end, functions[f].end);
+      if (high > low) {
+        share[f] += count*(high - low)/covered;
+      }
+    }
+    if (!covered) {
+      unknown += count;
+    }
+    total += count;
+  }
+
+  std::vector<std::pair<double, std::string> > rows;
+  attributed = unknown + profile.outside;
+  for (size_t f = 0; f < functions.size(); f++) {
+    if (share[f] > 0) {
+      rows.push_back(std::make_pair(share[f], functions[f].name));
+      attributed += share[f];
+    }
+  }
+  if (unknown > 0) {
+    rows.push_back(std::make_pair(unknown, std::string("[unknown]")));
+  }
+  if (profile.outside) {
+    rows.push_back(std::make_pair((double)profile.outside,
+                                  std::string("[outside]")));
+  }
+  std::sort(rows.begin(), rows.end(),
+            [](const std::pair<double, std::string> &a,
+               const std::pair<double, std::string> &b) {
+              return a.first > b.first;
+            });
+  total += profile.outside;
+
+  printf("%8s %10s  %s\n", "percent", "samples", "function");
+  for (size_t i = 0; i < rows.size(); i++) {
+    printf("%7.2f%% %10.1f  %s\n", 100*rows[i].first/total, rows[i].first,
+           rows[i].second.c_str());
+  }
+  if (total - attributed > 1e-6*total || attributed - total > 1e-6*total
+      || (uint64_t)total != profile.samples) {
+    fprintf(stderr, "attributed %.1f of %.0f samples, dump header says %llu\n",
+            attributed, total, (unsigned long long)profile.samples);
+    return 1;
+  }
+  return 0;
+}
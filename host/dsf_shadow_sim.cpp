@@ -0,0 +1,251 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Acessos das chamadas de configuração com as cópias de
+ *              sombra dos registradores no simulador do host.
+ *
+ * @file        dsf_shadow_sim.cpp
+ * @version     1.0
+ * @date        9 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. [-DDSF_SHADOW_CHECK]
+ *                            dsf_shadow_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_Delay_ocp.cpp ../dsf_SysClock_ocp.cpp
+ *                            ../dsf_Keypad_ocp.cpp ../dsf_GPIO_ocp.cpp
+ *                            ../dsf_TPM_ocp.cpp ../dsf_ClockGate_ocp.cpp
+ *                            ../dsf_Irq_ocp.cpp ../dsf_MCG_ocp.cpp
+ *                            -o dsf_shadow_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (9 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_shadow_sim
+ *
+ *              Cada chamada de configuração é executada depois de uma
+ *              chamada igual, como num laço que reinicia um periférico, e os
+ *              acessos ao barramento são comparados com os da versão sem as
+ *              cópias de sombra (before, medidos com esta mesma ferramenta
+ *              compilada com os drivers anteriores). As portas de clock dos
+ *              TPMs ficam adquiridas, de modo que só os acessos aos
+ *              registradores de configuração são contados. O código de
+ *              saída é 0 se nenhuma chamada ficou mais cara e o total caiu
+ *              a 60% ou menos. As escritas de parada e de início que
+ *              restam (CNT e SC) não podem ser omitidas, e a troca do
+ *              pull e do IRQC continua com uma escrita cada.
+ *
+ *              Com -DDSF_SHADOW_CHECK, as leituras de verificação entram na
+ *              contagem e a comparação não é feita. Em seu lugar, o MOD do
+ *              TPM1 e o PCR de PTA1 são alterados por fora dos drivers: a
+ *              divergência deve ser contada, a temporização seguinte deve
+ *              ter a duração pedida e o campo alterado por fora deve ser
+ *              preservado.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_ClockGate_ocp.h"
+#include "dsf_Delay_ocp.h"
+#include "dsf_GPIO_ocp.h"
+#include "dsf_Keypad_ocp.h"
+#include "dsf_SysClock_ocp.h"
+
+namespace {
+
+volatile uint32_t *const kPCR1 = (volatile uint32_t *)0x40049004u;
+volatile uint32_t *const kTPM1MOD = (volatile uint32_t *)0x40039008u;
+
+const uint16_t kDelayTicks = 1000;
+const uint16_t kScanTicks = 1311;
+
+const GPIO_t::dsf_Pin kRows[] = {GPIO_t::dsf_PTC0, GPIO_t::dsf_PTC1};
+const GPIO_t::dsf_Pin kColumns[] = {GPIO_t::dsf_PTC2, GPIO_t::dsf_PTC3};
+
+}  // namespace
+
+dsf_Delay_ocp delay(TPM_t::dsf_TPM1);
+dsf_SysClock_ocp sysClock(TPM_t::dsf_TPM0);
+dsf_Keypad_ocp keypad(GPIO_t::dsf_GPIOC, kRows, 2, GPIO_t::dsf_GPIOC,
+                      kColumns, 2, TPM_t::dsf_TPM2);
+dsf_GPIO_ocp key(GPIO_t::dsf_GPIOA, GPIO_t::dsf_PTA1);
+
+namespace {
+
+/*!
+ * Uma chamada de configuração: estado inicial, chamada medida e acessos
+ * da versão anterior dos drivers.
+ */
+struct Operation {
+  const char *name;
+  void (*prepare)();
+  void (*run)();
+  void (*finish)();
+  uint64_t before;
+};
+
+void delayRestart() {
+  delay.startDelay(kDelayTicks);
+  delay.cancelDelay();
+}
+void delayPeriod() {
+  delay.startDelay(2*kDelayTicks);
+  delay.cancelDelay();
+}
+void clockStart() {
+  sysClock.start();
+}
+void clockRestart() {
+  sysClock.stop();
+  sysClock.start();
+}
+void clockStop() {
+  sysClock.stop();
+}
+void scanStart() {
+  keypad.start(kScanTicks);
+}
+void scanRestart() {
+  keypad.stop();
+  keypad.start(kScanTicks);
+}
+void scanStop() {
+  keypad.stop();
+}
+void pinSetup() {
+  key.setPullResistor(PullResistor_t::PullUpResistor);
+  key.setInterrupt(PortIrq_t::dsf_IrqDisabled);
+}
+void nothing() {
+}
+
+const Operation kOperations[] = {
+  {"delay restart", delayRestart, delayRestart, nothing, 7},
+  {"delay new period", delayRestart, delayPeriod, nothing, 7},
+  {"sysclock restart", clockStart, clockRestart, clockStop, 7},
+  {"keypad restart", scanStart, scanRestart, scanStop, 6},
+  {"pull+interrupt", pinSetup, pinSetup, nothing, 2}
+};
+const uint32_t kOperationCount = sizeof(kOperations)/sizeof(kOperations[0]);
+
+uint64_t after[kOperationCount];
+
+#ifdef DSF_SHADOW_CHECK
+/*!
+ * Resultado das alterações feitas por fora dos drivers.
+ */
+struct Tamper {
+  uint32_t TPMMismatches;
+  uint32_t GPIOMismatches;
+  uint64_t delayCycles;
+  uint32_t pcr;
+};
+
+Tamper tamper;
+
+void tamperTest() {
+  uint64_t start;
+
+  delayRestart();
+  *kTPM1MOD = 4*kDelayTicks;
+  start = dsf_Sim::now();
+  delay.waitDelay(kDelayTicks);
+  tamper.delayCycles = dsf_Sim::now() - start;
+  tamper.TPMMismatches = dsf_TPMPeripheral_ocp::shadowMismatches();
+
+  *kPCR1 = PORT_PCR_MUX(1) | PORT_PCR_IRQC(PortIrq_t::dsf_IrqFalling);
+  key.setPullResistor(PullResistor_t::PullNoneResistor);
+  tamper.GPIOMismatches = dsf_GPIO_ocp::shadowMismatches();
+  tamper.pcr = *kPCR1;
+}
+#endif
+
+void entry() {
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_TPM0);
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_TPM1);
+  dsf_ClockGate_ocp::acquire(ClockGate_t::dsf_TPM2);
+  delay.setFrequency(TPMDiv_t::Div128);
+  keypad.setFrequency(TPMDiv_t::Div16);
+  for (uint32_t i = 0; i < kOperationCount; i++) {
+    const Operation &op = kOperations[i];
+    uint64_t accesses;
+
+    op.prepare();
+    accesses = dsf_Sim::accessCount();
+    op.run();
+    after[i] = dsf_Sim::accessCount() - accesses;
+    op.finish();
+  }
+#ifdef DSF_SHADOW_CHECK
+  tamperTest();
+#endif
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+  uint64_t before = 0, total = 0;
+
+  dsf_Sim::run(entry, dsf_Sim::microseconds(1000000));
+
+  printf("%-18s %8s %8s\n", "operation", "before", "after");
+  for (uint32_t i = 0; i < kOperationCount; i++) {
+    printf("%-18s %8llu %8llu\n", kOperations[i].name,
+           (unsigned long long)kOperations[i].before,
+           (unsigned long long)after[i]);
+    before += kOperations[i].before;
+    total += after[i];
+#ifndef DSF_SHADOW_CHECK
+    ok = ok && after[i] <= kOperations[i].before;
+#endif
+  }
+  printf("total before=%llu after=%llu\n", (unsigned long long)before,
+         (unsigned long long)total);
+#ifdef DSF_SHADOW_CHECK
+  {
+    uint64_t expected = (uint64_t)kDelayTicks*128;
+    uint64_t error = tamper.delayCycles > expected ?
+                     tamper.delayCycles - expected :
+                     expected - tamper.delayCycles;
+
+    printf("tamper tpm_mismatches=%u delay_cycles=%llu expected=%llu"
+           " gpio_mismatches=%u pcr=0x%08x\n", tamper.TPMMismatches,
+           (unsigned long long)tamper.delayCycles,
+           (unsigned long long)expected, tamper.GPIOMismatches, tamper.pcr);
+    ok = tamper.TPMMismatches == 1 && error < expected/100
+         && tamper.GPIOMismatches == 1
+         && tamper.pcr == (PORT_PCR_MUX(1)
+                           | PORT_PCR_IRQC(PortIrq_t::dsf_IrqFalling));
+  }
+#else
+  ok = ok && 10*total <= 6*before;
+#endif
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,293 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Verificação e custo do despacho do dsf_StateMachine_ocp.
+ *
+ * @file        dsf_statebench.cpp
+ * @version     1.0
+ * @date        11 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O2 -I.. dsf_statebench.cpp
+ *                            -o dsf_statebench
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (11 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_statebench [-n eventos] [-s semente]
+ *
+ *              O fluxo da máquina de sorteios (Idle, Drawing, ShowWin,
+ *              ShowLoss e Cooldown, com o sorteio do lpm_draw) é escrito
+ *              duas vezes: com o dsf_StateMachine_ocp e com switch
+ *              aninhados, como no laço antigo do main.cpp. As duas versões
+ *              recebem a mesma sequência pseudoaleatória de eventos da
+ *              tecla e do temporizador e devem passar pelos mesmos estados
+ *              e contar os mesmos sorteios, vitórias e piscadas. O resultado
+ *              é o tamanho da tabela e o custo por evento de cada versão no
+ *              host. O switch tem as ações expandidas no próprio código e
+ *              custa menos neste fluxo pequeno; a tabela tem custo fixo
+ *              (um acesso indexado e uma chamada indireta) qualquer que seja
+ *              o número de estados. Compilada com -fno-pie -no-pie, como na
+ *              placa, a tabela fica em .rodata. O código de saída é 0 se as
+ *              versões concordam.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "dsf_StateMachine_ocp.h"
+#include "lpm_draw.h"
+#include "lpm_random.h"
+
+namespace {
+
+/*!
+ * Estados e eventos do fluxo da máquina de sorteios.
+ */
+namespace Lottery_t {
+  enum dsf_State {
+    dsf_Idle = 0,
+    dsf_Drawing = 1,
+    dsf_ShowWin = 2,
+    dsf_ShowLoss = 3,
+    dsf_Cooldown = 4,
+    dsf_NumStates = 5
+  };
+  enum dsf_Event {
+    dsf_Timeout = 0,
+    dsf_KeyDown = 1,
+    dsf_KeyUp = 2,
+    dsf_Win = 3,
+    dsf_Loss = 4,
+    dsf_NumEvents = 5
+  };
+}  // namespace Lottery_t
+
+const uint32_t kPool = 4096;
+
+/*!
+ * Contadores do fluxo, um conjunto por versão.
+ */
+struct Device {
+  lpm_draw draw;
+  uint32_t draws;
+  uint32_t wins;
+  uint32_t blinks;
+  uint32_t led;
+};
+
+Device *device;
+volatile uint64_t sink;
+
+uint8_t blink() {
+  device->blinks++;
+  device->led = !device->led;
+  return StateMachine_t::dsf_NoEvent;
+}
+
+uint8_t drawOnce() {
+  device->draws++;
+  return lpm_draw::isWin(device->draw.draw()) ? Lottery_t::dsf_Win
+                                              : Lottery_t::dsf_Loss;
+}
+
+uint8_t showWin() {
+  device->wins++;
+  device->led = 1;
+  return StateMachine_t::dsf_NoEvent;
+}
+
+uint8_t ledOff() {
+  device->led = 0;
+  return StateMachine_t::dsf_NoEvent;
+}
+
+typedef dsf_StateMachine_ocp<Lottery_t::dsf_NumStates,
+                             Lottery_t::dsf_NumEvents,
+    dsf_Transition<Lottery_t::dsf_Idle, Lottery_t::dsf_Timeout,
+                   Lottery_t::dsf_Idle, blink>,
+    dsf_Transition<Lottery_t::dsf_Idle, Lottery_t::dsf_KeyDown,
+                   Lottery_t::dsf_Drawing, drawOnce>,
+    dsf_Transition<Lottery_t::dsf_Drawing, Lottery_t::dsf_Win,
+                   Lottery_t::dsf_ShowWin, showWin>,
+    dsf_Transition<Lottery_t::dsf_Drawing, Lottery_t::dsf_Loss,
+                   Lottery_t::dsf_ShowLoss, ledOff>,
+    dsf_Transition<Lottery_t::dsf_ShowWin, Lottery_t::dsf_Timeout,
+                   Lottery_t::dsf_Cooldown, ledOff>,
+    dsf_Transition<Lottery_t::dsf_ShowLoss, Lottery_t::dsf_Timeout,
+                   Lottery_t::dsf_Cooldown>,
+    dsf_Transition<Lottery_t::dsf_Cooldown, Lottery_t::dsf_KeyUp,
+                   Lottery_t::dsf_Idle>
+> LotteryMachine;
+
+/*!
+ * Versão de referência com switch aninhados.
+ */
+uint8_t dispatchSwitch(uint8_t state, uint8_t event) {
+  switch (state) {
+    case Lottery_t::dsf_Idle:
+      if (event == Lottery_t::dsf_Timeout) {
+        blink();
+      } else if (event == Lottery_t::dsf_KeyDown) {
+        if (drawOnce() == Lottery_t::dsf_Win) {
+          showWin();
+          state = Lottery_t::dsf_ShowWin;
+        } else {
+          ledOff();
+          state = Lottery_t::dsf_ShowLoss;
+        }
+      }
+      break;
+    case Lottery_t::dsf_ShowWin:
+      if (event == Lottery_t::dsf_Timeout) {
+        ledOff();
+        state = Lottery_t::dsf_Cooldown;
+      }
+      break;
+    case Lottery_t::dsf_ShowLoss:
+      if (event == Lottery_t::dsf_Timeout) {
+        state = Lottery_t::dsf_Cooldown;
+      }
+      break;
+    case Lottery_t::dsf_Cooldown:
+      if (event == Lottery_t::dsf_KeyUp) {
+        state = Lottery_t::dsf_Idle;
+      }
+      break;
+  }
+  return state;
+}
+
+double elapsedNs(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - begin).count();
+}
+
+/*!
+ * Eventos da tecla e do temporizador: metade fins de espera, um quarto de
+ * cada borda.
+ */
+void makeEvents(uint64_t seed, std::vector<uint8_t> *events) {
+  lpm_random generator(seed);
+
+  for (uint32_t i = 0; i < kPool; i++) {
+    uint32_t r = generator.next() & 3;
+
+    (*events)[i] = r < 2 ? Lottery_t::dsf_Timeout
+                         : r == 2 ? Lottery_t::dsf_KeyDown
+                                  : Lottery_t::dsf_KeyUp;
+  }
+}
+
+double benchTable(const std::vector<uint8_t> &events, uint32_t count,
+                  uint64_t seed, Device *out, uint64_t *trace) {
+  LotteryMachine machine(Lottery_t::dsf_Idle);
+  Device state = {lpm_draw(seed), 0, 0, 0, 0};
+  uint64_t hash = 0;
+
+  device = &state;
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < count; i++) {
+    machine.dispatch(events[i % kPool]);
+    hash = hash*31 + machine.current();
+  }
+  double ns = elapsedNs(begin);
+
+  *out = state;
+  *trace = hash;
+  sink = hash;
+  return ns/count;
+}
+
+double benchSwitch(const std::vector<uint8_t> &events, uint32_t count,
+                   uint64_t seed, Device *out, uint64_t *trace) {
+  uint8_t current = Lottery_t::dsf_Idle;
+  Device state = {lpm_draw(seed), 0, 0, 0, 0};
+  uint64_t hash = 0;
+
+  device = &state;
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < count; i++) {
+    current = dispatchSwitch(current, events[i % kPool]);
+    hash = hash*31 + current;
+  }
+  double ns = elapsedNs(begin);
+
+  *out = state;
+  *trace = hash;
+  sink = hash;
+  return ns/count;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t count = 20000000;
+  uint64_t seed = 1;
+  std::vector<uint8_t> events(kPool);
+  Device table, reference;
+  uint64_t tableTrace, referenceTrace;
+  double tableNs, switchNs;
+  bool ok;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      count = (uint32_t)strtoul(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      seed = strtoull(argv[++i], 0, 0);
+    } else {
+      fprintf(stderr, "usage: %s [-n events] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  makeEvents(seed, &events);
+  tableNs = benchTable(events, count, seed, &table, &tableTrace);
+  switchNs = benchSwitch(events, count, seed, &reference, &referenceTrace);
+
+  printf("table cells=%u bytes=%u\n",
+         (unsigned)(sizeof(LotteryMachine::Table::cells)
+                    /sizeof(dsf_StateCell)),
+         (unsigned)sizeof(LotteryMachine::Table::cells));
+  printf("%-6s %10s %8s %8s %10s\n", "engine", "ns/event", "draws", "wins",
+         "blinks");
+  printf("%-6s %10.2f %8u %8u %10u\n", "table", tableNs, table.draws,
+         table.wins, table.blinks);
+  printf("%-6s %10.2f %8u %8u %10u\n", "switch", switchNs, reference.draws,
+         reference.wins, reference.blinks);
+  ok = tableTrace == referenceTrace && table.draws == reference.draws
+       && table.wins == reference.wins && table.blinks == reference.blinks
+       && table.led == reference.led && table.draws > 0 && table.wins > 0;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Leituras do relógio de 64 bits durante overflows, trechos
+ *              com interrupções desabilitadas e troca do divisor, no
+ *              simulador do host.
+ *
+ * @file        dsf_sysclock_sim.cpp
+ * @version     1.0
+ * @date        16 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_sysclock_sim.cpp
+ *                            sim/dsf_Sim.cpp ../dsf_SysClock_ocp.cpp
+ *                            ../dsf_TPM_ocp.cpp ../dsf_ClockGate_ocp.cpp
+ *                            ../dsf_Irq_ocp.cpp ../dsf_MCG_ocp.cpp
+ *                            -o dsf_sysclock_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (16 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_sysclock_sim [-n leituras]
+ *
+ *              O relógio conta no TPM0 com Div1 e a interrupção de
+ *              overflow ligada por DSF_IRQ_BIND. São feitas 200000 leituras
+ *              de ticks seguidas, por cerca de 90 overflows; a cada 10000, 2500
+ *              leituras são feitas com as interrupções desabilitadas, um
+ *              trecho menor que um período do TPM em que o overflow fica
+ *              pendente e é detectado pela própria leitura. Cada leitura
+ *              deve ser maior ou igual à anterior e ficar entre os ciclos
+ *              simulados antes e depois da chamada.
+ *
+ *              Em seguida o divisor passa a Div4 e volta a Div1 com o
+ *              relógio contando, e mais 200000 leituras de nanoseconds são
+ *              feitas. Cada leitura deve ser maior ou igual à anterior e
+ *              diferir do tempo simulado em no máximo 5 us (os ciclos com o
+ *              TPM parado nas duas trocas, mais um tick), o que só ocorre
+ *              se o PS do TPM acompanha os multiplicadores. O código de
+ *              saída é 0 se todas as leituras passam.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Irq_ocp.h"
+#include "dsf_SysClock_ocp.h"
+
+dsf_SysClock_ocp sysClock(TPM_t::dsf_TPM0);
+
+DSF_IRQ_BIND(TPM0, sysClock)
+
+namespace {
+
+const uint32_t kStretchEvery = 10000;
+const uint32_t kStretchReads = 2500;
+const uint64_t kMaxNanosError = 5000;
+
+/*!
+ * Resultado das leituras, preenchido pelo firmware.
+ */
+struct Result {
+  uint32_t reads;
+  uint32_t backwards;
+  uint32_t outside;
+  uint64_t worstNanos;
+  uint64_t overflows;
+  uint64_t divisorChanges;
+};
+
+uint32_t readCount = 200000;
+Result result;
+uint64_t startCycle;
+
+uint64_t distance(uint64_t a, uint64_t b) {
+  return a > b ? a - b : b - a;
+}
+
+/*!
+ * Ciclos simulados desde o start, convertidos em ns.
+ */
+uint64_t elapsedNanos() {
+  return (dsf_Sim::now() - startCycle)*1000000000ull
+         / dsf_Sim::coreFrequency();
+}
+
+void readTicks() {
+  uint64_t previous = 0, value, before;
+  uint32_t primask;
+
+  for (uint32_t i = 0; i < readCount; i++) {
+    bool stretch = i % kStretchEvery == 0;
+
+    if (stretch) {
+      primask = __get_PRIMASK();
+      __disable_irq();
+    }
+    for (uint32_t j = 0; j < (stretch ? kStretchReads : 1); j++) {
+      before = dsf_Sim::now() - startCycle;
+      value = sysClock.ticks();
+      if (value < previous) {
+        result.backwards++;
+      }
+      if (value < before || value > dsf_Sim::now() - startCycle) {
+        result.outside++;
+      }
+      previous = value;
+      result.reads++;
+    }
+    if (stretch) {
+      __set_PRIMASK(primask);
+    }
+  }
+}
+
+void readNanos() {
+  uint64_t previous = 0, value, error;
+
+  for (uint32_t i = 0; i < readCount; i++) {
+    if (i == readCount/4) {
+      sysClock.setFrequency(TPMDiv_t::Div4);
+      result.divisorChanges++;
+    } else if (i == 3*readCount/4) {
+      sysClock.setFrequency(TPMDiv_t::Div1);
+      result.divisorChanges++;
+    }
+    value = sysClock.nanoseconds();
+    error = distance(value, elapsedNanos());
+    if (value < previous) {
+      result.backwards++;
+    }
+    if (error > result.worstNanos) {
+      result.worstNanos = error;
+    }
+    previous = value;
+    result.reads++;
+  }
+}
+
+void entry() {
+  sysClock.start();
+  startCycle = dsf_Sim::now();
+  readTicks();
+  readNanos();
+  result.overflows = sysClock.ticks() >> 16;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool ok;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      readCount = (uint32_t)strtoul(argv[++i], 0, 0);
+    } else {
+      fprintf(stderr, "usage: %s [-n reads]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  dsf_Sim::run(entry, dsf_Sim::microseconds(60000000));
+
+  printf("reads=%u overflows=%llu interrupts=%llu divisor_changes=%llu\n",
+         result.reads, (unsigned long long)result.overflows,
+         (unsigned long long)dsf_Sim::interruptCount(),
+         (unsigned long long)result.divisorChanges);
+  printf("backwards=%u ticks_outside_call=%u worst_ns_error=%llu\n",
+         result.backwards, result.outside,
+         (unsigned long long)result.worstNanos);
+  ok = result.reads > 2*readCount && result.backwards == 0
+       && result.outside == 0 && result.worstNanos <= kMaxNanosError;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
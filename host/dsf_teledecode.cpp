@@ -0,0 +1,182 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Decodificador dos quadros de telemetria do dsf_Telemetry_ocp.
+ *
+ * @file        dsf_teledecode.cpp
+ * @version     1.0
+ * @date        4 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O2 -Isim -I..
+ *                            dsf_teledecode.cpp -o dsf_teledecode
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (4 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+
+ *
+ * @section     USAGE
+ *
+ *              dsf_teledecode [-q] [captura.bin]
+ *
+ *              Lê os bytes da serial (do arquivo ou da entrada padrão, por
+ *              exemplo de um "cat /dev/ttyACM0") e escreve um registro por
+ *              linha, seguido de um resumo. Os quadros são localizados pelo
+ *              byte de sincronismo e confirmados pelo CRC-8, calculado aqui
+ *              bit a bit, independente da tabela do firmware. Bytes antes
+ *              do primeiro quadro e um quadro incompleto no fim (captura
+ *              iniciada ou encerrada no meio do fluxo) são tolerados; os
+ *              saltos do número de sequência são os registros descartados
+ *              pelo firmware (lost). Com -q só o resumo é escrito. O código
+ *              de saída é 0 se nenhum quadro foi corrompido.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "dsf_Telemetry_ocp.h"
+
+namespace {
+
+uint8_t crc8(const uint8_t *data, size_t length) {
+  uint8_t crc = 0;
+
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (uint8_t)((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+  }
+  return crc;
+}
+
+uint32_t word(const uint8_t *at) {
+  return (uint32_t)at[0] | (uint32_t)at[1] << 8 | (uint32_t)at[2] << 16
+         | (uint32_t)at[3] << 24;
+}
+
+void printRecord(uint8_t type, uint8_t sequence, const uint8_t *payload,
+                 uint8_t length) {
+  printf("seq=%u ", sequence);
+  if (type == Telemetry_t::dsf_RecCounter && length == 5) {
+    printf("counter id=%u value=%lu\n", payload[0],
+           (unsigned long)word(payload + 1));
+  } else if (type == Telemetry_t::dsf_RecDraw && length == 8) {
+    printf("draw number=%lu value=%lu\n", (unsigned long)word(payload),
+           (unsigned long)word(payload + 4));
+  } else if (type == Telemetry_t::dsf_RecWin && length == 5) {
+    printf("win number=%lu tier=%u\n", (unsigned long)word(payload),
+           payload[4]);
+  } else if (type == Telemetry_t::dsf_RecLatency && length == 4) {
+    printf("latency us=%lu\n", (unsigned long)word(payload));
+  } else {
+    printf("type=%u length=%u\n", type, length);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool quiet = false;
+  const char *path = 0;
+  FILE *input = stdin;
+  std::vector<uint8_t> data;
+  uint8_t block[4096];
+  size_t n, at = 0, frameEnd = 0;
+  unsigned long frames = 0, lost = 0, skipped = 0, corrupted = 0;
+  unsigned long truncated = 0;
+  int previous = -1;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-q")) {
+      quiet = true;
+    } else if (!path && argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      fprintf(stderr, "usage: %s [-q] [capture.bin]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (path && !(input = fopen(path, "rb"))) {
+    perror(path);
+    return 1;
+  }
+  while ((n = fread(block, 1, sizeof(block), input)) > 0) {
+    data.insert(data.end(), block, block + n);
+  }
+
+  /*!
+   * Um CRC errado logo após um quadro válido é um quadro corrompido; antes
+   * do primeiro quadro, ou já fora de sincronismo, é um falso sincronismo.
+   */
+  while (at < data.size()) {
+    const uint8_t *frame = &data[at];
+    size_t size;
+
+    if (frame[0] != Telemetry_t::dsf_Sync) {
+      skipped += frames ? 1 : 0;
+      at++;
+      continue;
+    }
+    if (data.size() - at < Telemetry_t::dsf_HeaderSize + 1u) {
+      truncated++;
+      break;
+    }
+    size = Telemetry_t::dsf_HeaderSize + frame[3] + 1u;
+    if (frame[3] > Telemetry_t::dsf_MaxPayload
+        || (data.size() - at >= size
+            && crc8(frame + 1, size - 2) != frame[size - 1])) {
+      if (frames && at == frameEnd) {
+        corrupted++;
+      } else if (frames) {
+        skipped++;
+      }
+      at++;
+      continue;
+    }
+    if (data.size() - at < size) {
+      truncated++;
+      break;
+    }
+    if (previous >= 0) {
+      lost += (uint8_t)(frame[2] - previous - 1);
+    }
+    previous = frame[2];
+    if (!quiet) {
+      printRecord(frame[1], frame[2], frame + Telemetry_t::dsf_HeaderSize,
+                  frame[3]);
+    }
+    frames++;
+    at += size;
+    frameEnd = at;
+  }
+
+  printf("frames=%lu lost=%lu corrupted=%lu skipped_bytes=%lu "
+         "truncated=%lu\n", frames, lost, corrupted, skipped, truncated);
+  return corrupted == 0 && skipped == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Telemetria pela UART0 com DMA no simulador do host.
+ *
+ * @file        dsf_telemetry_sim.cpp
+ * @version     1.0
+ * @date        4 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -no-pie
+ *                            -Wno-int-to-pointer-cast -Isim -I..
+ *                            dsf_telemetry_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_Telemetry_ocp.cpp ../dsf_UART_ocp.cpp
+ *                            ../dsf_ClockGate_ocp.cpp ../dsf_MCG_ocp.cpp
+ *                            -o dsf_telemetry_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (4 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_telemetry_sim > telemetria.bin
+ *              dsf_teledecode telemetria.bin
+ *
+ *              O firmware de teste registra 200 contadores a cada 1 ms,
+ *              dentro da capacidade da linha a 115200 bauds, depois uma
+ *              rajada de 120 sorteios, maior que o buffer, e por fim alguns
+ *              prêmios e latências com o buffer vazio. Os bytes que saem
+ *              pela UART0 simulada são escritos na saída padrão, para o
+ *              dsf_teledecode, que deve informar lost igual ao dropped
+ *              desta ferramenta. O código de saída é 0 se os bytes
+ *              recebidos são exatamente os dos quadros aceitos, se só a
+ *              rajada perdeu registros, se a rajada não acessou nenhum
+ *              registrador (o custo é só a cópia para o buffer) e se o
+ *              buffer foi esvaziado.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Telemetry_ocp.h"
+#include "dsf_Irq_ocp.h"
+
+dsf_UART_ocp serial(1);
+
+DSF_IRQ_BIND(DMA1, serial)
+
+dsf_Telemetry_ocp telemetry(serial);
+
+namespace {
+
+/*!
+ * Bytes recebidos do transmissor e contagens do firmware de teste.
+ */
+std::string received;
+
+struct Counts {
+  uint32_t acceptedBytes;
+  uint32_t steadyDrops;
+  uint32_t burstDrops;
+  uint64_t burstAccesses;
+  bool drained;
+};
+
+Counts counts = {0, 0, 0, 0, false};
+
+void onByte(void *, uint8_t byte) {
+  received += (char)byte;
+}
+
+/*!
+ * Espera de n acessos de 100 ciclos (escritas no GPIOB_PTOR, sem pino de
+ * saída).
+ */
+void pace(uint32_t accesses) {
+  for (uint32_t i = 0; i < accesses; i++) {
+    DSF_SIM_REG32(0x400FF04Cu) = 0;
+  }
+}
+
+void waitDrained() {
+  for (int i = 0; i < 2000 && serial.space() != UART_t::dsf_RingSize; i++) {
+    pace(50);
+  }
+  pace(400);
+}
+
+void entry() {
+  uint64_t before;
+
+  serial.start(115200);
+  for (uint32_t i = 0; i < 200; i++) {
+    if (telemetry.counter(Telemetry_t::dsf_CounterBlinks, i)) {
+      counts.acceptedBytes += 10;
+    } else {
+      counts.steadyDrops++;
+    }
+    pace(210);
+  }
+
+  /*!
+   * Rajada: o primeiro registro pode acordar o DMA parado; os demais só
+   * copiam para o buffer.
+   */
+  waitDrained();
+  if (telemetry.draw(0, 0)) {
+    counts.acceptedBytes += 13;
+  }
+  before = dsf_Sim::accessCount();
+  for (uint32_t i = 1; i < 120; i++) {
+    if (telemetry.draw(i, i*7919u)) {
+      counts.acceptedBytes += 13;
+    } else {
+      counts.burstDrops++;
+    }
+  }
+  counts.burstAccesses = dsf_Sim::accessCount() - before;
+
+  waitDrained();
+  for (uint32_t i = 0; i < 4; i++) {
+    if (telemetry.win(i*30, (uint8_t)(i + 1))) {
+      counts.acceptedBytes += 10;
+    }
+    if (telemetry.latency(1000 + i)) {
+      counts.acceptedBytes += 9;
+    }
+  }
+  waitDrained();
+  counts.drained = serial.space() == UART_t::dsf_RingSize;
+}
+
+}  // namespace
+
+int main() {
+  bool ok;
+
+  dsf_Sim::listen(onByte, 0);
+  dsf_Sim::setAccessCycles(100);
+  dsf_Sim::run(entry, dsf_Sim::microseconds(2000000));
+  fwrite(received.data(), 1, received.size(), stdout);
+
+  ok = received.size() == counts.acceptedBytes
+       && serial.sent() == counts.acceptedBytes
+       && counts.steadyDrops == 0 && counts.burstDrops > 0
+       && counts.burstDrops == telemetry.dropped()
+       && counts.burstAccesses == 0 && counts.drained;
+  fprintf(stderr, "baud=%lu records=%lu dropped=%lu bytes=%lu expected=%lu "
+          "burst_accesses=%llu simulated_ms=%llu %s\n",
+          (unsigned long)serial.baud(), (unsigned long)telemetry.records(),
+          (unsigned long)telemetry.dropped(), (unsigned long)received.size(),
+          (unsigned long)counts.acceptedBytes,
+          (unsigned long long)counts.burstAccesses,
+          (unsigned long long)(dsf_Sim::now()*1000/dsf_Sim::coreFrequency()),
+          ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Toque, liberação e deriva da linha de base do dsf_TSI_ocp
+ *              no simulador do host.
+ *
+ * @file        dsf_tsi_sim.cpp
+ * @version     1.0
+ * @date        17 Novembro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O1 -Wno-int-to-pointer-cast
+ *                            -Isim -I.. dsf_tsi_sim.cpp sim/dsf_Sim.cpp
+ *                            ../dsf_TSI_ocp.cpp ../dsf_ClockGate_ocp.cpp
+ *                            ../dsf_Irq_ocp.cpp ../dsf_MCG_ocp.cpp
+ *                            -o dsf_tsi_sim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (17 Novembro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              dsf_tsi_sim
+ *
+ *              Os eletrodos do slider da placa (PTB16 e PTB17) são
+ *              varridos a cada 5 ms, disparados pelo LPTMR, de modo que
+ *              cada um é medido a cada 10 ms. As contagens seguem um
+ *              roteiro: linha de base de 1000 e 1200, uma deriva lenta de
+ *              +60 no primeiro eletrodo, um toque de +400 no primeiro, um
+ *              degrau de +150 no segundo, abaixo do limiar de toque, e
+ *              depois um toque de +300 que cai para +150, acima do limiar
+ *              de liberação, e para +50. Por fim a contagem do primeiro cai
+ *              abaixo da linha de base.
+ *
+ *              O laço principal dorme em WFI e retira os eventos da fila.
+ *              O código de saída é 0 se a calibração dá as contagens
+ *              iniciais; se a linha de base segue a deriva sem gerar
+ *              eventos, a no máximo 40 contagens; se os quatro eventos
+ *              chegam na ordem, com eletrodo e tipo esperados, até 11 ms
+ *              depois do degrau que os causa; se o degrau abaixo do
+ *              limiar e a queda dentro da histerese não geram eventos; e
+ *              se a linha de base desce de imediato para a contagem menor.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sim/dsf_Sim.h"
+#include "dsf_Irq_ocp.h"
+#include "dsf_TSI_ocp.h"
+
+namespace {
+
+const uint8_t kChannels[] = {TSI_t::dsf_CH9_PTB16, TSI_t::dsf_CH10_PTB17};
+const uint16_t kPeriodMs = 5;
+const uint32_t kMaxLatencyMicros = 11000;
+const uint16_t kMaxDriftLag = 40;
+
+}  // namespace
+
+dsf_TSI_ocp touch(kChannels, 2);
+
+DSF_IRQ_BIND(TSI0, touch)
+
+namespace {
+
+/*!
+ * Um passo do roteiro: instante em microssegundos, eletrodo e contagem.
+ * event indica que o passo deve gerar um evento desse tipo.
+ */
+enum Expect {
+  kNone,
+  kPress,
+  kRelease
+};
+
+struct Step {
+  uint32_t micros;
+  uint8_t electrode;
+  uint16_t count;
+  Expect event;
+};
+
+/*!
+ * Deriva de +1 a cada 20 ms no primeiro eletrodo, de 200 a 1400 ms.
+ */
+const uint32_t kDriftFrom = 200000;
+const uint32_t kDriftStep = 20000;
+const uint16_t kDriftCounts = 60;
+
+const Step kScript[] = {
+  {0, 0, 1000, kNone}, {0, 1, 1200, kNone},
+  {1500000, 0, 1460, kPress},
+  {1700000, 1, 1350, kNone},
+  {1800000, 1, 1500, kPress},
+  {1900000, 1, 1350, kNone},
+  {2000000, 1, 1250, kRelease},
+  {2100000, 0, 1060, kRelease},
+  {2200000, 0, 980, kNone}
+};
+const uint32_t kSteps = sizeof(kScript)/sizeof(kScript[0]);
+const uint32_t kEndMicros = 2400000;
+
+/*!
+ * Leituras da linha de base: depois da calibração, no fim da deriva e
+ * depois da queda abaixo da linha de base.
+ */
+struct Snapshot {
+  uint32_t micros;
+  uint16_t baseline[2];
+  uint32_t events;
+};
+
+Snapshot snapshots[] = {{150000, {0, 0}, 0}, {1400000, {0, 0}, 0},
+                        {2250000, {0, 0}, 0}};
+const uint32_t kSnapshots = sizeof(snapshots)/sizeof(snapshots[0]);
+
+/*!
+ * Eventos recebidos pelo laço principal, com o instante da retirada.
+ */
+struct Received {
+  dsf_Event event;
+  uint64_t cycle;
+};
+
+Received received[16];
+uint32_t receivedCount;
+uint16_t drifted;
+
+void setCount(void *argument) {
+  const Step *step = (const Step *)argument;
+
+  dsf_Sim::setTouchCount(kChannels[step->electrode], step->count);
+}
+
+void drift(void *) {
+  drifted++;
+  dsf_Sim::setTouchCount(kChannels[0], (uint16_t)(1000 + drifted));
+}
+
+void snapshot(void *argument) {
+  Snapshot *shot = (Snapshot *)argument;
+
+  shot->baseline[0] = touch.baseline(0);
+  shot->baseline[1] = touch.baseline(1);
+  shot->events = receivedCount;
+}
+
+void entry() {
+  dsf_Event event;
+
+  touch.start(kPeriodMs);
+  for (;;) {
+    __WFI();
+    while (touch.events().pop(&event)) {
+      if (receivedCount < sizeof(received)/sizeof(received[0])) {
+        received[receivedCount].event = event;
+        received[receivedCount].cycle = dsf_Sim::now();
+        receivedCount++;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  bool ok = true;
+  uint32_t expected = 0;
+  uint32_t lastStamp = 0;
+
+  for (uint32_t i = 0; i < kSteps; i++) {
+    if (kScript[i].micros == 0) {
+      setCount((void *)&kScript[i]);
+    } else {
+      dsf_Sim::schedule(dsf_Sim::microseconds(kScript[i].micros), setCount,
+                        (void *)&kScript[i]);
+    }
+  }
+  for (uint32_t i = 1; i <= kDriftCounts; i++) {
+    dsf_Sim::schedule(dsf_Sim::microseconds(kDriftFrom + i*kDriftStep), drift,
+                      0);
+  }
+  for (uint32_t i = 0; i < kSnapshots; i++) {
+    dsf_Sim::schedule(dsf_Sim::microseconds(snapshots[i].micros), snapshot,
+                      &snapshots[i]);
+  }
+  dsf_Sim::run(entry, dsf_Sim::microseconds(kEndMicros));
+
+  printf("%-9s %-8s %6s %10s %10s\n", "electrode", "type", "stamp",
+         "step_us", "delay_us");
+  for (uint32_t i = 0; i < kSteps; i++) {
+    const Step &step = kScript[i];
+    const Received *got;
+    uint64_t delay;
+
+    if (step.event == kNone) {
+      continue;
+    }
+    if (expected >= receivedCount) {
+      printf("%-9u %-8s missing\n", step.electrode,
+             step.event == kPress ? "press" : "release");
+      ok = false;
+      continue;
+    }
+    got = &received[expected++];
+    delay = got->cycle - dsf_Sim::microseconds(step.micros);
+    printf("%-9u %-8s %6lu %10lu %10.0f\n", got->event.code,
+           got->event.type == Event_t::dsf_Press ? "press" : "release",
+           (unsigned long)got->event.stamp, (unsigned long)step.micros,
+           delay*1e6/dsf_Sim::coreFrequency());
+    ok = ok && got->event.source == Event_t::dsf_SourceTouch
+         && got->event.code == step.electrode
+         && got->event.type == (step.event == kPress ? Event_t::dsf_Press
+                                                     : Event_t::dsf_Release)
+         && got->event.stamp >= lastStamp
+         && got->cycle >= dsf_Sim::microseconds(step.micros)
+         && delay <= dsf_Sim::microseconds(kMaxLatencyMicros);
+    lastStamp = got->event.stamp;
+  }
+  ok = ok && receivedCount == expected
+       && touch.events().droppedCount() == 0;
+
+  for (uint32_t i = 0; i < kSnapshots; i++) {
+    printf("at_us=%lu baseline=%u,%u events=%u\n",
+           (unsigned long)snapshots[i].micros, snapshots[i].baseline[0],
+           snapshots[i].baseline[1], snapshots[i].events);
+  }
+  ok = ok && snapshots[0].baseline[0] == 1000
+       && snapshots[0].baseline[1] == 1200
+       && snapshots[1].events == 0
+       && snapshots[1].baseline[0] <= 1000 + kDriftCounts
+       && snapshots[1].baseline[0] + kMaxDriftLag >= 1000 + kDriftCounts
+       && snapshots[2].baseline[0] == 980;
+  printf("%s\n", ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
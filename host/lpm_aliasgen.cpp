@@ -0,0 +1,273 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Gerador das tabelas de alias de prêmios do lpm_compare.
+ *
+ * @file        lpm_aliasgen.cpp
+ * @version     1.0
+ * @date        18 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O2 -I.. lpm_aliasgen.cpp
+ *                            -o lpm_aliasgen
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (18 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              lpm_aliasgen [-k bits] [-n nome] [-s amostras]
+ *                           faixa0=peso faixa1=peso ... > tabela.cpp
+ *
+ *              A faixa 0 é a faixa sem prêmio. A probabilidade da faixa i
+ *              é peso_i/soma dos pesos. A tabela é construída pelo método
+ *              de Vose em aritmética inteira e verificada por enumeração de
+ *              todos os pares (coluna, u) através de
+ *              lpm_prizeCompare::selectPrize: a ferramenta falha se alguma
+ *              faixa não ocorrer com probabilidade exatamente igual à
+ *              pedida.
+ *              Com -s, a tabela também é amostrada com lpm_random.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+#include "lpm_compare.h"
+
+namespace {
+
+struct Tier {
+  std::string label;
+  uint32_t weight;
+};
+
+/*!
+ *   @fn         buildVose
+ *
+ *   @brief      Constrói a tabela de alias em aritmética inteira.
+ *
+ *   Cada faixa i recebe a massa weight_i * N, em unidades de
+ *   1/(N * weightTotal), e cada coluna tem capacidade weightTotal. Como
+ *   todas as operações são inteiras, a massa de cada faixa é preservada
+ *   exatamente.
+ */
+bool buildVose(const std::vector<Tier> &tiers, uint32_t columns,
+               uint32_t weightTotal, std::vector<uint32_t> *threshold,
+               std::vector<uint8_t> *alias) {
+  std::vector<uint64_t> mass(columns, 0);
+  std::vector<uint32_t> small, large;
+
+  for (size_t i = 0; i < tiers.size(); i++) {
+    mass[i] = (uint64_t)tiers[i].weight * columns;
+  }
+  for (uint32_t c = 0; c < columns; c++) {
+    (mass[c] < weightTotal ? small : large).push_back(c);
+  }
+  threshold->assign(columns, weightTotal);
+  alias->assign(columns, 0);
+  for (uint32_t c = 0; c < columns; c++) {
+    (*alias)[c] = (uint8_t)c;
+  }
+  while (!small.empty() && !large.empty()) {
+    uint32_t l = small.back();
+    uint32_t g = large.back();
+    small.pop_back();
+    large.pop_back();
+    (*threshold)[l] = (uint32_t)mass[l];
+    (*alias)[l] = (uint8_t)g;
+    mass[g] -= weightTotal - mass[l];
+    (mass[g] < weightTotal ? small : large).push_back(g);
+  }
+  /*!
+   * Colunas restantes devem estar exatamente cheias.
+   */
+  for (size_t i = 0; i < small.size(); i++) {
+    if (mass[small[i]] != weightTotal) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < large.size(); i++) {
+    if (mass[large[i]] != weightTotal) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ *   @fn         verifyExact
+ *
+ *   @brief      Verifica a distribuição exata da tabela.
+ *
+ *   Enumera todas as colunas e todos os valores u em [0, weightTotal),
+ *   que são equiprováveis, e conta a faixa devolvida por
+ *   lpm_prizeCompare::selectPrize. A faixa i deve ocorrer exatamente
+ *   weight_i * N vezes.
+ */
+bool verifyExact(const std::vector<Tier> &tiers, const lpm_aliasTable &table) {
+  uint32_t columns = 1u << table.columnBits;
+  std::vector<uint64_t> hits(columns, 0);
+  bool exact = true;
+
+  for (uint32_t c = 0; c < columns; c++) {
+    if (table.threshold[c] > table.weightTotal || table.alias[c] >= columns) {
+      return false;
+    }
+    if ((uint64_t)columns * table.weightTotal <= (1u << 26)) {
+      for (uint32_t u = 0; u < table.weightTotal; u++) {
+        hits[lpm_prizeCompare::selectPrize(table, c, u)]++;
+      }
+    } else {
+      hits[lpm_prizeCompare::selectPrize(table, c, 0)] +=
+          table.threshold[c];
+      if (table.threshold[c] < table.weightTotal) {
+        hits[lpm_prizeCompare::selectPrize(table, c,
+                                           table.weightTotal - 1)] +=
+            table.weightTotal - table.threshold[c];
+      }
+    }
+  }
+  for (uint32_t i = 0; i < columns; i++) {
+    uint64_t expected = i < tiers.size() ?
+                        (uint64_t)tiers[i].weight * columns : 0;
+    if (hits[i] != expected) {
+      fprintf(stderr, "tier %u: %llu hits, expected %llu\n", i,
+              (unsigned long long)hits[i], (unsigned long long)expected);
+      exact = false;
+    }
+  }
+  return exact;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::vector<Tier> tiers;
+  int columnBits = -1;
+  const char *name = "prizeTable";
+  uint64_t samples = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-k") && i + 1 < argc) {
+      columnBits = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      name = argv[++i];
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      samples = strtoull(argv[++i], NULL, 0);
+    } else if (strchr(argv[i], '=')) {
+      Tier tier;
+      const char *eq = strchr(argv[i], '=');
+      tier.label.assign(argv[i], eq - argv[i]);
+      tier.weight = (uint32_t)strtoul(eq + 1, NULL, 0);
+      tiers.push_back(tier);
+    } else {
+      fprintf(stderr, "usage: %s [-k bits] [-n name] [-s samples]"
+              " label=weight...\n", argv[0]);
+      return 2;
+    }
+  }
+
+  uint64_t total = 0;
+  for (size_t i = 0; i < tiers.size(); i++) {
+    total += tiers[i].weight;
+  }
+  if (tiers.size() < 2 || tiers.size() > 128 || total == 0) {
+    fprintf(stderr, "need 2 to 128 tiers with a positive total weight\n");
+    return 2;
+  }
+  if (columnBits < 0) {
+    columnBits = 1;
+    while ((1u << columnBits) < tiers.size()) {
+      columnBits++;
+    }
+  }
+  if (columnBits < 1 || columnBits > 8 ||
+      (1u << columnBits) < tiers.size() ||
+      total > (1ull << (32 - columnBits))) {
+    fprintf(stderr, "invalid column bits or total weight too large\n");
+    return 2;
+  }
+
+  uint32_t columns = 1u << columnBits;
+  uint32_t weightTotal = (uint32_t)total;
+  std::vector<uint32_t> threshold;
+  std::vector<uint8_t> alias;
+  if (!buildVose(tiers, columns, weightTotal, &threshold, &alias)) {
+    fprintf(stderr, "alias construction lost mass\n");
+    return 1;
+  }
+
+  lpm_aliasTable table;
+  table.columnBits = (uint8_t)columnBits;
+  table.tiers = (uint8_t)tiers.size();
+  table.weightTotal = weightTotal;
+  table.rejectBelow = (uint32_t)((1ull << (32 - columnBits)) % weightTotal);
+  table.threshold = &threshold[0];
+  table.alias = &alias[0];
+  if (!verifyExact(tiers, table)) {
+    fprintf(stderr, "alias table is not exact\n");
+    return 1;
+  }
+
+  if (samples) {
+    lpm_random generator(1);
+    std::vector<uint64_t> hits(tiers.size(), 0);
+    for (uint64_t s = 0; s < samples; s++) {
+      hits[lpm_prizeCompare::comparePrize(generator, table)]++;
+    }
+    for (size_t i = 0; i < tiers.size(); i++) {
+      double p = (double)tiers[i].weight / weightTotal;
+      double z = (hits[i] - samples * p) / sqrt(samples * p * (1.0 - p));
+      fprintf(stderr, "tier %zu %-10s p=%.6f sampled=%.6f z=%+.2f\n", i,
+              tiers[i].label.c_str(), p, (double)hits[i] / samples, z);
+    }
+  }
+
+  printf("/*\n * Tabela de alias gerada por host/lpm_aliasgen. Não editar.\n"
+         " *\n * Verificada exata por enumeração de %llu pares (coluna, u).\n"
+         " *\n", (unsigned long long)columns * weightTotal);
+  for (size_t i = 0; i < tiers.size(); i++) {
+    printf(" * Faixa %zu (%s): %u/%u\n", i, tiers[i].label.c_str(),
+           tiers[i].weight, weightTotal);
+  }
+  printf(" */\n\n#include \"lpm_prizeTable.h\"\n\n");
+  printf("static const uint32_t %sThreshold[%u] = {\n ", name, columns);
+  for (uint32_t c = 0; c < columns; c++) {
+    printf(" %u%s", threshold[c], c + 1 < columns ? "," : "\n");
+  }
+  printf("};\n\nstatic const uint8_t %sAlias[%u] = {\n ", name, columns);
+  for (uint32_t c = 0; c < columns; c++) {
+    printf(" %u%s", alias[c], c + 1 < columns ? "," : "\n");
+  }
+  printf("};\n\nconst lpm_aliasTable %s = {\n  %u, %u, %u, %u,\n"
+         "  %sThreshold, %sAlias\n};\n", name, table.columnBits, table.tiers,
+         table.weightTotal, table.rejectBelow, name, name);
+  return 0;
+}
@@ -0,0 +1,347 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Verificação e benchmark de lpm_counter e lpm_compare no host.
+ *
+ * @file        lpm_check.cpp
+ * @version     1.0
+ * @date        28 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O2 -I.. lpm_check.cpp
+ *                            -o lpm_check
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (28 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              lpm_check [-n operações] [-s semente]
+ *
+ *              Cada instância de lpm_counter é comparada, borda a borda,
+ *              com um modelo de referência escrito com desvios, sob
+ *              entradas cnt_en, sload, data e sclr pseudoaleatórias; as
+ *              saídas de lpm_compare são verificadas exaustivamente para
+ *              larguras até 10 bits e nos extremos e em pares
+ *              pseudoaleatórios para 16 e 32 bits. Em seguida, o custo de
+ *              uma borda de clock e de uma comparação é medido contra o do
+ *              modelo de referência. O código de saída é 0 se todas as
+ *              verificações passaram.
+ *
+ *              No x86-64 o compilador também converte os desvios da
+ *              referência em cmov, de modo que o benchmark mede só a vazão;
+ *              a ausência de desvios importa no Cortex-M0+, que não tem
+ *              execução condicional.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "lpm_counter.h"
+#include "lpm_compare.h"
+#include "lpm_random.h"
+
+/*!
+ * O tipo de armazenamento é o menor que comporta a largura.
+ */
+static_assert(sizeof(lpm_counter<1>::word) == 1, "1 bit em 8");
+static_assert(sizeof(lpm_counter<8>::word) == 1, "8 bits em 8");
+static_assert(sizeof(lpm_counter<9>::word) == 2, "9 bits em 16");
+static_assert(sizeof(lpm_counter<16>::word) == 2, "16 bits em 16");
+static_assert(sizeof(lpm_counter<17>::word) == 4, "17 bits em 32");
+static_assert(sizeof(lpm_counter<32>::word) == 4, "32 bits em 32");
+
+namespace {
+
+/*!
+ *  @struct   Inputs
+ *
+ *  @brief    Entradas síncronas de uma borda de clock.
+ */
+struct Inputs {
+  bool cntEn;
+  bool sload;
+  bool sclr;
+  uint32_t data;
+};
+
+/*!
+ * Entradas pseudoaleatórias: conta em 3/4 das bordas, carrega em 1/16 e
+ * zera em 1/32.
+ */
+Inputs randomInputs(lpm_random &generator, uint64_t modulus) {
+  uint32_t r = generator.next();
+  Inputs in;
+
+  in.cntEn = (r & 3) != 0;
+  in.sload = ((r >> 2) & 15) == 0;
+  in.sclr = ((r >> 6) & 31) == 0;
+  in.data = (uint32_t)(generator.next() % modulus);
+  return in;
+}
+
+/*!
+ *  @class    Reference
+ *
+ *  @brief    Modelo de referência do LPM_COUNTER, com desvios.
+ */
+template <uint64_t Modulus, Counter_t::dsf_Direction Dir>
+class Reference {
+ public:
+  Reference() : q(0) {
+  }
+
+  void clock(bool cntEn, bool sload, uint32_t data, bool sclr) {
+    if (sclr) {
+      q = 0;
+    } else if (sload) {
+      q = data;
+    } else if (cntEn) {
+      if (Dir == Counter_t::dsf_Up) {
+        q = (q + 1 == Modulus) ? 0 : q + 1;
+      } else {
+        q = (q == 0) ? Modulus - 1 : q - 1;
+      }
+    }
+  }
+
+  uint32_t cout() const {
+    return Dir == Counter_t::dsf_Up ? q == Modulus - 1 : q == 0;
+  }
+
+  uint64_t q;
+};
+
+template <uint8_t Width, uint64_t Modulus, Counter_t::dsf_Direction Dir>
+bool checkCounter(uint64_t seed, uint32_t steps) {
+  lpm_counter<Width, Modulus, Dir> counter;
+  Reference<Modulus, Dir> reference;
+  lpm_random generator(seed ^ (Modulus * 31 + Width * 2 + Dir));
+
+  for (uint32_t i = 0; i < steps; i++) {
+    Inputs in = randomInputs(generator, Modulus);
+
+    counter.clock(in.cntEn, in.sload, in.data, in.sclr);
+    reference.clock(in.cntEn, in.sload, in.data, in.sclr);
+    if (counter.q() != reference.q || counter.cout() != reference.cout()) {
+      printf("FAIL lpm_counter<%u, %llu, %s> step %u: q=%lu expected %llu\n",
+             Width, (unsigned long long)Modulus,
+             Dir == Counter_t::dsf_Up ? "Up" : "Down", i,
+             (unsigned long)counter.q(), (unsigned long long)reference.q);
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * Dois contadores módulo 10 em cascata contam módulo 100.
+ */
+bool checkCascade(uint32_t steps) {
+  lpm_counter<4, 10> units;
+  lpm_counter<4, 10> tens;
+
+  for (uint32_t i = 1; i <= steps; i++) {
+    tens.clock(units.cout() != 0);
+    units.clock();
+    if (tens.q()*10u + units.q() != i % 100) {
+      printf("FAIL cascade at %u: %u%u\n", i, tens.q(), units.q());
+      return false;
+    }
+  }
+  return true;
+}
+
+template <uint8_t Width>
+bool checkPair(uint32_t a, uint32_t b) {
+  lpm_compareOutputs out = lpm_compare<Width>::compare(
+      (typename lpm_compare<Width>::word)a,
+      (typename lpm_compare<Width>::word)b);
+
+  if (out.aeb != (a == b) || out.agb != (a > b) || out.alb != (a < b)
+      || out.aneb != (a != b) || out.ageb != (a >= b)
+      || out.aleb != (a <= b)) {
+    printf("FAIL lpm_compare<%u>(%lu, %lu)\n", Width, (unsigned long)a,
+           (unsigned long)b);
+    return false;
+  }
+  return true;
+}
+
+template <uint8_t Width>
+bool checkCompare(uint64_t seed, uint32_t pairs) {
+  const uint64_t top = 1ull << Width;
+  const uint32_t edges[] = {0, 1, (uint32_t)(top/2 - 1), (uint32_t)(top/2),
+                            (uint32_t)(top/2 + 1), (uint32_t)(top - 2),
+                            (uint32_t)(top - 1)};
+  lpm_random generator(seed + Width);
+
+  if (Width <= 10) {
+    for (uint64_t a = 0; a < top; a++) {
+      for (uint64_t b = 0; b < top; b++) {
+        if (!checkPair<Width>((uint32_t)a, (uint32_t)b)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+  for (uint32_t i = 0; i < 7; i++) {
+    for (uint32_t j = 0; j < 7; j++) {
+      if (!checkPair<Width>(edges[i], edges[j])) {
+        return false;
+      }
+    }
+  }
+  for (uint32_t i = 0; i < pairs; i++) {
+    uint32_t a = (uint32_t)(generator.next() & (top - 1));
+    uint32_t b = (i & 1) ? a ^ (1u << (generator.next() % Width))
+                         : (uint32_t)(generator.next() & (top - 1));
+    if (!checkPair<Width>(a, b)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * Custo médio de uma operação, em ns, de um laço sobre entradas
+ * pré-geradas.
+ */
+template <typename Body>
+double timeLoop(uint64_t operations, Body body) {
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+
+  body(operations);
+  return std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - begin).count()/operations;
+}
+
+volatile uint32_t sink;
+
+void benchmark(uint64_t operations, uint64_t seed) {
+  const uint32_t kInputs = 4096;
+  std::vector<Inputs> inputs(kInputs);
+  std::vector<uint32_t> operands(kInputs + 1);
+  lpm_random generator(seed);
+
+  for (uint32_t i = 0; i < kInputs; i++) {
+    inputs[i] = randomInputs(generator, 100);
+    operands[i] = generator.next() % 100;
+  }
+  operands[kInputs] = operands[0];
+
+  double counterNs = timeLoop(operations, [&](uint64_t n) {
+    lpm_counter<7, 100> counter;
+    for (uint64_t i = 0; i < n; i++) {
+      const Inputs &in = inputs[i & (kInputs - 1)];
+      counter.clock(in.cntEn, in.sload, (uint8_t)in.data, in.sclr);
+    }
+    sink = counter.q();
+  });
+  double referenceNs = timeLoop(operations, [&](uint64_t n) {
+    Reference<100, Counter_t::dsf_Up> counter;
+    for (uint64_t i = 0; i < n; i++) {
+      const Inputs &in = inputs[i & (kInputs - 1)];
+      counter.clock(in.cntEn, in.sload, in.data, in.sclr);
+    }
+    sink = (uint32_t)counter.q;
+  });
+  double compareNs = timeLoop(operations, [&](uint64_t n) {
+    uint32_t wins = 0;
+    for (uint64_t i = 0; i < n; i++) {
+      uint32_t k = i & (kInputs - 1);
+      lpm_compareOutputs out = lpm_compare<7>::compare(
+          (uint8_t)operands[k], (uint8_t)operands[k + 1]);
+      wins += out.alb + out.aeb;
+    }
+    sink = wins;
+  });
+  double compareReferenceNs = timeLoop(operations, [&](uint64_t n) {
+    uint32_t wins = 0;
+    for (uint64_t i = 0; i < n; i++) {
+      uint32_t k = i & (kInputs - 1);
+      wins += (operands[k] < operands[k + 1]) + (operands[k] == operands[k + 1]);
+    }
+    sink = wins;
+  });
+
+  printf("lpm_counter<7, 100>::clock  %6.2f ns (reference %6.2f ns)\n",
+         counterNs, referenceNs);
+  printf("lpm_compare<7>::compare     %6.2f ns (reference %6.2f ns)\n",
+         compareNs, compareReferenceNs);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint64_t operations = 100000000;
+  uint64_t seed = 1;
+  uint32_t steps = 1000000;
+  bool ok = true;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      operations = strtoull(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      seed = strtoull(argv[++i], 0, 0);
+    } else {
+      fprintf(stderr, "usage: %s [-n operations] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  ok &= checkCounter<1, 2, Counter_t::dsf_Up>(seed, steps);
+  ok &= checkCounter<1, 2, Counter_t::dsf_Down>(seed, steps);
+  ok &= checkCounter<3, 5, Counter_t::dsf_Up>(seed, steps);
+  ok &= checkCounter<3, 5, Counter_t::dsf_Down>(seed, steps);
+  ok &= checkCounter<4, 10, Counter_t::dsf_Up>(seed, steps);
+  ok &= checkCounter<7, 100, Counter_t::dsf_Up>(seed, steps);
+  ok &= checkCounter<7, 100, Counter_t::dsf_Down>(seed, steps);
+  ok &= checkCounter<8, 256, Counter_t::dsf_Up>(seed, steps);
+  ok &= checkCounter<8, 256, Counter_t::dsf_Down>(seed, steps);
+  ok &= checkCounter<16, 1000, Counter_t::dsf_Up>(seed, steps);
+  ok &= checkCounter<16, 65536, Counter_t::dsf_Down>(seed, steps);
+  ok &= checkCounter<24, 10000000, Counter_t::dsf_Down>(seed, steps);
+  ok &= checkCounter<32, 4000000000ull, Counter_t::dsf_Up>(seed, steps);
+  ok &= checkCounter<32, 1ull << 32, Counter_t::dsf_Up>(seed, steps);
+  ok &= checkCounter<32, 1ull << 32, Counter_t::dsf_Down>(seed, steps);
+  ok &= checkCascade(steps);
+  ok &= checkCompare<1>(seed, steps);
+  ok &= checkCompare<7>(seed, steps);
+  ok &= checkCompare<8>(seed, steps);
+  ok &= checkCompare<10>(seed, steps);
+  ok &= checkCompare<16>(seed, steps);
+  ok &= checkCompare<32>(seed, steps);
+  printf("checks %s\n", ok ? "passed" : "FAILED");
+
+  benchmark(operations, seed);
+  return ok ? 0 : 1;
+}
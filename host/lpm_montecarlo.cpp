@@ -0,0 +1,500 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Validação estatística do sorteio por Monte Carlo no host.
+ *
+ * @file        lpm_montecarlo.cpp
+ * @version     1.0
+ * @date        16 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64, multithread.
+ *              +compiler     g++ -std=c++11 -O2 -pthread -I..
+ *                            lpm_montecarlo.cpp -o lpm_montecarlo
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (16 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              lpm_montecarlo [-n sorteios] [-t threads] [-c log2 do bloco]
+ *                             [-s semente] [-S]
+ *
+ *              Os sorteios são divididos em blocos. O bloco k usa o
+ *              gerador da semente avançado k*2^64 passos (lpm_random::jump),
+ *              uma sequência que não se sobrepõe às dos outros blocos, de
+ *              modo que o resultado não depende do número de threads nem da
+ *              ordem de execução. Com -S a
+ *              execução é repetida de 1 até o número de threads para
+ *              medir a escalabilidade.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "lpm_draw.h"
+
+namespace {
+
+/*!
+ * Número de classes do teste de comprimento das sequências de derrotas.
+ */
+const int kStreakBins = 64;
+
+/*!
+ *  @struct   Tally
+ *
+ *  @brief    Contadores locais de uma thread.
+ *
+ *  @details  Cada thread acumula em sua própria estrutura, alinhada à
+ *            linha de cache, e as estruturas só são somadas no final.
+ */
+struct alignas(64) Tally {
+  uint64_t draws;
+  uint64_t wins;
+  uint64_t valueCount[Draw_t::dsf_Modulus];
+  uint64_t streakCount[kStreakBins + 1];
+  double runsObserved;
+  double runsExpected;
+  double runsVariance;
+  uint64_t pairs;
+  uint64_t sumXY;
+  uint64_t sumX;
+  uint64_t sumY;
+  uint64_t sumXX;
+
+  void merge(const Tally &other) {
+    draws += other.draws;
+    wins += other.wins;
+    for (int i = 0; i < Draw_t::dsf_Modulus; i++) {
+      valueCount[i] += other.valueCount[i];
+    }
+    for (int i = 0; i <= kStreakBins; i++) {
+      streakCount[i] += other.streakCount[i];
+    }
+    runsObserved += other.runsObserved;
+    runsExpected += other.runsExpected;
+    runsVariance += other.runsVariance;
+    pairs += other.pairs;
+    sumXY += other.sumXY;
+    sumX += other.sumX;
+    sumY += other.sumY;
+    sumXX += other.sumXX;
+  }
+};
+
+/*!
+ *  @struct   WorkRange
+ *
+ *  @brief    Faixa de blocos de uma thread, sujeita a roubo.
+ *
+ *  @details  O início e o fim da faixa ficam em uma única palavra atômica
+ *            de 64 bits. O dono consome blocos pelo início e as outras
+ *            threads roubam metade dos blocos restantes pelo fim.
+ */
+struct alignas(64) WorkRange {
+  std::atomic<uint64_t> range;
+
+  static uint64_t pack(uint32_t begin, uint32_t end) {
+    return ((uint64_t)end << 32) | begin;
+  }
+
+  bool pop(uint32_t *chunk) {
+    uint64_t r = range.load(std::memory_order_relaxed);
+    for (;;) {
+      uint32_t begin = (uint32_t)r;
+      uint32_t end = (uint32_t)(r >> 32);
+      if (begin >= end) {
+        return false;
+      }
+      if (range.compare_exchange_weak(r, pack(begin + 1, end))) {
+        *chunk = begin;
+        return true;
+      }
+    }
+  }
+
+  bool stealHalf(uint32_t *begin, uint32_t *end) {
+    uint64_t r = range.load(std::memory_order_relaxed);
+    for (;;) {
+      uint32_t b = (uint32_t)r;
+      uint32_t e = (uint32_t)(r >> 32);
+      if (b >= e) {
+        return false;
+      }
+      uint32_t taken = (e - b + 1) / 2;
+      if (range.compare_exchange_weak(r, pack(b, e - taken))) {
+        *begin = e - taken;
+        *end = e;
+        return true;
+      }
+    }
+  }
+};
+
+/*!
+ *   @fn         runChunk
+ *
+ *   @brief      Executa os sorteios de um bloco.
+ *
+ *   O bloco começa no estado base, o gerador da semente avançado
+ *   chunk*2^64 passos, e não alcança a base do bloco seguinte. As
+ *   estatísticas de sequência (corridas e correlação serial) são
+ *   calculadas dentro do bloco e somadas entre blocos.
+ */
+void runChunk(const lpm_random &base, uint64_t draws, Tally *tally) {
+  lpm_draw machine;
+  uint64_t wins = 0;
+  uint64_t runs = 0;
+  uint64_t sumXY = 0, sumX = 0, sumXX = 0;
+  uint32_t streak = 0;
+  uint32_t previous;
+
+  machine.generator = base;
+  previous = machine.draw();
+  uint32_t first = previous;
+  bool previousWin = lpm_draw::isWin(previous);
+
+  tally->valueCount[previous]++;
+  if (previousWin) {
+    wins++;
+    tally->streakCount[0]++;
+  } else {
+    streak = 1;
+  }
+  runs = 1;
+  sumX = previous;
+  sumXX = (uint64_t)previous * previous;
+
+  for (uint64_t i = 1; i < draws; i++) {
+    uint32_t value = machine.draw();
+    bool win = lpm_draw::isWin(value);
+
+    tally->valueCount[value]++;
+    sumXY += (uint64_t)previous * value;
+    sumX += value;
+    sumXX += (uint64_t)value * value;
+    runs += win != previousWin;
+    if (win) {
+      wins++;
+      tally->streakCount[streak < kStreakBins ? streak : kStreakBins]++;
+      streak = 0;
+    } else {
+      streak++;
+    }
+    previous = value;
+    previousWin = win;
+  }
+
+  /*!
+   * Teste de corridas de Wald-Wolfowitz: valor esperado e variância do
+   * número de corridas para n1 vitórias e n2 derrotas no bloco.
+   */
+  double n1 = (double)wins;
+  double n2 = (double)(draws - wins);
+  double n = n1 + n2;
+  if (n1 > 0 && n2 > 0) {
+    tally->runsObserved += (double)runs;
+    tally->runsExpected += 2.0 * n1 * n2 / n + 1.0;
+    tally->runsVariance +=
+        2.0 * n1 * n2 * (2.0 * n1 * n2 - n) / (n * n * (n - 1.0));
+  }
+
+  tally->draws += draws;
+  tally->wins += wins;
+  tally->pairs += draws - 1;
+  tally->sumXY += sumXY;
+  tally->sumX += sumX - previous;
+  tally->sumY += sumX - first;
+  tally->sumXX += sumXX;
+}
+
+/*!
+ *   @fn         gammaQ
+ *
+ *   @brief      Função gama incompleta regularizada superior Q(a, x).
+ *
+ *   Usada para o valor-p do teste qui-quadrado: p = Q(gl/2, chi2/2).
+ */
+double gammaQ(double a, double x) {
+  if (x <= 0.0) {
+    return 1.0;
+  }
+  double lnPrefix = a * log(x) - x - lgamma(a);
+  if (x < a + 1.0) {
+    double term = 1.0 / a, sum = term;
+    for (int n = 1; n < 10000; n++) {
+      term *= x / (a + n);
+      sum += term;
+      if (term < sum * 1e-15) {
+        break;
+      }
+    }
+    return 1.0 - sum * exp(lnPrefix);
+  }
+  double b = x + 1.0 - a, c = 1e300, d = 1.0 / b, h = d;
+  for (int i = 1; i < 10000; i++) {
+    double an = -i * (i - a);
+    b += 2.0;
+    d = an * d + b;
+    if (fabs(d) < 1e-300) d = 1e-300;
+    c = b + an / c;
+    if (fabs(c) < 1e-300) c = 1e-300;
+    d = 1.0 / d;
+    double delta = d * c;
+    h *= delta;
+    if (fabs(delta - 1.0) < 1e-15) {
+      break;
+    }
+  }
+  return exp(lnPrefix) * h;
+}
+
+/*!
+ * Valor-p bilateral de uma estatística normal padrão.
+ */
+double normalP(double z) {
+  return erfc(fabs(z) / sqrt(2.0));
+}
+
+/*!
+ *   @fn         runAll
+ *
+ *   @brief      Executa todos os blocos com o número de threads pedido.
+ *
+ *   @return     O tempo de execução, em segundos.
+ */
+double runAll(uint64_t totalDraws, uint32_t chunkLog2, uint64_t seed,
+              unsigned threads, Tally *result) {
+  uint64_t chunkDraws = 1ull << chunkLog2;
+  uint32_t chunks = (uint32_t)((totalDraws + chunkDraws - 1) / chunkDraws);
+  std::vector<WorkRange> ranges(threads);
+  std::vector<Tally> tallies(threads);
+  std::vector<std::thread> workers;
+  std::vector<lpm_random> bases(chunks);
+  lpm_random generator(seed);
+
+  for (uint32_t c = 0; c < chunks; c++) {
+    bases[c] = generator;
+    generator.jump();
+  }
+
+  for (unsigned t = 0; t < threads; t++) {
+    uint32_t begin = (uint32_t)((uint64_t)chunks * t / threads);
+    uint32_t end = (uint32_t)((uint64_t)chunks * (t + 1) / threads);
+    ranges[t].range.store(WorkRange::pack(begin, end));
+    memset(&tallies[t], 0, sizeof(Tally));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned t = 0; t < threads; t++) {
+    workers.push_back(std::thread([&, t]() {
+      uint32_t chunk;
+      for (;;) {
+        while (ranges[t].pop(&chunk)) {
+          uint64_t first = (uint64_t)chunk * chunkDraws;
+          uint64_t draws = totalDraws - first < chunkDraws ?
+                           totalDraws - first : chunkDraws;
+          runChunk(bases[chunk], draws, &tallies[t]);
+        }
+        /*!
+         * Faixa própria esgotada: rouba metade da faixa de outra thread.
+         */
+        bool stolen = false;
+        for (unsigned v = 1; v < threads && !stolen; v++) {
+          uint32_t begin, end;
+          if (ranges[(t + v) % threads].stealHalf(&begin, &end)) {
+            ranges[t].range.store(WorkRange::pack(begin, end));
+            stolen = true;
+          }
+        }
+        if (!stolen) {
+          return;
+        }
+      }
+    }));
+  }
+  for (unsigned t = 0; t < threads; t++) {
+    workers[t].join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  memset(result, 0, sizeof(Tally));
+  for (unsigned t = 0; t < threads; t++) {
+    result->merge(tallies[t]);
+  }
+  return elapsed.count();
+}
+
+/*!
+ *   @fn         report
+ *
+ *   @brief      Imprime a taxa de vitória e os testes estatísticos.
+ *
+ *   @return     0 se todos os testes passam ao nível de 0,1%.
+ */
+int report(const Tally &tally) {
+  const double p = (double)Draw_t::dsf_WinValues / Draw_t::dsf_Modulus;
+  const double alpha = 0.001;
+  double n = (double)tally.draws;
+  int failures = 0;
+
+  /*!
+   * Taxa de vitória contra a binomial(n, 7%).
+   */
+  double rate = tally.wins / n;
+  double zRate = (tally.wins - n * p) / sqrt(n * p * (1.0 - p));
+  double pRate = normalP(zRate);
+  printf("win rate        %.7f%% (%llu/%llu)  z=%+.3f  p=%.4f\n",
+         100.0 * rate, (unsigned long long)tally.wins,
+         (unsigned long long)tally.draws, zRate, pRate);
+  failures += pRate < alpha;
+
+  /*!
+   * Qui-quadrado da uniformidade dos 100 valores do sorteio.
+   */
+  double expected = n / Draw_t::dsf_Modulus;
+  double chi2 = 0.0;
+  for (int i = 0; i < Draw_t::dsf_Modulus; i++) {
+    double d = tally.valueCount[i] - expected;
+    chi2 += d * d / expected;
+  }
+  double pChi2 = gammaQ((Draw_t::dsf_Modulus - 1) / 2.0, chi2 / 2.0);
+  printf("uniformity      chi2=%.2f  df=%d  p=%.4f\n", chi2,
+         Draw_t::dsf_Modulus - 1, pChi2);
+  failures += pChi2 < alpha;
+
+  /*!
+   * Qui-quadrado do comprimento das sequências de derrotas contra a
+   * distribuição geométrica P(k) = (1 - p)^k p.
+   */
+  double streaks = 0.0;
+  for (int k = 0; k <= kStreakBins; k++) {
+    streaks += tally.streakCount[k];
+  }
+  double chi2Streak = 0.0;
+  for (int k = 0; k <= kStreakBins; k++) {
+    double prob = k < kStreakBins ? pow(1.0 - p, k) * p :
+                                    pow(1.0 - p, kStreakBins);
+    double e = streaks * prob;
+    double d = tally.streakCount[k] - e;
+    chi2Streak += d * d / e;
+  }
+  double pStreak = gammaQ(kStreakBins / 2.0, chi2Streak / 2.0);
+  printf("loss streaks    chi2=%.2f  df=%d  p=%.4f\n", chi2Streak,
+         kStreakBins, pStreak);
+  failures += pStreak < alpha;
+
+  /*!
+   * Teste de corridas de vitórias/derrotas.
+   */
+  double zRuns = (tally.runsObserved - tally.runsExpected) /
+                 sqrt(tally.runsVariance);
+  double pRuns = normalP(zRuns);
+  printf("runs            observed=%.0f  expected=%.1f  z=%+.3f  p=%.4f\n",
+         tally.runsObserved, tally.runsExpected, zRuns, pRuns);
+  failures += pRuns < alpha;
+
+  /*!
+   * Correlação serial de atraso 1 entre valores consecutivos.
+   */
+  double m = (double)tally.pairs;
+  double meanX = tally.sumX / m;
+  double meanY = tally.sumY / m;
+  double mean = (double)(tally.sumX + tally.sumY) / (2.0 * m);
+  double variance = tally.sumXX / n - mean * mean;
+  double r1 = (tally.sumXY / m - meanX * meanY) / variance;
+  double zSerial = r1 * sqrt(m);
+  double pSerial = normalP(zSerial);
+  printf("serial lag-1    r=%+.3e  z=%+.3f  p=%.4f\n", r1, zSerial, pSerial);
+  failures += pSerial < alpha;
+
+  printf("result          %s\n", failures ? "FAIL" : "PASS");
+  return failures ? 1 : 0;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  uint64_t totalDraws = 4000000000ull;
+  unsigned threads = std::thread::hardware_concurrency();
+  uint32_t chunkLog2 = 20;
+  uint64_t seed = 0x4c504d5f44524157ull;
+  bool scaling = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      totalDraws = strtoull(argv[++i], NULL, 0);
+    } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+      threads = (unsigned)strtoul(argv[++i], NULL, 0);
+    } else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+      chunkLog2 = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      seed = strtoull(argv[++i], NULL, 0);
+    } else if (!strcmp(argv[i], "-S")) {
+      scaling = true;
+    } else {
+      fprintf(stderr, "usage: %s [-n draws] [-t threads] [-c chunk_log2]"
+              " [-s seed] [-S]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (threads == 0) {
+    threads = 1;
+  }
+  if (chunkLog2 < 8 || chunkLog2 > 32 ||
+      ((totalDraws - 1) >> chunkLog2) >= 0xFFFFFFFFull) {
+    fprintf(stderr, "invalid chunk size for %llu draws\n",
+            (unsigned long long)totalDraws);
+    return 2;
+  }
+
+  Tally tally;
+  if (scaling) {
+    double base = 0.0;
+    for (unsigned t = 1; t <= threads; t++) {
+      double seconds = runAll(totalDraws, chunkLog2, seed, t, &tally);
+      double rate = totalDraws / seconds;
+      if (t == 1) {
+        base = rate;
+      }
+      printf("threads %2u  %.3f s  %.3e draws/s  speedup %.2f  "
+             "efficiency %.0f%%\n", t, seconds, rate, rate / base,
+             100.0 * rate / base / t);
+    }
+  } else {
+    double seconds = runAll(totalDraws, chunkLog2, seed, threads, &tally);
+    printf("threads %u  chunks of 2^%u  %.3f s  %.3e draws/s\n", threads,
+           chunkLog2, seconds, totalDraws / seconds);
+  }
+  return report(tally);
+}
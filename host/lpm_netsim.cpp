@@ -0,0 +1,330 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Verificação e vazão do simulador de netlists lpm_netlist.
+ *
+ * @file        lpm_netsim.cpp
+ * @version     1.0
+ * @date        30 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O2 -DLPM_NETLIST_THREADS
+ *                            -pthread -I.. lpm_netsim.cpp -o lpm_netsim
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (30 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              lpm_netsim [-m máquinas] [-n ciclos] [-t threads]
+ *
+ *              Cada máquina de sorteio da netlist tem uma tecla (porta de
+ *              entrada pseudoaleatória), um contador módulo 100, o
+ *              comparador de vitória abaixo de 7, um contador de vitórias,
+ *              um contador de dezenas em cascata, um contador realimentado
+ *              pela própria carga e um led (porta de saída). As máquinas
+ *              são partições independentes. O estado final é comparado com
+ *              um modelo escrito com lpm_counter e lpm_compare, na execução
+ *              em conjunto e na execução em threads. A vazão é informada em
+ *              ciclos simulados por segundo. Um comparador de 4 bits entre
+ *              0x13 e 0x03 deve dar aeb. O código de saída é 0 se todas as
+ *              verificações passaram.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#include "lpm_netlist.h"
+#include "lpm_compare.h"
+#include "lpm_counter.h"
+
+namespace {
+
+const uint16_t kMaxMachines = 128;
+const uint16_t kNodesPerMachine = 10;
+
+typedef lpm_netlist<kMaxMachines * kNodesPerMachine,
+                    kMaxMachines * 16 + 8> Netlist;
+
+/*!
+ *  @struct   Machine
+ *
+ *  @brief    Portas de uma máquina: gerador da tecla e bordas do led.
+ */
+struct Machine {
+  uint32_t lfsr;
+  uint32_t led;
+  uint32_t edges;
+};
+
+/*!
+ * Tecla: bit 0 de um xorshift32, diferente em cada máquina.
+ */
+uint32_t readKey(void *context) {
+  Machine *machine = static_cast<Machine *>(context);
+  uint32_t x = machine->lfsr;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  machine->lfsr = x;
+  return x & 1;
+}
+
+void writeLed(void *context, uint32_t level) {
+  Machine *machine = static_cast<Machine *>(context);
+
+  machine->edges += level & ~machine->led & 1;
+  machine->led = level;
+}
+
+/*!
+ *  @struct   Signals
+ *
+ *  @brief    Sinais observados de uma máquina.
+ */
+struct Signals {
+  uint16_t value;
+  uint16_t wins;
+  uint16_t tens;
+  uint16_t looped;
+};
+
+void seedMachines(Machine *machines, uint16_t count) {
+  for (uint16_t m = 0; m < count; m++) {
+    machines[m].lfsr = 0x9E3779B9u * (m + 1u);
+    machines[m].led = 0;
+    machines[m].edges = 0;
+  }
+}
+
+/*!
+ * Constrói as máquinas; retorna false se a netlist recusou o projeto.
+ */
+bool build(Netlist *net, Machine *machines, Signals *signals,
+           uint16_t count) {
+  uint16_t limit = net->constant(7);
+  uint16_t top = net->constant(200);
+  uint16_t base = net->constant(0x10);
+
+  for (uint16_t m = 0; m < count; m++) {
+    uint16_t key = net->input(readKey, &machines[m]);
+    lpm_netCounter value = net->counter(7, 100);
+    lpm_netCompare win = net->compare(7, value.q, limit);
+    uint16_t hit = net->gate(Net_t::dsf_And, win.alb, key);
+    lpm_netCounter wins = net->counter(16, 65536, Counter_t::dsf_Up, hit);
+    lpm_netCounter tens = net->counter(4, 10, Counter_t::dsf_Down,
+                                       value.cout);
+    lpm_netCounter looped = net->counter(8, 256);
+    lpm_netCompare full = net->compare(8, looped.q, top);
+
+    /*!
+     * Realimentação: o contador volta a 0x10 quando chega a 200.
+     */
+    net->connect(looped, Net_t::dsf_Sload, full.aeb);
+    net->connect(looped, Net_t::dsf_Data, base);
+    net->output(hit, writeLed, &machines[m]);
+    signals[m].value = value.q;
+    signals[m].wins = wins.q;
+    signals[m].tens = tens.q;
+    signals[m].looped = looped.q;
+  }
+  return net->levelize();
+}
+
+/*!
+ *  @struct   Reference
+ *
+ *  @brief    Modelo de referência de uma máquina.
+ */
+struct Reference {
+  lpm_counter<7, 100> value;
+  lpm_counter<16, 65536> wins;
+  lpm_counter<4, 10, Counter_t::dsf_Down> tens;
+  lpm_counter<8, 256> looped;
+  Machine ports;
+};
+
+void runReference(Reference *machine, uint32_t cycles) {
+  for (uint32_t c = 0; c < cycles; c++) {
+    uint32_t key = readKey(&machine->ports);
+    uint32_t hit = lpm_compare<7>::less(machine->value.q(), 7) & key;
+
+    writeLed(&machine->ports, hit);
+    machine->wins.clock(hit != 0);
+    machine->tens.clock(machine->value.cout() != 0);
+    machine->looped.clock(true, lpm_compare<8>::equal(machine->looped.q(),
+                                                      200) != 0, 0x10);
+    machine->value.clock();
+  }
+}
+
+bool verify(const char *mode, const Netlist &net, const Machine *machines,
+            const Signals *signals, uint16_t count, uint32_t cycles) {
+  for (uint16_t m = 0; m < count; m++) {
+    Reference reference;
+
+    seedMachines(&reference.ports, 1);
+    reference.ports.lfsr = 0x9E3779B9u * (m + 1u);
+    runReference(&reference, cycles);
+    if (net.read(signals[m].value) != reference.value.q()
+        || net.read(signals[m].wins) != reference.wins.q()
+        || net.read(signals[m].tens) != reference.tens.q()
+        || net.read(signals[m].looped) != reference.looped.q()
+        || machines[m].edges != reference.ports.edges) {
+      printf("FAIL %s machine %u: value=%lu wins=%lu tens=%lu looped=%lu"
+             " edges=%lu, expected %u %u %u %u %lu\n", mode, m,
+             (unsigned long)net.read(signals[m].value),
+             (unsigned long)net.read(signals[m].wins),
+             (unsigned long)net.read(signals[m].tens),
+             (unsigned long)net.read(signals[m].looped),
+             (unsigned long)machines[m].edges, reference.value.q(),
+             reference.wins.q(), reference.tens.q(), reference.looped.q(),
+             (unsigned long)reference.ports.edges);
+      return false;
+    }
+  }
+  return true;
+}
+
+double elapsedSeconds(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                       - begin).count();
+}
+
+Netlist single;
+Netlist threaded;
+Machine singleMachines[kMaxMachines];
+Machine threadedMachines[kMaxMachines];
+Signals singleSignals[kMaxMachines];
+Signals threadedSignals[kMaxMachines];
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint16_t count = 64;
+  uint32_t cycles = 200000;
+  uint16_t threads = (uint16_t)std::thread::hardware_concurrency();
+  bool ok = true;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+      count = (uint16_t)strtoul(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      cycles = (uint32_t)strtoul(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+      threads = (uint16_t)strtoul(argv[++i], 0, 0);
+    } else {
+      fprintf(stderr, "usage: %s [-m machines] [-n cycles] [-t threads]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (count < 1 || count > kMaxMachines) {
+    fprintf(stderr, "machines must be 1 to %u\n", kMaxMachines);
+    return 2;
+  }
+  if (threads < 1) {
+    threads = 1;
+  }
+
+  /*!
+   * Uma netlist acima da capacidade deve ser recusada.
+   */
+  {
+    lpm_netlist<4, 8> small;
+    lpm_netCounter a = small.counter(7, 100);
+    small.compare(7, a.q, small.constant(7));
+    small.counter(4, 10);
+    small.counter(4, 10);
+    if (small.levelize()) {
+      printf("FAIL netlist over capacity was accepted\n");
+      ok = false;
+    }
+    lpm_netlist<4, 8> invalid;
+    invalid.counter(4, 100);
+    if (invalid.levelize()) {
+      printf("FAIL counter with modulus above 2^width was accepted\n");
+      ok = false;
+    }
+  }
+
+  /*!
+   * Um comparador de 4 bits só enxerga os 4 bits menos significativos.
+   */
+  {
+    lpm_netlist<4, 8> masked;
+    lpm_netCompare out = masked.compare(4, masked.constant(0x13),
+                                        masked.constant(0x03));
+    if (!masked.levelize()) {
+      printf("FAIL masked comparator rejected by levelize\n");
+      ok = false;
+    } else {
+      masked.run(1);
+      if (masked.read(out.aeb) != 1 || masked.read(out.agb) != 0) {
+        printf("FAIL comparator ignored its width: aeb=%u agb=%u\n",
+               masked.read(out.aeb), masked.read(out.agb));
+        ok = false;
+      }
+    }
+  }
+
+  seedMachines(singleMachines, count);
+  seedMachines(threadedMachines, count);
+  if (!build(&single, singleMachines, singleSignals, count)
+      || !build(&threaded, threadedMachines, threadedSignals, count)) {
+    printf("FAIL design rejected by levelize\n");
+    return 1;
+  }
+  printf("%u machines, %u nodes, %u partitions, %lu cycles\n", count,
+         single.nodeCount(), single.partitionCount(),
+         (unsigned long)cycles);
+
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+  single.run(cycles);
+  double seconds = elapsedSeconds(begin);
+  printf("1 thread   %8.3f Mcycles/s  %8.1f Mnode-evals/s\n",
+         cycles/seconds/1e6, (double)cycles*single.nodeCount()/seconds/1e6);
+  ok &= verify("single", single, singleMachines, singleSignals, count,
+               cycles);
+
+  begin = std::chrono::steady_clock::now();
+  threaded.runThreaded(cycles, threads);
+  seconds = elapsedSeconds(begin);
+  printf("%u threads  %8.3f Mcycles/s  %8.1f Mnode-evals/s\n", threads,
+         cycles/seconds/1e6,
+         (double)cycles*threaded.nodeCount()/seconds/1e6);
+  ok &= verify("threaded", threaded, threadedMachines, threadedSignals,
+               count, cycles);
+  ok &= threaded.cycles() == cycles;
+
+  printf("checks %s\n", ok ? "passed" : "FAILED");
+  return ok ? 0 : 1;
+}
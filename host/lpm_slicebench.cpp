@@ -0,0 +1,363 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Verificação e vazão dos contadores e comparadores em fatias.
+ *
+ * @file        lpm_slicebench.cpp
+ * @version     1.0
+ * @date        29 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +compiler     g++ -std=c++11 -O2 -mavx2 -I..
+ *                            lpm_slicebench.cpp -o lpm_slicebench
+ *                            (sem -mavx2 a lane de 256 bits é omitida)
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (29 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @section     USAGE
+ *
+ *              lpm_slicebench [-n passos] [-s semente]
+ *
+ *              Primeiro, cada lpm_counterSlice é comparado, instância a
+ *              instância e borda a borda, com kInstances objetos
+ *              lpm_counter escalares sob as mesmas entradas
+ *              pseudoaleatórias, e cada lpm_compareSlice com
+ *              lpm_compare::compare. Em seguida, 4096 contadores módulo 100
+ *              e suas comparações com o limiar de vitória são avançados por
+ *              passos de clock, no caminho escalar e em lanes de 32, 64 e
+ *              256 bits. O resultado é o custo por contador e por passo. O
+ *              código de saída é 0 se todas as verificações passaram.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "lpm_slice.h"
+#include "lpm_random.h"
+
+namespace {
+
+/*!
+ * Entradas pseudoaleatórias de uma instância: conta em 3/4 das bordas,
+ * carrega em 1/16 e zera em 1/32.
+ */
+void randomInputs(lpm_random &generator, uint64_t modulus, uint32_t *cntEn,
+                  uint32_t *sload, uint32_t *sclr, uint32_t *data) {
+  uint32_t r = generator.next();
+
+  *cntEn = (r & 3) != 0;
+  *sload = ((r >> 2) & 15) == 0;
+  *sclr = ((r >> 6) & 31) == 0;
+  *data = (uint32_t)(generator.next() % modulus);
+}
+
+template <uint8_t Width, uint64_t Modulus, Counter_t::dsf_Direction Dir,
+          typename Lane>
+bool checkCounter(const char *lane, uint64_t seed, uint32_t steps) {
+  typedef lpm_lane<Lane> Ops;
+  const uint32_t n = Ops::kInstances;
+  std::vector<lpm_counter<Width, Modulus, Dir> > scalar(n);
+  lpm_counterSlice<Width, Modulus, Dir, Lane> slice;
+  lpm_planes<Width, Lane> data;
+  lpm_random generator(seed ^ (Modulus * 31 + Width * 2 + Dir));
+
+  for (uint32_t s = 0; s < steps; s++) {
+    Lane cntEn = Ops::zero(), sload = Ops::zero(), sclr = Ops::zero();
+
+    for (uint32_t k = 0; k < n; k++) {
+      uint32_t en, load, clear, value;
+
+      randomInputs(generator, Modulus, &en, &load, &clear, &value);
+      Ops::put(cntEn, k, en);
+      Ops::put(sload, k, load);
+      Ops::put(sclr, k, clear);
+      data.set(k, value);
+      scalar[k].clock(en, load,
+                      (typename lpm_counter<Width, Modulus, Dir>::word)value,
+                      clear);
+    }
+    slice.clock(cntEn, sload, data, sclr);
+
+    Lane cout = slice.cout();
+    for (uint32_t k = 0; k < n; k++) {
+      if (slice.q().get(k) != scalar[k].q()
+          || Ops::get(cout, k) != scalar[k].cout()) {
+        printf("FAIL lpm_counterSlice<%u, %llu, %s, %s> step %u instance %u:"
+               " q=%lu expected %lu\n", Width, (unsigned long long)Modulus,
+               Dir == Counter_t::dsf_Up ? "Up" : "Down", lane, s, k,
+               (unsigned long)slice.q().get(k),
+               (unsigned long)scalar[k].q());
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <uint8_t Width, typename Lane>
+bool checkCompare(const char *lane, uint64_t seed, uint32_t rounds) {
+  typedef lpm_lane<Lane> Ops;
+  const uint32_t n = Ops::kInstances;
+  const uint64_t mask = (1ull << Width) - 1;
+  lpm_planes<Width, Lane> a, b;
+  lpm_random generator(seed + Width);
+
+  for (uint32_t r = 0; r < rounds; r++) {
+    for (uint32_t k = 0; k < n; k++) {
+      uint32_t x = (uint32_t)(generator.next() & mask);
+      uint32_t y = (uint32_t)(generator.next() & mask);
+
+      /*!
+       * Um quarto dos pares é igual e um quarto difere em um só bit.
+       */
+      switch (k & 3) {
+        case 0:
+          y = x;
+          break;
+        case 1:
+          y = x ^ (1u << (generator.next() % Width));
+          break;
+      }
+      a.set(k, x);
+      b.set(k, y);
+    }
+
+    lpm_compareSliceOutputs<Lane> out = lpm_compareSlice<Width, Lane>::compare(
+        a, b);
+    for (uint32_t k = 0; k < n; k++) {
+      lpm_compareOutputs expected = lpm_compare<Width>::compare(
+          (typename lpm_compare<Width>::word)a.get(k),
+          (typename lpm_compare<Width>::word)b.get(k));
+
+      if (Ops::get(out.aeb, k) != expected.aeb
+          || Ops::get(out.agb, k) != expected.agb
+          || Ops::get(out.alb, k) != expected.alb
+          || Ops::get(out.aneb, k) != expected.aneb
+          || Ops::get(out.ageb, k) != expected.ageb
+          || Ops::get(out.aleb, k) != expected.aleb) {
+        printf("FAIL lpm_compareSlice<%u, %s>(%lu, %lu)\n", Width, lane,
+               (unsigned long)a.get(k), (unsigned long)b.get(k));
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <typename Lane>
+bool checkLane(const char *lane, uint64_t seed) {
+  bool ok = true;
+
+  ok &= checkCounter<1, 2, Counter_t::dsf_Up, Lane>(lane, seed, 2000);
+  ok &= checkCounter<3, 5, Counter_t::dsf_Down, Lane>(lane, seed, 2000);
+  ok &= checkCounter<4, 10, Counter_t::dsf_Up, Lane>(lane, seed, 2000);
+  ok &= checkCounter<7, 100, Counter_t::dsf_Up, Lane>(lane, seed, 2000);
+  ok &= checkCounter<7, 100, Counter_t::dsf_Down, Lane>(lane, seed, 2000);
+  ok &= checkCounter<8, 256, Counter_t::dsf_Up, Lane>(lane, seed, 2000);
+  ok &= checkCounter<8, 256, Counter_t::dsf_Down, Lane>(lane, seed, 2000);
+  ok &= checkCounter<16, 1000, Counter_t::dsf_Down, Lane>(lane, seed, 500);
+  ok &= checkCounter<32, 1ull << 32, Counter_t::dsf_Up, Lane>(lane, seed,
+                                                              200);
+  ok &= checkCompare<1, Lane>(lane, seed, 200);
+  ok &= checkCompare<7, Lane>(lane, seed, 200);
+  ok &= checkCompare<16, Lane>(lane, seed, 200);
+  ok &= checkCompare<32, Lane>(lane, seed, 200);
+  return ok;
+}
+
+/*!
+ * Parâmetros do benchmark: contadores, passos distintos de entradas
+ * pré-geradas e limiar de vitória.
+ */
+const uint32_t kCounters = 4096;
+const uint32_t kPool = 16;
+const uint32_t kWinValues = 7;
+
+struct ScalarInputs {
+  uint8_t cntEn;
+  uint8_t sload;
+  uint8_t sclr;
+  uint8_t data;
+};
+
+volatile uint64_t sink;
+
+double elapsedNs(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - begin).count();
+}
+
+/*!
+ * Caminho escalar: um lpm_counter e um lpm_compare por instância.
+ */
+double benchScalar(uint64_t seed, uint32_t steps, uint64_t *wins) {
+  std::vector<lpm_counter<7, 100> > counters(kCounters);
+  std::vector<ScalarInputs> pool(kPool * kCounters);
+  lpm_random generator(seed);
+  uint64_t total = 0;
+
+  for (uint32_t i = 0; i < kPool * kCounters; i++) {
+    uint32_t en, load, clear, value;
+
+    randomInputs(generator, 100, &en, &load, &clear, &value);
+    pool[i].cntEn = (uint8_t)en;
+    pool[i].sload = (uint8_t)load;
+    pool[i].sclr = (uint8_t)clear;
+    pool[i].data = (uint8_t)value;
+  }
+
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+  for (uint32_t s = 0; s < steps; s++) {
+    const ScalarInputs *in = &pool[(s % kPool) * kCounters];
+
+    for (uint32_t k = 0; k < kCounters; k++) {
+      counters[k].clock(in[k].cntEn, in[k].sload, in[k].data, in[k].sclr);
+      total += lpm_compare<7>::less(counters[k].q(), kWinValues);
+    }
+  }
+  double ns = elapsedNs(begin);
+
+  *wins = total;
+  sink = total;
+  return ns/((double)steps*kCounters);
+}
+
+/*!
+ * Caminho em fatias: kCounters/kInstances grupos de contadores.
+ */
+template <typename Lane>
+double benchSlice(uint64_t seed, uint32_t steps, uint64_t *wins) {
+  typedef lpm_lane<Lane> Ops;
+  const uint32_t groups = kCounters/Ops::kInstances;
+  struct Inputs {
+    Lane cntEn;
+    Lane sload;
+    Lane sclr;
+    lpm_planes<7, Lane> data;
+  };
+  std::vector<lpm_counterSlice<7, 100, Counter_t::dsf_Up, Lane> > counters(
+      groups);
+  std::vector<Inputs> pool(kPool * groups);
+  lpm_planes<7, Lane> limit;
+  lpm_random generator(seed);
+  uint64_t total = 0;
+
+  /*!
+   * Mesmas entradas do caminho escalar: a instância k do grupo g é o
+   * contador g*kInstances + k.
+   */
+  for (uint32_t i = 0; i < kPool * groups; i++) {
+    Inputs &in = pool[i];
+
+    in.cntEn = in.sload = in.sclr = Ops::zero();
+    for (uint32_t k = 0; k < Ops::kInstances; k++) {
+      uint32_t en, load, clear, value;
+
+      randomInputs(generator, 100, &en, &load, &clear, &value);
+      Ops::put(in.cntEn, k, en);
+      Ops::put(in.sload, k, load);
+      Ops::put(in.sclr, k, clear);
+      in.data.set(k, value);
+    }
+  }
+  limit.fill(kWinValues);
+
+  std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+  for (uint32_t s = 0; s < steps; s++) {
+    const Inputs *in = &pool[(s % kPool) * groups];
+
+    for (uint32_t g = 0; g < groups; g++) {
+      counters[g].clock(in[g].cntEn, in[g].sload, in[g].data, in[g].sclr);
+      total += Ops::count(lpm_compareSlice<7, Lane>::compare(
+          counters[g].q(), limit).alb);
+    }
+  }
+  double ns = elapsedNs(begin);
+
+  *wins = total;
+  sink = total;
+  return ns/((double)steps*kCounters);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  uint32_t steps = 20000;
+  uint64_t seed = 1;
+  uint64_t scalarWins, wins;
+  bool ok = true;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+      steps = (uint32_t)strtoul(argv[++i], 0, 0);
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      seed = strtoull(argv[++i], 0, 0);
+    } else {
+      fprintf(stderr, "usage: %s [-n steps] [-s seed]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  ok &= checkLane<uint32_t>("u32", seed);
+  ok &= checkLane<uint64_t>("u64", seed);
+#ifdef __AVX2__
+  ok &= checkLane<lpm_lane256>("avx2", seed);
+#endif
+  printf("checks %s\n", ok ? "passed" : "FAILED");
+
+  /*!
+   * Os mesmos contadores, nas mesmas entradas, devem produzir o mesmo
+   * número de vitórias em todos os caminhos.
+   */
+  double scalar = benchScalar(seed, steps, &scalarWins);
+  printf("%u counters x %lu steps, lpm_counter<7, 100> + lpm_compare<7>\n",
+         kCounters, (unsigned long)steps);
+  printf("scalar  %6.3f ns/counter-step\n", scalar);
+
+  double u32 = benchSlice<uint32_t>(seed, steps, &wins);
+  printf("u32     %6.3f ns/counter-step  %5.1fx\n", u32, scalar/u32);
+  ok &= wins == scalarWins;
+  double u64 = benchSlice<uint64_t>(seed, steps, &wins);
+  printf("u64     %6.3f ns/counter-step  %5.1fx\n", u64, scalar/u64);
+  ok &= wins == scalarWins;
+#ifdef __AVX2__
+  double avx2 = benchSlice<lpm_lane256>(seed, steps, &wins);
+  printf("avx2    %6.3f ns/counter-step  %5.1fx\n", avx2, scalar/avx2);
+  ok &= wins == scalarWins;
+#else
+  printf("avx2    not built (compile with -mavx2)\n");
+#endif
+  if (!ok) {
+    printf("FAIL\n");
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Cabeçalho do MKL25Z4 para o simulador de periféricos no host.
+ *
+ * @file        MKL25Z4.h
+ * @version     1.0
+ * @date        25 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (25 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ *
+ * @details     Substitui o cabeçalho do fabricante quando os drivers são
+ *              compilados no host com -Ihost/sim. Os registradores ficam nos
+ *              mesmos endereços da placa, que o simulador dsf_Sim mapeia e
+ *              intercepta, de modo que os drivers compilam sem alterações.
+ *              Somente os símbolos usados pelos drivers são definidos.
+ */
+
+#ifndef HOST_SIM_MKL25Z4_H_
+#define HOST_SIM_MKL25Z4_H_
+
+#include <stdint.h>
+
+#define DSF_HOST_SIM 1
+
+/*!
+ * Acesso a um registrador de 32 bits pelo endereço absoluto.
+ */
+#define DSF_SIM_REG32(address) (*(volatile uint32_t *)(uintptr_t)(address))
+
+/*!
+ * Endereços base dos periféricos.
+ */
+#define TPM0_BASE                 0x40038000u
+#define TPM1_BASE                 0x40039000u
+#define TPM2_BASE                 0x4003A000u
+#define SIM_BASE                  0x40047000u
+#define PORTA_BASE                0x40049000u
+#define GPIOA_BASE                0x400FF000u
+#define FGPIOA_BASE               0xF80FF000u
+
+/*!
+ * SIM - System Integration Module.
+ */
+#define SIM_SOPT2                 DSF_SIM_REG32(0x40048004u)
+#define SIM_SOPT7                 DSF_SIM_REG32(0x40048018u)
+#define SIM_SCGC4                 DSF_SIM_REG32(0x40048034u)
+#define SIM_SCGC5                 DSF_SIM_REG32(0x40048038u)
+#define SIM_SCGC6                 DSF_SIM_REG32(0x4004803Cu)
+#define SIM_SCGC7                 DSF_SIM_REG32(0x40048040u)
+#define SIM_CLKDIV1               DSF_SIM_REG32(0x40048044u)
+
+#define SIM_SCGC4_UART0_MASK      0x400u
+#define SIM_SCGC5_LPTMR_MASK      0x1u
+#define SIM_SCGC5_TSI_MASK        0x20u
+#define SIM_SCGC5_PORTA_MASK      0x200u
+#define SIM_SCGC5_PORTB_MASK      0x400u
+#define SIM_SCGC5_PORTC_MASK      0x800u
+#define SIM_SCGC5_PORTD_MASK      0x1000u
+#define SIM_SCGC5_PORTE_MASK      0x2000u
+#define SIM_SCGC6_DMAMUX_MASK     0x2u
+#define SIM_SCGC6_TPM0_MASK       0x1000000u
+#define SIM_SCGC6_TPM1_MASK       0x2000000u
+#define SIM_SCGC6_TPM2_MASK       0x4000000u
+#define SIM_SCGC6_ADC0_MASK       0x8000000u
+#define SIM_SCGC7_DMA_MASK        0x100u
+#define SIM_SOPT2_TPMSRC_MASK     0x3000000u
+#define SIM_SOPT2_TPMSRC(x)       (((uint32_t)(x) << 24) & 0x3000000u)
+#define SIM_SOPT2_UART0SRC_MASK   0xC000000u
+#define SIM_SOPT2_UART0SRC(x)     (((uint32_t)(x) << 26) & 0xC000000u)
+
+/*!
+ * PORT - Pin Control Register.
+ */
+#define PORT_PCR_PS_MASK          0x1u
+#define PORT_PCR_PE_MASK          0x2u
+#define PORT_PCR_MUX_MASK         0x700u
+#define PORT_PCR_MUX(x)           (((uint32_t)(x) << 8) & 0x700u)
+#define PORT_PCR_IRQC_MASK        0xF0000u
+#define PORT_PCR_IRQC(x)          (((uint32_t)(x) << 16) & 0xF0000u)
+#define PORT_PCR_ISF_MASK         0x1000000u
+
+/*!
+ * SysTick - temporizador do núcleo (core_cm0plus.h).
+ */
+typedef struct {
+  volatile uint32_t CTRL;
+  volatile uint32_t LOAD;
+  volatile uint32_t VAL;
+  volatile uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick                   ((SysTick_Type *)(uintptr_t)0xE000E010u)
+#define SysTick_CTRL_ENABLE_Msk     0x1u
+#define SysTick_CTRL_TICKINT_Msk    0x2u
+#define SysTick_CTRL_CLKSOURCE_Msk  0x4u
+#define SysTick_CTRL_COUNTFLAG_Msk  0x10000u
+#define SysTick_LOAD_RELOAD_Msk     0xFFFFFFu
+#define SysTick_VAL_CURRENT_Msk     0xFFFFFFu
+
+/*!
+ * SCB - System Control Block (core_cm0plus.h), até o CCR.
+ */
+typedef struct {
+  volatile uint32_t CPUID;
+  volatile uint32_t ICSR;
+  volatile uint32_t VTOR;
+  volatile uint32_t AIRCR;
+  volatile uint32_t SCR;
+  volatile uint32_t CCR;
+} SCB_Type;
+
+#define SCB                       ((SCB_Type *)(uintptr_t)0xE000ED00u)
+#define SCB_SCR_SLEEPDEEP_Msk     0x4u
+
+/*!
+ * Números das interrupções do MKL25Z4.
+ */
+typedef enum IRQn {
+  NonMaskableInt_IRQn = -14,
+  HardFault_IRQn = -13,
+  SVCall_IRQn = -5,
+  PendSV_IRQn = -2,
+  SysTick_IRQn = -1,
+  DMA0_IRQn = 0,
+  DMA1_IRQn = 1,
+  DMA2_IRQn = 2,
+  DMA3_IRQn = 3,
+  FTFA_IRQn = 5,
+  LVD_LVW_IRQn = 6,
+  LLW_IRQn = 7,
+  I2C0_IRQn = 8,
+  I2C1_IRQn = 9,
+  SPI0_IRQn = 10,
+  SPI1_IRQn = 11,
+  UART0_IRQn = 12,
+  UART1_IRQn = 13,
+  UART2_IRQn = 14,
+  ADC0_IRQn = 15,
+  CMP0_IRQn = 16,
+  TPM0_IRQn = 17,
+  TPM1_IRQn = 18,
+  TPM2_IRQn = 19,
+  RTC_IRQn = 20,
+  RTC_Seconds_IRQn = 21,
+  PIT_IRQn = 22,
+  USB0_IRQn = 24,
+  DAC0_IRQn = 25,
+  TSI0_IRQn = 26,
+  MCG_IRQn = 27,
+  LPTimer_IRQn = 28,
+  PORTA_IRQn = 30,
+  PORTD_IRQn = 31
+} IRQn_Type;
+
+/*!
+ * Núcleo simulado: PRIMASK, NVIC e instruções de sincronização.
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint32_t dsf_sim_getPrimask(void);
+void dsf_sim_setPrimask(uint32_t primask);
+void dsf_sim_nvicEnable(int irq, int enable);
+void dsf_sim_nvicPending(int irq, int pending);
+void dsf_sim_nvicPriority(int irq, uint32_t priority);
+void dsf_sim_wfi(void);
+uintptr_t dsf_sim_interruptedPc(void);
+#ifdef __cplusplus
+}
+#endif
+
+static inline uint32_t __get_PRIMASK(void) {
+  return dsf_sim_getPrimask();
+}
+static inline void __set_PRIMASK(uint32_t primask) {
+  dsf_sim_setPrimask(primask);
+}
+static inline void __disable_irq(void) {
+  dsf_sim_setPrimask(1);
+}
+static inline void __enable_irq(void) {
+  dsf_sim_setPrimask(0);
+}
+static inline void __WFI(void) {
+  dsf_sim_wfi();
+}
+static inline void __NOP(void) {
+}
+static inline void __DSB(void) {
+  __asm volatile("" ::: "memory");
+}
+static inline void __ISB(void) {
+  __asm volatile("" ::: "memory");
+}
+static inline void NVIC_EnableIRQ(IRQn_Type irq) {
+  dsf_sim_nvicEnable(irq, 1);
+}
+static inline void NVIC_DisableIRQ(IRQn_Type irq) {
+  dsf_sim_nvicEnable(irq, 0);
+}
+static inline void NVIC_SetPendingIRQ(IRQn_Type irq) {
+  dsf_sim_nvicPending(irq, 1);
+}
+static inline void NVIC_ClearPendingIRQ(IRQn_Type irq) {
+  dsf_sim_nvicPending(irq, 0);
+}
+static inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) {
+  dsf_sim_nvicPriority(irq, priority);
+}
+
+#endif  //  HOST_SIM_MKL25Z4_H_
@@ -0,0 +1,3140 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Simulador de periféricos do MKL25Z4 para execução no host.
+ *
+ * @file        dsf_Sim.cpp
+ * @version     1.0
+ * @date        25 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +peripheral   SIM, PORT, GPIO, FGPIO, TPM e NVIC simulados.
+ *              +compiler     g++ -std=c++11 -O1 -I. -I../.. -c dsf_Sim.cpp
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (25 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_Sim.h"
+
+#include <fcntl.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <map>
+#include <vector>
+
+#include <MKL25Z4.h>
+#include "dsf_TPM_ocp.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+/*!
+ * Tratadores do vetor de interrupções, definidos pelo firmware.
+ */
+extern "C" {
+void SysTick_Handler(void) __attribute__((weak));
+void DMA0_IRQHandler(void) __attribute__((weak));
+void DMA1_IRQHandler(void) __attribute__((weak));
+void DMA2_IRQHandler(void) __attribute__((weak));
+void DMA3_IRQHandler(void) __attribute__((weak));
+void FTFA_IRQHandler(void) __attribute__((weak));
+void LVD_LVW_IRQHandler(void) __attribute__((weak));
+void LLW_IRQHandler(void) __attribute__((weak));
+void I2C0_IRQHandler(void) __attribute__((weak));
+void I2C1_IRQHandler(void) __attribute__((weak));
+void SPI0_IRQHandler(void) __attribute__((weak));
+void SPI1_IRQHandler(void) __attribute__((weak));
+void UART0_IRQHandler(void) __attribute__((weak));
+void UART1_IRQHandler(void) __attribute__((weak));
+void UART2_IRQHandler(void) __attribute__((weak));
+void ADC0_IRQHandler(void) __attribute__((weak));
+void CMP0_IRQHandler(void) __attribute__((weak));
+void TPM0_IRQHandler(void) __attribute__((weak));
+void TPM1_IRQHandler(void) __attribute__((weak));
+void TPM2_IRQHandler(void) __attribute__((weak));
+void RTC_IRQHandler(void) __attribute__((weak));
+void RTC_Seconds_IRQHandler(void) __attribute__((weak));
+void PIT_IRQHandler(void) __attribute__((weak));
+void USB0_IRQHandler(void) __attribute__((weak));
+void DAC0_IRQHandler(void) __attribute__((weak));
+void TSI0_IRQHandler(void) __attribute__((weak));
+void MCG_IRQHandler(void) __attribute__((weak));
+void LPTimer_IRQHandler(void) __attribute__((weak));
+void PORTA_IRQHandler(void) __attribute__((weak));
+void PORTD_IRQHandler(void) __attribute__((weak));
+
+void dsf_sim_irq_trampoline(void);
+void dsf_sim_irq_dispatch(void);
+}
+
+/*!
+ * Entrada de exceção injetada pelo tratador do passo. O contexto
+ * interrompido empilhou o endereço de retorno abaixo da red zone; os
+ * registradores voláteis, as flags e o estado SSE são preservados e o
+ * "ret $128" devolve a pilha ao ponto exato da interrupção.
+ */
+__asm__(
+    "  .text\n"
+    "  .globl dsf_sim_irq_trampoline\n"
+    "  .type dsf_sim_irq_trampoline, @function\n"
+    "dsf_sim_irq_trampoline:\n"
+    "  pushfq\n"
+    "  pushq %rax\n"
+    "  pushq %rcx\n"
+    "  pushq %rdx\n"
+    "  pushq %rsi\n"
+    "  pushq %rdi\n"
+    "  pushq %r8\n"
+    "  pushq %r9\n"
+    "  pushq %r10\n"
+    "  pushq %r11\n"
+    "  pushq %rbx\n"
+    "  movq %rsp, %rbx\n"
+    "  andq $-64, %rsp\n"
+    "  subq $512, %rsp\n"
+    "  fxsave64 (%rsp)\n"
+    "  cld\n"
+    "  call dsf_sim_irq_dispatch\n"
+    "  fxrstor64 (%rsp)\n"
+    "  movq %rbx, %rsp\n"
+    "  popq %rbx\n"
+    "  popq %r11\n"
+    "  popq %r10\n"
+    "  popq %r9\n"
+    "  popq %r8\n"
+    "  popq %rdi\n"
+    "  popq %rsi\n"
+    "  popq %rdx\n"
+    "  popq %rcx\n"
+    "  popq %rax\n"
+    "  popfq\n"
+    "  ret $128\n"
+    "  .size dsf_sim_irq_trampoline, .-dsf_sim_irq_trampoline\n");
+
+namespace {
+
+/*!
+ * Relógio do núcleo no modo FEI de reset (32768 Hz x 640), a unidade do
+ * tempo simulado em qualquer perfil do MCG.
+ */
+const uint32_t kCoreHz = 20971520;
+/*!
+ * Ciclos de entrada de uma exceção no Cortex-M0+.
+ */
+const uint32_t kEntryCycles = 15;
+/*!
+ * Índice interno da exceção do SysTick, depois das 32 linhas do NVIC.
+ */
+const int kSysTickException = 32;
+const uint64_t kNever = ~0ull;
+const uintptr_t kPageSize = 0x1000;
+
+/*!
+ * Janelas mapeadas e seus deslocamentos no arquivo de memória compartilhada.
+ */
+struct Window {
+  uintptr_t base;
+  uint32_t size;
+  uint32_t offset;
+};
+const Window kWindows[] = {
+  {0x40000000, 0x100000, 0},       // AIPS: periféricos e GPIO.
+  {0xF80FF000, 0x1000, 0x100000},  // FGPIO (IOPORT).
+  {0xE000E000, 0x1000, 0x101000}   // SysTick, NVIC e SCB.
+};
+const int kWindowCount = 3;
+const uint32_t kMappedSize = 0x102000;
+
+/*!
+ * Endereços decorados do BME (AND, OR, XOR e BFI), reservados sem
+ * permissão de acesso e sem memória própria. A escrita decorada custa um
+ * ciclo a mais que um acesso comum: a leitura interna do BME.
+ */
+const uintptr_t kBMEBase = 0x44000000;
+const uint32_t kBMESize = 0x1C000000;
+const uint32_t kBMECycles = 1;
+
+const uintptr_t kSIMBase = 0x40048000;
+const uintptr_t kTPMBase = 0x40038000;
+const uintptr_t kPORTBase = 0x40049000;
+const uintptr_t kGPIOBase = 0x400FF000;
+const uintptr_t kFGPIOBase = 0xF80FF000;
+const uintptr_t kSysTickBase = 0xE000E010;
+const uintptr_t kNVICBase = 0xE000E100;
+const uintptr_t kUARTBase = 0x4006A000;
+const uintptr_t kDMABase = 0x40008100;
+const uintptr_t kDMAMUXBase = 0x40021000;
+const uintptr_t kFTFABase = 0x40020000;
+const uintptr_t kLPTMRBase = 0x40040000;
+const uintptr_t kTSIBase = 0x40045000;
+const uintptr_t kADCBase = 0x4003B000;
+const uintptr_t kLLWUBase = 0x4007C000;
+const uintptr_t kSMCBase = 0x4007E000;
+const uintptr_t kMCGBase = 0x40064000;
+const uintptr_t kCLKDIV1 = 0x40048044;
+const uintptr_t kSCR = 0xE000ED10;
+
+/*!
+ * LPO de 1 kHz do LPTMR e tempos de saída de VLPS e LLS para RUN, em ns,
+ * da tabela de transições do datasheet (indexados por Sim_t::dsf_PowerMode).
+ */
+const uint64_t kLpoHz = 1000;
+/*!
+ * Cristal de 8 MHz da placa (OSC0) e IRCs do MCG.
+ */
+const uint64_t kOscHz = 8000000;
+const uint64_t kSlowIrcHz = 32768;
+const uint64_t kFastIrcHz = 4000000;
+const uint64_t kExitNs[Sim_t::dsf_NumModes] = {0, 4400, 4600, 0};
+
+/*!
+ * Modelo de energia, com os valores típicos do datasheet a 3 V e 25 °C
+ * (código na flash). A corrente de cada modo (indexada por
+ * Sim_t::dsf_PowerMode) tem uma parte fixa e uma proporcional ao relógio
+ * do núcleo; em VLPS e LLS o relógio para e só a fixa conta.
+ */
+const double kSupplyVolts = 3.0;
+const double kModeMicroamps[Sim_t::dsf_NumModes] = {800, 4.4, 1.9, 600};
+const double kModeMicroampsPerMHz[Sim_t::dsf_NumModes] = {108, 0, 0, 65};
+
+/*!
+ * Acréscimo de cada módulo com a porta de clock ligada (SIM_SCGC4 a
+ * SIM_SCGC7), só em RUN e WAIT, e de um comando do FTFA em andamento.
+ */
+struct GateCost {
+  uintptr_t address;
+  uint32_t mask;
+  double microamps;
+};
+const GateCost kGateCosts[] = {
+  {0x40048034, 0x400, 66},        // UART0.
+  {0x40048038, 0x1, 3},           // LPTMR.
+  {0x40048038, 0x20, 47},         // TSI.
+  {0x40048038, 0x200, 8},         // PORTA.
+  {0x40048038, 0x400, 8},         // PORTB.
+  {0x40048038, 0x800, 8},         // PORTC.
+  {0x40048038, 0x1000, 8},        // PORTD.
+  {0x40048038, 0x2000, 8},        // PORTE.
+  {0x4004803C, 0x2, 10},          // DMAMUX.
+  {0x4004803C, 0x1000000, 86},    // TPM0.
+  {0x4004803C, 0x2000000, 86},    // TPM1.
+  {0x4004803C, 0x4000000, 86},    // TPM2.
+  {0x4004803C, 0x8000000, 42},    // ADC0.
+  {0x40048040, 0x100, 36}         // DMA.
+};
+const int kGateCostCount = sizeof(kGateCosts)/sizeof(kGateCosts[0]);
+const double kFlashMicroamps = 2500;
+
+/*!
+ * Cargas ligadas aos pinos: o led RGB da FRDM-KL25Z (PTB18, PTB19 e PTD1,
+ * acesos em nível baixo), com a corrente estimada pelos resistores da
+ * placa. setLoad troca ou acrescenta cargas.
+ */
+const int kMaxLoads = 8;
+
+/*!
+ * Pinos do LLWU no KL25: LLWU_Pn e o pino (GPIO*32 + pino).
+ */
+const uint8_t kWakePins[][2] = {
+  {5, 32 + 0}, {6, 64 + 1}, {7, 64 + 3}, {8, 64 + 4}, {9, 64 + 5},
+  {10, 64 + 6}, {14, 96 + 4}, {15, 96 + 6}
+};
+const int kWakePinCount = sizeof(kWakePins)/sizeof(kWakePins[0]);
+
+/*!
+ * Metade superior da flash (setores 64 a 127), mapeada do arquivo de
+ * attachFlash; o endereço 0 não pode ser mapeado no Linux. Tempos típicos
+ * dos comandos do FTFA: 65 us por palavra, 14 ms por setor e 60 us para
+ * verificar 1 KB.
+ */
+const uintptr_t kFlashBase = 0x10000;
+const uint32_t kFlashSize = 0x10000;
+const uint32_t kSectorSize = 0x400;
+const uint64_t kProgramUs = 65;
+const uint64_t kEraseUs = 14000;
+const uint64_t kVerifyUs = 60;
+
+/*!
+ * Duração de uma medida do TSI (NSCN varreduras do eletrodo), fixa no
+ * modelo; na placa ela cresce com a capacitância do eletrodo.
+ */
+const uint64_t kTsiScanUs = 250;
+
+/*!
+ * Duração da calibração do ADC0 em ciclos do ADCK, fixa no modelo, e o
+ * maior ADCK com que ela é aceita (pág. 494).
+ */
+const uint64_t kCalibrationAdck = 15000;
+const uint64_t kMaxCalibrationHz = 4000000;
+
+const int kPorts = 5;
+const int kPins = kPorts*32;
+const int kTimers = 3;
+const int kChannels = 6;
+const int kDMAChannels = 4;
+
+/*!
+ * Pinos com função de canal de TPM, decodificados de TPM_t::Pin_t.
+ */
+const TPM_t::Pin_t kTimerPins[] = {
+  TPM_t::dsf_TPM0_PTA0, TPM_t::dsf_TPM0_PTA3, TPM_t::dsf_TPM0_PTA4,
+  TPM_t::dsf_TPM0_PTA5, TPM_t::dsf_TPM0_PTC1, TPM_t::dsf_TPM0_PTC2,
+  TPM_t::dsf_TPM0_PTC3, TPM_t::dsf_TPM0_PTC4, TPM_t::dsf_TPM0_PTC8,
+  TPM_t::dsf_TPM0_PTC9, TPM_t::dsf_TPM0_PTD0, TPM_t::dsf_TPM0_PTD1,
+  TPM_t::dsf_TPM0_PTD2, TPM_t::dsf_TPM0_PTD3, TPM_t::dsf_TPM0_PTD4,
+  TPM_t::dsf_TPM0_PTD5, TPM_t::dsf_TPM0_PTE29, TPM_t::dsf_TPM0_PTE30,
+  TPM_t::dsf_TPM1_PTA12, TPM_t::dsf_TPM1_PTA13, TPM_t::dsf_TPM1_PTB0,
+  TPM_t::dsf_TPM1_PTB1, TPM_t::dsf_TPM1_PTE20, TPM_t::dsf_TPM1_PTE21,
+  TPM_t::dsf_TPM2_PTA1, TPM_t::dsf_TPM2_PTA2, TPM_t::dsf_TPM2_PTE22,
+  TPM_t::dsf_TPM2_PTE23
+};
+const int kTimerPinCount = sizeof(kTimerPins)/sizeof(kTimerPins[0]);
+
+typedef void (*Vector)(void);
+const Vector kVectors[32] = {
+  DMA0_IRQHandler, DMA1_IRQHandler, DMA2_IRQHandler, DMA3_IRQHandler, 0,
+  FTFA_IRQHandler, LVD_LVW_IRQHandler, LLW_IRQHandler, I2C0_IRQHandler,
+  I2C1_IRQHandler, SPI0_IRQHandler, SPI1_IRQHandler, UART0_IRQHandler,
+  UART1_IRQHandler, UART2_IRQHandler, ADC0_IRQHandler, CMP0_IRQHandler,
+  TPM0_IRQHandler, TPM1_IRQHandler, TPM2_IRQHandler, RTC_IRQHandler,
+  RTC_Seconds_IRQHandler, PIT_IRQHandler, 0, USB0_IRQHandler,
+  DAC0_IRQHandler, TSI0_IRQHandler, MCG_IRQHandler, LPTimer_IRQHandler, 0,
+  PORTA_IRQHandler, PORTD_IRQHandler
+};
+
+/*!
+ * Estado de um TPM. O contador é sincronizado com o tempo simulado sob
+ * demanda; residue guarda a fração de tick ainda não contada.
+ */
+struct Timer {
+  uint32_t sc;
+  uint32_t cnt;
+  uint32_t mod;
+  uint32_t modBuffer;
+  bool modPending;
+  uint32_t conf;
+  uint32_t csc[kChannels];
+  uint32_t cv[kChannels];
+  uint64_t residue;
+  uint64_t synced;
+};
+
+/*!
+ * Estado do SysTick. Enquanto habilitado, o contador é função do tempo:
+ * parte de held no ciclo origin, chega a zero e recarrega reload.
+ */
+struct Tick {
+  uint32_t csr;
+  uint32_t reload;
+  uint32_t held;
+  uint64_t origin;
+  uint64_t checked;
+};
+
+/*!
+ * Estado da UART0: BDH..C5 (S1 é calculado), registrador de deslocamento
+ * e registrador de dados ocupados e fim do byte em transmissão.
+ */
+struct Uart {
+  uint8_t reg[12];
+  bool shifting;
+  bool holding;
+  uint8_t shiftByte;
+  uint8_t holdByte;
+  uint64_t doneAt;
+};
+
+/*!
+ * Estado de um canal de DMA: SAR, DAR, DSR_BCR e DCR.
+ */
+struct Dma {
+  uint32_t sar;
+  uint32_t dar;
+  uint32_t dsr;
+  uint32_t dcr;
+};
+
+/*!
+ * Estado do FTFA: FSTAT, FCNFG e o comando em andamento. generation
+ * descarta o fim de um comando cortado por cutPower.
+ */
+struct Ftfa {
+  uint8_t fstat;
+  uint8_t fcnfg;
+  bool busy;
+  uint8_t command;
+  uint32_t address;
+  uint32_t data;
+  uint32_t generation;
+};
+
+/*!
+ * Estado do LPTMR: CSR, PSR, CMR e o CNR capturado pela última escrita.
+ * Habilitado, o contador é função do tempo: conta as bordas do LPO desde
+ * origin; checked são os ticks já examinados para o TCF.
+ */
+struct Lptmr {
+  uint32_t csr;
+  uint32_t psr;
+  uint32_t cmr;
+  uint32_t cnr;
+  uint64_t origin;
+  uint64_t checked;
+};
+
+/*!
+ * Estado do TSI0: GENCS (SCNIP e EOSF calculados pelo modelo) e DATA.
+ * generation descarta o fim de uma medida interrompida, como no FTFA;
+ * count é a contagem que cada canal devolve, dada por setTouchCount.
+ */
+struct Tsi {
+  uint32_t gencs;
+  uint32_t data;
+  bool scanning;
+  uint32_t generation;
+  uint16_t count[16];
+};
+
+/*!
+ * Estado do ADC0: SC1A a CLM0 na ordem dos endereços (COCO no SC1A, CAL e
+ * CALF no SC3; ADACT é calculado). generation descarta o fim de uma
+ * conversão abortada, como no TSI.
+ */
+struct Adc {
+  uint32_t reg[28];
+  bool converting;
+  bool calibrating;
+  uint32_t generation;
+};
+
+/*!
+ * Estado do SMC: PMPROT (escrita única), PMCTRL e STOPCTRL. O LLWU guarda
+ * PE1 a PE4, ME, F1, F2, F3, FILT1 e FILT2 na ordem dos endereços.
+ */
+struct Smc {
+  uint8_t pmprot;
+  bool locked;
+  uint8_t pmctrl;
+  uint8_t stopctrl;
+};
+
+/*!
+ * Estado do MCG: C1 a C6, S, SC e C7 a C10 na ordem dos endereços. S é
+ * derivado dos registradores de controle: o oscilador, o FLL e o PLL
+ * estabilizam no mesmo instante.
+ */
+struct Mcg {
+  uint8_t reg[16];
+};
+
+struct Action {
+  dsf_SimAction action;
+  void *argument;
+};
+
+/*!
+ * Carga de um pino (GPIO*32 + pino), acesa quando o pino é saída do GPIO
+ * com o PDOR no nível active.
+ */
+struct Load {
+  uint8_t pin;
+  uint8_t active;
+  double microamps;
+  uint64_t onCycles;
+};
+
+struct Watch {
+  uint8_t pin;
+  dsf_SimObserver observer;
+  void *argument;
+};
+
+struct State {
+  uint8_t *shadow;
+  uint64_t now;
+  uint32_t accessCycles;
+  int32_t ircErrorPpm;
+  uint64_t accesses;
+  uint64_t interrupts;
+  uint64_t stopAt;
+  bool running;
+  sigjmp_buf exitPoint;
+
+  uint32_t pcr[kPorts][32];
+  uint32_t pdor[kPorts];
+  uint32_t pddr[kPorts];
+  uint8_t drive[kPins];
+  uint8_t net[kPins];
+  uint8_t level[kPins];
+  std::vector<uint16_t> wires;
+  Timer timer[kTimers];
+  Tick sysTick;
+  bool sysTickPending;
+  uint8_t sysTickPriority;
+
+  uint32_t nvicEnabled;
+  uint32_t nvicPending;
+  uint8_t priority[32];
+  uint32_t primask;
+  bool inHandler;
+  uintptr_t interruptedPc;
+
+  bool stepping;
+  bool stepWrite;
+  uintptr_t stepAddress;
+  uint32_t stepWidth;
+  uintptr_t lastRead;
+  int repeatedReads;
+
+  std::multimap<uint64_t, Action> agenda;
+  std::vector<Watch> watches;
+
+  Uart uart;
+  Dma dma[kDMAChannels];
+  dsf_SimSerial serialReceiver;
+  void *serialArgument;
+
+  Ftfa ftfa;
+  uint8_t *flash;
+  uint32_t erases[kFlashSize/kSectorSize];
+  uint64_t noise;
+
+  Lptmr lptmr;
+  Tsi tsi;
+  Adc adc;
+  dsf_SimAnalog analogSource;
+  void *analogArgument;
+  Smc smc;
+  Mcg mcg;
+  uint8_t llwu[10];
+  uint8_t mode;
+  uint64_t modeCycles[Sim_t::dsf_NumModes];
+  uint64_t wakeups;
+  bool waiting;
+
+  double energy[Sim_t::dsf_NumParts];
+  Load loads[kMaxLoads];
+  int loadCount;
+};
+
+State st __attribute__((init_priority(101)));
+
+/*!
+ * Palavra da cópia interna que corresponde a um endereço da placa.
+ */
+volatile uint32_t *shadowWord(uintptr_t address) {
+  for (int w = 0; w < kWindowCount; w++) {
+    if (address - kWindows[w].base < kWindows[w].size) {
+      return (volatile uint32_t *)(st.shadow + kWindows[w].offset
+                                   + ((address - kWindows[w].base) & ~3u));
+    }
+  }
+  return 0;
+}
+
+bool inWindow(uintptr_t address) {
+  return shadowWord(address) != 0;
+}
+
+uint32_t readShadow(uintptr_t address) {
+  return *shadowWord(address);
+}
+
+void writeShadow(uintptr_t address, uint32_t value) {
+  *shadowWord(address) = value;
+}
+
+[[noreturn]] void busFault(uintptr_t address, const char *reason) {
+  fprintf(stderr, "dsf_Sim: hard fault at 0x%08lx (%s), cycle %llu\n",
+          (unsigned long)address, reason, (unsigned long long)st.now);
+  abort();
+}
+
+[[noreturn]] void finish() {
+  st.running = false;
+  siglongjmp(st.exitPoint, 1);
+}
+
+/*!
+ * MCG: saídas do FLL, do PLL e do IRC, relógio do núcleo e do barramento
+ * e a fonte selecionada por TPMSRC e UART0SRC. Os IRCs (e o FLL no FEI)
+ * têm o desvio de setIrcError; o cristal é exato.
+ */
+uint64_t ircError(uint64_t hz) {
+  return (uint64_t)((int64_t)hz + (int64_t)hz*st.ircErrorPpm/1000000);
+}
+
+uint64_t fllHz() {
+  const uint8_t *r = st.mcg.reg;
+  uint64_t reference;
+
+  if ((r[5] & 0x40) || (r[1] & 0x02)) {
+    return 0;
+  }
+  if (r[0] & 0x04) {
+    return ircError(kSlowIrcHz*640);
+  } else if (r[1] & 0x04) {
+    reference = kOscHz/((r[1] & 0x30) ? 32u << ((r[0] >> 3) & 7)
+                                      : 1u << ((r[0] >> 3) & 7));
+  } else {
+    return 0;
+  }
+  return reference*640;
+}
+
+uint64_t pllHz() {
+  const uint8_t *r = st.mcg.reg;
+
+  if (!(r[5] & 0x40) || !(r[1] & 0x04)) {
+    return 0;
+  }
+  return kOscHz/((r[4] & 0x1F) + 1u)*((r[5] & 0x1F) + 24u);
+}
+
+uint64_t ircHz() {
+  const uint8_t *r = st.mcg.reg;
+
+  return ircError((r[1] & 0x01) ? kFastIrcHz >> ((r[8] >> 1) & 7)
+                                 : kSlowIrcHz);
+}
+
+uint64_t mcgOutHz() {
+  const uint8_t *r = st.mcg.reg;
+
+  switch (r[0] >> 6) {
+    case 0: return (r[5] & 0x40) ? pllHz() : fllHz();
+    case 1: return ircHz();
+    case 2: return (r[1] & 0x04) ? kOscHz : 0;
+    default: return 0;
+  }
+}
+
+uint64_t coreClockHz() {
+  return mcgOutHz()/((readShadow(kCLKDIV1) >> 28) + 1);
+}
+
+uint64_t busClockHz() {
+  return coreClockHz()/(((readShadow(kCLKDIV1) >> 16) & 7) + 1);
+}
+
+/*!
+ * Fonte 1 a 3 de TPMSRC e UART0SRC: MCGFLLCLK ou MCGPLLCLK/2
+ * (PLLFLLSEL), OSCERCLK e MCGIRCLK (IRCLKEN).
+ */
+uint64_t peripheralSourceHz(uint32_t select) {
+  switch (select) {
+    case 1:
+      return (readShadow(0x40048004) & 0x10000) ? pllHz()/2 : fllHz();
+    case 2: return kOscHz;
+    case 3: return (st.mcg.reg[0] & 0x02) ? ircHz() : 0;
+    default: return 0;
+  }
+}
+
+void publishMcg() {
+  uint8_t *r = st.mcg.reg;
+  uint8_t clks = r[0] >> 6;
+  uint8_t status = 0;
+
+  status |= (r[1] & 0x04) ? 0x02 : 0;
+  status |= (uint8_t)((clks == 0 ? ((r[5] & 0x40) ? 3 : 0) : clks) << 2);
+  status |= (r[0] & 0x04) ? 0x10 : 0;
+  status |= (r[5] & 0x40) ? 0x60 : 0;
+  status |= (r[1] & 0x01) ? 0x01 : 0;
+  r[6] = status;
+  for (int w = 0; w < 16; w += 4) {
+    writeShadow(kMCGBase + w, (uint32_t)r[w] | r[w + 1] << 8
+                              | r[w + 2] << 16 | (uint32_t)r[w + 3] << 24);
+  }
+}
+
+void mcgWrite(uint32_t offset, uint8_t value) {
+  if (offset != 6) {
+    st.mcg.reg[offset] = value;
+  }
+  publishMcg();
+}
+
+/*!
+ * TPM: relógio, sincronização, overflow e publicação dos registradores.
+ */
+uint64_t timerSourceHz() {
+  /*!
+   * Nos modos de parada o MCG é desligado e os TPMs não contam.
+   */
+  if (st.mode != Sim_t::dsf_Run) {
+    return 0;
+  }
+  return peripheralSourceHz((readShadow(0x40048004) >> 24) & 3);
+}
+
+bool timerClocked(int t) {
+  return readShadow(0x4004803C) & (0x1000000u << t);
+}
+
+bool timerCounting(int t) {
+  return timerClocked(t) && ((st.timer[t].sc >> 3) & 3) == 1
+         && timerSourceHz() != 0;
+}
+
+void adcTrigger(int t, uint64_t at);
+
+void syncTimer(int t, uint64_t at) {
+  Timer &tm = st.timer[t];
+  uint64_t unit, ticks, period, count;
+
+  if (at <= tm.synced) {
+    return;
+  }
+  if (!timerCounting(t)) {
+    tm.synced = at;
+    tm.residue = 0;
+    return;
+  }
+  unit = (uint64_t)kCoreHz << (tm.sc & 7);
+  tm.residue += (at - tm.synced)*timerSourceHz();
+  tm.synced = at;
+  ticks = tm.residue/unit;
+  tm.residue -= ticks*unit;
+  if (ticks == 0) {
+    return;
+  }
+  period = (uint64_t)tm.mod + 1;
+  count = tm.cnt % period + ticks;
+  if (count >= period) {
+    tm.sc |= 0x80;
+    adcTrigger(t, at);
+    if (tm.modPending) {
+      count -= period;
+      tm.mod = tm.modBuffer;
+      tm.modPending = false;
+      period = (uint64_t)tm.mod + 1;
+    }
+  }
+  tm.cnt = (uint32_t)(count % period);
+}
+
+void syncTimers(uint64_t at) {
+  for (int t = 0; t < kTimers; t++) {
+    syncTimer(t, at);
+  }
+}
+
+uint64_t nextOverflow(int t) {
+  Timer &tm = st.timer[t];
+  uint64_t unit, source, ticks, needed;
+
+  if (!timerCounting(t)) {
+    return kNever;
+  }
+  unit = (uint64_t)kCoreHz << (tm.sc & 7);
+  source = timerSourceHz();
+  ticks = (uint64_t)tm.mod + 1 - tm.cnt % ((uint64_t)tm.mod + 1);
+  needed = ticks*unit - tm.residue;
+  return tm.synced + (needed + source - 1)/source;
+}
+
+void publishTimer(int t) {
+  Timer &tm = st.timer[t];
+  uintptr_t base = kTPMBase + 0x1000*t;
+  uint32_t status = (tm.sc & 0x80) << 1;
+
+  writeShadow(base + 0x00, tm.sc);
+  writeShadow(base + 0x04, tm.cnt);
+  writeShadow(base + 0x08, tm.modPending ? tm.modBuffer : tm.mod);
+  for (int c = 0; c < kChannels; c++) {
+    writeShadow(base + 0x0C + 8*c, tm.csc[c]);
+    writeShadow(base + 0x10 + 8*c, tm.cv[c]);
+    status |= (tm.csc[c] >> 7) << c;
+  }
+  writeShadow(base + 0x50, status);
+  writeShadow(base + 0x84, tm.conf);
+}
+
+void capture(int t, int c, int level) {
+  Timer &tm = st.timer[t];
+  uint32_t edges = (tm.csc[c] >> 2) & 3;
+
+  /*!
+   * Captura: CPWMS = 0, MSB:MSA = 00 e ELSB:ELSA = 01 (subida), 10
+   * (descida) ou 11 (ambas).
+   */
+  if (!timerClocked(t) || st.mode != Sim_t::dsf_Run || (tm.sc & 0x20)
+      || (tm.csc[c] & 0x30) || !edges) {
+    return;
+  }
+  if ((edges == 1 && !level) || (edges == 2 && level)) {
+    return;
+  }
+  syncTimer(t, st.now);
+  tm.cv[c] = tm.cnt;
+  tm.csc[c] |= 0x80;
+  publishTimer(t);
+}
+
+void timerWrite(int t, uint32_t offset, uint32_t value) {
+  Timer &tm = st.timer[t];
+  int c;
+
+  if (offset == 0x00) {
+    tm.sc = (value & 0x7F) | ((value & 0x80) ? 0 : (tm.sc & 0x80));
+    if (tm.modPending && !timerCounting(t)) {
+      tm.mod = tm.modBuffer;
+      tm.modPending = false;
+    }
+  } else if (offset == 0x04) {
+    tm.cnt = 0;
+    tm.residue = 0;
+  } else if (offset == 0x08) {
+    /*!
+     * Com o contador ligado, o novo MOD só vale a partir do próximo
+     * overflow (pág. 554).
+     */
+    if (timerCounting(t)) {
+      tm.modBuffer = value & 0xFFFF;
+      tm.modPending = true;
+    } else {
+      tm.mod = value & 0xFFFF;
+    }
+  } else if (offset >= 0x0C && offset < 0x0C + 8*kChannels) {
+    c = (offset - 0x0C)/8;
+    if ((offset - 0x0C) % 8 == 0) {
+      tm.csc[c] = (value & 0x7D) | ((value & 0x80) ? 0 : (tm.csc[c] & 0x80));
+    } else if ((tm.csc[c] & 0x30) || (tm.sc & 0x20)) {
+      tm.cv[c] = value & 0xFFFF;
+    }
+  } else if (offset == 0x50) {
+    if (value & 0x100) {
+      tm.sc &= ~0x80u;
+    }
+    for (c = 0; c < kChannels; c++) {
+      if (value & (1u << c)) {
+        tm.csc[c] &= ~0x80u;
+      }
+    }
+  } else if (offset == 0x84) {
+    tm.conf = value;
+  }
+  publishTimer(t);
+}
+
+/*!
+ * PORT e GPIO: níveis dos pinos, nós ligados e flags de interrupção.
+ */
+uint32_t pinMux(int p) {
+  return (st.pcr[p/32][p%32] >> 8) & 7;
+}
+
+uint32_t portInput(int port) {
+  uint32_t value = 0;
+
+  for (int i = 0; i < 32; i++) {
+    if (pinMux(port*32 + i) != 0 && st.level[port*32 + i]) {
+      value |= 1u << i;
+    }
+  }
+  return value;
+}
+
+void publishPorts() {
+  for (int port = 0; port < kPorts; port++) {
+    uint32_t isfr = 0;
+
+    for (int i = 0; i < 32; i++) {
+      writeShadow(kPORTBase + 0x1000*port + 4*i, st.pcr[port][i]);
+      isfr |= ((st.pcr[port][i] >> 24) & 1) << i;
+    }
+    writeShadow(kPORTBase + 0x1000*port + 0xA0, isfr);
+    uintptr_t bases[2] = {kGPIOBase + 0x40*port, kFGPIOBase + 0x40*port};
+    for (int v = 0; v < 2; v++) {
+      writeShadow(bases[v] + 0x00, st.pdor[port]);
+      writeShadow(bases[v] + 0x04, 0);
+      writeShadow(bases[v] + 0x08, 0);
+      writeShadow(bases[v] + 0x0C, 0);
+      writeShadow(bases[v] + 0x10, portInput(port));
+      writeShadow(bases[v] + 0x14, st.pddr[port]);
+    }
+  }
+}
+
+void pinEdge(int p, int level) {
+  uint32_t &pcr = st.pcr[p/32][p%32];
+  uint32_t irqc = (pcr >> 16) & 0xF;
+
+  /*!
+   * Em LLS as bordas só são vistas pelos pinos habilitados do LLWU.
+   */
+  if (st.mode == Sim_t::dsf_LLS) {
+    for (int i = 0; i < kWakePinCount; i++) {
+      uint8_t n = kWakePins[i][0];
+      uint32_t edges = (st.llwu[n/4] >> 2*(n%4)) & 3;
+      if (kWakePins[i][1] == p
+          && ((edges == 1 && level) || (edges == 2 && !level) || edges == 3)) {
+        st.llwu[5 + n/8] |= (uint8_t)(1u << n%8);
+      }
+    }
+  } else if ((irqc == 9 && level) || (irqc == 10 && !level) || irqc == 11) {
+    pcr |= PORT_PCR_ISF_MASK;
+  }
+  for (int i = 0; i < kTimerPinCount; i++) {
+    uint32_t code = kTimerPins[i];
+    if ((int)((code >> 5) & 7)*32 + (int)(code & 0x1F) == p
+        && ((code >> 13) & 7) == pinMux(p)) {
+      capture((code >> 11) & 3, (code >> 8) & 7, level);
+    }
+  }
+  for (size_t w = 0; w < st.watches.size(); w++) {
+    if (st.watches[w].pin == p) {
+      st.watches[w].observer(st.watches[w].argument, (uint8_t)(p/32),
+                             (uint8_t)(p%32), level);
+    }
+  }
+}
+
+/*!
+ * Junta os nós de dois pinos.
+ */
+void joinPins(int a, int b) {
+  uint8_t from = st.net[b];
+  uint8_t to = st.net[a];
+
+  for (int p = 0; p < kPins; p++) {
+    if (st.net[p] == from) {
+      st.net[p] = to;
+    }
+  }
+}
+
+/*!
+ * Resolve o nível de cada nó: saída GPIO, nível externo, pull up/down ou,
+ * sem nada disso, o nível anterior. Gera as bordas dos pinos que mudaram.
+ */
+void evaluatePins() {
+  int8_t netLevel[kPins];
+  uint8_t changed[kPins];
+  int count = 0;
+
+  memset(netLevel, -1, sizeof(netLevel));
+  for (int p = 0; p < kPins; p++) {
+    if (pinMux(p) == 1 && (st.pddr[p/32] >> (p%32) & 1)) {
+      netLevel[st.net[p]] = (st.pdor[p/32] >> (p%32)) & 1;
+    }
+  }
+  for (int p = 0; p < kPins; p++) {
+    if (netLevel[st.net[p]] < 0 && st.drive[p] != Sim_t::dsf_Released) {
+      netLevel[st.net[p]] = st.drive[p];
+    }
+  }
+  for (int p = 0; p < kPins; p++) {
+    uint32_t pcr = st.pcr[p/32][p%32];
+    if (netLevel[st.net[p]] < 0 && pinMux(p) != 0 && (pcr & PORT_PCR_PE_MASK)) {
+      netLevel[st.net[p]] = pcr & PORT_PCR_PS_MASK;
+    }
+  }
+  for (int p = 0; p < kPins; p++) {
+    int level = netLevel[st.net[p]];
+    if (level >= 0 && level != st.level[p]) {
+      st.level[p] = (uint8_t)level;
+      changed[count++] = (uint8_t)p;
+    }
+  }
+  for (int i = 0; i < count; i++) {
+    pinEdge(changed[i], st.level[changed[i]]);
+  }
+  /*!
+   * Interrupções por nível (IRQC 8 e 12) permanecem ativas com o nível.
+   */
+  for (int p = 0; p < kPins; p++) {
+    uint32_t &pcr = st.pcr[p/32][p%32];
+    uint32_t irqc = (pcr >> 16) & 0xF;
+    if ((irqc == 8 && !st.level[p]) || (irqc == 12 && st.level[p])) {
+      pcr |= PORT_PCR_ISF_MASK;
+    }
+  }
+  publishPorts();
+}
+
+void portWrite(int port, uint32_t offset, uint32_t value) {
+  uint32_t *pcr = st.pcr[port];
+
+  if (offset < 0x80) {
+    uint32_t &reg = pcr[offset/4];
+    reg = (value & 0x000F0757)
+          | ((value & PORT_PCR_ISF_MASK) ? 0 : (reg & PORT_PCR_ISF_MASK));
+  } else if (offset == 0x80 || offset == 0x84) {
+    for (int i = 0; i < 16; i++) {
+      if (value & (0x10000u << i)) {
+        uint32_t &reg = pcr[i + (offset == 0x84 ? 16 : 0)];
+        reg = (reg & 0xFFFF0000u) | (value & 0x0757);
+      }
+    }
+  } else if (offset == 0xA0) {
+    for (int i = 0; i < 32; i++) {
+      if (value & (1u << i)) {
+        pcr[i] &= ~PORT_PCR_ISF_MASK;
+      }
+    }
+  }
+  evaluatePins();
+}
+
+void gpioWrite(int port, uint32_t offset, uint32_t value) {
+  switch (offset) {
+    case 0x00: st.pdor[port] = value; break;
+    case 0x04: st.pdor[port] |= value; break;
+    case 0x08: st.pdor[port] &= ~value; break;
+    case 0x0C: st.pdor[port] ^= value; break;
+    case 0x14: st.pddr[port] = value; break;
+    default: break;
+  }
+  evaluatePins();
+}
+
+/*!
+ * SysTick: contador decrescente de 24 bits, com o relógio do núcleo
+ * (CLKSOURCE = 1) ou do núcleo/16. O ponto de partida é refeito a cada
+ * mudança do relógio do núcleo.
+ */
+uint64_t sysTickElapsed() {
+  return (st.now - st.sysTick.origin)*coreClockHz()/kCoreHz
+         /((st.sysTick.csr & 4) ? 1 : 16);
+}
+
+uint32_t sysTickValue() {
+  Tick &tick = st.sysTick;
+  uint64_t elapsed = sysTickElapsed();
+
+  if (!(tick.csr & 1) || elapsed <= tick.held) {
+    return (tick.csr & 1) ? tick.held - (uint32_t)elapsed : tick.held;
+  }
+  if (tick.reload == 0) {
+    return 0;
+  }
+  return tick.reload - (uint32_t)((elapsed - tick.held - 1)
+                                  % ((uint64_t)tick.reload + 1));
+}
+
+/*!
+ * Número de vezes que o contador chegou a zero após elapsed ticks.
+ */
+uint64_t sysTickZeros(uint64_t elapsed) {
+  Tick &tick = st.sysTick;
+  uint64_t first = tick.held ? tick.held : (uint64_t)tick.reload + 1;
+
+  if (elapsed < first || (tick.reload == 0 && tick.held == 0)) {
+    return 0;
+  }
+  if (tick.reload == 0) {
+    return 1;
+  }
+  return (elapsed - first)/((uint64_t)tick.reload + 1) + 1;
+}
+
+void syncSysTick() {
+  Tick &tick = st.sysTick;
+  uint64_t elapsed;
+
+  if (!(tick.csr & 1)) {
+    return;
+  }
+  elapsed = sysTickElapsed();
+  if (sysTickZeros(elapsed) > sysTickZeros(tick.checked)) {
+    tick.csr |= 0x10000;
+    if (tick.csr & 2) {
+      st.sysTickPending = true;
+    }
+  }
+  tick.checked = elapsed;
+}
+
+uint64_t nextSysTickZero() {
+  Tick &tick = st.sysTick;
+  uint64_t divider = (tick.csr & 4) ? 1 : 16;
+  uint64_t first = tick.held ? tick.held : (uint64_t)tick.reload + 1;
+  uint64_t elapsed, zeros;
+
+  if (!(tick.csr & 1) || tick.reload == 0 || coreClockHz() == 0) {
+    return kNever;
+  }
+  elapsed = sysTickElapsed();
+  zeros = sysTickZeros(elapsed);
+  return tick.origin + ((first + zeros*((uint64_t)tick.reload + 1))*divider
+                        *kCoreHz + coreClockHz() - 1)/coreClockHz();
+}
+
+void publishSysTick() {
+  syncSysTick();
+  writeShadow(kSysTickBase + 0x0, st.sysTick.csr);
+  writeShadow(kSysTickBase + 0x4, st.sysTick.reload);
+  writeShadow(kSysTickBase + 0x8, sysTickValue());
+  writeShadow(kSysTickBase + 0xC, 0);
+}
+
+/*!
+ * Fixa o valor atual como novo ponto de partida antes de uma escrita.
+ */
+void rebaseSysTick() {
+  syncSysTick();
+  st.sysTick.held = sysTickValue();
+  st.sysTick.origin = st.now;
+  st.sysTick.checked = 0;
+}
+
+void sysTickWrite(uint32_t offset, uint32_t value) {
+  Tick &tick = st.sysTick;
+
+  rebaseSysTick();
+  switch (offset) {
+    case 0x0: tick.csr = (tick.csr & 0x10000) | (value & 7); break;
+    case 0x4: tick.reload = value & 0xFFFFFF; break;
+    case 0x8: tick.held = 0; tick.csr &= ~0x10000u; break;
+    default: break;
+  }
+  publishSysTick();
+}
+
+/*!
+ * UART0: só o transmissor, em 8N1 (ou 2 bits de parada com SBNS), com o
+ * registrador de dados e o registrador de deslocamento. Cada byte leva
+ * (10 ou 11) x (OSR + 1) x SBR ciclos do clock da UART0.
+ */
+uint64_t uartClockHz() {
+  return peripheralSourceHz((readShadow(0x40048004) >> 26) & 3);
+}
+
+bool uartClocked() {
+  return readShadow(0x40048034) & 0x400u;
+}
+
+bool uartEnabled() {
+  return uartClocked() && (st.uart.reg[3] & 0x08) && uartClockHz() != 0;
+}
+
+uint64_t uartFrameCycles() {
+  Uart &u = st.uart;
+  uint64_t sbr = ((uint64_t)(u.reg[0] & 0x1F) << 8) | u.reg[1];
+  uint64_t bits = (u.reg[0] & 0x20) ? 11 : 10;
+
+  return bits*((u.reg[10] & 0x1F) + 1u)*(sbr ? sbr : 1)*kCoreHz/uartClockHz();
+}
+
+uint8_t uartStatus() {
+  Uart &u = st.uart;
+
+  return (uint8_t)((u.holding ? 0 : 0x80)
+                   | (u.holding || u.shifting ? 0 : 0x40));
+}
+
+void publishUart() {
+  uint8_t *r = st.uart.reg;
+
+  r[4] = uartStatus();
+  for (int w = 0; w < 12; w += 4) {
+    writeShadow(kUARTBase + w, (uint32_t)r[w] | r[w + 1] << 8
+                               | r[w + 2] << 16 | (uint32_t)r[w + 3] << 24);
+  }
+}
+
+void dmaService();
+void publishAdc();
+
+void uartShiftDone(void *) {
+  Uart &u = st.uart;
+
+  if (!u.shifting || st.now < u.doneAt) {
+    return;
+  }
+  if (st.serialReceiver) {
+    st.serialReceiver(st.serialArgument, u.shiftByte);
+  }
+  u.shifting = false;
+  if (u.holding && uartEnabled()) {
+    u.holding = false;
+    u.shifting = true;
+    u.shiftByte = u.holdByte;
+    u.doneAt = st.now + uartFrameCycles();
+    dsf_Sim::schedule(u.doneAt, uartShiftDone, 0);
+  }
+  dmaService();
+}
+
+/*!
+ * Escrita no UART0_D, pela CPU ou pelo DMA.
+ */
+void uartData(uint8_t value) {
+  Uart &u = st.uart;
+
+  if (!uartEnabled()) {
+    return;
+  }
+  if (!u.shifting) {
+    u.shifting = true;
+    u.shiftByte = value;
+    u.doneAt = st.now + uartFrameCycles();
+    dsf_Sim::schedule(u.doneAt, uartShiftDone, 0);
+  } else {
+    u.holding = true;
+    u.holdByte = value;
+  }
+}
+
+void uartWrite(uint32_t offset, uint8_t value) {
+  Uart &u = st.uart;
+
+  if (offset == 4 || offset >= 12) {
+    return;
+  }
+  if (offset == 7) {
+    uartData(value);
+  } else {
+    u.reg[offset] = value;
+  }
+  if (!(u.reg[3] & 0x08)) {
+    u.shifting = false;
+    u.holding = false;
+  }
+  dmaService();
+  publishUart();
+}
+
+/*!
+ * DMA: quatro canais em roubo de ciclo, atendidos pela requisição de
+ * transmissor vazio da UART0 (fonte 3 do DMAMUX) e pelo fim de conversão
+ * do ADC0 (fonte 40). Cada requisição move uma unidade de SSIZE da origem
+ * para o destino, com SMOD e DMOD.
+ */
+bool dmaClocked() {
+  return (readShadow(0x40048040) & 0x100u) && (readShadow(0x4004803C) & 2u);
+}
+
+void publishDma() {
+  for (int c = 0; c < kDMAChannels; c++) {
+    Dma &d = st.dma[c];
+    writeShadow(kDMABase + 0x10*c + 0x0, d.sar);
+    writeShadow(kDMABase + 0x10*c + 0x4, d.dar);
+    writeShadow(kDMABase + 0x10*c + 0x8, d.dsr);
+    writeShadow(kDMABase + 0x10*c + 0xC, d.dcr);
+  }
+}
+
+uint32_t dmaUnit(uint32_t size) {
+  return size == 1 ? 1 : size == 2 ? 2 : 4;
+}
+
+uint32_t dmaStep(uint32_t address, uint32_t unit, uint32_t mod) {
+  uint32_t window;
+
+  if (mod == 0) {
+    return address + unit;
+  }
+  window = 16u << (mod - 1);
+  return (address & ~(window - 1)) | ((address + unit) & (window - 1));
+}
+
+uint32_t dmaRead(uint32_t address, uint32_t unit) {
+  uint32_t word;
+
+  if (inWindow(address)) {
+    word = readShadow(address) >> 8*(address & 3);
+  } else if (unit == 1) {
+    word = *(volatile uint8_t *)(uintptr_t)address;
+  } else if (unit == 2) {
+    word = *(volatile uint16_t *)(uintptr_t)address;
+  } else {
+    word = *(volatile uint32_t *)(uintptr_t)address;
+  }
+  /*!
+   * A leitura do RA apaga o COCO e, com ele, a requisição do ADC0.
+   */
+  if (address - (kADCBase + 0x10) < 4u) {
+    st.adc.reg[0] &= ~0x80u;
+  }
+  return unit == 4 ? word : word & ((1u << 8*unit) - 1);
+}
+
+void dmaWriteUnit(uint32_t address, uint32_t unit, uint32_t value) {
+  if (address == kUARTBase + 7) {
+    uartData((uint8_t)value);
+  } else if (unit == 1) {
+    *(volatile uint8_t *)(uintptr_t)address = (uint8_t)value;
+  } else if (unit == 2) {
+    *(volatile uint16_t *)(uintptr_t)address = (uint16_t)value;
+  } else {
+    *(volatile uint32_t *)(uintptr_t)address = value;
+  }
+}
+
+bool dmaRequest(int c) {
+  uint8_t mux = (uint8_t)(readShadow(kDMAMUXBase) >> 8*c);
+  Uart &u = st.uart;
+
+  if (!(mux & 0x80)) {
+    return false;
+  }
+  if ((mux & 0x3F) == 40) {
+    return (st.adc.reg[8] & 0x4) && (st.adc.reg[0] & 0x80);
+  }
+  if ((mux & 0x3F) != 3) {
+    return false;
+  }
+  return uartEnabled() && (u.reg[11] & 0x80) && (u.reg[3] & 0x80)
+         && !u.holding;
+}
+
+void dmaService() {
+  bool moved = false;
+
+  if (!dmaClocked()) {
+    return;
+  }
+  for (int c = 0; c < kDMAChannels; c++) {
+    Dma &d = st.dma[c];
+    while ((d.dcr & 0x40000000u) && (d.dsr & 0xFFFFFF) != 0
+           && !(d.dsr & 0x40000000u) && dmaRequest(c)) {
+      uint32_t unit = dmaUnit((d.dcr >> 20) & 3);
+      dmaWriteUnit(d.dar, dmaUnit((d.dcr >> 17) & 3), dmaRead(d.sar, unit));
+      if (d.dcr & 0x400000u) {
+        d.sar = dmaStep(d.sar, unit, (d.dcr >> 12) & 0xF);
+      }
+      if (d.dcr & 0x80000u) {
+        d.dar = dmaStep(d.dar, dmaUnit((d.dcr >> 17) & 3), (d.dcr >> 8) & 0xF);
+      }
+      d.dsr -= unit;
+      if ((d.dsr & 0xFFFFFF) == 0) {
+        d.dsr |= 0x1000000u;
+        if (d.dcr & 0x80) {
+          d.dcr &= ~0x40000000u;
+        }
+      }
+      moved = true;
+    }
+  }
+  if (moved) {
+    publishDma();
+    publishUart();
+    publishAdc();
+  }
+}
+
+/*!
+ * Requisição nova de uma fonte do DMAMUX. Com o contador zerado ela é um
+ * erro de configuração (CE, pág. 350): o canal liga DONE e não transfere
+ * até a escrita de DONE. Senão ela é atendida por dmaService.
+ */
+void dmaSignal(uint32_t source) {
+  if (!dmaClocked()) {
+    return;
+  }
+  for (int c = 0; c < kDMAChannels; c++) {
+    Dma &d = st.dma[c];
+    uint8_t mux = (uint8_t)(readShadow(kDMAMUXBase) >> 8*c);
+    if (mux == (0x80 | source) && (d.dcr & 0x40000000u)
+        && (d.dsr & 0xFFFFFF) == 0) {
+      d.dsr |= 0x41000000u;
+    }
+  }
+  dmaService();
+  publishDma();
+}
+
+void dmaWrite(int c, uint32_t offset, uint32_t value) {
+  Dma &d = st.dma[c];
+
+  switch (offset) {
+    case 0x0: d.sar = value; break;
+    case 0x4: d.dar = value; break;
+    case 0x8:
+      if (value & 0x1000000u) {
+        d.dsr &= 0xFFFFFF;
+      }
+      d.dsr = (d.dsr & ~0xFFFFFFu) | (value & 0xFFFFFF);
+      break;
+    case 0xC: d.dcr = value & ~0x10000u; break;
+    default: break;
+  }
+  dmaService();
+  publishDma();
+}
+
+/*!
+ * ADC0: conversões únicas no canal de ADCH, iniciadas pela escrita no SC1A
+ * (ADTRG = 0) ou pelo overflow do TPM escolhido no SIM_SOPT7
+ * (ADC0ALTTRGEN e ADC0TRGSEL = 8 + TPM). Cada conversão leva o tempo do
+ * manual para a resolução e a média, sem amostragem longa: 3 ADCK e 5
+ * ciclos do barramento mais 17, 20 ou 25 ADCK por conversão somada. O RA
+ * recebe o valor de 16 bits da fonte de setAnalogSource, uma vez por
+ * amostra, na resolução de MODE; um disparo durante a conversão é
+ * ignorado. O COCO pede ADC0 com AIEN e o DMA (fonte 40) com DMAEN, e é
+ * apagado pela leitura do RA ou pela escrita no SC1A; uma conversão que
+ * termina com o COCO ligado sobrescreve o RA.
+ *
+ * A calibração leva kCalibrationAdck ciclos do ADCK, liga CALF se o ADCK
+ * passa de 4 MHz e mantém nos CLPx e CLMx os valores de reset. Com
+ * ADTRG = 1 ela falha de imediato. ALTCLK, ADACK, o canal B e a
+ * comparação não são simulados: com eles as conversões não começam e a
+ * calibração falha.
+ */
+bool adcClocked() {
+  return readShadow(0x4004803C) & 0x8000000u;
+}
+
+uint64_t adcClockHz() {
+  uint32_t cfg1 = st.adc.reg[2];
+
+  if ((cfg1 & 3) > 1) {
+    return 0;
+  }
+  return (busClockHz() >> (cfg1 & 3)) >> ((cfg1 >> 5) & 3);
+}
+
+uint64_t adcConversionCycles() {
+  static const uint64_t kBaseAdck[4] = {17, 20, 20, 25};
+  uint32_t sc3 = st.adc.reg[9];
+  uint64_t average = (sc3 & 4) ? 4u << (sc3 & 3) : 1;
+  uint64_t adck = 3 + average*kBaseAdck[(st.adc.reg[2] >> 2) & 3];
+
+  return adck*kCoreHz/adcClockHz() + 5*kCoreHz/busClockHz();
+}
+
+void publishAdc() {
+  Adc &a = st.adc;
+
+  for (int r = 0; r < 28; r++) {
+    writeShadow(kADCBase + 4*r, a.reg[r]);
+  }
+  if (a.converting || a.calibrating) {
+    writeShadow(kADCBase + 0x20, a.reg[8] | 0x80);
+  }
+}
+
+void adcDone(void *argument) {
+  static const uint32_t kShift[4] = {8, 4, 6, 0};
+  Adc &a = st.adc;
+  uint16_t value = 0;
+
+  if (!a.converting || (uint32_t)(uintptr_t)argument != a.generation) {
+    return;
+  }
+  a.converting = false;
+  if (st.analogSource) {
+    value = st.analogSource(st.analogArgument, (uint8_t)(a.reg[0] & 0x1F));
+  }
+  a.reg[4] = (uint32_t)value >> kShift[(a.reg[2] >> 2) & 3];
+  a.reg[0] |= 0x80;
+  publishAdc();
+  if (a.reg[8] & 0x4) {
+    dmaSignal(40);
+  }
+}
+
+void adcStart(uint64_t at) {
+  Adc &a = st.adc;
+
+  if (!adcClocked() || a.converting || a.calibrating
+      || (a.reg[0] & 0x1F) == 0x1F || adcClockHz() == 0) {
+    return;
+  }
+  a.converting = true;
+  dsf_Sim::schedule(at + adcConversionCycles(), adcDone,
+                    (void *)(uintptr_t)++a.generation);
+  publishAdc();
+}
+
+void adcTrigger(int t, uint64_t at) {
+  uint32_t sopt7 = readShadow(0x40048018);
+
+  if ((st.adc.reg[8] & 0x40) && (sopt7 & 0x80) && (sopt7 & 0xF) == 8u + t) {
+    adcStart(at);
+  }
+}
+
+void adcCalibrated(void *argument) {
+  Adc &a = st.adc;
+
+  if (!a.calibrating || (uint32_t)(uintptr_t)argument != a.generation) {
+    return;
+  }
+  a.calibrating = false;
+  a.reg[9] &= ~0x80u;
+  if (adcClockHz() > kMaxCalibrationHz) {
+    a.reg[9] |= 0x40;
+  }
+  a.reg[0] |= 0x80;
+  publishAdc();
+}
+
+void adcCalibrate() {
+  Adc &a = st.adc;
+
+  if ((a.reg[8] & 0x40) || adcClockHz() == 0) {
+    a.reg[9] = (a.reg[9] & ~0x80u) | 0x40;
+    a.reg[0] |= 0x80;
+    return;
+  }
+  a.converting = false;
+  a.calibrating = true;
+  a.reg[9] |= 0x80;
+  dsf_Sim::schedule(st.now + kCalibrationAdck*kCoreHz/adcClockHz(),
+                    adcCalibrated, (void *)(uintptr_t)++a.generation);
+}
+
+void adcWrite(uint32_t offset, uint32_t value) {
+  Adc &a = st.adc;
+
+  if (offset == 0x00) {
+    a.reg[0] = value & 0x7F;
+    if (!a.calibrating) {
+      a.converting = false;
+      a.generation++;
+      if (!(a.reg[8] & 0x40)) {
+        adcStart(st.now);
+      }
+    }
+  } else if (offset == 0x20) {
+    a.reg[8] = value & 0x7F;
+  } else if (offset == 0x24) {
+    /*!
+     * CALF é write-1-to-clear; CAL fica ligado até o fim da calibração.
+     */
+    a.reg[9] = (value & 0x0F) | (a.reg[9] & 0x40 & ~value)
+               | (a.calibrating ? 0x80 : 0);
+    if ((value & 0x80) && !a.calibrating) {
+      adcCalibrate();
+    }
+  } else if (offset != 0x10 && offset != 0x14) {
+    a.reg[offset/4] = value;
+  }
+  publishAdc();
+  /*!
+   * A requisição segue o COCO: DMAEN ligado com o COCO pendente pede o DMA.
+   */
+  dmaService();
+}
+
+/*!
+ * FTFA: Read 1s Section, Program Longword e Erase Flash Sector sobre a
+ * janela da flash. O comando leva o tempo típico; CCIF fica em 0 até o
+ * fim e os bits gravados só passam de 1 para 0.
+ */
+bool flashClocked() {
+  return readShadow(0x4004803C) & 1u;
+}
+
+void publishFtfa() {
+  writeShadow(kFTFABase, (uint32_t)st.ftfa.fstat | st.ftfa.fcnfg << 8
+                         | 0xFFFE0000u);
+}
+
+uint8_t *flashByte(uint32_t address) {
+  return st.flash + (address - kFlashBase);
+}
+
+bool inFlash(uint32_t address, uint32_t size) {
+  return st.flash && address >= kFlashBase
+         && address - kFlashBase + (uint64_t)size <= kFlashSize;
+}
+
+/*!
+ * Ruído reprodutível para os resultados parciais de cutPower.
+ */
+uint64_t nextNoise() {
+  st.noise ^= st.noise << 13;
+  st.noise ^= st.noise >> 7;
+  st.noise ^= st.noise << 17;
+  return st.noise;
+}
+
+void ftfaDone(void *argument) {
+  Ftfa &f = st.ftfa;
+  bool blank = true;
+
+  if (!f.busy || (uint32_t)(uintptr_t)argument != f.generation) {
+    return;
+  }
+  if (f.command == 0x06) {
+    for (int i = 0; i < 4; i++) {
+      uint8_t *cell = flashByte(f.address + i);
+      *cell &= (uint8_t)(f.data >> 8*i);
+      blank = blank && *cell == (uint8_t)(f.data >> 8*i);
+    }
+  } else if (f.command == 0x09) {
+    memset(flashByte(f.address), 0xFF, kSectorSize);
+    st.erases[(f.address - kFlashBase)/kSectorSize]++;
+  } else {
+    for (uint32_t i = 0; i < 4*(f.data >> 16); i++) {
+      blank = blank && *flashByte(f.address + i) == 0xFF;
+    }
+  }
+  f.busy = false;
+  f.fstat |= 0x80 | (blank ? 0 : 0x01);
+  publishFtfa();
+}
+
+/*!
+ * Lança o comando do FCCOB: o código no FCCOB0 (+7), o endereço no FCCOB1
+ * a FCCOB3 (+6 a +4) e FCCOB4 a FCCOB7 na palavra em +8.
+ */
+void ftfaLaunch() {
+  Ftfa &f = st.ftfa;
+  uint32_t words = readShadow(kFTFABase + 4);
+  uint64_t us;
+  bool valid;
+
+  f.command = (uint8_t)(words >> 24);
+  f.address = words & 0xFFFFFF;
+  f.data = readShadow(kFTFABase + 8);
+  f.fstat &= ~0x01u;
+  switch (f.command) {
+    case 0x01:
+      valid = (f.address & 3) == 0 && (f.data >> 16) != 0
+              && inFlash(f.address, 4*(f.data >> 16));
+      us = kVerifyUs*4*(f.data >> 16)/kSectorSize + 1;
+      break;
+    case 0x06:
+      valid = (f.address & 3) == 0 && inFlash(f.address, 4);
+      us = kProgramUs;
+      break;
+    case 0x09:
+      valid = (f.address & (kSectorSize - 1)) == 0
+              && inFlash(f.address, kSectorSize);
+      us = kEraseUs;
+      break;
+    default:
+      valid = false;
+      us = 0;
+      break;
+  }
+  /*!
+   * Em VLPR a flash só pode ser lida.
+   */
+  if (!valid || ((st.smc.pmctrl >> 5) & 3) == 2) {
+    f.fstat |= 0x20;
+    return;
+  }
+  f.busy = true;
+  f.fstat &= ~0x80u;
+  dsf_Sim::schedule(st.now + us*kCoreHz/1000000, ftfaDone,
+                    (void *)(uintptr_t)++f.generation);
+}
+
+void ftfaWrite(uint32_t offset, uint8_t value) {
+  Ftfa &f = st.ftfa;
+
+  if (offset == 0) {
+    f.fstat &= (uint8_t)~(value & 0x70);
+    if ((value & 0x80) && !f.busy && !(f.fstat & 0x30)) {
+      ftfaLaunch();
+    }
+  } else if (offset == 1) {
+    f.fcnfg = value & 0xC0;
+  }
+  publishFtfa();
+}
+
+/*!
+ * TSI: com TSIEN, uma medida começa pela escrita de SWTS no DATA (STM =
+ * 0) ou a cada comparação do LPTMR (STM = 1), no canal de TSICH, e
+ * termina kTsiScanUs depois com a contagem do canal no TSICNT e EOSF. A
+ * interrupção de fim de varredura (ESOR = 1) pede TSI0 com TSIIEN. Os
+ * limites de fora de faixa e o DMA não são simulados.
+ */
+bool tsiClocked() {
+  return readShadow(0x40048038) & SIM_SCGC5_TSI_MASK;
+}
+
+void publishTsi() {
+  writeShadow(kTSIBase + 0x0, st.tsi.gencs | (st.tsi.scanning ? 0x8u : 0));
+  writeShadow(kTSIBase + 0x4, st.tsi.data);
+}
+
+void tsiDone(void *argument) {
+  Tsi &t = st.tsi;
+
+  if (!t.scanning || (uint32_t)(uintptr_t)argument != t.generation) {
+    return;
+  }
+  t.scanning = false;
+  t.data = (t.data & ~0xFFFFu) | t.count[t.data >> 28];
+  t.gencs |= 0x4u;
+  publishTsi();
+}
+
+void tsiScan() {
+  Tsi &t = st.tsi;
+
+  if (!tsiClocked() || !(t.gencs & 0x80) || t.scanning) {
+    return;
+  }
+  t.scanning = true;
+  dsf_Sim::schedule(st.now + kTsiScanUs*kCoreHz/1000000, tsiDone,
+                    (void *)(uintptr_t)++t.generation);
+}
+
+void tsiWrite(uint32_t offset, uint32_t value) {
+  Tsi &t = st.tsi;
+
+  if (offset == 0x0) {
+    /*!
+     * EOSF e OUTRGF são write-1-to-clear; TSIEN em 0 interrompe a medida.
+     */
+    t.gencs = (value & ~0x8000000Cu) | (t.gencs & 0x4u & ~value);
+    if (!(t.gencs & 0x80)) {
+      t.scanning = false;
+    }
+  } else if (offset == 0x4) {
+    t.data = (value & 0xF0800000u) | (t.data & 0xFFFFu);
+    if ((value & (1u << 22)) && !(t.gencs & 0x10)) {
+      tsiScan();
+    }
+  }
+  publishTsi();
+}
+
+/*!
+ * LPTMR: contador de 16 bits do LPO (PCS = 1), com ou sem prescaler. Com
+ * TFC = 0 o contador volta a zero na comparação (período CMR + 1); com
+ * TFC = 1 ele conta livre e TCF liga a cada 65536 ticks. As demais fontes
+ * de clock não são simuladas e o contador fica parado.
+ */
+bool lptmrClocked() {
+  return readShadow(0x40048038) & 1u;
+}
+
+bool lptmrCounting() {
+  return lptmrClocked() && (st.lptmr.csr & 1) && (st.lptmr.psr & 3) == 1;
+}
+
+uint64_t lpoEdges(uint64_t at) {
+  return at*kLpoHz/kCoreHz;
+}
+
+uint32_t lptmrShift() {
+  return (st.lptmr.psr & 4) ? 0 : ((st.lptmr.psr >> 3) & 0xF) + 1;
+}
+
+uint64_t lptmrTicks(uint64_t at) {
+  return (lpoEdges(at) - lpoEdges(st.lptmr.origin)) >> lptmrShift();
+}
+
+uint64_t lptmrMatches(uint64_t ticks) {
+  Lptmr &l = st.lptmr;
+
+  if (!(l.csr & 4)) {
+    return ticks/((uint64_t)l.cmr + 1);
+  }
+  return ticks > l.cmr ? (ticks - l.cmr - 1)/0x10000 + 1 : 0;
+}
+
+uint32_t lptmrCount(uint64_t ticks) {
+  Lptmr &l = st.lptmr;
+
+  return (uint32_t)((l.csr & 4) ? ticks & 0xFFFF
+                                : ticks % ((uint64_t)l.cmr + 1));
+}
+
+void syncLptmr() {
+  Lptmr &l = st.lptmr;
+  uint64_t ticks;
+
+  if (!lptmrCounting()) {
+    return;
+  }
+  ticks = lptmrTicks(st.now);
+  if (lptmrMatches(ticks) > lptmrMatches(l.checked)) {
+    l.csr |= 0x80;
+    /*!
+     * A comparação é o disparo por hardware do TSI.
+     */
+    if (st.tsi.gencs & 0x10) {
+      tsiScan();
+    }
+  }
+  l.checked = ticks;
+}
+
+uint64_t nextLptmrMatch() {
+  Lptmr &l = st.lptmr;
+  uint64_t match, ticks, edge;
+
+  if (!lptmrCounting()) {
+    return kNever;
+  }
+  match = lptmrMatches(l.checked) + 1;
+  ticks = (l.csr & 4) ? l.cmr + 1 + (match - 1)*0x10000
+                      : match*((uint64_t)l.cmr + 1);
+  edge = lpoEdges(l.origin) + (ticks << lptmrShift());
+  return (edge*kCoreHz + kLpoHz - 1)/kLpoHz;
+}
+
+void publishLptmr() {
+  syncLptmr();
+  writeShadow(kLPTMRBase + 0x0, st.lptmr.csr);
+  writeShadow(kLPTMRBase + 0x4, st.lptmr.psr);
+  writeShadow(kLPTMRBase + 0x8, st.lptmr.cmr);
+  writeShadow(kLPTMRBase + 0xC, st.lptmr.cnr);
+}
+
+void lptmrWrite(uint32_t offset, uint32_t value) {
+  Lptmr &l = st.lptmr;
+
+  syncLptmr();
+  if (offset == 0x0) {
+    /*!
+     * TEN em 0 zera o contador e o TCF; TCF é write-1-to-clear.
+     */
+    if ((value & 1) && !(l.csr & 1)) {
+      l.origin = st.now;
+      l.checked = 0;
+    }
+    l.csr = (value & 0x7F) | ((value & 0x80) ? 0 : (l.csr & 0x80));
+    if (!(l.csr & 1)) {
+      l.csr &= ~0x80u;
+      l.cnr = 0;
+    }
+    if (!(l.csr & 0x80)) {
+      st.llwu[7] &= ~1u;
+    }
+  } else if (offset == 0x4) {
+    l.psr = value & 0x7F;
+  } else if (offset == 0x8) {
+    l.cmr = value & 0xFFFF;
+  } else if (offset == 0xC) {
+    l.cnr = lptmrCounting() ? lptmrCount(lptmrTicks(st.now)) : 0;
+  }
+  publishLptmr();
+}
+
+/*!
+ * SMC e LLWU: PMPROT libera os modos de parada uma vez após o reset e
+ * STOPM só aceita um modo liberado. O modo de parada é o de STOPM quando
+ * o WFI é executado com SLEEPDEEP; STOP é tratado como VLPS. RUNM só
+ * aceita VLPR com o núcleo até 4 MHz e o barramento até 1 MHz.
+ */
+void publishSmc() {
+  uint8_t pmstat = ((st.smc.pmctrl >> 5) & 3) == 2 ? 0x04 : 0x01;
+
+  writeShadow(kSMCBase, (uint32_t)st.smc.pmprot | st.smc.pmctrl << 8
+                        | st.smc.stopctrl << 16 | (uint32_t)pmstat << 24);
+}
+
+void smcWrite(uint32_t offset, uint8_t value) {
+  Smc &smc = st.smc;
+  uint8_t stopm = value & 7;
+  uint8_t runm = (value >> 5) & 3;
+
+  if (offset == 0 && !smc.locked) {
+    smc.pmprot = value & 0x2A;
+    smc.locked = true;
+  } else if (offset == 1) {
+    if ((stopm == 2 || runm == 2) && !(smc.pmprot & 0x20)) {
+      return;
+    }
+    if (runm == 2 && (coreClockHz() > 4000000 || busClockHz() > 1000000)) {
+      return;
+    }
+    if ((stopm == 3 && !(smc.pmprot & 0x08))
+        || (stopm == 4 && !(smc.pmprot & 0x02))) {
+      return;
+    }
+    smc.pmctrl = (uint8_t)((smc.pmctrl & 0x08) | runm << 5 | stopm);
+  } else if (offset == 2) {
+    smc.stopctrl = value & 0xE7;
+  }
+  publishSmc();
+}
+
+void publishLlwu() {
+  for (int w = 0; w < 12; w += 4) {
+    uint32_t word = 0;
+    for (int b = 0; b < 4 && w + b < 10; b++) {
+      word |= (uint32_t)st.llwu[w + b] << 8*b;
+    }
+    writeShadow(kLLWUBase + w, word);
+  }
+}
+
+void llwuWrite(uint32_t offset, uint8_t value) {
+  if (offset < 5 || offset == 8 || offset == 9) {
+    st.llwu[offset] = value;
+  } else if (offset == 5 || offset == 6) {
+    st.llwu[offset] &= (uint8_t)~value;
+  }
+  publishLlwu();
+}
+
+/*!
+ * NVIC: linhas de interrupção dos periféricos, habilitação e prioridade.
+ */
+void publishNvic() {
+  writeShadow(kNVICBase + 0x000, st.nvicEnabled);
+  writeShadow(kNVICBase + 0x080, st.nvicEnabled);
+  writeShadow(kNVICBase + 0x100, st.nvicPending);
+  writeShadow(kNVICBase + 0x180, st.nvicPending);
+  for (int i = 0; i < 8; i++) {
+    writeShadow(kNVICBase + 0x300 + 4*i,
+                (uint32_t)st.priority[4*i] | st.priority[4*i + 1] << 8
+                | st.priority[4*i + 2] << 16
+                | (uint32_t)st.priority[4*i + 3] << 24);
+  }
+}
+
+void nvicWrite(uint32_t offset, uint32_t value) {
+  if (offset == 0x000) {
+    st.nvicEnabled |= value;
+  } else if (offset == 0x080) {
+    st.nvicEnabled &= ~value;
+  } else if (offset == 0x100) {
+    st.nvicPending |= value;
+  } else if (offset == 0x180) {
+    st.nvicPending &= ~value;
+  } else if (offset >= 0x300 && offset < 0x320) {
+    for (int i = 0; i < 4; i++) {
+      st.priority[offset - 0x300 + i] = (uint8_t)((value >> 8*i) & 0xC0);
+    }
+  }
+  publishNvic();
+}
+
+uint32_t irqLines() {
+  uint32_t lines = 0;
+
+  for (int t = 0; t < kTimers; t++) {
+    Timer &tm = st.timer[t];
+    if (!timerClocked(t)) {
+      continue;
+    }
+    if ((tm.sc & 0xC0) == 0xC0) {
+      lines |= 1u << (TPM0_IRQn + t);
+    }
+    for (int c = 0; c < kChannels; c++) {
+      if ((tm.csc[c] & 0xC0) == 0xC0) {
+        lines |= 1u << (TPM0_IRQn + t);
+      }
+    }
+  }
+  for (int i = 0; i < 32; i++) {
+    uint32_t irqc;
+    irqc = (st.pcr[0][i] >> 16) & 0xF;
+    if ((st.pcr[0][i] & PORT_PCR_ISF_MASK) && irqc >= 8 && irqc <= 12) {
+      lines |= 1u << PORTA_IRQn;
+    }
+    irqc = (st.pcr[3][i] >> 16) & 0xF;
+    if ((st.pcr[3][i] & PORT_PCR_ISF_MASK) && irqc >= 8 && irqc <= 12) {
+      lines |= 1u << PORTD_IRQn;
+    }
+  }
+  for (int c = 0; c < kDMAChannels; c++) {
+    if ((st.dma[c].dsr & 0x1000000u) && (st.dma[c].dcr & 0x80000000u)) {
+      lines |= 1u << (DMA0_IRQn + c);
+    }
+  }
+  /*!
+   * UART0 sem DMA: TIE com o registrador de dados vazio e TCIE com a
+   * transmissão completa.
+   */
+  if (uartEnabled() && !(st.uart.reg[11] & 0x80)
+      && (((st.uart.reg[3] & 0x80) && (uartStatus() & 0x80))
+          || ((st.uart.reg[3] & 0x40) && (uartStatus() & 0x40)))) {
+    lines |= 1u << UART0_IRQn;
+  }
+  if ((st.ftfa.fcnfg & 0x80) && (st.ftfa.fstat & 0x80)) {
+    lines |= 1u << FTFA_IRQn;
+  }
+  syncLptmr();
+  if ((st.lptmr.csr & 0xC0) == 0xC0) {
+    lines |= 1u << LPTimer_IRQn;
+  }
+  if ((st.tsi.gencs & 0x100000C4u) == 0x100000C4u) {
+    lines |= 1u << TSI0_IRQn;
+  }
+  if ((st.adc.reg[0] & 0xC0) == 0xC0) {
+    lines |= 1u << ADC0_IRQn;
+  }
+  if (st.llwu[5] | st.llwu[6] | st.llwu[7]) {
+    lines |= 1u << LLW_IRQn;
+  }
+  return lines;
+}
+
+/*!
+ * Próxima exceção a entregar: a linha de maior prioridade ou
+ * kSysTickException. Com a mesma prioridade vence o menor número de
+ * exceção, que é o do SysTick (15).
+ */
+int nextIrq() {
+  uint32_t active = (irqLines() | st.nvicPending) & st.nvicEnabled;
+  int best = -1;
+
+  for (int i = 0; i < 32; i++) {
+    if ((active >> i & 1) && (best < 0 || st.priority[i] < st.priority[best])) {
+      best = i;
+    }
+  }
+  /*!
+   * O SysTick para com o relógio do núcleo nos modos de parada.
+   */
+  if (st.mode == Sim_t::dsf_Run) {
+    syncSysTick();
+  }
+  if (st.sysTickPending
+      && (best < 0 || st.sysTickPriority <= st.priority[best])) {
+    best = kSysTickException;
+  }
+  return best;
+}
+
+bool deliverable() {
+  return st.running && !st.inHandler && !st.primask && nextIrq() >= 0;
+}
+
+/*!
+ * Energia: a corrente é constante entre dois instantes em que o tempo
+ * avança, pois os registradores só mudam nos acessos e nas ações.
+ */
+bool loadOn(const Load &load) {
+  int port = load.pin/32;
+  uint32_t bit = 1u << (load.pin % 32);
+
+  return pinMux(load.pin) == 1 && (st.pddr[port] & bit)
+         && ((st.pdor[port] & bit) != 0) == (load.active != 0);
+}
+
+void accrue(uint64_t to) {
+  uint8_t mode = st.waiting ? (uint8_t)Sim_t::dsf_Wait : st.mode;
+  double seconds, joules;
+
+  if (to <= st.now) {
+    return;
+  }
+  seconds = (double)(to - st.now)/kCoreHz;
+  joules = kSupplyVolts*seconds;
+  st.energy[Sim_t::dsf_Core] += joules*(kModeMicroamps[mode]
+                                        + kModeMicroampsPerMHz[mode]
+                                          *coreClockHz()/1e6);
+  if (mode == Sim_t::dsf_Run || mode == Sim_t::dsf_Wait) {
+    for (int g = 0; g < kGateCostCount; g++) {
+      if (readShadow(kGateCosts[g].address) & kGateCosts[g].mask) {
+        st.energy[Sim_t::dsf_Clocks] += joules*kGateCosts[g].microamps;
+      }
+    }
+  }
+  if (st.ftfa.busy) {
+    st.energy[Sim_t::dsf_Flash] += joules*kFlashMicroamps;
+  }
+  for (int l = 0; l < st.loadCount; l++) {
+    if (loadOn(st.loads[l])) {
+      st.energy[Sim_t::dsf_Loads] += joules*st.loads[l].microamps;
+      st.loads[l].onCycles += to - st.now;
+    }
+  }
+}
+
+/*!
+ * Tempo simulado: agenda, próximo evento e avanço.
+ */
+void advanceTo(uint64_t target) {
+  while (!st.agenda.empty() && st.agenda.begin()->first <= target) {
+    std::multimap<uint64_t, Action>::iterator first = st.agenda.begin();
+    uint64_t at = first->first;
+    Action action = first->second;
+
+    st.agenda.erase(first);
+    if (at > st.now) {
+      syncTimers(at);
+      accrue(at);
+      st.now = at;
+    }
+    action.action(action.argument);
+  }
+  if (target > st.now) {
+    syncTimers(target);
+    accrue(target);
+    st.now = target;
+  }
+}
+
+uint64_t nextEventTime() {
+  uint64_t next = st.stopAt;
+
+  if (!st.agenda.empty() && st.agenda.begin()->first < next) {
+    next = st.agenda.begin()->first;
+  }
+  for (int t = 0; t < kTimers; t++) {
+    uint64_t overflow = nextOverflow(t);
+    if (overflow < next) {
+      next = overflow;
+    }
+  }
+  if (st.mode == Sim_t::dsf_Run && nextSysTickZero() < next) {
+    next = nextSysTickZero();
+  }
+  if (nextLptmrMatch() < next) {
+    next = nextLptmrMatch();
+  }
+  return next;
+}
+
+/*!
+ * Verifica a porta de clock e prepara a cópia interna para a leitura.
+ */
+void prepareAccess(uintptr_t address) {
+  if (address - kPORTBase < 0x1000u*kPorts) {
+    if (!(readShadow(0x40048038) & (0x200u << (address - kPORTBase)/0x1000))) {
+      busFault(address, "PORT clock gated off");
+    }
+  } else if (address - kTPMBase < 0x1000u*kTimers) {
+    int t = (int)((address - kTPMBase)/0x1000);
+    if (!timerClocked(t)) {
+      busFault(address, "TPM clock gated off");
+    }
+    publishTimer(t);
+  } else if (address - kNVICBase < 0x400u) {
+    publishNvic();
+  } else if (address - kUARTBase < 0x1000u) {
+    if (!uartClocked()) {
+      busFault(address, "UART0 clock gated off");
+    }
+    publishUart();
+  } else if (address - kDMABase < 0x10u*kDMAChannels) {
+    if (!(readShadow(0x40048040) & 0x100u)) {
+      busFault(address, "DMA clock gated off");
+    }
+    publishDma();
+  } else if (address - kDMAMUXBase < 0x1000u) {
+    if (!(readShadow(0x4004803C) & 2u)) {
+      busFault(address, "DMAMUX clock gated off");
+    }
+  } else if (address - kFTFABase < 0x1000u) {
+    if (!flashClocked()) {
+      busFault(address, "FTF clock gated off");
+    }
+    publishFtfa();
+  } else if (address - kLPTMRBase < 0x10u) {
+    if (!lptmrClocked()) {
+      busFault(address, "LPTMR clock gated off");
+    }
+    publishLptmr();
+  } else if (address - kTSIBase < 0x10u) {
+    if (!tsiClocked()) {
+      busFault(address, "TSI clock gated off");
+    }
+    syncLptmr();
+    publishTsi();
+  } else if (address - kADCBase < 0x70u) {
+    if (!adcClocked()) {
+      busFault(address, "ADC0 clock gated off");
+    }
+    publishAdc();
+    /*!
+     * COCO é apagado pela leitura do RA.
+     */
+    if (address - (kADCBase + 0x10) < 4u) {
+      st.adc.reg[0] &= ~0x80u;
+    }
+  } else if (address - kSMCBase < 0x4u) {
+    publishSmc();
+  } else if (address - kLLWUBase < 0xAu) {
+    publishLlwu();
+  } else if (address - kMCGBase < 0x10u || address - kCLKDIV1 < 4u) {
+    /*!
+     * O SysTick guarda a contagem no relógio anterior a uma escrita.
+     */
+    rebaseSysTick();
+    publishMcg();
+  } else if (address - kSysTickBase < 0x10u) {
+    /*!
+     * COUNTFLAG é apagado pela leitura do CSR.
+     */
+    publishSysTick();
+    if (address == kSysTickBase) {
+      st.sysTick.csr &= ~0x10000u;
+    }
+  }
+}
+
+void completeWrite(uintptr_t address) {
+  uint32_t value = readShadow(address);
+
+  if (address - kTPMBase < 0x1000u*kTimers) {
+    timerWrite((int)((address - kTPMBase)/0x1000), address & 0xFFC, value);
+  } else if (address - kPORTBase < 0x1000u*kPorts) {
+    portWrite((int)((address - kPORTBase)/0x1000), address & 0xFFC, value);
+  } else if (address - kGPIOBase < 0x40u*kPorts) {
+    gpioWrite((int)((address - kGPIOBase)/0x40), address & 0x3C, value);
+  } else if (address - kFGPIOBase < 0x40u*kPorts) {
+    gpioWrite((int)((address - kFGPIOBase)/0x40), address & 0x3C, value);
+  } else if (address - kNVICBase < 0x400u) {
+    nvicWrite((uint32_t)(address - kNVICBase) & ~3u, value);
+  } else if (address - kUARTBase < 0x1000u) {
+    uartWrite((uint32_t)(address - kUARTBase),
+              (uint8_t)(value >> 8*(address & 3)));
+  } else if (address - kDMABase < 0x10u*kDMAChannels) {
+    dmaWrite((int)((address - kDMABase)/0x10), address & 0xC, value);
+  } else if (address - kDMAMUXBase < 0x1000u) {
+    dmaService();
+  } else if (address - kFTFABase < 0x14u) {
+    ftfaWrite((uint32_t)(address - kFTFABase),
+              (uint8_t)(value >> 8*(address & 3)));
+  } else if (address - kLPTMRBase < 0x10u) {
+    lptmrWrite((uint32_t)(address - kLPTMRBase) & ~3u, value);
+  } else if (address - kTSIBase < 0x10u) {
+    tsiWrite((uint32_t)(address - kTSIBase) & ~3u, value);
+  } else if (address - kADCBase < 0x70u) {
+    adcWrite((uint32_t)(address - kADCBase) & ~3u, value);
+  } else if (address - kSMCBase < 0x4u) {
+    smcWrite((uint32_t)(address - kSMCBase),
+             (uint8_t)(value >> 8*(address & 3)));
+  } else if (address - kLLWUBase < 0xAu) {
+    llwuWrite((uint32_t)(address - kLLWUBase),
+              (uint8_t)(value >> 8*(address & 3)));
+  } else if (address - kMCGBase < 0x10u) {
+    mcgWrite((uint32_t)(address - kMCGBase),
+             (uint8_t)(value >> 8*(address & 3)));
+  } else if (address - kSysTickBase < 0x10u) {
+    sysTickWrite((uint32_t)(address - kSysTickBase) & ~3u, value);
+  } else if (address - kSIMBase < 0x1000u) {
+    /*!
+     * SOPT2 e SCGCx ficam na cópia interna; os TPMs já foram
+     * sincronizados com o relógio anterior.
+     */
+    evaluatePins();
+  }
+}
+
+/*!
+ * Registrador alcançado por um endereço decorado: 20 bits do endereço para
+ * AND, OR e XOR, 19 bits para o BFI.
+ */
+uintptr_t bmeTarget(uintptr_t address) {
+  if (address >= 0x50000000) {
+    return 0x40000000 | (address & 0x7FFFF);
+  }
+  return 0x40000000 | (address & 0xFFFFF);
+}
+
+/*!
+ * Largura em bytes de uma escrita MOV do x86-64 (88, 89, C6 e C7, com os
+ * prefixos 66 e 67 e REX sem W), ou 0 para outras instruções. O 67 aparece
+ * quando o endereço é calculado em 32 bits.
+ */
+uint32_t storeWidth(const uint8_t *code) {
+  uint32_t width = 4;
+
+  for (; *code == 0x66 || *code == 0x67; code++) {
+    if (*code == 0x66) {
+      width = 2;
+    }
+  }
+  if ((*code & 0xF0) == 0x40) {
+    if (*code & 0x08) {
+      return 0;
+    }
+    code++;
+  }
+  if (*code == 0x88 || *code == 0xC6) {
+    return 1;
+  }
+  if (*code == 0x89 || *code == 0xC7) {
+    return width;
+  }
+  return 0;
+}
+
+/*!
+ * Fim de uma escrita decorada: o dado ficou na página decorada, liberada
+ * durante o passo. A operação é aplicada à faixa de bytes do registrador
+ * na cópia interna, que então é interpretada como uma escrita comum.
+ */
+void bmeStore(uintptr_t address, uint32_t width) {
+  uintptr_t target = bmeTarget(address);
+  uint32_t data = 0, lanes, shift, old, result, field;
+
+  memcpy(&data, (void *)address, width);
+  memset((void *)address, 0, width);
+  lanes = width == 4 ? ~0u : (1u << 8*width) - 1;
+  shift = 8*(uint32_t)(target & 3);
+  old = (readShadow(target) >> shift) & lanes;
+  switch ((address >> 26) & 7) {
+    case 1: result = old & data; break;
+    case 2: result = old | data; break;
+    case 3: result = old ^ data; break;
+    default:
+      field = ((2u << ((address >> 19) & 0xF)) - 1)
+              << ((address >> 23) & 0x1F);
+      result = (old & ~field) | (data & field);
+      break;
+  }
+  writeShadow(target, (readShadow(target) & ~(lanes << shift))
+                      | (result & lanes) << shift);
+  completeWrite(target);
+}
+
+void restoreDefault(int signal) {
+  struct sigaction action;
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = SIG_DFL;
+  sigaction(signal, &action, 0);
+}
+
+/*!
+ * Falha de página: um acesso a registrador. Avança o tempo, salta laços
+ * de espera, prepara o valor lido e executa a instrução em passo único.
+ */
+void onFault(int signal, siginfo_t *info, void *context) {
+  ucontext_t *uc = (ucontext_t *)context;
+  uintptr_t address = (uintptr_t)info->si_addr;
+  bool write = uc->uc_mcontext.gregs[REG_ERR] & 2;
+  bool decorated = address - kBMEBase < kBMESize;
+  uintptr_t target = decorated ? bmeTarget(address) : address;
+
+  if (!inWindow(target) || st.stepping) {
+    restoreDefault(signal);
+    return;
+  }
+  st.stepWidth = 0;
+  if (decorated) {
+    st.stepWidth = storeWidth((const uint8_t *)
+                              uc->uc_mcontext.gregs[REG_RIP]);
+    if (!write || !st.stepWidth) {
+      busFault(address, "BME access other than a store");
+    }
+  }
+  st.accesses++;
+  advanceTo(st.now + st.accessCycles + (decorated ? kBMECycles : 0));
+  if (write) {
+    st.lastRead = 0;
+    st.repeatedReads = 0;
+  } else if (address == st.lastRead) {
+    if (++st.repeatedReads >= 2) {
+      st.repeatedReads = 0;
+      advanceTo(nextEventTime());
+    }
+  } else {
+    st.lastRead = address;
+    st.repeatedReads = 0;
+  }
+  if (st.running && st.now >= st.stopAt) {
+    finish();
+  }
+  prepareAccess(target);
+
+  st.stepping = true;
+  st.stepWrite = write;
+  st.stepAddress = address;
+  mprotect((void *)(address & ~(kPageSize - 1)), kPageSize,
+           PROT_READ | PROT_WRITE);
+  uc->uc_mcontext.gregs[REG_EFL] |= 0x100;
+}
+
+/*!
+ * Fim do passo único: protege a página, interpreta a escrita e, se houver
+ * interrupção a entregar, desvia o contexto para o trampolim.
+ */
+void onStep(int signal, siginfo_t *info, void *context) {
+  ucontext_t *uc = (ucontext_t *)context;
+  greg_t *regs = uc->uc_mcontext.gregs;
+  uint64_t sp;
+
+  (void)info;
+  if (!st.stepping) {
+    restoreDefault(signal);
+    return;
+  }
+  regs[REG_EFL] &= ~0x100;
+  st.stepping = false;
+  if (st.stepWidth) {
+    bmeStore(st.stepAddress, st.stepWidth);
+  }
+  mprotect((void *)(st.stepAddress & ~(kPageSize - 1)), kPageSize, PROT_NONE);
+  if (st.stepWrite && !st.stepWidth) {
+    completeWrite(st.stepAddress);
+  }
+  if (deliverable()) {
+    st.interruptedPc = (uintptr_t)regs[REG_RIP];
+    sp = (uint64_t)regs[REG_RSP] - 128 - 8;
+    *(uint64_t *)sp = (uint64_t)regs[REG_RIP];
+    regs[REG_RSP] = (greg_t)sp;
+    regs[REG_RIP] = (greg_t)(uintptr_t)dsf_sim_irq_trampoline;
+  }
+}
+
+void resetState() {
+  st.now = 0;
+  memset(st.pcr, 0, sizeof(st.pcr));
+  memset(st.pdor, 0, sizeof(st.pdor));
+  memset(st.pddr, 0, sizeof(st.pddr));
+  memset(st.level, 0, sizeof(st.level));
+  memset(st.timer, 0, sizeof(st.timer));
+  memset(st.priority, 0, sizeof(st.priority));
+  memset(&st.sysTick, 0, sizeof(st.sysTick));
+  st.sysTickPending = false;
+  st.sysTickPriority = 0;
+  st.nvicEnabled = 0;
+  st.nvicPending = 0;
+  st.primask = 0;
+  /*!
+   * Valores de reset: SWD em PTA0/PTA3, RESET em PTA20, TPMs com MOD
+   * máximo, portas PORTx desligadas e FTF ligado.
+   */
+  st.pcr[0][0] = PORT_PCR_MUX(7) | PORT_PCR_PE_MASK;
+  st.pcr[0][3] = PORT_PCR_MUX(7) | PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;
+  st.pcr[0][20] = PORT_PCR_MUX(7) | PORT_PCR_PE_MASK | PORT_PCR_PS_MASK;
+  for (int t = 0; t < kTimers; t++) {
+    st.timer[t].mod = 0xFFFF;
+    publishTimer(t);
+  }
+  writeShadow(0x40048004, 0);
+  writeShadow(0x40048034, 0xF0000030);
+  writeShadow(0x40048038, 0x00000180);
+  writeShadow(0x4004803C, 0x00000001);
+  writeShadow(0x40048040, 0x00000100);
+  writeShadow(kCLKDIV1, 0x00010000);
+  memset(&st.uart, 0, sizeof(st.uart));
+  st.uart.reg[1] = 0x04;
+  st.uart.reg[10] = 0x0F;
+  memset(st.dma, 0, sizeof(st.dma));
+  st.ftfa.fstat = 0x80;
+  st.ftfa.fcnfg = 0;
+  st.ftfa.busy = false;
+  st.ftfa.generation++;
+  memset(&st.lptmr, 0, sizeof(st.lptmr));
+  st.tsi.gencs = 0;
+  st.tsi.data = 0;
+  st.tsi.scanning = false;
+  st.tsi.generation++;
+  /*!
+   * ADC0 desligado (ADCH = 0x1F), OFS, PG e MG de reset e os CLPx e CLMx
+   * de reset, de CLPD/CLMD a CLP0/CLM0.
+   */
+  memset(st.adc.reg, 0, sizeof(st.adc.reg));
+  st.adc.reg[0] = 0x1F;
+  st.adc.reg[10] = 0x4;
+  st.adc.reg[11] = 0x8200;
+  st.adc.reg[12] = 0x8200;
+  for (int i = 0; i < 7; i++) {
+    static const uint32_t kCalibration[7] = {0xA, 0x20, 0x200, 0x100, 0x80,
+                                             0x40, 0x20};
+    st.adc.reg[13 + i] = kCalibration[i];
+    st.adc.reg[21 + i] = kCalibration[i];
+  }
+  st.adc.converting = false;
+  st.adc.calibrating = false;
+  st.adc.generation++;
+  memset(&st.smc, 0, sizeof(st.smc));
+  memset(st.llwu, 0, sizeof(st.llwu));
+  /*!
+   * MCG em FEI: IREFS, LOCRE0 e FCRDIV = 1.
+   */
+  memset(&st.mcg, 0, sizeof(st.mcg));
+  st.mcg.reg[0] = 0x04;
+  st.mcg.reg[1] = 0x80;
+  st.mcg.reg[8] = 0x02;
+  st.mode = Sim_t::dsf_Run;
+  memset(st.modeCycles, 0, sizeof(st.modeCycles));
+  st.waiting = false;
+  memset(st.energy, 0, sizeof(st.energy));
+  for (int l = 0; l < st.loadCount; l++) {
+    st.loads[l].onCycles = 0;
+  }
+  writeShadow(kSCR, 0);
+  evaluatePins();
+  publishNvic();
+  publishSysTick();
+  publishUart();
+  publishDma();
+  publishFtfa();
+  publishLptmr();
+  publishTsi();
+  publishAdc();
+  publishSmc();
+  publishLlwu();
+  publishMcg();
+}
+
+/*!
+ * Modos de parada: o modo pedido pelo WFI, a condição de despertar e o
+ * sono até ela.
+ */
+uint8_t stopMode() {
+  if (!(readShadow(kSCR) & SCB_SCR_SLEEPDEEP_Msk)) {
+    return Sim_t::dsf_Run;
+  }
+  return (st.smc.pmctrl & 7) == 3 ? Sim_t::dsf_LLS : Sim_t::dsf_VLPS;
+}
+
+/*!
+ * VLPS acorda com qualquer interrupção habilitada; LLS só com uma flag do
+ * LLWU: um pino habilitado ou o TCF do LPTMR (módulo 0, MWUF0 em F3).
+ */
+bool stopWake() {
+  if (st.mode == Sim_t::dsf_VLPS) {
+    return nextIrq() >= 0;
+  }
+  syncLptmr();
+  if ((st.llwu[4] & 1) && (st.lptmr.csr & 0x80)) {
+    st.llwu[7] |= 1;
+  }
+  return st.llwu[5] | st.llwu[6] | st.llwu[7];
+}
+
+/*!
+ * Dorme no modo pedido: os TPMs e o SysTick param e o tempo salta de
+ * evento em evento até o despertar, mais o tempo de saída para RUN. Em
+ * PEE o PLL para e o MCG sai em PBE (CLKS = 10).
+ */
+void enterStop(uint8_t mode) {
+  uint64_t from = st.now;
+
+  syncTimers(st.now);
+  rebaseSysTick();
+  st.mode = mode;
+  while (!stopWake()) {
+    advanceTo(nextEventTime());
+    if (st.now >= st.stopAt) {
+      st.modeCycles[mode] += st.now - from;
+      st.mode = Sim_t::dsf_Run;
+      finish();
+    }
+  }
+  advanceTo(st.now + kExitNs[mode]*kCoreHz/1000000000);
+  st.modeCycles[mode] += st.now - from;
+  st.mode = Sim_t::dsf_Run;
+  if ((st.mcg.reg[0] >> 6) == 0 && (st.mcg.reg[5] & 0x40)) {
+    st.mcg.reg[0] = (uint8_t)((st.mcg.reg[0] & 0x3F) | 0x80);
+    publishMcg();
+  }
+  st.sysTick.origin = st.now;
+  st.wakeups++;
+  publishLlwu();
+  publishSmc();
+}
+
+/*!
+ * Mapeia as janelas de periféricos antes dos construtores estáticos dos
+ * drivers, que já acessam registradores.
+ */
+__attribute__((constructor(102))) void initialize() {
+  struct sigaction action;
+  int fd = memfd_create("dsf_sim", 0);
+
+  if (fd < 0 || ftruncate(fd, kMappedSize) != 0) {
+    perror("dsf_Sim: memfd");
+    exit(1);
+  }
+  st.shadow = (uint8_t *)mmap(0, kMappedSize, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, fd, 0);
+  if (st.shadow == MAP_FAILED) {
+    perror("dsf_Sim: mmap");
+    exit(1);
+  }
+  for (int w = 0; w < kWindowCount; w++) {
+    void *base = mmap((void *)kWindows[w].base, kWindows[w].size, PROT_NONE,
+                      MAP_SHARED | MAP_FIXED_NOREPLACE, fd,
+                      kWindows[w].offset);
+    if (base != (void *)kWindows[w].base) {
+      fprintf(stderr, "dsf_Sim: cannot map 0x%08lx\n",
+              (unsigned long)kWindows[w].base);
+      exit(1);
+    }
+  }
+  close(fd);
+  if (mmap((void *)kBMEBase, kBMESize, PROT_NONE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE,
+           -1, 0) != (void *)kBMEBase) {
+    fprintf(stderr, "dsf_Sim: cannot map 0x%08lx\n", (unsigned long)kBMEBase);
+    exit(1);
+  }
+  for (int p = 0; p < kPins; p++) {
+    st.drive[p] = Sim_t::dsf_Released;
+    st.net[p] = (uint8_t)p;
+  }
+  st.accessCycles = 8;
+  st.noise = 0x9E3779B97F4A7C15ull;
+  dsf_Sim::setLoad(1, 18, 2000, Sim_t::dsf_Low);
+  dsf_Sim::setLoad(1, 19, 2000, Sim_t::dsf_Low);
+  dsf_Sim::setLoad(3, 1, 2000, Sim_t::dsf_Low);
+  resetState();
+
+  memset(&action, 0, sizeof(action));
+  action.sa_flags = SA_SIGINFO;
+  action.sa_sigaction = onFault;
+  sigaction(SIGSEGV, &action, 0);
+  action.sa_sigaction = onStep;
+  sigaction(SIGTRAP, &action, 0);
+}
+
+}  // namespace
+
+/*!
+ * Entrega das interrupções pendentes, sem aninhamento e com encadeamento
+ * (tail-chaining) enquanto houver linhas ativas.
+ */
+extern "C" void dsf_sim_irq_dispatch(void) {
+  int irq;
+
+  st.inHandler = true;
+  while (st.running && !st.primask && (irq = nextIrq()) >= 0) {
+    st.interrupts++;
+    if (irq == kSysTickException) {
+      st.sysTickPending = false;
+      advanceTo(st.now + kEntryCycles);
+      if (!SysTick_Handler) {
+        fprintf(stderr, "dsf_Sim: SysTick without handler\n");
+        abort();
+      }
+      SysTick_Handler();
+      continue;
+    }
+    st.nvicPending &= ~(1u << irq);
+    advanceTo(st.now + kEntryCycles);
+    if (!kVectors[irq]) {
+      fprintf(stderr, "dsf_Sim: IRQ %d without handler\n", irq);
+      abort();
+    }
+    kVectors[irq]();
+  }
+  st.inHandler = false;
+}
+
+extern "C" uint32_t dsf_sim_getPrimask(void) {
+  return st.primask;
+}
+
+extern "C" void dsf_sim_setPrimask(uint32_t primask) {
+  st.primask = primask & 1;
+  if (deliverable()) {
+    st.interruptedPc = (uintptr_t)__builtin_return_address(0);
+    dsf_sim_irq_dispatch();
+  }
+}
+
+extern "C" void dsf_sim_nvicEnable(int irq, int enable) {
+  if (irq < 0) {
+    return;
+  }
+  if (enable) {
+    st.nvicEnabled |= 1u << irq;
+  } else {
+    st.nvicEnabled &= ~(1u << irq);
+  }
+  publishNvic();
+  if (deliverable()) {
+    st.interruptedPc = (uintptr_t)__builtin_return_address(0);
+    dsf_sim_irq_dispatch();
+  }
+}
+
+extern "C" void dsf_sim_nvicPending(int irq, int pending) {
+  if (irq < 0) {
+    return;
+  }
+  if (pending) {
+    st.nvicPending |= 1u << irq;
+  } else {
+    st.nvicPending &= ~(1u << irq);
+  }
+  publishNvic();
+  if (deliverable()) {
+    st.interruptedPc = (uintptr_t)__builtin_return_address(0);
+    dsf_sim_irq_dispatch();
+  }
+}
+
+extern "C" void dsf_sim_nvicPriority(int irq, uint32_t priority) {
+  if (irq >= 0 && irq < 32) {
+    st.priority[irq] = (uint8_t)((priority << 6) & 0xC0);
+    publishNvic();
+  } else if (irq == SysTick_IRQn) {
+    st.sysTickPriority = (uint8_t)((priority << 6) & 0xC0);
+  }
+}
+
+/*!
+ * Endereço da instrução interrompida pela exceção em andamento: a
+ * instrução após o acesso a registrador ou o retorno da chamada ao WFI, ao
+ * PRIMASK ou ao NVIC que liberou a exceção.
+ */
+extern "C" uintptr_t dsf_sim_interruptedPc(void) {
+  return st.interruptedPc;
+}
+
+/*!
+ * WFI: avança o tempo até uma interrupção habilitada ficar pendente; com
+ * SLEEPDEEP, dorme antes em VLPS ou LLS.
+ */
+extern "C" void dsf_sim_wfi(void) {
+  uint64_t from;
+  uint8_t mode;
+
+  if (!st.running) {
+    return;
+  }
+  /*!
+   * Com SLEEPDEEP, uma interrupção já pendente aborta a entrada no modo
+   * de parada (STOPA).
+   */
+  mode = stopMode();
+  if (mode != Sim_t::dsf_Run) {
+    st.smc.pmctrl &= ~0x08u;
+    if (nextIrq() >= 0) {
+      st.smc.pmctrl |= 0x08;
+    } else {
+      enterStop(mode);
+    }
+    publishSmc();
+  }
+  /*!
+   * Sem SLEEPDEEP, o núcleo espera em WAIT com os periféricos ligados.
+   */
+  from = st.now;
+  st.waiting = nextIrq() < 0;
+  while (nextIrq() < 0) {
+    advanceTo(nextEventTime());
+    if (st.now >= st.stopAt) {
+      st.modeCycles[Sim_t::dsf_Wait] += st.now - from;
+      st.waiting = false;
+      finish();
+    }
+  }
+  if (st.waiting) {
+    st.modeCycles[Sim_t::dsf_Wait] += st.now - from;
+    st.waiting = false;
+  }
+  if (!st.primask && !st.inHandler) {
+    st.interruptedPc = (uintptr_t)__builtin_return_address(0);
+    dsf_sim_irq_dispatch();
+  }
+}
+
+/*!
+ *   @fn         wire
+ *
+ *   @brief      Liga dois pinos no mesmo nó elétrico.
+ *
+ *   @param[in]  GPIOa, pina - primeiro pino (GPIO 0..4 = A..E).
+ *               GPIOb, pinb - segundo pino.
+ */
+void dsf_Sim::wire(uint8_t GPIOa, uint8_t pina, uint8_t GPIOb, uint8_t pinb) {
+  st.wires.push_back((uint16_t)((GPIOa*32 + pina) << 8 | (GPIOb*32 + pinb)));
+  joinPins(GPIOa*32 + pina, GPIOb*32 + pinb);
+  evaluatePins();
+}
+
+/*!
+ *   @fn         unwire
+ *
+ *   @brief      Desfaz uma ligação feita por wire, como uma tecla solta.
+ *
+ *   Os nós são refeitos a partir das ligações restantes.
+ *
+ *   @param[in]  GPIOa, pina - primeiro pino (GPIO 0..4 = A..E).
+ *               GPIOb, pinb - segundo pino.
+ */
+void dsf_Sim::unwire(uint8_t GPIOa, uint8_t pina, uint8_t GPIOb,
+                     uint8_t pinb) {
+  uint16_t forward = (uint16_t)((GPIOa*32 + pina) << 8 | (GPIOb*32 + pinb));
+  uint16_t backward = (uint16_t)((GPIOb*32 + pinb) << 8 | (GPIOa*32 + pina));
+
+  for (size_t w = 0; w < st.wires.size(); w++) {
+    if (st.wires[w] == forward || st.wires[w] == backward) {
+      st.wires.erase(st.wires.begin() + w);
+      break;
+    }
+  }
+  for (int p = 0; p < kPins; p++) {
+    st.net[p] = (uint8_t)p;
+  }
+  for (size_t w = 0; w < st.wires.size(); w++) {
+    joinPins(st.wires[w] >> 8, st.wires[w] & 0xFF);
+  }
+  evaluatePins();
+}
+
+/*!
+ *   @fn         drive
+ *
+ *   @brief      Impõe um nível externo a um pino, como uma tecla.
+ *
+ *   @param[in]  level - Sim_t::dsf_Low, dsf_High ou dsf_Released.
+ */
+void dsf_Sim::drive(uint8_t GPIO, uint8_t pin, Sim_t::dsf_Level level) {
+  st.drive[GPIO*32 + pin] = (uint8_t)level;
+  evaluatePins();
+}
+
+/*!
+ *   @fn         pinLevel
+ *
+ *   @brief      Informa o nível atual de um pino.
+ */
+int dsf_Sim::pinLevel(uint8_t GPIO, uint8_t pin) {
+  return st.level[GPIO*32 + pin];
+}
+
+/*!
+ *   @fn         watch
+ *
+ *   @brief      Registra um observador das mudanças de nível de um pino.
+ */
+void dsf_Sim::watch(uint8_t GPIO, uint8_t pin, dsf_SimObserver observer,
+                    void *argument) {
+  Watch entry = {(uint8_t)(GPIO*32 + pin), observer, argument};
+
+  st.watches.push_back(entry);
+}
+
+/*!
+ *   @fn         listen
+ *
+ *   @brief      Registra o receptor dos bytes transmitidos pela UART0.
+ *
+ *   Cada byte é entregue no fim do seu bit de parada.
+ */
+void dsf_Sim::listen(dsf_SimSerial receiver, void *argument) {
+  st.serialReceiver = receiver;
+  st.serialArgument = argument;
+}
+
+/*!
+ *   @fn         attachFlash
+ *
+ *   @brief      Mapeia um arquivo como a metade superior da flash.
+ *
+ *   O arquivo guarda os 64 KB de 0x10000 a 0x1FFFF e é criado apagado
+ *   (0xFF) se não existe, de modo que o conteúdo sobrevive entre
+ *   execuções. O firmware lê a flash diretamente e grava pelo FTFA.
+ *
+ *   @param[in]  path - caminho do arquivo.
+ *
+ *   @return     true se o arquivo foi mapeado.
+ */
+bool dsf_Sim::attachFlash(const char *path) {
+  struct stat info;
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  uint8_t *flash;
+  void *view;
+
+  if (fd < 0 || fstat(fd, &info) != 0
+      || (info.st_size < kFlashSize && ftruncate(fd, kFlashSize) != 0)) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+  flash = (uint8_t *)mmap(0, kFlashSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          fd, 0);
+  if (flash == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  if (info.st_size < kFlashSize) {
+    memset(flash + info.st_size, 0xFF, kFlashSize - info.st_size);
+  }
+  if (st.flash) {
+    munmap((void *)kFlashBase, kFlashSize);
+    munmap(st.flash, kFlashSize);
+  }
+  view = mmap((void *)kFlashBase, kFlashSize, PROT_READ,
+              MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+  close(fd);
+  if (view != (void *)kFlashBase) {
+    munmap(flash, kFlashSize);
+    st.flash = 0;
+    return false;
+  }
+  st.flash = flash;
+  memset(st.erases, 0, sizeof(st.erases));
+  return true;
+}
+
+/*!
+ *   @fn         cutPower
+ *
+ *   @brief      Corta a alimentação no instante atual.
+ *
+ *   Um comando do FTFA em andamento fica pela metade: uma parte
+ *   pseudoaleatória dos bits a gravar ou a apagar muda. A execução termina
+ *   no próximo acesso a registrador; reset prepara a próxima partida.
+ *   Chamado de uma ação agendada.
+ *
+ *   @return     O código do comando interrompido ou 0 sem comando.
+ */
+uint8_t dsf_Sim::cutPower() {
+  Ftfa &f = st.ftfa;
+  uint8_t command = f.busy ? f.command : 0;
+
+  if (command == 0x06) {
+    for (int i = 0; i < 4; i++) {
+      uint8_t *cell = flashByte(f.address + i);
+      *cell &= (uint8_t)(f.data >> 8*i) | (uint8_t)nextNoise();
+    }
+  } else if (command == 0x09) {
+    for (uint32_t i = 0; i < kSectorSize; i++) {
+      *flashByte(f.address + i) |= (uint8_t)nextNoise();
+    }
+  }
+  f.busy = false;
+  f.generation++;
+  stop();
+  return command;
+}
+
+/*!
+ *   @fn         reset
+ *
+ *   @brief      Partida após um corte de alimentação ou um reset.
+ *
+ *   Os registradores voltam aos valores de reset, a agenda é esvaziada e
+ *   o tempo volta a 0. A flash, as ligações entre pinos, os níveis
+ *   externos e os observadores são mantidos.
+ */
+void dsf_Sim::reset() {
+  st.agenda.clear();
+  st.inHandler = false;
+  resetState();
+}
+
+/*!
+ *   @fn         flashErases
+ *
+ *   @brief      Informa quantas vezes o setor foi apagado desde
+ *               attachFlash.
+ */
+uint32_t dsf_Sim::flashErases(uint32_t address) {
+  return inFlash(address, 1)
+         ? st.erases[(address - kFlashBase)/kSectorSize] : 0;
+}
+
+/*!
+ *   @fn         schedule
+ *
+ *   @brief      Agenda uma ação no ciclo informado do tempo simulado.
+ */
+void dsf_Sim::schedule(uint64_t cycle, dsf_SimAction action, void *argument) {
+  Action entry = {action, argument};
+
+  st.agenda.insert(std::make_pair(cycle, entry));
+}
+
+uint64_t dsf_Sim::now() {
+  return st.now;
+}
+
+uint32_t dsf_Sim::coreFrequency() {
+  return kCoreHz;
+}
+
+uint64_t dsf_Sim::microseconds(uint64_t us) {
+  return us*kCoreHz/1000000;
+}
+
+void dsf_Sim::setAccessCycles(uint32_t cycles) {
+  st.accessCycles = cycles;
+}
+
+/*!
+ *   @fn         setIrcError
+ *
+ *   @brief      Ajusta o desvio dos IRCs do MCG em relação ao nominal.
+ *
+ *   Simula o erro de fábrica e a deriva com a temperatura: o FLL no FEI, o
+ *   MCGIRCLK e os relógios derivados deles passam a contar na frequência
+ *   nominal vezes (1 + ppm/10^6). A unidade do tempo simulado e o cristal
+ *   não mudam. Os TPMs e o SysTick contam até aqui na frequência anterior.
+ *
+ *   @param[in]  ppm - desvio, em partes por milhão.
+ */
+void dsf_Sim::setIrcError(int32_t ppm) {
+  syncTimers(st.now);
+  rebaseSysTick();
+  st.ircErrorPpm = ppm;
+}
+
+/*!
+ *   @fn         run
+ *
+ *   @brief      Executa o firmware até ele retornar ou até o ciclo limite.
+ *
+ *   @param[in]  entry - ponto de entrada do firmware (o main da placa).
+ *               untilCycle - ciclo do tempo simulado em que a execução
+ *                            é encerrada.
+ *
+ *   @return     0 se entry retornou e 1 se a execução foi encerrada.
+ */
+int dsf_Sim::run(void (*entry)(), uint64_t untilCycle) {
+  st.stopAt = untilCycle;
+  if (sigsetjmp(st.exitPoint, 1)) {
+    st.running = false;
+    st.inHandler = false;
+    st.stepping = false;
+    return 1;
+  }
+  st.running = true;
+  entry();
+  st.running = false;
+  return 0;
+}
+
+/*!
+ *   @fn         stop
+ *
+ *   @brief      Encerra a execução no próximo acesso a registrador.
+ */
+void dsf_Sim::stop() {
+  st.stopAt = st.now;
+}
+
+uint64_t dsf_Sim::accessCount() {
+  return st.accesses;
+}
+
+uint64_t dsf_Sim::interruptCount() {
+  return st.interrupts;
+}
+
+/*!
+ *   @fn         modeCycles
+ *
+ *   @brief      Informa os ciclos passados em um modo de energia desde o
+ *               reset, incluindo o tempo de saída para RUN.
+ */
+uint64_t dsf_Sim::modeCycles(Sim_t::dsf_PowerMode mode) {
+  if (mode == Sim_t::dsf_Run) {
+    return st.now - st.modeCycles[Sim_t::dsf_VLPS]
+           - st.modeCycles[Sim_t::dsf_LLS] - st.modeCycles[Sim_t::dsf_Wait];
+  }
+  return st.modeCycles[mode];
+}
+
+/*!
+ *   @fn         microjoules
+ *
+ *   @brief      Informa a energia estimada desde o reset, em uJ.
+ *
+ *   A energia é a integral da corrente do modelo (modo de energia, portas
+ *   de clock, comandos da flash e cargas dos pinos) vezes a tensão de
+ *   alimentação, ao longo do tempo simulado.
+ */
+double dsf_Sim::microjoules() {
+  double total = 0;
+
+  for (int part = 0; part < Sim_t::dsf_NumParts; part++) {
+    total += st.energy[part];
+  }
+  return total;
+}
+
+double dsf_Sim::microjoules(Sim_t::dsf_EnergyPart part) {
+  return st.energy[part];
+}
+
+/*!
+ *   @fn         setLoad
+ *
+ *   @brief      Liga uma carga a um pino, como um led.
+ *
+ *   A carga consome microamps enquanto o pino é saída do GPIO com o PDOR
+ *   no nível active. microamps = 0 retira a carga do pino.
+ */
+void dsf_Sim::setLoad(uint8_t GPIO, uint8_t pin, uint32_t microamps,
+                      Sim_t::dsf_Level active) {
+  uint8_t p = (uint8_t)(GPIO*32 + pin);
+  int l;
+
+  for (l = 0; l < st.loadCount && st.loads[l].pin != p; l++) {
+  }
+  if (microamps == 0) {
+    if (l < st.loadCount) {
+      st.loads[l] = st.loads[--st.loadCount];
+    }
+    return;
+  }
+  if (l == st.loadCount) {
+    if (st.loadCount == kMaxLoads) {
+      fprintf(stderr, "dsf_Sim: more than %d loads\n", kMaxLoads);
+      exit(1);
+    }
+    st.loads[st.loadCount++].onCycles = 0;
+  }
+  st.loads[l].pin = p;
+  st.loads[l].active = active == Sim_t::dsf_Low ? 0 : 1;
+  st.loads[l].microamps = microamps;
+}
+
+/*!
+ *   @fn         setTouchCount
+ *
+ *   @brief      Fixa a contagem que as próximas medidas de um canal do TSI
+ *               devolvem no TSICNT.
+ *
+ *   Uma sequência de chamadas agendadas forma o traço do eletrodo: a
+ *   linha de base, a deriva e os toques.
+ */
+void dsf_Sim::setTouchCount(uint8_t channel, uint16_t count) {
+  st.tsi.count[channel & 15] = count;
+}
+
+/*!
+ *   @fn         setAnalogSource
+ *
+ *   @brief      Informa a fonte dos valores das conversões do ADC0.
+ *
+ *   A fonte é chamada no fim de cada amostra, com o canal de ADCH, e
+ *   devolve o valor em 16 bits; o modelo o reduz à resolução de MODE.
+ *   Sem fonte as conversões devolvem 0.
+ */
+void dsf_Sim::setAnalogSource(dsf_SimAnalog source, void *argument) {
+  st.analogSource = source;
+  st.analogArgument = argument;
+}
+
+/*!
+ *   @fn         loadCycles
+ *
+ *   @brief      Informa os ciclos em que a carga do pino ficou acesa.
+ */
+uint64_t dsf_Sim::loadCycles(uint8_t GPIO, uint8_t pin) {
+  for (int l = 0; l < st.loadCount; l++) {
+    if (st.loads[l].pin == GPIO*32 + pin) {
+      return st.loads[l].onCycles;
+    }
+  }
+  return 0;
+}
+
+uint64_t dsf_Sim::wakeupCount() {
+  return st.wakeups;
+}
@@ -0,0 +1,240 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Simulador de periféricos do MKL25Z4 para execução no host.
+ *
+ * @file        dsf_Sim.h
+ * @version     1.0
+ * @date        25 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +platform     Host Linux/x86-64.
+ *              +peripheral   SIM, PORT, GPIO, FGPIO, TPM, SysTick, NVIC,
+ *                            transmissor da UART0, DMA, FTFA, LPTMR, SMC,
+ *                            LLWU, MCG e BME simulados, com estimativa
+ *                            de energia.
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (25 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef HOST_SIM_DSF_SIM_H_
+#define HOST_SIM_DSF_SIM_H_
+
+#include <stdint.h>
+
+/*!
+ * Namespace de definição dos níveis impostos externamente a um pino, dos
+ * modos de energia e das parcelas do modelo de energia.
+ */
+namespace Sim_t {
+  enum dsf_Level {
+    dsf_Low = 0,
+    dsf_High = 1,
+    dsf_Released = 2
+  };
+  enum dsf_PowerMode {
+    dsf_Run = 0,
+    dsf_VLPS = 1,
+    dsf_LLS = 2,
+    dsf_Wait = 3,
+    dsf_NumModes = 4
+  };
+  enum dsf_EnergyPart {
+    dsf_Core = 0,
+    dsf_Clocks = 1,
+    dsf_Flash = 2,
+    dsf_Loads = 3,
+    dsf_NumParts = 4
+  };
+}  // namespace Sim_t
+
+/*!
+ * Ação agendada no tempo simulado.
+ */
+typedef void (*dsf_SimAction)(void *argument);
+
+/*!
+ * Observador das mudanças de nível de um pino.
+ */
+typedef void (*dsf_SimObserver)(void *argument, uint8_t GPIO, uint8_t pin,
+                                int level);
+
+/*!
+ * Receptor dos bytes transmitidos pela UART0.
+ */
+typedef void (*dsf_SimSerial)(void *argument, uint8_t byte);
+
+/*!
+ * Fonte das conversões do ADC0: valor de 16 bits do canal.
+ */
+typedef uint16_t (*dsf_SimAnalog)(void *argument, uint8_t channel);
+
+/*!
+ *  @class    dsf_Sim
+ *
+ *  @brief    Simulador dos periféricos usados pelos drivers dsf.
+ *
+ *  @details  As janelas de periféricos (0x40000000, FGPIO em 0xF80FF000 e o
+ *            NVIC em 0xE000E000) são mapeadas nos mesmos endereços da placa
+ *            sem permissão de acesso. Cada acesso dos drivers gera uma falha
+ *            de página; o simulador atualiza o valor a ser lido, libera a
+ *            página e executa a instrução passo a passo (trap flag). Após o
+ *            passo, a escrita é interpretada com a semântica do registrador
+ *            (write-1-to-clear, PSOR/PCOR/PTOR, captura, MOD atualizado no
+ *            overflow, portas de clock, COUNTFLAG do SysTick).
+ *
+ *            As escritas decoradas do BME (AND, OR, XOR e BFI, 0x44000000 a
+ *            0x5FFFFFFF) são aplicadas ao registrador alcançado como uma
+ *            única escrita, sem interrupção entre a leitura e a escrita, e
+ *            custam accessCycles mais um ciclo. As leituras decoradas (LAC1,
+ *            LAS1 e UBFX) não são simuladas.
+ *
+ *            O tempo simulado é contado em ciclos do núcleo (20,97 MHz,
+ *            modo FEI). O MCG troca a frequência dos TPMs, da UART0 e do
+ *            SysTick (FEI, FEE, PEE, BLPI), mas não a unidade do tempo: o
+ *            custo de cada acesso continua em ciclos de 20,97 MHz, como se
+ *            o núcleo não mudasse de velocidade. setIrcError desvia os
+ *            IRCs (e o FLL no FEI) da frequência nominal, como a deriva
+ *            com a temperatura; o cristal é exato. Cada acesso avança
+ *            accessCycles ciclos e, quando o mesmo registrador é lido
+ *            repetidamente sem escritas (um laço de espera), o tempo salta
+ *            para o próximo evento: overflow de um TPM, SysTick chegando a
+ *            zero ou ação agendada.
+ *
+ *            As interrupções habilitadas no NVIC são entregues entre
+ *            instruções, como no Cortex-M0+, pelos tratadores com os nomes
+ *            do vetor de interrupções (TPM1_IRQHandler etc.), sem
+ *            aninhamento. A exceção do SysTick (TICKINT) é entregue a
+ *            SysTick_Handler com a prioridade de NVIC_SetPriority e
+ *            dsf_sim_interruptedPc informa o endereço interrompido, no
+ *            lugar do PC empilhado.
+ *
+ *            O transmissor da UART0 leva o tempo de cada byte na taxa
+ *            programada e entrega os bytes ao receptor de listen. O DMA
+ *            atende as requisições de transmissor vazio da UART0 (fonte 3
+ *            do DMAMUX) lendo a memória do próprio processo, de modo que os
+ *            buffers de origem devem ficar abaixo de 4 GB (-no-pie).
+ *
+ *            A metade superior da flash (0x10000 a 0x1FFFF) é um arquivo
+ *            mapeado por attachFlash, apagado e gravado pelos comandos do
+ *            FTFA com os tempos típicos. cutPower interrompe um comando no
+ *            meio, com resultado parcial, e reset faz uma nova partida com
+ *            o mesmo arquivo, para testes de falta de energia.
+ *
+ *            O WFI com SLEEPDEEP dorme no modo de STOPM (VLPS ou LLS): os
+ *            TPMs e o SysTick param, o LPTMR conta o LPO de 1 kHz e o
+ *            despertar vem de qualquer interrupção habilitada em VLPS ou só
+ *            do LLWU em LLS, com o tempo de saída típico para RUN. A UART0
+ *            e o DMA não são parados.
+ *
+ *            O WFI sem SLEEPDEEP espera em WAIT, contado à parte em
+ *            modeCycles.
+ *
+ *            Cada medida do TSI, disparada pelo SWTS ou pela comparação do
+ *            LPTMR, dura 250 us e devolve no TSICNT a contagem do canal
+ *            dada por setTouchCount.
+ *
+ *            O ADC0 converte por software ou no overflow do TPM do
+ *            SIM_SOPT7, com o tempo de conversão do manual para o ADCK, a
+ *            resolução e a média, e devolve no RA o valor da fonte de
+ *            setAnalogSource. O fim de conversão pede o DMA (fonte 40);
+ *            uma requisição com o contador zerado liga CE e DONE. A
+ *            calibração falha com o ADCK acima de 4 MHz.
+ *
+ *            A energia é estimada pela corrente de cada modo (RUN e WAIT
+ *            proporcionais ao relógio do núcleo, VLPS e LLS fixas), mais
+ *            os módulos com a porta de clock ligada nos SIM_SCGC4 a 7 (em
+ *            RUN e WAIT), os comandos do FTFA e as cargas dos pinos: o led
+ *            RGB da placa (PTB18, PTB19 e PTD1, acesos em nível baixo) ou
+ *            as de setLoad, acesas conforme o PDOR. Os valores são típicos
+ *            do datasheet a 3 V; servem para comparar versões, não para
+ *            substituir a medida na placa.
+ *
+ *            Acessos a PORT, TPM, UART0, DMA, FTFA, LPTMR, TSI ou ADC0 com a
+ *            porta de clock desligada encerram a simulação com uma
+ *            mensagem, como a falha de barramento da placa.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Tecla em PTA1 ligada ao canal de captura em PTA12.
+ *             +fn dsf_Sim::wire(0, 1, 0, 12);
+ *             +fn dsf_Sim::schedule(dsf_Sim::microseconds(5000), press, 0);
+ *             +fn dsf_Sim::run(firmware_main, dsf_Sim::microseconds(1e6));
+ */
+class dsf_Sim {
+ public:
+  /*!
+   * Métodos de ligação e estímulo dos pinos (GPIO 0..4 = A..E).
+   */
+  static void wire(uint8_t GPIOa, uint8_t pina, uint8_t GPIOb, uint8_t pinb);
+  static void unwire(uint8_t GPIOa, uint8_t pina, uint8_t GPIOb, uint8_t pinb);
+  static void drive(uint8_t GPIO, uint8_t pin, Sim_t::dsf_Level level);
+  static int pinLevel(uint8_t GPIO, uint8_t pin);
+  static void watch(uint8_t GPIO, uint8_t pin, dsf_SimObserver observer,
+                    void *argument);
+  static void listen(dsf_SimSerial receiver, void *argument);
+  static void setLoad(uint8_t GPIO, uint8_t pin, uint32_t microamps,
+                      Sim_t::dsf_Level active);
+  static void setTouchCount(uint8_t channel, uint16_t count);
+  static void setAnalogSource(dsf_SimAnalog source, void *argument);
+
+  /*!
+   * Métodos da flash e da alimentação.
+   */
+  static bool attachFlash(const char *path);
+  static uint8_t cutPower();
+  static void reset();
+
+  /*!
+   * Métodos do tempo simulado.
+   */
+  static void schedule(uint64_t cycle, dsf_SimAction action, void *argument);
+  static uint64_t now();
+  static uint32_t coreFrequency();
+  static uint64_t microseconds(uint64_t us);
+  static void setAccessCycles(uint32_t cycles);
+  static void setIrcError(int32_t ppm);
+
+  /*!
+   * Métodos de execução. run retorna 0 se entry retornou e 1 se a
+   * simulação atingiu o ciclo limite ou foi parada por stop.
+   */
+  static int run(void (*entry)(), uint64_t untilCycle);
+  static void stop();
+
+  /*!
+   * Métodos de estatística da simulação.
+   */
+  static uint64_t accessCount();
+  static uint64_t interruptCount();
+  static uint32_t flashErases(uint32_t address);
+  static uint64_t modeCycles(Sim_t::dsf_PowerMode mode);
+  static uint64_t wakeupCount();
+  static double microjoules();
+  static double microjoules(Sim_t::dsf_EnergyPart part);
+  static uint64_t loadCycles(uint8_t GPIO, uint8_t pin);
+};
+
+#endif  //  HOST_SIM_DSF_SIM_H_
@@ -1,15 +1,293 @@
-/*
- * lpm_compare.h
- *
- *  Created on: 23/09/2019
- *      Author: joaob
- */
-
-#ifndef SOURCES_LPM_COMPARE_H_
-#define SOURCES_LPM_COMPARE_H_
-
-
-
-
-
-#endif /* SOURCES_LPM_COMPARE_H_ */
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Comparador LPM_COMPARE e sorteio de faixas de prêmio.
+ *
+ * @file        lpm_compare.h
+ * @version     1.0
+ * @date        28 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (28 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef LPM_COMPARE_H_
+#define LPM_COMPARE_H_
+
+#include <stdint.h>
+#include "lpm_random.h"
+
+/*!
+ *  @struct   lpm_word
+ *
+ *  @brief    Menor tipo sem sinal que armazena Width bits.
+ */
+template <uint8_t Width, bool Byte = (Width <= 8), bool Half = (Width <= 16)>
+struct lpm_word {
+  typedef uint32_t type;
+};
+
+template <uint8_t Width, bool Half>
+struct lpm_word<Width, true, Half> {
+  typedef uint8_t type;
+};
+
+template <uint8_t Width>
+struct lpm_word<Width, false, true> {
+  typedef uint16_t type;
+};
+
+/*!
+ *  @struct   lpm_compareOutputs
+ *
+ *  @brief    Saídas do comparador, cada uma valendo 0 ou 1.
+ */
+struct lpm_compareOutputs {
+  uint8_t aeb;
+  uint8_t agb;
+  uint8_t alb;
+  uint8_t aneb;
+  uint8_t ageb;
+  uint8_t aleb;
+};
+
+/*!
+ *  @class    lpm_compare
+ *
+ *  @brief    Comparador sem sinal de Width bits, como o LPM_COMPARE.
+ *
+ *  @details  As saídas aeb (a = b), agb (a > b), alb (a < b), aneb, ageb e
+ *            aleb são calculadas só com operações aritméticas e lógicas,
+ *            sem desvios: com Width < 32 o bit 31 de a - b é o borrow; com
+ *            Width = 32 o borrow é obtido pela fórmula de Hacker's Delight
+ *            (2-12). A largura é um parâmetro do template, verificada em
+ *            tempo de compilação, e não há máscaras calculadas em execução.
+ *
+ *            datab é fixado no construtor, como a constante do número
+ *            vencedor da máquina de sorteios, ou passado a cada comparação.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Comparação do valor de um contador de 7 bits com 42.
+ *             +fn lpm_compare<7> winner(42);
+ *             +fn if (winner.aeb(counter.q())) { ... }
+ *             +fn lpm_compareOutputs out = lpm_compare<7>::compare(a, b);
+ */
+template <uint8_t Width>
+class lpm_compare {
+  static_assert(Width >= 1 && Width <= 32, "Width deve estar entre 1 e 32");
+
+ public:
+  typedef typename lpm_word<Width>::type word;
+
+  /*!
+   * Método construtor da classe.
+   */
+  explicit lpm_compare(word value = 0) : datab(value) {
+  }
+
+  /*!
+   * Métodos de comparação com o datab do objeto.
+   */
+  uint32_t aeb(word dataa) const {
+    return equal(dataa, datab);
+  }
+  uint32_t agb(word dataa) const {
+    return less(datab, dataa);
+  }
+  uint32_t alb(word dataa) const {
+    return less(dataa, datab);
+  }
+  lpm_compareOutputs compare(word dataa) const {
+    return compare(dataa, datab);
+  }
+
+  /*!
+   *   @fn         equal
+   *
+   *   @brief      Calcula a = b sem desvios.
+   *
+   *   O bit 31 de d | -d é 1 se e somente se d = a ^ b é diferente de 0.
+   *
+   *   @return     1 se a = b e 0 caso contrário.
+   */
+  static uint32_t equal(uint32_t a, uint32_t b) {
+    uint32_t d = a ^ b;
+
+    return 1 ^ ((d | (0u - d)) >> 31);
+  }
+
+  /*!
+   *   @fn         less
+   *
+   *   @brief      Calcula a < b sem desvios.
+   *
+   *   @return     1 se a < b e 0 caso contrário.
+   */
+  static uint32_t less(uint32_t a, uint32_t b) {
+    if (Width < 32) {
+      return (a - b) >> 31;
+    }
+    return ((~a & b) | ((~a | b) & (a - b))) >> 31;
+  }
+
+  /*!
+   *   @fn         compare
+   *
+   *   @brief      Calcula todas as saídas do comparador.
+   *
+   *   @param[in]  dataa, datab - operandos, em [0, 2^Width).
+   *
+   *   @return     As seis saídas do LPM_COMPARE.
+   */
+  static lpm_compareOutputs compare(word dataa, word datab) {
+    lpm_compareOutputs out;
+
+    out.aeb = (uint8_t)equal(dataa, datab);
+    out.alb = (uint8_t)less(dataa, datab);
+    out.agb = (uint8_t)less(datab, dataa);
+    out.aneb = (uint8_t)(out.aeb ^ 1);
+    out.ageb = (uint8_t)(out.alb ^ 1);
+    out.aleb = (uint8_t)(out.agb ^ 1);
+    return out;
+  }
+
+ private:
+  /*!
+   * Operando b fixo, o número vencedor da máquina de sorteios.
+   */
+  word datab;
+};
+
+/*!
+ *  @struct   lpm_aliasTable
+ *
+ *  @brief    Tabela de alias de Walker/Vose para sorteio com vários prêmios.
+ *
+ *  @details  A tabela possui 2^columnBits colunas. Cada coluna c tem um
+ *            limiar threshold[c] em [0, weightTotal] e uma faixa alternativa
+ *            alias[c]. Um sorteio escolhe a coluna pelos bits mais
+ *            significativos de uma saída do gerador e um valor u uniforme em
+ *            [0, weightTotal) pelos bits restantes. O resultado é c se
+ *            u < threshold[c] e alias[c] caso contrário.
+ *
+ *            A tabela é gerada em tempo de compilação pela ferramenta
+ *            host/lpm_aliasgen, que verifica que cada faixa i ocorre com
+ *            probabilidade exatamente igual a weight[i]/weightTotal, e é
+ *            declarada const para residir na flash.
+ */
+struct lpm_aliasTable {
+  /*!
+   * Número de bits do índice de coluna (2^columnBits colunas).
+   */
+  uint8_t columnBits;
+  /*!
+   * Número de faixas de prêmio, incluindo a faixa 0 (sem prêmio).
+   */
+  uint8_t tiers;
+  /*!
+   * Soma dos pesos das faixas: denominador comum das probabilidades.
+   */
+  uint32_t weightTotal;
+  /*!
+   * Resto 2^(32 - columnBits) mod weightTotal, abaixo do qual a parte
+   * baixa do produto é rejeitada para manter u exatamente uniforme.
+   */
+  uint32_t rejectBelow;
+  /*!
+   * Limiar e faixa alternativa de cada coluna.
+   */
+  const uint32_t *threshold;
+  const uint8_t *alias;
+};
+
+/*!
+ *  @class    lpm_prizeCompare
+ *
+ *  @brief    Comparação com a tabela de alias das faixas de prêmio.
+ *
+ *  @details  O método comparePrize sorteia uma entre várias faixas de prêmio
+ *            com custo constante, independente do número de faixas: uma
+ *            saída do gerador, uma leitura da tabela e uma comparação.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Sorteio de uma faixa da tabela prizeTable.
+ *             +fn prize = lpm_prizeCompare::comparePrize(generator,
+ *                                                         prizeTable);
+ */
+class lpm_prizeCompare {
+ public:
+  /*!
+   *   @fn         selectPrize
+   *
+   *   @brief      Seleciona a faixa de uma coluna da tabela de alias.
+   *
+   *   @param[in]  table - tabela de alias.
+   *               column - coluna, em [0, 2^columnBits).
+   *               u - valor uniforme, em [0, weightTotal).
+   *
+   *   @return     A faixa de prêmio selecionada.
+   */
+  static uint8_t selectPrize(const lpm_aliasTable &table, uint32_t column,
+                             uint32_t u) {
+    return u < table.threshold[column] ? (uint8_t)column :
+                                         table.alias[column];
+  }
+
+  /*!
+   *   @fn         comparePrize
+   *
+   *   @brief      Sorteia uma faixa de prêmio.
+   *
+   *   A parte baixa da saída do gerador é reduzida a [0, weightTotal) pelo
+   *   método de multiplicação de Lemire. A rejeição ocorre com
+   *   probabilidade menor que weightTotal/2^(32 - columnBits) e só então
+   *   uma nova saída do gerador é usada.
+   *
+   *   @param[in]  generator - gerador de números pseudoaleatórios.
+   *               table - tabela de alias das faixas de prêmio.
+   *
+   *   @return     A faixa de prêmio sorteada; 0 indica nenhum prêmio.
+   */
+  static uint8_t comparePrize(lpm_random &generator,
+                              const lpm_aliasTable &table) {
+    const uint32_t lowBits = 32 - table.columnBits;
+    const uint32_t lowMask = 0xFFFFFFFFu >> table.columnBits;
+    uint32_t r;
+    uint64_t product;
+
+    do {
+      r = generator.next();
+      product = (uint64_t)(r & lowMask) * table.weightTotal;
+    } while (((uint32_t)product & lowMask) < table.rejectBelow);
+    return selectPrize(table, r >> lowBits, (uint32_t)(product >> lowBits));
+  }
+};
+
+#endif  //  LPM_COMPARE_H_
@@ -1,15 +1,170 @@
-/*
- * lpm_counter.h
- *
- *  Created on: 23/09/2019
- *      Author: joaovicente
- */
-
-#include "stdint.h"
-
-
-class lpm_counter {
-
-	int counter(int countValue);
-
-};
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Contador LPM_COUNTER com largura, módulo e sentido fixos.
+ *
+ * @file        lpm_counter.h
+ * @version     1.0
+ * @date        28 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (28 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef LPM_COUNTER_H_
+#define LPM_COUNTER_H_
+
+#include <stdint.h>
+#include "lpm_compare.h"
+
+/*!
+ * Namespace de definição do sentido de contagem.
+ */
+namespace Counter_t {
+  enum dsf_Direction {
+    dsf_Up = 0,
+    dsf_Down = 1
+  };
+}  // namespace Counter_t
+
+/*!
+ *  @class    lpm_counter
+ *
+ *  @brief    Contador síncrono de Width bits, como o LPM_COUNTER.
+ *
+ *  @details  A largura, o módulo e o sentido são parâmetros do template,
+ *            verificados em tempo de compilação. Cada chamada de clock é
+ *            uma borda de subida com as entradas síncronas, em ordem de
+ *            prioridade: sclr (zera), sload (carrega data) e cnt_en (conta).
+ *
+ *            O contador conta de 0 a Modulus - 1 (ou de Modulus - 1 a 0) e
+ *            cout vale 1 no valor terminal, de modo que a saída cout de um
+ *            contador é a entrada cnt_en do próximo, em cascata.
+ *
+ *            O próximo valor e a seleção entre as entradas são calculados
+ *            com máscaras 0 ou ~0 derivadas das entradas e com a igualdade
+ *            sem desvios de lpm_compare, sem desvios condicionais; as
+ *            constantes dependem só dos parâmetros do template. O valor de
+ *            data deve estar em [0, Modulus).
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Contador módulo 100 e contador de dezenas em cascata.
+ *             +fn lpm_counter<7, 100> units;
+ *             +fn lpm_counter<4, 10> tens;
+ *             +fn tens.clock(units.cout());
+ *             +fn units.clock();
+ *
+ *            Contador decrescente de 16 bits com carga síncrona.
+ *             +fn lpm_counter<16, 65536, Counter_t::dsf_Down> timer;
+ *             +fn timer.clock(true, true, 1000);
+ */
+template <uint8_t Width, uint64_t Modulus = (1ull << Width),
+          Counter_t::dsf_Direction Dir = Counter_t::dsf_Up>
+class lpm_counter {
+  static_assert(Width >= 1 && Width <= 32, "Width deve estar entre 1 e 32");
+  static_assert(Modulus >= 2 && Modulus <= (1ull << Width),
+                "Modulus deve estar entre 2 e 2^Width");
+
+ public:
+  typedef typename lpm_word<Width>::type word;
+
+  /*!
+   * Método construtor da classe: o contador parte de zero (aclr).
+   */
+  lpm_counter() : count(0) {
+  }
+
+  /*!
+   *   @fn         clock
+   *
+   *   @brief      Aplica uma borda de clock com as entradas síncronas.
+   *
+   *   @param[in]  cntEn - habilita a contagem.
+   *               sload - carrega data, com prioridade sobre cntEn.
+   *               data - valor carregado por sload.
+   *               sclr - zera o contador, com prioridade sobre sload.
+   */
+  void clock(bool cntEn = true, bool sload = false, word data = 0,
+             bool sclr = false) {
+    uint32_t value = count;
+    uint32_t terminal = lpm_compare<Width>::equal(value, kTerminal);
+    uint32_t next, mask;
+
+    if (Dir == Counter_t::dsf_Up) {
+      next = (value + 1) & (terminal - 1);
+    } else {
+      next = value - 1 + ((uint32_t)(Modulus - 1) + 1)*terminal;
+    }
+    mask = 0u - (uint32_t)cntEn;
+    value = (next & mask) | (value & ~mask);
+    mask = 0u - (uint32_t)sload;
+    value = ((uint32_t)data & mask) | (value & ~mask);
+    value &= (uint32_t)sclr - 1;
+    count = (word)value;
+  }
+
+  /*!
+   * Métodos de carga e de limpeza síncronas.
+   */
+  void load(word data) {
+    clock(false, true, data);
+  }
+  void clear() {
+    clock(false, false, 0, true);
+  }
+
+  /*!
+   *   @fn         q
+   *
+   *   @brief      Informa o valor do contador.
+   */
+  word q() const {
+    return count;
+  }
+
+  /*!
+   *   @fn         cout
+   *
+   *   @brief      Informa o carry-out: 1 no valor terminal da contagem.
+   */
+  uint32_t cout() const {
+    return lpm_compare<Width>::equal(count, kTerminal);
+  }
+
+ private:
+  /*!
+   * Valor terminal: Modulus - 1 na contagem crescente e 0 na decrescente.
+   */
+  static const uint32_t kTerminal =
+      (Dir == Counter_t::dsf_Up) ? (uint32_t)(Modulus - 1) : 0;
+
+  word count;
+};
+
+#endif  //  LPM_COUNTER_H_
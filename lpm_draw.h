@@ -0,0 +1,127 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Lógica de sorteio da máquina de sorteios.
+ *
+ * @file        lpm_draw.h
+ * @version     1.0
+ * @date        16 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (16 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef LPM_DRAW_H_
+#define LPM_DRAW_H_
+
+#include <stdint.h>
+#include "lpm_random.h"
+#include "lpm_compare.h"
+
+/*!
+ * Namespace de definição dos parâmetros do sorteio.
+ */
+namespace Draw_t {
+  enum dsf_Draw {
+    dsf_Modulus = 100,
+    dsf_WinValues = 7
+  };
+}  // namespace Draw_t
+
+/*!
+ *  @class    lpm_draw
+ *
+ *  @brief    Sorteio com 7% de probabilidade de vitória.
+ *
+ *  @details  Cada sorteio reduz uma saída do gerador lpm_random ao
+ *            intervalo [0, Draw_t::dsf_Modulus), como o valor de um
+ *            contador módulo 100, e compara o valor com o limiar
+ *            Draw_t::dsf_WinValues no comparador lpm_compare de 7 bits.
+ *            Valores abaixo do limiar (saída alb) são vitórias.
+ *
+ *            A redução usa o método de multiplicação de Lemire com
+ *            rejeição, que é exatamente uniforme e evita a divisão, que
+ *            o Cortex-M0+ não possui em hardware.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Sorteio.
+ *             +fn value = draw.draw();
+ *             +fn if (lpm_draw::isWin(value)) { ... }
+ */
+class lpm_draw {
+ public:
+  /*!
+   * Método construtor da classe.
+   */
+  explicit lpm_draw(uint64_t seedValue = 1) : generator(seedValue) {
+  }
+
+  /*!
+   *   @fn         draw
+   *
+   *   @brief      Realiza um sorteio.
+   *
+   *   @return     O valor sorteado, no intervalo [0, Draw_t::dsf_Modulus).
+   */
+  uint32_t draw() {
+    uint64_t product = (uint64_t)generator.next() * Draw_t::dsf_Modulus;
+
+    /*!
+     * Rejeita os 2^32 mod 100 valores que tornariam o resultado enviesado.
+     */
+    if ((uint32_t)product < (uint32_t)Draw_t::dsf_Modulus) {
+      const uint32_t threshold =
+          (0u - (uint32_t)Draw_t::dsf_Modulus) % Draw_t::dsf_Modulus;
+      while ((uint32_t)product < threshold) {
+        product = (uint64_t)generator.next() * Draw_t::dsf_Modulus;
+      }
+    }
+    return (uint32_t)(product >> 32);
+  }
+
+  /*!
+   *   @fn         isWin
+   *
+   *   @brief      Indica se o valor sorteado é uma vitória.
+   *
+   *   @param[in]  value - valor retornado por draw().
+   *
+   *   @return     true se o valor é uma vitória.
+   */
+  static bool isWin(uint32_t value) {
+    return lpm_compare<7>::less(value, Draw_t::dsf_WinValues);
+  }
+
+  /*!
+   * Gerador de números pseudoaleatórios do sorteio.
+   */
+  lpm_random generator;
+};
+
+#endif  //  LPM_DRAW_H_
@@ -0,0 +1,695 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Simulador de netlists de blocos LPM por ciclos de clock.
+ *
+ * @file        lpm_netlist.h
+ * @version     1.0
+ * @date        30 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (30 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef LPM_NETLIST_H_
+#define LPM_NETLIST_H_
+
+#include <stdint.h>
+#ifdef LPM_NETLIST_THREADS
+#include <thread>
+#endif
+#include "lpm_counter.h"
+
+/*!
+ * Namespace de definição dos tipos de nós, das entradas dos contadores e
+ * dos sinais constantes da netlist.
+ */
+namespace Net_t {
+  enum dsf_Kind {
+    dsf_Input = 0,
+    dsf_Output = 1,
+    dsf_And = 2,
+    dsf_Or = 3,
+    dsf_Xor = 4,
+    dsf_Not = 5,
+    dsf_Compare = 6,
+    dsf_Counter = 7
+  };
+  enum dsf_Pin {
+    dsf_CntEn = 0,
+    dsf_Sload = 1,
+    dsf_Data = 2,
+    dsf_Sclr = 3
+  };
+  enum dsf_Net {
+    dsf_Zero = 0,
+    dsf_One = 1,
+    dsf_NoDriver = 0xFFFF
+  };
+}  // namespace Net_t
+
+/*!
+ *  @struct   lpm_netCompare
+ *
+ *  @brief    Sinais de saída de um nó comparador.
+ */
+struct lpm_netCompare {
+  uint16_t aeb;
+  uint16_t agb;
+  uint16_t alb;
+};
+
+/*!
+ *  @struct   lpm_netCounter
+ *
+ *  @brief    Nó contador e seus sinais de saída.
+ */
+struct lpm_netCounter {
+  uint16_t node;
+  uint16_t q;
+  uint16_t cout;
+};
+
+/*!
+ * Adaptadores das portas: pinos com readBit/writeBit, como dsf_GPIO_ocp,
+ * e relógios com ticks, como dsf_SysClock_ocp.
+ */
+template <class Pin>
+uint32_t lpm_readBit(void *pin) {
+  return (uint32_t)static_cast<Pin *>(pin)->readBit();
+}
+
+template <class Pin>
+void lpm_writeBit(void *pin, uint32_t value) {
+  static_cast<Pin *>(pin)->writeBit((int)(value & 1));
+}
+
+template <class Clock>
+uint32_t lpm_readTicks(void *clock) {
+  return (uint32_t)static_cast<Clock *>(clock)->ticks();
+}
+
+/*!
+ *  @class    lpm_netlist
+ *
+ *  @brief    Netlist de contadores, comparadores, portas lógicas e portas
+ *            de entrada e saída, simulada ciclo a ciclo.
+ *
+ *  @details  Cada nó produz um ou mais sinais (nets) de até 32 bits; os
+ *            sinais dsf_Zero e dsf_One são constantes. As portas lógicas
+ *            operam bit a bit e dsf_Not inverte o bit 0. Os contadores têm
+ *            as entradas síncronas e a saída cout de lpm_counter, com
+ *            largura, módulo e sentido escolhidos na construção do nó; as
+ *            entradas podem ser ligadas depois, com connect, o que permite
+ *            realimentar a saída de um contador na sua própria carga.
+ *
+ *            levelize é chamado uma vez, depois da construção. Ele separa
+ *            a netlist em partições independentes (componentes conexas),
+ *            ordena os nós combinacionais de cada partição por nível e
+ *            recusa laços combinacionais. Um ciclo de uma partição lê as
+ *            portas de entrada, avalia os nós combinacionais na ordem
+ *            calculada, escreve as portas de saída cujo valor mudou e
+ *            aplica a borda de clock a todos os contadores de uma vez.
+ *
+ *            O estado fica em vetores paralelos por campo, dimensionados
+ *            pelos parâmetros do template, sem alocação dinâmica, de modo
+ *            que a mesma netlist roda na placa e no host. Como as
+ *            partições não compartilham sinais, cada uma pode avançar
+ *            todos os ciclos sozinha; com LPM_NETLIST_THREADS definido
+ *            (só no host), runThreaded distribui as partições entre
+ *            threads sem sincronização por ciclo.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Sorteio: contador módulo 100 e vitória abaixo de 7 no led.
+ *             +fn lpm_netlist<> net;
+ *             +fn lpm_netCounter value = net.counter(7, 100);
+ *             +fn lpm_netCompare win = net.compare(7, value.q,
+ *                                                  net.constant(7));
+ *             +fn net.output(win.alb, lpm_writeBit<dsf_GPIO_ocp>, &led);
+ *             +fn if (net.levelize()) { net.run(1000); }
+ */
+template <uint16_t MaxNodes = 32, uint16_t MaxNets = 64>
+class lpm_netlist {
+ public:
+  typedef uint32_t (*ReadPort)(void *context);
+  typedef void (*WritePort)(void *context, uint32_t value);
+
+  /*!
+   * Método construtor da classe: netlist vazia, só com as constantes.
+   */
+  lpm_netlist() : nodes(0), nets(2), partitions(0), ready(false),
+                  failed(false), cycleCount(0) {
+    value[Net_t::dsf_Zero] = 0;
+    value[Net_t::dsf_One] = 1;
+    driver[Net_t::dsf_Zero] = Net_t::dsf_NoDriver;
+    driver[Net_t::dsf_One] = Net_t::dsf_NoDriver;
+  }
+
+  /*!
+   *   @fn         constant
+   *
+   *   @brief      Cria um sinal constante.
+   */
+  uint16_t constant(uint32_t data) {
+    uint16_t signal = newNets(1, Net_t::dsf_NoDriver);
+
+    value[signal] = data;
+    return signal;
+  }
+
+  /*!
+   *   @fn         input
+   *
+   *   @brief      Cria uma porta de entrada, lida no início de cada ciclo.
+   *
+   *   @param[in]  read - função de leitura, como lpm_readBit<dsf_GPIO_ocp>.
+   *               context - objeto passado a read.
+   *
+   *   @return     O sinal com o valor lido.
+   */
+  uint16_t input(ReadPort reader, void *context) {
+    uint16_t node = newNode(Net_t::dsf_Input);
+
+    readPort[node] = reader;
+    portContext[node] = context;
+    return firstOut[node] = newNets(1, node);
+  }
+
+  /*!
+   *   @fn         output
+   *
+   *   @brief      Cria uma porta de saída, escrita quando o sinal muda.
+   */
+  void output(uint16_t signal, WritePort writer, void *context) {
+    uint16_t node = newNode(Net_t::dsf_Output);
+
+    writePort[node] = writer;
+    portContext[node] = context;
+    state[node] = ~0u;
+    bind(node, 0, signal);
+  }
+
+  /*!
+   *   @fn         gate
+   *
+   *   @brief      Cria uma porta lógica dsf_And, dsf_Or, dsf_Xor ou dsf_Not.
+   */
+  uint16_t gate(Net_t::dsf_Kind kind, uint16_t a,
+                uint16_t b = Net_t::dsf_Zero) {
+    if (kind < Net_t::dsf_And || kind > Net_t::dsf_Not) {
+      failed = true;
+      return Net_t::dsf_Zero;
+    }
+    uint16_t node = newNode(kind);
+
+    bind(node, 0, a);
+    bind(node, 1, b);
+    return firstOut[node] = newNets(1, node);
+  }
+
+  /*!
+   *   @fn         compare
+   *
+   *   @brief      Cria um comparador sem sinal de width bits.
+   *
+   *   As duas entradas são reduzidas aos width bits menos significativos
+   *   a cada avaliação, como no lpm_compare<width>; a máscara fica no
+   *   estado do nó.
+   *
+   *   @return     Os sinais aeb, agb e alb.
+   */
+  lpm_netCompare compare(uint8_t width, uint16_t a, uint16_t b) {
+    lpm_netCompare out = {Net_t::dsf_Zero, Net_t::dsf_Zero, Net_t::dsf_Zero};
+
+    if (width < 1 || width > 32) {
+      failed = true;
+      return out;
+    }
+    uint16_t node = newNode(Net_t::dsf_Compare);
+
+    state[node] = width == 32 ? ~0u : (1u << width) - 1;
+    bind(node, 0, a);
+    bind(node, 1, b);
+    firstOut[node] = newNets(3, node);
+    out.aeb = firstOut[node];
+    out.agb = (uint16_t)(firstOut[node] + 1);
+    out.alb = (uint16_t)(firstOut[node] + 2);
+    return out;
+  }
+
+  /*!
+   *   @fn         counter
+   *
+   *   @brief      Cria um contador de width bits, módulo modulus.
+   *
+   *   @param[in]  cntEn, sload, data, sclr - sinais das entradas síncronas,
+   *               que também podem ser ligados depois com connect.
+   *
+   *   @return     O nó e os sinais q e cout.
+   */
+  lpm_netCounter counter(uint8_t width, uint64_t modulus,
+                         Counter_t::dsf_Direction dir = Counter_t::dsf_Up,
+                         uint16_t cntEn = Net_t::dsf_One,
+                         uint16_t sload = Net_t::dsf_Zero,
+                         uint16_t data = Net_t::dsf_Zero,
+                         uint16_t sclr = Net_t::dsf_Zero) {
+    lpm_netCounter out = {Net_t::dsf_NoDriver, Net_t::dsf_Zero,
+                          Net_t::dsf_Zero};
+
+    if (width < 1 || width > 32 || modulus < 2
+        || modulus > (1ull << width)) {
+      failed = true;
+      return out;
+    }
+    uint16_t node = newNode(Net_t::dsf_Counter);
+
+    terminal[node] = (dir == Counter_t::dsf_Up) ? (uint32_t)(modulus - 1) : 0;
+    reload[node] = (dir == Counter_t::dsf_Up) ? 0 : (uint32_t)(modulus - 1);
+    increment[node] = (dir == Counter_t::dsf_Up) ? 1 : ~0u;
+    state[node] = 0;
+    bind(node, Net_t::dsf_CntEn, cntEn);
+    bind(node, Net_t::dsf_Sload, sload);
+    bind(node, Net_t::dsf_Data, data);
+    bind(node, Net_t::dsf_Sclr, sclr);
+    firstOut[node] = newNets(2, node);
+    value[firstOut[node]] = 0;
+    value[firstOut[node] + 1] = (terminal[node] == 0);
+    out.node = node;
+    out.q = firstOut[node];
+    out.cout = (uint16_t)(firstOut[node] + 1);
+    return out;
+  }
+
+  /*!
+   *   @fn         connect
+   *
+   *   @brief      Liga um sinal a uma entrada de um contador já criado.
+   */
+  void connect(const lpm_netCounter &counter, Net_t::dsf_Pin pin,
+               uint16_t signal) {
+    if (counter.node >= nodes || type[counter.node] != Net_t::dsf_Counter) {
+      failed = true;
+      return;
+    }
+    bind(counter.node, pin, signal);
+  }
+
+  /*!
+   *   @fn         levelize
+   *
+   *   @brief      Calcula as partições e a ordem estática de avaliação.
+   *
+   *   @return     false se a construção falhou (capacidade, parâmetros ou
+   *               sinal inexistente) ou se há um laço combinacional.
+   */
+  bool levelize() {
+    ready = false;
+    if (failed) {
+      return false;
+    }
+
+    /*!
+     * Níveis por relaxação: um nó combinacional fica um nível acima dos
+     * nós combinacionais que o alimentam. Sem convergência em MaxNodes
+     * passos, há um laço.
+     */
+    for (uint16_t n = 0; n < nodes; n++) {
+      level[n] = 0;
+    }
+    bool changed = true;
+    for (uint16_t pass = 0; changed; pass++) {
+      if (pass > nodes) {
+        return false;
+      }
+      changed = false;
+      for (uint16_t n = 0; n < nodes; n++) {
+        if (type[n] == Net_t::dsf_Counter) {
+          continue;
+        }
+        for (uint8_t i = 0; i < 4; i++) {
+          uint16_t from = driver[source[i][n]];
+
+          if (from != Net_t::dsf_NoDriver
+              && type[from] != Net_t::dsf_Counter
+              && level[n] <= level[from]) {
+            level[n] = (uint16_t)(level[from] + 1);
+            changed = true;
+          }
+        }
+      }
+    }
+
+    /*!
+     * Partições: união dos nós ligados por um sinal, com as constantes
+     * fora de qualquer partição.
+     */
+    for (uint16_t n = 0; n < nodes; n++) {
+      partition[n] = n;
+    }
+    for (uint16_t n = 0; n < nodes; n++) {
+      for (uint8_t i = 0; i < 4; i++) {
+        uint16_t from = driver[source[i][n]];
+
+        if (from != Net_t::dsf_NoDriver) {
+          partition[findRoot(n)] = findRoot(from);
+        }
+      }
+    }
+    partitions = 0;
+    for (uint16_t n = 0; n < nodes; n++) {
+      if (findRoot(n) == n) {
+        combBegin[partitions] = n;
+        partitions++;
+      }
+    }
+    for (uint16_t n = 0; n < nodes; n++) {
+      uint16_t root = findRoot(n);
+      uint16_t p = 0;
+
+      while (combBegin[p] != root) {
+        p++;
+      }
+      group[n] = p;
+    }
+
+    /*!
+     * Ordem: por partição; dentro dela, os nós combinacionais por nível e
+     * depois os contadores.
+     */
+    uint16_t count = 0;
+    for (uint16_t p = 0; p < partitions; p++) {
+      uint16_t maxLevel = 0;
+
+      for (uint16_t n = 0; n < nodes; n++) {
+        if (group[n] == p && level[n] > maxLevel) {
+          maxLevel = level[n];
+        }
+      }
+      combBegin[p] = count;
+      for (uint16_t l = 0; l <= maxLevel; l++) {
+        for (uint16_t n = 0; n < nodes; n++) {
+          if (group[n] == p && type[n] != Net_t::dsf_Counter
+              && level[n] == l) {
+            order[count++] = n;
+          }
+        }
+      }
+      seqBegin[p] = count;
+      for (uint16_t n = 0; n < nodes; n++) {
+        if (group[n] == p && type[n] == Net_t::dsf_Counter) {
+          order[count++] = n;
+        }
+      }
+      seqEnd[p] = count;
+    }
+    ready = true;
+    return true;
+  }
+
+  /*!
+   *   @fn         step
+   *
+   *   @brief      Avança um ciclo da partição p.
+   */
+  void step(uint16_t p) {
+    for (uint16_t i = combBegin[p]; i < seqBegin[p]; i++) {
+      uint16_t n = order[i];
+      uint32_t a = value[source[0][n]];
+      uint32_t b = value[source[1][n]];
+      uint16_t out = firstOut[n];
+
+      switch (type[n]) {
+        case Net_t::dsf_Input:
+          value[out] = readPort[n](portContext[n]);
+          break;
+        case Net_t::dsf_Output:
+          if (a != state[n]) {
+            state[n] = a;
+            writePort[n](portContext[n], a);
+          }
+          break;
+        case Net_t::dsf_And:
+          value[out] = a & b;
+          break;
+        case Net_t::dsf_Or:
+          value[out] = a | b;
+          break;
+        case Net_t::dsf_Xor:
+          value[out] = a ^ b;
+          break;
+        case Net_t::dsf_Not:
+          value[out] = a ^ 1;
+          break;
+        default:
+          a &= state[n];
+          b &= state[n];
+          value[out] = (a == b);
+          value[out + 1] = (a > b);
+          value[out + 2] = (a < b);
+          break;
+      }
+    }
+
+    /*!
+     * Borda de clock: todos os próximos estados são calculados antes de
+     * qualquer saída mudar, como nos registradores de um circuito
+     * síncrono. A seleção segue lpm_counter: sclr, sload e cnt_en.
+     */
+    for (uint16_t i = seqBegin[p]; i < seqEnd[p]; i++) {
+      uint16_t n = order[i];
+      uint32_t q = state[n];
+      uint32_t next = q + increment[n];
+      uint32_t mask;
+
+      mask = 0u - (uint32_t)(q == terminal[n]);
+      next += (reload[n] - next) & mask;
+      mask = 0u - (value[source[Net_t::dsf_CntEn][n]] & 1);
+      next = (next & mask) | (q & ~mask);
+      mask = 0u - (value[source[Net_t::dsf_Sload][n]] & 1);
+      next = (value[source[Net_t::dsf_Data][n]] & mask) | (next & ~mask);
+      next &= (value[source[Net_t::dsf_Sclr][n]] & 1) - 1;
+      state[n] = next;
+    }
+    for (uint16_t i = seqBegin[p]; i < seqEnd[p]; i++) {
+      uint16_t n = order[i];
+
+      value[firstOut[n]] = state[n];
+      value[firstOut[n] + 1] = (state[n] == terminal[n]);
+    }
+  }
+
+  /*!
+   *   @fn         run
+   *
+   *   @brief      Avança cycles ciclos, todas as partições em conjunto.
+   */
+  void run(uint32_t cycles) {
+    if (!ready) {
+      return;
+    }
+    for (uint32_t c = 0; c < cycles; c++) {
+      for (uint16_t p = 0; p < partitions; p++) {
+        step(p);
+      }
+    }
+    cycleCount += cycles;
+  }
+
+  /*!
+   *   @fn         runPartition
+   *
+   *   @brief      Avança cycles ciclos só da partição p.
+   *
+   *   Não atualiza cycles(): quem distribui as partições o faz.
+   */
+  void runPartition(uint16_t p, uint32_t cycles) {
+    if (!ready || p >= partitions) {
+      return;
+    }
+    for (uint32_t c = 0; c < cycles; c++) {
+      step(p);
+    }
+  }
+
+#ifdef LPM_NETLIST_THREADS
+  /*!
+   *   @fn         runThreaded
+   *
+   *   @brief      Avança cycles ciclos com as partições em até threads
+   *               threads, balanceadas pelo número de nós.
+   *
+   *   As portas de partições diferentes são chamadas em paralelo.
+   */
+  void runThreaded(uint32_t cycles, uint16_t threads) {
+    std::thread worker[16];
+    uint32_t load[16] = {0};
+    uint16_t owner[MaxNodes];
+
+    if (!ready) {
+      return;
+    }
+    if (threads > 16) {
+      threads = 16;
+    }
+    if (threads > partitions) {
+      threads = partitions;
+    }
+    if (threads <= 1) {
+      run(cycles);
+      return;
+    }
+    for (uint16_t p = 0; p < partitions; p++) {
+      uint16_t lightest = 0;
+
+      for (uint16_t t = 1; t < threads; t++) {
+        if (load[t] < load[lightest]) {
+          lightest = t;
+        }
+      }
+      owner[p] = lightest;
+      load[lightest] += seqEnd[p] - combBegin[p];
+    }
+    for (uint16_t t = 0; t < threads; t++) {
+      worker[t] = std::thread([this, t, cycles, &owner]() {
+        for (uint16_t p = 0; p < partitions; p++) {
+          if (owner[p] == t) {
+            runPartition(p, cycles);
+          }
+        }
+      });
+    }
+    for (uint16_t t = 0; t < threads; t++) {
+      worker[t].join();
+    }
+    cycleCount += cycles;
+  }
+#endif
+
+  /*!
+   * Métodos de consulta da netlist e dos sinais.
+   */
+  uint32_t read(uint16_t signal) const {
+    return value[signal];
+  }
+  uint16_t partitionCount() const {
+    return partitions;
+  }
+  uint16_t nodeCount() const {
+    return nodes;
+  }
+  uint64_t cycles() const {
+    return cycleCount;
+  }
+
+ private:
+  uint16_t newNode(Net_t::dsf_Kind nodeKind) {
+    if (nodes >= MaxNodes) {
+      failed = true;
+      return (uint16_t)(MaxNodes - 1);
+    }
+    type[nodes] = (uint8_t)nodeKind;
+    firstOut[nodes] = Net_t::dsf_Zero;
+    for (uint8_t i = 0; i < 4; i++) {
+      source[i][nodes] = Net_t::dsf_Zero;
+    }
+    return nodes++;
+  }
+
+  uint16_t newNets(uint16_t count, uint16_t node) {
+    if (failed || nets + count > MaxNets) {
+      failed = true;
+      return Net_t::dsf_Zero;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+      driver[nets + i] = node;
+      value[nets + i] = 0;
+    }
+    nets = (uint16_t)(nets + count);
+    return (uint16_t)(nets - count);
+  }
+
+  void bind(uint16_t node, uint8_t pin, uint16_t signal) {
+    if (signal >= nets) {
+      failed = true;
+      return;
+    }
+    source[pin][node] = signal;
+    ready = false;
+  }
+
+  uint16_t findRoot(uint16_t n) {
+    while (partition[n] != n) {
+      partition[n] = partition[partition[n]];
+      n = partition[n];
+    }
+    return n;
+  }
+
+  /*!
+   * Nós, em vetores paralelos: tipo, sinais de entrada (4 por nó), primeiro
+   * sinal de saída, estado (máscara de largura nos comparadores),
+   * constantes dos contadores e portas.
+   */
+  uint8_t type[MaxNodes];
+  uint16_t source[4][MaxNodes];
+  uint16_t firstOut[MaxNodes];
+  uint32_t state[MaxNodes];
+  uint32_t terminal[MaxNodes];
+  uint32_t reload[MaxNodes];
+  uint32_t increment[MaxNodes];
+  ReadPort readPort[MaxNodes];
+  WritePort writePort[MaxNodes];
+  void *portContext[MaxNodes];
+
+  /*!
+   * Ordem de avaliação e partições calculadas por levelize.
+   */
+  uint16_t level[MaxNodes];
+  uint16_t partition[MaxNodes];
+  uint16_t group[MaxNodes];
+  uint16_t order[MaxNodes];
+  uint16_t combBegin[MaxNodes];
+  uint16_t seqBegin[MaxNodes];
+  uint16_t seqEnd[MaxNodes];
+
+  /*!
+   * Sinais: valor e nó que o produz.
+   */
+  uint32_t value[MaxNets];
+  uint16_t driver[MaxNets];
+
+  uint16_t nodes;
+  uint16_t nets;
+  uint16_t partitions;
+  bool ready;
+  bool failed;
+  uint64_t cycleCount;
+};
+
+#endif  //  LPM_NETLIST_H_
@@ -0,0 +1,25 @@
+/*
+ * Tabela de alias gerada por host/lpm_aliasgen. Não editar.
+ *
+ * Verificada exata por enumeração de 4000 pares (coluna, u).
+ *
+ * Faixa 0 (nenhum): 930/1000
+ * Faixa 1 (premio3): 50/1000
+ * Faixa 2 (premio2): 15/1000
+ * Faixa 3 (premio1): 5/1000
+ */
+
+#include "lpm_prizeTable.h"
+
+static const uint32_t prizeTableThreshold[4] = {
+  1000, 200, 60, 20
+};
+
+static const uint8_t prizeTableAlias[4] = {
+  0, 0, 0, 0
+};
+
+const lpm_aliasTable prizeTable = {
+  2, 4, 1000, 824,
+  prizeTableThreshold, prizeTableAlias
+};
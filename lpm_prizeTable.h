@@ -0,0 +1,64 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Faixas de prêmio da máquina de sorteios.
+ *
+ * @file        lpm_prizeTable.h
+ * @version     1.0
+ * @date        18 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (18 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef LPM_PRIZETABLE_H_
+#define LPM_PRIZETABLE_H_
+
+#include "lpm_compare.h"
+
+/*!
+ * Namespace de definição das faixas de prêmio. A soma das faixas
+ * premiadas mantém a probabilidade de vitória em 7%.
+ */
+namespace Prize_t {
+  enum dsf_Prize {
+    dsf_NoPrize = 0,  // 930/1000
+    dsf_Prize3 = 1,   //  50/1000
+    dsf_Prize2 = 2,   //  15/1000
+    dsf_Prize1 = 3    //   5/1000
+  };
+}  // namespace Prize_t
+
+/*!
+ * Tabela de alias das faixas de prêmio, gerada em lpm_prizeTable.cpp por:
+ *
+ *   lpm_aliasgen nenhum=930 premio3=50 premio2=15 premio1=5
+ */
+extern const lpm_aliasTable prizeTable;
+
+#endif  //  LPM_PRIZETABLE_H_
@@ -0,0 +1,160 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Gerador de números pseudoaleatórios da máquina de sorteios.
+ *
+ * @file        lpm_random.h
+ * @version     1.0
+ * @date        16 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (16 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef LPM_RANDOM_H_
+#define LPM_RANDOM_H_
+
+#include <stdint.h>
+
+/*!
+ *  @class    lpm_random
+ *
+ *  @brief    Gerador xoshiro128** de 32 bits.
+ *
+ *  @details  O estado de 128 bits é atualizado apenas com deslocamentos,
+ *            rotações e XOR, e a saída usa uma multiplicação de 32 bits,
+ *            que no Cortex-M0+ é executada em um ciclo.
+ *
+ *            O método jump() avança o gerador 2^64 passos, produzindo
+ *            sequências que não se sobrepõem para uso em paralelo.
+ *
+ *            O código é o mesmo na placa e nas ferramentas do host, de
+ *            modo que as validações estatísticas do host se aplicam ao
+ *            sorteio embarcado.
+ */
+class lpm_random {
+ public:
+  /*!
+   * Método construtor da classe.
+   */
+  explicit lpm_random(uint64_t seedValue = 1) {
+    seed(seedValue);
+  }
+
+  /*!
+   *   @fn         seed
+   *
+   *   @brief      Inicializa o estado do gerador.
+   *
+   *   O estado é derivado da semente com o gerador SplitMix64, que nunca
+   *   produz o estado todo em zero.
+   *
+   *   @param[in]  seedValue - semente do gerador.
+   */
+  void seed(uint64_t seedValue) {
+    uint64_t word;
+
+    word = splitMix64(&seedValue);
+    state[0] = (uint32_t)word;
+    state[1] = (uint32_t)(word >> 32);
+    word = splitMix64(&seedValue);
+    state[2] = (uint32_t)word;
+    state[3] = (uint32_t)(word >> 32);
+  }
+
+  /*!
+   *   @fn         next
+   *
+   *   @brief      Gera o próximo número de 32 bits.
+   *
+   *   @return     O número pseudoaleatório gerado.
+   */
+  uint32_t next() {
+    uint32_t result = rotl(state[1] * 5, 7) * 9;
+    uint32_t t = state[1] << 9;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 11);
+    return result;
+  }
+
+  /*!
+   *   @fn         jump
+   *
+   *   @brief      Avança o gerador 2^64 passos.
+   *
+   *   Equivale a 2^64 chamadas de next(), permitindo até 2^64 sequências
+   *   independentes a partir de uma mesma semente.
+   */
+  void jump() {
+    static const uint32_t jumpPoly[4] = {
+      0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b
+    };
+    uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+    for (int i = 0; i < 4; i++) {
+      for (int b = 0; b < 32; b++) {
+        if (jumpPoly[i] & (1u << b)) {
+          s0 ^= state[0];
+          s1 ^= state[1];
+          s2 ^= state[2];
+          s3 ^= state[3];
+        }
+        next();
+      }
+    }
+    state[0] = s0;
+    state[1] = s1;
+    state[2] = s2;
+    state[3] = s3;
+  }
+
+ private:
+  /*!
+   * Estado do gerador.
+   */
+  uint32_t state[4];
+
+  static uint32_t rotl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+  }
+
+  static uint64_t splitMix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+};
+
+#endif  //  LPM_RANDOM_H_
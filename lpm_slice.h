@@ -0,0 +1,429 @@
+/*!
+ * @copyright   © 2019 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Contadores e comparadores LPM em fatias de bits, vários por palavra.
+ *
+ * @file        lpm_slice.h
+ * @version     1.0
+ * @date        29 Outubro 2019
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+.
+ *              +compiler     Kinetis® Design Studio IDE.
+ *              +revisions    Versão (data): Descrição breve.
+ *                             ++ 1.0 (29 Outubro 2019): Versão inicial.
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas.
+ *              +courses      Engenharia da Computação / Engenharia Elétrica.
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef LPM_SLICE_H_
+#define LPM_SLICE_H_
+
+#include <stdint.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "lpm_counter.h"
+
+/*!
+ *  @struct   lpm_lane
+ *
+ *  @brief    Operações de uma palavra de fatia (lane): uma instância por bit.
+ *
+ *  @details  Uma lane de 32 bits guarda o mesmo bit de 32 instâncias e uma
+ *            de 64 bits o de 64. As operações booleanas sobre a palavra
+ *            inteira são os operadores &, |, ^ e ~ do próprio tipo; a
+ *            estrutura fornece as constantes e o acesso a uma instância.
+ */
+template <typename Lane>
+struct lpm_lane;
+
+template <>
+struct lpm_lane<uint32_t> {
+  static const uint32_t kInstances = 32;
+
+  static uint32_t zero() {
+    return 0;
+  }
+  static uint32_t ones() {
+    return ~0u;
+  }
+  static uint32_t get(const uint32_t &lane, uint32_t index) {
+    return (lane >> index) & 1;
+  }
+  static void put(uint32_t &lane, uint32_t index, uint32_t bit) {
+    lane = (lane & ~(1u << index)) | (bit << index);
+  }
+  static uint32_t count(const uint32_t &lane) {
+    return (uint32_t)__builtin_popcount(lane);
+  }
+};
+
+template <>
+struct lpm_lane<uint64_t> {
+  static const uint32_t kInstances = 64;
+
+  static uint64_t zero() {
+    return 0;
+  }
+  static uint64_t ones() {
+    return ~0ull;
+  }
+  static uint32_t get(const uint64_t &lane, uint32_t index) {
+    return (uint32_t)(lane >> index) & 1;
+  }
+  static void put(uint64_t &lane, uint32_t index, uint32_t bit) {
+    lane = (lane & ~(1ull << index)) | ((uint64_t)bit << index);
+  }
+  static uint32_t count(const uint64_t &lane) {
+    return (uint32_t)__builtin_popcountll(lane);
+  }
+};
+
+#ifdef __AVX2__
+/*!
+ *  @struct   lpm_lane256
+ *
+ *  @brief    Lane de 256 bits para os registradores AVX2, só no host.
+ *
+ *  @details  A palavra é guardada como quatro uint64_t, com o alinhamento
+ *            de 8 bytes que std::vector garante em C++11; as operações
+ *            carregam e gravam com as instruções não alinhadas, e o
+ *            compilador mantém os valores intermediários em registradores.
+ */
+struct lpm_lane256 {
+  uint64_t w[4];
+};
+
+inline __m256i lpm_load256(const lpm_lane256 &a) {
+  return _mm256_loadu_si256((const __m256i *)a.w);
+}
+inline lpm_lane256 lpm_store256(__m256i v) {
+  lpm_lane256 r;
+
+  _mm256_storeu_si256((__m256i *)r.w, v);
+  return r;
+}
+inline lpm_lane256 operator&(const lpm_lane256 &a, const lpm_lane256 &b) {
+  return lpm_store256(_mm256_and_si256(lpm_load256(a), lpm_load256(b)));
+}
+inline lpm_lane256 operator|(const lpm_lane256 &a, const lpm_lane256 &b) {
+  return lpm_store256(_mm256_or_si256(lpm_load256(a), lpm_load256(b)));
+}
+inline lpm_lane256 operator^(const lpm_lane256 &a, const lpm_lane256 &b) {
+  return lpm_store256(_mm256_xor_si256(lpm_load256(a), lpm_load256(b)));
+}
+inline lpm_lane256 operator~(const lpm_lane256 &a) {
+  return lpm_store256(_mm256_xor_si256(lpm_load256(a),
+                                       _mm256_set1_epi32(-1)));
+}
+
+template <>
+struct lpm_lane<lpm_lane256> {
+  static const uint32_t kInstances = 256;
+
+  static lpm_lane256 zero() {
+    lpm_lane256 r = {{0, 0, 0, 0}};
+    return r;
+  }
+  static lpm_lane256 ones() {
+    lpm_lane256 r = {{~0ull, ~0ull, ~0ull, ~0ull}};
+    return r;
+  }
+  static uint32_t get(const lpm_lane256 &lane, uint32_t index) {
+    return lpm_lane<uint64_t>::get(lane.w[index >> 6], index & 63);
+  }
+  static void put(lpm_lane256 &lane, uint32_t index, uint32_t bit) {
+    lpm_lane<uint64_t>::put(lane.w[index >> 6], index & 63, bit);
+  }
+  static uint32_t count(const lpm_lane256 &lane) {
+    return lpm_lane<uint64_t>::count(lane.w[0])
+           + lpm_lane<uint64_t>::count(lane.w[1])
+           + lpm_lane<uint64_t>::count(lane.w[2])
+           + lpm_lane<uint64_t>::count(lane.w[3]);
+  }
+};
+#endif
+
+/*!
+ *  @struct   lpm_planes
+ *
+ *  @brief    Valores de Width bits de kInstances instâncias, transpostos.
+ *
+ *  @details  plane[i] guarda o bit i de todas as instâncias: a instância k
+ *            ocupa o bit k de cada plano. get e set transpõem uma
+ *            instância e servem para preparar entradas e ler resultados,
+ *            fora do laço de simulação.
+ */
+template <uint8_t Width, typename Lane = uint32_t>
+struct lpm_planes {
+  static_assert(Width >= 1 && Width <= 32, "Width deve estar entre 1 e 32");
+
+  static const uint32_t kInstances = lpm_lane<Lane>::kInstances;
+
+  /*!
+   * Método construtor: todas as instâncias valem zero.
+   */
+  lpm_planes() {
+    fill(0);
+  }
+
+  /*!
+   * Valor da instância index.
+   */
+  uint32_t get(uint32_t index) const {
+    uint32_t value = 0;
+
+    for (uint8_t i = 0; i < Width; i++) {
+      value |= lpm_lane<Lane>::get(plane[i], index) << i;
+    }
+    return value;
+  }
+
+  /*!
+   * Atribui value à instância index.
+   */
+  void set(uint32_t index, uint32_t value) {
+    for (uint8_t i = 0; i < Width; i++) {
+      lpm_lane<Lane>::put(plane[i], index, (value >> i) & 1);
+    }
+  }
+
+  /*!
+   * Atribui value a todas as instâncias.
+   */
+  void fill(uint32_t value) {
+    for (uint8_t i = 0; i < Width; i++) {
+      plane[i] = ((value >> i) & 1) ? lpm_lane<Lane>::ones()
+                                    : lpm_lane<Lane>::zero();
+    }
+  }
+
+  Lane plane[Width];
+};
+
+/*!
+ *  @class    lpm_counterSlice
+ *
+ *  @brief    kInstances contadores lpm_counter independentes em fatias.
+ *
+ *  @details  Os contadores têm a mesma largura, módulo e sentido, fixados
+ *            pelo template como em lpm_counter, e entradas síncronas
+ *            próprias: o bit k de cntEn, sload e sclr e a instância k de
+ *            data são as entradas do contador k. Cada clock avança todos os
+ *            contadores com um somador (ou subtrator) de propagação sobre
+ *            os planos e com as mesmas seleções por máscara de lpm_counter,
+ *            cerca de 8 operações booleanas por bit de largura para toda a
+ *            palavra. Os bits da constante de recarga decidem em tempo de
+ *            compilação se o plano é forçado a 0 ou a 1 no valor terminal;
+ *            com Modulus = 2^Width o estouro natural já é a recarga e esse
+ *            passo é omitido.
+ *
+ *            No Cortex-M0+ a lane é uint32_t; no host também uint64_t e,
+ *            compilado com -mavx2, lpm_lane256.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            32 contadores módulo 100 em cascata com 32 de dezenas.
+ *             +fn lpm_counterSlice<7, 100> units;
+ *             +fn lpm_counterSlice<4, 10> tens;
+ *             +fn tens.clock(units.cout());
+ *             +fn units.clock(~0u);
+ *             +fn uint32_t value = units.q().get(5);
+ */
+template <uint8_t Width, uint64_t Modulus = (1ull << Width),
+          Counter_t::dsf_Direction Dir = Counter_t::dsf_Up,
+          typename Lane = uint32_t>
+class lpm_counterSlice {
+  static_assert(Width >= 1 && Width <= 32, "Width deve estar entre 1 e 32");
+  static_assert(Modulus >= 2 && Modulus <= (1ull << Width),
+                "Modulus deve estar entre 2 e 2^Width");
+
+ public:
+  static const uint32_t kInstances = lpm_lane<Lane>::kInstances;
+
+  /*!
+   * Método construtor da classe: os contadores partem de zero (aclr).
+   */
+  lpm_counterSlice() {
+  }
+
+  /*!
+   *   @fn         clock
+   *
+   *   @brief      Aplica uma borda de clock a todos os contadores.
+   *
+   *   @param[in]  cntEn - habilita a contagem, um bit por contador.
+   *               sload - carrega data, com prioridade sobre cntEn.
+   *               data - valores carregados por sload, em [0, Modulus).
+   *               sclr - zera o contador, com prioridade sobre sload.
+   */
+  void clock(const Lane &cntEn, const Lane &sload,
+             const lpm_planes<Width, Lane> &data, const Lane &sclr) {
+    step<true>(cntEn, sload, data.plane, sclr);
+  }
+
+  /*!
+   *   @fn         clock
+   *
+   *   @brief      Aplica uma borda de clock só com a entrada cnt_en.
+   */
+  void clock(const Lane &cntEn) {
+    step<false>(cntEn, cntEn, count.plane, cntEn);
+  }
+
+  /*!
+   *   @fn         q
+   *
+   *   @brief      Informa os valores dos contadores, transpostos.
+   */
+  const lpm_planes<Width, Lane> &q() const {
+    return count;
+  }
+
+  /*!
+   *   @fn         cout
+   *
+   *   @brief      Informa o carry-out: bit k em 1 se o contador k está no
+   *               valor terminal.
+   */
+  Lane cout() const {
+    Lane terminal = lpm_lane<Lane>::ones();
+
+    for (uint8_t i = 0; i < Width; i++) {
+      terminal = terminal & (((kTerminal >> i) & 1) ? count.plane[i]
+                                                     : ~count.plane[i]);
+    }
+    return terminal;
+  }
+
+ private:
+  /*!
+   * Valor terminal e valor seguinte a ele, como em lpm_counter.
+   */
+  static const uint32_t kTerminal =
+      (Dir == Counter_t::dsf_Up) ? (uint32_t)(Modulus - 1) : 0;
+  static const uint32_t kReload =
+      (Dir == Counter_t::dsf_Up) ? 0 : (uint32_t)(Modulus - 1);
+  static const bool kFull = (Modulus == (1ull << Width));
+
+  template <bool Sync>
+  void step(const Lane &cntEn, const Lane &sload, const Lane *data,
+            const Lane &sclr) {
+    Lane terminal = kFull ? lpm_lane<Lane>::zero() : cout();
+    Lane carry = lpm_lane<Lane>::ones();
+
+    for (uint8_t i = 0; i < Width; i++) {
+      Lane bit = count.plane[i];
+      Lane next = bit ^ carry;
+
+      carry = (Dir == Counter_t::dsf_Up) ? carry & bit : carry & ~bit;
+      if (!kFull) {
+        next = ((kReload >> i) & 1) ? next | terminal : next & ~terminal;
+      }
+      next = (next & cntEn) | (bit & ~cntEn);
+      if (Sync) {
+        next = (data[i] & sload) | (next & ~sload);
+        next = next & ~sclr;
+      }
+      count.plane[i] = next;
+    }
+  }
+
+  lpm_planes<Width, Lane> count;
+};
+
+/*!
+ *  @struct   lpm_compareSliceOutputs
+ *
+ *  @brief    Saídas de kInstances comparadores, um bit por comparador.
+ */
+template <typename Lane>
+struct lpm_compareSliceOutputs {
+  Lane aeb;
+  Lane agb;
+  Lane alb;
+  Lane aneb;
+  Lane ageb;
+  Lane aleb;
+};
+
+/*!
+ *  @class    lpm_compareSlice
+ *
+ *  @brief    kInstances comparadores lpm_compare em fatias.
+ *
+ *  @details  A comparação percorre os planos do bit menos para o mais
+ *            significativo: em cada bit, a diferença entre a e b decide
+ *            alb e agb, e a igualdade mantém a decisão dos bits
+ *            inferiores. São cerca de 7 operações por bit para todas as
+ *            instâncias, sem desvios.
+ *
+ *  @section  EXAMPLES USAGE
+ *
+ *            Vitórias de 32 contadores contra o limiar 7.
+ *             +fn lpm_planes<7> limit;
+ *             +fn limit.fill(7);
+ *             +fn uint32_t wins = lpm_compareSlice<7>::compare(units.q(),
+ *                                                            limit).alb;
+ */
+template <uint8_t Width, typename Lane = uint32_t>
+class lpm_compareSlice {
+ public:
+  /*!
+   *   @fn         compare
+   *
+   *   @brief      Calcula todas as saídas dos comparadores.
+   *
+   *   @param[in]  dataa, datab - operandos transpostos.
+   *
+   *   @return     As seis saídas do LPM_COMPARE, um bit por instância.
+   */
+  static lpm_compareSliceOutputs<Lane> compare(
+      const lpm_planes<Width, Lane> &dataa,
+      const lpm_planes<Width, Lane> &datab) {
+    lpm_compareSliceOutputs<Lane> out;
+    Lane equal = lpm_lane<Lane>::ones();
+    Lane less = lpm_lane<Lane>::zero();
+    Lane greater = lpm_lane<Lane>::zero();
+
+    for (uint8_t i = 0; i < Width; i++) {
+      Lane a = dataa.plane[i];
+      Lane b = datab.plane[i];
+      Lane same = ~(a ^ b);
+
+      less = (~a & b) | (same & less);
+      greater = (a & ~b) | (same & greater);
+      equal = equal & same;
+    }
+    out.aeb = equal;
+    out.alb = less;
+    out.agb = greater;
+    out.aneb = ~equal;
+    out.ageb = ~less;
+    out.aleb = ~greater;
+    return out;
+  }
+};
+
+#endif  //  LPM_SLICE_H_
@@ -1,78 +1,283 @@
-/*!
- * @copyright    2017 UFAM - Universidade Federal do Amazonas.
- *
- * @brief       Exemplo de uso da classe Delay.
- *
- * @example     main.cpp
- * @version     1.0
- * @date        02 Agosto 2017
- *
- * @section     HARDWARES & SOFTWARES
- *              +board        FRDM-KL25Z da NXP.
- *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+
- *              +Peripheral   TPM, GPIO e Led RGB.
- *              +compiler     Kinetis Design Studio IDE
- *              +manual       L25P80M48SF0RM, Rev.3, September 2012
- *
- * @section     AUTHORS & DEVELOPERS
- *              +institution  Universidade Federal do Amazonas
- *              +courses      Engenharia da Computao / Engenharia Eltrica
- *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
- *              +student      Verso inicial:
- *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
- *
- * @section     LICENSE
- *
- *              GNU General Public License (GNU GPL).
- *
- *              Este programa  um software livre; Voc pode redistribu-lo
- *              e/ou modific-lo de acordo com os termos do "GNU General Public
- *              License" como publicado pela Free Software Foundation; Seja a
- *              verso 3 da licena, ou qualquer verso posterior.
- *
- *              Este programa  distribudo na esperana de que seja til,
- *              mas SEM QUALQUER GARANTIA; Sem a garantia implcita de
- *              COMERCIALIZAO OU USO PARA UM DETERMINADO PROPSITO.
- *              Veja o site da "GNU General Public License" para mais detalhes.
- *
- * @htmlonly    http://www.gnu.org/copyleft/gpl.html
- */
-
-#include "dsf_GPIO_ocp.h"
-#include "dsf_Delay_ocp.h"
-
-/*! Objeto led verde. */
-dsf_GPIO_ocp greenLed(GPIO_t::dsf_GPIOB, GPIO_t::dsf_PTB18);
-
-/*! * Objeto key. */
-dsf_GPIO_ocp key(GPIO_t::dsf_GPIOA, GPIO_t::dsf_PTA1);
-
-/*! Objeto da classe delay. */
-dsf_Delay_ocp tpm(TPM_t::dsf_TPM2);
-
-
-void setup() {
-	greenLed.setPortMode(PortMode_t::Output);
-	key.setPortMode(PortMode_t::Input);
-	key.setPullResistor(PullResistor_t::PullUpResistor);
-	tpm.setFrequency(TPMDiv_t::Div128);
-}
-
-int main() {
-  int contaPiscas = 0;
-  int bit = 0;
-
-  setup();
-  while (true) {
-    /*! Aguarda 400 ms. */
-    tpm.waitDelay(0xFFFF);
-    if (key.readBit()) {
-    	bit = !bit;
-    	greenLed.writeBit(bit);
-    	contaPiscas++;
-    } else {
-    	greenLed.writeBit(1);
-    }
-  }
-  return 0;
-}
+/*!
+ * @copyright   © 2017 UFAM - Universidade Federal do Amazonas.
+ *
+ * @brief       Exemplo de uso da classe Delay.
+ *
+ * @example     main.cpp
+ * @version     1.0
+ * @date        02 Agosto 2017
+ *
+ * @section     HARDWARES & SOFTWARES
+ *              +board        FRDM-KL25Z da NXP.
+ *              +processor    MKL25Z128VLK4 - ARM Cortex-M0+
+ *              +Peripheral   TPM, GPIO e Led RGB.
+ *              +compiler     Kinetis® Design Studio IDE
+ *              +manual       L25P80M48SF0RM, Rev.3, September 2012
+ *
+ * @section     AUTHORS & DEVELOPERS
+ *              +institution  Universidade Federal do Amazonas
+ *              +courses      Engenharia da Computação / Engenharia Elétrica
+ *              +teacher      Miguel Grimm <miguelgrimm@gmail.com>
+ *              +student      Versão inicial:
+ *                             ++ Hamilton Nascimento <hdan_neto@hotmail.com>
+ *
+ * @section     LICENSE
+ *
+ *              GNU General Public License (GNU GPL).
+ *
+ *              Este programa é um software livre; Você pode redistribuí-lo
+ *              e/ou modificá-lo de acordo com os termos do "GNU General Public
+ *              License" como publicado pela Free Software Foundation; Seja a
+ *              versão 3 da licença, ou qualquer versão posterior.
+ *
+ *              Este programa é distribuído na esperança de que seja útil,
+ *              mas SEM QUALQUER GARANTIA; Sem a garantia implícita de
+ *              COMERCIALIZAÇÃO OU USO PARA UM DETERMINADO PROPÓSITO.
+ *              Veja o site da "GNU General Public License" para mais detalhes.
+ *
+ * @htmlonly    http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "dsf_GPIO_ocp.h"
+#include "dsf_Delay_ocp.h"
+#ifdef DSF_LATENCY
+#include "dsf_Latency_ocp.h"
+#endif
+#ifdef DSF_LOAD_METER
+#include "dsf_SysClock_ocp.h"
+#include "dsf_LoadMeter_ocp.h"
+#endif
+#ifdef DSF_TOUCH
+#include "dsf_TSI_ocp.h"
+#endif
+#ifdef DSF_TELEMETRY
+#include "dsf_UART_ocp.h"
+#include "dsf_Telemetry_ocp.h"
+#endif
+#ifdef DSF_LOW_POWER
+#include "dsf_Power_ocp.h"
+#endif
+#ifdef DSF_CALIBRATION
+#include "dsf_Calibration_ocp.h"
+#endif
+#include "dsf_Irq_ocp.h"
+#include "dsf_StateMachine_ocp.h"
+
+/*! Objeto led verde. */
+dsf_GPIO_ocp greenLed(GPIO_t::dsf_GPIOB, GPIO_t::dsf_PTB18);
+
+/*! * Objeto key. */
+dsf_GPIO_ocp key(GPIO_t::dsf_GPIOA, GPIO_t::dsf_PTA1);
+
+/*! Objeto da classe delay. */
+dsf_Delay_ocp tpm(TPM_t::dsf_TPM2);
+
+#ifdef DSF_LATENCY
+/*!
+ * Medição da latência tecla-led (build com -DDSF_LATENCY): PTA1 ligado por
+ * fio a PTA12 e PTB18 a PTA13. O histograma fica em RAM e é descarregado
+ * com latency.dump(), pelo depurador ou por uma saída serial.
+ */
+dsf_Latency_ocp latency(TPM_t::dsf_TPM1_PTA12, TPM_t::dsf_TPM1_PTA13);
+
+DSF_IRQ_BIND(TPM1, latency)
+#endif
+
+#ifdef DSF_LOAD_METER
+/*!
+ * Medidor de carga da CPU (build com -DDSF_LOAD_METER) sobre o relógio do
+ * TPM0. A carga é consultada com dsf_LoadMeter_ocp::getStats ou dump.
+ */
+dsf_SysClock_ocp sysClock(TPM_t::dsf_TPM0);
+
+DSF_IRQ_BIND(TPM0, sysClock)
+#endif
+
+#ifdef DSF_TOUCH
+/*!
+ * Tecla capacitiva (build com -DDSF_TOUCH): os eletrodos do slider da placa
+ * (PTB16 e PTB17) substituem a tecla mecânica, com varreduras a cada 5 ms.
+ */
+const uint8_t touchChannels[] = {TSI_t::dsf_CH9_PTB16, TSI_t::dsf_CH10_PTB17};
+dsf_TSI_ocp touch(touchChannels, 2);
+
+DSF_IRQ_BIND(TSI0, touch)
+#endif
+
+#ifdef DSF_TELEMETRY
+/*!
+ * Telemetria pela UART0 (build com -DDSF_TELEMETRY): o contador de piscadas
+ * sai em PTA2 (ponte serial USB do OpenSDA) a 115200 bit/s, pelo canal 1 do
+ * DMA, e é lido no PC com host/dsf_teledecode.
+ */
+dsf_UART_ocp serial(1);
+
+DSF_IRQ_BIND(DMA1, serial)
+
+dsf_Telemetry_ocp telemetry(serial);
+#endif
+
+#ifdef DSF_LOW_POWER
+#ifdef DSF_TOUCH
+#error "DSF_LOW_POWER e DSF_TOUCH usam o LPTMR"
+#endif
+/*!
+ * Baixo consumo (build com -DDSF_LOW_POWER): a espera de 400 ms dorme em
+ * VLPS até o LPTMR ou a tecla (PORTA) acordar o núcleo, e o led acende
+ * assim que a tecla é pressionada. PTA1 não é pino do LLWU; por isso VLPS.
+ */
+dsf_Power_ocp power;
+
+DSF_IRQ_BIND(LPTimer, power)
+DSF_IRQ_BIND(PORTA, key)
+#endif
+
+#ifdef DSF_CALIBRATION
+#if defined(DSF_LATENCY) || defined(DSF_LOW_POWER)
+#error "DSF_CALIBRATION usa o TPM1 contando sem parar"
+#endif
+/*!
+ * Calibração da base de tempo (build com -DDSF_CALIBRATION): uma referência
+ * de 1 Hz (RTC com cristal de 32,768 kHz ou 1PPS de GPS) em PTE20 corrige
+ * a frequência do FLL, e a espera de 400 ms deixa de variar com a placa e
+ * a temperatura.
+ */
+dsf_Calibration_ocp calibration(TPM_t::dsf_TPM1_PTE20, 1);
+
+DSF_IRQ_BIND(TPM1, calibration)
+#endif
+
+/*!
+ * Estado da tecla: 1 solta e 0 pressionada, como o nível de PTA1.
+ */
+int keyReleased() {
+#ifdef DSF_TOUCH
+	return touch.touchedMask() == 0;
+#else
+	return key.readBit();
+#endif
+}
+
+/*!
+ * Estados e eventos do laço da placa.
+ */
+namespace Device_t {
+  enum dsf_State {
+    dsf_Blinking = 0,
+    dsf_Holding = 1,
+    dsf_NumStates = 2
+  };
+  enum dsf_Event {
+    dsf_Timeout = 0,
+    dsf_KeyDown = 1,
+    dsf_KeyUp = 2,
+    dsf_NumEvents = 3
+  };
+}  // namespace Device_t
+
+int contaPiscas = 0;
+int bit = 0;
+
+/*!
+ * Ação das esperas com a tecla solta: inverte o led e conta a piscada.
+ */
+uint8_t blink() {
+	bit = !bit;
+	greenLed.writeBit(bit);
+	contaPiscas++;
+#ifdef DSF_TELEMETRY
+	telemetry.counter(Telemetry_t::dsf_CounterBlinks, contaPiscas);
+#endif
+	return StateMachine_t::dsf_NoEvent;
+}
+
+/*!
+ * Ação das esperas com a tecla pressionada: led em nível alto.
+ */
+uint8_t hold() {
+	greenLed.writeBit(1);
+	return StateMachine_t::dsf_NoEvent;
+}
+
+/*!
+ * Máquina do laço: a tecla pressionada ao fim de uma espera (ou, com
+ * DSF_LOW_POWER, em qualquer despertar) leva a Holding, e a tecla solta ao
+ * fim de uma espera volta a Blinking com uma piscada.
+ */
+typedef dsf_StateMachine_ocp<Device_t::dsf_NumStates, Device_t::dsf_NumEvents,
+    dsf_Transition<Device_t::dsf_Blinking, Device_t::dsf_Timeout,
+                   Device_t::dsf_Blinking, blink>,
+    dsf_Transition<Device_t::dsf_Blinking, Device_t::dsf_KeyDown,
+                   Device_t::dsf_Holding, hold>,
+    dsf_Transition<Device_t::dsf_Holding, Device_t::dsf_Timeout,
+                   Device_t::dsf_Holding, hold>,
+    dsf_Transition<Device_t::dsf_Holding, Device_t::dsf_KeyUp,
+                   Device_t::dsf_Blinking, blink>
+> dsf_DeviceMachine;
+
+dsf_DeviceMachine machine(Device_t::dsf_Blinking);
+
+/*!
+ * Evento do fim de uma espera: a borda da tecla em relação ao estado da
+ * máquina, ou o próprio fim da espera se a tecla não mudou.
+ */
+uint8_t sampleKey() {
+	bool holding = machine.current() == Device_t::dsf_Holding;
+
+	if (keyReleased()) {
+		return holding ? Device_t::dsf_KeyUp : Device_t::dsf_Timeout;
+	}
+	return holding ? Device_t::dsf_Timeout : Device_t::dsf_KeyDown;
+}
+
+void setup() {
+	greenLed.setPortMode(PortMode_t::Output);
+	key.setPortMode(PortMode_t::Input);
+	key.setPullResistor(PullResistor_t::PullUpResistor);
+	tpm.setFrequency(TPMDiv_t::Div128);
+#ifdef DSF_LATENCY
+	latency.start();
+#endif
+#ifdef DSF_LOAD_METER
+	sysClock.start();
+	dsf_LoadMeter_ocp::start(&sysClock);
+#endif
+#ifdef DSF_TOUCH
+	touch.start(5);
+#endif
+#ifdef DSF_TELEMETRY
+	serial.start();
+#endif
+#ifdef DSF_LOW_POWER
+	key.setInterrupt(PortIrq_t::dsf_IrqEither);
+	power.track(&tpm);
+#ifdef DSF_LOAD_METER
+	power.track(&sysClock);
+#endif
+	power.start(Power_t::dsf_VLPS);
+#endif
+#ifdef DSF_CALIBRATION
+	calibration.start();
+#endif
+}
+
+int main() {
+  setup();
+  while (true) {
+    /*! Aguarda 400 ms. */
+#ifdef DSF_LOW_POWER
+    tpm.startDelay(0xFFFF);
+    while (!tpm.timeoutDelay()) {
+    	power.sleep();
+    	if (!keyReleased()) {
+    		machine.dispatch(Device_t::dsf_KeyDown);
+    	}
+    }
+    tpm.cancelDelay();
+#else
+    tpm.waitMicros(400000);
+#endif
+    machine.dispatch(sampleKey());
+  }
+  return 0;
+}